@@ -54,6 +54,7 @@ AbstractHttpServerResponseCommand::AbstractHttpServerResponseCommand(
       e_(e),
       socket_(socket),
       httpServer_(httpServer),
+      timeoutTimer_(global::wallclock()),
       readCheck_(false),
       writeCheck_(true)
 {
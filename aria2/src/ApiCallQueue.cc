@@ -0,0 +1,159 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2013 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "ApiCallQueue.h"
+
+#include <cerrno>
+#include <cstring>
+#ifdef HAVE_EVENTFD
+#  include <sys/eventfd.h>
+#  include <unistd.h>
+#endif // HAVE_EVENTFD
+
+#include "SocketCore.h"
+#include "DlAbortEx.h"
+#include "util.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+ApiCallQueue::ApiCallQueue() : closed_(false), signaled_(false)
+{
+#ifdef HAVE_EVENTFD
+  efd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (efd_ == -1) {
+    int errNum = errno;
+    throw DL_ABORT_EX(fmt("Failed to create eventfd: %s",
+                          util::safeStrerror(errNum).c_str()));
+  }
+#else  // !HAVE_EVENTFD
+  socket_ = std::make_shared<SocketCore>(SOCK_DGRAM);
+  socket_->bind("127.0.0.1", 0, AF_INET);
+  socket_->setNonBlockingMode();
+  port_ = socket_->getAddrInfo().port;
+#endif // !HAVE_EVENTFD
+}
+
+ApiCallQueue::~ApiCallQueue()
+{
+#ifdef HAVE_EVENTFD
+  ::close(efd_);
+#endif // HAVE_EVENTFD
+}
+
+bool ApiCallQueue::push(std::function<void()> call)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (closed_) {
+    return false;
+  }
+  calls_.push_back(std::move(call));
+  if (!signaled_) {
+    wakeup();
+    signaled_ = true;
+  }
+  return true;
+}
+
+size_t ApiCallQueue::execute()
+{
+  std::deque<std::function<void()>> calls;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (signaled_) {
+      clearWakeup();
+      signaled_ = false;
+    }
+    calls.swap(calls_);
+  }
+  for (auto& call : calls) {
+    call();
+  }
+  return calls.size();
+}
+
+void ApiCallQueue::close()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+  }
+  execute();
+}
+
+sock_t ApiCallQueue::getWakeupFd() const
+{
+#ifdef HAVE_EVENTFD
+  return efd_;
+#else  // !HAVE_EVENTFD
+  return socket_->getSockfd();
+#endif // !HAVE_EVENTFD
+}
+
+void ApiCallQueue::wakeup()
+{
+#ifdef HAVE_EVENTFD
+  uint64_t n = 1;
+  while (write(efd_, &n, sizeof(n)) == -1 && errno == EINTR)
+    ;
+#else  // !HAVE_EVENTFD
+  try {
+    unsigned char c = 0;
+    socket_->writeData(&c, 1, "127.0.0.1", port_);
+  }
+  catch (RecoverableException& e) {
+    // The engine picks up the call at the next polling timeout.
+  }
+#endif // !HAVE_EVENTFD
+}
+
+void ApiCallQueue::clearWakeup()
+{
+#ifdef HAVE_EVENTFD
+  uint64_t n;
+  while (read(efd_, &n, sizeof(n)) == -1 && errno == EINTR)
+    ;
+#else  // !HAVE_EVENTFD
+  try {
+    unsigned char buf[16];
+    Endpoint sender;
+    while (socket_->readDataFrom(buf, sizeof(buf), sender) > 0)
+      ;
+  }
+  catch (RecoverableException& e) {
+  }
+#endif // !HAVE_EVENTFD
+}
+
+} // namespace aria2
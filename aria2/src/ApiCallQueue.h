@@ -0,0 +1,108 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2013 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_API_CALL_QUEUE_H
+#define D_API_CALL_QUEUE_H
+
+#include "common.h"
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "a2netcompat.h"
+
+namespace aria2 {
+
+class SocketCore;
+
+// Queue of libaria2 API calls made from threads other than the one
+// running DownloadEngine.  Any thread can push calls, which are run
+// by ApiCallCommand on the engine thread.  Pushing a call makes the
+// wakeup descriptor readable, so that the engine returns from the
+// event polling immediately.  The descriptor is eventfd(2) if it is
+// available, otherwise a UDP socket bound to the loopback address,
+// which works with all EventPoll implementations.
+class ApiCallQueue {
+public:
+  // Throws DlAbortEx if the wakeup descriptor cannot be created.
+  ApiCallQueue();
+
+  ~ApiCallQueue();
+
+  // Appends |call| to the queue and wakes up the engine.  Returns
+  // false if the queue has been closed, in which case |call| is not
+  // run.
+  bool push(std::function<void()> call);
+
+  // Runs all queued calls in order.  This function must be called
+  // from the engine thread.  Returns the number of calls run.
+  size_t execute();
+
+  // Closes the queue and runs the calls still queued.  Call this
+  // function from the engine thread after the event loop exits.
+  void close();
+
+  // Returns the descriptor which becomes readable when calls are
+  // pushed.
+  sock_t getWakeupFd() const;
+
+private:
+  // The caller must hold mutex_.
+  void wakeup();
+  // The caller must hold mutex_.
+  void clearWakeup();
+
+  std::mutex mutex_;
+  std::deque<std::function<void()>> calls_;
+  bool closed_;
+  // True if the wakeup descriptor has been signaled and not cleared
+  // yet.  This avoids one system call per pushed call.
+  bool signaled_;
+#ifdef HAVE_EVENTFD
+  int efd_;
+#else  // !HAVE_EVENTFD
+  std::shared_ptr<SocketCore> socket_;
+  uint16_t port_;
+#endif // !HAVE_EVENTFD
+
+  // Don't allow copying
+  ApiCallQueue(const ApiCallQueue&);
+  ApiCallQueue& operator=(const ApiCallQueue&);
+};
+
+} // namespace aria2
+
+#endif // D_API_CALL_QUEUE_H
@@ -0,0 +1,299 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "AsyncLogWriter.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+
+#include "BufferedFile.h"
+#include "File.h"
+#include "DlAbortEx.h"
+#include "fmt.h"
+#include "message.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+namespace {
+// Write the batch when it grows beyond this size even if more
+// records are available.
+constexpr size_t MAX_BATCH_SIZE = 256_k;
+} // namespace
+
+namespace {
+size_t roundUpPow2(size_t n)
+{
+  size_t res = 2;
+  while (res < n) {
+    res <<= 1;
+  }
+  return res;
+}
+} // namespace
+
+AsyncLogWriter::AsyncLogWriter(const std::string& filename, size_t capacity,
+                               OverflowPolicy policy, int64_t maxSize)
+    : filename_(filename),
+      fp_(make_unique<BufferedFile>(filename.c_str(), BufferedFile::APPEND)),
+      mask_(roundUpPow2(capacity) - 1),
+      policy_(policy),
+      maxSize_(maxSize),
+      fileSize_(0),
+      enqueuePos_(0),
+      dequeuePos_(0),
+      dropped_(0),
+      droppedReported_(0),
+      written_(0),
+      sleeping_(false),
+      stop_(false),
+      flushRequested_(0),
+      flushDone_(0),
+      lastSec_(-1)
+{
+  if (!*fp_) {
+    throw DL_ABORT_EX(fmt(EX_FILE_OPEN, filename.c_str(), "n/a"));
+  }
+  fileSize_ = File(filename_).size();
+  ring_.reset(new Record[mask_ + 1]);
+  for (size_t i = 0; i <= mask_; ++i) {
+    ring_[i].seq.store(i, std::memory_order_relaxed);
+  }
+  batch_.reserve(MAX_BATCH_SIZE + 4_k);
+  thread_ = std::thread(&AsyncLogWriter::run, this);
+}
+
+AsyncLogWriter::~AsyncLogWriter()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cond_.notify_one();
+  thread_.join();
+}
+
+// The ring buffer follows Dmitry Vyukov's bounded MPMC queue.  Each
+// slot carries a sequence number.  A slot at position pos is free
+// for the producer if its sequence is pos, and holds a published
+// record for the consumer if its sequence is pos + 1.
+bool AsyncLogWriter::tryPush(const struct timeval& tv, const char* levelName,
+                             const char* sourceFile, int lineNum,
+                             std::string& msg, std::string& trace)
+{
+  auto pos = enqueuePos_.load(std::memory_order_relaxed);
+  for (;;) {
+    auto& rec = ring_[pos & mask_];
+    auto seq = rec.seq.load(std::memory_order_acquire);
+    auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+    if (diff == 0) {
+      if (enqueuePos_.compare_exchange_weak(pos, pos + 1,
+                                            std::memory_order_relaxed)) {
+        rec.tv = tv;
+        rec.levelName = levelName;
+        rec.sourceFile = sourceFile;
+        rec.lineNum = lineNum;
+        rec.msg.swap(msg);
+        rec.trace.swap(trace);
+        rec.seq.store(pos + 1, std::memory_order_release);
+        return true;
+      }
+    }
+    else if (diff < 0) {
+      // The ring is full.
+      return false;
+    }
+    else {
+      pos = enqueuePos_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+void AsyncLogWriter::wakeWriter()
+{
+  if (sleeping_.load()) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cond_.notify_one();
+  }
+}
+
+bool AsyncLogWriter::push(const struct timeval& tv, const char* levelName,
+                          const char* sourceFile, int lineNum, std::string msg,
+                          std::string trace)
+{
+  for (;;) {
+    if (tryPush(tv, levelName, sourceFile, lineNum, msg, trace)) {
+      wakeWriter();
+      return true;
+    }
+    if (policy_ == OVERFLOW_DROP) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    wakeWriter();
+    std::this_thread::yield();
+  }
+}
+
+void AsyncLogWriter::flush()
+{
+  auto target = enqueuePos_.load();
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (flushRequested_ < target) {
+    flushRequested_ = target;
+  }
+  cond_.notify_one();
+  flushedCond_.wait(lock, [&] { return flushDone_ >= target; });
+}
+
+void AsyncLogWriter::appendHeader(const struct timeval& tv,
+                                  const char* levelName,
+                                  const char* sourceFile, int lineNum)
+{
+  // tv.tv_sec may not be of type time_t.
+  time_t timesec = tv.tv_sec;
+  if (timesec != lastSec_) {
+    struct tm tm;
+    localtime_r(&timesec, &tm);
+    // 'YYYY-MM-DD hh:mm:ss'+'\0' = 20 bytes
+    size_t dateLength =
+        strftime(datestr_, sizeof(datestr_), "%Y-%m-%d %H:%M:%S", &tm);
+    assert(dateLength <= (size_t)20);
+    lastSec_ = timesec;
+  }
+  char buf[1024];
+  int len = snprintf(buf, sizeof(buf), "%s.%06ld [%s] [%s:%d] ", datestr_,
+                     (unsigned long)tv.tv_usec, levelName, sourceFile, lineNum);
+  if (len > 0) {
+    batch_.append(buf, std::min(static_cast<size_t>(len), sizeof(buf) - 1));
+  }
+}
+
+size_t AsyncLogWriter::drain()
+{
+  size_t n = 0;
+  auto dropped = dropped_.load(std::memory_order_relaxed);
+  if (dropped != droppedReported_) {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    appendHeader(tv, "WARN", __FILE__, __LINE__);
+    batch_ += fmt("%" PRIu64 " log message(s) were dropped because the log "
+                  "queue was full.\n",
+                  dropped - droppedReported_);
+    droppedReported_ = dropped;
+  }
+  while (batch_.size() < MAX_BATCH_SIZE) {
+    auto& rec = ring_[dequeuePos_ & mask_];
+    auto seq = rec.seq.load(std::memory_order_acquire);
+    if (seq != dequeuePos_ + 1) {
+      break;
+    }
+    appendHeader(rec.tv, rec.levelName, rec.sourceFile, rec.lineNum);
+    batch_ += rec.msg;
+    batch_ += '\n';
+    batch_ += rec.trace;
+    rec.msg.clear();
+    rec.trace.clear();
+    rec.seq.store(dequeuePos_ + mask_ + 1, std::memory_order_release);
+    ++dequeuePos_;
+    ++n;
+  }
+  written_.fetch_add(n, std::memory_order_relaxed);
+  return n;
+}
+
+void AsyncLogWriter::rotate()
+{
+  fp_.reset();
+  auto backup = filename_ + ".1";
+  File(backup).remove();
+  File(filename_).renameTo(backup);
+  fp_ = make_unique<BufferedFile>(filename_.c_str(), BufferedFile::APPEND);
+  if (!*fp_) {
+    // Nothing we can do here.  Discard the log until next rotation
+    // attempt.
+    fp_.reset();
+  }
+  fileSize_ = 0;
+}
+
+void AsyncLogWriter::writeBatch()
+{
+  if (fp_) {
+    fp_->write(batch_.data(), batch_.size());
+    fp_->flush();
+  }
+  fileSize_ += batch_.size();
+  batch_.clear();
+  if (maxSize_ > 0 && fileSize_ >= maxSize_) {
+    rotate();
+  }
+}
+
+void AsyncLogWriter::run()
+{
+  for (;;) {
+    auto n = drain();
+    if (!batch_.empty()) {
+      writeBatch();
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (flushDone_ < flushRequested_ && n == 0) {
+      flushDone_ = dequeuePos_;
+      flushedCond_.notify_all();
+    }
+    if (n > 0) {
+      continue;
+    }
+    if (stop_ && enqueuePos_.load() == dequeuePos_) {
+      flushDone_ = dequeuePos_;
+      flushedCond_.notify_all();
+      break;
+    }
+    sleeping_.store(true);
+    auto& rec = ring_[dequeuePos_ & mask_];
+    if (rec.seq.load() != dequeuePos_ + 1) {
+      // A pending flush or stop request waits here too if a producer
+      // has reserved the next slot but has not published the record
+      // yet; the producer wakes us up when it does.  The timeout
+      // covers the wakeup the producer misses because it has not seen
+      // sleeping_ yet.
+      cond_.wait_for(lock, 100_ms);
+    }
+    sleeping_.store(false);
+  }
+}
+
+} // namespace aria2
@@ -0,0 +1,167 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_ASYNC_LOG_WRITER_H
+#define D_ASYNC_LOG_WRITER_H
+
+#include "common.h"
+
+#include <string>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "a2time.h"
+
+namespace aria2 {
+
+class IOFile;
+
+// Writes log records to a file from a background thread.  Producers
+// push records into a bounded lock-free ring buffer (multiple
+// producers, single consumer).  The time stamp of a record is taken
+// by the producer, but its header is formatted by the writer thread,
+// which appends many records into one buffer and issues a single
+// write and flush per batch.  If |maxSize| is positive, the log file
+// is rotated to "<filename>.1" by the writer thread when it grows
+// beyond |maxSize| bytes.
+class AsyncLogWriter {
+public:
+  enum OverflowPolicy {
+    // Producer waits until the writer thread frees a slot.
+    OVERFLOW_BLOCK,
+    // Record is discarded and counted.  The number of discarded
+    // records is written to the log when the writer catches up.
+    OVERFLOW_DROP
+  };
+
+  // Opens |filename| in append mode and starts the writer thread.
+  // |capacity| is rounded up to the power of 2.  Throws DlAbortEx if
+  // the file cannot be opened.
+  AsyncLogWriter(const std::string& filename, size_t capacity,
+                 OverflowPolicy policy, int64_t maxSize);
+
+  // Drains all queued records and stops the writer thread.
+  ~AsyncLogWriter();
+
+  // Enqueues the record.  |sourceFile| must have static storage
+  // duration (e.g., __FILE__).  |levelName| must also have static
+  // storage duration.  Returns false if the record was dropped
+  // because of the overflow.
+  bool push(const struct timeval& tv, const char* levelName,
+            const char* sourceFile, int lineNum, std::string msg,
+            std::string trace);
+
+  // Blocks until all records pushed so far are written and flushed.
+  void flush();
+
+  uint64_t getDroppedCount() const { return dropped_.load(); }
+
+  uint64_t getWrittenCount() const { return written_.load(); }
+
+  size_t getCapacity() const { return mask_ + 1; }
+
+private:
+  struct Record {
+    std::atomic<size_t> seq;
+    struct timeval tv;
+    const char* levelName;
+    const char* sourceFile;
+    int lineNum;
+    std::string msg;
+    std::string trace;
+  };
+
+  // Don't allow copying
+  AsyncLogWriter(const AsyncLogWriter&);
+  AsyncLogWriter& operator=(const AsyncLogWriter&);
+
+  bool tryPush(const struct timeval& tv, const char* levelName,
+               const char* sourceFile, int lineNum, std::string& msg,
+               std::string& trace);
+
+  void wakeWriter();
+
+  void run();
+
+  // Moves as many records as possible into batch_.  Returns the
+  // number of records consumed.
+  size_t drain();
+
+  void writeBatch();
+
+  void rotate();
+
+  // Appends the header of a record to batch_.  The formatted date is
+  // cached per second since localtime_r() is relatively expensive.
+  void appendHeader(const struct timeval& tv, const char* levelName,
+                    const char* sourceFile, int lineNum);
+
+  std::string filename_;
+  std::unique_ptr<IOFile> fp_;
+  std::unique_ptr<Record[]> ring_;
+  size_t mask_;
+  OverflowPolicy policy_;
+  int64_t maxSize_;
+  int64_t fileSize_;
+
+  std::atomic<size_t> enqueuePos_;
+  // Only touched by the writer thread.
+  size_t dequeuePos_;
+
+  std::atomic<uint64_t> dropped_;
+  uint64_t droppedReported_;
+  std::atomic<uint64_t> written_;
+
+  // Guards the sleep/wakeup handshake and flush requests.  Never
+  // taken by producers unless the writer thread is sleeping.
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::condition_variable flushedCond_;
+  std::atomic<bool> sleeping_;
+  bool stop_;
+  uint64_t flushRequested_;
+  uint64_t flushDone_;
+
+  std::string batch_;
+  time_t lastSec_;
+  char datestr_[20];
+  std::thread thread_;
+};
+
+} // namespace aria2
+
+#endif // D_ASYNC_LOG_WRITER_H
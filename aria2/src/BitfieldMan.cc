@@ -157,18 +157,15 @@ bool BitfieldMan::hasMissingPiece(const unsigned char* peerBitfield,
   if (bitfieldLength_ != length) {
     return false;
   }
-  bool retval = false;
-  for (size_t i = 0; i < bitfieldLength_; ++i) {
-    unsigned char temp = peerBitfield[i] & ~bitfield_[i];
-    if (filterEnabled_) {
-      temp &= filterBitfield_[i];
-    }
-    if (temp & 0xffu) {
-      retval = true;
-      break;
-    }
+  if (filterEnabled_) {
+    return bitfield::findSetBit(array(peerBitfield) & ~array(bitfield_) &
+                                    array(filterBitfield_),
+                                blocks_, 0, blocks_) < blocks_;
+  }
+  else {
+    return bitfield::findSetBit(array(peerBitfield) & ~array(bitfield_),
+                                blocks_, 0, blocks_) < blocks_;
   }
-  return retval;
 }
 
 bool BitfieldMan::getFirstMissingUnusedIndex(size_t& index) const
@@ -185,6 +182,28 @@ bool BitfieldMan::getFirstMissingUnusedIndex(size_t& index) const
   }
 }
 
+bool BitfieldMan::getFirstMissingUnusedIndex(
+    size_t& index, size_t startIndex, size_t endIndex,
+    const unsigned char* ignoreBitfield, size_t ignoreBitfieldLength) const
+{
+  endIndex = std::min(endIndex, blocks_);
+  if (startIndex >= endIndex) {
+    return false;
+  }
+  if (filterEnabled_) {
+    index = bitfield::findUnsetBit(array(ignoreBitfield) |
+                                       ~array(filterBitfield_) |
+                                       array(bitfield_) | array(useBitfield_),
+                                   blocks_, startIndex, endIndex);
+  }
+  else {
+    index = bitfield::findUnsetBit(array(ignoreBitfield) | array(bitfield_) |
+                                       array(useBitfield_),
+                                   blocks_, startIndex, endIndex);
+  }
+  return index != endIndex;
+}
+
 size_t BitfieldMan::getFirstNMissingUnusedIndex(std::vector<size_t>& out,
                                                 size_t n) const
 {
@@ -212,33 +231,6 @@ bool BitfieldMan::getFirstMissingIndex(size_t& index) const
   }
 }
 
-namespace {
-template <typename Array>
-size_t getStartIndex(size_t index, const Array& bitfield, size_t blocks)
-{
-  while (index < blocks && bitfield::test(bitfield, blocks, index)) {
-    ++index;
-  }
-  if (blocks <= index) {
-    return blocks;
-  }
-  else {
-    return index;
-  }
-}
-} // namespace
-
-namespace {
-template <typename Array>
-size_t getEndIndex(size_t index, const Array& bitfield, size_t blocks)
-{
-  while (index < blocks && !bitfield::test(bitfield, blocks, index)) {
-    ++index;
-  }
-  return index;
-}
-} // namespace
-
 namespace {
 template <typename Array>
 bool getSparseMissingUnusedIndex(size_t& index, int32_t minSplitSize,
@@ -250,12 +242,13 @@ bool getSparseMissingUnusedIndex(size_t& index, int32_t minSplitSize,
   BitfieldMan::Range currentRange;
   size_t nextIndex = 0;
   while (nextIndex < blocks) {
-    currentRange.startIndex = getStartIndex(nextIndex, bitfield, blocks);
+    currentRange.startIndex =
+        bitfield::findUnsetBit(bitfield, blocks, nextIndex, blocks);
     if (currentRange.startIndex == blocks) {
       break;
     }
     currentRange.endIndex =
-        getEndIndex(currentRange.startIndex, bitfield, blocks);
+        bitfield::findSetBit(bitfield, blocks, currentRange.startIndex, blocks);
 
     if (currentRange.startIndex > 0) {
       if (bitfield::test(useBitfield, blocks, currentRange.startIndex - 1)) {
@@ -330,19 +323,12 @@ bool getGeomMissingUnusedIndex(size_t& index, int32_t minSplitSize,
   double start = 0;
   double end = 1;
   while (start + offsetIndex < blocks) {
-    index = blocks;
-    for (size_t i = start + offsetIndex,
-                eoi = std::min(blocks, static_cast<size_t>(end + offsetIndex));
-         i < eoi; ++i) {
-      if (bitfield::test(useBitfield, blocks, i)) {
-        break;
-      }
-      else if (!bitfield::test(bitfield, blocks, i)) {
-        index = i;
-        break;
-      }
-    }
-    if (index < blocks) {
+    // Look for an unset bit in the range up to the first block in use.
+    size_t first = start + offsetIndex;
+    size_t eoi = std::min(blocks, static_cast<size_t>(end + offsetIndex));
+    eoi = bitfield::findSetBit(useBitfield, blocks, first, eoi);
+    index = bitfield::findUnsetBit(bitfield, blocks, first, eoi);
+    if (index < eoi) {
       return true;
     }
     else {
@@ -384,40 +370,39 @@ bool getInorderMissingUnusedIndex(size_t& index, size_t startIndex,
                                   const unsigned char* useBitfield,
                                   int32_t blockLength, size_t blocks)
 {
+  // bitfield includes useBitfield, so that an unset bit in bitfield
+  // is a block we can download.
+
   // We always return first piece if it is available.
-  if (!bitfield::test(bitfield, blocks, startIndex) &&
-      !bitfield::test(useBitfield, blocks, startIndex)) {
+  if (!bitfield::test(bitfield, blocks, startIndex)) {
     index = startIndex;
     return true;
   }
+  // The number of free blocks which make up minSplitSize
+  size_t minSplitBlocks = std::max(
+      static_cast<int64_t>(1),
+      (static_cast<int64_t>(minSplitSize) + blockLength - 1) / blockLength);
   for (size_t i = startIndex + 1; i < lastIndex;) {
-    if (!bitfield::test(bitfield, blocks, i) &&
-        !bitfield::test(useBitfield, blocks, i)) {
-      // If previous piece has already been retrieved, we can download
-      // from this index.
-      if (!bitfield::test(useBitfield, blocks, i - 1) &&
-          bitfield::test(bitfield, blocks, i - 1)) {
-        index = i;
-        return true;
-      }
-      // Check free space of minSplitSize.  When checking this, we use
-      // blocks instead of lastIndex.
-      size_t j;
-      for (j = i; j < blocks; ++j) {
-        if (bitfield::test(bitfield, blocks, j) ||
-            bitfield::test(useBitfield, blocks, j)) {
-          break;
-        }
-        if (static_cast<int64_t>(j - i + 1) * blockLength >= minSplitSize) {
-          index = j;
-          return true;
-        }
-      }
-      i = j + 1;
+    i = bitfield::findUnsetBit(bitfield, blocks, i, lastIndex);
+    if (i == lastIndex) {
+      break;
     }
-    else {
-      ++i;
+    // If previous piece has already been retrieved, we can download
+    // from this index.
+    if (!bitfield::test(useBitfield, blocks, i - 1) &&
+        bitfield::test(bitfield, blocks, i - 1)) {
+      index = i;
+      return true;
+    }
+    // Check free space of minSplitSize.  When checking this, we use
+    // blocks instead of lastIndex.
+    size_t j = bitfield::findSetBit(bitfield, blocks, i,
+                                    std::min(blocks, i + minSplitBlocks));
+    if (j - i == minSplitBlocks) {
+      index = j - 1;
+      return true;
     }
+    i = j + 1;
   }
   return false;
 }
@@ -600,12 +585,8 @@ bool BitfieldMan::unsetBit(size_t index)
 bool BitfieldMan::isFilteredAllBitSet() const
 {
   if (filterEnabled_) {
-    for (size_t i = 0; i < bitfieldLength_; ++i) {
-      if ((bitfield_[i] & filterBitfield_[i]) != filterBitfield_[i]) {
-        return false;
-      }
-    }
-    return true;
+    return bitfield::findSetBit(~array(bitfield_) & array(filterBitfield_),
+                                blocks_, 0, blocks_) == blocks_;
   }
   else {
     return isAllBitSet();
@@ -854,12 +835,9 @@ void BitfieldMan::updateCache()
 
 bool BitfieldMan::isBitRangeSet(size_t startIndex, size_t endIndex) const
 {
-  for (size_t i = startIndex; i <= endIndex; ++i) {
-    if (!isBitSet(i)) {
-      return false;
-    }
-  }
-  return true;
+  assert(endIndex < blocks_);
+  return bitfield::findUnsetBit(bitfield_, blocks_, startIndex,
+                                endIndex + 1) == endIndex + 1;
 }
 
 void BitfieldMan::unsetBitRange(size_t startIndex, size_t endIndex)
@@ -891,12 +869,7 @@ bool BitfieldMan::isBitSetOffsetRange(int64_t offset, int64_t length) const
   }
   size_t startBlock = offset / blockLength_;
   size_t endBlock = (offset + length - 1) / blockLength_;
-  for (size_t i = startBlock; i <= endBlock; i++) {
-    if (!isBitSet(i)) {
-      return false;
-    }
-  }
-  return true;
+  return isBitRangeSet(startBlock, endBlock);
 }
 
 int64_t BitfieldMan::getOffsetCompletedLength(int64_t offset,
@@ -937,14 +910,16 @@ int64_t BitfieldMan::getMissingUnusedLength(size_t startingIndex) const
   if (blocks_ <= startingIndex) {
     return 0;
   }
-  int64_t length = 0;
-  for (size_t i = startingIndex; i < blocks_; ++i) {
-    if (isBitSet(i) || isUseBitSet(i)) {
-      break;
-    }
-    length += getBlockLength(i);
+  size_t end = bitfield::findSetBit(array(bitfield_) | array(useBitfield_),
+                                    blocks_, startingIndex, blocks_);
+  if (end == startingIndex) {
+    return 0;
+  }
+  if (end == blocks_) {
+    return static_cast<int64_t>(end - startingIndex - 1) * blockLength_ +
+           getLastBlockLength();
   }
-  return length;
+  return static_cast<int64_t>(end - startingIndex) * blockLength_;
 }
 
 BitfieldMan::Range::Range(size_t startIndex, size_t endIndex)
@@ -109,6 +109,18 @@ public:
   // affected by filter
   bool getFirstMissingUnusedIndex(size_t& index) const;
 
+  // Stores the smallest index of missing unused piece in [startIndex,
+  // endIndex) to index, regardless of minSplitSize.  Set bits in
+  // ignoreBitfield are excluded.  |endIndex| is normalized to
+  // min(|endIndex|, blocks_).  Returns true if such bit index is
+  // found. Otherwise returns false.
+  //
+  // affected by filter
+  bool getFirstMissingUnusedIndex(size_t& index, size_t startIndex,
+                                  size_t endIndex,
+                                  const unsigned char* ignoreBitfield,
+                                  size_t ignoreBitfieldLength) const;
+
   // Appends at most n missing unused index to out. This function
   // doesn't delete existing elements in out.  Returns the number of
   // appended elements.
@@ -47,6 +47,9 @@
 #include "Option.h"
 #include "prefs.h"
 #include "LogFactory.h"
+#include "RequestGroupMan.h"
+#include "PieceReuseCommand.h"
+#include "a2functional.h"
 
 namespace aria2 {
 
@@ -76,6 +79,10 @@ void BtFileAllocationEntry::prepareForNextAction(
     // For DownloadContext::resetDownloadStartTime(), see also
     // RequestGroup::createInitialCommand()
     dctx->resetDownloadStartTime();
+    if (e->getRequestGroupMan()->getPieceHashIndex() &&
+        !rg->inMemoryDownload()) {
+      commands.push_back(make_unique<PieceReuseCommand>(e->newCUID(), rg, e));
+    }
     const auto& fileEntries = dctx->getFileEntries();
     if (isUriSuppliedForRequsetFileEntry(std::begin(fileEntries),
                                          std::end(fileEntries))) {
@@ -215,6 +215,17 @@ fin:
   return outlen;
 }
 
+unsigned char*
+ChunkedDecodingStreamFilter::reserve(const std::shared_ptr<Segment>& segment,
+                                     size_t& len)
+{
+  if (state_ != CHUNK) {
+    return nullptr;
+  }
+  len = std::min(static_cast<int64_t>(len), chunkRemaining_);
+  return getDelegate()->reserve(segment, len);
+}
+
 bool ChunkedDecodingStreamFilter::finished()
 {
   return state_ == CHUNKS_COMPLETE && getDelegate()->finished();
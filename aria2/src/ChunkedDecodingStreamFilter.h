@@ -58,6 +58,12 @@ public:
                             const unsigned char* inbuf,
                             size_t inlen) CXX11_OVERRIDE;
 
+  // While in the middle of chunk data, the input is passed to the
+  // delegate as is.  Lends the buffer of the delegate for at most the
+  // rest of the chunk.
+  virtual unsigned char* reserve(const std::shared_ptr<Segment>& segment,
+                                 size_t& len) CXX11_OVERRIDE;
+
   virtual bool finished() CXX11_OVERRIDE;
 
   virtual void release() CXX11_OVERRIDE;
@@ -172,6 +172,9 @@ Context::Context(bool standalone, int argc, char** argv, const KeyVals& options)
   LogFactory::setLogLevel(op->get(PREF_LOG_LEVEL));
   LogFactory::setConsoleLogLevel(op->get(PREF_CONSOLE_LOG_LEVEL));
   LogFactory::setColorOutput(op->getAsBool(PREF_ENABLE_COLOR));
+  LogFactory::setAsync(op->getAsBool(PREF_LOG_ASYNC));
+  LogFactory::setAsyncOverflowPolicy(op->get(PREF_LOG_ASYNC_OVERFLOW));
+  LogFactory::setLogMaxSize(op->getAsLLInt(PREF_LOG_MAX_SIZE));
   if (op->getAsBool(PREF_QUIET)) {
     LogFactory::setConsoleOutput(false);
   }
@@ -44,9 +44,28 @@
 #include "fmt.h"
 #include "DHTNode.h"
 #include "a2functional.h"
+#include "Metrics.h"
 
 namespace aria2 {
 
+namespace {
+Counter* messagesSentCounter()
+{
+  static auto c = global::metrics().counter("aria2_dht_messages_sent_total",
+                                            "Number of DHT messages sent.");
+  return c;
+}
+} // namespace
+
+namespace {
+Counter* sendFailuresCounter()
+{
+  static auto c = global::metrics().counter(
+      "aria2_dht_send_failures_total", "Number of DHT messages failed to send.");
+  return c;
+}
+} // namespace
+
 DHTMessageDispatcherImpl::DHTMessageDispatcherImpl(
     const std::shared_ptr<DHTMessageTracker>& tracker)
     : tracker_{tracker}, timeout_{DHT_MESSAGE_TIMEOUT}
@@ -76,6 +95,7 @@ bool DHTMessageDispatcherImpl::sendMessage(DHTMessageEntry* entry)
         tracker_->addMessage(entry->message.get(), entry->timeout,
                              std::move(entry->callback));
       }
+      messagesSentCounter()->inc();
       A2_LOG_INFO(fmt("Message sent: %s", entry->message->toString().c_str()));
     }
     else {
@@ -83,6 +103,7 @@ bool DHTMessageDispatcherImpl::sendMessage(DHTMessageEntry* entry)
     }
   }
   catch (RecoverableException& e) {
+    sendFailuresCounter()->inc();
     A2_LOG_INFO_EX(
         fmt("Failed to send message: %s", entry->message->toString().c_str()),
         e);
@@ -52,9 +52,20 @@
 #include "util.h"
 #include "bencode2.h"
 #include "fmt.h"
+#include "Metrics.h"
 
 namespace aria2 {
 
+namespace {
+Counter* messagesReceivedCounter()
+{
+  static auto c = global::metrics().counter(
+      "aria2_dht_messages_received_total",
+      "Number of DHT messages received, including malformed ones.");
+  return c;
+}
+} // namespace
+
 DHTMessageReceiver::DHTMessageReceiver(
     const std::shared_ptr<DHTMessageTracker>& tracker)
     : tracker_{tracker}, factory_{nullptr}, routingTable_{nullptr}
@@ -66,6 +77,7 @@ DHTMessageReceiver::receiveMessage(const std::string& remoteAddr,
                                    uint16_t remotePort, unsigned char* data,
                                    size_t length)
 {
+  messagesReceivedCounter()->inc();
   try {
     bool isReply = false;
     auto decoded = bencode2::decode(data, length);
@@ -48,9 +48,20 @@
 #include "DlAbortEx.h"
 #include "DHTConstants.h"
 #include "fmt.h"
+#include "Metrics.h"
 
 namespace aria2 {
 
+namespace {
+Counter* timeoutsCounter()
+{
+  static auto c = global::metrics().counter(
+      "aria2_dht_message_timeouts_total",
+      "Number of DHT queries which were not answered in time.");
+  return c;
+}
+} // namespace
+
 DHTMessageTracker::DHTMessageTracker()
     : routingTable_{nullptr}, factory_{nullptr}
 {
@@ -118,6 +129,7 @@ DHTMessageTracker::messageArrived(const Dict* dict, const std::string& ipaddr,
 
 void DHTMessageTracker::handleTimeoutEntry(DHTMessageTrackerEntry* entry)
 {
+  timeoutsCounter()->inc();
   try {
     auto& node = entry->getTargetNode();
     A2_LOG_DEBUG(fmt("Message timeout: To:%s:%u", node->getIPAddress().c_str(),
@@ -43,6 +43,7 @@
 namespace aria2 {
 
 DHTPeerAnnounceEntry::DHTPeerAnnounceEntry(const unsigned char* infoHash)
+    : lastUpdated_(global::wallclock())
 {
   memcpy(infoHash_, infoHash, DHT_ID_LENGTH);
 }
@@ -0,0 +1,140 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2013 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "DataSinkDiskWriter.h"
+
+#include <algorithm>
+
+#include "DlAbortEx.h"
+#include "fmt.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+DataSinkFeeder::DataSinkFeeder(DataSink* sink, DataSinkMode mode)
+    : sink_(sink), mode_(mode), offset_(0), bufferedLength_(0)
+{
+}
+
+void DataSinkFeeder::write(const unsigned char* data, size_t len,
+                           int64_t offset)
+{
+  if (mode_ == DATA_SINK_RANDOM) {
+    pass(data, len, offset);
+    return;
+  }
+  if (offset > offset_) {
+    auto& buf = pending_[offset];
+    if (buf.size() < len) {
+      bufferedLength_ += len - buf.size();
+      buf.assign(reinterpret_cast<const char*>(data), len);
+    }
+    return;
+  }
+  if (offset + static_cast<int64_t>(len) <= offset_) {
+    // Already passed
+    return;
+  }
+  size_t skip = offset_ - offset;
+  pass(data + skip, len - skip, offset_);
+  while (!pending_.empty()) {
+    auto i = std::begin(pending_);
+    if ((*i).first > offset_) {
+      break;
+    }
+    auto& buf = (*i).second;
+    if ((*i).first + static_cast<int64_t>(buf.size()) > offset_) {
+      skip = offset_ - (*i).first;
+      pass(reinterpret_cast<const unsigned char*>(buf.data()) + skip,
+           buf.size() - skip, offset_);
+    }
+    bufferedLength_ -= buf.size();
+    pending_.erase(i);
+  }
+}
+
+void DataSinkFeeder::pass(const unsigned char* data, size_t len,
+                          int64_t offset)
+{
+  if (sink_->write(offset, data, len) != 0) {
+    throw DL_ABORT_EX(fmt("DataSink failed to write %lu bytes at offset"
+                          " %" PRId64,
+                          static_cast<unsigned long>(len), offset));
+  }
+  if (mode_ == DATA_SINK_SEQUENTIAL) {
+    offset_ = offset + len;
+  }
+}
+
+DataSinkDiskWriter::DataSinkDiskWriter(std::shared_ptr<DataSinkFeeder> feeder)
+    : feeder_(std::move(feeder)), length_(0)
+{
+}
+
+void DataSinkDiskWriter::initAndOpenFile(int64_t totalLength) { length_ = 0; }
+
+void DataSinkDiskWriter::openFile(int64_t totalLength) {}
+
+void DataSinkDiskWriter::closeFile() {}
+
+void DataSinkDiskWriter::openExistingFile(int64_t totalLength) {}
+
+void DataSinkDiskWriter::writeData(const unsigned char* data, size_t len,
+                                   int64_t offset)
+{
+  feeder_->write(data, len, offset);
+  length_ = std::max(length_, offset + static_cast<int64_t>(len));
+}
+
+ssize_t DataSinkDiskWriter::readData(unsigned char* data, size_t len,
+                                     int64_t offset)
+{
+  throw DL_ABORT_EX("The data passed to DataSink cannot be read back.");
+}
+
+int64_t DataSinkDiskWriter::size() { return length_; }
+
+DataSinkDiskWriterFactory::DataSinkDiskWriterFactory(DataSink* sink,
+                                                     DataSinkMode mode)
+    : feeder_(std::make_shared<DataSinkFeeder>(sink, mode))
+{
+}
+
+std::unique_ptr<DiskWriter>
+DataSinkDiskWriterFactory::newDiskWriter(const std::string& filename)
+{
+  return make_unique<DataSinkDiskWriter>(feeder_);
+}
+
+} // namespace aria2
@@ -0,0 +1,121 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2013 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_DATA_SINK_DISK_WRITER_H
+#define D_DATA_SINK_DISK_WRITER_H
+
+#include "DiskWriter.h"
+#include "DiskWriterFactory.h"
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include <aria2/aria2.h>
+
+namespace aria2 {
+
+// Passes the data written to DataSinkDiskWriter to DataSink.  This
+// object is shared by all DataSinkDiskWriters created for a
+// download, so that in DATA_SINK_SEQUENTIAL mode, the data already
+// passed is not passed again when the download is restarted.
+class DataSinkFeeder {
+public:
+  DataSinkFeeder(DataSink* sink, DataSinkMode mode);
+
+  // Passes the data to the sink, or holds it until the data before
+  // it arrives in DATA_SINK_SEQUENTIAL mode.  Throws DlAbortEx if
+  // DataSink::write() fails.
+  void write(const unsigned char* data, size_t len, int64_t offset);
+
+  // Returns the number of bytes passed in DATA_SINK_SEQUENTIAL mode.
+  int64_t getOffset() const { return offset_; }
+
+  // Returns the number of bytes held in DATA_SINK_SEQUENTIAL mode.
+  size_t getBufferedLength() const { return bufferedLength_; }
+
+private:
+  void pass(const unsigned char* data, size_t len, int64_t offset);
+
+  DataSink* sink_;
+  DataSinkMode mode_;
+  int64_t offset_;
+  // Data received ahead of offset_, keyed by its offset.
+  std::map<int64_t, std::string> pending_;
+  size_t bufferedLength_;
+};
+
+// DiskWriter which passes the written data to DataSink instead of
+// writing it to a file.  The written data cannot be read back.
+class DataSinkDiskWriter : public DiskWriter {
+public:
+  DataSinkDiskWriter(std::shared_ptr<DataSinkFeeder> feeder);
+
+  virtual void initAndOpenFile(int64_t totalLength = 0) CXX11_OVERRIDE;
+
+  virtual void openFile(int64_t totalLength = 0) CXX11_OVERRIDE;
+
+  virtual void closeFile() CXX11_OVERRIDE;
+
+  virtual void openExistingFile(int64_t totalLength = 0) CXX11_OVERRIDE;
+
+  virtual void writeData(const unsigned char* data, size_t len,
+                         int64_t offset) CXX11_OVERRIDE;
+
+  // Always throws DlAbortEx.
+  virtual ssize_t readData(unsigned char* data, size_t len,
+                           int64_t offset) CXX11_OVERRIDE;
+
+  // Returns the end offset of the data written so far.
+  virtual int64_t size() CXX11_OVERRIDE;
+
+private:
+  std::shared_ptr<DataSinkFeeder> feeder_;
+  int64_t length_;
+};
+
+class DataSinkDiskWriterFactory : public DiskWriterFactory {
+public:
+  DataSinkDiskWriterFactory(DataSink* sink, DataSinkMode mode);
+
+  virtual std::unique_ptr<DiskWriter>
+  newDiskWriter(const std::string& filename) CXX11_OVERRIDE;
+
+private:
+  std::shared_ptr<DataSinkFeeder> feeder_;
+};
+
+} // namespace aria2
+
+#endif // D_DATA_SINK_DISK_WRITER_H
@@ -0,0 +1,81 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2013 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "DeadlineStreamPieceSelector.h"
+
+#include <algorithm>
+
+#include "BitfieldMan.h"
+#include "PlaybackCursor.h"
+
+namespace aria2 {
+
+DeadlineStreamPieceSelector::DeadlineStreamPieceSelector(
+    BitfieldMan* bitfieldMan, const PlaybackCursor* cursor)
+    : bitfieldMan_(bitfieldMan), cursor_(cursor)
+{
+}
+
+DeadlineStreamPieceSelector::~DeadlineStreamPieceSelector() = default;
+
+bool DeadlineStreamPieceSelector::select(size_t& index, size_t minSplitSize,
+                                         const unsigned char* ignoreBitfield,
+                                         size_t length)
+{
+  int64_t blockLength = bitfieldMan_->getBlockLength();
+  size_t blocks = bitfieldMan_->countBlock();
+  size_t cursorIndex = std::min(
+      static_cast<size_t>(cursor_->getPosition() / blockLength), blocks);
+  size_t urgentEndIndex = std::min(
+      static_cast<size_t>((cursor_->getUrgentEnd() + blockLength - 1) /
+                          blockLength),
+      blocks);
+  if (bitfieldMan_->getFirstMissingUnusedIndex(
+          index, cursorIndex, urgentEndIndex, ignoreBitfield, length)) {
+    return true;
+  }
+  if (cursorIndex < blocks &&
+      bitfieldMan_->getInorderMissingUnusedIndex(
+          index, cursorIndex, blocks, minSplitSize, ignoreBitfield, length)) {
+    return true;
+  }
+  // The player may seek back to the pieces it has skipped.
+  return cursorIndex > 0 && bitfieldMan_->getInorderMissingUnusedIndex(
+                                index, 0, cursorIndex, minSplitSize,
+                                ignoreBitfield, length);
+}
+
+void DeadlineStreamPieceSelector::onBitfieldInit() {}
+
+} // namespace aria2
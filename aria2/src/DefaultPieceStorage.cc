@@ -60,6 +60,7 @@
 #include "InorderStreamPieceSelector.h"
 #include "RandomStreamPieceSelector.h"
 #include "GeomStreamPieceSelector.h"
+#include "DeadlineStreamPieceSelector.h"
 #include "array_fun.h"
 #include "PieceStatMan.h"
 #include "wallclock.h"
@@ -71,6 +72,7 @@
 #include "SimpleRandomizer.h"
 #ifdef ENABLE_BITTORRENT
 #  include "bittorrent_helper.h"
+#  include "PeerStorage.h"
 #endif // ENABLE_BITTORRENT
 
 namespace aria2 {
@@ -112,6 +114,10 @@ DefaultPieceStorage::DefaultPieceStorage(
     streamPieceSelector_ =
         make_unique<GeomStreamPieceSelector>(bitfieldMan_.get(), 1.5);
   }
+  else if (pieceSelectorOpt == A2_V_DEADLINE) {
+    streamPieceSelector_ = make_unique<DeadlineStreamPieceSelector>(
+        bitfieldMan_.get(), &downloadContext_->getPlaybackCursor());
+  }
 }
 
 DefaultPieceStorage::~DefaultPieceStorage() = default;
@@ -192,9 +198,51 @@ bool DefaultPieceStorage::hasMissingPiece(const std::shared_ptr<Peer>& peer)
                                        peer->getBitfieldLength());
 }
 
+namespace {
+// Returns true if a peer unchoking us downloads faster than |speed|
+// bytes per second.
+bool fasterPeerExists(RequestGroup* group, int speed)
+{
+  if (!group || !group->getPeerStorage()) {
+    return false;
+  }
+  for (auto& peer : group->getPeerStorage()->getUsedPeers()) {
+    if (peer->isActive() && !peer->peerChoking() &&
+        peer->calculateDownloadSpeed() > speed) {
+      return true;
+    }
+  }
+  return false;
+}
+} // namespace
+
+namespace {
+// Returns the range of the pieces after the one at the playback
+// position which a peer downloading at |speed| bytes per second
+// cannot complete before the player reaches them.  They are left to
+// the faster peers.
+std::pair<size_t, size_t> getUnreachableRange(const PlaybackCursor& cursor,
+                                              int32_t pieceLength,
+                                              size_t blocks, int speed)
+{
+  if (speed <= 0) {
+    return {0, 0};
+  }
+  size_t cursorIndex =
+      std::min(static_cast<size_t>(cursor.getPosition() / pieceLength), blocks);
+  size_t reachableIndex = std::min(
+      static_cast<size_t>(
+          (cursor.getReachableOffset(pieceLength, speed) + pieceLength - 1) /
+          pieceLength),
+      blocks);
+  return {std::min(cursorIndex + 1, reachableIndex), reachableIndex};
+}
+} // namespace
+
 void DefaultPieceStorage::getMissingPiece(
     std::vector<std::shared_ptr<Piece>>& pieces, size_t minMissingBlocks,
-    const unsigned char* bitfield, size_t length, cuid_t cuid)
+    const unsigned char* bitfield, size_t length, int downloadSpeed,
+    cuid_t cuid)
 {
   const size_t mislen = bitfieldMan_->getBitfieldLength();
   auto misbitfield = make_unique<unsigned char[]>(mislen);
@@ -234,6 +282,29 @@ void DefaultPieceStorage::getMissingPiece(
     if (!r) {
       return;
     }
+    const auto& cursor = downloadContext_->getPlaybackCursor();
+    auto unreachable =
+        cursor.isPlaying()
+            ? getUnreachableRange(cursor, downloadContext_->getPieceLength(),
+                                  blocks, downloadSpeed)
+            : std::make_pair<size_t, size_t>(0, 0);
+    if (unreachable.first < unreachable.second &&
+        fasterPeerExists(downloadContext_->getOwnerRequestGroup(),
+                         downloadSpeed)) {
+      auto reachable = make_unique<unsigned char[]>(mislen);
+      std::copy_n(misbitfield.get(), mislen, reachable.get());
+      for (size_t i = unreachable.first; i < unreachable.second; ++i) {
+        if (bitfield::test(reachable, blocks, i)) {
+          bitfield::flipBit(reachable.get(), blocks, i);
+        }
+      }
+      // Only if the peer has nothing else to offer, it downloads the
+      // pieces it cannot complete in time.
+      size_t index;
+      if (pieceSelector_->select(index, reachable.get(), blocks)) {
+        misbitfield = std::move(reachable);
+      }
+    }
     while (misBlock < minMissingBlocks) {
       size_t index;
       if (pieceSelector_->select(index, misbitfield.get(), blocks)) {
@@ -274,7 +345,8 @@ void DefaultPieceStorage::getMissingPiece(
     const std::shared_ptr<Peer>& peer, cuid_t cuid)
 {
   getMissingPiece(pieces, minMissingBlocks, peer->getBitfield(),
-                  peer->getBitfieldLength(), cuid);
+                  peer->getBitfieldLength(), peer->calculateDownloadSpeed(),
+                  cuid);
 }
 
 void DefaultPieceStorage::getMissingPiece(
@@ -287,7 +359,8 @@ void DefaultPieceStorage::getMissingPiece(
   tempBitfield.setBitfield(peer->getBitfield(), peer->getBitfieldLength());
   unsetExcludedIndexes(tempBitfield, excludedIndexes);
   getMissingPiece(pieces, minMissingBlocks, tempBitfield.getBitfield(),
-                  tempBitfield.getBitfieldLength(), cuid);
+                  tempBitfield.getBitfieldLength(),
+                  peer->calculateDownloadSpeed(), cuid);
 }
 
 void DefaultPieceStorage::getMissingFastPiece(
@@ -299,7 +372,8 @@ void DefaultPieceStorage::getMissingFastPiece(
                              bitfieldMan_->getTotalLength());
     createFastIndexBitfield(tempBitfield, peer);
     getMissingPiece(pieces, minMissingBlocks, tempBitfield.getBitfield(),
-                    tempBitfield.getBitfieldLength(), cuid);
+                    tempBitfield.getBitfieldLength(),
+                    peer->calculateDownloadSpeed(), cuid);
   }
 }
 
@@ -314,7 +388,8 @@ void DefaultPieceStorage::getMissingFastPiece(
     createFastIndexBitfield(tempBitfield, peer);
     unsetExcludedIndexes(tempBitfield, excludedIndexes);
     getMissingPiece(pieces, minMissingBlocks, tempBitfield.getBitfield(),
-                    tempBitfield.getBitfieldLength(), cuid);
+                    tempBitfield.getBitfieldLength(),
+                    peer->calculateDownloadSpeed(), cuid);
   }
 }
 
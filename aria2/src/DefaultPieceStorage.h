@@ -96,9 +96,13 @@ private:
 
   WrDiskCache* wrDiskCache_;
 #ifdef ENABLE_BITTORRENT
+  // downloadSpeed is the speed of the peer which has bitfield.  If
+  // the player is playing, the pieces the peer cannot complete before
+  // the player reaches them are selected only if there is no other
+  // piece.
   void getMissingPiece(std::vector<std::shared_ptr<Piece>>& pieces,
                        size_t minMissingBlocks, const unsigned char* bitfield,
-                       size_t length, cuid_t cuid);
+                       size_t length, int downloadSpeed, cuid_t cuid);
 
   void createFastIndexBitfield(BitfieldMan& bitfield,
                                const std::shared_ptr<Peer>& peer);
@@ -47,6 +47,7 @@
 #include "Logger.h"
 #include "LogFactory.h"
 #include "ChecksumCheckIntegrityEntry.h"
+#include "IncrementalChecksum.h"
 #include "PieceStorage.h"
 #include "CheckIntegrityCommand.h"
 #include "DiskAdaptor.h"
@@ -111,6 +112,11 @@ DownloadCommand::~DownloadCommand()
   getSegmentMan()->updateFastestPeerStat(peerStat_);
 }
 
+namespace {
+// The same as the capacity of SocketRecvBuffer
+const size_t READ_BUFFER_LENGTH = 16_k;
+} // namespace
+
 namespace {
 void flushWrDiskCacheEntry(WrDiskCache* wrDiskCache,
                            const std::shared_ptr<Segment>& segment)
@@ -147,6 +153,10 @@ bool DownloadCommand::executeInternal()
       getPieceStorage()->getDiskAdaptor();
   std::shared_ptr<Segment> segment = getSegments().front();
   bool eof = false;
+  // The buffer lent by streamFilter_, into which data are read
+  // directly instead of SocketRecvBuffer.
+  unsigned char* lentBuf = nullptr;
+  size_t lentLen = 0;
   if (getSocketRecvBuffer()->bufferEmpty()) {
     // Only read from socket when buffer is empty.  Imagine that When
     // segment length is *short* and we are using HTTP pilelining.  We
@@ -157,12 +167,34 @@ bool DownloadCommand::executeInternal()
     // read data from socket here, we will get EOF and leaves 2nd
     // response unprocessed.  To prevent this, we don't read from
     // socket when buffer is not empty.
-    eof = getSocketRecvBuffer()->recv() == 0 && !getSocket()->wantRead() &&
-          !getSocket()->wantWrite();
+    lentLen = READ_BUFFER_LENGTH;
+    if (sinkFilterOnly_ && segment->getLength() > 0) {
+      lentLen = std::min(static_cast<int64_t>(lentLen),
+                         getFileEntry()->getLastOffset() -
+                             segment->getPositionToWrite());
+    }
+    if (lentLen > 0) {
+      lentBuf = streamFilter_->reserve(segment, lentLen);
+    }
+    if (lentBuf) {
+      getSocket()->readData(lentBuf, lentLen);
+      eof = lentLen == 0 && !getSocket()->wantRead() &&
+            !getSocket()->wantWrite();
+    }
+    else {
+      eof = getSocketRecvBuffer()->recv() == 0 &&
+            !getSocket()->wantRead() && !getSocket()->wantWrite();
+    }
   }
   if (!eof) {
     size_t bufSize;
-    if (sinkFilterOnly_) {
+    if (lentBuf) {
+      // The lent buffer is limited to what the filters pass through,
+      // so that all of it is processed.
+      streamFilter_->transform(diskAdaptor, segment, lentBuf, lentLen);
+      bufSize = lentLen;
+    }
+    else if (sinkFilterOnly_) {
       if (segment->getLength() > 0) {
         if (segment->getPosition() + segment->getLength() <=
             getFileEntry()->getLastOffset()) {
@@ -182,6 +214,7 @@ bool DownloadCommand::executeInternal()
       }
       streamFilter_->transform(diskAdaptor, segment,
                                getSocketRecvBuffer()->getBuffer(), bufSize);
+      getSocketRecvBuffer()->drain(bufSize);
     }
     else {
       // It is possible that segment is completed but we have some bytes
@@ -192,8 +225,8 @@ bool DownloadCommand::executeInternal()
                                getSocketRecvBuffer()->getBuffer(),
                                getSocketRecvBuffer()->getBufferLength());
       bufSize = streamFilter_->getBytesProcessed();
+      getSocketRecvBuffer()->drain(bufSize);
     }
-    getSocketRecvBuffer()->drain(bufSize);
     peerStat_->updateDownload(bufSize);
     getDownloadContext()->updateDownload(bufSize);
   }
@@ -400,11 +433,27 @@ void DownloadCommand::validatePieceHash(const std::shared_ptr<Segment>& segment,
   }
 }
 
+namespace {
+// The number of the pieces completed out of order which are hashed
+// for the whole file checksum per completed segment.  Reading them
+// all at once when the gap before them is filled would stall the
+// other downloads.
+const size_t CHECKSUM_CATCH_UP_PIECES = 4;
+} // namespace
+
 void DownloadCommand::completeSegment(cuid_t cuid,
                                       const std::shared_ptr<Segment>& segment)
 {
+  auto checksum = getDownloadContext()->getIncrementalChecksum();
+  if (checksum) {
+    // Hash the piece while its data is still in the write disk cache.
+    checksum->update(segment->getPiece(), getPieceStorage()->getDiskAdaptor());
+  }
   flushWrDiskCacheEntry(getPieceStorage()->getWrDiskCache(), segment);
   getSegmentMan()->completeSegment(cuid, segment);
+  if (checksum) {
+    checksum->update(getPieceStorage().get(), CHECKSUM_CATCH_UP_PIECES);
+  }
 }
 
 void DownloadCommand::installStreamFilter(
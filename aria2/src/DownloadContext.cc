@@ -44,6 +44,8 @@
 #include "a2functional.h"
 #include "Signature.h"
 #include "RequestGroupMan.h"
+#include "IncrementalChecksum.h"
+#include "MessageDigest.h"
 
 namespace aria2 {
 
@@ -201,6 +203,7 @@ void DownloadContext::releaseRuntimeResource()
     (*i)->putBackRequest();
     (*i)->releaseRuntimeResource();
   }
+  incrementalChecksum_.reset();
 }
 
 size_t DownloadContext::getNumPieces() const
@@ -263,6 +266,18 @@ bool DownloadContext::isChecksumVerificationNeeded() const
          !checksumVerified_;
 }
 
+void DownloadContext::initIncrementalChecksum()
+{
+  if (isChecksumVerificationNeeded() && knowsTotalLength_ &&
+      getTotalLength() > 0 && MessageDigest::supports(hashType_)) {
+    incrementalChecksum_ = make_unique<IncrementalChecksum>(
+        hashType_, pieceLength_, getTotalLength());
+  }
+  else {
+    incrementalChecksum_.reset();
+  }
+}
+
 bool DownloadContext::isChecksumVerificationAvailable() const
 {
   return !digest_.empty() && !hashType_.empty();
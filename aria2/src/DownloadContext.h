@@ -48,17 +48,21 @@
 #include "SegList.h"
 #include "ContextAttribute.h"
 #include "NetStat.h"
+#include "PlaybackCursor.h"
 
 namespace aria2 {
 
 class RequestGroup;
 class Signature;
 class FileEntry;
+class IncrementalChecksum;
 
 class DownloadContext {
 private:
   std::unique_ptr<Signature> signature_;
 
+  std::unique_ptr<IncrementalChecksum> incrementalChecksum_;
+
   RequestGroup* ownerRequestGroup_;
 
   std::vector<std::shared_ptr<ContextAttribute>> attrs_;
@@ -71,6 +75,8 @@ private:
 
   Timer downloadStopTime_;
 
+  PlaybackCursor playbackCursor_;
+
   std::string pieceHashType_;
 
   std::string digest_;
@@ -196,6 +202,18 @@ public:
 
   void setChecksumVerified(bool f) { checksumVerified_ = f; }
 
+  // Starts hashing the file for the checksum verification while it is
+  // downloaded if the verification is needed.  Otherwise, discards
+  // the digest being computed.
+  void initIncrementalChecksum();
+
+  // Returns nullptr if initIncrementalChecksum() did not start
+  // hashing.
+  IncrementalChecksum* getIncrementalChecksum() const
+  {
+    return incrementalChecksum_.get();
+  }
+
   void setAttribute(ContextAttributeType key,
                     std::shared_ptr<ContextAttribute> value);
 
@@ -225,6 +243,13 @@ public:
 
   NetStat& getNetStat() { return netStat_; }
 
+  // The position of the player reported by
+  // aria2.changePlaybackPosition.  --stream-piece-selector=deadline
+  // selects pieces by it.
+  PlaybackCursor& getPlaybackCursor() { return playbackCursor_; }
+
+  const PlaybackCursor& getPlaybackCursor() const { return playbackCursor_; }
+
   // This method also updates global download length held by
   // RequestGroupMan via getOwnerRequestGroup().
   void updateDownload(size_t bytes);
@@ -75,6 +75,8 @@
 #endif // ENABLE_WEBSOCKET
 #include "Option.h"
 #include "util_security.h"
+#include "AuthTokenCache.h"
+#include "Metrics.h"
 
 namespace aria2 {
 
@@ -123,9 +125,53 @@ DownloadEngine::~DownloadEngine()
 }
 
 namespace {
-void executeCommand(std::deque<std::unique_ptr<Command>>& commands,
-                    Command::STATUS statusFilter)
+struct EngineMetrics {
+  EngineMetrics()
+      : iterations(global::metrics().counter(
+            "aria2_engine_iterations_total",
+            "Number of event loop iterations.")),
+        commandsExecuted(global::metrics().counter(
+            "aria2_engine_commands_executed_total",
+            "Number of Command::execute() calls.")),
+        commandsPerIteration(global::metrics().histogram(
+            "aria2_engine_commands_per_iteration",
+            "Number of commands executed in one event loop iteration.")),
+        iterationTime(global::metrics().histogram(
+            "aria2_engine_iteration_seconds",
+            "Time spent executing commands in one event loop iteration, "
+            "excluding the wait for events.",
+            1e-6)),
+        commands(global::metrics().gauge(
+            "aria2_engine_commands", "Number of commands in the engine.")),
+        socketPoolSize(global::metrics().gauge(
+            "aria2_engine_socket_pool_size",
+            "Number of idle connections in the socket pool."))
+  {
+  }
+
+  Counter* iterations;
+  Counter* commandsExecuted;
+  Histogram* commandsPerIteration;
+  Histogram* iterationTime;
+  Gauge* commands;
+  Gauge* socketPoolSize;
+};
+} // namespace
+
+namespace {
+EngineMetrics& engineMetrics()
+{
+  static EngineMetrics m;
+  return m;
+}
+} // namespace
+
+namespace {
+// Returns the number of commands executed.
+size_t executeCommand(std::deque<std::unique_ptr<Command>>& commands,
+                      Command::STATUS statusFilter)
 {
+  size_t executed = 0;
   size_t max = commands.size();
   for (size_t i = 0; i < max; ++i) {
     auto com = std::move(commands.front());
@@ -136,6 +182,7 @@ void executeCommand(std::deque<std::unique_ptr<Command>>& commands,
       continue;
     }
     com->transitStatus();
+    ++executed;
     if (com->execute()) {
       com.reset();
     }
@@ -144,6 +191,7 @@ void executeCommand(std::deque<std::unique_ptr<Command>>& commands,
       com.release();
     }
   }
+  return executed;
 }
 } // namespace
 
@@ -166,24 +214,35 @@ private:
 int DownloadEngine::run(bool oneshot)
 {
   GlobalHaltRequestedFinalizer ghrf(oneshot);
+  auto& metrics = engineMetrics();
   while (!commands_.empty() || !routineCommands_.empty()) {
     if (!commands_.empty()) {
       waitData();
     }
     noWait_ = false;
+    // The wallclock is coarse, so the iteration time is measured with
+    // the precise clock.
+    auto iterationStart = std::chrono::steady_clock::now();
     global::wallclock().reset();
     calculateStatistics();
+    size_t executed;
     if (lastRefresh_.difference(global::wallclock()) + A2_DELTA_MILLIS >=
         refreshInterval_) {
       refreshInterval_ = DEFAULT_REFRESH_INTERVAL;
       lastRefresh_ = global::wallclock();
-      executeCommand(commands_, Command::STATUS_ALL);
+      executed = executeCommand(commands_, Command::STATUS_ALL);
     }
     else {
-      executeCommand(commands_, Command::STATUS_ACTIVE);
+      executed = executeCommand(commands_, Command::STATUS_ACTIVE);
     }
-    executeCommand(routineCommands_, Command::STATUS_ALL);
+    executed += executeCommand(routineCommands_, Command::STATUS_ALL);
     afterEachIteration();
+    metrics.iterations->inc();
+    metrics.commandsExecuted->add(executed);
+    metrics.commandsPerIteration->record(executed);
+    metrics.commands->set(commands_.size() + routineCommands_.size());
+    metrics.socketPoolSize->set(socketPool_.size());
+    metrics.iterationTime->recordSince(iterationStart);
     if (!noWait_ && oneshot) {
       return 1;
     }
@@ -235,6 +294,16 @@ bool DownloadEngine::deleteSocketForWriteCheck(
                                   EventPoll::EVENT_WRITE);
 }
 
+bool DownloadEngine::addSocketForReadCheck(sock_t fd, Command* command)
+{
+  return eventPoll_->addEvents(fd, command, EventPoll::EVENT_READ);
+}
+
+bool DownloadEngine::deleteSocketForReadCheck(sock_t fd, Command* command)
+{
+  return eventPoll_->deleteEvents(fd, command, EventPoll::EVENT_READ);
+}
+
 void DownloadEngine::calculateStatistics()
 {
   if (statCalc_) {
@@ -604,12 +673,18 @@ void DownloadEngine::setFileAllocationMan(
     std::unique_ptr<FileAllocationMan> faman)
 {
   fileAllocationMan_ = std::move(faman);
+  fileAllocationMan_->setQueueLengthGauge(global::metrics().gauge(
+      "aria2_file_allocation_queue_length",
+      "Number of downloads waiting for file allocation."));
 }
 
 void DownloadEngine::setCheckIntegrityMan(
     std::unique_ptr<CheckIntegrityMan> ciman)
 {
   checkIntegrityMan_ = std::move(ciman);
+  checkIntegrityMan_->setQueueLengthGauge(global::metrics().gauge(
+      "aria2_check_integrity_queue_length",
+      "Number of downloads waiting for hash check."));
 }
 
 #ifdef HAVE_ARES_ADDR_NODE
@@ -633,7 +708,8 @@ void DownloadEngine::setWebSocketSessionMan(
 }
 #endif // ENABLE_WEBSOCKET
 
-bool DownloadEngine::validateToken(const std::string& token)
+bool DownloadEngine::validateToken(const std::string& token,
+                                   AuthTokenCache* cache)
 {
   using namespace util::security;
 
@@ -641,6 +717,10 @@ bool DownloadEngine::validateToken(const std::string& token)
     return true;
   }
 
+  if (cache && cache->match(token)) {
+    return true;
+  }
+
   if (!tokenHMAC_) {
     tokenHMAC_ = HMAC::createRandom();
     if (!tokenHMAC_) {
@@ -651,7 +731,13 @@ bool DownloadEngine::validateToken(const std::string& token)
         tokenHMAC_->getResult(option_->get(PREF_RPC_SECRET)));
   }
 
-  return *tokenExpected_ == tokenHMAC_->getResult(token);
+  if (*tokenExpected_ != tokenHMAC_->getResult(token)) {
+    return false;
+  }
+  if (cache) {
+    cache->store(token);
+  }
+  return true;
 }
 
 } // namespace aria2
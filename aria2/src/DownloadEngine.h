@@ -65,6 +65,7 @@ class AuthConfigFactory;
 class Request;
 class EventPoll;
 class Command;
+class AuthTokenCache;
 #ifdef ENABLE_BITTORRENT
 class BtRegistry;
 #endif // ENABLE_BITTORRENT
@@ -195,6 +196,11 @@ public:
   bool deleteSocketForWriteCheck(const std::shared_ptr<SocketCore>& socket,
                                  Command* command);
 
+  // Same as above, but takes the descriptor which is not owned by
+  // SocketCore, such as eventfd.
+  bool addSocketForReadCheck(sock_t fd, Command* command);
+  bool deleteSocketForReadCheck(sock_t fd, Command* command);
+
 #ifdef ENABLE_ASYNC_DNS
 
   bool addNameResolverCheck(const std::shared_ptr<AsyncNameResolver>& resolver,
@@ -341,7 +347,11 @@ public:
   }
 #endif // ENABLE_WEBSOCKET
 
-  bool validateToken(const std::string& token);
+  // Returns true if |token| is the RPC secret.  If |cache| is not
+  // nullptr, the token cached in it is accepted without HMAC, and a
+  // valid token is cached.
+  bool validateToken(const std::string& token,
+                     AuthTokenCache* cache = nullptr);
 };
 
 } // namespace aria2
@@ -124,8 +124,10 @@ std::string FeedbackURISelector::selectFaster(
   constexpr size_t NUM_URI = 10;
   // Ignore low speed server
   constexpr int SPEED_THRESHOLD = 20_k;
-  std::vector<std::pair<std::shared_ptr<ServerStat>, std::string>> fastCands;
+  // pair of decayed download speed and URI
+  std::vector<std::pair<int, std::string>> fastCands;
   std::vector<std::string> normCands;
+  auto now = Time();
   for (const auto& u : uris) {
     if (fastCands.size() >= NUM_URI) {
       break;
@@ -146,8 +148,9 @@ std::string FeedbackURISelector::selectFaster(
       normCands.push_back(u);
     }
     else if (ss->isOK()) {
-      if (ss->getDownloadSpeed() > SPEED_THRESHOLD) {
-        fastCands.push_back(std::make_pair(ss, u));
+      auto speed = ss->getDecayedDownloadSpeed(now);
+      if (speed > SPEED_THRESHOLD) {
+        fastCands.push_back(std::make_pair(speed, u));
       }
       else {
         normCands.push_back(u);
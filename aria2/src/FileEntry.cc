@@ -278,8 +278,9 @@ std::shared_ptr<Request> FileEntry::findFasterRequest(
   A2_LOG_DEBUG("Search faster server using ServerStat.");
   // Use first 10 good URIs to introduce some randomness.
   const size_t NUM_URI = 10;
-  std::vector<std::pair<std::shared_ptr<ServerStat>, std::string>> fastCands;
-  std::vector<std::string> normCands;
+  // pair of decayed download speed and URI
+  std::vector<std::pair<int, std::string>> fastCands;
+  auto now = Time();
   for (std::deque<std::string>::const_iterator i = uris_.begin(),
                                                eoi = uris_.end();
        i != eoi && fastCands.size() < NUM_URI; ++i) {
@@ -302,10 +303,10 @@ std::shared_ptr<Request> FileEntry::findFasterRequest(
     }
     std::shared_ptr<ServerStat> ss = serverStatMan->find(host, protocol);
     if (ss && ss->isOK()) {
-      if ((basestat &&
-           ss->getDownloadSpeed() > basestat->calculateDownloadSpeed() * 1.5) ||
-          (!basestat && ss->getDownloadSpeed() > SPEED_THRESHOLD)) {
-        fastCands.push_back(std::make_pair(ss, *i));
+      auto speed = ss->getDecayedDownloadSpeed(now);
+      if ((basestat && speed > basestat->calculateDownloadSpeed() * 1.5) ||
+          (!basestat && speed > SPEED_THRESHOLD)) {
+        fastCands.push_back(std::make_pair(speed, *i));
       }
     }
   }
@@ -91,14 +91,44 @@ bool FtpConnection::sendUser()
   return socketBuffer_.sendBufferIsEmpty();
 }
 
+namespace {
+std::string createPathRequest(const char* command, const std::string& path)
+{
+  std::string request = command;
+  request += ' ';
+  request += util::percentDecode(path.begin(), path.end());
+  request += "\r\n";
+  return request;
+}
+} // namespace
+
+void FtpConnection::pushPass()
+{
+  std::string request = "PASS ";
+  request += authConfig_->getPassword();
+  request += "\r\n";
+  A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, "PASS ********"));
+  socketBuffer_.pushStr(std::move(request));
+}
+
+void FtpConnection::pushRequest(std::string request)
+{
+  A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, request.c_str()));
+  socketBuffer_.pushStr(std::move(request));
+}
+
+std::string FtpConnection::createTypeRequest() const
+{
+  std::string request = "TYPE ";
+  request += (option_->get(PREF_FTP_TYPE) == V_ASCII ? 'A' : 'I');
+  request += "\r\n";
+  return request;
+}
+
 bool FtpConnection::sendPass()
 {
   if (socketBuffer_.sendBufferIsEmpty()) {
-    std::string request = "PASS ";
-    request += authConfig_->getPassword();
-    request += "\r\n";
-    A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, "PASS ********"));
-    socketBuffer_.pushStr(std::move(request));
+    pushPass();
   }
   socketBuffer_.send();
   return socketBuffer_.sendBufferIsEmpty();
@@ -107,11 +137,7 @@ bool FtpConnection::sendPass()
 bool FtpConnection::sendType()
 {
   if (socketBuffer_.sendBufferIsEmpty()) {
-    std::string request = "TYPE ";
-    request += (option_->get(PREF_FTP_TYPE) == V_ASCII ? 'A' : 'I');
-    request += "\r\n";
-    A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, request.c_str()));
-    socketBuffer_.pushStr(std::move(request));
+    pushRequest(createTypeRequest());
   }
   socketBuffer_.send();
   return socketBuffer_.sendBufferIsEmpty();
@@ -120,9 +146,7 @@ bool FtpConnection::sendType()
 bool FtpConnection::sendPwd()
 {
   if (socketBuffer_.sendBufferIsEmpty()) {
-    std::string request = "PWD\r\n";
-    A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, request.c_str()));
-    socketBuffer_.pushStr(std::move(request));
+    pushRequest("PWD\r\n");
   }
   socketBuffer_.send();
   return socketBuffer_.sendBufferIsEmpty();
@@ -131,11 +155,7 @@ bool FtpConnection::sendPwd()
 bool FtpConnection::sendCwd(const std::string& dir)
 {
   if (socketBuffer_.sendBufferIsEmpty()) {
-    std::string request = "CWD ";
-    request += util::percentDecode(dir.begin(), dir.end());
-    request += "\r\n";
-    A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, request.c_str()));
-    socketBuffer_.pushStr(std::move(request));
+    pushRequest(createPathRequest("CWD", dir));
   }
   socketBuffer_.send();
   return socketBuffer_.sendBufferIsEmpty();
@@ -144,12 +164,7 @@ bool FtpConnection::sendCwd(const std::string& dir)
 bool FtpConnection::sendMdtm()
 {
   if (socketBuffer_.sendBufferIsEmpty()) {
-    std::string request = "MDTM ";
-    request +=
-        util::percentDecode(req_->getFile().begin(), req_->getFile().end());
-    request += "\r\n";
-    A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, request.c_str()));
-    socketBuffer_.pushStr(std::move(request));
+    pushRequest(createPathRequest("MDTM", req_->getFile()));
   }
   socketBuffer_.send();
   return socketBuffer_.sendBufferIsEmpty();
@@ -158,12 +173,36 @@ bool FtpConnection::sendMdtm()
 bool FtpConnection::sendSize()
 {
   if (socketBuffer_.sendBufferIsEmpty()) {
-    std::string request = "SIZE ";
-    request +=
-        util::percentDecode(req_->getFile().begin(), req_->getFile().end());
-    request += "\r\n";
-    A2_LOG_INFO(fmt(MSG_SENDING_REQUEST, cuid_, request.c_str()));
-    socketBuffer_.pushStr(std::move(request));
+    pushRequest(createPathRequest("SIZE", req_->getFile()));
+  }
+  socketBuffer_.send();
+  return socketBuffer_.sendBufferIsEmpty();
+}
+
+bool FtpConnection::sendLoginPipeline(bool pass)
+{
+  if (socketBuffer_.sendBufferIsEmpty()) {
+    if (pass) {
+      pushPass();
+    }
+    pushRequest(createTypeRequest());
+    pushRequest("PWD\r\n");
+  }
+  socketBuffer_.send();
+  return socketBuffer_.sendBufferIsEmpty();
+}
+
+bool FtpConnection::sendCwdPipeline(const std::deque<std::string>& dirs,
+                                    bool mdtm)
+{
+  if (socketBuffer_.sendBufferIsEmpty()) {
+    for (auto& dir : dirs) {
+      pushRequest(createPathRequest("CWD", dir));
+    }
+    if (mdtm) {
+      pushRequest(createPathRequest("MDTM", req_->getFile()));
+    }
+    pushRequest(createPathRequest("SIZE", req_->getFile()));
   }
   socketBuffer_.send();
   return socketBuffer_.sendBufferIsEmpty();
@@ -40,6 +40,7 @@
 #include <utility>
 #include <string>
 #include <memory>
+#include <deque>
 
 #include "TimeA2.h"
 #include "SocketBuffer.h"
@@ -75,6 +76,10 @@ private:
                                            const std::string& buf) const;
   bool bulkReceiveResponse(std::pair<int, std::string>& response);
 
+  void pushPass();
+  void pushRequest(std::string request);
+  std::string createTypeRequest() const;
+
   // prepare for large banners
   static const size_t MAX_RECV_BUFFER = 64_k;
 
@@ -99,6 +104,19 @@ public:
   bool sendRest(const std::shared_ptr<Segment>& segment);
   bool sendRetr();
 
+  // The pipelined variants below queue several commands in one write
+  // without waiting for the replies in between.  The replies must be
+  // received one by one in the order of the commands, and they may
+  // all be in the receive buffer already, so the caller must not wait
+  // for the socket to become readable before the next receive call.
+  // Like the other send functions, they return true if everything was
+  // sent, and must be called again until then.
+
+  // Sends PASS if |pass| is true, TYPE and PWD.
+  bool sendLoginPipeline(bool pass);
+  // Sends CWD for each of |dirs|, MDTM if |mdtm| is true, and SIZE.
+  bool sendCwdPipeline(const std::deque<std::string>& dirs, bool mdtm);
+
   int receiveResponse();
   int receiveSizeResponse(int64_t& size);
   // Returns status code of MDTM reply. If the status code is 213, parses
@@ -112,6 +130,11 @@ public:
   int receivePasvResponse(std::pair<std::string, uint16_t>& dest);
   int receivePwdResponse(std::string& pwd);
 
+  // Returns true if a part of the next reply was received already.
+  // It is in our buffer, so the socket does not become readable for
+  // it again.
+  bool isResponseBuffered() const { return !strbuf_.empty(); }
+
   void setBaseWorkingDir(const std::string& baseWorkingDir);
 
   const std::string& getBaseWorkingDir() const { return baseWorkingDir_; }
@@ -74,25 +74,29 @@ bool FtpFinishDownloadCommand::execute()
     return true;
   }
   try {
+    // The reply to RETR often arrives together with the preceding 150
+    // reply for a small file, so it may be buffered already.  Only new
+    // data counts as progress, though: a partial reply in the buffer
+    // must not keep the command from timing out.
+    int status = 0;
     if (readEventEnabled() || hupEventEnabled()) {
       getCheckPoint() = global::wallclock();
-      int status = ftpConnection_->receiveResponse();
-      if (status == 0) {
-        addCommandSelf();
-        return false;
-      }
-      if (status == 226) {
-        if (getOption()->getAsBool(PREF_FTP_REUSE_CONNECTION)) {
-          getDownloadEngine()->poolSocket(
-              getRequest(), ftpConnection_->getUser(), createProxyRequest(),
-              getSocket(), ftpConnection_->getBaseWorkingDir());
-        }
-      }
-      else {
-        A2_LOG_INFO(fmt("CUID#%" PRId64 " - Bad status for transfer complete.",
-                        getCuid()));
+      status = ftpConnection_->receiveResponse();
+    }
+    else if (ftpConnection_->isResponseBuffered()) {
+      status = ftpConnection_->receiveResponse();
+    }
+    if (status == 226) {
+      if (getOption()->getAsBool(PREF_FTP_REUSE_CONNECTION)) {
+        getDownloadEngine()->poolSocket(
+            getRequest(), ftpConnection_->getUser(), createProxyRequest(),
+            getSocket(), ftpConnection_->getBaseWorkingDir());
       }
     }
+    else if (status != 0) {
+      A2_LOG_INFO(fmt("CUID#%" PRId64 " - Bad status for transfer complete.",
+                      getCuid()));
+    }
     else if (getCheckPoint().difference(global::wallclock()) >= getTimeout()) {
       A2_LOG_INFO(fmt("CUID#%" PRId64
                       " - Timeout before receiving transfer complete.",
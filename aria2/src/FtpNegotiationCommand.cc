@@ -91,7 +91,8 @@ FtpNegotiationCommand::FtpNegotiationCommand(
           e->getAuthConfigFactory()->createAuthConfig(
               req, requestGroup->getOption().get()),
           getOption().get())),
-      pasvPort_(0)
+      pasvPort_(0),
+      pipelining_(getOption()->getAsBool(PREF_FTP_PIPELINING))
 {
   ftp_->setBaseWorkingDir(baseWorkingDir);
   if (seq == SEQ_RECV_GREETING) {
@@ -202,7 +203,7 @@ bool FtpNegotiationCommand::recvUser()
 
 bool FtpNegotiationCommand::sendPass()
 {
-  if (ftp_->sendPass()) {
+  if (pipelining_ ? ftp_->sendLoginPipeline(true) : ftp_->sendPass()) {
     disableWriteCheckSocket();
     sequence_ = SEQ_RECV_PASS;
   }
@@ -222,13 +223,14 @@ bool FtpNegotiationCommand::recvPass()
     throw DL_ABORT_EX2(fmt(EX_BAD_STATUS, status),
                        error_code::FTP_PROTOCOL_ERROR);
   }
-  sequence_ = SEQ_SEND_TYPE;
+  // TYPE and PWD were sent together with PASS.
+  sequence_ = pipelining_ ? SEQ_RECV_TYPE : SEQ_SEND_TYPE;
   return true;
 }
 
 bool FtpNegotiationCommand::sendType()
 {
-  if (ftp_->sendType()) {
+  if (pipelining_ ? ftp_->sendLoginPipeline(false) : ftp_->sendType()) {
     disableWriteCheckSocket();
     sequence_ = SEQ_RECV_TYPE;
   }
@@ -248,7 +250,7 @@ bool FtpNegotiationCommand::recvType()
     throw DL_ABORT_EX2(fmt(EX_BAD_STATUS, status),
                        error_code::FTP_PROTOCOL_ERROR);
   }
-  sequence_ = SEQ_SEND_PWD;
+  sequence_ = pipelining_ ? SEQ_RECV_PWD : SEQ_SEND_PWD;
   return true;
 }
 
@@ -295,7 +297,10 @@ bool FtpNegotiationCommand::sendCwdPrep()
 
 bool FtpNegotiationCommand::sendCwd()
 {
-  if (ftp_->sendCwd(cwdDirs_.front())) {
+  if (pipelining_
+          ? ftp_->sendCwdPipeline(cwdDirs_,
+                                  getOption()->getAsBool(PREF_REMOTE_TIME))
+          : ftp_->sendCwd(cwdDirs_.front())) {
     disableWriteCheckSocket();
     sequence_ = SEQ_RECV_CWD;
   }
@@ -312,7 +317,12 @@ bool FtpNegotiationCommand::recvCwd()
     return false;
   }
   if (status != 250) {
-    poolConnection();
+    // With pipelining, the replies to the rest of the commands are
+    // still on the way, and the next user of the connection would
+    // read them.
+    if (!pipelining_) {
+      poolConnection();
+    }
     getRequestGroup()->increaseAndValidateFileNotFoundCount();
     if (status == 550)
       throw DL_ABORT_EX2(MSG_RESOURCE_NOT_FOUND,
@@ -324,14 +334,14 @@ bool FtpNegotiationCommand::recvCwd()
   cwdDirs_.pop_front();
   if (cwdDirs_.empty()) {
     if (getOption()->getAsBool(PREF_REMOTE_TIME)) {
-      sequence_ = SEQ_SEND_MDTM;
+      sequence_ = pipelining_ ? SEQ_RECV_MDTM : SEQ_SEND_MDTM;
     }
     else {
-      sequence_ = SEQ_SEND_SIZE;
+      sequence_ = pipelining_ ? SEQ_RECV_SIZE : SEQ_SEND_SIZE;
     }
   }
   else {
-    sequence_ = SEQ_SEND_CWD;
+    sequence_ = pipelining_ ? SEQ_RECV_CWD : SEQ_SEND_CWD;
   }
   return true;
 }
@@ -369,7 +379,7 @@ bool FtpNegotiationCommand::recvMdtm()
   else {
     A2_LOG_INFO(fmt("CUID#%" PRId64 " - MDTM command failed.", getCuid()));
   }
-  sequence_ = SEQ_SEND_SIZE;
+  sequence_ = pipelining_ ? SEQ_RECV_SIZE : SEQ_SEND_SIZE;
   return true;
 }
 
@@ -154,6 +154,9 @@ private:
   std::string proxyAddr_;
 
   std::deque<std::string> cwdDirs_;
+  // True if the commands which do not depend on each other's reply
+  // are sent in one batch.  See --ftp-pipelining.
+  bool pipelining_;
 
 protected:
   virtual bool executeInternal() CXX11_OVERRIDE;
@@ -96,8 +96,16 @@ GZipDecodingStreamFilter::transform(const std::shared_ptr<BinaryStream>& out,
 
   unsigned char outbuf[OUTBUF_LENGTH];
   while (1) {
-    strm_->avail_out = OUTBUF_LENGTH;
-    strm_->next_out = outbuf;
+    // Inflate into the buffer of the sink if it lends one, so that
+    // the output is not copied again.
+    size_t buflen = OUTBUF_LENGTH;
+    unsigned char* buf = getDelegate()->reserve(segment, buflen);
+    if (!buf) {
+      buf = outbuf;
+      buflen = OUTBUF_LENGTH;
+    }
+    strm_->avail_out = buflen;
+    strm_->next_out = buf;
 
     int ret = ::inflate(strm_, Z_NO_FLUSH);
 
@@ -108,9 +116,9 @@ GZipDecodingStreamFilter::transform(const std::shared_ptr<BinaryStream>& out,
       throw DL_ABORT_EX(fmt("libz::inflate() failed. cause:%s", strm_->msg));
     }
 
-    size_t produced = OUTBUF_LENGTH - strm_->avail_out;
+    size_t produced = buflen - strm_->avail_out;
 
-    outlen += getDelegate()->transform(out, segment, outbuf, produced);
+    outlen += getDelegate()->transform(out, segment, buf, produced);
     if (strm_->avail_out > 0) {
       break;
     }
@@ -239,6 +239,7 @@ constexpr const char* INTERESTING_HEADER_NAMES[] = {
     "origin",
     "port",
     "retry-after",
+    "sec-websocket-extensions",
     "sec-websocket-key",
     "sec-websocket-version",
     "set-cookie",
@@ -90,6 +90,7 @@ public:
     ORIGIN,
     PORT, // Used for BitTorrent LPD
     RETRY_AFTER,
+    SEC_WEBSOCKET_EXTENSIONS,
     SEC_WEBSOCKET_KEY,
     SEC_WEBSOCKET_VERSION,
     SET_COOKIE,
@@ -329,6 +329,10 @@ bool HttpServer::authenticate()
   if (authHeader.empty()) {
     return false;
   }
+  // Keep-alive clients send the same header with every request.
+  if (authHeaderCache_.match(authHeader)) {
+    return true;
+  }
   auto p = util::divide(std::begin(authHeader), std::end(authHeader), ' ');
   if (!util::streq(p.first.first, p.first.second, "Basic")) {
     return false;
@@ -338,8 +342,12 @@ bool HttpServer::authenticate()
   auto up = util::divide(std::begin(userpass), std::end(userpass), ':', false);
   std::string username(up.first.first, up.first.second);
   std::string password(up.second.first, up.second.second);
-  return *username_ == hmac_->getResult(username) &&
-         (!password_ || *password_ == hmac_->getResult(password));
+  if (*username_ != hmac_->getResult(username) ||
+      (password_ && *password_ != hmac_->getResult(password))) {
+    return false;
+  }
+  authHeaderCache_.store(authHeader);
+  return true;
 }
 
 void HttpServer::setUsernamePassword(const std::string& username,
@@ -351,6 +359,7 @@ void HttpServer::setUsernamePassword(const std::string& username,
     hmac_ = HMAC::createRandom();
   }
 
+  authHeaderCache_.clear();
   if (!username.empty()) {
     username_ = make_unique<HMACResult>(hmac_->getResult(username));
   }
@@ -375,6 +384,11 @@ int HttpServer::setupResponseRecv()
       lastBody_.reset();
       return 0;
     }
+    if (path == "/metrics") {
+      reqType_ = RPC_TYPE_METRICS;
+      lastBody_.reset();
+      return 0;
+    }
   }
   else if (getMethod() == "POST") {
     if (path == "/jsonrpc") {
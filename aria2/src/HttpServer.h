@@ -43,6 +43,7 @@
 #include <memory>
 
 #include "SocketBuffer.h"
+#include "AuthTokenCache.h"
 
 namespace aria2 {
 
@@ -60,7 +61,14 @@ class HMACResult;
 } // namespace security
 } // namespace util
 
-enum RequestType { RPC_TYPE_NONE, RPC_TYPE_XML, RPC_TYPE_JSON, RPC_TYPE_JSONP };
+enum RequestType {
+  RPC_TYPE_NONE,
+  RPC_TYPE_XML,
+  RPC_TYPE_JSON,
+  RPC_TYPE_JSONP,
+  // GET /metrics in Prometheus text format
+  RPC_TYPE_METRICS
+};
 
 // HTTP server class handling RPC request from the client.  It is not
 // intended to be a generic HTTP server.
@@ -83,6 +91,12 @@ private:
   bool gzip_;
   std::unique_ptr<util::security::HMACResult> username_;
   std::unique_ptr<util::security::HMACResult> password_;
+  // Authorization header field which last passed authenticate() on
+  // this connection
+  AuthTokenCache authHeaderCache_;
+  // RPC secret token which last passed the validation on this
+  // connection
+  AuthTokenCache tokenCache_;
   bool acceptsGZip_;
   std::string allowOrigin_;
   bool secure_;
@@ -130,6 +144,8 @@ public:
   void setUsernamePassword(const std::string& username,
                            const std::string& password);
 
+  AuthTokenCache* getTokenCache() { return &tokenCache_; }
+
   ssize_t sendResponse();
 
   bool sendBufferIsEmpty() const;
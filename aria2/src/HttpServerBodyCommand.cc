@@ -60,6 +60,7 @@
 #include "rpc_helper.h"
 #include "JsonDiskWriter.h"
 #include "ValueBaseJsonParser.h"
+#include "Metrics.h"
 #ifdef ENABLE_XML_RPC
 #  include "XmlRpcRequestParserStateMachine.h"
 #  include "XmlRpcDiskWriter.h"
@@ -93,6 +94,26 @@ HttpServerBodyCommand::~HttpServerBodyCommand()
   }
 }
 
+namespace {
+// Returns the percent-decoded value of "token" parameter in |query|.
+// |query| must start with '?' if it is not empty.
+std::string getTokenParam(const std::string& query)
+{
+  if (query.empty()) {
+    return A2STR::NIL;
+  }
+  std::vector<Scip> params;
+  util::splitIter(query.begin() + 1, query.end(), std::back_inserter(params),
+                  '&');
+  for (const auto& p : params) {
+    if (util::startsWith(p.first, p.second, "token=")) {
+      return util::percentDecode(p.first + 6, p.second);
+    }
+  }
+  return A2STR::NIL;
+}
+} // namespace
+
 namespace {
 std::string getJsonRpcContentType(bool script)
 {
@@ -239,6 +260,7 @@ bool HttpServerBodyCommand::execute()
             return true;
           }
           A2_LOG_INFO(fmt("Executing RPC method %s", req.methodName.c_str()));
+          req.tokenCache = httpServer_->getTokenCache();
           auto method = rpc::getMethod(req.methodName);
           auto res = method->execute(std::move(req), e_);
           bool gzip = httpServer_->supportsGZip();
@@ -283,7 +305,8 @@ bool HttpServerBodyCommand::execute()
           }
           Dict* jsondict = downcast<Dict>(json);
           if (jsondict) {
-            auto res = rpc::processJsonRpcRequest(jsondict, e_);
+            auto res = rpc::processJsonRpcRequest(
+                jsondict, e_, httpServer_->getTokenCache());
             sendJsonRpcResponse(res, callback);
           }
           else {
@@ -296,7 +319,8 @@ bool HttpServerBodyCommand::execute()
                    i != eoi; ++i) {
                 Dict* jsondict = downcast<Dict>(*i);
                 if (jsondict) {
-                  auto resp = rpc::processJsonRpcRequest(jsondict, e_);
+                  auto resp = rpc::processJsonRpcRequest(
+                      jsondict, e_, httpServer_->getTokenCache());
                   results.push_back(std::move(resp));
                 }
               }
@@ -310,6 +334,24 @@ bool HttpServerBodyCommand::execute()
           }
           return true;
         }
+        case RPC_TYPE_METRICS: {
+          // The secret is given as "token" query parameter, since
+          // Prometheus cannot send it in the request body.
+          if (!e_->validateToken(getTokenParam(query),
+                                 httpServer_->getTokenCache())) {
+            A2_LOG_INFO(fmt("CUID#%" PRId64
+                            " - Metrics request with invalid token",
+                            getCuid()));
+            httpServer_->disableKeepAlive();
+            httpServer_->feedResponse(403);
+            addHttpServerResponseCommand(true);
+            return true;
+          }
+          httpServer_->feedResponse(global::metrics().toPrometheusText(),
+                                    "text/plain; version=0.0.4");
+          addHttpServerResponseCommand(false);
+          return true;
+        }
         default:
           httpServer_->feedResponse(404);
           addHttpServerResponseCommand(false);
@@ -55,6 +55,9 @@
 #include "message_digest_helper.h"
 #ifdef ENABLE_WEBSOCKET
 #  include "WebSocketResponseCommand.h"
+#  ifdef HAVE_ZLIB
+#    include "PermessageDeflate.h"
+#  endif // HAVE_ZLIB
 #endif // ENABLE_WEBSOCKET
 
 namespace aria2 {
@@ -216,11 +219,20 @@ bool HttpServerCommand::execute()
         if (status == 101) {
           std::string serverKey = createWebSocketServerKey(
               header->find(HttpHeader::SEC_WEBSOCKET_KEY));
-          httpServer_->feedUpgradeResponse(
-              "websocket",
-              fmt("Sec-WebSocket-Accept: %s\r\n", serverKey.c_str()));
+          std::string headers =
+              fmt("Sec-WebSocket-Accept: %s\r\n", serverKey.c_str());
+          std::string extensions;
+#  ifdef HAVE_ZLIB
+          extensions = rpc::negotiatePermessageDeflate(
+              header->findAll(HttpHeader::SEC_WEBSOCKET_EXTENSIONS));
+          if (!extensions.empty()) {
+            headers += fmt("Sec-WebSocket-Extensions: %s\r\n",
+                           extensions.c_str());
+          }
+#  endif // HAVE_ZLIB
+          httpServer_->feedUpgradeResponse("websocket", headers);
           e_->addCommand(make_unique<rpc::WebSocketResponseCommand>(
-              getCuid(), httpServer_, e_, socket_));
+              getCuid(), httpServer_, e_, socket_, !extensions.empty()));
         }
         else {
           if (status == 426) {
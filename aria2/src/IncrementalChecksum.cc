@@ -0,0 +1,142 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2013 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "IncrementalChecksum.h"
+
+#include <array>
+#include <algorithm>
+
+#include "MessageDigest.h"
+#include "Piece.h"
+#include "PieceStorage.h"
+#include "DiskAdaptor.h"
+#include "RecoverableException.h"
+#include "DlAbortEx.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include "message.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+namespace {
+Counter* hashedBytesCounter()
+{
+  static auto c = global::metrics().counter(
+      "aria2_checksum_incremental_bytes_total",
+      "Number of bytes hashed for whole file checksums during downloads.");
+  return c;
+}
+} // namespace
+
+IncrementalChecksum::IncrementalChecksum(const std::string& hashType,
+                                         int32_t pieceLength,
+                                         int64_t totalLength)
+    : hashType_{hashType},
+      pieceLength_{pieceLength},
+      totalLength_{totalLength},
+      offset_{0},
+      ctx_{MessageDigest::create(hashType)}
+{
+}
+
+IncrementalChecksum::~IncrementalChecksum() = default;
+
+void IncrementalChecksum::update(const std::shared_ptr<Piece>& piece,
+                                 const std::shared_ptr<DiskAdaptor>& adaptor)
+{
+  if (static_cast<int64_t>(piece->getIndex()) * pieceLength_ != offset_) {
+    return;
+  }
+  try {
+    piece->updateHashWithWrCache(ctx_.get(), pieceLength_, adaptor);
+    offset_ += piece->getLength();
+    hashedBytesCounter()->add(piece->getLength());
+  }
+  catch (RecoverableException& e) {
+    A2_LOG_INFO_EX("Could not hash the piece for the checksum. Starting over.",
+                   e);
+    reset();
+  }
+}
+
+void IncrementalChecksum::update(PieceStorage* pieceStorage,
+                                 size_t maxPieces)
+{
+  auto adaptor = pieceStorage->getDiskAdaptor();
+  std::array<unsigned char, 16_k> buf;
+  try {
+    for (; maxPieces > 0 && offset_ < totalLength_ &&
+           pieceStorage->hasPiece(offset_ / pieceLength_);
+         --maxPieces) {
+      int64_t last =
+          std::min(offset_ + static_cast<int64_t>(pieceLength_), totalLength_);
+      int64_t start = offset_;
+      while (offset_ < last) {
+        ssize_t r = adaptor->readData(
+            buf.data(),
+            std::min(static_cast<int64_t>(buf.size()), last - offset_),
+            offset_);
+        if (r <= 0) {
+          throw DL_ABORT_EX(fmt(EX_FILE_READ, "n/a", "data is too short"));
+        }
+        ctx_->update(buf.data(), r);
+        offset_ += r;
+      }
+      hashedBytesCounter()->add(last - start);
+    }
+  }
+  catch (RecoverableException& e) {
+    A2_LOG_INFO_EX("Could not hash the piece for the checksum. Starting over.",
+                   e);
+    reset();
+  }
+}
+
+std::unique_ptr<MessageDigest> IncrementalChecksum::popContext()
+{
+  auto ctx = std::move(ctx_);
+  ctx_ = MessageDigest::create(hashType_);
+  offset_ = 0;
+  return ctx;
+}
+
+void IncrementalChecksum::reset()
+{
+  ctx_->reset();
+  offset_ = 0;
+}
+
+} // namespace aria2
@@ -0,0 +1,92 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2013 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_INCREMENTAL_CHECKSUM_H
+#define D_INCREMENTAL_CHECKSUM_H
+
+#include "common.h"
+
+#include <memory>
+#include <string>
+
+namespace aria2 {
+
+class MessageDigest;
+class Piece;
+class PieceStorage;
+class DiskAdaptor;
+
+// Digest of the whole file, computed from the start of the file as
+// the pieces there complete, so that the checksum verification after
+// the download only reads the rest of the file.  The pieces
+// completing in order are hashed before their data leaves the write
+// disk cache.  The pieces completed out of order are read back from
+// the disk when the gap before them is filled.
+class IncrementalChecksum {
+public:
+  IncrementalChecksum(const std::string& hashType, int32_t pieceLength,
+                      int64_t totalLength);
+
+  ~IncrementalChecksum();
+
+  // Returns the number of bytes hashed from the start of the file.
+  int64_t getOffset() const { return offset_; }
+
+  // Hashes |piece| if it is the next one.  The caller must call this
+  // before |piece| is completed, while its data may still be in the
+  // write disk cache.
+  void update(const std::shared_ptr<Piece>& piece,
+              const std::shared_ptr<DiskAdaptor>& adaptor);
+
+  // Hashes at most |maxPieces| completed pieces following the hashed
+  // ones, reading them from the disk.
+  void update(PieceStorage* pieceStorage, size_t maxPieces);
+
+  // Returns the digest context, which has been fed getOffset() bytes,
+  // and starts over from the start of the file.
+  std::unique_ptr<MessageDigest> popContext();
+
+private:
+  void reset();
+
+  std::string hashType_;
+  int32_t pieceLength_;
+  int64_t totalLength_;
+  int64_t offset_;
+  std::unique_ptr<MessageDigest> ctx_;
+};
+
+} // namespace aria2
+
+#endif // D_INCREMENTAL_CHECKSUM_H
@@ -37,7 +37,9 @@
 
 #include "common.h"
 
-#include <deque>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
 #include <unordered_map>
 #include <vector>
 #include <algorithm>
@@ -46,36 +48,237 @@
 
 namespace aria2 {
 
-template <typename SeqType, typename ValueType, typename ReferenceType,
-          typename PointerType, typename SeqIteratorType>
+// The elements of IndexedList are kept in a treap keyed implicitly
+// by their position.  Each node knows the number of nodes in its
+// subtree, so the position of a node and the node at a given
+// position are found in O(log N).  The nodes also have the pointer
+// to their parent, so that the position of the node found by the
+// key can be computed without searching the sequence.
+struct IndexedListNodeBase {
+  IndexedListNodeBase* left;
+  IndexedListNodeBase* right;
+  IndexedListNodeBase* parent;
+  size_t size;
+  uint32_t priority;
+};
+
+namespace indexed_list {
+
+inline size_t size(const IndexedListNodeBase* t) { return t ? t->size : 0; }
+
+// Recomputes the size of |t| and makes |t| the parent of its
+// children.
+inline void update(IndexedListNodeBase* t)
+{
+  t->size = 1 + size(t->left) + size(t->right);
+  if (t->left) {
+    t->left->parent = t;
+  }
+  if (t->right) {
+    t->right->parent = t;
+  }
+}
+
+// Concatenates the trees |a| and |b| and returns the new root.  The
+// parent of the returned root is not updated.
+inline IndexedListNodeBase* merge(IndexedListNodeBase* a,
+                                  IndexedListNodeBase* b)
+{
+  if (!a) {
+    return b;
+  }
+  if (!b) {
+    return a;
+  }
+  if (a->priority > b->priority) {
+    a->right = merge(a->right, b);
+    update(a);
+    return a;
+  }
+  else {
+    b->left = merge(a, b->left);
+    update(b);
+    return b;
+  }
+}
+
+// Splits the tree |t| into |a|, which contains the first |n| nodes,
+// and |b|, which contains the rest.  The parents of the roots of |a|
+// and |b| are not updated.
+inline void split(IndexedListNodeBase* t, size_t n, IndexedListNodeBase*& a,
+                  IndexedListNodeBase*& b)
+{
+  if (!t) {
+    a = b = nullptr;
+    return;
+  }
+  if (size(t->left) < n) {
+    split(t->right, n - size(t->left) - 1, t->right, b);
+    update(t);
+    a = t;
+  }
+  else {
+    split(t->left, n, a, t->left);
+    update(t);
+    b = t;
+  }
+}
+
+inline IndexedListNodeBase* leftmost(IndexedListNodeBase* t)
+{
+  if (t) {
+    for (; t->left; t = t->left)
+      ;
+  }
+  return t;
+}
+
+inline IndexedListNodeBase* rightmost(IndexedListNodeBase* t)
+{
+  if (t) {
+    for (; t->right; t = t->right)
+      ;
+  }
+  return t;
+}
+
+// Returns the node following |t| in the sequence, or nullptr if |t|
+// is the last node.
+inline IndexedListNodeBase* next(IndexedListNodeBase* t)
+{
+  if (t->right) {
+    return leftmost(t->right);
+  }
+  for (; t->parent && t->parent->right == t; t = t->parent)
+    ;
+  return t->parent;
+}
+
+// Returns the node preceding |t| in the tree |root|.  If |t| is
+// nullptr, which denotes the end of the sequence, returns the last
+// node.
+inline IndexedListNodeBase* prev(IndexedListNodeBase* root,
+                                 IndexedListNodeBase* t)
+{
+  if (!t) {
+    return rightmost(root);
+  }
+  if (t->left) {
+    return rightmost(t->left);
+  }
+  for (; t->parent && t->parent->left == t; t = t->parent)
+    ;
+  return t->parent;
+}
+
+// Returns the position of the node |t| in its tree.
+inline size_t rank(const IndexedListNodeBase* t)
+{
+  size_t r = size(t->left);
+  for (; t->parent; t = t->parent) {
+    if (t->parent->right == t) {
+      r += size(t->parent->left) + 1;
+    }
+  }
+  return r;
+}
+
+// Returns the node at the position |n| in the tree |t|, or nullptr
+// if |n| is out of range.
+inline IndexedListNodeBase* select(IndexedListNodeBase* t, size_t n)
+{
+  while (t) {
+    auto lsize = size(t->left);
+    if (n < lsize) {
+      t = t->left;
+    }
+    else if (n == lsize) {
+      return t;
+    }
+    else {
+      n -= lsize + 1;
+      t = t->right;
+    }
+  }
+  return nullptr;
+}
+
+// Builds the tree from |nodes| in O(N), keeping their order, and
+// returns its root.
+inline IndexedListNodeBase*
+build(const std::vector<IndexedListNodeBase*>& nodes)
+{
+  // Right spine of the tree built so far.
+  std::vector<IndexedListNodeBase*> spine;
+  for (auto t : nodes) {
+    IndexedListNodeBase* last = nullptr;
+    while (!spine.empty() && spine.back()->priority < t->priority) {
+      last = spine.back();
+      spine.pop_back();
+      // The subtree of |last| is complete.
+      update(last);
+    }
+    t->left = last;
+    t->right = nullptr;
+    if (!spine.empty()) {
+      spine.back()->right = t;
+    }
+    spine.push_back(t);
+  }
+  if (spine.empty()) {
+    return nullptr;
+  }
+  for (auto i = spine.rbegin(), eoi = spine.rend(); i != eoi; ++i) {
+    update(*i);
+  }
+  spine.front()->parent = nullptr;
+  return spine.front();
+}
+
+} // namespace indexed_list
+
+template <typename NodeType, typename ValueType, typename ReferenceType,
+          typename PointerType>
 struct IndexedListIterator {
-  typedef IndexedListIterator<SeqType, ValueType, ValueType&, ValueType*,
-                              typename SeqType::iterator>
+  typedef IndexedListIterator<NodeType, ValueType, ValueType&, ValueType*>
       iterator;
-  typedef IndexedListIterator<SeqType, ValueType, const ValueType&,
-                              const ValueType*,
-                              typename SeqType::const_iterator>
+  typedef IndexedListIterator<NodeType, ValueType, const ValueType&,
+                              const ValueType*>
       const_iterator;
 
-  typedef typename SeqIteratorType::iterator_category iterator_category;
+  typedef std::random_access_iterator_tag iterator_category;
   typedef ValueType value_type;
   typedef PointerType pointer;
   typedef ReferenceType reference;
-  typedef typename SeqType::size_type size_type;
-  typedef typename SeqType::difference_type difference_type;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
   typedef IndexedListIterator SelfType;
 
-  IndexedListIterator() = default;
-  IndexedListIterator(const iterator& other) : p(other.p) {}
-  IndexedListIterator(const SeqIteratorType& p) : p(p) {}
+  IndexedListIterator() : root(nullptr), node(nullptr) {}
+  IndexedListIterator(const iterator& other)
+      : root(other.root), node(other.node)
+  {
+  }
+  IndexedListIterator(IndexedListNodeBase* const* root,
+                      IndexedListNodeBase* node)
+      : root(root), node(node)
+  {
+  }
+
+  reference operator*() const { return static_cast<NodeType*>(node)->value; }
 
-  reference operator*() const { return (*p).second; }
+  pointer operator->() const { return &static_cast<NodeType*>(node)->value; }
 
-  pointer operator->() const { return &(*p).second; }
+  // Returns the position of this iterator in the list.  Complexity:
+  // O(log N)
+  difference_type index() const
+  {
+    return node ? indexed_list::rank(node) : indexed_list::size(*root);
+  }
 
   SelfType& operator++()
   {
-    ++p;
+    node = indexed_list::next(node);
     return *this;
   }
 
@@ -88,7 +291,7 @@ struct IndexedListIterator {
 
   SelfType& operator--()
   {
-    --p;
+    node = indexed_list::prev(*root, node);
     return *this;
   }
 
@@ -101,7 +304,12 @@ struct IndexedListIterator {
 
   SelfType& operator+=(difference_type n)
   {
-    std::advance(p, n);
+    if (n == 1 && node) {
+      return ++*this;
+    }
+    if (n != 0) {
+      node = indexed_list::select(*root, index() + n);
+    }
     return *this;
   }
 
@@ -111,11 +319,7 @@ struct IndexedListIterator {
     return copy += n;
   }
 
-  SelfType& operator-=(difference_type n)
-  {
-    std::advance(p, -n);
-    return *this;
-  }
+  SelfType& operator-=(difference_type n) { return *this += -n; }
 
   SelfType operator-(difference_type n) const
   {
@@ -123,298 +327,201 @@ struct IndexedListIterator {
     return copy -= n;
   }
 
-  reference operator[](size_type n) const { return p[n].second; }
+  reference operator[](size_type n) const { return *(*this + n); }
 
-  SeqIteratorType p;
+  IndexedListNodeBase* const* root;
+  IndexedListNodeBase* node;
 };
 
-template <typename SeqType, typename ValueType, typename ReferenceType,
-          typename PointerType, typename SeqIteratorType>
-bool operator==(const IndexedListIterator<SeqType, ValueType, ReferenceType,
-                                          PointerType, SeqIteratorType>& lhs,
-                const IndexedListIterator<SeqType, ValueType, ReferenceType,
-                                          PointerType, SeqIteratorType>& rhs)
-{
-  return lhs.p == rhs.p;
-}
-
-template <typename SeqType, typename ValueType, typename ReferenceTypeL,
-          typename PointerTypeL, typename SeqIteratorTypeL,
-          typename ReferenceTypeR, typename PointerTypeR,
-          typename SeqIteratorTypeR>
-bool operator==(const IndexedListIterator<SeqType, ValueType, ReferenceTypeL,
-                                          PointerTypeL, SeqIteratorTypeL>& lhs,
-                const IndexedListIterator<SeqType, ValueType, ReferenceTypeR,
-                                          PointerTypeR, SeqIteratorTypeR>& rhs)
-{
-  return lhs.p == rhs.p;
-}
-
-template <typename SeqType, typename ValueType, typename ReferenceType,
-          typename PointerType, typename SeqIteratorType>
-bool operator!=(const IndexedListIterator<SeqType, ValueType, ReferenceType,
-                                          PointerType, SeqIteratorType>& lhs,
-                const IndexedListIterator<SeqType, ValueType, ReferenceType,
-                                          PointerType, SeqIteratorType>& rhs)
-{
-  return lhs.p != rhs.p;
-}
-
-template <typename SeqType, typename ValueType, typename ReferenceTypeL,
-          typename PointerTypeL, typename SeqIteratorTypeL,
-          typename ReferenceTypeR, typename PointerTypeR,
-          typename SeqIteratorTypeR>
-bool operator!=(const IndexedListIterator<SeqType, ValueType, ReferenceTypeL,
-                                          PointerTypeL, SeqIteratorTypeL>& lhs,
-                const IndexedListIterator<SeqType, ValueType, ReferenceTypeR,
-                                          PointerTypeR, SeqIteratorTypeR>& rhs)
-{
-  return lhs.p != rhs.p;
-}
-
-template <typename SeqType, typename ValueType, typename ReferenceType,
-          typename PointerType, typename SeqIteratorType>
-bool operator<(const IndexedListIterator<SeqType, ValueType, ReferenceType,
-                                         PointerType, SeqIteratorType>& lhs,
-               const IndexedListIterator<SeqType, ValueType, ReferenceType,
-                                         PointerType, SeqIteratorType>& rhs)
+template <typename NodeType, typename ValueType, typename ReferenceTypeL,
+          typename PointerTypeL, typename ReferenceTypeR,
+          typename PointerTypeR>
+bool operator==(const IndexedListIterator<NodeType, ValueType, ReferenceTypeL,
+                                          PointerTypeL>& lhs,
+                const IndexedListIterator<NodeType, ValueType, ReferenceTypeR,
+                                          PointerTypeR>& rhs)
 {
-  return lhs.p < rhs.p;
+  return lhs.node == rhs.node;
 }
 
-template <typename SeqType, typename ValueType, typename ReferenceTypeL,
-          typename PointerTypeL, typename SeqIteratorTypeL,
-          typename ReferenceTypeR, typename PointerTypeR,
-          typename SeqIteratorTypeR>
-bool operator<(const IndexedListIterator<SeqType, ValueType, ReferenceTypeL,
-                                         PointerTypeL, SeqIteratorTypeL>& lhs,
-               const IndexedListIterator<SeqType, ValueType, ReferenceTypeR,
-                                         PointerTypeR, SeqIteratorTypeR>& rhs)
+template <typename NodeType, typename ValueType, typename ReferenceTypeL,
+          typename PointerTypeL, typename ReferenceTypeR,
+          typename PointerTypeR>
+bool operator!=(const IndexedListIterator<NodeType, ValueType, ReferenceTypeL,
+                                          PointerTypeL>& lhs,
+                const IndexedListIterator<NodeType, ValueType, ReferenceTypeR,
+                                          PointerTypeR>& rhs)
 {
-  return lhs.p < rhs.p;
+  return lhs.node != rhs.node;
 }
 
-template <typename SeqType, typename ValueType, typename ReferenceType,
-          typename PointerType, typename SeqIteratorType>
-bool operator>(const IndexedListIterator<SeqType, ValueType, ReferenceType,
-                                         PointerType, SeqIteratorType>& lhs,
-               const IndexedListIterator<SeqType, ValueType, ReferenceType,
-                                         PointerType, SeqIteratorType>& rhs)
+template <typename NodeType, typename ValueType, typename ReferenceTypeL,
+          typename PointerTypeL, typename ReferenceTypeR,
+          typename PointerTypeR>
+bool operator<(const IndexedListIterator<NodeType, ValueType, ReferenceTypeL,
+                                         PointerTypeL>& lhs,
+               const IndexedListIterator<NodeType, ValueType, ReferenceTypeR,
+                                         PointerTypeR>& rhs)
 {
-  return lhs.p > rhs.p;
+  return lhs.index() < rhs.index();
 }
 
-template <typename SeqType, typename ValueType, typename ReferenceTypeL,
-          typename PointerTypeL, typename SeqIteratorTypeL,
-          typename ReferenceTypeR, typename PointerTypeR,
-          typename SeqIteratorTypeR>
-bool operator>(const IndexedListIterator<SeqType, ValueType, ReferenceTypeL,
-                                         PointerTypeL, SeqIteratorTypeL>& lhs,
-               const IndexedListIterator<SeqType, ValueType, ReferenceTypeR,
-                                         PointerTypeR, SeqIteratorTypeR>& rhs)
+template <typename NodeType, typename ValueType, typename ReferenceTypeL,
+          typename PointerTypeL, typename ReferenceTypeR,
+          typename PointerTypeR>
+bool operator>(const IndexedListIterator<NodeType, ValueType, ReferenceTypeL,
+                                         PointerTypeL>& lhs,
+               const IndexedListIterator<NodeType, ValueType, ReferenceTypeR,
+                                         PointerTypeR>& rhs)
 {
-  return lhs.p > rhs.p;
+  return lhs.index() > rhs.index();
 }
 
-template <typename SeqType, typename ValueType, typename ReferenceType,
-          typename PointerType, typename SeqIteratorType>
-bool operator<=(const IndexedListIterator<SeqType, ValueType, ReferenceType,
-                                          PointerType, SeqIteratorType>& lhs,
-                const IndexedListIterator<SeqType, ValueType, ReferenceType,
-                                          PointerType, SeqIteratorType>& rhs)
+template <typename NodeType, typename ValueType, typename ReferenceTypeL,
+          typename PointerTypeL, typename ReferenceTypeR,
+          typename PointerTypeR>
+bool operator<=(const IndexedListIterator<NodeType, ValueType, ReferenceTypeL,
+                                          PointerTypeL>& lhs,
+                const IndexedListIterator<NodeType, ValueType, ReferenceTypeR,
+                                          PointerTypeR>& rhs)
 {
-  return lhs.p <= rhs.p;
+  return lhs.index() <= rhs.index();
 }
 
-template <typename SeqType, typename ValueType, typename ReferenceTypeL,
-          typename PointerTypeL, typename SeqIteratorTypeL,
-          typename ReferenceTypeR, typename PointerTypeR,
-          typename SeqIteratorTypeR>
-bool operator<=(const IndexedListIterator<SeqType, ValueType, ReferenceTypeL,
-                                          PointerTypeL, SeqIteratorTypeL>& lhs,
-                const IndexedListIterator<SeqType, ValueType, ReferenceTypeR,
-                                          PointerTypeR, SeqIteratorTypeR>& rhs)
+template <typename NodeType, typename ValueType, typename ReferenceTypeL,
+          typename PointerTypeL, typename ReferenceTypeR,
+          typename PointerTypeR>
+bool operator>=(const IndexedListIterator<NodeType, ValueType, ReferenceTypeL,
+                                          PointerTypeL>& lhs,
+                const IndexedListIterator<NodeType, ValueType, ReferenceTypeR,
+                                          PointerTypeR>& rhs)
 {
-  return lhs.p <= rhs.p;
+  return lhs.index() >= rhs.index();
 }
 
-template <typename SeqType, typename ValueType, typename ReferenceType,
-          typename PointerType, typename SeqIteratorType>
-bool operator>=(const IndexedListIterator<SeqType, ValueType, ReferenceType,
-                                          PointerType, SeqIteratorType>& lhs,
-                const IndexedListIterator<SeqType, ValueType, ReferenceType,
-                                          PointerType, SeqIteratorType>& rhs)
-{
-  return lhs.p >= rhs.p;
-}
-
-template <typename SeqType, typename ValueType, typename ReferenceTypeL,
-          typename PointerTypeL, typename SeqIteratorTypeL,
-          typename ReferenceTypeR, typename PointerTypeR,
-          typename SeqIteratorTypeR>
-bool operator>=(const IndexedListIterator<SeqType, ValueType, ReferenceTypeL,
-                                          PointerTypeL, SeqIteratorTypeL>& lhs,
-                const IndexedListIterator<SeqType, ValueType, ReferenceTypeR,
-                                          PointerTypeR, SeqIteratorTypeR>& rhs)
-{
-  return lhs.p >= rhs.p;
-}
-
-template <typename SeqType, typename ValueType, typename ReferenceType,
-          typename PointerType, typename SeqIteratorType>
-IndexedListIterator<SeqType, ValueType, ReferenceType, PointerType,
-                    SeqIteratorType>
-operator+(
-    typename IndexedListIterator<SeqType, ValueType, ReferenceType, PointerType,
-                                 SeqIteratorType>::difference_type n,
-    const IndexedListIterator<SeqType, ValueType, ReferenceType, PointerType,
-                              SeqIteratorType>& lhs)
+template <typename NodeType, typename ValueType, typename ReferenceType,
+          typename PointerType>
+IndexedListIterator<NodeType, ValueType, ReferenceType, PointerType>
+operator+(typename IndexedListIterator<NodeType, ValueType, ReferenceType,
+                                       PointerType>::difference_type n,
+          const IndexedListIterator<NodeType, ValueType, ReferenceType,
+                                    PointerType>& lhs)
 {
   return lhs + n;
 }
 
-template <typename SeqType, typename ValueType, typename ReferenceType,
-          typename PointerType, typename SeqIteratorType>
-typename IndexedListIterator<SeqType, ValueType, ReferenceType, PointerType,
-                             SeqIteratorType>::difference_type
-operator-(const IndexedListIterator<SeqType, ValueType, ReferenceType,
-                                    PointerType, SeqIteratorType>& lhs,
-          const IndexedListIterator<SeqType, ValueType, ReferenceType,
-                                    PointerType, SeqIteratorType>& rhs)
+template <typename NodeType, typename ValueType, typename ReferenceTypeL,
+          typename PointerTypeL, typename ReferenceTypeR,
+          typename PointerTypeR>
+typename IndexedListIterator<NodeType, ValueType, ReferenceTypeL,
+                             PointerTypeL>::difference_type
+operator-(const IndexedListIterator<NodeType, ValueType, ReferenceTypeL,
+                                    PointerTypeL>& lhs,
+          const IndexedListIterator<NodeType, ValueType, ReferenceTypeR,
+                                    PointerTypeR>& rhs)
 {
-  return typename IndexedListIterator<SeqType, ValueType, ReferenceType,
-                                      PointerType,
-                                      SeqIteratorType>::difference_type(lhs.p -
-                                                                        rhs.p);
-}
-
-template <typename SeqType, typename ValueType, typename ReferenceTypeL,
-          typename PointerTypeL, typename SeqIteratorTypeL,
-          typename ReferenceTypeR, typename PointerTypeR,
-          typename SeqIteratorTypeR>
-typename IndexedListIterator<SeqType, ValueType, ReferenceTypeL, PointerTypeL,
-                             SeqIteratorTypeL>::difference_type
-operator-(const IndexedListIterator<SeqType, ValueType, ReferenceTypeL,
-                                    PointerTypeL, SeqIteratorTypeL>& lhs,
-          const IndexedListIterator<SeqType, ValueType, ReferenceTypeR,
-                                    PointerTypeR, SeqIteratorTypeR>& rhs)
-{
-  return typename IndexedListIterator<SeqType, ValueType, ReferenceTypeL,
-                                      PointerTypeL,
-                                      SeqIteratorTypeL>::difference_type(lhs.p -
-                                                                         rhs.p);
+  return lhs.index() - rhs.index();
 }
 
 template <typename KeyType, typename ValuePtrType> class IndexedList {
+private:
+  struct Node : public IndexedListNodeBase {
+    Node(KeyType key, ValuePtrType value) : key(key), value(value) {}
+    KeyType key;
+    ValuePtrType value;
+  };
+
 public:
-  IndexedList() = default;
-  ~IndexedList() = default;
+  IndexedList() : root_(nullptr), seed_(0x9e3779b9u) {}
+  ~IndexedList() { clear(); }
+
+  IndexedList(const IndexedList&) = delete;
+  IndexedList& operator=(const IndexedList&) = delete;
 
   typedef KeyType key_type;
   typedef ValuePtrType value_type;
-  typedef std::unordered_map<KeyType, ValuePtrType> IndexType;
-  typedef std::deque<std::pair<KeyType, ValuePtrType>> SeqType;
+  typedef std::unordered_map<KeyType, Node*> IndexType;
 
-  typedef IndexedListIterator<SeqType, ValuePtrType, ValuePtrType&,
-                              ValuePtrType*, typename SeqType::iterator>
+  typedef IndexedListIterator<Node, ValuePtrType, ValuePtrType&,
+                              ValuePtrType*>
       iterator;
-  typedef IndexedListIterator<SeqType, ValuePtrType, const ValuePtrType&,
-                              const ValuePtrType*,
-                              typename SeqType::const_iterator>
+  typedef IndexedListIterator<Node, ValuePtrType, const ValuePtrType&,
+                              const ValuePtrType*>
       const_iterator;
 
-  ValuePtrType& operator[](size_t n) { return seq_[n].second; }
+  // Complexity: O(log N)
+  ValuePtrType& operator[](size_t n)
+  {
+    return static_cast<Node*>(indexed_list::select(root_, n))->value;
+  }
 
-  const ValuePtrType& operator[](size_t n) const { return seq_[n].second; }
+  // Complexity: O(log N)
+  const ValuePtrType& operator[](size_t n) const
+  {
+    return static_cast<Node*>(indexed_list::select(root_, n))->value;
+  }
 
   // Inserts (|key|, |value|) to the end of the list. If the same key
   // has been already added, this function fails. This function
-  // returns true if it succeeds. Complexity: O(1)
+  // returns true if it succeeds. Complexity: O(log N)
   bool push_back(KeyType key, ValuePtrType value)
   {
-    auto i = index_.find(key);
-    if (i == std::end(index_)) {
-      index_.insert({key, value});
-      seq_.emplace_back(key, value);
-      return true;
-    }
-    else {
+    auto node = newNode(key, value);
+    if (!node) {
       return false;
     }
+    setRoot(indexed_list::merge(root_, node));
+    return true;
   }
 
   // Inserts (|key|, |value|) to the front of the list. If the same
   // key has been already added, this function fails. This function
-  // returns true if it succeeds. Complexity: O(1)
+  // returns true if it succeeds. Complexity: O(log N)
   bool push_front(KeyType key, ValuePtrType value)
   {
-    auto i = index_.find(key);
-    if (i == std::end(index_)) {
-      index_.insert({key, value});
-      seq_.emplace_front(key, value);
-      return true;
-    }
-    else {
+    auto node = newNode(key, value);
+    if (!node) {
       return false;
     }
+    setRoot(indexed_list::merge(node, root_));
+    return true;
   }
 
   // Inserts (|key|, |value|) to the position |dest|. If the same key
   // has been already added, this function fails. This function
   // returns the iterator to the newly added element if it is
-  // succeeds, or end(). Complexity: O(N)
+  // succeeds, or end(). Complexity: O(log N)
   iterator insert(size_t dest, KeyType key, ValuePtrType value)
   {
     if (dest > size()) {
-      return std::end(seq_);
+      return end();
     }
-    auto i = index_.find(key);
-    if (i == std::end(index_)) {
-      auto j = std::begin(seq_);
-      std::advance(j, dest);
-      index_.insert({key, value});
-      return iterator(seq_.insert(j, {key, value}));
-    }
-    else {
-      return iterator(std::end(seq_));
+    auto node = newNode(key, value);
+    if (!node) {
+      return end();
     }
+    insertNode(dest, node);
+    return iterator(&root_, node);
   }
 
   // Inserts (|key|, |value|) to the position |dest|. If the same key
   // has been already added, this function fails. This function
   // returns the iterator to the newly added element if it is
-  // succeeds, or end(). Complexity: O(1) if inserted to the first or
-  // last, otherwise O(N)
+  // succeeds, or end(). Complexity: O(log N)
   iterator insert(iterator dest, KeyType key, ValuePtrType value)
   {
-    auto i = index_.find(key);
-    if (i == std::end(index_)) {
-      index_.insert({key, value});
-      return iterator(seq_.insert(dest.p, {key, value}));
-    }
-    else {
-      return iterator(std::end(seq_));
-    }
+    return insert(dest.index(), key, value);
   }
 
   // Inserts values in iterator range [first, last). The key for each
   // value is retrieved by functor |keyFunc|. The insertion position
-  // is given by |dest|.
+  // is given by |dest|.  Complexity: O(M + log N), where M is the
+  // number of the inserted values.
   template <typename KeyFunc, typename InputIterator>
   void insert(iterator dest, KeyFunc keyFunc, InputIterator first,
               InputIterator last)
   {
-    std::vector<typename SeqType::value_type> v;
-    v.reserve(std::distance(first, last));
-    for (; first != last; ++first) {
-      auto key = keyFunc(*first);
-      auto i = index_.find(key);
-      if (i == std::end(index_)) {
-        index_.insert({key, *first});
-        v.emplace_back(key, *first);
-      }
-    }
-    seq_.insert(dest.p, std::begin(v), std::end(v));
+    insert(dest.index(), keyFunc, first, last);
   }
 
   template <typename KeyFunc, typename InputIterator>
@@ -424,82 +531,78 @@ public:
     if (pos > size()) {
       return;
     }
-    std::vector<typename SeqType::value_type> v;
+    std::vector<IndexedListNodeBase*> v;
     v.reserve(std::distance(first, last));
     for (; first != last; ++first) {
-      auto key = keyFunc(*first);
-      auto i = index_.find(key);
-      if (i == std::end(index_)) {
-        index_.insert({key, *first});
-        v.emplace_back(key, *first);
+      auto node = newNode(keyFunc(*first), *first);
+      if (node) {
+        v.push_back(node);
       }
     }
-    seq_.insert(std::begin(seq_) + pos, std::begin(v), std::end(v));
+    if (v.empty()) {
+      return;
+    }
+    IndexedListNodeBase *a, *b;
+    indexed_list::split(root_, pos, a, b);
+    setRoot(indexed_list::merge(indexed_list::merge(a, indexed_list::build(v)),
+                                b));
   }
 
   // Removes |key| from the list. If the element is not found, this
   // function fails. This function returns true if it
-  // succeeds. Complexity: O(N)
+  // succeeds. Complexity: O(log N)
   bool remove(KeyType key)
   {
     auto i = index_.find(key);
     if (i == std::end(index_)) {
       return false;
     }
-    for (auto j = std::begin(seq_), eoj = std::end(seq_); j != eoj; ++j) {
-      if ((*j).first == key) {
-        seq_.erase(j);
-        break;
-      }
-    }
+    auto node = (*i).second;
     index_.erase(i);
+    unlink(node);
+    delete node;
     return true;
   }
 
   // Removes element pointed by iterator |k| from the list. If the
   // iterator must be valid. This function returns the iterator
   // pointing to the element following the erased element. Complexity:
-  // O(N)
+  // O(log N)
   iterator erase(iterator k)
   {
-    index_.erase((*k.p).first);
-    return iterator(seq_.erase(k.p));
+    auto node = static_cast<Node*>(k.node);
+    auto next = indexed_list::next(node);
+    index_.erase(node->key);
+    unlink(node);
+    delete node;
+    return iterator(&root_, next);
   }
 
   // Removes elements for which Pred returns true. The pred is called
-  // against each each element once per each.
+  // against each each element once per each.  Complexity: O(N + M log
+  // N), where M is the number of the removed elements.
   template <typename Pred> void remove_if(Pred pred)
   {
-    auto first = std::begin(seq_), last = std::end(seq_);
-    for (; first != last && !pred((*first).second); ++first)
-      ;
-    if (first == last) {
-      return;
-    }
-    index_.erase((*first).first);
-    auto store = first;
-    ++first;
-    for (; first != last; ++first) {
-      if (pred((*first).second)) {
-        index_.erase((*first).first);
-      }
-      else {
-        *store++ = *first;
+    for (auto t = indexed_list::leftmost(root_); t;) {
+      auto node = static_cast<Node*>(t);
+      t = indexed_list::next(t);
+      if (pred(node->value)) {
+        index_.erase(node->key);
+        unlink(node);
+        delete node;
       }
     }
-    seq_.erase(store, last);
   }
 
   // Removes element at the front of the list. If the list is empty,
   // this function fails. This function returns true if it
-  // succeeds. Complexity: O(1)
+  // succeeds. Complexity: O(log N)
   bool pop_front()
   {
-    if (seq_.empty()) {
+    if (!root_) {
       return false;
     }
-    index_.erase(seq_.front().first);
-    seq_.pop_front();
+    erase(begin());
     return true;
   }
 
@@ -511,20 +614,15 @@ public:
   // relative to the end of the list.  This function returns the
   // position the element is moved to if it succeeds, or -1 if no
   // element with |key| is found or |how| is invalid.  Complexity:
-  // O(N)
+  // O(log N)
   ssize_t move(KeyType key, ssize_t offset, OffsetMode how)
   {
     auto idxent = index_.find(key);
     if (idxent == std::end(index_)) {
       return -1;
     }
-    auto x = std::begin(seq_), eseq = std::end(seq_);
-    for (; x != eseq; ++x) {
-      if ((*x).first == (*idxent).first) {
-        break;
-      }
-    }
-    ssize_t xp = std::distance(std::begin(seq_), x);
+    auto node = (*idxent).second;
+    ssize_t xp = indexed_list::rank(node);
     ssize_t size = index_.size();
     ssize_t dest;
     if (how == OFFSET_MODE_CUR) {
@@ -547,13 +645,9 @@ public:
       }
       dest = std::max(dest, static_cast<ssize_t>(0));
     }
-    auto d = std::begin(seq_);
-    std::advance(d, dest);
-    if (xp < dest) {
-      std::rotate(x, x + 1, d + 1);
-    }
-    else {
-      std::rotate(d, x, x + 1);
+    if (xp != dest) {
+      unlink(node);
+      insertNode(dest, node);
     }
     return dest;
   }
@@ -567,7 +661,7 @@ public:
       return ValuePtrType();
     }
     else {
-      return (*idxent).second;
+      return (*idxent).second->value;
     }
   }
 
@@ -575,24 +669,93 @@ public:
 
   size_t empty() const { return index_.empty(); }
 
-  iterator begin() { return iterator(std::begin(seq_)); }
+  iterator begin() { return iterator(&root_, indexed_list::leftmost(root_)); }
 
-  iterator end() { return iterator(std::end(seq_)); }
+  iterator end() { return iterator(&root_, nullptr); }
 
-  const_iterator begin() const { return const_iterator(std::begin(seq_)); }
+  const_iterator begin() const
+  {
+    return const_iterator(&root_, indexed_list::leftmost(root_));
+  }
 
-  const_iterator end() const { return const_iterator(std::end(seq_)); }
+  const_iterator end() const { return const_iterator(&root_, nullptr); }
 
   // Removes all elements from the list.
   void clear()
   {
+    for (auto& kv : index_) {
+      delete kv.second;
+    }
     index_.clear();
-    seq_.clear();
+    root_ = nullptr;
   }
 
 private:
-  SeqType seq_;
+  // Creates the node for (|key|, |value|) and adds it to the index.
+  // Returns nullptr if |key| has been already added.
+  Node* newNode(KeyType key, ValuePtrType value)
+  {
+    auto i = index_.find(key);
+    if (i != std::end(index_)) {
+      return nullptr;
+    }
+    auto node = new Node(key, value);
+    node->left = node->right = node->parent = nullptr;
+    node->size = 1;
+    // xorshift32
+    seed_ ^= seed_ << 13;
+    seed_ ^= seed_ >> 17;
+    seed_ ^= seed_ << 5;
+    node->priority = seed_;
+    index_.insert({key, node});
+    return node;
+  }
+
+  void setRoot(IndexedListNodeBase* root)
+  {
+    root_ = root;
+    if (root_) {
+      root_->parent = nullptr;
+    }
+  }
+
+  // Inserts the detached |node| to the position |pos|.
+  void insertNode(size_t pos, IndexedListNodeBase* node)
+  {
+    IndexedListNodeBase *a, *b;
+    indexed_list::split(root_, pos, a, b);
+    setRoot(indexed_list::merge(indexed_list::merge(a, node), b));
+  }
+
+  // Detaches |node| from the tree.  The node is not deleted.
+  void unlink(IndexedListNodeBase* node)
+  {
+    auto parent = node->parent;
+    auto child = indexed_list::merge(node->left, node->right);
+    if (child) {
+      child->parent = parent;
+    }
+    if (!parent) {
+      root_ = child;
+    }
+    else {
+      if (parent->left == node) {
+        parent->left = child;
+      }
+      else {
+        parent->right = child;
+      }
+      for (; parent; parent = parent->parent) {
+        --parent->size;
+      }
+    }
+    node->left = node->right = node->parent = nullptr;
+    node->size = 1;
+  }
+
+  IndexedListNodeBase* root_;
   IndexType index_;
+  uint32_t seed_;
 };
 
 } // namespace aria2
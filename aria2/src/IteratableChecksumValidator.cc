@@ -46,6 +46,7 @@
 #include "BitfieldMan.h"
 #include "DownloadContext.h"
 #include "LogFactory.h"
+#include "IncrementalChecksum.h"
 #include "fmt.h"
 
 namespace aria2 {
@@ -102,8 +103,18 @@ int64_t IteratableChecksumValidator::getTotalLength() const
 
 void IteratableChecksumValidator::init()
 {
-  currentOffset_ = 0;
-  ctx_ = MessageDigest::create(dctx_->getHashType());
+  auto checksum = dctx_->getIncrementalChecksum();
+  if (checksum && checksum->getOffset() > 0) {
+    // The start of the file was hashed while it was downloaded.
+    currentOffset_ = checksum->getOffset();
+    ctx_ = checksum->popContext();
+    A2_LOG_INFO(fmt("Verifying checksum from offset %" PRId64,
+                    currentOffset_));
+  }
+  else {
+    currentOffset_ = 0;
+    ctx_ = MessageDigest::create(dctx_->getHashType());
+  }
 }
 
 } // namespace aria2
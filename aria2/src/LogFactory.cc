@@ -49,9 +49,19 @@ bool LogFactory::consoleOutput_ = true;
 Logger::LEVEL LogFactory::logLevel_ = Logger::A2_DEBUG;
 Logger::LEVEL LogFactory::consoleLogLevel_ = Logger::A2_NOTICE;
 bool LogFactory::colorOutput_ = true;
+bool LogFactory::async_ = false;
+bool LogFactory::asyncDrop_ = false;
+int64_t LogFactory::logMaxSize_ = 0;
+
+namespace {
+// The number of log records the asynchronous log queue can hold.
+constexpr size_t ASYNC_LOG_QUEUE_CAPACITY = 16384;
+} // namespace
 
 void LogFactory::openLogger(const std::shared_ptr<Logger>& logger)
 {
+  logger->setAsync(async_ ? ASYNC_LOG_QUEUE_CAPACITY : 0, asyncDrop_,
+                   logMaxSize_);
   if (filename_ != DEV_NULL) {
     // don't open file DEV_NULL for performance sake.
     // This avoids costly unnecessary message formatting and write.
@@ -167,6 +177,11 @@ void LogFactory::setConsoleLogLevel(const std::string& level)
 
 void LogFactory::setColorOutput(bool enabled) { colorOutput_ = enabled; }
 
+void LogFactory::setAsyncOverflowPolicy(const std::string& policy)
+{
+  asyncDrop_ = policy == V_DROP;
+}
+
 void LogFactory::release() { logger_.reset(); }
 
 } // namespace aria2
@@ -52,6 +52,9 @@ private:
   static Logger::LEVEL logLevel_;
   static Logger::LEVEL consoleLogLevel_;
   static bool colorOutput_;
+  static bool async_;
+  static bool asyncDrop_;
+  static int64_t logMaxSize_;
 
   static void openLogger(const std::shared_ptr<Logger>& logger);
 
@@ -106,6 +109,24 @@ public:
    */
   static void setColorOutput(bool enabled);
 
+  /**
+   * Write the file log from a background thread if |enabled| is
+   * true.  The change takes effect in next reconfigure() call.
+   */
+  static void setAsync(bool enabled) { async_ = enabled; }
+
+  /**
+   * Set overflow policy of the asynchronous log queue by string
+   * representation.  Possible values are: block, drop
+   */
+  static void setAsyncOverflowPolicy(const std::string& policy);
+
+  /**
+   * Rotate the log file when its size exceeds |size| bytes.  0
+   * disables rotation.  Only effective with asynchronous logging.
+   */
+  static void setLogMaxSize(int64_t size) { logMaxSize_ = size; }
+
   /**
    * Releases used resources
    */
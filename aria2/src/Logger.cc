@@ -47,6 +47,8 @@
 #include "BufferedFile.h"
 #include "util.h"
 #include "console.h"
+#include "AsyncLogWriter.h"
+#include "a2functional.h"
 
 namespace aria2 {
 
@@ -54,7 +56,10 @@ Logger::Logger()
     : logLevel_(Logger::A2_DEBUG),
       consoleLogLevel_(Logger::A2_NOTICE),
       consoleOutput_(true),
-      colorOutput_(global::cout()->supportsColor())
+      colorOutput_(global::cout()->supportsColor()),
+      asyncCapacity_(0),
+      asyncDrop_(false),
+      maxFileSize_(0)
 {
 }
 
@@ -66,6 +71,13 @@ void Logger::openFile(const std::string& filename)
   if (filename == DEV_STDOUT) {
     fpp_ = global::cout();
   }
+  else if (asyncCapacity_ > 0) {
+    asyncWriter_ = make_unique<AsyncLogWriter>(
+        filename, asyncCapacity_,
+        asyncDrop_ ? AsyncLogWriter::OVERFLOW_DROP
+                   : AsyncLogWriter::OVERFLOW_BLOCK,
+        maxFileSize_);
+  }
   else {
     fpp_ =
         std::make_shared<BufferedFile>(filename.c_str(), BufferedFile::APPEND);
@@ -80,13 +92,32 @@ void Logger::closeFile()
   if (fpp_) {
     fpp_.reset();
   }
+  // The destructor writes all queued records.
+  asyncWriter_.reset();
+}
+
+void Logger::setAsync(size_t capacity, bool drop, int64_t maxFileSize)
+{
+  asyncCapacity_ = capacity;
+  asyncDrop_ = drop;
+  maxFileSize_ = maxFileSize;
+}
+
+void Logger::flush()
+{
+  if (asyncWriter_) {
+    asyncWriter_->flush();
+  }
 }
 
 void Logger::setConsoleOutput(bool enabled) { consoleOutput_ = enabled; }
 
 void Logger::setColorOutput(bool enabled) { colorOutput_ = enabled; }
 
-bool Logger::fileLogEnabled(LEVEL level) { return level >= logLevel_ && fpp_; }
+bool Logger::fileLogEnabled(LEVEL level)
+{
+  return level >= logLevel_ && (fpp_ || asyncWriter_);
+}
 
 bool Logger::consoleLogEnabled(LEVEL level)
 {
@@ -193,10 +224,20 @@ void Logger::writeLog(Logger::LEVEL level, const char* sourceFile, int lineNum,
                       const char* msg, const char* trace)
 {
   if (fileLogEnabled(level)) {
-    writeHeader(*fpp_, level, sourceFile, lineNum);
-    fpp_->printf("%s\n", msg);
-    writeStackTrace(*fpp_, trace);
-    fpp_->flush();
+    if (asyncWriter_) {
+      // Only the time stamp is taken here.  The header is formatted
+      // by the writer thread.
+      struct timeval tv;
+      gettimeofday(&tv, nullptr);
+      asyncWriter_->push(tv, levelToString(level), sourceFile, lineNum, msg,
+                         trace);
+    }
+    else {
+      writeHeader(*fpp_, level, sourceFile, lineNum);
+      fpp_->printf("%s\n", msg);
+      writeStackTrace(*fpp_, trace);
+      fpp_->flush();
+    }
   }
   if (consoleLogEnabled(level)) {
     global::cout()->printf("\n");
@@ -44,6 +44,7 @@ namespace aria2 {
 
 class Exception;
 class OutputFile;
+class AsyncLogWriter;
 
 class Logger {
 public:
@@ -64,6 +65,17 @@ private:
   // true if console log output is enabled.
   bool consoleOutput_;
   bool colorOutput_;
+  // The number of records the asynchronous log queue can hold. 0
+  // disables asynchronous logging.
+  size_t asyncCapacity_;
+  // true if records are dropped when the asynchronous log queue is
+  // full.
+  bool asyncDrop_;
+  // Rotate the log file when it exceeds this size. 0 means no
+  // rotation.
+  int64_t maxFileSize_;
+  // Non-null if the file log is written by background thread.
+  std::unique_ptr<AsyncLogWriter> asyncWriter_;
   // Don't allow copying
   Logger(const Logger&);
   Logger& operator=(const Logger&);
@@ -106,6 +118,17 @@ public:
 
   void setColorOutput(bool enabled);
 
+  // Writes the file log from a background thread with a queue of
+  // |capacity| records.  If |drop| is true, records are discarded
+  // when the queue is full, instead of waiting for the writer.  If
+  // |maxFileSize| is positive, the log file is rotated when its size
+  // exceeds it.  Pass 0 to |capacity| to disable.  Takes effect in
+  // next openFile() call.
+  void setAsync(size_t capacity, bool drop, int64_t maxFileSize);
+
+  // Waits until all queued log records are written to the file.
+  void flush();
+
   // Returns true if this logger actually writes debug log message to
   // either file or stdout.
   bool levelEnabled(LEVEL level);
@@ -0,0 +1,226 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "Metrics.h"
+
+#include <cassert>
+#include <cmath>
+
+#include "a2functional.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+Metric::Metric(Type type, std::string name, std::string help)
+    : type_(type), name_(std::move(name)), help_(std::move(help))
+{
+}
+
+Counter::Counter(std::string name, std::string help)
+    : Metric(COUNTER, std::move(name), std::move(help))
+{
+}
+
+size_t Counter::nextShardIndex()
+{
+  static std::atomic<size_t> nextIndex(0);
+  return nextIndex.fetch_add(1, std::memory_order_relaxed) % NUM_SHARDS;
+}
+
+uint64_t Counter::get() const
+{
+  uint64_t res = 0;
+  for (auto& shard : shards_) {
+    res += shard.value.load(std::memory_order_relaxed);
+  }
+  return res;
+}
+
+Gauge::Gauge(std::string name, std::string help)
+    : Metric(GAUGE, std::move(name), std::move(help)), value_(0)
+{
+}
+
+Histogram::Histogram(std::string name, std::string help, double scale)
+    : Metric(HISTOGRAM, std::move(name), std::move(help)),
+      scale_(scale),
+      sum_(0),
+      max_(0)
+{
+  for (auto& b : buckets_) {
+    b.store(0, std::memory_order_relaxed);
+  }
+}
+
+// Inverse of bucketIndex(): values less than SUB_BUCKETS have their
+// own bucket, and then each power of 2 is split into SUB_BUCKETS.
+uint64_t Histogram::bucketUpperBound(size_t index)
+{
+  if (index < SUB_BUCKETS) {
+    return index;
+  }
+  auto shift = (index - SUB_BUCKETS) / SUB_BUCKETS;
+  auto sub = (index - SUB_BUCKETS) % SUB_BUCKETS;
+  auto lower = static_cast<uint64_t>(SUB_BUCKETS + sub) << shift;
+  return lower + ((static_cast<uint64_t>(1) << shift) - 1);
+}
+
+uint64_t Histogram::getCount() const
+{
+  uint64_t res = 0;
+  for (auto& b : buckets_) {
+    res += b.load(std::memory_order_relaxed);
+  }
+  return res;
+}
+
+uint64_t Histogram::getQuantile(double q) const
+{
+  auto count = getCount();
+  if (count == 0) {
+    return 0;
+  }
+  auto rank = static_cast<uint64_t>(std::ceil(q * count));
+  if (rank == 0) {
+    rank = 1;
+  }
+  uint64_t seen = 0;
+  auto max = getMax();
+  for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+    seen += buckets_[i].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      return std::min(bucketUpperBound(i), max);
+    }
+  }
+  // A concurrent record() may make us fall through.
+  return max;
+}
+
+Metric* MetricsRegistry::find(const std::string& name) const
+{
+  for (auto& m : metrics_) {
+    if (m->getName() == name) {
+      return m.get();
+    }
+  }
+  return nullptr;
+}
+
+Counter* MetricsRegistry::counter(const std::string& name,
+                                  const std::string& help)
+{
+  auto m = find(name);
+  if (m) {
+    assert(m->getType() == Metric::COUNTER);
+    return static_cast<Counter*>(m);
+  }
+  auto c = make_unique<Counter>(name, help);
+  auto res = c.get();
+  metrics_.push_back(std::move(c));
+  return res;
+}
+
+Gauge* MetricsRegistry::gauge(const std::string& name, const std::string& help)
+{
+  auto m = find(name);
+  if (m) {
+    assert(m->getType() == Metric::GAUGE);
+    return static_cast<Gauge*>(m);
+  }
+  auto g = make_unique<Gauge>(name, help);
+  auto res = g.get();
+  metrics_.push_back(std::move(g));
+  return res;
+}
+
+Histogram* MetricsRegistry::histogram(const std::string& name,
+                                      const std::string& help, double scale)
+{
+  auto m = find(name);
+  if (m) {
+    assert(m->getType() == Metric::HISTOGRAM);
+    return static_cast<Histogram*>(m);
+  }
+  auto h = make_unique<Histogram>(name, help, scale);
+  auto res = h.get();
+  metrics_.push_back(std::move(h));
+  return res;
+}
+
+namespace {
+const double QUANTILES[] = {0.5, 0.9, 0.99, 1.0};
+} // namespace
+
+std::string MetricsRegistry::toPrometheusText() const
+{
+  std::string res;
+  for (auto& m : metrics_) {
+    res += fmt("# HELP %s %s\n", m->getName().c_str(), m->getHelp().c_str());
+    switch (m->getType()) {
+    case Metric::COUNTER:
+      res += fmt("# TYPE %s counter\n%s %" PRIu64 "\n", m->getName().c_str(),
+                 m->getName().c_str(), static_cast<Counter*>(m.get())->get());
+      break;
+    case Metric::GAUGE:
+      res += fmt("# TYPE %s gauge\n%s %" PRId64 "\n", m->getName().c_str(),
+                 m->getName().c_str(), static_cast<Gauge*>(m.get())->get());
+      break;
+    case Metric::HISTOGRAM: {
+      auto h = static_cast<Histogram*>(m.get());
+      auto& name = h->getName();
+      res += fmt("# TYPE %s summary\n", name.c_str());
+      for (auto q : QUANTILES) {
+        res += fmt("%s{quantile=\"%g\"} %.9g\n", name.c_str(), q,
+                   h->getQuantile(q) * h->getScale());
+      }
+      res += fmt("%s_sum %.9g\n%s_count %" PRIu64 "\n", name.c_str(),
+                 h->getSum() * h->getScale(), name.c_str(), h->getCount());
+      break;
+    }
+    }
+  }
+  return res;
+}
+
+namespace global {
+
+MetricsRegistry& metrics()
+{
+  static auto r = new MetricsRegistry();
+  return *r;
+}
+
+} // namespace global
+
+} // namespace aria2
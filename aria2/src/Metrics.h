@@ -0,0 +1,236 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2010 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_METRICS_H
+#define D_METRICS_H
+
+#include "common.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <chrono>
+
+namespace aria2 {
+
+class Metric {
+public:
+  enum Type { COUNTER, GAUGE, HISTOGRAM };
+
+  Metric(Type type, std::string name, std::string help);
+  virtual ~Metric() = default;
+
+  Type getType() const { return type_; }
+  const std::string& getName() const { return name_; }
+  const std::string& getHelp() const { return help_; }
+
+private:
+  Type type_;
+  std::string name_;
+  std::string help_;
+};
+
+// Monotonically increasing counter.  Each thread adds to its own
+// cache line sized shard, so that increments from different threads
+// do not contend.  get() sums up all shards.
+class Counter : public Metric {
+public:
+  Counter(std::string name, std::string help);
+
+  void add(uint64_t n)
+  {
+    shards_[shardIndex()].value.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  void inc() { add(1); }
+
+  uint64_t get() const;
+
+  static const size_t NUM_SHARDS = 8;
+
+private:
+  struct Shard {
+    Shard() : value(0) {}
+    std::atomic<uint64_t> value;
+    // Keep each shard in its own cache line.
+    char padding[64 - sizeof(std::atomic<uint64_t>)];
+  };
+
+  static size_t shardIndex()
+  {
+    static thread_local size_t index = nextShardIndex();
+    return index;
+  }
+
+  static size_t nextShardIndex();
+
+  Shard shards_[NUM_SHARDS];
+};
+
+// Value which goes up and down, such as queue length.
+class Gauge : public Metric {
+public:
+  Gauge(std::string name, std::string help);
+
+  void set(int64_t v) { value_.store(v, std::memory_order_relaxed); }
+
+  void add(int64_t v) { value_.fetch_add(v, std::memory_order_relaxed); }
+
+  int64_t get() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<int64_t> value_;
+};
+
+// Histogram of non-negative integer values with HDR-style log-linear
+// buckets: each power of 2 is divided into SUB_BUCKETS buckets, so
+// the relative error of a reported quantile is at most
+// 1/SUB_BUCKETS.  Recording a value is O(1) and lock-free.  Values
+// are multiplied by |scale| when exported, so that, for example,
+// latencies can be recorded in microseconds and exported in seconds.
+class Histogram : public Metric {
+public:
+  Histogram(std::string name, std::string help, double scale);
+
+  void record(uint64_t v)
+  {
+    buckets_[bucketIndex(v)].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(v, std::memory_order_relaxed);
+    auto max = max_.load(std::memory_order_relaxed);
+    while (v > max &&
+           !max_.compare_exchange_weak(max, v, std::memory_order_relaxed))
+      ;
+  }
+
+  // Records the elapsed time since |start| in microseconds.
+  void recordSince(std::chrono::steady_clock::time_point start)
+  {
+    record(std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now() - start)
+               .count());
+  }
+
+  // Returns the number of recorded values.  This sums up all buckets
+  // so that record() does not have to update yet another atomic.
+  uint64_t getCount() const;
+
+  uint64_t getSum() const { return sum_.load(std::memory_order_relaxed); }
+
+  uint64_t getMax() const { return max_.load(std::memory_order_relaxed); }
+
+  // Returns the value at quantile |q| (0 <= q <= 1), which is the
+  // highest value equivalent to the bucket the quantile falls in,
+  // capped by the maximum recorded value.  Returns 0 if nothing has
+  // been recorded.
+  uint64_t getQuantile(double q) const;
+
+  double getScale() const { return scale_; }
+
+  static const size_t SUB_BUCKET_BITS = 3;
+  static const size_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+  static const size_t NUM_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+  static size_t bucketIndex(uint64_t v)
+  {
+    if (v < SUB_BUCKETS) {
+      return v;
+    }
+    auto e = log2floor(v);
+    auto sub = (v >> (e - SUB_BUCKET_BITS)) - SUB_BUCKETS;
+    return SUB_BUCKETS + (e - SUB_BUCKET_BITS) * SUB_BUCKETS + sub;
+  }
+
+  // Returns the highest value which falls in the bucket |index|.
+  static uint64_t bucketUpperBound(size_t index);
+
+private:
+  static int log2floor(uint64_t v)
+  {
+#ifdef __GNUC__
+    return 63 - __builtin_clzll(v);
+#else  // !__GNUC__
+    int res = 0;
+    while (v >>= 1) {
+      ++res;
+    }
+    return res;
+#endif // !__GNUC__
+  }
+
+  double scale_;
+  std::atomic<uint64_t> sum_;
+  std::atomic<uint64_t> max_;
+  std::atomic<uint64_t> buckets_[NUM_BUCKETS];
+};
+
+// Registry of all metrics in the process.  Metrics are created on
+// first request and live until the program exits, so components can
+// keep the returned pointers.  Requesting an existing name returns
+// the same object.  Registration is expected to be done by the
+// thread running DownloadEngine; updating metrics is thread-safe.
+class MetricsRegistry {
+public:
+  Counter* counter(const std::string& name, const std::string& help);
+
+  Gauge* gauge(const std::string& name, const std::string& help);
+
+  Histogram* histogram(const std::string& name, const std::string& help,
+                       double scale = 1.0);
+
+  const std::vector<std::unique_ptr<Metric>>& getMetrics() const
+  {
+    return metrics_;
+  }
+
+  // Returns all metrics in Prometheus text exposition format.
+  // Histograms are exported as summaries with 0.5, 0.9, 0.99 and 1
+  // quantiles.
+  std::string toPrometheusText() const;
+
+private:
+  Metric* find(const std::string& name) const;
+
+  std::vector<std::unique_ptr<Metric>> metrics_;
+};
+
+namespace global {
+
+MetricsRegistry& metrics();
+
+} // namespace global
+
+} // namespace aria2
+
+#endif // D_METRICS_H
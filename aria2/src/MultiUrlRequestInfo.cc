@@ -284,6 +284,10 @@ int MultiUrlRequestInfo::prepare()
       e_->getRequestGroupMan()->removeStaleServerStat(
           std::chrono::seconds(option_->getAsInt(PREF_SERVER_STAT_TIMEOUT)));
     }
+    const std::string& pieceHashIndex = option_->get(PREF_PIECE_HASH_INDEX);
+    if (!pieceHashIndex.empty()) {
+      e_->getRequestGroupMan()->loadPieceHashIndex(pieceHashIndex);
+    }
     e_->setStatCalc(getStatCalc(option_));
     if (uriListParser_) {
       e_->getRequestGroupMan()->setUriListParser(uriListParser_);
@@ -315,6 +319,10 @@ error_code::Value MultiUrlRequestInfo::getResult()
   if (!serverStatOf.empty()) {
     e_->getRequestGroupMan()->saveServerStat(serverStatOf);
   }
+  const std::string& pieceHashIndex = option_->get(PREF_PIECE_HASH_INDEX);
+  if (!pieceHashIndex.empty()) {
+    e_->getRequestGroupMan()->savePieceHashIndex(pieceHashIndex);
+  }
   if (!option_->getAsBool(PREF_QUIET) &&
       option_->get(PREF_DOWNLOAD_RESULT) != A2_V_HIDE) {
     e_->getRequestGroupMan()->showDownloadResults(
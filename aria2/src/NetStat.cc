@@ -38,7 +38,8 @@
 namespace aria2 {
 
 NetStat::NetStat()
-    : status_(NetStat::IDLE),
+    : downloadStartTime_(global::wallclock()),
+      status_(NetStat::IDLE),
       avgDownloadSpeed_(0),
       avgUploadSpeed_(0),
       sessionDownloadLength_(0),
@@ -190,7 +190,7 @@ const std::shared_ptr<Option>& Option::getParent() const { return parent_; }
 bool Option::emptyLocal() const
 {
   size_t dst;
-  return !bitfield::getFirstSetBitIndex(dst, use_, use_.size() * 8);
+  return !bitfield::getFirstSetBitIndex(dst, use_.data(), use_.size() * 8);
 }
 
 } // namespace aria2
@@ -429,6 +429,25 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->setChangeGlobalOption(true);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new BooleanOptionHandler(
+        PREF_LOG_ASYNC, TEXT_LOG_ASYNC, A2_V_FALSE, OptionHandler::OPT_ARG));
+    op->addTag(TAG_ADVANCED);
+    handlers.push_back(op);
+  }
+  {
+    OptionHandler* op(new ParameterOptionHandler(
+        PREF_LOG_ASYNC_OVERFLOW, TEXT_LOG_ASYNC_OVERFLOW, V_BLOCK,
+        {V_BLOCK, V_DROP}));
+    op->addTag(TAG_ADVANCED);
+    handlers.push_back(op);
+  }
+  {
+    OptionHandler* op(new UnitNumberOptionHandler(
+        PREF_LOG_MAX_SIZE, TEXT_LOG_MAX_SIZE, "0", 0));
+    op->addTag(TAG_ADVANCED);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(new NumberOptionHandler(PREF_MAX_CONCURRENT_DOWNLOADS,
                                               TEXT_MAX_CONCURRENT_DOWNLOADS,
@@ -778,6 +797,12 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->addTag(TAG_RPC);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new UnitNumberOptionHandler(
+        PREF_RPC_MAX_SEND_QUEUE_SIZE, TEXT_RPC_MAX_SEND_QUEUE_SIZE, "8M", 0));
+    op->addTag(TAG_RPC);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(new LocalFilePathOptionHandler(
         PREF_RPC_PRIVATE_KEY, TEXT_RPC_PRIVATE_KEY, NO_DEFAULT_VALUE, false));
@@ -806,6 +831,13 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->addTag(TAG_RPC);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new ParameterOptionHandler(
+        PREF_RPC_SEND_QUEUE_OVERFLOW, TEXT_RPC_SEND_QUEUE_OVERFLOW, V_DROP,
+        {V_DROP, V_CLOSE}));
+    op->addTag(TAG_RPC);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(new DeprecatedOptionHandler(
         new DefaultOptionHandler(PREF_RPC_USER, TEXT_RPC_USER), nullptr, true,
@@ -913,6 +945,15 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->setChangeGlobalOption(true);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new LocalFilePathOptionHandler(
+        PREF_PIECE_HASH_INDEX, TEXT_PIECE_HASH_INDEX, NO_DEFAULT_VALUE,
+        /* acceptStdin = */ false, 0, /* mustExist = */ false));
+    op->addTag(TAG_ADVANCED);
+    op->addTag(TAG_BITTORRENT);
+    op->addTag(TAG_METALINK);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(new BooleanOptionHandler(PREF_REMOTE_TIME,
                                                TEXT_REMOTE_TIME, A2_V_FALSE,
@@ -944,6 +985,15 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->setChangeOptionForReserved(true);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new ParameterOptionHandler(PREF_SERVER_STAT_FORMAT,
+                                                 TEXT_SERVER_STAT_FORMAT,
+                                                 V_TEXT, {V_TEXT, V_BINARY}));
+    op->addTag(TAG_FTP);
+    op->addTag(TAG_HTTP);
+    op->setChangeGlobalOption(true);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(new LocalFilePathOptionHandler(
         PREF_SERVER_STAT_IF, TEXT_SERVER_STAT_IF, NO_DEFAULT_VALUE,
@@ -989,7 +1039,8 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
   {
     OptionHandler* op(new ParameterOptionHandler(
         PREF_STREAM_PIECE_SELECTOR, TEXT_STREAM_PIECE_SELECTOR, A2_V_DEFAULT,
-        {A2_V_DEFAULT, V_INORDER, A2_V_RANDOM, A2_V_GEOM}));
+        {A2_V_DEFAULT, V_INORDER, A2_V_RANDOM, A2_V_GEOM, A2_V_DEADLINE}));
+    op->addTag(TAG_BITTORRENT);
     op->addTag(TAG_FTP);
     op->addTag(TAG_HTTP);
     op->setInitialOption(true);
@@ -1246,6 +1297,16 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->setChangeOptionForReserved(true);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new BooleanOptionHandler(PREF_FTP_PIPELINING,
+                                               TEXT_FTP_PIPELINING, A2_V_FALSE,
+                                               OptionHandler::OPT_ARG));
+    op->addTag(TAG_FTP);
+    op->setInitialOption(true);
+    op->setChangeGlobalOption(true);
+    op->setChangeOptionForReserved(true);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(new BooleanOptionHandler(
         PREF_FTP_REUSE_CONNECTION, TEXT_FTP_REUSE_CONNECTION, A2_V_TRUE,
@@ -1284,6 +1345,16 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->setChangeOptionForReserved(true);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new UnitNumberOptionHandler(
+        PREF_SFTP_READ_AHEAD, TEXT_SFTP_READ_AHEAD, "0", 0, 64_m));
+    op->addTag(TAG_ADVANCED);
+    op->addTag(TAG_FTP);
+    op->setInitialOption(true);
+    op->setChangeGlobalOption(true);
+    op->setChangeOptionForReserved(true);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(new LocalFilePathOptionHandler(
         PREF_NETRC_PATH, TEXT_NETRC_PATH, util::getHomeDir() + "/.netrc",
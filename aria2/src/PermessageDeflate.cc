@@ -0,0 +1,242 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2013 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "PermessageDeflate.h"
+
+#include <array>
+#include <set>
+
+#include "A2STR.h"
+#include "fmt.h"
+#include "DlAbortEx.h"
+#include "util.h"
+
+namespace aria2 {
+
+namespace rpc {
+
+namespace {
+const char PERMESSAGE_DEFLATE[] = "permessage-deflate";
+} // namespace
+
+namespace {
+// Returns the window size in bits |value| denotes, or -1 if it is
+// invalid.  Quoted values are allowed.
+int32_t parseWindowBits(std::string value)
+{
+  if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+    value = value.substr(1, value.size() - 2);
+  }
+  int32_t bits;
+  if (value.size() <= 2 && util::isNumber(std::begin(value), std::end(value)) &&
+      util::parseIntNoThrow(bits, value) && 8 <= bits && bits <= 15) {
+    return bits;
+  }
+  return -1;
+}
+} // namespace
+
+namespace {
+// Returns true if we accept the permessage-deflate offer with the
+// parameters |params|.  |serverMaxWindowBits| is set to true if the
+// offer has the server_max_window_bits parameter, which the response
+// must then include (RFC 7692, section 7.1.2.1).
+bool acceptOffer(const std::vector<std::string>& params,
+                 bool& serverMaxWindowBits)
+{
+  serverMaxWindowBits = false;
+  std::set<std::string> seen;
+  for (auto& param : params) {
+    auto p = util::divide(std::begin(param), std::end(param), '=');
+    auto name = std::string(p.first.first, p.first.second);
+    auto value = std::string(p.second.first, p.second.second);
+    bool hasValue = param.find('=') != std::string::npos;
+    if (!seen.insert(name).second) {
+      return false;
+    }
+    if (name == "server_no_context_takeover" ||
+        name == "client_no_context_takeover") {
+      if (hasValue) {
+        return false;
+      }
+    }
+    else if (name == "server_max_window_bits") {
+      // We compress with the window of 15 bits only.
+      if (parseWindowBits(value) != 15) {
+        return false;
+      }
+      serverMaxWindowBits = true;
+    }
+    else if (name == "client_max_window_bits") {
+      // Our inflater accepts any window size.
+      if (hasValue && parseWindowBits(value) == -1) {
+        return false;
+      }
+    }
+    else {
+      return false;
+    }
+  }
+  return true;
+}
+} // namespace
+
+std::string negotiatePermessageDeflate(const std::vector<std::string>& offers)
+{
+  for (auto& offer : offers) {
+    std::vector<std::string> extensions;
+    util::split(std::begin(offer), std::end(offer),
+                std::back_inserter(extensions), ',', true);
+    for (auto& extension : extensions) {
+      std::vector<std::string> params;
+      util::split(std::begin(extension), std::end(extension),
+                  std::back_inserter(params), ';', true);
+      if (params.empty() || !util::strieq(params[0], PERMESSAGE_DEFLATE)) {
+        continue;
+      }
+      params.erase(std::begin(params));
+      bool serverMaxWindowBits;
+      if (acceptOffer(params, serverMaxWindowBits)) {
+        return fmt("%s; server_no_context_takeover%s", PERMESSAGE_DEFLATE,
+                   serverMaxWindowBits ? "; server_max_window_bits=15" : "");
+      }
+    }
+  }
+  return A2STR::NIL;
+}
+
+namespace {
+// The tail which the deflater leaves at the end of each message, and
+// the sender removes.
+const unsigned char MESSAGE_TAIL[] = {0x00, 0x00, 0xff, 0xff};
+} // namespace
+
+PermessageDeflater::PermessageDeflater() : strm_{}
+{
+  if (Z_OK != deflateInit2(&strm_, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8,
+                           Z_DEFAULT_STRATEGY)) {
+    throw DL_ABORT_EX("Initializing z_stream failed.");
+  }
+}
+
+PermessageDeflater::~PermessageDeflater() { deflateEnd(&strm_); }
+
+std::string PermessageDeflater::deflate(const std::string& msg)
+{
+  deflateReset(&strm_);
+  std::string out;
+  out.resize(deflateBound(&strm_, msg.size()) + 16);
+  strm_.next_in =
+      reinterpret_cast<unsigned char*>(const_cast<char*>(msg.data()));
+  strm_.avail_in = msg.size();
+  size_t produced = 0;
+  while (1) {
+    strm_.next_out = reinterpret_cast<unsigned char*>(&out[produced]);
+    strm_.avail_out = out.size() - produced;
+    int ret = ::deflate(&strm_, Z_SYNC_FLUSH);
+    if (ret == Z_STREAM_ERROR) {
+      throw DL_ABORT_EX(fmt("libz::deflate() failed. cause:%s", strm_.msg));
+    }
+    produced = out.size() - strm_.avail_out;
+    if (strm_.avail_out > 0) {
+      break;
+    }
+    out.resize(out.size() * 2);
+  }
+  out.resize(produced);
+  if (out.size() >= sizeof(MESSAGE_TAIL) &&
+      out.compare(out.size() - sizeof(MESSAGE_TAIL), sizeof(MESSAGE_TAIL),
+                  reinterpret_cast<const char*>(MESSAGE_TAIL),
+                  sizeof(MESSAGE_TAIL)) == 0) {
+    out.resize(out.size() - sizeof(MESSAGE_TAIL));
+  }
+  return out;
+}
+
+PermessageInflater::PermessageInflater() : strm_{}, streamEnded_(false)
+{
+  if (Z_OK != inflateInit2(&strm_, -15)) {
+    throw DL_ABORT_EX("Initializing z_stream failed.");
+  }
+}
+
+PermessageInflater::~PermessageInflater() { inflateEnd(&strm_); }
+
+bool PermessageInflater::inflate(std::string& out, const unsigned char* in,
+                                 size_t len, size_t maxLength)
+{
+  if (streamEnded_) {
+    // Ignore the padding after the final block.
+    return true;
+  }
+  strm_.next_in = const_cast<unsigned char*>(in);
+  strm_.avail_in = len;
+  std::array<unsigned char, 16_k> outbuf;
+  while (1) {
+    strm_.next_out = outbuf.data();
+    strm_.avail_out = outbuf.size();
+    int ret = ::inflate(&strm_, Z_SYNC_FLUSH);
+    if (ret != Z_OK && ret != Z_BUF_ERROR && ret != Z_STREAM_END) {
+      return false;
+    }
+    size_t produced = outbuf.size() - strm_.avail_out;
+    if (out.size() + produced > maxLength) {
+      return false;
+    }
+    out.append(outbuf.data(), outbuf.data() + produced);
+    if (ret == Z_STREAM_END) {
+      // The client ended the message with the final block.  The next
+      // message starts a new stream.
+      inflateReset(&strm_);
+      streamEnded_ = true;
+      return true;
+    }
+    if (strm_.avail_out > 0) {
+      return true;
+    }
+  }
+}
+
+bool PermessageInflater::finish(std::string& out, size_t maxLength)
+{
+  if (streamEnded_) {
+    streamEnded_ = false;
+    return true;
+  }
+  return inflate(out, MESSAGE_TAIL, sizeof(MESSAGE_TAIL), maxLength);
+}
+
+} // namespace rpc
+
+} // namespace aria2
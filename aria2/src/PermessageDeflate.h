@@ -0,0 +1,106 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2013 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_PERMESSAGE_DEFLATE_H
+#define D_PERMESSAGE_DEFLATE_H
+
+#include "common.h"
+
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+namespace aria2 {
+
+namespace rpc {
+
+// Returns the value of the Sec-WebSocket-Extensions response header
+// field which accepts the first acceptable permessage-deflate (RFC
+// 7692) offer in |offers|, the values of the Sec-WebSocket-Extensions
+// request header fields.  Returns an empty string if there is no such
+// offer.
+//
+// The server never takes over the compression context, so that a
+// compressed message can be sent to any session.  The offers which
+// limit the window of the server are declined for the same reason.
+std::string negotiatePermessageDeflate(const std::vector<std::string>& offers);
+
+// Compresses the messages sent with permessage-deflate.  The context
+// is reset for each message.
+class PermessageDeflater {
+public:
+  PermessageDeflater();
+
+  ~PermessageDeflater();
+
+  // Returns the payload of the compressed message of |msg|, which is
+  // sent with RSV1 set.
+  std::string deflate(const std::string& msg);
+
+private:
+  z_stream strm_;
+};
+
+// Decompresses the messages received with permessage-deflate.  The
+// context is kept across messages, since the client may take it over.
+class PermessageInflater {
+public:
+  PermessageInflater();
+
+  ~PermessageInflater();
+
+  // Decompresses |len| bytes of the payload of a compressed message
+  // from |in| and appends the result to |out|.  Returns false if the
+  // data is corrupted, or the result would make |out| longer than
+  // |maxLength| bytes.
+  bool inflate(std::string& out, const unsigned char* in, size_t len,
+               size_t maxLength);
+
+  // Decompresses the rest of the message after its payload is fed by
+  // inflate().  The return value is the same as inflate().
+  bool finish(std::string& out, size_t maxLength);
+
+private:
+  z_stream strm_;
+  // True if the message being received ended the deflate stream with
+  // a final block.
+  bool streamEnded_;
+};
+
+} // namespace rpc
+
+} // namespace aria2
+
+#endif // D_PERMESSAGE_DEFLATE_H
@@ -255,23 +255,29 @@ Piece::getDigestWithWrCache(size_t pieceLength,
                             const std::shared_ptr<DiskAdaptor>& adaptor)
 {
   auto mdctx = MessageDigest::create(hashType_);
+  updateHashWithWrCache(mdctx.get(), pieceLength, adaptor);
+  return mdctx->digest();
+}
+
+void Piece::updateHashWithWrCache(MessageDigest* mdctx, size_t pieceLength,
+                                  const std::shared_ptr<DiskAdaptor>& adaptor)
+{
   int64_t start = static_cast<int64_t>(index_) * pieceLength;
   int64_t goff = start;
   if (wrCache_) {
     const WrDiskCacheEntry::DataCellSet& dataSet = wrCache_->getDataSet();
     for (auto& d : dataSet) {
       if (goff < d->goff) {
-        updateHashWithRead(mdctx.get(), adaptor, goff, d->goff - goff);
+        updateHashWithRead(mdctx, adaptor, goff, d->goff - goff);
       }
       mdctx->update(d->data + d->offset, d->len);
       goff = d->goff + d->len;
     }
-    updateHashWithRead(mdctx.get(), adaptor, goff, start + length_ - goff);
+    updateHashWithRead(mdctx, adaptor, goff, start + length_ - goff);
   }
   else {
-    updateHashWithRead(mdctx.get(), adaptor, goff, length_);
+    updateHashWithRead(mdctx, adaptor, goff, length_);
   }
-  return mdctx->digest();
 }
 
 void Piece::destroyHashContext()
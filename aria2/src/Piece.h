@@ -162,6 +162,12 @@ public:
   // cached data and data on disk.
   std::string getDigestWithWrCache(size_t pieceLength,
                                    const std::shared_ptr<DiskAdaptor>& adaptor);
+
+  // Feeds the data of this piece to |mdctx| in the same way as
+  // getDigestWithWrCache().
+  void updateHashWithWrCache(MessageDigest* mdctx, size_t pieceLength,
+                             const std::shared_ptr<DiskAdaptor>& adaptor);
+
   /**
    * Loses current bitfield state.
    */
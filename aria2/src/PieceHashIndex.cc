@@ -0,0 +1,217 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2013 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "PieceHashIndex.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "DownloadContext.h"
+#include "FileEntry.h"
+#include "BufferedFile.h"
+#include "File.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "util.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+namespace {
+std::string makeKey(const std::string& hashType, const std::string& hexDigest,
+                    int64_t length)
+{
+  return fmt("%s %s %" PRId64, hashType.c_str(), hexDigest.c_str(), length);
+}
+} // namespace
+
+namespace {
+// The recorded paths outlive the current directory of this process.
+std::string toAbsolutePath(const std::string& path)
+{
+  if (!path.empty() && path[0] == '/') {
+    return path;
+  }
+  return util::applyDir(File::getCurrentDir(), path);
+}
+} // namespace
+
+PieceHashIndex::PieceHashIndex() = default;
+
+PieceHashIndex::~PieceHashIndex() = default;
+
+void PieceHashIndex::add(const std::string& hashType,
+                         const std::string& digest, int64_t length,
+                         const std::string& path, int64_t offset)
+{
+  entries_[makeKey(hashType, util::toHex(digest), length)] =
+      Location{path, offset};
+}
+
+size_t PieceHashIndex::add(const DownloadContext& dctx)
+{
+  const auto& hashes = dctx.getPieceHashes();
+  if (dctx.getPieceHashType().empty() || hashes.empty() ||
+      hashes.size() != dctx.getNumPieces()) {
+    return 0;
+  }
+  size_t n = 0;
+  const auto& fileEntries = dctx.getFileEntries();
+  auto fe = std::begin(fileEntries);
+  for (size_t i = 0; i < hashes.size(); ++i) {
+    int64_t offset = static_cast<int64_t>(i) * dctx.getPieceLength();
+    int64_t length =
+        std::min(static_cast<int64_t>(dctx.getPieceLength()),
+                 dctx.getTotalLength() - offset);
+    for (; fe != std::end(fileEntries) &&
+           (*fe)->getOffset() + (*fe)->getLength() <= offset;
+         ++fe)
+      ;
+    if (fe == std::end(fileEntries)) {
+      break;
+    }
+    if (!(*fe)->isRequested() || (*fe)->getPath().empty() ||
+        offset + length > (*fe)->getOffset() + (*fe)->getLength()) {
+      continue;
+    }
+    add(dctx.getPieceHashType(), hashes[i], length,
+        toAbsolutePath((*fe)->getPath()), offset - (*fe)->getOffset());
+    ++n;
+  }
+  return n;
+}
+
+const PieceHashIndex::Location*
+PieceHashIndex::find(const std::string& hashType, const std::string& digest,
+                     int64_t length) const
+{
+  auto i = entries_.find(makeKey(hashType, util::toHex(digest), length));
+  if (i == std::end(entries_)) {
+    return nullptr;
+  }
+  return &(*i).second;
+}
+
+void PieceHashIndex::remove(const std::string& hashType,
+                            const std::string& digest, int64_t length)
+{
+  entries_.erase(makeKey(hashType, util::toHex(digest), length));
+}
+
+// The file has a line per entry:
+//
+//   <hash type> <hex digest> <length> <offset> <percent-encoded path>
+bool PieceHashIndex::load(const std::string& filename)
+{
+  BufferedFile fp(filename.c_str(), BufferedFile::READ);
+  if (!fp) {
+    A2_LOG_ERROR(fmt("Failed to open piece hash index %s for read.",
+                     filename.c_str()));
+    return false;
+  }
+  while (1) {
+    std::string line = fp.getLine();
+    if (line.empty()) {
+      if (fp.eof()) {
+        break;
+      }
+      else if (!fp) {
+        A2_LOG_ERROR(
+            fmt("Failed to read piece hash index %s.", filename.c_str()));
+        return false;
+      }
+      else {
+        continue;
+      }
+    }
+    std::vector<std::string> fields;
+    util::split(std::begin(line), std::end(line), std::back_inserter(fields),
+                ' ');
+    int64_t length, offset;
+    if (fields.size() != 5 || !util::isHexDigit(fields[1]) ||
+        !util::parseLLIntNoThrow(length, fields[2]) || length <= 0 ||
+        !util::parseLLIntNoThrow(offset, fields[3]) || offset < 0) {
+      continue;
+    }
+    util::lowercase(fields[1]);
+    entries_[makeKey(fields[0], fields[1], length)] =
+        Location{util::percentDecode(std::begin(fields[4]),
+                                     std::end(fields[4])),
+                 offset};
+  }
+  A2_LOG_NOTICE(fmt("Piece hash index %s loaded successfully.",
+                    filename.c_str()));
+  return true;
+}
+
+bool PieceHashIndex::save(const std::string& filename) const
+{
+  std::string tempfile = filename;
+  tempfile += "__temp";
+  {
+    BufferedFile fp(tempfile.c_str(), BufferedFile::WRITE);
+    if (!fp) {
+      A2_LOG_ERROR(fmt("Failed to open piece hash index %s for write.",
+                       filename.c_str()));
+      return false;
+    }
+    for (auto& e : entries_) {
+      std::string l =
+          fmt("%s %" PRId64 " %s\n", e.first.c_str(), e.second.offset,
+              util::percentEncode(e.second.path).c_str());
+      if (fp.write(l.data(), l.size()) != l.size()) {
+        A2_LOG_ERROR(
+            fmt("Failed to write piece hash index %s.", filename.c_str()));
+        return false;
+      }
+    }
+    if (fp.close() == EOF) {
+      A2_LOG_ERROR(
+          fmt("Failed to write piece hash index %s.", filename.c_str()));
+      return false;
+    }
+  }
+  if (File(tempfile).renameTo(filename)) {
+    A2_LOG_NOTICE(
+        fmt("Piece hash index %s saved successfully.", filename.c_str()));
+    return true;
+  }
+  else {
+    A2_LOG_ERROR(fmt("Failed to write piece hash index %s.", filename.c_str()));
+    return false;
+  }
+}
+
+} // namespace aria2
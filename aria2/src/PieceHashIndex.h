@@ -0,0 +1,97 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2013 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_PIECE_HASH_INDEX_H
+#define D_PIECE_HASH_INDEX_H
+
+#include "common.h"
+
+#include <map>
+#include <string>
+
+namespace aria2 {
+
+class DownloadContext;
+
+// Maps the hash type, the digest and the length of a piece to the
+// local file and the offset where the same data was downloaded
+// before, so that a download can copy the pieces it shares with
+// earlier downloads instead of fetching them.  The entries are only
+// hints: the data may have changed since it was recorded, and its
+// hash must be verified before use.
+class PieceHashIndex {
+public:
+  struct Location {
+    std::string path;
+    int64_t offset;
+  };
+
+  PieceHashIndex();
+
+  ~PieceHashIndex();
+
+  // Adds the location of the piece whose hash is |digest|, which is a
+  // raw digest of |hashType|.  The existing entry for the same piece
+  // is replaced.
+  void add(const std::string& hashType, const std::string& digest,
+           int64_t length, const std::string& path, int64_t offset);
+
+  // Adds the pieces of the completed download |dctx| which lie within
+  // a single requested file.  Returns the number of added pieces.
+  size_t add(const DownloadContext& dctx);
+
+  // Returns the location of the piece, or nullptr if it is not known.
+  const Location* find(const std::string& hashType, const std::string& digest,
+                       int64_t length) const;
+
+  void remove(const std::string& hashType, const std::string& digest,
+              int64_t length);
+
+  size_t size() const { return entries_.size(); }
+
+  // Loads the entries from |filename|.  Returns true if it succeeds.
+  bool load(const std::string& filename);
+
+  // Saves the entries to |filename|.  Returns true if it succeeds.
+  bool save(const std::string& filename) const;
+
+private:
+  // "<hash type> <hex digest> <length>", which is also the start of
+  // the line of the entry in the saved file.
+  std::map<std::string, Location> entries_;
+};
+
+} // namespace aria2
+
+#endif // D_PIECE_HASH_INDEX_H
@@ -0,0 +1,249 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2013 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "PieceReuseCommand.h"
+
+#include <array>
+#include <algorithm>
+
+#include "DownloadEngine.h"
+#include "RequestGroup.h"
+#include "RequestGroupMan.h"
+#include "DownloadContext.h"
+#include "PieceStorage.h"
+#include "Piece.h"
+#include "DiskAdaptor.h"
+#include "DefaultDiskWriter.h"
+#include "MessageDigest.h"
+#include "RecoverableException.h"
+#include "DlAbortEx.h"
+#include "GroupId.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include "message.h"
+#include "wallclock.h"
+#include "util.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+namespace {
+Counter* reusedBytesCounter()
+{
+  static auto c = global::metrics().counter(
+      "aria2_piece_reuse_bytes_total",
+      "Number of bytes copied from local files instead of being fetched.");
+  return c;
+}
+} // namespace
+
+namespace {
+Counter* reuseFailuresCounter()
+{
+  static auto c = global::metrics().counter(
+      "aria2_piece_reuse_failures_total",
+      "Number of pieces in the piece hash index which failed to be copied.");
+  return c;
+}
+} // namespace
+
+PieceReuseCommand::PieceReuseCommand(cuid_t cuid, RequestGroup* requestGroup,
+                                     DownloadEngine* e)
+    : RealtimeCommand{cuid, requestGroup, e},
+      index_{e->getRequestGroupMan()->getPieceHashIndex()},
+      initialized_{false},
+      numFound_{0},
+      numReused_{0},
+      reusedLength_{0}
+{
+}
+
+PieceReuseCommand::~PieceReuseCommand() { cancelPieces(); }
+
+bool PieceReuseCommand::executeInternal()
+{
+  if (getRequestGroup()->isHaltRequested() ||
+      getRequestGroup()->downloadFinished()) {
+    return true;
+  }
+  if (!initialized_) {
+    initialized_ = true;
+    checkOutPieces();
+  }
+  if (!pieces_.empty()) {
+    auto piece = pieces_.front().first;
+    auto location = std::move(pieces_.front().second);
+    pieces_.pop_front();
+    if (reusePiece(piece, location)) {
+      ++numReused_;
+      reusedLength_ += piece->getLength();
+      reusedBytesCounter()->add(piece->getLength());
+    }
+    else {
+      reuseFailuresCounter()->inc();
+    }
+  }
+  if (!pieces_.empty()) {
+    getDownloadEngine()->addCommand(std::unique_ptr<Command>(this));
+    return false;
+  }
+  if (numFound_ > 0) {
+    auto rg = getRequestGroup();
+    A2_LOG_NOTICE(fmt("GID#%s - Copied %" PRId64 " bytes in %lu piece(s)"
+                      " from local files, %" PRId64 " bytes left to fetch.",
+                      GroupId::toHex(rg->getGID()).c_str(), reusedLength_,
+                      static_cast<unsigned long>(numReused_),
+                      rg->getTotalLength() - rg->getCompletedLength()));
+  }
+  return true;
+}
+
+void PieceReuseCommand::checkOutPieces()
+{
+  const auto& dctx = getRequestGroup()->getDownloadContext();
+  const auto& hashType = dctx->getPieceHashType();
+  const auto& hashes = dctx->getPieceHashes();
+  if (!index_ || index_->size() == 0 || hashType.empty() ||
+      hashes.size() != dctx->getNumPieces() ||
+      !MessageDigest::supports(hashType)) {
+    return;
+  }
+  auto& ps = getRequestGroup()->getPieceStorage();
+  for (size_t i = 0; i < hashes.size(); ++i) {
+    if (ps->hasPiece(i) || ps->isPieceUsed(i)) {
+      continue;
+    }
+    int64_t offset = static_cast<int64_t>(i) * dctx->getPieceLength();
+    int64_t length = std::min(static_cast<int64_t>(dctx->getPieceLength()),
+                              dctx->getTotalLength() - offset);
+    auto location = index_->find(hashType, hashes[i], length);
+    if (!location) {
+      continue;
+    }
+    // Returns nullptr for the pieces of the files not selected.
+    auto piece = ps->getMissingPiece(i, getCuid());
+    if (piece) {
+      pieces_.emplace_back(piece, *location);
+    }
+  }
+  numFound_ = pieces_.size();
+  if (numFound_ > 0) {
+    ctx_ = MessageDigest::create(hashType);
+    A2_LOG_INFO(fmt("CUID#%" PRId64 " - %lu piece(s) found in piece hash"
+                    " index.",
+                    getCuid(), static_cast<unsigned long>(numFound_)));
+  }
+}
+
+bool PieceReuseCommand::reusePiece(const std::shared_ptr<Piece>& piece,
+                                   const PieceHashIndex::Location& location)
+{
+  const auto& dctx = getRequestGroup()->getDownloadContext();
+  auto& ps = getRequestGroup()->getPieceStorage();
+  size_t index = piece->getIndex();
+  int64_t offset = static_cast<int64_t>(index) * dctx->getPieceLength();
+  int64_t length = piece->getLength();
+  try {
+    if (!src_ || srcPath_ != location.path) {
+      src_ = make_unique<DefaultDiskWriter>(location.path);
+      srcPath_ = location.path;
+      src_->enableReadOnly();
+      src_->openExistingFile();
+    }
+    // The data is written before its hash is known.  If it does not
+    // match, the piece is cancelled and overwritten when fetched.
+    std::array<unsigned char, 16_k> buf;
+    ctx_->reset();
+    for (int64_t n = 0; n < length;) {
+      ssize_t r = src_->readData(
+          buf.data(), std::min(static_cast<int64_t>(buf.size()), length - n),
+          location.offset + n);
+      if (r <= 0) {
+        throw DL_ABORT_EX(
+            fmt(EX_FILE_READ, location.path.c_str(), "data is too short"));
+      }
+      ctx_->update(buf.data(), r);
+      ps->getDiskAdaptor()->writeData(buf.data(), r, offset + n);
+      n += r;
+    }
+    if (ctx_->digest() != dctx->getPieceHash(index)) {
+      A2_LOG_INFO(fmt("CUID#%" PRId64 " - Piece %lu in %s at %" PRId64
+                      " has changed since it was indexed.",
+                      getCuid(), static_cast<unsigned long>(index),
+                      location.path.c_str(), location.offset));
+      index_->remove(dctx->getPieceHashType(), dctx->getPieceHash(index),
+                     length);
+      ps->cancelPiece(piece, getCuid());
+      return false;
+    }
+  }
+  catch (RecoverableException& e) {
+    A2_LOG_INFO_EX(fmt("CUID#%" PRId64 " - Could not copy piece %lu from %s.",
+                       getCuid(), static_cast<unsigned long>(index),
+                       location.path.c_str()),
+                   e);
+    src_.reset();
+    index_->remove(dctx->getPieceHashType(), dctx->getPieceHash(index),
+                   length);
+    ps->cancelPiece(piece, getCuid());
+    return false;
+  }
+  ps->completePiece(piece);
+  ps->advertisePiece(getCuid(), index, global::wallclock());
+  return true;
+}
+
+void PieceReuseCommand::cancelPieces()
+{
+  auto& ps = getRequestGroup()->getPieceStorage();
+  if (ps) {
+    for (auto& e : pieces_) {
+      ps->cancelPiece(e.first, getCuid());
+    }
+  }
+  pieces_.clear();
+}
+
+bool PieceReuseCommand::handleException(Exception& e)
+{
+  A2_LOG_ERROR_EX(fmt("CUID#%" PRId64 " - Copying pieces from local files"
+                      " failed.",
+                      getCuid()),
+                  e);
+  cancelPieces();
+  return true;
+}
+
+} // namespace aria2
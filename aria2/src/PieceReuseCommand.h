@@ -0,0 +1,95 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2013 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_PIECE_REUSE_COMMAND_H
+#define D_PIECE_REUSE_COMMAND_H
+
+#include "RealtimeCommand.h"
+
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "PieceHashIndex.h"
+
+namespace aria2 {
+
+class Piece;
+class DiskWriter;
+class MessageDigest;
+
+// Copies the missing pieces of a download with piece hashes from the
+// local files which PieceHashIndex knows to have the same data.  The
+// pieces found in the index are checked out on the first execution,
+// so that the download commands running beside this command fetch
+// the others.  Then a piece is copied per execution, and completed if
+// its hash matches.  A piece whose copy fails is cancelled and
+// fetched as usual, and its stale entry is removed from the index.
+class PieceReuseCommand : public RealtimeCommand {
+public:
+  PieceReuseCommand(cuid_t cuid, RequestGroup* requestGroup,
+                    DownloadEngine* e);
+
+  virtual ~PieceReuseCommand();
+
+  virtual bool executeInternal() CXX11_OVERRIDE;
+
+  virtual bool handleException(Exception& e) CXX11_OVERRIDE;
+
+private:
+  void checkOutPieces();
+
+  // Returns true if the piece was copied and its hash matched.
+  bool reusePiece(const std::shared_ptr<Piece>& piece,
+                  const PieceHashIndex::Location& location);
+
+  void cancelPieces();
+
+  PieceHashIndex* index_;
+  std::deque<std::pair<std::shared_ptr<Piece>, PieceHashIndex::Location>>
+      pieces_;
+  std::unique_ptr<MessageDigest> ctx_;
+  // The file the last piece was copied from, kept open for the next
+  // piece from the same file.
+  std::unique_ptr<DiskWriter> src_;
+  std::string srcPath_;
+  bool initialized_;
+  size_t numFound_;
+  size_t numReused_;
+  int64_t reusedLength_;
+};
+
+} // namespace aria2
+
+#endif // D_PIECE_REUSE_COMMAND_H
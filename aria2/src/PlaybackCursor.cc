@@ -0,0 +1,101 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2013 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "PlaybackCursor.h"
+
+#include <algorithm>
+
+#include "wallclock.h"
+
+namespace aria2 {
+
+const int PlaybackCursor::URGENT_SEC;
+
+PlaybackCursor::PlaybackCursor()
+    : position_(0), bitrate_(0), updated_(global::wallclock())
+{
+}
+
+void PlaybackCursor::update(int64_t position, int64_t bitrate)
+{
+  position_ = position;
+  bitrate_ = bitrate;
+  updated_ = global::wallclock();
+}
+
+int64_t PlaybackCursor::getPosition() const
+{
+  if (bitrate_ == 0) {
+    return position_;
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     updated_.difference(global::wallclock()))
+                     .count();
+  return position_ + bitrate_ * elapsed / 1000;
+}
+
+std::chrono::milliseconds PlaybackCursor::getTimeLeft(int64_t offset) const
+{
+  if (bitrate_ == 0) {
+    return std::chrono::milliseconds::max();
+  }
+  return std::chrono::milliseconds((offset - getPosition()) * 1000 /
+                                   bitrate_);
+}
+
+int64_t PlaybackCursor::getUrgentEnd() const
+{
+  return getPosition() + std::max(static_cast<int64_t>(1),
+                                  bitrate_ * URGENT_SEC);
+}
+
+bool PlaybackCursor::canMeetDeadline(int64_t offset, int64_t length,
+                                     int speed) const
+{
+  if (bitrate_ == 0) {
+    return true;
+  }
+  if (speed <= 0) {
+    return false;
+  }
+  return std::chrono::milliseconds(length * 1000 / speed) <=
+         getTimeLeft(offset);
+}
+
+int64_t PlaybackCursor::getReachableOffset(int64_t length, int speed) const
+{
+  return getPosition() + length * bitrate_ / speed;
+}
+
+} // namespace aria2
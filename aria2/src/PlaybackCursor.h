@@ -0,0 +1,99 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2013 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_PLAYBACK_CURSOR_H
+#define D_PLAYBACK_CURSOR_H
+
+#include "common.h"
+
+#include <chrono>
+
+#include "TimerA2.h"
+
+namespace aria2 {
+
+// Position of a media player which plays a file while it is being
+// downloaded.  The player reports its position and bitrate with
+// aria2.changePlaybackPosition, and the position moves at the bitrate
+// from then on.  Each byte of the file has a deadline, the time the
+// player reaches it.
+class PlaybackCursor {
+public:
+  // The data the player reaches within this time is urgent.
+  static const int URGENT_SEC = 20;
+
+  PlaybackCursor();
+
+  // Sets the position and bitrate in bytes per second.  bitrate 0
+  // means that the bitrate is unknown or that the player is paused.
+  void update(int64_t position, int64_t bitrate);
+
+  int64_t getPosition() const;
+
+  int64_t getBitrate() const { return bitrate_; }
+
+  // Returns true if the player is playing at a known bitrate.  The
+  // deadlines are known only in this case.
+  bool isPlaying() const { return bitrate_ > 0; }
+
+  // Returns the time left until the player reaches |offset|, which is
+  // negative if the player has passed it.  If the player is not
+  // playing, returns std::chrono::milliseconds::max().
+  std::chrono::milliseconds getTimeLeft(int64_t offset) const;
+
+  // Returns the offset the player reaches in URGENT_SEC seconds.  The
+  // data in [getPosition(), getUrgentEnd()) is urgent.  If the player
+  // is not playing, only the byte at the position is urgent.
+  int64_t getUrgentEnd() const;
+
+  // Returns true if |length| bytes from |offset| can be downloaded at
+  // |speed| bytes per second before the player reaches |offset|.
+  bool canMeetDeadline(int64_t offset, int64_t length, int speed) const;
+
+  // Returns the first offset from which a connection downloading at
+  // |speed| bytes per second can download |length| bytes before the
+  // player reaches the offset.  The player must be playing and speed
+  // must be positive.
+  int64_t getReachableOffset(int64_t length, int speed) const;
+
+private:
+  int64_t position_;
+  int64_t bitrate_;
+  // The time position_ was set
+  Timer updated_;
+};
+
+} // namespace aria2
+
+#endif // D_PLAYBACK_CURSOR_H
@@ -0,0 +1,104 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2015 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_READ_AHEAD_BUFFER_H
+#define D_READ_AHEAD_BUFFER_H
+
+#include "common.h"
+
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+namespace aria2 {
+
+// Buffer which reads more than the caller asks for from the
+// underlying transport, and serves the following reads from it.
+// SSHSession uses it to make libssh2_sftp_read() keep more read
+// requests in flight.
+class ReadAheadBuffer {
+public:
+  ReadAheadBuffer() : pos_(0), last_(0) {}
+
+  // Discards the buffered data and sets the size of the buffer to
+  // |capacity|.  If |capacity| is 0, read() always reads the
+  // transport directly.
+  void reset(size_t capacity)
+  {
+    buf_.resize(capacity);
+    clear();
+  }
+
+  // Discards the buffered data.
+  void clear() { pos_ = last_ = 0; }
+
+  // Returns the number of bytes read() returns without reading the
+  // transport.
+  size_t getBufferedLength() const { return last_ - pos_; }
+
+  // Reads at most |len| bytes into |data|.  If nothing is buffered,
+  // calls |readFunc|, which takes a char* and a size_t and returns
+  // ssize_t like read(2), to fill the buffer, or to read into |data|
+  // directly if |len| is not less than the buffer size.  Returns the
+  // number of bytes read, or the value |readFunc| returned if it is
+  // not positive.
+  template <typename ReadFunc>
+  ssize_t read(void* data, size_t len, ReadFunc readFunc)
+  {
+    if (pos_ == last_) {
+      if (len >= buf_.size()) {
+        return readFunc(static_cast<char*>(data), len);
+      }
+      auto nread = readFunc(buf_.data(), buf_.size());
+      if (nread <= 0) {
+        return nread;
+      }
+      pos_ = 0;
+      last_ = nread;
+    }
+    auto n = std::min(len, last_ - pos_);
+    memcpy(data, buf_.data() + pos_, n);
+    pos_ += n;
+    return n;
+  }
+
+private:
+  std::vector<char> buf_;
+  size_t pos_;
+  size_t last_;
+};
+
+} // namespace aria2
+
+#endif // D_READ_AHEAD_BUFFER_H
@@ -111,6 +111,7 @@
 #  include "DHTEntryPointNameResolveCommand.h"
 #  include "LongestSequencePieceSelector.h"
 #  include "PriorityPieceSelector.h"
+#  include "DeadlinePieceSelector.h"
 #  include "bittorrent_helper.h"
 #endif // ENABLE_BITTORRENT
 #ifdef ENABLE_METALINK
@@ -590,6 +591,12 @@ void RequestGroup::initPieceStorage()
           ps->setPieceSelector(std::move(priSelector));
         }
       }
+      if (option_->get(PREF_STREAM_PIECE_SELECTOR) == A2_V_DEADLINE) {
+        A2_LOG_DEBUG("Using DeadlinePieceSelector");
+        ps->setPieceSelector(make_unique<DeadlinePieceSelector>(
+            ps->popPieceSelector(), &downloadContext_->getPlaybackCursor(),
+            downloadContext_->getPieceLength()));
+      }
     }
 #else  // !ENABLE_BITTORRENT
     auto ps =
@@ -618,6 +625,7 @@ void RequestGroup::initPieceStorage()
   segmentMan_ =
       std::make_shared<SegmentMan>(downloadContext_, tempPieceStorage);
   pieceStorage_ = tempPieceStorage;
+  downloadContext_->initIncrementalChecksum();
 
 #ifdef __MINGW32__
   // Windows build: --file-allocation=falloc uses SetFileValidData
@@ -486,6 +486,12 @@ public:
 
   RequestGroupMan* getRequestGroupMan() { return requestGroupMan_; }
 
+#ifdef ENABLE_BITTORRENT
+  // Returns the PeerStorage of the BitTorrent download in progress,
+  // or nullptr.
+  PeerStorage* getPeerStorage() const { return peerStorage_; }
+#endif // ENABLE_BITTORRENT
+
   int getResumeFailureCount() const { return resumeFailureCount_; }
 
   void increaseResumeFailureCount() { ++resumeFailureCount_; }
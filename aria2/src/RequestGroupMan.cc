@@ -78,6 +78,7 @@
 #include "Notifier.h"
 #include "PeerStat.h"
 #include "WrDiskCache.h"
+#include "PieceHashIndex.h"
 #include "PieceStorage.h"
 #include "DiskAdaptor.h"
 #include "SimpleRandomizer.h"
@@ -121,6 +122,7 @@ RequestGroupMan::RequestGroupMan(
       queueCheck_(true),
       removedErrorResult_(0),
       removedLastErrorResult_(error_code::FINISHED),
+      numInProgressResult_(0),
       maxDownloadResult_(option->getAsInt(PREF_MAX_DOWNLOAD_RESULT)),
       openedFileCounter_(std::make_shared<OpenedFileCounter>(
           this, option->getAsInt(PREF_BT_MAX_OPEN_FILES))),
@@ -380,6 +382,10 @@ public:
                  !group->getDownloadContext()->isChecksumVerificationNeeded()) {
           group->applyLastModifiedTimeToLocalFiles();
           group->reportDownloadFinished();
+          auto pieceHashIndex = e_->getRequestGroupMan()->getPieceHashIndex();
+          if (pieceHashIndex && !group->inMemoryDownload()) {
+            pieceHashIndex->add(*dctx);
+          }
           if (group->allDownloadFinished() &&
               !group->getOption()->getAsBool(PREF_FORCE_SAVE)) {
             group->removeControlFile();
@@ -620,31 +626,47 @@ void RequestGroupMan::closeFile()
 
 RequestGroupMan::DownloadStat RequestGroupMan::getDownloadStat() const
 {
-  int finished = 0;
-  int error = removedErrorResult_;
-  int inprogress = 0;
-  int removed = 0;
   error_code::Value lastError = removedLastErrorResult_;
-  for (auto& dr : downloadResults_) {
+  if (!errorResults_.empty()) {
+    lastError = errorResults_[errorResults_.size() - 1];
+  }
+  return DownloadStat(removedErrorResult_ + errorResults_.size(),
+                      numInProgressResult_, reservedGroups_.size(),
+                      lastError);
+}
 
-    if (dr->belongsTo != 0) {
-      continue;
-    }
-    if (dr->result == error_code::FINISHED) {
-      ++finished;
-    }
-    else if (dr->result == error_code::IN_PROGRESS) {
-      ++inprogress;
-    }
-    else if (dr->result == error_code::REMOVED) {
-      ++removed;
-    }
-    else {
-      ++error;
-      lastError = dr->result;
-    }
+void RequestGroupMan::countDownloadResult(const DownloadResult& dr)
+{
+  if (dr.belongsTo != 0) {
+    return;
+  }
+  switch (dr.result) {
+  case error_code::FINISHED:
+  case error_code::REMOVED:
+    break;
+  case error_code::IN_PROGRESS:
+    ++numInProgressResult_;
+    break;
+  default:
+    errorResults_.push_back(dr.gid->getNumericId(), dr.result);
+  }
+}
+
+void RequestGroupMan::uncountDownloadResult(const DownloadResult& dr)
+{
+  if (dr.belongsTo != 0) {
+    return;
+  }
+  switch (dr.result) {
+  case error_code::FINISHED:
+  case error_code::REMOVED:
+    break;
+  case error_code::IN_PROGRESS:
+    --numInProgressResult_;
+    break;
+  default:
+    errorResults_.remove(dr.gid->getNumericId());
   }
-  return DownloadStat(error, inprogress, reservedGroups_.size(), lastError);
 }
 
 enum DownloadResultStatus {
@@ -911,6 +933,11 @@ RequestGroupMan::findDownloadResult(a2_gid_t gid) const
 
 bool RequestGroupMan::removeDownloadResult(a2_gid_t gid)
 {
+  auto dr = downloadResults_.get(gid);
+  if (!dr) {
+    return false;
+  }
+  uncountDownloadResult(*dr);
   return downloadResults_.remove(gid);
 }
 
@@ -920,6 +947,7 @@ void RequestGroupMan::addDownloadResult(
   ++numStoppedTotal_;
   bool rv = downloadResults_.push_back(dr->gid->getNumericId(), dr);
   assert(rv);
+  countDownloadResult(*dr);
   while (downloadResults_.size() > maxDownloadResult_) {
     // Save last encountered error code so that we can report it
     // later.
@@ -937,11 +965,17 @@ void RequestGroupMan::addDownloadResult(
         }
       }
     }
+    uncountDownloadResult(*dr);
     downloadResults_.pop_front();
   }
 }
 
-void RequestGroupMan::purgeDownloadResult() { downloadResults_.clear(); }
+void RequestGroupMan::purgeDownloadResult()
+{
+  downloadResults_.clear();
+  numInProgressResult_ = 0;
+  errorResults_.clear();
+}
 
 std::shared_ptr<ServerStat>
 RequestGroupMan::findServerStat(const std::string& hostname,
@@ -954,12 +988,7 @@ std::shared_ptr<ServerStat>
 RequestGroupMan::getOrCreateServerStat(const std::string& hostname,
                                        const std::string& protocol)
 {
-  std::shared_ptr<ServerStat> ss = findServerStat(hostname, protocol);
-  if (!ss) {
-    ss = std::make_shared<ServerStat>(hostname, protocol);
-    addServerStat(ss);
-  }
-  return ss;
+  return serverStatMan_->getOrCreate(hostname, protocol);
 }
 
 bool RequestGroupMan::addServerStat(
@@ -975,7 +1004,10 @@ bool RequestGroupMan::loadServerStat(const std::string& filename)
 
 bool RequestGroupMan::saveServerStat(const std::string& filename) const
 {
-  return serverStatMan_->save(filename);
+  return serverStatMan_->save(filename,
+                              option_->get(PREF_SERVER_STAT_FORMAT) == V_BINARY
+                                  ? ServerStatMan::BINARY
+                                  : ServerStatMan::TEXT);
 }
 
 void RequestGroupMan::removeStaleServerStat(const std::chrono::seconds& timeout)
@@ -983,6 +1015,23 @@ void RequestGroupMan::removeStaleServerStat(const std::chrono::seconds& timeout)
   serverStatMan_->removeStaleServerStat(timeout);
 }
 
+bool RequestGroupMan::loadPieceHashIndex(const std::string& filename)
+{
+  pieceHashIndex_ = make_unique<PieceHashIndex>();
+  if (!File(filename).exists()) {
+    return true;
+  }
+  return pieceHashIndex_->load(filename);
+}
+
+bool RequestGroupMan::savePieceHashIndex(const std::string& filename) const
+{
+  if (!pieceHashIndex_) {
+    return false;
+  }
+  return pieceHashIndex_->save(filename);
+}
+
 bool RequestGroupMan::doesOverallDownloadSpeedExceed()
 {
   return maxOverallDownloadSpeedLimit_ > 0 &&
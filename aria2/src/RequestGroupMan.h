@@ -60,6 +60,7 @@ class Option;
 class OutputFile;
 class UriListParser;
 class WrDiskCache;
+class PieceHashIndex;
 class OpenedFileCounter;
 
 typedef IndexedList<a2_gid_t, std::shared_ptr<RequestGroup>> RequestGroupList;
@@ -114,6 +115,18 @@ private:
   // The last error of removed DownloadResult
   error_code::Value removedLastErrorResult_;
 
+  // The number of DownloadResult in downloadResults_ with
+  // error_code::IN_PROGRESS, excluding the ones belonging to other
+  // download.
+  int numInProgressResult_;
+
+  // Error codes of DownloadResult in downloadResults_, excluding the
+  // ones belonging to other download, in the same order.  This and
+  // numInProgressResult_ are updated whenever downloadResults_
+  // changes, so that getDownloadStat() does not scan
+  // downloadResults_.
+  IndexedList<a2_gid_t, error_code::Value> errorResults_;
+
   size_t maxDownloadResult_;
 
   // UriListParser for deferred input.
@@ -121,6 +134,9 @@ private:
 
   std::unique_ptr<WrDiskCache> wrDiskCache_;
 
+  // nullptr unless --piece-hash-index is given
+  std::unique_ptr<PieceHashIndex> pieceHashIndex_;
+
   std::shared_ptr<OpenedFileCounter> openedFileCounter_;
 
   // The number of stopped downloads so far in total, including
@@ -147,6 +163,11 @@ private:
 
   int optimizeConcurrentDownloads();
 
+  // Updates numInProgressResult_ and errorResults_ when |dr| is added
+  // to or removed from downloadResults_.
+  void countDownloadResult(const DownloadResult& dr);
+  void uncountDownloadResult(const DownloadResult& dr);
+
 public:
   RequestGroupMan(std::vector<std::shared_ptr<RequestGroup>> requestGroups,
                   int maxConcurrentDownloads, const Option* option);
@@ -286,6 +307,14 @@ public:
 
   void removeStaleServerStat(const std::chrono::seconds& timeout);
 
+  // Creates the piece hash index, and loads it from |filename| if the
+  // file exists.  Returns false if loading the existing file fails.
+  bool loadPieceHashIndex(const std::string& filename);
+
+  bool savePieceHashIndex(const std::string& filename) const;
+
+  PieceHashIndex* getPieceHashIndex() const { return pieceHashIndex_.get(); }
+
   // Returns true if current download speed exceeds
   // maxOverallDownloadSpeedLimit_.  Always returns false if
   // maxOverallDownloadSpeedLimit_ == 0.  Otherwise returns false.
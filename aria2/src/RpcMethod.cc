@@ -83,7 +83,7 @@ void RpcMethod::authorize(RpcRequest& req, DownloadEngine* e)
       }
     }
   }
-  if (!e || !e->validateToken(token)) {
+  if (!e || !e->validateToken(token, req.tokenCache)) {
     throw DL_ABORT_EX("Unauthorized");
   }
 }
@@ -68,6 +68,7 @@ std::vector<std::string> rpcMethodNames = {
     "aria2.unpauseAll",
     "aria2.forceRemove",
     "aria2.changePosition",
+    "aria2.changePlaybackPosition",
     "aria2.tellStatus",
     "aria2.getUris",
     "aria2.getFiles",
@@ -87,6 +88,7 @@ std::vector<std::string> rpcMethodNames = {
     "aria2.shutdown",
     "aria2.forceShutdown",
     "aria2.getGlobalStat",
+    "aria2.getMetrics",
     "aria2.saveSession",
     "system.multicall",
     "system.listMethods",
@@ -171,6 +173,10 @@ std::unique_ptr<RpcMethod> createMethod(const std::string& methodName)
     return make_unique<ChangePositionRpcMethod>();
   }
 
+  if (methodName == ChangePlaybackPositionRpcMethod::getMethodName()) {
+    return make_unique<ChangePlaybackPositionRpcMethod>();
+  }
+
   if (methodName == TellStatusRpcMethod::getMethodName()) {
     return make_unique<TellStatusRpcMethod>();
   }
@@ -247,6 +253,10 @@ std::unique_ptr<RpcMethod> createMethod(const std::string& methodName)
     return make_unique<GetGlobalStatRpcMethod>();
   }
 
+  if (methodName == GetMetricsRpcMethod::getMethodName()) {
+    return make_unique<GetMetricsRpcMethod>();
+  }
+
   if (methodName == SaveSessionRpcMethod::getMethodName()) {
     return make_unique<SaveSessionRpcMethod>();
   }
@@ -69,6 +69,8 @@
 #include "MessageDigest.h"
 #include "message_digest_helper.h"
 #include "OpenedFileCounter.h"
+#include "Metrics.h"
+#include "AuthTokenCache.h"
 #ifdef ENABLE_BITTORRENT
 #  include "bittorrent_helper.h"
 #  include "BtRegistry.h"
@@ -76,6 +78,7 @@
 #  include "Peer.h"
 #  include "BtRuntime.h"
 #  include "BtAnnounce.h"
+#  include "TorrentIngestor.h"
 #endif // ENABLE_BITTORRENT
 #include "CheckIntegrityEntry.h"
 
@@ -276,8 +279,15 @@ std::unique_ptr<ValueBase> AddTorrentRpcMethod::process(const RpcRequest& req,
   const Dict* optsParam = checkParam<Dict>(req, 2);
   const Integer* posParam = checkParam<Integer>(req, 3);
 
+  // The torrent parsed by system.multicall in advance, which has the
+  // data decoded already.
+  auto job = req.torrentJob;
   std::unique_ptr<String> tempTorrentParam;
-  if (req.jsonRpc) {
+  if (job) {
+    tempTorrentParam = String::g(std::move(job->data));
+    torrentParam = tempTorrentParam.get();
+  }
+  else if (req.jsonRpc) {
     tempTorrentParam = String::g(
         base64::decode(torrentParam->s().begin(), torrentParam->s().end()));
     torrentParam = tempTorrentParam.get();
@@ -293,8 +303,13 @@ std::unique_ptr<ValueBase> AddTorrentRpcMethod::process(const RpcRequest& req,
 
   std::string filename;
   if (requestOption->getAsBool(PREF_RPC_SAVE_UPLOAD_METADATA)) {
-    filename = util::applyDir(requestOption->get(PREF_DIR),
-                              getHexSha1(torrentParam->s()) + ".torrent");
+    if (job && !job->metaInfoUri.empty()) {
+      filename = job->metaInfoUri;
+    }
+    else {
+      filename = util::applyDir(requestOption->get(PREF_DIR),
+                                getHexSha1(torrentParam->s()) + ".torrent");
+    }
     // Save uploaded data in order to save this download in
     // --save-session file.
     if (util::saveAs(filename, torrentParam->s(), true)) {
@@ -310,8 +325,20 @@ std::unique_ptr<ValueBase> AddTorrentRpcMethod::process(const RpcRequest& req,
     }
   }
   std::vector<std::shared_ptr<RequestGroup>> result;
-  createRequestGroupForBitTorrent(result, requestOption, uris, filename,
-                                  torrentParam->s());
+  // The job was parsed with the name the torrent gets if it lacks
+  // one, which differs if the data could not be saved.
+  if (job && job->metaInfoUri == filename &&
+      (job->downloadContext || job->error)) {
+    if (job->error) {
+      std::rethrow_exception(job->error);
+    }
+    createRequestGroupForBitTorrent(result, requestOption, filename,
+                                    job->downloadContext);
+  }
+  else {
+    createRequestGroupForBitTorrent(result, requestOption, uris, filename,
+                                    torrentParam->s());
+  }
 
   if (!result.empty()) {
     return addRequestGroup(result.front(), e, posGiven, pos);
@@ -1251,6 +1278,35 @@ ChangePositionRpcMethod::process(const RpcRequest& req, DownloadEngine* e)
   return Integer::g(destPos);
 }
 
+std::unique_ptr<ValueBase>
+ChangePlaybackPositionRpcMethod::process(const RpcRequest& req,
+                                         DownloadEngine* e)
+{
+  const String* gidParam = checkRequiredParam<String>(req, 0);
+  const Integer* posParam = checkRequiredParam<Integer>(req, 1);
+  const Integer* bitrateParam = checkParam<Integer>(req, 2);
+
+  a2_gid_t gid = str2Gid(gidParam);
+  auto group = e->getRequestGroupMan()->findGroup(gid);
+  if (!group) {
+    throw DL_ABORT_EX(fmt("Cannot change playback position of GID#%s",
+                          GroupId::toHex(gid).c_str()));
+  }
+  if (group->getOption()->get(PREF_STREAM_PIECE_SELECTOR) != A2_V_DEADLINE) {
+    throw DL_ABORT_EX(fmt("GID#%s is not downloaded with"
+                          " --stream-piece-selector=%s",
+                          GroupId::toHex(gid).c_str(),
+                          A2_V_DEADLINE.c_str()));
+  }
+  int64_t bitrate = bitrateParam ? bitrateParam->i() : 0;
+  if (posParam->i() < 0 || bitrate < 0) {
+    throw DL_ABORT_EX("Illegal argument.");
+  }
+  group->getDownloadContext()->getPlaybackCursor().update(posParam->i(),
+                                                          bitrate);
+  return createOKResponse();
+}
+
 std::unique_ptr<ValueBase>
 GetSessionInfoRpcMethod::process(const RpcRequest& req, DownloadEngine* e)
 {
@@ -1393,6 +1449,36 @@ GetGlobalStatRpcMethod::process(const RpcRequest& req, DownloadEngine* e)
   return std::move(res);
 }
 
+std::unique_ptr<ValueBase>
+GetMetricsRpcMethod::process(const RpcRequest& req, DownloadEngine* e)
+{
+  auto res = Dict::g();
+  for (auto& m : global::metrics().getMetrics()) {
+    switch (m->getType()) {
+    case Metric::COUNTER:
+      res->put(m->getName(), util::uitos(static_cast<Counter*>(m.get())->get()));
+      break;
+    case Metric::GAUGE:
+      res->put(m->getName(), util::itos(static_cast<Gauge*>(m.get())->get()));
+      break;
+    case Metric::HISTOGRAM: {
+      auto h = static_cast<Histogram*>(m.get());
+      auto scale = h->getScale();
+      auto entry = Dict::g();
+      entry->put("count", util::uitos(h->getCount()));
+      entry->put("sum", fmt("%.9g", h->getSum() * scale));
+      entry->put("p50", fmt("%.9g", h->getQuantile(0.5) * scale));
+      entry->put("p90", fmt("%.9g", h->getQuantile(0.9) * scale));
+      entry->put("p99", fmt("%.9g", h->getQuantile(0.99) * scale));
+      entry->put("max", fmt("%.9g", h->getMax() * scale));
+      res->put(m->getName(), std::move(entry));
+      break;
+    }
+    }
+  }
+  return std::move(res);
+}
+
 std::unique_ptr<ValueBase> SaveSessionRpcMethod::process(const RpcRequest& req,
                                                          DownloadEngine* e)
 {
@@ -1418,14 +1504,99 @@ SystemMulticallRpcMethod::process(const RpcRequest& req, DownloadEngine* e)
   return nullptr;
 }
 
+#ifdef ENABLE_BITTORRENT
+std::vector<TorrentIngestJob*> SystemMulticallRpcMethod::ingestTorrents(
+    std::vector<TorrentIngestJob>& jobs, const List* methodSpecs,
+    bool jsonRpc, DownloadEngine* e, AuthTokenCache* tokenCache)
+{
+  std::vector<TorrentIngestJob*> res(methodSpecs->size());
+  std::vector<size_t> callIndexes;
+  for (size_t i = 0; i < methodSpecs->size(); ++i) {
+    const Dict* methodDict = downcast<Dict>(methodSpecs->get(i));
+    if (!methodDict) {
+      continue;
+    }
+    const String* methodName =
+        downcast<String>(methodDict->get(KEY_METHOD_NAME));
+    if (!methodName) {
+      continue;
+    }
+    // The options of the later calls may differ from the ones used
+    // here.
+    if (methodName->s() == ChangeGlobalOptionRpcMethod::getMethodName()) {
+      break;
+    }
+    const List* params = downcast<List>(methodDict->get(KEY_PARAMS));
+    if (methodName->s() != AddTorrentRpcMethod::getMethodName() || !params) {
+      continue;
+    }
+    auto param = [params](size_t index) -> const ValueBase* {
+      return index < params->size() ? params->get(index) : nullptr;
+    };
+    // Don't spend time on the calls which are rejected anyway.  The
+    // token is only peeked at here, and authorize() removes it later.
+    size_t first = 0;
+    std::string token;
+    const String* t = downcast<String>(param(0));
+    if (t && util::startsWith(t->s(), "token:")) {
+      token = t->s().substr(6);
+      first = 1;
+    }
+    if (!e->validateToken(token, tokenCache)) {
+      continue;
+    }
+    const String* torrentParam = downcast<String>(param(first));
+    if (!torrentParam || torrentParam->s().empty()) {
+      continue;
+    }
+    TorrentIngestJob job;
+    job.option = std::make_shared<Option>(*e->getOption());
+    try {
+      // The same option AddTorrentRpcMethod creates.  The calls with
+      // the invalid options fail there.
+      gatherRequestOption(job.option.get(),
+                          downcast<Dict>(param(first + 2)));
+    }
+    catch (RecoverableException& ex) {
+      continue;
+    }
+    extractUris(std::back_inserter(job.uris),
+                downcast<List>(param(first + 1)));
+    job.data = torrentParam->s();
+    job.base64 = jsonRpc;
+    jobs.push_back(std::move(job));
+    callIndexes.push_back(i);
+  }
+  // Ingesting a single torrent gains nothing.
+  if (jobs.size() < 2) {
+    jobs.clear();
+    return res;
+  }
+  TorrentIngestor().run(jobs);
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    res[callIndexes[i]] = &jobs[i];
+  }
+  return res;
+}
+#endif // ENABLE_BITTORRENT
+
 RpcResponse SystemMulticallRpcMethod::execute(RpcRequest req, DownloadEngine* e)
 {
   auto authorized = RpcResponse::AUTHORIZED;
+  // The calls in a batch usually carry the same token, which is
+  // verified only once.
+  AuthTokenCache batchTokenCache;
+  auto tokenCache = req.tokenCache ? req.tokenCache : &batchTokenCache;
   try {
     const List* methodSpecs = checkRequiredParam<List>(req, 0);
+#ifdef ENABLE_BITTORRENT
+    std::vector<TorrentIngestJob> jobs;
+    auto torrentJobs =
+        ingestTorrents(jobs, methodSpecs, req.jsonRpc, e, tokenCache);
+#endif // ENABLE_BITTORRENT
     auto list = List::g();
-    for (auto& methodSpec : *methodSpecs) {
-      Dict* methodDict = downcast<Dict>(methodSpec);
+    for (size_t i = 0, len = methodSpecs->size(); i < len; ++i) {
+      Dict* methodDict = downcast<Dict>(methodSpecs->get(i));
       if (!methodDict) {
         list->append(createErrorResponse(
             DL_ABORT_EX("system.multicall expected struct."), req));
@@ -1455,6 +1626,10 @@ RpcResponse SystemMulticallRpcMethod::execute(RpcRequest req, DownloadEngine* e)
       }
       RpcRequest r = {methodName->s(), std::move(paramsList), nullptr,
                       req.jsonRpc};
+      r.tokenCache = tokenCache;
+#ifdef ENABLE_BITTORRENT
+      r.torrentJob = torrentJobs[i];
+#endif // ENABLE_BITTORRENT
       RpcResponse res = getMethod(methodName->s())->execute(std::move(r), e);
       if (rpc::not_authorized(res)) {
         authorized = RpcResponse::NOTAUTHORIZED;
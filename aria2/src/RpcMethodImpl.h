@@ -55,6 +55,7 @@ namespace aria2 {
 struct DownloadResult;
 class RequestGroup;
 class CheckIntegrityEntry;
+struct TorrentIngestJob;
 
 namespace rpc {
 
@@ -462,6 +463,18 @@ public:
   static const char* getMethodName() { return "aria2.changePosition"; }
 };
 
+class ChangePlaybackPositionRpcMethod : public RpcMethod {
+protected:
+  virtual std::unique_ptr<ValueBase> process(const RpcRequest& req,
+                                             DownloadEngine* e) CXX11_OVERRIDE;
+
+public:
+  static const char* getMethodName()
+  {
+    return "aria2.changePlaybackPosition";
+  }
+};
+
 class ChangeUriRpcMethod : public RpcMethod {
 protected:
   virtual std::unique_ptr<ValueBase> process(const RpcRequest& req,
@@ -498,6 +511,15 @@ public:
   static const char* getMethodName() { return "aria2.getGlobalStat"; }
 };
 
+class GetMetricsRpcMethod : public RpcMethod {
+protected:
+  virtual std::unique_ptr<ValueBase> process(const RpcRequest& req,
+                                             DownloadEngine* e) CXX11_OVERRIDE;
+
+public:
+  static const char* getMethodName() { return "aria2.getMetrics"; }
+};
+
 class ForceShutdownRpcMethod : public RpcMethod {
 protected:
   virtual std::unique_ptr<ValueBase> process(const RpcRequest& req,
@@ -525,6 +547,16 @@ public:
   virtual RpcResponse execute(RpcRequest req, DownloadEngine* e) CXX11_OVERRIDE;
 
   static const char* getMethodName() { return "system.multicall"; }
+
+private:
+#ifdef ENABLE_BITTORRENT
+  // Parses the torrents of the authorized aria2.addTorrent calls in
+  // |methodSpecs| in parallel, and stores them in |jobs|.  Returns
+  // the job of each call, nullptr for the calls without one.
+  std::vector<TorrentIngestJob*>
+  ingestTorrents(std::vector<TorrentIngestJob>& jobs, const List* methodSpecs,
+                 bool jsonRpc, DownloadEngine* e, AuthTokenCache* tokenCache);
+#endif // ENABLE_BITTORRENT
 };
 
 class SystemListMethodsRpcMethod : public RpcMethod {
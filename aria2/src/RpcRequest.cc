@@ -38,12 +38,17 @@ namespace aria2 {
 
 namespace rpc {
 
-RpcRequest::RpcRequest() : jsonRpc{false} {}
+RpcRequest::RpcRequest()
+    : jsonRpc{false}, tokenCache{nullptr}, torrentJob{nullptr}
+{
+}
 
 RpcRequest::RpcRequest(std::string methodName, std::unique_ptr<List> params)
     : methodName{std::move(methodName)},
       params{std::move(params)},
-      jsonRpc{false}
+      jsonRpc{false},
+      tokenCache{nullptr},
+      torrentJob{nullptr}
 {
 }
 
@@ -52,7 +57,9 @@ RpcRequest::RpcRequest(std::string methodName, std::unique_ptr<List> params,
     : methodName{std::move(methodName)},
       params{std::move(params)},
       id{std::move(id)},
-      jsonRpc{jsonRpc}
+      jsonRpc{jsonRpc},
+      tokenCache{nullptr},
+      torrentJob{nullptr}
 {
 }
 
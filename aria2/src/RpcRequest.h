@@ -43,6 +43,9 @@
 
 namespace aria2 {
 
+class AuthTokenCache;
+struct TorrentIngestJob;
+
 namespace rpc {
 
 struct RpcRequest {
@@ -50,6 +53,12 @@ struct RpcRequest {
   std::unique_ptr<List> params;
   std::unique_ptr<ValueBase> id;
   bool jsonRpc;
+  // The secret token cache of the connection the request came from.
+  // nullptr if there is none.
+  AuthTokenCache* tokenCache;
+  // The torrent of aria2.addTorrent parsed in advance by
+  // system.multicall.  nullptr if there is none.
+  TorrentIngestJob* torrentJob;
 
   RpcRequest();
 
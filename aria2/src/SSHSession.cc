@@ -118,6 +118,7 @@ int SSHSession::sftpClose()
     return SSH_ERR_ERROR;
   }
   sftph_ = nullptr;
+  readAhead_.clear();
   return SSH_ERR_OK;
 }
 
@@ -149,7 +150,9 @@ ssize_t SSHSession::writeData(const void* data, size_t len)
 
 ssize_t SSHSession::readData(void* data, size_t len)
 {
-  auto nread = libssh2_sftp_read(sftph_, static_cast<char*>(data), len);
+  auto nread = readAhead_.read(data, len, [this](char* buf, size_t n) {
+    return libssh2_sftp_read(sftph_, buf, n);
+  });
   if (nread == LIBSSH2_ERROR_EAGAIN) {
     return SSH_ERR_WOULDBLOCK;
   }
@@ -203,7 +206,7 @@ int SSHSession::authPassword(const std::string& user,
   return SSH_ERR_OK;
 }
 
-int SSHSession::sftpOpen(const std::string& path)
+int SSHSession::sftpOpen(const std::string& path, size_t readAhead)
 {
   if (!sftp_) {
     sftp_ = libssh2_sftp_init(ssh2_);
@@ -222,6 +225,7 @@ int SSHSession::sftpOpen(const std::string& path)
       }
       return SSH_ERR_ERROR;
     }
+    readAhead_.reset(readAhead / 4);
   }
   return SSH_ERR_OK;
 }
@@ -241,7 +245,11 @@ int SSHSession::sftpStat(int64_t& totalLength, time_t& mtime)
   return SSH_ERR_OK;
 }
 
-void SSHSession::sftpSeek(int64_t pos) { libssh2_sftp_seek64(sftph_, pos); }
+void SSHSession::sftpSeek(int64_t pos)
+{
+  readAhead_.clear();
+  libssh2_sftp_seek64(sftph_, pos);
+}
 
 std::string SSHSession::getLastErrorString()
 {
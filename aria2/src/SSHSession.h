@@ -43,6 +43,8 @@
 #include <libssh2.h>
 #include <libssh2_sftp.h>
 
+#include "ReadAheadBuffer.h"
+
 namespace aria2 {
 
 enum SSHDirection { SSH_WANT_READ = 1, SSH_WANT_WRITE };
@@ -92,6 +94,13 @@ public:
   // SSH_ERR_ERROR.
   ssize_t readData(void* data, size_t len);
 
+  // Returns the number of bytes that readData() returns from its read
+  // ahead buffer, without reading the underlying transport.
+  size_t getRecvBufferedLength() const
+  {
+    return readAhead_.getBufferedLength();
+  }
+
   // Performs handshake. This function returns SSH_ERR_OK
   // if it succeeds, or SSH_ERR_WOULDBLOCK if the underlying transport
   // blocks, or SSH_ERR_ERROR.
@@ -106,10 +115,11 @@ public:
   // if the underlying transport blocks, or SSH_ERR_ERROR.
   int authPassword(const std::string& user, const std::string& password);
 
-  // Starts SFTP session and opens remote file |path|.  This function
-  // returns SSH_ERR_OK if it succeeds, or SSH_ERR_WOULDBLOCK if the
-  // underlying transport blocks, or SSH_ERR_ERROR.
-  int sftpOpen(const std::string& path);
+  // Starts SFTP session and opens remote file |path|.  readData()
+  // keeps read requests for about |readAhead| bytes in flight.  This
+  // function returns SSH_ERR_OK if it succeeds, or SSH_ERR_WOULDBLOCK
+  // if the underlying transport blocks, or SSH_ERR_ERROR.
+  int sftpOpen(const std::string& path, size_t readAhead);
 
   // Closes remote file opened by sftpOpen().  This function returns
   // SSH_ERR_OK if it succeeds, or SSH_ERR_WOULDBLOCK if the
@@ -123,7 +133,8 @@ public:
   // blocks, or SSH_ERR_ERROR.
   int sftpStat(int64_t& totalLength, time_t& mtime);
 
-  // Moves file position to |pos|.
+  // Moves file position to |pos|.  The data read ahead are
+  // discarded.
   void sftpSeek(int64_t pos);
 
   // Returns last error string
@@ -134,6 +145,12 @@ private:
   LIBSSH2_SFTP* sftp_;
   LIBSSH2_SFTP_HANDLE* sftph_;
   sock_t fd_;
+  // libssh2_sftp_read() sends read requests for 4 times the length
+  // of the buffer it is given, one per 30000 bytes, before it waits
+  // for the first reply.  The caller reads 16KiB at a time, which
+  // would leave only 64KiB in flight.  So we read into this buffer of
+  // a quarter of the read ahead size, and serve readData() from it.
+  ReadAheadBuffer readAhead_;
 };
 } // namespace aria2
 
@@ -200,9 +200,102 @@ void SegmentMan::getInFlightSegment(
   }
 }
 
+int SegmentMan::getDownloadSpeed(cuid_t cuid) const
+{
+  // The speed of the last transfer is used even if the command is
+  // idle now, since it is idle while it is getting a new segment.
+  auto ps = getPeerStat(cuid);
+  if (!ps) {
+    return 0;
+  }
+  return ps->calculateDownloadSpeed();
+}
+
+std::shared_ptr<Segment> SegmentMan::takeOverLateSegment(cuid_t cuid)
+{
+  const auto& cursor = downloadContext_->getPlaybackCursor();
+  int speed = getDownloadSpeed(cuid);
+  if (speed == 0) {
+    return nullptr;
+  }
+  int64_t urgentEnd = cursor.getUrgentEnd();
+  std::shared_ptr<SegmentEntry> late;
+  for (auto& e : usedSegmentEntries_) {
+    const auto& segment = e->segment;
+    if (e->cuid == cuid || segment->complete() ||
+        segment->getPositionToWrite() >= urgentEnd ||
+        (late && late->segment->getIndex() < segment->getIndex())) {
+      continue;
+    }
+    int ownerSpeed = getDownloadSpeed(e->cuid);
+    // The owner which has not received anything yet may be still
+    // connecting.
+    if (ownerSpeed == 0 && segment->getWrittenLength() == 0) {
+      continue;
+    }
+    if (speed < 2 * static_cast<int64_t>(ownerSpeed) ||
+        cursor.canMeetDeadline(segment->getPositionToWrite(),
+                               segment->getLength() -
+                                   segment->getWrittenLength(),
+                               ownerSpeed)) {
+      continue;
+    }
+    late = e;
+  }
+  if (!late) {
+    return nullptr;
+  }
+  auto owner = late->cuid;
+  auto segment = late->segment;
+  A2_LOG_INFO(fmt("CUID#%" PRId64 " takes over segment#%lu from CUID#%" PRId64
+                  ", which cannot complete it before the playback position"
+                  " reaches it.",
+                  cuid, static_cast<unsigned long>(segment->getIndex()),
+                  owner));
+  cancelSegment(owner, segment);
+  return getSegmentWithIndex(cuid, segment->getIndex());
+}
+
+std::shared_ptr<Segment> SegmentMan::getReachableSegment(cuid_t cuid,
+                                                         size_t minSplitSize)
+{
+  const auto& cursor = downloadContext_->getPlaybackCursor();
+  int speed = getDownloadSpeed(cuid);
+  if (speed == 0 ||
+      std::none_of(std::begin(peerStats_), std::end(peerStats_),
+                   [speed](const std::shared_ptr<PeerStat>& ps) {
+                     return ps->calculateDownloadSpeed() > speed;
+                   })) {
+    return nullptr;
+  }
+  int32_t pieceLength = downloadContext_->getPieceLength();
+  // The piece at the playback position is always downloadable.
+  int64_t first = (cursor.getPosition() / pieceLength + 1) * pieceLength;
+  int64_t last = cursor.getReachableOffset(pieceLength, speed);
+  if (first >= last) {
+    return nullptr;
+  }
+  BitfieldMan filter(ignoreBitfield_);
+  filter.enableFilter();
+  filter.addFilter(first, last - first);
+  return checkoutSegment(
+      cuid, pieceStorage_->getMissingPiece(minSplitSize,
+                                           filter.getFilterBitfield(),
+                                           filter.getBitfieldLength(), cuid));
+}
+
 std::shared_ptr<Segment> SegmentMan::getSegment(cuid_t cuid,
                                                 size_t minSplitSize)
 {
+  if (downloadContext_->getPlaybackCursor().isPlaying()) {
+    auto segment = takeOverLateSegment(cuid);
+    if (!segment) {
+      segment = getReachableSegment(cuid, minSplitSize);
+    }
+    if (segment) {
+      return segment;
+    }
+  }
   std::shared_ptr<Piece> piece = pieceStorage_->getMissingPiece(
       minSplitSize, ignoreBitfield_.getFilterBitfield(),
       ignoreBitfield_.getBitfieldLength(), cuid);
@@ -99,6 +99,23 @@ private:
   void cancelSegmentInternal(cuid_t cuid,
                              const std::shared_ptr<Segment>& segment);
 
+  // Returns the download speed of the command whose CUID is cuid, or
+  // 0 if it is unknown.
+  int getDownloadSpeed(cuid_t cuid) const;
+
+  // If the player is playing, cancels the segment of another command
+  // which is too slow to complete it before the player reaches it,
+  // and assigns it to cuid if the command is at least twice as fast.
+  // Returns the segment, or nullptr.
+  std::shared_ptr<Segment> takeOverLateSegment(cuid_t cuid);
+
+  // If the player is playing and there is a faster command, returns a
+  // segment excluding the pieces the command whose CUID is cuid cannot
+  // complete before the player reaches them.  Otherwise returns
+  // nullptr.
+  std::shared_ptr<Segment> getReachableSegment(cuid_t cuid,
+                                               size_t minSplitSize);
+
 public:
   SegmentMan(const std::shared_ptr<DownloadContext>& downloadContext,
              const std::shared_ptr<PieceStorage>& pieceStorage);
@@ -130,6 +147,9 @@ public:
   void getInFlightSegment(std::vector<std::shared_ptr<Segment>>& segments,
                           cuid_t cuid);
 
+  // If the player of DownloadContext::getPlaybackCursor() is playing,
+  // the segment the player reaches first is given to the command which
+  // can complete it in time.
   std::shared_ptr<Segment> getSegment(cuid_t cuid, size_t minSplitSize);
 
   // Checkouts segments in the range of fileEntry and push back to
@@ -41,14 +41,27 @@
 #include <memory>
 #include <functional>
 
+#include "Metrics.h"
+
 namespace aria2 {
 
 template <typename T> class SequentialPicker {
 private:
   std::deque<std::unique_ptr<T>> entries_;
   std::unique_ptr<T> pickedEntry_;
+  // If non-null, updated with the number of queued entries.
+  Gauge* queueLength_;
+
+  void updateQueueLength()
+  {
+    if (queueLength_) {
+      queueLength_->set(entries_.size());
+    }
+  }
 
 public:
+  SequentialPicker() : queueLength_(nullptr) {}
+
   bool isPicked() const { return pickedEntry_.get(); }
 
   const std::unique_ptr<T>& getPickedEntry() const { return pickedEntry_; }
@@ -62,6 +75,7 @@ public:
     if (hasNext()) {
       pickedEntry_ = std::move(entries_.front());
       entries_.pop_front();
+      updateQueueLength();
       return pickedEntry_.get();
     }
     return nullptr;
@@ -70,10 +84,17 @@ public:
   void pushEntry(std::unique_ptr<T> entry)
   {
     entries_.push_back(std::move(entry));
+    updateQueueLength();
   }
 
   size_t countEntryInQueue() const { return entries_.size(); }
 
+  void setQueueLengthGauge(Gauge* gauge)
+  {
+    queueLength_ = gauge;
+    updateQueueLength();
+  }
+
   bool isPicked(const std::function<bool(const T&)>& pred) const
   {
     return pickedEntry_ && pred(*pickedEntry_);
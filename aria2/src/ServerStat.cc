@@ -36,6 +36,7 @@
 
 #include <ostream>
 #include <algorithm>
+#include <cmath>
 
 #include "array_fun.h"
 #include "Logger.h"
@@ -57,99 +58,133 @@ ServerStat::ServerStat(const std::string& hostname, const std::string& protocol)
       singleConnectionAvgSpeed_(0),
       multiConnectionAvgSpeed_(0),
       counter_(0),
-      status_(OK)
+      status_(OK),
+      lastUpdated_(Time().getTimeFromEpoch())
 {
 }
 
 ServerStat::~ServerStat() = default;
 
-void ServerStat::setLastUpdated(const Time& time) { lastUpdated_ = time; }
+constexpr std::chrono::hours ServerStat::SPEED_HALF_LIFE;
+
+void ServerStat::setLastUpdated(const Time& time)
+{
+  lastUpdated_.store(time.getTimeFromEpoch(), std::memory_order_relaxed);
+}
+
+int ServerStat::getDecayedDownloadSpeed(const Time& now) const
+{
+  auto speed = getDownloadSpeed();
+  auto age = now.getTimeFromEpoch() -
+             lastUpdated_.load(std::memory_order_relaxed);
+  if (age <= 0) {
+    return speed;
+  }
+  return speed *
+         std::exp2(-static_cast<double>(age) /
+                   std::chrono::seconds(SPEED_HALF_LIFE).count());
+}
 
 void ServerStat::setDownloadSpeed(int downloadSpeed)
 {
-  downloadSpeed_ = downloadSpeed;
+  downloadSpeed_.store(downloadSpeed, std::memory_order_relaxed);
 }
 
 void ServerStat::updateDownloadSpeed(int downloadSpeed)
 {
-  downloadSpeed_ = downloadSpeed;
+  downloadSpeed_.store(downloadSpeed, std::memory_order_relaxed);
   if (downloadSpeed > 0) {
-    status_ = OK;
+    status_.store(OK, std::memory_order_relaxed);
   }
-  lastUpdated_.reset();
+  setLastUpdated(Time());
 }
 
 void ServerStat::setSingleConnectionAvgSpeed(int singleConnectionAvgSpeed)
 {
-  singleConnectionAvgSpeed_ = singleConnectionAvgSpeed;
+  singleConnectionAvgSpeed_.store(singleConnectionAvgSpeed,
+                                  std::memory_order_relaxed);
 }
 
 void ServerStat::updateSingleConnectionAvgSpeed(int downloadSpeed)
 {
   float avgDownloadSpeed;
-  if (counter_ == 0)
+  int counter = getCounter();
+  int singleConnectionAvgSpeed = getSingleConnectionAvgSpeed();
+  if (counter == 0)
     return;
-  if (counter_ < 5) {
-    avgDownloadSpeed = ((((float)counter_ - 1) / (float)counter_) *
-                        (float)singleConnectionAvgSpeed_) +
-                       ((1.0 / (float)counter_) * (float)downloadSpeed);
+  if (counter < 5) {
+    avgDownloadSpeed = ((((float)counter - 1) / (float)counter) *
+                        (float)singleConnectionAvgSpeed) +
+                       ((1.0 / (float)counter) * (float)downloadSpeed);
   }
   else {
-    avgDownloadSpeed = ((4.0 / 5.0) * (float)singleConnectionAvgSpeed_) +
+    avgDownloadSpeed = ((4.0 / 5.0) * (float)singleConnectionAvgSpeed) +
                        ((1.0 / 5.0) * (float)downloadSpeed);
   }
-  if (avgDownloadSpeed < (int)(0.80 * singleConnectionAvgSpeed_)) {
+  if (avgDownloadSpeed < (int)(0.80 * singleConnectionAvgSpeed)) {
     A2_LOG_DEBUG(fmt("ServerStat:%s: resetting counter since single connection"
                      " speed dropped",
                      getHostname().c_str()));
-    counter_ = 0;
+    setCounter(0);
   }
   A2_LOG_DEBUG(
       fmt("ServerStat:%s: singleConnectionAvgSpeed_ old:%.2fKB/s"
           " new:%.2fKB/s last:%.2fKB/s",
-          getHostname().c_str(), (float)singleConnectionAvgSpeed_ / 1024,
+          getHostname().c_str(), (float)singleConnectionAvgSpeed / 1024,
           (float)avgDownloadSpeed / 1024, (float)downloadSpeed / 1024));
-  singleConnectionAvgSpeed_ = (int)avgDownloadSpeed;
+  setSingleConnectionAvgSpeed((int)avgDownloadSpeed);
 }
 
 void ServerStat::setMultiConnectionAvgSpeed(int multiConnectionAvgSpeed)
 {
-  multiConnectionAvgSpeed_ = multiConnectionAvgSpeed;
+  multiConnectionAvgSpeed_.store(multiConnectionAvgSpeed,
+                                 std::memory_order_relaxed);
 }
 
 void ServerStat::updateMultiConnectionAvgSpeed(int downloadSpeed)
 {
   float avgDownloadSpeed;
-  if (counter_ == 0)
+  int counter = getCounter();
+  int multiConnectionAvgSpeed = getMultiConnectionAvgSpeed();
+  if (counter == 0)
     return;
-  if (counter_ < 5) {
-    avgDownloadSpeed = ((((float)counter_ - 1) / (float)counter_) *
-                        (float)multiConnectionAvgSpeed_) +
-                       ((1.0 / (float)counter_) * (float)downloadSpeed);
+  if (counter < 5) {
+    avgDownloadSpeed = ((((float)counter - 1) / (float)counter) *
+                        (float)multiConnectionAvgSpeed) +
+                       ((1.0 / (float)counter) * (float)downloadSpeed);
   }
   else {
-    avgDownloadSpeed = ((4.0 / 5.0) * (float)multiConnectionAvgSpeed_) +
+    avgDownloadSpeed = ((4.0 / 5.0) * (float)multiConnectionAvgSpeed) +
                        ((1.0 / 5.0) * (float)downloadSpeed);
   }
   A2_LOG_DEBUG(
       fmt("ServerStat:%s: multiConnectionAvgSpeed_ old:%.2fKB/s"
           " new:%.2fKB/s last:%.2fKB/s",
-          getHostname().c_str(), (float)multiConnectionAvgSpeed_ / 1024,
+          getHostname().c_str(), (float)multiConnectionAvgSpeed / 1024,
           (float)avgDownloadSpeed / 1024, (float)downloadSpeed / 1024));
-  multiConnectionAvgSpeed_ = (int)avgDownloadSpeed;
+  setMultiConnectionAvgSpeed((int)avgDownloadSpeed);
 }
 
-void ServerStat::increaseCounter() { ++counter_; }
+void ServerStat::increaseCounter()
+{
+  counter_.fetch_add(1, std::memory_order_relaxed);
+}
 
-void ServerStat::setCounter(int value) { counter_ = value; }
+void ServerStat::setCounter(int value)
+{
+  counter_.store(value, std::memory_order_relaxed);
+}
 
-void ServerStat::setStatus(STATUS status) { status_ = status; }
+void ServerStat::setStatus(STATUS status)
+{
+  status_.store(status, std::memory_order_relaxed);
+}
 
 void ServerStat::setStatus(const std::string& status)
 {
   for (int i = 0; i < MAX_STATUS; ++i) {
     if (strcmp(status.c_str(), STATUS_STRING[i]) == 0) {
-      status_ = static_cast<STATUS>(i);
+      setStatus(static_cast<STATUS>(i));
       break;
     }
   }
@@ -160,8 +195,8 @@ void ServerStat::setStatusInternal(STATUS status)
   A2_LOG_DEBUG(fmt("ServerStat: set status %s for %s (%s)",
                    STATUS_STRING[status], hostname_.c_str(),
                    protocol_.c_str()));
-  status_ = status;
-  lastUpdated_.reset();
+  setStatus(status);
+  setLastUpdated(Time());
 }
 
 void ServerStat::setOK() { setStatusInternal(OK); }
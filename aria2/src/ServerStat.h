@@ -39,6 +39,8 @@
 #include <string>
 #include <iosfwd>
 #include <memory>
+#include <atomic>
+#include <chrono>
 
 #include "TimeA2.h"
 
@@ -48,6 +50,11 @@ namespace aria2 {
 // URISelector: interface
 // ServerStatURISelector: Has a reference of ServerStatMan
 // InOrderURISelector: this is default.
+//
+// The statistics are stored in atomic variables, so that they can be
+// read and updated from several threads without locking.  Each value
+// is consistent by itself, but updates of several values are not
+// done as a transaction.
 class ServerStat {
 public:
   enum STATUS { OK = 0, A2_ERROR, MAX_STATUS };
@@ -60,12 +67,25 @@ public:
 
   const std::string& getProtocol() const { return protocol_; }
 
-  const Time& getLastUpdated() const { return lastUpdated_; }
+  Time getLastUpdated() const
+  {
+    return Time(
+        static_cast<time_t>(lastUpdated_.load(std::memory_order_relaxed)));
+  }
 
   // This method doesn't update _lastUpdate.
   void setLastUpdated(const Time& time);
 
-  int getDownloadSpeed() const { return downloadSpeed_; }
+  int getDownloadSpeed() const
+  {
+    return downloadSpeed_.load(std::memory_order_relaxed);
+  }
+
+  // Returns the download speed which is halved for each
+  // SPEED_HALF_LIFE elapsed since lastUpdated_ until |now|.  An old
+  // observation tells less about the current speed of the server, so
+  // that URI selectors prefer servers measured recently.
+  int getDecayedDownloadSpeed(const Time& now) const;
 
   // update download speed and update lastUpdated_
   void updateDownloadSpeed(int downloadSpeed);
@@ -73,17 +93,23 @@ public:
   // set download speed. This method doesn't update _lastUpdate.
   void setDownloadSpeed(int downloadSpeed);
 
-  int getSingleConnectionAvgSpeed() const { return singleConnectionAvgSpeed_; }
+  int getSingleConnectionAvgSpeed() const
+  {
+    return singleConnectionAvgSpeed_.load(std::memory_order_relaxed);
+  }
 
   void updateSingleConnectionAvgSpeed(int downloadSpeed);
   void setSingleConnectionAvgSpeed(int singleConnectionAvgSpeed);
 
-  int getMultiConnectionAvgSpeed() const { return multiConnectionAvgSpeed_; }
+  int getMultiConnectionAvgSpeed() const
+  {
+    return multiConnectionAvgSpeed_.load(std::memory_order_relaxed);
+  }
 
   void updateMultiConnectionAvgSpeed(int downloadSpeed);
   void setMultiConnectionAvgSpeed(int singleConnectionAvgSpeed);
 
-  int getCounter() const { return counter_; }
+  int getCounter() const { return counter_.load(std::memory_order_relaxed); }
 
   void increaseCounter();
   void setCounter(int value);
@@ -96,14 +122,14 @@ public:
   // This method doesn't update _lastUpdate.
   void setStatus(const std::string& status);
 
-  STATUS getStatus() const { return status_; }
+  STATUS getStatus() const { return status_.load(std::memory_order_relaxed); }
 
-  bool isOK() const { return status_ == OK; }
+  bool isOK() const { return getStatus() == OK; }
 
   // set status OK and update lastUpdated_
   void setOK();
 
-  bool isError() const { return status_ == A2_ERROR; }
+  bool isError() const { return getStatus() == A2_ERROR; }
 
   // set status ERROR and update lastUpdated_
   void setError();
@@ -114,33 +140,38 @@ public:
 
   std::string toString() const;
 
+  static constexpr std::chrono::hours SPEED_HALF_LIFE{6};
+
 private:
   std::string hostname_;
 
   std::string protocol_;
 
-  int downloadSpeed_;
+  std::atomic<int> downloadSpeed_;
 
-  int singleConnectionAvgSpeed_;
+  std::atomic<int> singleConnectionAvgSpeed_;
 
-  int multiConnectionAvgSpeed_;
+  std::atomic<int> multiConnectionAvgSpeed_;
 
-  int counter_;
+  std::atomic<int> counter_;
 
-  STATUS status_;
+  std::atomic<STATUS> status_;
 
-  Time lastUpdated_;
+  // The seconds since the Epoch.
+  std::atomic<int64_t> lastUpdated_;
 
   void setStatusInternal(STATUS status);
 };
 
+// Sorts pairs of the download speed and URI in descending order of
+// the speed.  The speed is taken once before sorting, since the
+// ServerStat may be updated while sorting.
 class ServerStatFaster {
 public:
-  bool operator()(
-      const std::pair<std::shared_ptr<ServerStat>, std::string> lhs,
-      const std::pair<std::shared_ptr<ServerStat>, std::string> rhs) const
+  bool operator()(const std::pair<int, std::string>& lhs,
+                  const std::pair<int, std::string>& rhs) const
   {
-    return lhs.first->getDownloadSpeed() > rhs.first->getDownloadSpeed();
+    return lhs.first > rhs.first;
   }
 };
 
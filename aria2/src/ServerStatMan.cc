@@ -44,6 +44,7 @@
 #include "util.h"
 #include "RecoverableException.h"
 #include "a2functional.h"
+#include "a2netcompat.h"
 #include "BufferedFile.h"
 #include "message.h"
 #include "fmt.h"
@@ -56,33 +57,99 @@ ServerStatMan::ServerStatMan() {}
 
 ServerStatMan::~ServerStatMan() = default;
 
+ServerStatMan::Shard& ServerStatMan::getShard(const std::string& hostname)
+{
+  return shards_[std::hash<std::string>()(hostname) % NUM_SHARDS];
+}
+
+const ServerStatMan::Shard&
+ServerStatMan::getShard(const std::string& hostname) const
+{
+  return shards_[std::hash<std::string>()(hostname) % NUM_SHARDS];
+}
+
+namespace {
+std::shared_ptr<ServerStat>
+findProtocol(const std::vector<std::shared_ptr<ServerStat>>& v,
+             const std::string& protocol)
+{
+  for (auto& ss : v) {
+    if (ss->getProtocol() == protocol) {
+      return ss;
+    }
+  }
+  return nullptr;
+}
+} // namespace
+
 std::shared_ptr<ServerStat>
 ServerStatMan::find(const std::string& hostname,
                     const std::string& protocol) const
 {
-  auto ss = std::make_shared<ServerStat>(hostname, protocol);
-  auto i = serverStats_.find(ss);
-  if (i == serverStats_.end()) {
+  auto& shard = getShard(hostname);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto i = shard.serverStats.find(hostname);
+  if (i == shard.serverStats.end()) {
     return nullptr;
   }
-  else {
-    return *i;
+  return findProtocol((*i).second, protocol);
+}
+
+std::shared_ptr<ServerStat>
+ServerStatMan::getOrCreate(const std::string& hostname,
+                           const std::string& protocol)
+{
+  auto& shard = getShard(hostname);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto& v = shard.serverStats[hostname];
+  auto ss = findProtocol(v, protocol);
+  if (!ss) {
+    ss = std::make_shared<ServerStat>(hostname, protocol);
+    v.push_back(ss);
   }
+  return ss;
 }
 
 bool ServerStatMan::add(const std::shared_ptr<ServerStat>& serverStat)
 {
-  auto i = serverStats_.lower_bound(serverStat);
-  if (i != serverStats_.end() && *(*i) == *serverStat) {
+  auto& shard = getShard(serverStat->getHostname());
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto& v = shard.serverStats[serverStat->getHostname()];
+  if (findProtocol(v, serverStat->getProtocol())) {
     return false;
   }
-  else {
-    serverStats_.insert(i, serverStat);
-    return true;
+  v.push_back(serverStat);
+  return true;
+}
+
+size_t ServerStatMan::size() const
+{
+  size_t n = 0;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (auto& e : shard.serverStats) {
+      n += e.second.size();
+    }
+  }
+  return n;
+}
+
+std::vector<std::shared_ptr<ServerStat>>
+ServerStatMan::getSortedServerStats() const
+{
+  std::vector<std::shared_ptr<ServerStat>> res;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (auto& e : shard.serverStats) {
+      res.insert(std::end(res), std::begin(e.second), std::end(e.second));
+    }
   }
+  std::sort(std::begin(res), std::end(res),
+            DerefLess<std::shared_ptr<ServerStat>>());
+  return res;
 }
 
-bool ServerStatMan::save(const std::string& filename) const
+bool ServerStatMan::save(const std::string& filename, Format format) const
 {
   std::string tempfile = filename;
   tempfile += "__temp";
@@ -93,13 +160,9 @@ bool ServerStatMan::save(const std::string& filename) const
           fmt(MSG_OPENING_WRITABLE_SERVER_STAT_FILE_FAILED, filename.c_str()));
       return false;
     }
-    for (auto& e : serverStats_) {
-      std::string l = e->toString();
-      l += "\n";
-      if (fp.write(l.data(), l.size()) != l.size()) {
-        A2_LOG_ERROR(
-            fmt(MSG_WRITING_SERVER_STAT_FILE_FAILED, filename.c_str()));
-      }
+    if (!(format == BINARY ? saveBinary(fp, filename)
+                           : saveText(fp, filename))) {
+      return false;
     }
     if (fp.close() == EOF) {
       A2_LOG_ERROR(fmt(MSG_WRITING_SERVER_STAT_FILE_FAILED, filename.c_str()));
@@ -116,6 +179,170 @@ bool ServerStatMan::save(const std::string& filename) const
   }
 }
 
+bool ServerStatMan::saveText(BufferedFile& fp,
+                             const std::string& filename) const
+{
+  for (auto& e : getSortedServerStats()) {
+    std::string l = e->toString();
+    l += "\n";
+    if (fp.write(l.data(), l.size()) != l.size()) {
+      A2_LOG_ERROR(fmt(MSG_WRITING_SERVER_STAT_FILE_FAILED, filename.c_str()));
+      return false;
+    }
+  }
+  return true;
+}
+
+// The binary format of the server performance profile.  All integers
+// are in network byte order.
+//
+// 8 bytes header:
+//   2 bytes magic: 0xa1 0xa2
+//   1 byte format ID: 0x05
+//   3 bytes reserved
+//   2 bytes version: 0x0001
+// 4 bytes the number of entries
+// Each entry:
+//   1 byte length of protocol, followed by protocol
+//   2 bytes length of hostname, followed by hostname
+//   4 bytes dl_speed
+//   4 bytes sc_avg_speed
+//   4 bytes mc_avg_speed
+//   4 bytes counter
+//   8 bytes last_updated
+//   1 byte status
+namespace {
+const unsigned char BINARY_HEADER[] = {0xa1u, 0xa2u, 0x05u, 0,
+                                       0,     0,     0,     0x01u};
+} // namespace
+
+namespace {
+void appendUInt32(std::string& buf, uint32_t v)
+{
+  v = htonl(v);
+  buf.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+} // namespace
+
+bool ServerStatMan::saveBinary(BufferedFile& fp,
+                               const std::string& filename) const
+{
+  auto serverStats = getSortedServerStats();
+  // Entries whose names don't fit into their length fields are left
+  // out, before the count is written.
+  serverStats.erase(
+      std::remove_if(std::begin(serverStats), std::end(serverStats),
+                     [](const std::shared_ptr<ServerStat>& e) {
+                       return e->getProtocol().size() > UINT8_MAX ||
+                              e->getHostname().size() > UINT16_MAX;
+                     }),
+      std::end(serverStats));
+  std::string buf(std::begin(BINARY_HEADER), std::end(BINARY_HEADER));
+  appendUInt32(buf, serverStats.size());
+  for (auto& e : serverStats) {
+    auto& protocol = e->getProtocol();
+    auto& hostname = e->getHostname();
+    buf += static_cast<char>(protocol.size());
+    buf += protocol;
+    uint16_t hostlen = htons(hostname.size());
+    buf.append(reinterpret_cast<const char*>(&hostlen), sizeof(hostlen));
+    buf += hostname;
+    appendUInt32(buf, e->getDownloadSpeed());
+    appendUInt32(buf, e->getSingleConnectionAvgSpeed());
+    appendUInt32(buf, e->getMultiConnectionAvgSpeed());
+    appendUInt32(buf, e->getCounter());
+    uint64_t lastUpdated = hton64(e->getLastUpdated().getTimeFromEpoch());
+    buf.append(reinterpret_cast<const char*>(&lastUpdated),
+               sizeof(lastUpdated));
+    buf += static_cast<char>(e->getStatus());
+    if (buf.size() >= 16_k) {
+      if (fp.write(buf.data(), buf.size()) != buf.size()) {
+        A2_LOG_ERROR(
+            fmt(MSG_WRITING_SERVER_STAT_FILE_FAILED, filename.c_str()));
+        return false;
+      }
+      buf.clear();
+    }
+  }
+  if (fp.write(buf.data(), buf.size()) != buf.size()) {
+    A2_LOG_ERROR(fmt(MSG_WRITING_SERVER_STAT_FILE_FAILED, filename.c_str()));
+    return false;
+  }
+  return true;
+}
+
+bool ServerStatMan::load(const std::string& filename)
+{
+  {
+    BufferedFile fp(filename.c_str(), BufferedFile::READ);
+    if (!fp) {
+      A2_LOG_ERROR(
+          fmt(MSG_OPENING_READABLE_SERVER_STAT_FILE_FAILED, filename.c_str()));
+      return false;
+    }
+    unsigned char header[sizeof(BINARY_HEADER)];
+    if (fp.read(header, sizeof(header)) == sizeof(header) &&
+        memcmp(header, BINARY_HEADER, 3) == 0) {
+      if (memcmp(header, BINARY_HEADER, sizeof(header)) != 0) {
+        A2_LOG_ERROR(fmt("Unsupported server stat file version: %s",
+                         filename.c_str()));
+        return false;
+      }
+      if (!loadBinary(fp, filename)) {
+        return false;
+      }
+      A2_LOG_NOTICE(fmt(MSG_SERVER_STAT_LOADED, filename.c_str()));
+      return true;
+    }
+  }
+  return loadText(filename);
+}
+
+#define READ_CHECK(fp, ptr, count)                                             \
+  if (fp.read((ptr), (count)) != (count)) {                                    \
+    A2_LOG_ERROR(fmt(MSG_READING_SERVER_STAT_FILE_FAILED, filename.c_str()));  \
+    return false;                                                              \
+  }
+
+bool ServerStatMan::loadBinary(BufferedFile& fp, const std::string& filename)
+{
+  uint32_t numEntries;
+  READ_CHECK(fp, &numEntries, sizeof(numEntries));
+  numEntries = ntohl(numEntries);
+  std::string protocol, hostname;
+  for (uint32_t i = 0; i < numEntries; ++i) {
+    uint8_t protolen;
+    READ_CHECK(fp, &protolen, sizeof(protolen));
+    protocol.resize(protolen);
+    READ_CHECK(fp, &protocol[0], protocol.size());
+    uint16_t hostlen;
+    READ_CHECK(fp, &hostlen, sizeof(hostlen));
+    hostname.resize(ntohs(hostlen));
+    READ_CHECK(fp, &hostname[0], hostname.size());
+    // dl_speed, sc_avg_speed, mc_avg_speed, counter, last_updated
+    // and status
+    unsigned char buf[4 * 4 + 8 + 1];
+    READ_CHECK(fp, buf, sizeof(buf));
+    uint32_t v[4];
+    memcpy(v, buf, sizeof(v));
+    uint64_t lastUpdated;
+    memcpy(&lastUpdated, buf + sizeof(v), sizeof(lastUpdated));
+    if (protocol.empty() || hostname.empty() ||
+        buf[sizeof(buf) - 1] >= ServerStat::MAX_STATUS) {
+      continue;
+    }
+    auto sstat = std::make_shared<ServerStat>(hostname, protocol);
+    sstat->setDownloadSpeed(ntohl(v[0]));
+    sstat->setSingleConnectionAvgSpeed(ntohl(v[1]));
+    sstat->setMultiConnectionAvgSpeed(ntohl(v[2]));
+    sstat->setCounter(ntohl(v[3]));
+    sstat->setLastUpdated(Time(static_cast<time_t>(ntoh64(lastUpdated))));
+    sstat->setStatus(static_cast<ServerStat::STATUS>(buf[sizeof(buf) - 1]));
+    add(sstat);
+  }
+  return true;
+}
+
 namespace {
 // Field and FIELD_NAMES must have same order except for MAX_FIELD.
 enum Field {
@@ -149,7 +376,7 @@ int idField(std::string::const_iterator first, std::string::const_iterator last)
 }
 } // namespace
 
-bool ServerStatMan::load(const std::string& filename)
+bool ServerStatMan::loadText(const std::string& filename)
 {
   BufferedFile fp(filename.c_str(), BufferedFile::READ);
   if (!fp) {
@@ -234,12 +461,24 @@ bool ServerStatMan::load(const std::string& filename)
 void ServerStatMan::removeStaleServerStat(const std::chrono::seconds& timeout)
 {
   auto now = Time();
-  for (auto i = std::begin(serverStats_); i != std::end(serverStats_);) {
-    if ((*i)->getLastUpdated().difference(now) >= timeout) {
-      serverStats_.erase(i++);
-    }
-    else {
-      ++i;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (auto i = std::begin(shard.serverStats);
+         i != std::end(shard.serverStats);) {
+      auto& v = (*i).second;
+      v.erase(std::remove_if(std::begin(v), std::end(v),
+                             [&now, &timeout](
+                                 const std::shared_ptr<ServerStat>& ss) {
+                               return ss->getLastUpdated().difference(now) >=
+                                      timeout;
+                             }),
+              std::end(v));
+      if (v.empty()) {
+        i = shard.serverStats.erase(i);
+      }
+      else {
+        ++i;
+      }
     }
   }
 }
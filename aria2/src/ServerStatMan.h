@@ -37,8 +37,10 @@
 #include "common.h"
 
 #include <string>
-#include <set>
+#include <vector>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #include "a2time.h"
 #include "a2functional.h"
@@ -46,9 +48,17 @@
 namespace aria2 {
 
 class ServerStat;
+class BufferedFile;
 
+// Stores ServerStat objects indexed by hostname and protocol.  The
+// objects are spread over NUM_SHARDS hash tables by the hash of the
+// hostname, each of which is guarded by its own mutex, so that the
+// lookups from several threads rarely wait for each other.  The
+// ServerStat objects themselves are updated without locking.
 class ServerStatMan {
 public:
+  enum Format { TEXT, BINARY };
+
   ServerStatMan();
 
   ~ServerStatMan();
@@ -56,19 +66,57 @@ public:
   std::shared_ptr<ServerStat> find(const std::string& hostname,
                                    const std::string& protocol) const;
 
+  // Returns the ServerStat object for |hostname| and |protocol|.  If
+  // there is no such object, creates and adds new one.
+  std::shared_ptr<ServerStat> getOrCreate(const std::string& hostname,
+                                          const std::string& protocol);
+
   bool add(const std::shared_ptr<ServerStat>& serverStat);
 
+  // Loads ServerStat objects from |filename|.  The format of the file
+  // is detected automatically.
   bool load(const std::string& filename);
 
-  bool save(const std::string& filename) const;
+  // Saves ServerStat objects to |filename| in |format|, sorted by
+  // hostname and protocol.
+  bool save(const std::string& filename, Format format = TEXT) const;
 
   void removeStaleServerStat(const std::chrono::seconds& timeout);
 
+  // Returns the number of ServerStat objects.
+  size_t size() const;
+
+  static const size_t NUM_SHARDS = 16;
+
 private:
-  typedef std::set<std::shared_ptr<ServerStat>,
-                   DerefLess<std::shared_ptr<ServerStat>>>
-      ServerStatSet;
-  ServerStatSet serverStats_;
+  // Most hosts are contacted with only one protocol, so ServerStat
+  // objects of the same hostname are kept in a small vector.  This
+  // allows the lookup by hostname without constructing a key.
+  typedef std::unordered_map<std::string,
+                             std::vector<std::shared_ptr<ServerStat>>>
+      ServerStatMap;
+
+  struct Shard {
+    mutable std::mutex mutex;
+    ServerStatMap serverStats;
+  };
+
+  Shard& getShard(const std::string& hostname);
+
+  const Shard& getShard(const std::string& hostname) const;
+
+  // Returns all ServerStat objects sorted by hostname and protocol.
+  std::vector<std::shared_ptr<ServerStat>> getSortedServerStats() const;
+
+  bool saveText(BufferedFile& fp, const std::string& filename) const;
+
+  bool saveBinary(BufferedFile& fp, const std::string& filename) const;
+
+  bool loadText(const std::string& filename);
+
+  bool loadBinary(BufferedFile& fp, const std::string& filename);
+
+  Shard shards_[NUM_SHARDS];
 };
 
 } // namespace aria2
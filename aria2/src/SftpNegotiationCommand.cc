@@ -113,7 +113,8 @@ bool SftpNegotiationCommand::executeInternal()
       sequence_ = SEQ_SFTP_OPEN;
       break;
     case SEQ_SFTP_OPEN:
-      if (!getSocket()->sshSFTPOpen(path_)) {
+      if (!getSocket()->sshSFTPOpen(
+              path_, getOption()->getAsInt(PREF_SFTP_READ_AHEAD))) {
         goto again;
       }
       A2_LOG_DEBUG(fmt("CUID#%" PRId64 " - SFTP file %s opened", getCuid(),
@@ -75,14 +75,14 @@ std::random_device rd;
 } // namespace
 
 #ifdef __MINGW32__
-SimpleRandomizer::SimpleRandomizer()
+SimpleRandomizer::SimpleRandomizer() : gen_(rd()), seeded_(false)
 {
   BOOL r = ::CryptAcquireContext(&provider_, 0, 0, PROV_RSA_FULL,
                                  CRYPT_VERIFYCONTEXT | CRYPT_SILENT);
   assert(r);
 }
 #else  // !__MINGW32__
-SimpleRandomizer::SimpleRandomizer() : gen_(rd()) {}
+SimpleRandomizer::SimpleRandomizer() : gen_(rd()), seeded_(false) {}
 #endif // !__MINGW32__
 
 SimpleRandomizer::~SimpleRandomizer()
@@ -98,8 +98,22 @@ long int SimpleRandomizer::getRandomNumber(long int to)
   return std::uniform_int_distribution<long int>(0, to - 1)(*this);
 }
 
+void SimpleRandomizer::seed(result_type seed)
+{
+  gen_.seed(seed);
+  seeded_ = true;
+}
+
+void SimpleRandomizer::useSystemEntropy() { seeded_ = false; }
+
 void SimpleRandomizer::getRandomBytes(unsigned char* buf, size_t len)
 {
+  if (seeded_) {
+    for (size_t i = 0; i < len; ++i) {
+      buf[i] = static_cast<unsigned char>(gen_());
+    }
+    return;
+  }
 #ifdef __MINGW32__
   BOOL r = CryptGenRandom(provider_, len, reinterpret_cast<BYTE*>(buf));
   if (!r) {
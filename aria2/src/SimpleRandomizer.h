@@ -54,9 +54,9 @@ private:
 private:
 #ifdef __MINGW32__
   HCRYPTPROV provider_;
-#else
+#endif // __MINGW32__
   std::mt19937 gen_;
-#endif // ! __MINGW32__
+  bool seeded_;
 
 public:
   typedef std::mt19937::result_type result_type;
@@ -72,6 +72,14 @@ public:
 
   void getRandomBytes(unsigned char* buf, size_t len);
 
+  // Makes the following random numbers reproducible from |seed|
+  // until useSystemEntropy() is called.  The numbers are not
+  // suitable for cryptographic use, so this is only for tests and
+  // simulations.
+  void seed(result_type seed);
+
+  void useSystemEntropy();
+
   long int operator()(long int to) { return getRandomNumber(to); }
 
   result_type operator()()
@@ -41,21 +41,82 @@
 #include "Segment.h"
 #include "WrDiskCache.h"
 #include "Piece.h"
+#include "WrDiskCacheEntry.h"
+#include "Metrics.h"
 
 namespace aria2 {
 
 const std::string SinkStreamFilter::NAME("SinkStreamFilter");
 
+namespace {
+Counter* bytesCopiedCounter()
+{
+  static auto c = global::metrics().counter(
+      "aria2_disk_cache_copied_bytes_total",
+      "Number of received bytes copied into the disk cache.");
+  return c;
+}
+} // namespace
+
+namespace {
+Counter* bytesInPlaceCounter()
+{
+  static auto c = global::metrics().counter(
+      "aria2_disk_cache_in_place_bytes_total",
+      "Number of received bytes put into the disk cache without a copy.");
+  return c;
+}
+} // namespace
+
 SinkStreamFilter::SinkStreamFilter(WrDiskCache* wrDiskCache, bool hashUpdate)
-    : wrDiskCache_(wrDiskCache), hashUpdate_(hashUpdate), bytesProcessed_(0)
+    : wrDiskCache_(wrDiskCache),
+      hashUpdate_(hashUpdate),
+      bytesProcessed_(0),
+      lent_(nullptr),
+      bufCapacity_(0)
 {
 }
 
+unsigned char*
+SinkStreamFilter::reserve(const std::shared_ptr<Segment>& segment,
+                          size_t& len)
+{
+  lent_ = nullptr;
+  const std::shared_ptr<Piece>& piece = segment->getPiece();
+  if (!piece->getWrDiskCacheEntry()) {
+    return nullptr;
+  }
+  if (segment->getLength() > 0) {
+    len = std::min(len, static_cast<size_t>(segment->getLength() -
+                                            segment->getWrittenLength()));
+  }
+  if (len == 0) {
+    return nullptr;
+  }
+  size_t avail;
+  lent_ = piece->getWrDiskCacheEntry()->getAppendBuffer(
+      segment->getPositionToWrite(), avail);
+  if (lent_) {
+    len = std::min(len, avail);
+    return lent_;
+  }
+  // The same as transform(), the cell is at least 4KiB so that small
+  // reads are appended to it.
+  if (!buf_ || bufCapacity_ < len) {
+    bufCapacity_ = std::max(len, static_cast<size_t>(4_k));
+    buf_.reset(new unsigned char[bufCapacity_]);
+  }
+  lent_ = buf_.get();
+  return lent_;
+}
+
 ssize_t SinkStreamFilter::transform(const std::shared_ptr<BinaryStream>& out,
                                     const std::shared_ptr<Segment>& segment,
                                     const unsigned char* inbuf, size_t inlen)
 {
   size_t wlen;
+  bool inPlace = lent_ && inbuf == lent_;
+  lent_ = nullptr;
   if (inlen > 0) {
     if (segment->getLength() > 0) {
       // We must not write data larger than available space in
@@ -67,30 +128,46 @@ ssize_t SinkStreamFilter::transform(const std::shared_ptr<BinaryStream>& out,
     else {
       wlen = inlen;
     }
+    // Update the hash first, because caching the data may flush them
+    // and free the lent buffer.
+    if (hashUpdate_) {
+      segment->updateHash(segment->getWrittenLength(), inbuf, wlen);
+    }
     const std::shared_ptr<Piece>& piece = segment->getPiece();
     if (piece->getWrDiskCacheEntry()) {
       assert(wrDiskCache_);
-      // If we receive small data (e.g., 1 or 2 bytes), cache entry
-      // becomes a headache. To mitigate this problem, we allocate
-      // cache buffer at least 4KiB and append the data to the
-      // contagious cache data.
-      size_t alen = piece->appendWrCache(
-          wrDiskCache_, segment->getPositionToWrite(), inbuf, wlen);
-      if (alen < wlen) {
-        size_t len = wlen - alen;
-        size_t capacity = std::max(len, static_cast<size_t>(4_k));
-        auto dataCopy = new unsigned char[capacity];
-        memcpy(dataCopy, inbuf + alen, len);
-        piece->updateWrCache(wrDiskCache_, dataCopy, 0, len, capacity,
-                             segment->getPositionToWrite() + alen);
+      if (inPlace && inbuf == buf_.get()) {
+        piece->updateWrCache(wrDiskCache_, buf_.release(), 0, wlen,
+                             bufCapacity_, segment->getPositionToWrite());
+        bytesInPlaceCounter()->add(wlen);
+      }
+      else {
+        // If we receive small data (e.g., 1 or 2 bytes), cache entry
+        // becomes a headache. To mitigate this problem, we allocate
+        // cache buffer at least 4KiB and append the data to the
+        // contagious cache data.
+        size_t alen = piece->appendWrCache(
+            wrDiskCache_, segment->getPositionToWrite(), inbuf, wlen);
+        if (inPlace) {
+          bytesInPlaceCounter()->add(alen);
+        }
+        else {
+          bytesCopiedCounter()->add(alen);
+        }
+        if (alen < wlen) {
+          size_t len = wlen - alen;
+          size_t capacity = std::max(len, static_cast<size_t>(4_k));
+          auto dataCopy = new unsigned char[capacity];
+          memcpy(dataCopy, inbuf + alen, len);
+          piece->updateWrCache(wrDiskCache_, dataCopy, 0, len, capacity,
+                               segment->getPositionToWrite() + alen);
+          bytesCopiedCounter()->add(len);
+        }
       }
     }
     else {
       out->writeData(inbuf, wlen, segment->getPositionToWrite());
     }
-    if (hashUpdate_) {
-      segment->updateHash(segment->getWrittenLength(), inbuf, wlen);
-    }
     segment->updateWrittenLength(wlen);
   }
   else {
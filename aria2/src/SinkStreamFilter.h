@@ -46,6 +46,12 @@ private:
   WrDiskCache* wrDiskCache_;
   bool hashUpdate_;
   size_t bytesProcessed_;
+  // The buffer returned by the last reserve()
+  unsigned char* lent_;
+  // Buffer lent for a new cache cell, which is handed over to the
+  // cache when transform() receives it.
+  std::unique_ptr<unsigned char[]> buf_;
+  size_t bufCapacity_;
 
 public:
   SinkStreamFilter(WrDiskCache* wrDiskCache = nullptr, bool hashUpdate = false);
@@ -57,6 +63,12 @@ public:
                             const unsigned char* inbuf,
                             size_t inlen) CXX11_OVERRIDE;
 
+  // Lends the memory of the write disk cache of the piece of
+  // |segment|: the rest of its last cell if the data are contagious
+  // to it, or a new cell.  Returns nullptr if the piece has no cache.
+  virtual unsigned char* reserve(const std::shared_ptr<Segment>& segment,
+                                 size_t& len) CXX11_OVERRIDE;
+
   virtual bool finished() CXX11_OVERRIDE { return true; }
 
   virtual void release() CXX11_OVERRIDE {}
@@ -58,6 +58,7 @@
 #include "a2functional.h"
 #include "LogFactory.h"
 #include "A2STR.h"
+#include "Metrics.h"
 #ifdef ENABLE_SSL
 #  include "TLSContext.h"
 #  include "TLSSession.h"
@@ -116,6 +117,24 @@ std::string errorMsg(int errNum)
 }
 } // namespace
 
+namespace {
+Counter* bytesReadCounter()
+{
+  static auto c = global::metrics().counter(
+      "aria2_socket_read_bytes_total", "Number of bytes read from sockets.");
+  return c;
+}
+} // namespace
+
+namespace {
+Counter* bytesWrittenCounter()
+{
+  static auto c = global::metrics().counter(
+      "aria2_socket_written_bytes_total", "Number of bytes written to sockets.");
+  return c;
+}
+} // namespace
+
 namespace {
 enum TlsState {
   // TLS object is not initialized.
@@ -781,6 +800,7 @@ ssize_t SocketCore::writeVector(a2iovec* iov, size_t iovcnt)
       wantWrite_ = true;
       ret = 0;
     }
+    bytesWrittenCounter()->add(ret);
   }
   else {
     // For SSL/TLS, we could not use writev, so just iterate vector
@@ -835,6 +855,7 @@ ssize_t SocketCore::writeData(const void* data, size_t len)
     }
 #endif // ENABLE_SSL
   }
+  bytesWrittenCounter()->add(ret);
   return ret;
 }
 
@@ -897,6 +918,7 @@ void SocketCore::readData(void* data, size_t& len)
 #endif // ENABLE_SSL
     }
 
+  bytesReadCounter()->add(ret);
   len = ret;
 }
 
@@ -1094,14 +1116,14 @@ bool SocketCore::sshAuthPassword(const std::string& user,
   return true;
 }
 
-bool SocketCore::sshSFTPOpen(const std::string& path)
+bool SocketCore::sshSFTPOpen(const std::string& path, size_t readAhead)
 {
   assert(sshSession_);
 
   wantRead_ = false;
   wantWrite_ = false;
 
-  auto rv = sshSession_->sftpOpen(path);
+  auto rv = sshSession_->sftpOpen(path, readAhead);
   if (rv == SSH_ERR_WOULDBLOCK) {
     sshCheckDirection();
     return false;
@@ -1223,6 +1245,7 @@ ssize_t SocketCore::writeData(const void* data, size_t len,
   if (r == -1) {
     throw DL_ABORT_EX(fmt(EX_SOCKET_SEND, errorMsg(errNum).c_str()));
   }
+  bytesWrittenCounter()->add(r);
   return r;
 }
 
@@ -1248,6 +1271,7 @@ ssize_t SocketCore::readDataFrom(void* data, size_t len, Endpoint& sender)
   }
   else {
     sender = util::getNumericNameInfo(&sockaddr.sa, sockaddrlen);
+    bytesReadCounter()->add(r);
   }
 
   return r;
@@ -1336,6 +1360,12 @@ int SocketCore::getSocketRecvBufferSize() { return socketRecvBufferSize_; }
 
 size_t SocketCore::getRecvBufferedLength() const
 {
+#ifdef HAVE_LIBSSH2
+  if (sshSession_) {
+    return sshSession_->getRecvBufferedLength();
+  }
+#endif // HAVE_LIBSSH2
+
 #ifdef ENABLE_SSL
   if (!tlsSession_) {
     return 0;
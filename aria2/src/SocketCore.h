@@ -303,8 +303,9 @@ public:
   bool sshHandshake(const std::string& hashType, const std::string& digest);
   // Performs SSH authentication using username and password.
   bool sshAuthPassword(const std::string& user, const std::string& password);
-  // Starts sftp session and open remote file |path|.
-  bool sshSFTPOpen(const std::string& path);
+  // Starts sftp session and open remote file |path|.  Read requests
+  // for about |readAhead| bytes are kept in flight.
+  bool sshSFTPOpen(const std::string& path, size_t readAhead);
   // Closes sftp remote file gracefully
   bool sshSFTPClose();
   // Gets total length and modified time for remote file currently
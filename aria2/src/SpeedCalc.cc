@@ -34,6 +34,7 @@
 /* copyright --> */
 #include "SpeedCalc.h"
 
+#include <cassert>
 #include <algorithm>
 #include <functional>
 
@@ -45,11 +46,20 @@ namespace {
 constexpr auto WINDOW_TIME = 10_s;
 } // namespace
 
-SpeedCalc::SpeedCalc() : accumulatedLength_(0), bytesWindow_(0), maxSpeed_(0) {}
+SpeedCalc::SpeedCalc()
+    : first_(0),
+      numSlots_(0),
+      start_(global::wallclock()),
+      accumulatedLength_(0),
+      bytesWindow_(0),
+      maxSpeed_(0)
+{
+}
 
 void SpeedCalc::reset()
 {
-  timeSlots_.clear();
+  first_ = 0;
+  numSlots_ = 0;
   start_ = global::wallclock();
   accumulatedLength_ = 0;
   bytesWindow_ = 0;
@@ -58,12 +68,17 @@ void SpeedCalc::reset()
 
 void SpeedCalc::removeStaleTimeSlot(const Timer& now)
 {
-  while (!timeSlots_.empty()) {
-    if (timeSlots_[0].first.difference(now) <= WINDOW_TIME) {
+  // Timer::difference() is not inlined, and this is called for each
+  // update.  The time goes forward, so comparing time points directly
+  // is the same.
+  while (numSlots_ > 0) {
+    auto& slot = slotAt(0);
+    if (now.getTime() - slot.time.getTime() <= WINDOW_TIME) {
       break;
     }
-    bytesWindow_ -= timeSlots_[0].second;
-    timeSlots_.pop_front();
+    bytesWindow_ -= slot.bytes;
+    first_ = (first_ + 1) % MAX_SLOTS;
+    --numSlots_;
   }
 }
 
@@ -71,11 +86,11 @@ int SpeedCalc::calculateSpeed()
 {
   const auto& now = global::wallclock();
   removeStaleTimeSlot(now);
-  if (timeSlots_.empty()) {
+  if (numSlots_ == 0) {
     return 0;
   }
   auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                     timeSlots_[0].first.difference(now))
+                     slotAt(0).time.difference(now))
                      .count();
   if (elapsed <= 0) {
     elapsed = 1;
@@ -91,19 +106,20 @@ int SpeedCalc::calculateNewestSpeed(int seconds)
   removeStaleTimeSlot(now);
 
   int64_t bytesCount(0);
-  auto it = timeSlots_.rbegin();
-  while (it != timeSlots_.rend()) {
-    if (it->first.difference(now) > seconds * 1_s) {
+  size_t i = numSlots_;
+  for (; i > 0; --i) {
+    auto& slot = slotAt(i - 1);
+    if (slot.time.difference(now) > seconds * 1_s) {
       break;
     }
-    bytesCount += (*it++).second;
+    bytesCount += slot.bytes;
   }
-  if (it == timeSlots_.rbegin()) {
+  if (i == numSlots_) {
     return 0;
   }
 
   auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                     (*--it).first.difference(now))
+                     slotAt(i).time.difference(now))
                      .count();
   if (elapsed <= 0) {
     elapsed = 1;
@@ -115,13 +131,17 @@ void SpeedCalc::update(size_t bytes)
 {
   const auto& now = global::wallclock();
   removeStaleTimeSlot(now);
-  if (timeSlots_.empty() ||
-      std::chrono::duration_cast<std::chrono::seconds>(
-          timeSlots_.back().first.difference(now)) >= 1_s) {
-    timeSlots_.push_back(std::make_pair(now, bytes));
+  if (numSlots_ == 0 ||
+      now.getTime() - slotAt(numSlots_ - 1).time.getTime() >= 1_s) {
+    // Slots are at least 1 second apart, so the oldest one has been
+    // removed above if all slots are used.
+    assert(numSlots_ < MAX_SLOTS);
+    auto& slot = slotAt(numSlots_++);
+    slot.time = now;
+    slot.bytes = bytes;
   }
   else {
-    timeSlots_.back().second += bytes;
+    slotAt(numSlots_ - 1).bytes += bytes;
   }
   bytesWindow_ += bytes;
   accumulatedLength_ += bytes;
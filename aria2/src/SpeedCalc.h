@@ -37,20 +37,37 @@
 
 #include "common.h"
 
-#include <deque>
-
 #include "TimerA2.h"
 
 namespace aria2 {
 
 class SpeedCalc {
 private:
-  std::deque<std::pair<Timer, size_t>> timeSlots_;
+  // The bytes transferred in the last 10 seconds are counted in time
+  // slots.  A slot starts at the first update after the previous slot
+  // has lasted for 1 second, so that at most MAX_SLOTS slots are in
+  // the window.  The slots are stored in a ring buffer, the oldest at
+  // first_, so that update() takes constant time and never allocates
+  // memory.  The time is taken from global::wallclock(), which is
+  // updated once per event loop iteration.
+  struct TimeSlot {
+    Timer time = Timer::zero();
+    size_t bytes = 0;
+  };
+
+  static const size_t MAX_SLOTS = 11;
+
+  TimeSlot timeSlots_[MAX_SLOTS];
+  size_t first_;
+  size_t numSlots_;
   Timer start_;
   int64_t accumulatedLength_;
   int64_t bytesWindow_;
   int maxSpeed_;
 
+  // Returns i-th oldest slot in the window.
+  TimeSlot& slotAt(size_t i) { return timeSlots_[(first_ + i) % MAX_SLOTS]; }
+
   void removeStaleTimeSlot(const Timer& now);
 
 public:
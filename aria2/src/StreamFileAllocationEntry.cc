@@ -47,6 +47,9 @@
 #include "PieceStorage.h"
 #include "DiskAdaptor.h"
 #include "LogFactory.h"
+#include "RequestGroupMan.h"
+#include "PieceReuseCommand.h"
+#include "a2functional.h"
 
 namespace aria2 {
 
@@ -75,6 +78,9 @@ void StreamFileAllocationEntry::prepareForNextAction(
       diskAdaptor->size() <= option->getAsLLInt(PREF_MAX_MMAP_LIMIT)) {
     diskAdaptor->enableMmap();
   }
+  if (e->getRequestGroupMan()->getPieceHashIndex()) {
+    commands.push_back(make_unique<PieceReuseCommand>(e->newCUID(), rg, e));
+  }
   if (getNextCommand()) {
     // Reset download start time of PeerStat because it is started
     // before file allocation begins.
@@ -43,6 +43,12 @@ StreamFilter::StreamFilter(std::unique_ptr<StreamFilter> delegate)
 
 StreamFilter::~StreamFilter() = default;
 
+unsigned char* StreamFilter::reserve(const std::shared_ptr<Segment>& segment,
+                                     size_t& len)
+{
+  return nullptr;
+}
+
 bool StreamFilter::installDelegate(std::unique_ptr<StreamFilter> filter)
 {
   if (!delegate_) {
@@ -63,6 +63,15 @@ public:
                             const std::shared_ptr<Segment>& segment,
                             const unsigned char* inbuf, size_t inlen) = 0;
 
+  // Lends a buffer into which the caller can put up to |len| bytes of
+  // the next input for |segment|, so that passing them to transform()
+  // delivers them to the sink without a copy.  |len| is set to the
+  // size of the buffer.  The buffer is valid until the next call of
+  // transform().  Returns nullptr if the filter cannot take its input
+  // in place.  The default implementation returns nullptr.
+  virtual unsigned char* reserve(const std::shared_ptr<Segment>& segment,
+                                 size_t& len);
+
   virtual bool finished() = 0;
 
   // The call of release() will free allocated resources.
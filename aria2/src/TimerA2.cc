@@ -35,17 +35,54 @@
 
 #include "TimerA2.h"
 
+#include <time.h>
+
+#include <atomic>
+
 namespace aria2 {
 
 // Add this offset to Timer::Clock::now() so that we can treat 0 value
 // as special case, and normal timeout always applies.
 constexpr auto OFFSET = 24_h;
 
+Timer::Clock::time_point MonotonicTimeSource::now()
+{
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC_COARSE)
+  // Timer::Clock, that is std::chrono::steady_clock, reads
+  // CLOCK_MONOTONIC on Linux, and the coarse one counts from the same
+  // origin.
+  struct timespec ts;
+  if (clock_gettime(CLOCK_MONOTONIC_COARSE, &ts) == 0) {
+    return Timer::Clock::time_point(
+               std::chrono::duration_cast<Timer::Clock::duration>(
+                   std::chrono::seconds(ts.tv_sec) +
+                   std::chrono::nanoseconds(ts.tv_nsec))) +
+           OFFSET;
+  }
+#endif // HAVE_CLOCK_GETTIME && CLOCK_MONOTONIC_COARSE
+  return Timer::Clock::now() + OFFSET;
+}
+
+ManualTimeSource::ManualTimeSource() : tp_(OFFSET) {}
+
 namespace {
-Timer::Clock::time_point getNow() { return Timer::Clock::now() + OFFSET; }
+MonotonicTimeSource defaultTimeSource;
+std::atomic<TimeSource*> timeSource(&defaultTimeSource);
+} // namespace
+
+TimeSource* setTimeSource(TimeSource* source)
+{
+  return timeSource.exchange(source ? source : &defaultTimeSource);
+}
+
+namespace {
+Timer::Clock::time_point getNow()
+{
+  return timeSource.load(std::memory_order_relaxed)->now();
+}
 } // namespace
 
-Timer::Timer() : tp_(getNow()) { reset(); }
+Timer::Timer() : tp_(getNow()) {}
 
 Timer::Timer(const Clock::time_point& tp) : tp_(tp) {}
 
@@ -95,6 +95,46 @@ private:
   Clock::time_point tp_;
 };
 
+// Source of the current time of Timer.  All Timer objects read the
+// time from the installed source, so that tests and simulations can
+// control the time seen by the whole program.
+class TimeSource {
+public:
+  virtual ~TimeSource() = default;
+
+  virtual Timer::Clock::time_point now() = 0;
+};
+
+// The default time source.  It reads CLOCK_MONOTONIC_COARSE where
+// available, which is served from memory without a system call and
+// is precise to a few milliseconds.  This is enough for the timeouts
+// and speed calculation in aria2.  Otherwise it reads
+// Timer::Clock::now().
+class MonotonicTimeSource : public TimeSource {
+public:
+  virtual Timer::Clock::time_point now() CXX11_OVERRIDE;
+};
+
+// Time source which only moves when told to.  It starts at a fixed
+// time point, so that the runs using it are deterministic.
+class ManualTimeSource : public TimeSource {
+public:
+  ManualTimeSource();
+
+  virtual Timer::Clock::time_point now() CXX11_OVERRIDE { return tp_; }
+
+  template <typename duration> void advance(const duration& t) { tp_ += t; }
+
+private:
+  Timer::Clock::time_point tp_;
+};
+
+// Installs |source| as the time source of Timer and returns the
+// previous one.  If |source| is nullptr, MonotonicTimeSource is
+// installed.  The caller keeps the ownership of |source|, which must
+// outlive its use.
+TimeSource* setTimeSource(TimeSource* source);
+
 } // namespace aria2
 
 #endif // D_TIMER_A2_H
@@ -0,0 +1,150 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2013 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "TorrentIngestor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <system_error>
+#include <thread>
+
+#include "DownloadContext.h"
+#include "Option.h"
+#include "prefs.h"
+#include "ProtocolDetector.h"
+#include "ValueBaseBencodeParser.h"
+#include "DlAbortEx.h"
+#include "download_helper.h"
+#include "base64.h"
+#include "MessageDigest.h"
+#include "message_digest_helper.h"
+#include "util.h"
+#include "Metrics.h"
+
+namespace aria2 {
+
+namespace {
+Counter* torrentsIngestedCounter()
+{
+  static auto c = global::metrics().counter(
+      "aria2_torrent_ingest_total",
+      "Number of torrents parsed by the ingestion workers.");
+  return c;
+}
+} // namespace
+
+TorrentIngestJob::TorrentIngestJob() : base64(false) {}
+
+const size_t TorrentIngestor::MAX_THREADS;
+
+TorrentIngestor::TorrentIngestor(size_t numThreads) : numThreads_(numThreads)
+{
+  if (numThreads_ == 0) {
+    numThreads_ = std::min(
+        std::max(static_cast<size_t>(std::thread::hardware_concurrency()),
+                 static_cast<size_t>(1)),
+        MAX_THREADS);
+  }
+}
+
+void TorrentIngestor::run(std::vector<TorrentIngestJob>& jobs)
+{
+  std::atomic<size_t> next(0);
+  auto work = [&jobs, &next]() {
+    for (size_t i; (i = next++) < jobs.size();) {
+      ingestTorrent(jobs[i]);
+    }
+  };
+  auto numWorkers = std::min(numThreads_, jobs.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < numWorkers; ++i) {
+    try {
+      threads.emplace_back(work);
+    }
+    catch (std::system_error& e) {
+      // The threads started so far do the rest.
+      break;
+    }
+  }
+  work();
+  for (auto& t : threads) {
+    t.join();
+  }
+}
+
+void ingestTorrent(TorrentIngestJob& job)
+{
+  try {
+    std::unique_ptr<ValueBase> torrent;
+    bittorrent::ValueBaseBencodeParser parser;
+    if (job.data.empty()) {
+      if (!ProtocolDetector().guessTorrentFile(job.metaInfoUri)) {
+        return;
+      }
+      torrent = parseFile(parser, job.metaInfoUri);
+    }
+    else {
+      if (job.base64) {
+        job.data = base64::decode(std::begin(job.data), std::end(job.data));
+        job.base64 = false;
+      }
+      if (job.metaInfoUri.empty() &&
+          job.option->getAsBool(PREF_RPC_SAVE_UPLOAD_METADATA)) {
+        unsigned char hash[20];
+        message_digest::digest(hash, sizeof(hash),
+                               MessageDigest::sha1().get(), job.data.data(),
+                               job.data.size());
+        job.metaInfoUri =
+            util::applyDir(job.option->get(PREF_DIR),
+                           util::toHex(hash, sizeof(hash)) + ".torrent");
+      }
+      ssize_t error;
+      torrent = parser.parseFinal(job.data.c_str(), job.data.size(), error);
+    }
+    if (!torrent) {
+      throw DL_ABORT_EX2("Bencode decoding failed",
+                         error_code::BENCODE_PARSE_ERROR);
+    }
+    job.downloadContext = createBtDownloadContext(job.option, job.uris,
+                                                  job.metaInfoUri,
+                                                  torrent.get());
+    torrentsIngestedCounter()->inc();
+  }
+  catch (...) {
+    // Nothing may escape from a worker thread.
+    job.error = std::current_exception();
+  }
+}
+
+} // namespace aria2
@@ -0,0 +1,107 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2013 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_TORRENT_INGESTOR_H
+#define D_TORRENT_INGESTOR_H
+
+#include "common.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <exception>
+
+namespace aria2 {
+
+class DownloadContext;
+class Option;
+
+// A torrent to be parsed by TorrentIngestor.
+struct TorrentIngestJob {
+  // Path to the .torrent file.  If data is given, this is the name
+  // the torrent is loaded with, usually empty.
+  std::string metaInfoUri;
+  // Content of the uploaded torrent, Base64 encoded if base64 is
+  // true.  If empty, metaInfoUri is read instead, and the job is
+  // skipped unless the file looks like a .torrent file.
+  std::string data;
+  bool base64;
+  std::vector<std::string> uris;
+  // Option the download is created with.  It is only read while the
+  // job is parsed.
+  std::shared_ptr<Option> option;
+
+  // The parsed torrent.  nullptr if the job was skipped or failed.
+  std::shared_ptr<DownloadContext> downloadContext;
+  // The exception the parser threw, if any.  The caller rethrows it
+  // on the engine thread.
+  std::exception_ptr error;
+
+  TorrentIngestJob();
+};
+
+// Parses torrents on worker threads: reading the file, Base64 and
+// bencode decoding, the info hash, the piece hashes and the file
+// entries, which dominate the cost of adding torrents in bulk.  The
+// caller creates the RequestGroups from the parsed DownloadContexts
+// on the engine thread, since neither GroupId nor SimpleRandomizer
+// is thread-safe.  If the uploaded data of a job is parsed,
+// metaInfoUri is empty and --rpc-save-upload-metadata is true,
+// metaInfoUri is set to the path aria2.addTorrent saves the data to,
+// as the torrent is named after it if it lacks a name.
+class TorrentIngestor {
+public:
+  // If numThreads is 0, the number of the hardware threads is used,
+  // at most MAX_THREADS.
+  explicit TorrentIngestor(size_t numThreads = 0);
+
+  // Parses |jobs| and returns when all of them are done.  The worker
+  // threads only live while this function runs, and the calling
+  // thread is one of them.
+  void run(std::vector<TorrentIngestJob>& jobs);
+
+  size_t getNumThreads() const { return numThreads_; }
+
+  static const size_t MAX_THREADS = 16;
+
+private:
+  size_t numThreads_;
+};
+
+// Parses |job| on the calling thread.
+void ingestTorrent(TorrentIngestJob& job);
+
+} // namespace aria2
+
+#endif // D_TORRENT_INGESTOR_H
@@ -51,7 +51,10 @@ public:
     size_t index_;
     Timer dispatchedTime_;
 
-    RequestEntry(size_t index) : index_(index) {}
+    RequestEntry(size_t index)
+        : index_(index), dispatchedTime_(global::wallclock())
+    {
+    }
 
     bool elapsed(const std::chrono::seconds t) const
     {
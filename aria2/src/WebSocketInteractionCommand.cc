@@ -89,6 +89,12 @@ bool WebSocketInteractionCommand::execute()
   if (e_->isHaltRequested()) {
     return true;
   }
+  if (wsSession_->overflowed()) {
+    A2_LOG_INFO(fmt("CUID#%" PRId64 " - WebSocket session terminated"
+                    " (Send queue overflowed).",
+                    getCuid()));
+    return true;
+  }
   if (wsSession_->onReadEvent() == -1 || wsSession_->onWriteEvent() == -1) {
     if (wsSession_->closeSent() || wsSession_->closeReceived()) {
       A2_LOG_INFO(
@@ -45,8 +45,10 @@ namespace rpc {
 
 WebSocketResponseCommand::WebSocketResponseCommand(
     cuid_t cuid, const std::shared_ptr<HttpServer>& httpServer,
-    DownloadEngine* e, const std::shared_ptr<SocketCore>& socket)
-    : AbstractHttpServerResponseCommand(cuid, httpServer, e, socket)
+    DownloadEngine* e, const std::shared_ptr<SocketCore>& socket,
+    bool permessageDeflate)
+    : AbstractHttpServerResponseCommand(cuid, httpServer, e, socket),
+      permessageDeflate_(permessageDeflate)
 {
 }
 
@@ -55,8 +57,8 @@ WebSocketResponseCommand::~WebSocketResponseCommand() = default;
 void WebSocketResponseCommand::afterSend(
     const std::shared_ptr<HttpServer>& httpServer, DownloadEngine* e)
 {
-  auto wsSession = std::make_shared<WebSocketSession>(httpServer->getSocket(),
-                                                      getDownloadEngine());
+  auto wsSession = std::make_shared<WebSocketSession>(
+      httpServer->getSocket(), getDownloadEngine(), permessageDeflate_);
   auto command = make_unique<WebSocketInteractionCommand>(
       getCuid(), wsSession, e, wsSession->getSocket());
   wsSession->setCommand(command.get());
@@ -42,6 +42,9 @@ namespace aria2 {
 namespace rpc {
 
 class WebSocketResponseCommand : public AbstractHttpServerResponseCommand {
+private:
+  bool permessageDeflate_;
+
 protected:
   virtual void afterSend(const std::shared_ptr<HttpServer>& httpServer,
                          DownloadEngine* e) CXX11_OVERRIDE;
@@ -50,7 +53,8 @@ public:
   WebSocketResponseCommand(cuid_t cuid,
                            const std::shared_ptr<HttpServer>& httpServer,
                            DownloadEngine* e,
-                           const std::shared_ptr<SocketCore>& socket);
+                           const std::shared_ptr<SocketCore>& socket,
+                           bool permessageDeflate = false);
 
   virtual ~WebSocketResponseCommand();
 };
@@ -50,26 +50,43 @@
 #include "json.h"
 #include "prefs.h"
 #include "Option.h"
+#include "WebSocketSessionMan.h"
+#include "Metrics.h"
+#include "fmt.h"
+#ifdef HAVE_ZLIB
+#  include "PermessageDeflate.h"
+#endif // HAVE_ZLIB
 
 namespace aria2 {
 
 namespace rpc {
 
+namespace {
+// The frames queued in a tick are written to the socket together up
+// to this length.
+const size_t OUTPUT_BUFFER_LENGTH = 16_k;
+} // namespace
+
+namespace {
+Counter* droppedNotificationCounter()
+{
+  static auto c = global::metrics().counter(
+      "aria2_websocket_notifications_dropped_total",
+      "Number of WebSocket notifications dropped because the send queue "
+      "of the session was full");
+  return c;
+}
+} // namespace
+
 namespace {
 ssize_t sendCallback(wslay_event_context_ptr wsctx, const uint8_t* data,
                      size_t len, int flags, void* userData)
 {
   WebSocketSession* session = reinterpret_cast<WebSocketSession*>(userData);
-  const std::shared_ptr<SocketCore>& socket = session->getSocket();
   try {
-    ssize_t r = socket->writeData(data, len);
+    ssize_t r = session->bufferOutput(data, len);
     if (r == 0) {
-      if (socket->wantRead() || socket->wantWrite()) {
-        wslay_event_set_error(wsctx, WSLAY_ERR_WOULDBLOCK);
-      }
-      else {
-        wslay_event_set_error(wsctx, WSLAY_ERR_CALLBACK_FAILURE);
-      }
+      wslay_event_set_error(wsctx, WSLAY_ERR_WOULDBLOCK);
       r = -1;
     }
     return r;
@@ -113,6 +130,17 @@ ssize_t recvCallback(wslay_event_context_ptr wsctx, uint8_t* buf, size_t len,
 }
 } // namespace
 
+namespace {
+ssize_t notificationReadCallback(wslay_event_context_ptr wsctx, uint8_t* buf,
+                                 size_t len,
+                                 const union wslay_event_msg_source* source,
+                                 int* eof, void* userData)
+{
+  WebSocketSession* session = reinterpret_cast<WebSocketSession*>(userData);
+  return session->readNotification(buf, len, eof);
+}
+} // namespace
+
 namespace {
 void addResponse(WebSocketSession* wsSession, const RpcResponse& res)
 {
@@ -139,6 +167,11 @@ void onFrameRecvStartCallback(
 {
   WebSocketSession* wsSession = reinterpret_cast<WebSocketSession*>(userData);
   wsSession->setIgnorePayload(wslay_is_ctrl_frame(arg->opcode));
+  // RSV1 of the first frame tells whether the message is compressed.
+  if (!wslay_is_ctrl_frame(arg->opcode) &&
+      arg->opcode != WSLAY_CONTINUATION_FRAME) {
+    wsSession->setCompressed(wslay_get_rsv1(arg->rsv));
+  }
 }
 } // namespace
 
@@ -149,9 +182,8 @@ void onFrameRecvChunkCallback(
 {
   WebSocketSession* wsSession = reinterpret_cast<WebSocketSession*>(userData);
   if (!wsSession->getIgnorePayload()) {
-    // The return value is ignored here. It will be evaluated in
-    // onMsgRecvCallback.
-    wsSession->parseUpdate(arg->data, arg->data_length);
+    // The result of parsing is evaluated in onMsgRecvCallback.
+    wsSession->receivePayload(arg->data, arg->data_length);
   }
 }
 } // namespace
@@ -165,7 +197,7 @@ void onMsgRecvCallback(wslay_event_context_ptr wsctx,
   if (!wslay_is_ctrl_frame(arg->opcode)) {
     // TODO Only process text frame
     ssize_t error = 0;
-    auto json = wsSession->parseFinal(nullptr, 0, error);
+    auto json = wsSession->receiveFinal(error);
     if (error < 0) {
       A2_LOG_INFO("Failed to parse JSON-RPC request");
       RpcResponse res(
@@ -176,7 +208,8 @@ void onMsgRecvCallback(wslay_event_context_ptr wsctx,
     Dict* jsondict = downcast<Dict>(json);
     auto e = wsSession->getDownloadEngine();
     if (jsondict) {
-      RpcResponse res = processJsonRpcRequest(jsondict, e);
+      RpcResponse res =
+          processJsonRpcRequest(jsondict, e, wsSession->getTokenCache());
       addResponse(wsSession, res);
     }
     else {
@@ -189,7 +222,8 @@ void onMsgRecvCallback(wslay_event_context_ptr wsctx,
              i != eoi; ++i) {
           Dict* jsondict = downcast<Dict>(*i);
           if (jsondict) {
-            auto resp = processJsonRpcRequest(jsondict, e);
+            auto resp =
+                processJsonRpcRequest(jsondict, e, wsSession->getTokenCache());
             results.push_back(std::move(resp));
           }
         }
@@ -211,12 +245,23 @@ void onMsgRecvCallback(wslay_event_context_ptr wsctx,
 } // namespace
 
 WebSocketSession::WebSocketSession(const std::shared_ptr<SocketCore>& socket,
-                                   DownloadEngine* e)
+                                   DownloadEngine* e, bool permessageDeflate)
     : socket_(socket),
       e_(e),
+      permessageDeflate_(permessageDeflate),
+      compressed_(false),
+      inflateError_(false),
+      overflowed_(false),
+      maxSendQueueSize_(
+          e->getOption()->getAsInt(PREF_RPC_MAX_SEND_QUEUE_SIZE)),
+      closeOnOverflow_(e->getOption()->get(PREF_RPC_SEND_QUEUE_OVERFLOW) ==
+                       V_CLOSE),
       ignorePayload_(false),
       receivedLength_(0),
-      command_(nullptr)
+      command_(nullptr),
+      notificationLength_(0),
+      outbufOffset_(0),
+      writeBlocked_(false)
 {
   wslay_event_callbacks callbacks;
   memset(&callbacks, 0, sizeof(wslay_event_callbacks));
@@ -229,13 +274,24 @@ WebSocketSession::WebSocketSession(const std::shared_ptr<SocketCore>& socket,
   int r = wslay_event_context_server_init(&wsctx_, &callbacks, this);
   assert(r == 0);
   wslay_event_config_set_no_buffering(wsctx_, 1);
+#ifdef HAVE_ZLIB
+  if (permessageDeflate_) {
+    wslay_event_config_set_allowed_rsv_bits(wsctx_, WSLAY_RSV1_BIT);
+    inflater_ = make_unique<PermessageInflater>();
+  }
+#else  // !HAVE_ZLIB
+  permessageDeflate_ = false;
+#endif // !HAVE_ZLIB
 }
 
 WebSocketSession::~WebSocketSession() { wslay_event_context_free(wsctx_); }
 
 bool WebSocketSession::wantRead() { return wslay_event_want_read(wsctx_); }
 
-bool WebSocketSession::wantWrite() { return wslay_event_want_write(wsctx_); }
+bool WebSocketSession::wantWrite()
+{
+  return wslay_event_want_write(wsctx_) || outbufOffset_ < outbuf_.size();
+}
 
 bool WebSocketSession::finish() { return !wantRead() && !wantWrite(); }
 
@@ -251,14 +307,50 @@ int WebSocketSession::onReadEvent()
 
 int WebSocketSession::onWriteEvent()
 {
-  if (wslay_event_send(wsctx_) == 0) {
+  try {
+    if (!flushOutput()) {
+      return 0;
+    }
+    if (wslay_event_send(wsctx_) != 0) {
+      return -1;
+    }
+    flushOutput();
     return 0;
   }
-  else {
+  catch (RecoverableException& e) {
+    A2_LOG_DEBUG_EX(EX_EXCEPTION_CAUGHT, e);
     return -1;
   }
 }
 
+ssize_t WebSocketSession::bufferOutput(const uint8_t* data, size_t len)
+{
+  if (writeBlocked_ ||
+      (outbuf_.size() >= OUTPUT_BUFFER_LENGTH && !flushOutput())) {
+    return 0;
+  }
+  len = std::min(len, OUTPUT_BUFFER_LENGTH - outbuf_.size());
+  outbuf_.append(data, data + len);
+  return len;
+}
+
+bool WebSocketSession::flushOutput()
+{
+  while (outbufOffset_ < outbuf_.size()) {
+    ssize_t r = socket_->writeData(outbuf_.data() + outbufOffset_,
+                                   outbuf_.size() - outbufOffset_);
+    if (r == 0) {
+      writeBlocked_ = true;
+      return false;
+    }
+    outbufOffset_ += r;
+  }
+  outbuf_.clear();
+  outbufOffset_ = 0;
+  writeBlocked_ = false;
+  return true;
+}
+
 namespace {
 class TextMessageCommand : public Command {
 private:
@@ -290,14 +382,83 @@ void WebSocketSession::addTextMessage(const std::string& msg, bool delayed)
     return;
   }
 
-  // TODO Don't add text message if the size of outbound queue in
-  // wsctx_ exceeds certain limit.
+#ifdef HAVE_ZLIB
+  if (permessageDeflate_) {
+    auto payload = e_->getWebSocketSessionMan()->deflate(msg);
+    wslay_event_msg arg = {WSLAY_TEXT_FRAME,
+                           reinterpret_cast<const uint8_t*>(payload.c_str()),
+                           payload.size()};
+    wslay_event_queue_msg_ex(wsctx_, &arg, WSLAY_RSV1_BIT);
+    return;
+  }
+#endif // HAVE_ZLIB
   wslay_event_msg arg = {WSLAY_TEXT_FRAME,
                          reinterpret_cast<const uint8_t*>(msg.c_str()),
                          msg.size()};
   wslay_event_queue_msg(wsctx_, &arg);
 }
 
+size_t WebSocketSession::getQueuedLength()
+{
+  return wslay_event_get_queued_msg_length(wsctx_) + notificationLength_ +
+         outbuf_.size() - outbufOffset_;
+}
+
+bool WebSocketSession::addNotification(
+    const std::shared_ptr<const std::string>& payload, bool compressed)
+{
+  if (overflowed_) {
+    return false;
+  }
+  if (maxSendQueueSize_ > 0 &&
+      getQueuedLength() + payload->size() > maxSendQueueSize_) {
+    if (closeOnOverflow_) {
+      overflowed_ = true;
+      // The socket may never become readable nor writable, so wake up
+      // the command to close the connection.
+      command_->setStatusActive();
+      e_->setNoWait(true);
+    }
+    else {
+      A2_LOG_DEBUG(fmt("CUID#%" PRId64 " - WebSocket send queue is full."
+                       " Dropped a notification.",
+                       command_->getCuid()));
+      droppedNotificationCounter()->inc();
+    }
+    return false;
+  }
+  notifications_.push_back(Notification{payload, 0});
+  wslay_event_fragmented_msg arg;
+  memset(&arg, 0, sizeof(arg));
+  arg.opcode = WSLAY_TEXT_FRAME;
+  arg.source.data = &notifications_.back();
+  arg.read_callback = notificationReadCallback;
+  if (wslay_event_queue_fragmented_msg_ex(wsctx_, &arg,
+                                          compressed ? WSLAY_RSV1_BIT : 0) !=
+      0) {
+    notifications_.pop_back();
+    return false;
+  }
+  notificationLength_ += payload->size();
+  return true;
+}
+
+ssize_t WebSocketSession::readNotification(uint8_t* buf, size_t len, int* eof)
+{
+  assert(!notifications_.empty());
+  auto& notification = notifications_.front();
+  auto& payload = *notification.payload;
+  len = std::min(len, payload.size() - notification.offset);
+  memcpy(buf, payload.data() + notification.offset, len);
+  notification.offset += len;
+  notificationLength_ -= len;
+  if (notification.offset == payload.size()) {
+    *eof = 1;
+    notifications_.pop_front();
+  }
+  return len;
+}
+
 bool WebSocketSession::closeReceived()
 {
   return wslay_event_get_close_received(wsctx_);
@@ -330,6 +491,49 @@ WebSocketSession::parseFinal(const uint8_t* data, size_t len, ssize_t& error)
   return res;
 }
 
+void WebSocketSession::receivePayload(const uint8_t* data, size_t len)
+{
+#ifdef HAVE_ZLIB
+  if (compressed_) {
+    if (inflateError_) {
+      return;
+    }
+    size_t maxlen = e_->getOption()->getAsInt(PREF_RPC_MAX_REQUEST_SIZE);
+    std::string out;
+    if (!inflater_->inflate(out, data, len, maxlen - receivedLength_)) {
+      inflateError_ = true;
+      return;
+    }
+    parseUpdate(reinterpret_cast<const uint8_t*>(out.data()), out.size());
+    return;
+  }
+#endif // HAVE_ZLIB
+  parseUpdate(data, len);
+}
+
+std::unique_ptr<ValueBase> WebSocketSession::receiveFinal(ssize_t& error)
+{
+#ifdef HAVE_ZLIB
+  if (compressed_) {
+    size_t maxlen = e_->getOption()->getAsInt(PREF_RPC_MAX_REQUEST_SIZE);
+    std::string out;
+    if (!inflateError_ && !inflater_->finish(out, maxlen - receivedLength_)) {
+      inflateError_ = true;
+    }
+    if (inflateError_) {
+      // The inflater cannot decompress the following messages either.
+      parseFinal(nullptr, 0, error);
+      error = -1;
+      wslay_event_queue_close(wsctx_, WSLAY_CODE_MESSAGE_TOO_BIG, nullptr, 0);
+      return nullptr;
+    }
+    return parseFinal(reinterpret_cast<const uint8_t*>(out.data()),
+                      out.size(), error);
+  }
+#endif // HAVE_ZLIB
+  return parseFinal(nullptr, 0, error);
+}
+
 } // namespace rpc
 
 } // namespace aria2
@@ -38,10 +38,13 @@
 #include "common.h"
 
 #include <memory>
+#include <deque>
+#include <string>
 
 #include <wslay/wslay.h>
 
 #include "ValueBaseJsonParser.h"
+#include "AuthTokenCache.h"
 
 namespace aria2 {
 
@@ -51,11 +54,16 @@ class DownloadEngine;
 namespace rpc {
 
 class WebSocketInteractionCommand;
+#ifdef HAVE_ZLIB
+class PermessageInflater;
+#endif // HAVE_ZLIB
 
 class WebSocketSession {
 public:
+  // If |permessageDeflate| is true, permessage-deflate extension was
+  // negotiated in the opening handshake.
   WebSocketSession(const std::shared_ptr<SocketCore>& socket,
-                   DownloadEngine* e);
+                   DownloadEngine* e, bool permessageDeflate = false);
   ~WebSocketSession();
   // Returns true if this session object wants to read data from the
   // remote endpoint.
@@ -75,6 +83,27 @@ public:
   // Adds text message |msg|. The message is queued and will be sent
   // in onWriteEvent().
   void addTextMessage(const std::string& msg, bool delayed);
+  // Adds notification |payload|, which may be shared with other
+  // sessions.  If |compressed| is true, |payload| is compressed with
+  // permessage-deflate.  If queueing it would exceed
+  // --rpc-max-send-queue-size, the notification is dropped, or the
+  // session is marked overflowed for --rpc-send-queue-overflow=close.
+  // Returns true if the notification is queued.
+  bool addNotification(const std::shared_ptr<const std::string>& payload,
+                       bool compressed);
+  // Returns the number of bytes queued to send.
+  size_t getQueuedLength();
+  // Returns true if the send queue overflowed, and the connection
+  // should be closed.
+  bool overflowed() const { return overflowed_; }
+  // Copies the next part of the front notification to |buf| of length
+  // |len|, and returns the number of bytes copied.  Sets |eof| to 1 if
+  // it is the end of the notification.
+  ssize_t readNotification(uint8_t* buf, size_t len, int* eof);
+  // Appends data to the output buffer, which is written to the socket
+  // at once in onWriteEvent().  Returns the number of bytes appended,
+  // or 0 if the buffer is full and the socket is not writable.
+  ssize_t bufferOutput(const uint8_t* data, size_t len);
   // Returns true if the close frame is received.
   bool closeReceived();
   // Returns true if the close frame is sent.
@@ -88,6 +117,12 @@ public:
   // this function resets parser state and receivedLength_.
   std::unique_ptr<ValueBase> parseFinal(const uint8_t* data, size_t len,
                                         ssize_t& error);
+  // Feeds the payload of a received data frame to parseUpdate(),
+  // inflating it if the message is compressed.
+  void receivePayload(const uint8_t* data, size_t len);
+  // Parses the rest of the received message and returns the result,
+  // as parseFinal() does.
+  std::unique_ptr<ValueBase> receiveFinal(ssize_t& error);
 
   const std::shared_ptr<SocketCore>& getSocket() const { return socket_; }
 
@@ -101,14 +136,54 @@ public:
 
   void setIgnorePayload(bool flag) { ignorePayload_ = flag; }
 
+  bool getPermessageDeflate() const { return permessageDeflate_; }
+
+  // Sets whether the message being received is compressed.
+  void setCompressed(bool flag) { compressed_ = flag; }
+
+  AuthTokenCache* getTokenCache() { return &tokenCache_; }
+
 private:
+  // Writes the output buffer to the socket.  Returns true if all of
+  // it is written.
+  bool flushOutput();
+
+  struct Notification {
+    std::shared_ptr<const std::string> payload;
+    size_t offset;
+  };
+
   std::shared_ptr<SocketCore> socket_;
   DownloadEngine* e_;
   wslay_event_context_ptr wsctx_;
+  bool permessageDeflate_;
+#ifdef HAVE_ZLIB
+  std::unique_ptr<PermessageInflater> inflater_;
+#endif // HAVE_ZLIB
+  bool compressed_;
+  // True if inflating the message being received failed.
+  bool inflateError_;
+  bool overflowed_;
+  // --rpc-max-send-queue-size and --rpc-send-queue-overflow=close
+  size_t maxSendQueueSize_;
+  bool closeOnOverflow_;
   bool ignorePayload_;
   int32_t receivedLength_;
   json::ValueBaseJsonParser parser_;
   WebSocketInteractionCommand* command_;
+  // RPC secret token which last passed the validation on this
+  // session
+  AuthTokenCache tokenCache_;
+  // Notifications queued in wsctx_, in the order they are sent.
+  std::deque<Notification> notifications_;
+  // Number of bytes in notifications_ which are not sent yet.
+  size_t notificationLength_;
+  // Frames to be written to the socket.  Once a write of it is
+  // blocked, nothing is appended until it is written, so that TLS can
+  // retry the write with the same buffer.
+  std::string outbuf_;
+  size_t outbufOffset_;
+  bool writeBlocked_;
 };
 
 } // namespace rpc
@@ -42,6 +42,9 @@
 #include "util.h"
 #include "WebSocketInteractionCommand.h"
 #include "LogFactory.h"
+#ifdef HAVE_ZLIB
+#  include "PermessageDeflate.h"
+#endif // HAVE_ZLIB
 
 namespace aria2 {
 
@@ -76,13 +79,34 @@ void WebSocketSessionMan::addNotification(const std::string& method,
   auto params = List::g();
   params->append(std::move(eventSpec));
   dict->put("params", std::move(params));
-  std::string msg = json::encode(dict.get());
+  auto msg = std::make_shared<std::string>(json::encode(dict.get()));
+  std::shared_ptr<std::string> deflated;
   for (auto& session : sessions_) {
-    session->addTextMessage(msg, false);
+    if (session->getPermessageDeflate()) {
+#ifdef HAVE_ZLIB
+      if (!deflated) {
+        deflated = std::make_shared<std::string>(deflate(*msg));
+      }
+#endif // HAVE_ZLIB
+      session->addNotification(deflated, true);
+    }
+    else {
+      session->addNotification(msg, false);
+    }
     session->getCommand()->updateWriteCheck();
   }
 }
 
+#ifdef HAVE_ZLIB
+std::string WebSocketSessionMan::deflate(const std::string& msg)
+{
+  if (!deflater_) {
+    deflater_ = make_unique<PermessageDeflater>();
+  }
+  return deflater_->deflate(msg);
+}
+#endif // HAVE_ZLIB
+
 namespace {
 // The string constants for download events.
 const std::string ON_DOWNLOAD_START = "aria2.onDownloadStart";
@@ -50,6 +50,9 @@ class RequestGroup;
 namespace rpc {
 
 class WebSocketSession;
+#ifdef HAVE_ZLIB
+class PermessageDeflater;
+#endif // HAVE_ZLIB
 
 class WebSocketSessionMan : public DownloadEventListener {
 public:
@@ -59,12 +62,23 @@ public:
   ~WebSocketSessionMan();
   void addSession(const std::shared_ptr<WebSocketSession>& wsSession);
   void removeSession(const std::shared_ptr<WebSocketSession>& wsSession);
+  // Sends the notification |method| of |group| to all sessions.  The
+  // notification is encoded, and compressed for the sessions which
+  // negotiated permessage-deflate, only once.
   void addNotification(const std::string& method, const RequestGroup* group);
   virtual void onEvent(DownloadEvent event,
                        const RequestGroup* group) CXX11_OVERRIDE;
+#ifdef HAVE_ZLIB
+  // Returns |msg| compressed with permessage-deflate.  The result can
+  // be sent to any session which negotiated it.
+  std::string deflate(const std::string& msg);
+#endif // HAVE_ZLIB
 
 private:
   WebSocketSessions sessions_;
+#ifdef HAVE_ZLIB
+  std::unique_ptr<PermessageDeflater> deflater_;
+#endif // HAVE_ZLIB
 };
 
 } // namespace rpc
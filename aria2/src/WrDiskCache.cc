@@ -39,16 +39,28 @@
 #include "WrDiskCacheEntry.h"
 #include "LogFactory.h"
 #include "fmt.h"
+#include "Metrics.h"
 
 namespace aria2 {
 
-WrDiskCache::WrDiskCache(size_t limit) : limit_(limit), total_(0), clock_(0) {}
+WrDiskCache::WrDiskCache(size_t limit)
+    : limit_(limit),
+      total_(0),
+      clock_(0),
+      sizeGauge_(global::metrics().gauge("aria2_disk_cache_bytes",
+                                         "Number of bytes in the disk cache.")),
+      evictionCounter_(global::metrics().counter(
+          "aria2_disk_cache_evictions_total",
+          "Number of cache entries flushed because the cache is full."))
+{
+}
 
 WrDiskCache::~WrDiskCache()
 {
   if (total_) {
     A2_LOG_WARN(fmt("Write disk cache is not empty size=%lu",
                     static_cast<unsigned long>(total_)));
+    sizeGauge_->add(-static_cast<int64_t>(total_));
   }
 }
 
@@ -59,6 +71,7 @@ bool WrDiskCache::add(WrDiskCacheEntry* ent)
   std::pair<EntrySet::iterator, bool> rv = set_.insert(ent);
   if (rv.second) {
     total_ += ent->getSize();
+    sizeGauge_->add(ent->getSize());
     ensureLimit();
     return true;
   }
@@ -80,6 +93,7 @@ bool WrDiskCache::remove(WrDiskCacheEntry* ent)
                      static_cast<unsigned long>(ent->getSize()),
                      ent->getLastUpdate()));
     total_ -= ent->getSize();
+    sizeGauge_->add(-static_cast<int64_t>(ent->getSize()));
     return true;
   }
   else {
@@ -104,6 +118,7 @@ bool WrDiskCache::update(WrDiskCacheEntry* ent, ssize_t delta)
     assert(total_ >= static_cast<size_t>(-delta));
   }
   total_ += delta;
+  sizeGauge_->add(delta);
   ensureLimit();
   return true;
 }
@@ -117,6 +132,8 @@ void WrDiskCache::ensureLimit()
                      static_cast<unsigned long>(ent->getSizeKey()),
                      ent->getLastUpdate()));
     total_ -= ent->getSize();
+    sizeGauge_->add(-static_cast<int64_t>(ent->getSize()));
+    evictionCounter_->inc();
     ent->writeToDisk();
     set_.erase(i);
 
@@ -44,6 +44,8 @@
 namespace aria2 {
 
 class WrDiskCacheEntry;
+class Gauge;
+class Counter;
 
 class WrDiskCache {
 public:
@@ -72,6 +74,10 @@ private:
   size_t total_;
   EntrySet set_;
   int64_t clock_;
+  // Current number of bytes cached.  Shared by all instances.
+  Gauge* sizeGauge_;
+  // The number of entries flushed because the cache is full.
+  Counter* evictionCounter_;
 };
 
 } // namespace aria2
@@ -41,6 +41,7 @@
 #include "DownloadFailureException.h"
 #include "LogFactory.h"
 #include "fmt.h"
+#include "Metrics.h"
 
 namespace aria2 {
 
@@ -74,8 +75,36 @@ void WrDiskCacheEntry::deleteDataCells()
   size_ = 0;
 }
 
+namespace {
+struct FlushMetrics {
+  FlushMetrics()
+      : latency(global::metrics().histogram(
+            "aria2_disk_cache_flush_seconds",
+            "Time spent writing one cache entry to the disk.", 1e-6)),
+        bytes(global::metrics().counter(
+            "aria2_disk_cache_flushed_bytes_total",
+            "Number of bytes written from the disk cache."))
+  {
+  }
+
+  Histogram* latency;
+  Counter* bytes;
+};
+} // namespace
+
+namespace {
+FlushMetrics& flushMetrics()
+{
+  static FlushMetrics m;
+  return m;
+}
+} // namespace
+
 void WrDiskCacheEntry::writeToDisk()
 {
+  auto& metrics = flushMetrics();
+  auto start = std::chrono::steady_clock::now();
+  metrics.bytes->add(size_);
   try {
     diskAdaptor_->writeCache(this);
   }
@@ -85,6 +114,7 @@ void WrDiskCacheEntry::writeToDisk()
     errorCode_ = e.getErrorCode();
   }
   deleteDataCells();
+  metrics.latency->recordSince(start);
 }
 
 void WrDiskCacheEntry::clear() { deleteDataCells(); }
@@ -112,7 +142,10 @@ size_t WrDiskCacheEntry::append(int64_t goff, const unsigned char* data,
   --i;
   if (static_cast<int64_t>((*i)->goff + (*i)->len) == goff) {
     size_t wlen = std::min((*i)->capacity - (*i)->len, len);
-    memcpy((*i)->data + (*i)->offset + (*i)->len, data, wlen);
+    auto dst = (*i)->data + (*i)->offset + (*i)->len;
+    if (dst != data) {
+      memcpy(dst, data, wlen);
+    }
     (*i)->len += wlen;
     size_ += wlen;
     return wlen;
@@ -122,4 +155,18 @@ size_t WrDiskCacheEntry::append(int64_t goff, const unsigned char* data,
   }
 }
 
+unsigned char* WrDiskCacheEntry::getAppendBuffer(int64_t goff, size_t& len)
+{
+  if (set_.empty()) {
+    return nullptr;
+  }
+  auto cell = *set_.rbegin();
+  if (static_cast<int64_t>(cell->goff + cell->len) != goff ||
+      cell->len == cell->capacity) {
+    return nullptr;
+  }
+  len = cell->capacity - cell->len;
+  return cell->data + cell->offset + cell->len;
+}
+
 } // namespace aria2
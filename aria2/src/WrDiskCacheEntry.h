@@ -77,9 +77,16 @@ public:
   bool cacheData(DataCell* dataCell);
 
   // Appends into last dataCell in set_ if the region is
-  // contagious. Returns the number of copied bytes.
+  // contagious. Returns the number of copied bytes.  If |data| is the
+  // buffer returned by getAppendBuffer(), the data are already in
+  // place and not copied.
   size_t append(int64_t goff, const unsigned char* data, size_t len);
 
+  // Returns the unused memory after the last dataCell in set_ if the
+  // region at |goff| is contagious to it, and stores its size in
+  // |len|.  Otherwise returns nullptr.
+  unsigned char* getAppendBuffer(int64_t goff, size_t& len);
+
   size_t getSize() const { return size_; }
   void setSizeKey(size_t sizeKey) { sizeKey_ = sizeKey; }
   size_t getSizeKey() const { return sizeKey_; }
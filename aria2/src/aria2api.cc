@@ -35,6 +35,8 @@
 #include "aria2api.h"
 
 #include <functional>
+#include <future>
+#include <atomic>
 
 #include "Platform.h"
 #include "Context.h"
@@ -62,6 +64,9 @@
 #include "SingletonHolder.h"
 #include "Notifier.h"
 #include "ApiCallbackDownloadEventListener.h"
+#include "ApiCallQueue.h"
+#include "ApiCallCommand.h"
+#include "DataSinkDiskWriter.h"
 #ifdef ENABLE_BITTORRENT
 #  include "bittorrent_helper.h"
 #endif // ENABLE_BITTORRENT
@@ -69,7 +74,9 @@
 namespace aria2 {
 
 Session::Session(const KeyVals& options)
-    : context(std::make_shared<Context>(false, 0, nullptr, options))
+    : context(std::make_shared<Context>(false, 0, nullptr, options)),
+      keepRunning(false),
+      background(false)
 {
 }
 
@@ -83,10 +90,49 @@ SessionConfig::SessionConfig()
 {
 }
 
+std::shared_ptr<const ApiStatSnapshot> Session::getSnapshot() const
+{
+  return std::atomic_load(&snapshot);
+}
+
 namespace {
 Platform* platform = nullptr;
 } // namespace
 
+namespace {
+// Runs |func| on the engine thread and returns its result.  If the
+// session does not run in RUN_FOREVER mode, or the caller is the
+// engine thread, |func| is just called.  Otherwise, |func| is queued
+// and this function blocks until the engine thread runs it.  The
+// statistics snapshot is published before this function returns, so
+// that the caller sees the effect of |func| in it.
+template <typename T>
+T callOnEngine(Session* session, const std::function<T()>& func)
+{
+  if (!session->isForeignThread()) {
+    return func();
+  }
+  auto promise = std::make_shared<std::promise<T>>();
+  auto future = promise->get_future();
+  if (!session->callQueue->push([session, &func, promise]() {
+        try {
+          T res = func();
+          session->publishSnapshot();
+          promise->set_value(std::move(res));
+        }
+        catch (...) {
+          promise->set_exception(std::current_exception());
+        }
+      })) {
+    // The engine thread has finished its event loop.  Nobody touches
+    // the engine except for the API callers now.
+    std::lock_guard<std::mutex> lock(session->directCallMutex);
+    return func();
+  }
+  return future.get();
+}
+} // namespace
+
 int libraryInit()
 {
   global::initConsole(true);
@@ -127,6 +173,7 @@ Session* sessionNew(const KeyVals& options, const SessionConfig& config)
     }
     auto& e = session->context->reqinfo->getDownloadEngine();
     if (config.keepRunning) {
+      session->keepRunning = true;
       e->getRequestGroupMan()->setKeepRunning(true);
       // Add command to make aria2 keep event polling
       e->addCommand(make_unique<KeepRunningCommand>(e->newCUID(), e.get()));
@@ -146,32 +193,107 @@ Session* sessionNew(const KeyVals& options, const SessionConfig& config)
 
 int sessionFinal(Session* session)
 {
+  if (session->background) {
+    if (session->isForeignThread()) {
+      shutdown(session, false);
+      session->engineThread.join();
+    }
+    else {
+      // Called from the download event callback.  We cannot wait for
+      // ourselves.
+      return -1;
+    }
+  }
   error_code::Value rv = session->context->reqinfo->getResult();
   delete session;
   return rv;
 }
 
+namespace {
+void runForever(Session* session, std::promise<void>* started)
+{
+  session->engineThreadId = std::this_thread::get_id();
+  started->set_value();
+  auto& e = session->context->reqinfo->getDownloadEngine();
+  e->run();
+  session->callQueue->close();
+  // The other threads now call the API functions directly.
+  std::lock_guard<std::mutex> lock(session->directCallMutex);
+  session->publishSnapshot();
+}
+} // namespace
+
+namespace {
+int startBackground(Session* session)
+{
+  auto& e = session->context->reqinfo->getDownloadEngine();
+  try {
+    session->callQueue = make_unique<ApiCallQueue>();
+  }
+  catch (RecoverableException& ex) {
+    A2_LOG_ERROR_EX(EX_EXCEPTION_CAUGHT, ex);
+    return -1;
+  }
+  if (!session->keepRunning) {
+    session->keepRunning = true;
+    e->getRequestGroupMan()->setKeepRunning(true);
+    e->addCommand(make_unique<KeepRunningCommand>(e->newCUID(), e.get()));
+  }
+  e->addRoutineCommand(
+      make_unique<ApiCallCommand>(e->newCUID(), e.get(), session));
+  session->publishSnapshot();
+  session->background = true;
+  std::promise<void> started;
+  auto future = started.get_future();
+  session->engineThread = std::thread(runForever, session, &started);
+  future.wait();
+  return 0;
+}
+} // namespace
+
 int run(Session* session, RUN_MODE mode)
 {
+  if (session->background) {
+    return -1;
+  }
+  if (mode == RUN_FOREVER) {
+    return startBackground(session);
+  }
   auto& e = session->context->reqinfo->getDownloadEngine();
   return e->run(mode == RUN_ONCE);
 }
 
-int shutdown(Session* session, bool force)
+int post(Session* session, SessionCallback callback, void* userData)
 {
-  auto& e = session->context->reqinfo->getDownloadEngine();
-  if (force) {
-    e->requestForceHalt();
+  if (!session->isForeignThread()) {
+    callback(session, userData);
+    return 0;
   }
-  else {
-    e->requestHalt();
+  if (!session->callQueue->push(
+          [session, callback, userData]() { callback(session, userData); })) {
+    std::lock_guard<std::mutex> lock(session->directCallMutex);
+    callback(session, userData);
   }
-  // Skip next polling timeout. This avoids 1 second delay when there
-  // is no Command other than KeepRunningCommand in the queue.
-  e->setNoWait(true);
   return 0;
 }
 
+int shutdown(Session* session, bool force)
+{
+  return callOnEngine<int>(session, [&] {
+    auto& e = session->context->reqinfo->getDownloadEngine();
+    if (force) {
+      e->requestForceHalt();
+    }
+    else {
+      e->requestHalt();
+    }
+    // Skip next polling timeout. This avoids 1 second delay when there
+    // is no Command other than KeepRunningCommand in the queue.
+    e->setNoWait(true);
+    return 0;
+  });
+}
+
 std::string gidToHex(A2Gid gid) { return GroupId::toHex(gid); }
 
 A2Gid hexToGid(const std::string& hex)
@@ -265,98 +387,174 @@ void addRequestGroup(const std::shared_ptr<RequestGroup>& group,
 int addUri(Session* session, A2Gid* gid, const std::vector<std::string>& uris,
            const KeyVals& options, int position)
 {
-  auto& e = session->context->reqinfo->getDownloadEngine();
-  auto requestOption = std::make_shared<Option>(*e->getOption());
-  try {
-    apiGatherRequestOption(requestOption.get(), options,
-                           OptionParser::getInstance());
-  }
-  catch (RecoverableException& e) {
-    A2_LOG_INFO_EX(EX_EXCEPTION_CAUGHT, e);
-    return -1;
-  }
-  std::vector<std::shared_ptr<RequestGroup>> result;
-  createRequestGroupForUri(result, requestOption, uris,
-                           /* ignoreForceSeq = */ true,
-                           /* ignoreLocalPath = */ true);
-  if (!result.empty()) {
-    addRequestGroup(result.front(), e.get(), position);
+  return callOnEngine<int>(session, [&] {
+    auto& e = session->context->reqinfo->getDownloadEngine();
+    auto requestOption = std::make_shared<Option>(*e->getOption());
+    try {
+      apiGatherRequestOption(requestOption.get(), options,
+                             OptionParser::getInstance());
+    }
+    catch (RecoverableException& e) {
+      A2_LOG_INFO_EX(EX_EXCEPTION_CAUGHT, e);
+      return -1;
+    }
+    std::vector<std::shared_ptr<RequestGroup>> result;
+    createRequestGroupForUri(result, requestOption, uris,
+                             /* ignoreForceSeq = */ true,
+                             /* ignoreLocalPath = */ true);
+    if (!result.empty()) {
+      addRequestGroup(result.front(), e.get(), position);
+      if (gid) {
+        *gid = result.front()->getGID();
+      }
+    }
+    return 0;
+  });
+}
+
+int addUriToSink(Session* session, A2Gid* gid,
+                 const std::vector<std::string>& uris, const KeyVals& options,
+                 DataSink* sink, DataSinkMode mode, int position)
+{
+  return callOnEngine<int>(session, [&] {
+    auto& e = session->context->reqinfo->getDownloadEngine();
+    auto requestOption = std::make_shared<Option>(*e->getOption());
+    try {
+      apiGatherRequestOption(requestOption.get(), options,
+                             OptionParser::getInstance());
+    }
+    catch (RecoverableException& e) {
+      A2_LOG_INFO_EX(EX_EXCEPTION_CAUGHT, e);
+      return -1;
+    }
+    if (mode == DATA_SINK_SEQUENTIAL) {
+      requestOption->put(PREF_STREAM_PIECE_SELECTOR, V_INORDER);
+    }
+    std::vector<std::shared_ptr<RequestGroup>> result;
+    createRequestGroupForUri(result, requestOption, uris,
+                             /* ignoreForceSeq = */ true,
+                             /* ignoreLocalPath = */ true);
+    if (result.empty()) {
+      return 0;
+    }
+    auto& group = result.front();
+    auto& dctx = group->getDownloadContext();
+#ifdef ENABLE_BITTORRENT
+    if (dctx->hasAttribute(CTX_ATTR_BT)) {
+      A2_LOG_INFO("DataSink cannot be used for BitTorrent download.");
+      return -1;
+    }
+#endif // ENABLE_BITTORRENT
+    if (dctx->isChecksumVerificationAvailable()) {
+      A2_LOG_INFO("DataSink cannot be used with checksum verification.");
+      return -1;
+    }
+    // Same setup as MemoryPreDownloadHandler, except for the number
+    // of connections.  Marking it as in-memory download also keeps
+    // the data out of the disk cache.
+    group->setDiskWriterFactory(
+        std::make_shared<DataSinkDiskWriterFactory>(sink, mode));
+    group->setFileAllocationEnabled(false);
+    group->setPreLocalFileCheckEnabled(false);
+    group->markInMemoryDownload();
+    group->clearPreDownloadHandler();
+    group->clearPostDownloadHandler();
+    addRequestGroup(group, e.get(), position);
     if (gid) {
-      *gid = result.front()->getGID();
+      *gid = group->getGID();
     }
+    return 0;
+  });
+}
+
+MemoryDataSink::MemoryDataSink() = default;
+
+MemoryDataSink::~MemoryDataSink() = default;
+
+int MemoryDataSink::write(int64_t offset, const uint8_t* data, size_t length)
+{
+  if (data_.size() < offset + length) {
+    data_.resize(offset + length);
   }
+  std::copy(data, data + length, std::begin(data_) + offset);
   return 0;
 }
 
+const std::string& MemoryDataSink::getData() const { return data_; }
+
 int addMetalink(Session* session, std::vector<A2Gid>* gids,
                 const std::string& metalinkFile, const KeyVals& options,
                 int position)
 {
+  return callOnEngine<int>(session, [&] {
 #ifdef ENABLE_METALINK
-  auto& e = session->context->reqinfo->getDownloadEngine();
-  auto requestOption = std::make_shared<Option>(*e->getOption());
-  std::vector<std::shared_ptr<RequestGroup>> result;
-  try {
-    apiGatherRequestOption(requestOption.get(), options,
-                           OptionParser::getInstance());
-    requestOption->put(PREF_METALINK_FILE, metalinkFile);
-    createRequestGroupForMetalink(result, requestOption);
-  }
-  catch (RecoverableException& e) {
-    A2_LOG_INFO_EX(EX_EXCEPTION_CAUGHT, e);
-    return -1;
-  }
-  if (!result.empty()) {
-    if (position >= 0) {
-      e->getRequestGroupMan()->insertReservedGroup(position, result);
+    auto& e = session->context->reqinfo->getDownloadEngine();
+    auto requestOption = std::make_shared<Option>(*e->getOption());
+    std::vector<std::shared_ptr<RequestGroup>> result;
+    try {
+      apiGatherRequestOption(requestOption.get(), options,
+                             OptionParser::getInstance());
+      requestOption->put(PREF_METALINK_FILE, metalinkFile);
+      createRequestGroupForMetalink(result, requestOption);
     }
-    else {
-      e->getRequestGroupMan()->addReservedGroup(result);
-    }
-    if (gids) {
-      for (std::vector<std::shared_ptr<RequestGroup>>::const_iterator
-               i = result.begin(),
-               eoi = result.end();
-           i != eoi; ++i) {
-        (*gids).push_back((*i)->getGID());
+    catch (RecoverableException& e) {
+      A2_LOG_INFO_EX(EX_EXCEPTION_CAUGHT, e);
+      return -1;
+    }
+    if (!result.empty()) {
+      if (position >= 0) {
+        e->getRequestGroupMan()->insertReservedGroup(position, result);
+      }
+      else {
+        e->getRequestGroupMan()->addReservedGroup(result);
+      }
+      if (gids) {
+        for (std::vector<std::shared_ptr<RequestGroup>>::const_iterator
+                 i = result.begin(),
+                 eoi = result.end();
+             i != eoi; ++i) {
+          (*gids).push_back((*i)->getGID());
+        }
       }
     }
-  }
-  return 0;
+    return 0;
 #else  // !ENABLE_METALINK
-  return -1;
+    return -1;
 #endif // !ENABLE_METALINK
+  });
 }
 
 int addTorrent(Session* session, A2Gid* gid, const std::string& torrentFile,
                const std::vector<std::string>& webSeedUris,
                const KeyVals& options, int position)
 {
+  return callOnEngine<int>(session, [&] {
 #ifdef ENABLE_BITTORRENT
-  auto& e = session->context->reqinfo->getDownloadEngine();
-  auto requestOption = std::make_shared<Option>(*e->getOption());
-  std::vector<std::shared_ptr<RequestGroup>> result;
-  try {
-    apiGatherRequestOption(requestOption.get(), options,
-                           OptionParser::getInstance());
-    requestOption->put(PREF_TORRENT_FILE, torrentFile);
-    createRequestGroupForBitTorrent(result, requestOption, webSeedUris,
-                                    torrentFile);
-  }
-  catch (RecoverableException& e) {
-    A2_LOG_INFO_EX(EX_EXCEPTION_CAUGHT, e);
-    return -1;
-  }
-  if (!result.empty()) {
-    addRequestGroup(result.front(), e.get(), position);
-    if (gid) {
-      *gid = result.front()->getGID();
+    auto& e = session->context->reqinfo->getDownloadEngine();
+    auto requestOption = std::make_shared<Option>(*e->getOption());
+    std::vector<std::shared_ptr<RequestGroup>> result;
+    try {
+      apiGatherRequestOption(requestOption.get(), options,
+                             OptionParser::getInstance());
+      requestOption->put(PREF_TORRENT_FILE, torrentFile);
+      createRequestGroupForBitTorrent(result, requestOption, webSeedUris,
+                                      torrentFile);
     }
-  }
-  return 0;
+    catch (RecoverableException& e) {
+      A2_LOG_INFO_EX(EX_EXCEPTION_CAUGHT, e);
+      return -1;
+    }
+    if (!result.empty()) {
+      addRequestGroup(result.front(), e.get(), position);
+      if (gid) {
+        *gid = result.front()->getGID();
+      }
+    }
+    return 0;
 #else  // !ENABLE_BITTORRENT
-  return -1;
+    return -1;
 #endif // !ENABLE_BITTORRENT
+  });
 }
 
 int addTorrent(Session* session, A2Gid* gid, const std::string& torrentFile,
@@ -368,104 +566,125 @@ int addTorrent(Session* session, A2Gid* gid, const std::string& torrentFile,
 
 int removeDownload(Session* session, A2Gid gid, bool force)
 {
-  auto& e = session->context->reqinfo->getDownloadEngine();
-  std::shared_ptr<RequestGroup> group = e->getRequestGroupMan()->findGroup(gid);
-  if (group) {
-    if (group->getState() == RequestGroup::STATE_ACTIVE) {
-      if (force) {
-        group->setForceHaltRequested(true, RequestGroup::USER_REQUEST);
+  return callOnEngine<int>(session, [&] {
+    auto& e = session->context->reqinfo->getDownloadEngine();
+    std::shared_ptr<RequestGroup> group =
+        e->getRequestGroupMan()->findGroup(gid);
+    if (group) {
+      if (group->getState() == RequestGroup::STATE_ACTIVE) {
+        if (force) {
+          group->setForceHaltRequested(true, RequestGroup::USER_REQUEST);
+        }
+        else {
+          group->setHaltRequested(true, RequestGroup::USER_REQUEST);
+        }
+        e->setRefreshInterval(std::chrono::milliseconds(0));
       }
       else {
-        group->setHaltRequested(true, RequestGroup::USER_REQUEST);
+        if (group->isDependencyResolved()) {
+          e->getRequestGroupMan()->removeReservedGroup(gid);
+        }
+        else {
+          return -1;
+        }
       }
-      e->setRefreshInterval(std::chrono::milliseconds(0));
     }
     else {
-      if (group->isDependencyResolved()) {
-        e->getRequestGroupMan()->removeReservedGroup(gid);
-      }
-      else {
-        return -1;
-      }
+      return -1;
     }
-  }
-  else {
-    return -1;
-  }
-  return 0;
+    return 0;
+  });
 }
 
 int pauseDownload(Session* session, A2Gid gid, bool force)
 {
-  auto& e = session->context->reqinfo->getDownloadEngine();
-  std::shared_ptr<RequestGroup> group = e->getRequestGroupMan()->findGroup(gid);
-  if (group) {
-    bool reserved = group->getState() == RequestGroup::STATE_WAITING;
-    if (pauseRequestGroup(group, reserved, force)) {
-      e->setRefreshInterval(std::chrono::milliseconds(0));
-      return 0;
+  return callOnEngine<int>(session, [&] {
+    auto& e = session->context->reqinfo->getDownloadEngine();
+    std::shared_ptr<RequestGroup> group =
+        e->getRequestGroupMan()->findGroup(gid);
+    if (group) {
+      bool reserved = group->getState() == RequestGroup::STATE_WAITING;
+      if (pauseRequestGroup(group, reserved, force)) {
+        e->setRefreshInterval(std::chrono::milliseconds(0));
+        return 0;
+      }
     }
-  }
-  return -1;
+    return -1;
+  });
 }
 
 int unpauseDownload(Session* session, A2Gid gid)
 {
-  auto& e = session->context->reqinfo->getDownloadEngine();
-  std::shared_ptr<RequestGroup> group = e->getRequestGroupMan()->findGroup(gid);
-  if (!group || group->getState() != RequestGroup::STATE_WAITING ||
-      !group->isPauseRequested()) {
-    return -1;
-  }
-  else {
-    group->setPauseRequested(false);
-    e->getRequestGroupMan()->requestQueueCheck();
-  }
-  return 0;
+  return callOnEngine<int>(session, [&] {
+    auto& e = session->context->reqinfo->getDownloadEngine();
+    std::shared_ptr<RequestGroup> group =
+        e->getRequestGroupMan()->findGroup(gid);
+    if (!group || group->getState() != RequestGroup::STATE_WAITING ||
+        !group->isPauseRequested()) {
+      return -1;
+    }
+    else {
+      group->setPauseRequested(false);
+      e->getRequestGroupMan()->requestQueueCheck();
+    }
+    return 0;
+  });
 }
 
 int changePosition(Session* session, A2Gid gid, int pos, OffsetMode how)
 {
-  auto& e = session->context->reqinfo->getDownloadEngine();
-  try {
-    return e->getRequestGroupMan()->changeReservedGroupPosition(gid, pos, how);
-  }
-  catch (RecoverableException& e) {
-    A2_LOG_INFO_EX(EX_EXCEPTION_CAUGHT, e);
-    return -1;
-  }
+  return callOnEngine<int>(session, [&]() -> int {
+    auto& e = session->context->reqinfo->getDownloadEngine();
+    try {
+      return e->getRequestGroupMan()->changeReservedGroupPosition(gid, pos,
+                                                                   how);
+    }
+    catch (RecoverableException& e) {
+      A2_LOG_INFO_EX(EX_EXCEPTION_CAUGHT, e);
+      return -1;
+    }
+  });
 }
 
 int changeOption(Session* session, A2Gid gid, const KeyVals& options)
 {
-  auto& e = session->context->reqinfo->getDownloadEngine();
-  std::shared_ptr<RequestGroup> group = e->getRequestGroupMan()->findGroup(gid);
-  if (group) {
-    Option option;
-    try {
-      if (group->getState() == RequestGroup::STATE_ACTIVE) {
-        apiGatherChangeableOption(&option, options,
-                                  OptionParser::getInstance());
+  return callOnEngine<int>(session, [&] {
+    auto& e = session->context->reqinfo->getDownloadEngine();
+    std::shared_ptr<RequestGroup> group =
+        e->getRequestGroupMan()->findGroup(gid);
+    if (group) {
+      Option option;
+      try {
+        if (group->getState() == RequestGroup::STATE_ACTIVE) {
+          apiGatherChangeableOption(&option, options,
+                                    OptionParser::getInstance());
+        }
+        else {
+          apiGatherChangeableOptionForReserved(&option, options,
+                                               OptionParser::getInstance());
+        }
       }
-      else {
-        apiGatherChangeableOptionForReserved(&option, options,
-                                             OptionParser::getInstance());
+      catch (RecoverableException& err) {
+        A2_LOG_INFO_EX(EX_EXCEPTION_CAUGHT, err);
+        return -1;
       }
+      changeOption(group, option, e.get());
+      return 0;
     }
-    catch (RecoverableException& err) {
-      A2_LOG_INFO_EX(EX_EXCEPTION_CAUGHT, err);
+    else {
       return -1;
     }
-    changeOption(group, option, e.get());
-    return 0;
-  }
-  else {
-    return -1;
-  }
+  });
 }
 
 const std::string& getGlobalOption(Session* session, const std::string& name)
 {
+  if (session->isForeignThread()) {
+    // The engine may change or free its option at any time.
+    static thread_local std::string value;
+    value = getGlobalOptionCopy(session, name);
+    return value;
+  }
   auto& e = session->context->reqinfo->getDownloadEngine();
   PrefPtr pref = option::k2p(name);
   if (OptionParser::getInstance()->find(pref)) {
@@ -476,39 +695,58 @@ const std::string& getGlobalOption(Session* session, const std::string& name)
   }
 }
 
+std::string getGlobalOptionCopy(Session* session, const std::string& name)
+{
+  return callOnEngine<std::string>(session, [&] {
+    auto& e = session->context->reqinfo->getDownloadEngine();
+    PrefPtr pref = option::k2p(name);
+    if (OptionParser::getInstance()->find(pref)) {
+      return e->getOption()->get(pref);
+    }
+    else {
+      return A2STR::NIL;
+    }
+  });
+}
+
 KeyVals getGlobalOptions(Session* session)
 {
-  auto& e = session->context->reqinfo->getDownloadEngine();
-  const std::shared_ptr<OptionParser>& optionParser =
-      OptionParser::getInstance();
-  const Option* option = e->getOption();
-  KeyVals options;
-  for (size_t i = 1, len = option::countOption(); i < len; ++i) {
-    PrefPtr pref = option::i2p(i);
-    if (option->defined(pref) && optionParser->find(pref)) {
-      options.push_back(KeyVals::value_type(pref->k, option->get(pref)));
+  return callOnEngine<KeyVals>(session, [&] {
+    auto& e = session->context->reqinfo->getDownloadEngine();
+    const std::shared_ptr<OptionParser>& optionParser =
+        OptionParser::getInstance();
+    const Option* option = e->getOption();
+    KeyVals options;
+    for (size_t i = 1, len = option::countOption(); i < len; ++i) {
+      PrefPtr pref = option::i2p(i);
+      if (option->defined(pref) && optionParser->find(pref)) {
+        options.push_back(KeyVals::value_type(pref->k, option->get(pref)));
+      }
     }
-  }
-  return options;
+    return options;
+  });
 }
 
 int changeGlobalOption(Session* session, const KeyVals& options)
 {
-  auto& e = session->context->reqinfo->getDownloadEngine();
-  Option option;
-  try {
-    apiGatherChangeableGlobalOption(&option, options,
-                                    OptionParser::getInstance());
-  }
-  catch (RecoverableException& err) {
-    A2_LOG_INFO_EX(EX_EXCEPTION_CAUGHT, err);
-    return -1;
-  }
-  changeGlobalOption(option, e.get());
-  return 0;
+  return callOnEngine<int>(session, [&] {
+    auto& e = session->context->reqinfo->getDownloadEngine();
+    Option option;
+    try {
+      apiGatherChangeableGlobalOption(&option, options,
+                                      OptionParser::getInstance());
+    }
+    catch (RecoverableException& err) {
+      A2_LOG_INFO_EX(EX_EXCEPTION_CAUGHT, err);
+      return -1;
+    }
+    changeGlobalOption(option, e.get());
+    return 0;
+  });
 }
 
-GlobalStat getGlobalStat(Session* session)
+namespace {
+GlobalStat createGlobalStat(Session* session)
 {
   auto& e = session->context->reqinfo->getDownloadEngine();
   auto& rgman = e->getRequestGroupMan();
@@ -521,8 +759,10 @@ GlobalStat getGlobalStat(Session* session)
   res.numStopped = rgman->getDownloadResults().size();
   return res;
 }
+} // namespace
 
-std::vector<A2Gid> getActiveDownload(Session* session)
+namespace {
+std::vector<A2Gid> createActiveDownload(Session* session)
 {
   auto& e = session->context->reqinfo->getDownloadEngine();
   const RequestGroupList& groups = e->getRequestGroupMan()->getRequestGroups();
@@ -532,6 +772,32 @@ std::vector<A2Gid> getActiveDownload(Session* session)
   }
   return res;
 }
+} // namespace
+
+void Session::publishSnapshot()
+{
+  auto snap = std::make_shared<ApiStatSnapshot>();
+  snap->stat = createGlobalStat(this);
+  snap->active = createActiveDownload(this);
+  std::atomic_store(&snapshot,
+                    std::shared_ptr<const ApiStatSnapshot>(std::move(snap)));
+}
+
+GlobalStat getGlobalStat(Session* session)
+{
+  if (session->isForeignThread()) {
+    return session->getSnapshot()->stat;
+  }
+  return createGlobalStat(session);
+}
+
+std::vector<A2Gid> getActiveDownload(Session* session)
+{
+  if (session->isForeignThread()) {
+    return session->getSnapshot()->active;
+  }
+  return createActiveDownload(session);
+}
 
 namespace {
 template <typename OutputIterator, typename InputIterator>
@@ -867,7 +1133,98 @@ struct DownloadResultDH : public DownloadHandle {
 };
 } // namespace
 
-DownloadHandle* getDownloadHandle(Session* session, A2Gid gid)
+namespace {
+// Copy of the all information available from DownloadHandle.  This
+// is returned to the threads other than the engine thread in
+// RUN_FOREVER mode, because the other handles refer to the objects
+// owned by the engine.
+struct SnapshotDH : public DownloadHandle {
+  SnapshotDH(DownloadHandle& dh)
+      : status(dh.getStatus()),
+        totalLength(dh.getTotalLength()),
+        completedLength(dh.getCompletedLength()),
+        uploadLength(dh.getUploadLength()),
+        bitfield(dh.getBitfield()),
+        downloadSpeed(dh.getDownloadSpeed()),
+        uploadSpeed(dh.getUploadSpeed()),
+        infoHash(dh.getInfoHash()),
+        pieceLength(dh.getPieceLength()),
+        numPieces(dh.getNumPieces()),
+        connections(dh.getConnections()),
+        errorCode(dh.getErrorCode()),
+        followedBy(dh.getFollowedBy()),
+        following(dh.getFollowing()),
+        belongsTo(dh.getBelongsTo()),
+        dir(dh.getDir()),
+        files(dh.getFiles()),
+        btMetaInfo(dh.getBtMetaInfo()),
+        options(dh.getOptions())
+  {
+  }
+  virtual ~SnapshotDH() = default;
+  virtual DownloadStatus getStatus() CXX11_OVERRIDE { return status; }
+  virtual int64_t getTotalLength() CXX11_OVERRIDE { return totalLength; }
+  virtual int64_t getCompletedLength() CXX11_OVERRIDE
+  {
+    return completedLength;
+  }
+  virtual int64_t getUploadLength() CXX11_OVERRIDE { return uploadLength; }
+  virtual std::string getBitfield() CXX11_OVERRIDE { return bitfield; }
+  virtual int getDownloadSpeed() CXX11_OVERRIDE { return downloadSpeed; }
+  virtual int getUploadSpeed() CXX11_OVERRIDE { return uploadSpeed; }
+  virtual const std::string& getInfoHash() CXX11_OVERRIDE { return infoHash; }
+  virtual size_t getPieceLength() CXX11_OVERRIDE { return pieceLength; }
+  virtual int getNumPieces() CXX11_OVERRIDE { return numPieces; }
+  virtual int getConnections() CXX11_OVERRIDE { return connections; }
+  virtual int getErrorCode() CXX11_OVERRIDE { return errorCode; }
+  virtual const std::vector<A2Gid>& getFollowedBy() CXX11_OVERRIDE
+  {
+    return followedBy;
+  }
+  virtual A2Gid getFollowing() CXX11_OVERRIDE { return following; }
+  virtual A2Gid getBelongsTo() CXX11_OVERRIDE { return belongsTo; }
+  virtual const std::string& getDir() CXX11_OVERRIDE { return dir; }
+  virtual std::vector<FileData> getFiles() CXX11_OVERRIDE { return files; }
+  virtual int getNumFiles() CXX11_OVERRIDE { return files.size(); }
+  virtual FileData getFile(int index) CXX11_OVERRIDE
+  {
+    return files[index - 1];
+  }
+  virtual BtMetaInfoData getBtMetaInfo() CXX11_OVERRIDE { return btMetaInfo; }
+  virtual const std::string& getOption(const std::string& name) CXX11_OVERRIDE
+  {
+    for (auto& kv : options) {
+      if (kv.first == name) {
+        return kv.second;
+      }
+    }
+    return A2STR::NIL;
+  }
+  virtual KeyVals getOptions() CXX11_OVERRIDE { return options; }
+  DownloadStatus status;
+  int64_t totalLength;
+  int64_t completedLength;
+  int64_t uploadLength;
+  std::string bitfield;
+  int downloadSpeed;
+  int uploadSpeed;
+  std::string infoHash;
+  size_t pieceLength;
+  int numPieces;
+  int connections;
+  int errorCode;
+  std::vector<A2Gid> followedBy;
+  A2Gid following;
+  A2Gid belongsTo;
+  std::string dir;
+  std::vector<FileData> files;
+  BtMetaInfoData btMetaInfo;
+  KeyVals options;
+};
+} // namespace
+
+namespace {
+DownloadHandle* createDownloadHandle(Session* session, A2Gid gid)
 {
   auto& e = session->context->reqinfo->getDownloadEngine();
   auto& rgman = e->getRequestGroupMan();
@@ -883,6 +1240,21 @@ DownloadHandle* getDownloadHandle(Session* session, A2Gid gid)
   }
   return nullptr;
 }
+} // namespace
+
+DownloadHandle* getDownloadHandle(Session* session, A2Gid gid)
+{
+  if (!session->isForeignThread()) {
+    return createDownloadHandle(session, gid);
+  }
+  return callOnEngine<DownloadHandle*>(session, [&]() -> DownloadHandle* {
+    std::unique_ptr<DownloadHandle> dh(createDownloadHandle(session, gid));
+    if (!dh) {
+      return nullptr;
+    }
+    return new SnapshotDH(*dh);
+  });
+}
 
 void deleteDownloadHandle(DownloadHandle* dh) { delete dh; }
 
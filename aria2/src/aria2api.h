@@ -38,6 +38,9 @@
 #include "common.h"
 
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include <aria2/aria2.h>
 
@@ -45,12 +48,47 @@ namespace aria2 {
 
 struct Context;
 class ApiCallbackDownloadEventListener;
+class ApiCallQueue;
+
+// Statistics of the session published by the engine thread for the
+// queries from the other threads in RUN_FOREVER mode.  The published
+// object is immutable.
+struct ApiStatSnapshot {
+  GlobalStat stat;
+  std::vector<A2Gid> active;
+};
 
 struct Session {
   Session(const KeyVals& options);
   ~Session();
+
+  // Returns true if the caller must not touch the engine directly,
+  // that is the engine runs in the background thread and the caller
+  // is not that thread.
+  bool isForeignThread() const
+  {
+    return background && std::this_thread::get_id() != engineThreadId;
+  }
+
+  // Builds ApiStatSnapshot from the current state of the engine and
+  // publishes it.  Must be called from the engine thread.
+  void publishSnapshot();
+
+  // Returns the latest snapshot published.
+  std::shared_ptr<const ApiStatSnapshot> getSnapshot() const;
+
   std::shared_ptr<Context> context;
   std::unique_ptr<ApiCallbackDownloadEventListener> listener;
+  bool keepRunning;
+  // The members below are used in RUN_FOREVER mode.
+  bool background;
+  std::thread engineThread;
+  std::thread::id engineThreadId;
+  std::unique_ptr<ApiCallQueue> callQueue;
+  // Serializes the calls made after the engine thread exited.
+  std::mutex directCallMutex;
+  // Accessed with std::atomic_load/std::atomic_store.
+  std::shared_ptr<const ApiStatSnapshot> snapshot;
 };
 
 } // namespace aria2
@@ -37,11 +37,13 @@
 
 #include "common.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
 
 #include "util.h"
+#include "array_fun.h"
 
 namespace aria2 {
 
@@ -120,23 +122,173 @@ inline size_t countSetBit(const unsigned char* bitfield, size_t nbits)
   return count;
 }
 
+// Word level access to bitfields.  Bit index i of a bitfield is
+// stored in the bit 63 - i % 64 of the word i / 64, so that the first
+// bit is the most significant one.  Expression templates of
+// array_fun.h are evaluated 64 bits at a time.
+
+// Returns the word |i| of |bitfield|.  The whole word must be inside
+// |bitfield|.
+inline uint64_t loadWord(const unsigned char* bitfield, size_t i)
+{
+  uint64_t v;
+  memcpy(&v, bitfield + i * 8, sizeof(v));
+  return ntoh64(v);
+}
+
+inline uint64_t loadWord(unsigned char* bitfield, size_t i)
+{
+  return loadWord(const_cast<const unsigned char*>(bitfield), i);
+}
+
+template <typename T>
+uint64_t loadWord(const expr::Array<T>& bitfield, size_t i);
+
+template <typename Arg, typename Op>
+uint64_t loadWord(const expr::UnExpr<Arg, Op>& bitfield, size_t i);
+
+template <typename L, typename R, typename Op>
+uint64_t loadWord(const expr::BinExpr<L, R, Op>& bitfield, size_t i);
+
+template <typename T>
+uint64_t applyWord(const std::bit_and<T>&, uint64_t lhs, uint64_t rhs)
+{
+  return lhs & rhs;
+}
+
+template <typename T>
+uint64_t applyWord(const std::bit_or<T>&, uint64_t lhs, uint64_t rhs)
+{
+  return lhs | rhs;
+}
+
+template <typename T>
+uint64_t applyWord(const expr::bit_neg<T>&, uint64_t arg)
+{
+  return ~arg;
+}
+
+template <typename T>
+uint64_t loadWord(const expr::Array<T>& bitfield, size_t i)
+{
+  return loadWord(bitfield.t, i);
+}
+
+template <typename Arg, typename Op>
+uint64_t loadWord(const expr::UnExpr<Arg, Op>& bitfield, size_t i)
+{
+  return applyWord(bitfield.op, loadWord(bitfield.arg, i));
+}
+
+template <typename L, typename R, typename Op>
+uint64_t loadWord(const expr::BinExpr<L, R, Op>& bitfield, size_t i)
+{
+  return applyWord(bitfield.op, loadWord(bitfield.lhs, i),
+                   loadWord(bitfield.rhs, i));
+}
+
+// Returns the word |i| of |bitfield|, which contains nbits bits.  The
+// bits past nbits are 0.  The last word is read byte by byte, so that
+// no byte past the end of |bitfield| is touched.
+template <typename Array>
+uint64_t getWord(const Array& bitfield, size_t nbits, size_t i)
+{
+  size_t nbytes = (nbits + 7) / 8;
+  uint64_t v;
+  if ((i + 1) * 8 <= nbytes) {
+    v = loadWord(bitfield, i);
+  }
+  else {
+    v = 0;
+    for (size_t j = i * 8, shift = 56; j < nbytes; ++j, shift -= 8) {
+      v |= static_cast<uint64_t>(static_cast<unsigned char>(bitfield[j]))
+           << shift;
+    }
+  }
+  size_t rest = nbits - i * 64;
+  if (rest < 64) {
+    v &= ~(~static_cast<uint64_t>(0) >> rest);
+  }
+  return v;
+}
+
+// Returns the number of leading 0 bits of x.  x must not be 0.
+inline size_t countLeadingZero(uint64_t x)
+{
+#ifdef __GNUC__
+  return __builtin_clzll(x);
+#else  // !__GNUC__
+  size_t n = 0;
+  for (; !(x & (static_cast<uint64_t>(1) << 63)); x <<= 1) {
+    ++n;
+  }
+  return n;
+#endif // !__GNUC__
+}
+
+inline size_t countSetBit64(uint64_t x)
+{
+#ifdef __GNUC__
+  return __builtin_popcountll(x);
+#else  // !__GNUC__
+  return countBit32(x) + countBit32(x >> 32);
+#endif // !__GNUC__
+}
+
+// Returns the index of the first bit in [from, to) of bitfield which
+// is set if on is true, or unset otherwise.  bitfield contains nbits
+// bits and to must not exceed nbits.  Returns to if there is no such
+// bit.
+template <typename Array>
+size_t findBit(const Array& bitfield, size_t nbits, size_t from, size_t to,
+               bool on)
+{
+  if (to <= from) {
+    return to;
+  }
+  uint64_t flip = on ? 0 : ~static_cast<uint64_t>(0);
+  size_t i = from / 64;
+  size_t last = (to - 1) / 64;
+  uint64_t v = (getWord(bitfield, nbits, i) ^ flip) &
+               (~static_cast<uint64_t>(0) >> (from % 64));
+  for (;;) {
+    if (v) {
+      return std::min(to, i * 64 + countLeadingZero(v));
+    }
+    if (i == last) {
+      return to;
+    }
+    ++i;
+    v = getWord(bitfield, nbits, i) ^ flip;
+  }
+}
+
+// Returns the index of the first set bit in [from, to) of bitfield,
+// or to if there is none.
+template <typename Array>
+size_t findSetBit(const Array& bitfield, size_t nbits, size_t from, size_t to)
+{
+  return findBit(bitfield, nbits, from, to, true);
+}
+
+// Returns the index of the first unset bit in [from, to) of bitfield,
+// or to if there is none.  Used to find the end of a run of set bits.
+template <typename Array>
+size_t findUnsetBit(const Array& bitfield, size_t nbits, size_t from,
+                    size_t to)
+{
+  return findBit(bitfield, nbits, from, to, false);
+}
+
 // Counts set bit in bitfield. This is a bit slower than countSetBit
 // but can accept array template expression as bitfield.
 template <typename Array>
 size_t countSetBitSlow(const Array& bitfield, size_t nbits)
 {
-  if (nbits == 0) {
-    return 0;
-  }
   size_t count = 0;
-  size_t to = (nbits + 7) / 8;
-  if (to > 1) {
-    for (size_t i = 0; i < to - 1; ++i) {
-      count += cntbits[static_cast<unsigned char>(bitfield[i])];
-    }
+  for (size_t i = 0, nwords = (nbits + 63) / 64; i < nwords; ++i) {
+    count += countSetBit64(getWord(bitfield, nbits, i));
   }
-  count += cntbits[static_cast<unsigned char>(bitfield[to - 1]) &
-                   lastByteMask(nbits)];
   return count;
 }
 
@@ -147,13 +299,12 @@ void flipBit(unsigned char* data, size_t length, size_t bitIndex);
 template <typename Array>
 bool getFirstSetBitIndex(size_t& index, const Array& bitfield, size_t nbits)
 {
-  for (size_t i = 0; i < nbits; ++i) {
-    if (bitfield::test(bitfield, nbits, i)) {
-      index = i;
-      return true;
-    }
+  size_t i = findSetBit(bitfield, nbits, 0, nbits);
+  if (i == nbits) {
+    return false;
   }
-  return false;
+  index = i;
+  return true;
 }
 
 // Appends first at most n set bit index in bitfield to out.  bitfield
@@ -166,12 +317,14 @@ size_t getFirstNSetBitIndex(OutputIterator out, size_t n, const Array& bitfield,
     return 0;
   }
   const size_t origN = n;
-  for (size_t i = 0; i < nbits; ++i) {
-    if (bitfield::test(bitfield, nbits, i)) {
-      *out++ = i;
+  for (size_t i = 0, nwords = (nbits + 63) / 64; i < nwords; ++i) {
+    for (uint64_t v = getWord(bitfield, nbits, i); v;) {
+      size_t nlz = countLeadingZero(v);
+      *out++ = i * 64 + nlz;
       if (--n == 0) {
-        break;
+        return origN;
       }
+      v &= ~((static_cast<uint64_t>(1) << 63) >> nlz);
     }
   }
   return origN - n;
@@ -67,6 +67,7 @@
 #  include "bittorrent_helper.h"
 #  include "BtConstants.h"
 #  include "ValueBaseBencodeParser.h"
+#  include "TorrentIngestor.h"
 #endif // ENABLE_BITTORRENT
 
 namespace aria2 {
@@ -181,20 +182,36 @@ std::shared_ptr<MetadataInfo> createMetadataInfoDataOnly()
 
 #ifdef ENABLE_BITTORRENT
 
+std::shared_ptr<DownloadContext>
+createBtDownloadContext(const std::shared_ptr<Option>& option,
+                        const std::vector<std::string>& uris,
+                        const std::string& metaInfoUri,
+                        const ValueBase* torrent)
+{
+  std::vector<std::string> nargs;
+  if (option->get(PREF_PARAMETERIZED_URI) == A2_V_TRUE) {
+    unfoldURI(nargs, uris);
+  }
+  else {
+    nargs = uris;
+  }
+  auto dctx = std::make_shared<DownloadContext>();
+  // may throw exception
+  bittorrent::loadFromMemory(torrent, dctx, option, nargs,
+                             metaInfoUri.empty() ? "default" : metaInfoUri);
+  return dctx;
+}
+
 namespace {
 std::shared_ptr<RequestGroup>
 createBtRequestGroup(const std::string& metaInfoUri,
                      const std::shared_ptr<Option>& optionTemplate,
-                     const std::vector<std::string>& auxUris,
-                     const ValueBase* torrent, bool adjustAnnounceUri = true)
+                     const std::shared_ptr<DownloadContext>& dctx,
+                     bool adjustAnnounceUri = true)
 {
   auto option = util::copy(optionTemplate);
   auto gid = getGID(option);
   auto rg = std::make_shared<RequestGroup>(gid, option);
-  auto dctx = std::make_shared<DownloadContext>();
-  // may throw exception
-  bittorrent::loadFromMemory(torrent, dctx, option, auxUris,
-                             metaInfoUri.empty() ? "default" : metaInfoUri);
   for (auto& fe : dctx->getFileEntries()) {
     auto& uris = fe->getRemainingUris();
     std::shuffle(std::begin(uris), std::end(uris),
@@ -255,8 +272,10 @@ createBtMagnetRequestGroup(const std::string& magnetLink,
     bittorrent::ValueBaseBencodeParser parser;
     auto torrent = parseFile(parser, torrentFilename);
     if (torrent) {
-      auto rg = createBtRequestGroup(torrentFilename, optionTemplate, {},
-                                     torrent.get());
+      auto rg = createBtRequestGroup(
+          torrentFilename, optionTemplate,
+          createBtDownloadContext(optionTemplate, {}, torrentFilename,
+                                  torrent.get()));
       const auto& actualInfoHash =
           bittorrent::getTorrentAttrs(rg->getDownloadContext())->infoHash;
 
@@ -331,17 +350,20 @@ void createRequestGroupForBitTorrent(
     const std::string& metaInfoUri, const ValueBase* torrent,
     bool adjustAnnounceUri)
 {
-  std::vector<std::string> nargs;
-  if (option->get(PREF_PARAMETERIZED_URI) == A2_V_TRUE) {
-    unfoldURI(nargs, uris);
-  }
-  else {
-    nargs = uris;
-  }
+  createRequestGroupForBitTorrent(
+      result, option, metaInfoUri,
+      createBtDownloadContext(option, uris, metaInfoUri, torrent),
+      adjustAnnounceUri);
+}
+
+void createRequestGroupForBitTorrent(
+    std::vector<std::shared_ptr<RequestGroup>>& result,
+    const std::shared_ptr<Option>& option, const std::string& metaInfoUri,
+    const std::shared_ptr<DownloadContext>& dctx, bool adjustAnnounceUri)
+{
   // we ignore -Z option here
   size_t numSplit = option->getAsInt(PREF_SPLIT);
-  auto rg = createBtRequestGroup(metaInfoUri, option, nargs, torrent,
-                                 adjustAnnounceUri);
+  auto rg = createBtRequestGroup(metaInfoUri, option, dctx, adjustAnnounceUri);
   rg->setNumConcurrentCommand(numSplit);
   result.push_back(rg);
 }
@@ -413,8 +435,9 @@ public:
           throw DL_ABORT_EX2("Bencode decoding failed",
                              error_code::BENCODE_PARSE_ERROR);
         }
-        requestGroups_.push_back(
-            createBtRequestGroup(uri, option_, {}, torrent.get()));
+        requestGroups_.push_back(createBtRequestGroup(
+            uri, option_,
+            createBtDownloadContext(option_, {}, uri, torrent.get())));
       }
       catch (RecoverableException& e) {
         if (throwOnError_) {
@@ -519,6 +542,26 @@ void createRequestGroupForUri(
   }
 }
 
+namespace {
+// Returns the option of an entry of the input file, which has the
+// per-entry options |tempOption| on top of |option|.
+std::shared_ptr<Option> createEntryOption(const Option* option,
+                                          const Option& tempOption)
+{
+  auto requestOption = std::make_shared<Option>(*option);
+  requestOption->remove(PREF_OUT);
+  const auto& oparser = OptionParser::getInstance();
+  for (size_t i = 1, len = option::countOption(); i < len; ++i) {
+    auto pref = option::i2p(i);
+    auto h = oparser->find(pref);
+    if (h && h->getInitialOption() && tempOption.defined(pref)) {
+      requestOption->put(pref, tempOption.get(pref));
+    }
+  }
+  return requestOption;
+}
+} // namespace
+
 bool createRequestGroupFromUriListParser(
     std::vector<std::shared_ptr<RequestGroup>>& result, const Option* option,
     UriListParser* uriListParser)
@@ -534,16 +577,7 @@ bool createRequestGroupFromUriListParser(
     if (uris.empty()) {
       continue;
     }
-    auto requestOption = std::make_shared<Option>(*option);
-    requestOption->remove(PREF_OUT);
-    const auto& oparser = OptionParser::getInstance();
-    for (size_t i = 1, len = option::countOption(); i < len; ++i) {
-      auto pref = option::i2p(i);
-      auto h = oparser->find(pref);
-      if (h && h->getInitialOption() && tempOption.defined(pref)) {
-        requestOption->put(pref, tempOption.get(pref));
-      }
-    }
+    auto requestOption = createEntryOption(option, tempOption);
     // This does not throw exception because throwOnError = false.
     createRequestGroupForUri(result, requestOption, uris);
     if (num < result.size()) {
@@ -567,14 +601,89 @@ std::shared_ptr<UriListParser> openUriListParser(const std::string& filename)
   return std::make_shared<UriListParser>(listPath);
 }
 
+#ifdef ENABLE_BITTORRENT
+namespace {
+// Number of the entries of the input file read ahead, so that their
+// .torrent files are parsed in parallel.
+const size_t INGEST_BATCH_SIZE = 1024;
+} // namespace
+
+namespace {
+// Creates RequestGroups from the entries of |uriListParser| like
+// createRequestGroupFromUriListParser(), but the entries consisting
+// of a single local file are parsed by |ingestor| in batches.
+void ingestUriList(std::vector<std::shared_ptr<RequestGroup>>& result,
+                   const Option* option, UriListParser* uriListParser,
+                   TorrentIngestor& ingestor)
+{
+  ProtocolDetector detector;
+  while (uriListParser->hasNext()) {
+    std::vector<std::pair<std::vector<std::string>, std::shared_ptr<Option>>>
+        entries;
+    std::vector<TorrentIngestJob> jobs;
+    while (entries.size() < INGEST_BATCH_SIZE && uriListParser->hasNext()) {
+      std::vector<std::string> uris;
+      Option tempOption;
+      uriListParser->parseNext(uris, tempOption);
+      if (uris.empty()) {
+        continue;
+      }
+      auto requestOption = createEntryOption(option, tempOption);
+      if (uris.size() == 1 &&
+          requestOption->get(PREF_PARAMETERIZED_URI) != A2_V_TRUE &&
+          !detector.isStreamProtocol(uris[0]) &&
+          !detector.guessTorrentMagnet(uris[0])) {
+        jobs.emplace_back();
+        jobs.back().metaInfoUri = uris[0];
+        jobs.back().option = requestOption;
+      }
+      entries.emplace_back(std::move(uris), std::move(requestOption));
+    }
+    ingestor.run(jobs);
+    // The jobs are in the order of the entries, and a job shares the
+    // option with its entry.
+    auto job = std::begin(jobs);
+    for (auto& entry : entries) {
+      if (job != std::end(jobs) && (*job).option == entry.second) {
+        auto& j = *job++;
+        if (j.downloadContext) {
+          result.push_back(
+              createBtRequestGroup(j.metaInfoUri, j.option, j.downloadContext));
+          continue;
+        }
+        if (j.error) {
+          try {
+            std::rethrow_exception(j.error);
+          }
+          catch (RecoverableException& e) {
+            // error occurred while parsing torrent file.
+            // We simply ignore it.
+            A2_LOG_ERROR_EX(EX_EXCEPTION_CAUGHT, e);
+          }
+          continue;
+        }
+      }
+      // This does not throw exception because throwOnError = false.
+      createRequestGroupForUri(result, entry.second, entry.first);
+    }
+  }
+}
+} // namespace
+#endif // ENABLE_BITTORRENT
+
 void createRequestGroupForUriList(
     std::vector<std::shared_ptr<RequestGroup>>& result,
     const std::shared_ptr<Option>& option)
 {
   auto uriListParser = openUriListParser(option->get(PREF_INPUT_FILE));
+#ifdef ENABLE_BITTORRENT
+  TorrentIngestor ingestor;
+  ingestUriList(result, option.get(), uriListParser.get(), ingestor);
+#else  // !ENABLE_BITTORRENT
   while (createRequestGroupFromUriListParser(result, option.get(),
                                              uriListParser.get()))
     ;
+#endif // !ENABLE_BITTORRENT
 }
 
 std::shared_ptr<MetadataInfo> createMetadataInfoFromFirstFileEntry(
@@ -75,6 +75,27 @@ void createRequestGroupForBitTorrent(
     const std::string& metaInfoUri, const ValueBase* torrent,
     bool adjustAnnounceUri = true);
 
+// Create RequestGroup object using DownloadContext created by
+// createBtDownloadContext() with the same option and metaInfoUri.
+// If adjustAnnounceUri is true, announce URIs are adjusted using
+// bittorrent::adjustAnnounceUri().  In this function,
+// force-sequential is ignored.
+void createRequestGroupForBitTorrent(
+    std::vector<std::shared_ptr<RequestGroup>>& result,
+    const std::shared_ptr<Option>& option, const std::string& metaInfoUri,
+    const std::shared_ptr<DownloadContext>& dctx,
+    bool adjustAnnounceUri = true);
+
+// Creates DownloadContext from decoded torrent metainfo structure,
+// which is the costly part of createRequestGroupForBitTorrent().
+// Unlike the latter, this function only reads option and is safe to
+// call from a worker thread.
+std::shared_ptr<DownloadContext>
+createBtDownloadContext(const std::shared_ptr<Option>& option,
+                        const std::vector<std::string>& uris,
+                        const std::string& metaInfoUri,
+                        const ValueBase* torrent);
+
 #endif // ENABLE_BITTORRENT
 
 #ifdef ENABLE_METALINK
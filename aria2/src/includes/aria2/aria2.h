@@ -214,6 +214,11 @@ Session* sessionNew(const KeyVals& options, const SessionConfig& config);
  * destroys the |session| object, releasing the allocated resources
  * for it. This function returns the last error code and it is the
  * equivalent to the :ref:`exit-status` of :manpage:`aria2c(1)`.
+ *
+ * If the |session| runs in :c:macro:`RUN_FOREVER` mode, this
+ * function waits for the event loop thread to finish.  It must not
+ * be called from the download event callback in that case; it
+ * returns -1 without doing anything.
  */
 int sessionFinal(Session* session);
 
@@ -230,7 +235,12 @@ enum RUN_MODE {
   /**
    * :func:`run()` returns after one event polling.
    */
-  RUN_ONCE
+  RUN_ONCE,
+  /**
+   * :func:`run()` starts the event loop in a background thread and
+   * returns immediately.  See :func:`run()` for details.
+   */
+  RUN_FOREVER
 };
 
 /**
@@ -248,10 +258,51 @@ enum RUN_MODE {
  * caller must call this function one or more time to complete
  * downloads.
  *
+ * If the |mode| is :c:macro:`RUN_FOREVER`, this function starts a
+ * thread which runs the event loop, and returns 0 immediately.  The
+ * session behaves as if :member:`SessionConfig::keepRunning` is true,
+ * and the event loop runs until :func:`shutdown()` is called.  After
+ * this call, all API functions taking the |session| can be called
+ * from any thread.  The calls are queued and executed in the event
+ * loop thread, and the caller blocks until the call completes.  The
+ * event loop is woken up immediately when a call is queued.
+ * :func:`getGlobalStat()` and :func:`getActiveDownload()` do not
+ * block; they return the statistics the event loop published most
+ * recently, which is at most 100 milliseconds old.  The download
+ * event callback is invoked in the event loop thread, and the API
+ * functions called from it are executed directly.  Do not call
+ * :func:`run()` again for this session.  :func:`sessionFinal()`
+ * requests shutdown, if it has not been requested yet, and waits
+ * for the thread to finish.
+ *
  * In either case, this function returns negative error code on error.
  */
 int run(Session* session, RUN_MODE mode);
 
+/**
+ * @functypedef
+ *
+ * Callback function passed to :func:`post()`.  The |userData| is the
+ * pointer passed to :func:`post()`.
+ */
+typedef void (*SessionCallback)(Session* session, void* userData);
+
+/**
+ * @function
+ *
+ * Schedules the |callback| to be called with the |userData| in the
+ * thread running the event loop of the |session|, and returns
+ * without waiting for it.  API functions called from the |callback|
+ * are executed directly, so this is the way to issue several calls
+ * without blocking the caller, and to receive their results
+ * asynchronously.  The callbacks are called in the order they are
+ * posted.  If the |session| does not run in :c:macro:`RUN_FOREVER`
+ * mode, or the caller is the event loop thread, the |callback| is
+ * called before this function returns.  This function returns 0 if
+ * it succeeds, or negative error code.
+ */
+int post(Session* session, SessionCallback callback, void* userData);
+
 /**
  * @function
  *
@@ -294,6 +345,93 @@ bool isNull(A2Gid gid);
 int addUri(Session* session, A2Gid* gid, const std::vector<std::string>& uris,
            const KeyVals& options, int position = -1);
 
+/**
+ * @class
+ *
+ * The interface to receive the downloaded data instead of writing it
+ * to a file.  See :func:`addUriToSink()`.
+ */
+class DataSink {
+public:
+  virtual ~DataSink() = default;
+  /**
+   * Called when the |length| bytes of data pointed by the |data| are
+   * downloaded.  The |offset| is the position of the data in the
+   * file.  This function is called from the thread running the event
+   * loop.  It must return 0 if it succeeds.  If it returns nonzero,
+   * the download is aborted with an error.
+   */
+  virtual int write(int64_t offset, const uint8_t* data, size_t length) = 0;
+};
+
+/**
+ * @class
+ *
+ * :class:`DataSink` which stores the downloaded data in memory.
+ */
+class MemoryDataSink : public DataSink {
+public:
+  MemoryDataSink();
+  virtual ~MemoryDataSink();
+  virtual int write(int64_t offset, const uint8_t* data, size_t length);
+  /**
+   * Returns the data received so far.  If the download runs in the
+   * other thread, call this function after the download finished.
+   */
+  const std::string& getData() const;
+
+private:
+  std::string data_;
+};
+
+/**
+ * @enum
+ *
+ * The order in which the downloaded data is passed to
+ * :class:`DataSink`.
+ */
+enum DataSinkMode {
+  /**
+   * The data is passed as soon as it is downloaded.  With multiple
+   * connections, the offsets are not in order.  The same range may be
+   * passed more than once if the download is restarted.
+   */
+  DATA_SINK_RANDOM,
+  /**
+   * The data is passed exactly once, in order and without gaps.  The
+   * data received out of order is held in memory until the data
+   * before it arrives.  The pieces are selected in order
+   * (:option:`--stream-piece-selector=inorder
+   * <--stream-piece-selector>`), so that the memory usage is bounded
+   * by the number of connections times the piece length.
+   */
+  DATA_SINK_SEQUENTIAL
+};
+
+/**
+ * @function
+ *
+ * Same as :func:`addUri()`, but the downloaded data is passed to the
+ * |sink| instead of being written to a file.  No file, control file
+ * and disk cache is used for this download.  The |mode| specifies the
+ * order in which the data is passed.  The |sink| must be valid until
+ * the download is stopped or removed.
+ *
+ * The |uris| must be HTTP(S) or FTP URIs pointing to a single file.
+ * The data is not read back, so the checksum verification cannot be
+ * used.  This function returns -1 if the |uris| is BitTorrent Magnet
+ * URI, or the :option:`checksum <--checksum>` option is given.  The
+ * downloaded file is not treated as .torrent or Metalink file
+ * regardless of the :option:`follow-torrent <--follow-torrent>` and
+ * :option:`follow-metalink <--follow-metalink>` options.
+ *
+ * This function returns 0 if it succeeds, or negative error code.
+ */
+int addUriToSink(Session* session, A2Gid* gid,
+                 const std::vector<std::string>& uris, const KeyVals& options,
+                 DataSink* sink, DataSinkMode mode = DATA_SINK_RANDOM,
+                 int position = -1);
+
 /**
  * @function
  *
@@ -433,9 +571,22 @@ int changeOption(Session* session, A2Gid gid, const KeyVals& options);
  *
  * Returns global option denoted by the |name|. If such option is not
  * available, returns empty string.
+ *
+ * In :c:macro:`RUN_FOREVER` mode, the reference returned to the
+ * thread other than the event loop thread is valid until the next
+ * call of this function in the same thread.  Use
+ * :func:`getGlobalOptionCopy()` to keep the value.
  */
 const std::string& getGlobalOption(Session* session, const std::string& name);
 
+/**
+ * @function
+ *
+ * Returns a copy of global option denoted by the |name|. If such
+ * option is not available, returns empty string.
+ */
+std::string getGlobalOptionCopy(Session* session, const std::string& name);
+
 /**
  * @function
  *
@@ -873,7 +1024,11 @@ public:
  * handle's member functions. The lifetime of the returned handle is
  * before the next call of :func:`run()` or
  * :func:`sessionFinal()`. The caller must call
- * :func:`deleteDownloadHandle()` before that. This function returns
+ * :func:`deleteDownloadHandle()` before that. In
+ * :c:macro:`RUN_FOREVER` mode, the handle returned to the thread
+ * other than the event loop thread holds a copy of the information
+ * taken when this function was called, and it is valid until
+ * :func:`sessionFinal()`. This function returns
  * ``NULL`` if no download denoted by the |gid| is present. It is the
  * responsibility of the caller to call :func:`deleteDownloadHandle()`
  * to delete handle object.
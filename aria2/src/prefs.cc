@@ -123,6 +123,7 @@ const std::string V_ALL("all");
 const std::string A2_V_FULL("full");
 const std::string A2_V_HIDE("hide");
 const std::string A2_V_GEOM("geom");
+const std::string A2_V_DEADLINE("deadline");
 const std::string V_PREALLOC("prealloc");
 const std::string V_FALLOC("falloc");
 const std::string V_TRUNC("trunc");
@@ -153,6 +154,10 @@ const std::string V_FTP("ftp");
 const std::string A2_V_TLS11("TLSv1.1");
 const std::string A2_V_TLS12("TLSv1.2");
 const std::string A2_V_TLS13("TLSv1.3");
+const std::string V_BLOCK("block");
+const std::string V_DROP("drop");
+const std::string V_TEXT("text");
+const std::string V_CLOSE("close");
 
 PrefPtr PREF_VERSION = makePref("version");
 PrefPtr PREF_HELP = makePref("help");
@@ -258,6 +263,10 @@ PrefPtr PREF_SERVER_STAT_TIMEOUT = makePref("server-stat-timeout");
 PrefPtr PREF_SERVER_STAT_IF = makePref("server-stat-if");
 // value: string that your file system recognizes as a file name.
 PrefPtr PREF_SERVER_STAT_OF = makePref("server-stat-of");
+// value: text | binary
+PrefPtr PREF_SERVER_STAT_FORMAT = makePref("server-stat-format");
+// value: string that your file system recognizes as a file name.
+PrefPtr PREF_PIECE_HASH_INDEX = makePref("piece-hash-index");
 // value: true | false
 PrefPtr PREF_REMOTE_TIME = makePref("remote-time");
 // value: 1*digit
@@ -286,6 +295,10 @@ PrefPtr PREF_RPC_PRIVATE_KEY = makePref("rpc-private-key");
 PrefPtr PREF_RPC_SECURE = makePref("rpc-secure");
 // value: true | false
 PrefPtr PREF_RPC_SAVE_UPLOAD_METADATA = makePref("rpc-save-upload-metadata");
+// value: 1*digit
+PrefPtr PREF_RPC_MAX_SEND_QUEUE_SIZE = makePref("rpc-max-send-queue-size");
+// value: drop | close
+PrefPtr PREF_RPC_SEND_QUEUE_OVERFLOW = makePref("rpc-send-queue-overflow");
 // value: true | false
 PrefPtr PREF_DRY_RUN = makePref("dry-run");
 // value: true | false
@@ -376,6 +389,12 @@ PrefPtr PREF_STDERR = makePref("stderr");
 // value: true | false
 PrefPtr PREF_KEEP_UNFINISHED_DOWNLOAD_RESULT =
     makePref("keep-unfinished-download-result");
+// value: true | false
+PrefPtr PREF_LOG_ASYNC = makePref("log-async");
+// value: block | drop
+PrefPtr PREF_LOG_ASYNC_OVERFLOW = makePref("log-async-overflow");
+// value: 1*digit
+PrefPtr PREF_LOG_MAX_SIZE = makePref("log-max-size");
 
 /**
  * FTP related preferences
@@ -387,9 +406,13 @@ PrefPtr PREF_FTP_TYPE = makePref("ftp-type");
 // values: true | false
 PrefPtr PREF_FTP_PASV = makePref("ftp-pasv");
 // values: true | false
+PrefPtr PREF_FTP_PIPELINING = makePref("ftp-pipelining");
+// values: true | false
 PrefPtr PREF_FTP_REUSE_CONNECTION = makePref("ftp-reuse-connection");
 // values: hashType=digest
 PrefPtr PREF_SSH_HOST_KEY_MD = makePref("ssh-host-key-md");
+// values: 1*digit
+PrefPtr PREF_SFTP_READ_AHEAD = makePref("sftp-read-ahead");
 
 /**
  * HTTP related preferences
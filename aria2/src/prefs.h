@@ -80,6 +80,7 @@ extern const std::string V_ALL;
 extern const std::string A2_V_FULL;
 extern const std::string A2_V_HIDE;
 extern const std::string A2_V_GEOM;
+extern const std::string A2_V_DEADLINE;
 extern const std::string V_PREALLOC;
 extern const std::string V_FALLOC;
 extern const std::string V_TRUNC;
@@ -110,6 +111,10 @@ extern const std::string V_FTP;
 extern const std::string A2_V_TLS11;
 extern const std::string A2_V_TLS12;
 extern const std::string A2_V_TLS13;
+extern const std::string V_BLOCK;
+extern const std::string V_DROP;
+extern const std::string V_TEXT;
+extern const std::string V_CLOSE;
 
 extern PrefPtr PREF_VERSION;
 extern PrefPtr PREF_HELP;
@@ -211,6 +216,10 @@ extern PrefPtr PREF_SERVER_STAT_TIMEOUT;
 extern PrefPtr PREF_SERVER_STAT_IF;
 // value: string that your file system recognizes as a file name.
 extern PrefPtr PREF_SERVER_STAT_OF;
+// value: text | binary
+extern PrefPtr PREF_SERVER_STAT_FORMAT;
+// value: string that your file system recognizes as a file name.
+extern PrefPtr PREF_PIECE_HASH_INDEX;
 // value: true | false
 extern PrefPtr PREF_REMOTE_TIME;
 // value: 1*digit
@@ -239,6 +248,10 @@ extern PrefPtr PREF_RPC_PRIVATE_KEY;
 extern PrefPtr PREF_RPC_SECURE;
 // value: true | false
 extern PrefPtr PREF_RPC_SAVE_UPLOAD_METADATA;
+// value: 1*digit
+extern PrefPtr PREF_RPC_MAX_SEND_QUEUE_SIZE;
+// value: drop | close
+extern PrefPtr PREF_RPC_SEND_QUEUE_OVERFLOW;
 // value: true | false
 extern PrefPtr PREF_DRY_RUN;
 // value: true | false
@@ -329,6 +342,12 @@ extern PrefPtr PREF_MAX_MMAP_LIMIT;
 extern PrefPtr PREF_STDERR;
 // value: true | false
 extern PrefPtr PREF_KEEP_UNFINISHED_DOWNLOAD_RESULT;
+// value: true | false
+extern PrefPtr PREF_LOG_ASYNC;
+// value: block | drop
+extern PrefPtr PREF_LOG_ASYNC_OVERFLOW;
+// value: 1*digit
+extern PrefPtr PREF_LOG_MAX_SIZE;
 
 /**
  * FTP related preferences
@@ -340,9 +359,13 @@ extern PrefPtr PREF_FTP_TYPE;
 // values: true | false
 extern PrefPtr PREF_FTP_PASV;
 // values: true | false
+extern PrefPtr PREF_FTP_PIPELINING;
+// values: true | false
 extern PrefPtr PREF_FTP_REUSE_CONNECTION;
 // values: hashType=digest
 extern PrefPtr PREF_SSH_HOST_KEY_MD;
+// values: 1*digit
+extern PrefPtr PREF_SFTP_READ_AHEAD;
 
 /**
  * HTTP related preferences
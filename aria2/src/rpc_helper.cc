@@ -77,7 +77,8 @@ RpcResponse createJsonRpcErrorResponse(int code, const std::string& msg,
                           std::move(id)};
 }
 
-RpcResponse processJsonRpcRequest(Dict* jsondict, DownloadEngine* e)
+RpcResponse processJsonRpcRequest(Dict* jsondict, DownloadEngine* e,
+                                  AuthTokenCache* tokenCache)
 {
   auto id = jsondict->popValue("id");
   if (!id) {
@@ -102,6 +103,7 @@ RpcResponse processJsonRpcRequest(Dict* jsondict, DownloadEngine* e)
   }
   A2_LOG_INFO(fmt("Executing RPC method %s", methodName->s().c_str()));
   RpcRequest req = {methodName->s(), std::move(params), std::move(id), true};
+  req.tokenCache = tokenCache;
   return getMethod(methodName->s())->execute(std::move(req), e);
 }
 
@@ -48,6 +48,7 @@ namespace aria2 {
 class ValueBase;
 class Dict;
 class DownloadEngine;
+class AuthTokenCache;
 
 namespace rpc {
 
@@ -62,8 +63,11 @@ RpcRequest xmlParseMemory(const char* xml, size_t size);
 RpcResponse createJsonRpcErrorResponse(int code, const std::string& msg,
                                        std::unique_ptr<ValueBase> id);
 
-// Processes JSON-RPC request |jsondict| and returns the result.
-RpcResponse processJsonRpcRequest(Dict* jsondict, DownloadEngine* e);
+// Processes JSON-RPC request |jsondict| and returns the result.  The
+// |tokenCache| is the secret token cache of the connection, or
+// nullptr.
+RpcResponse processJsonRpcRequest(Dict* jsondict, DownloadEngine* e,
+                                  AuthTokenCache* tokenCache = nullptr);
 
 } // namespace rpc
 
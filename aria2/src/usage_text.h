@@ -451,6 +451,13 @@
   _(" -q, --quiet[=true|false]     Make aria2 quiet(no console output).")
 #define TEXT_ASYNC_DNS                                          \
   _(" --async-dns[=true|false]     Enable asynchronous DNS.")
+#define TEXT_FTP_PIPELINING                                             \
+  _(" --ftp-pipelining[=true|false] Send the FTP commands which do not depend on\n" \
+    "                              each other's reply in one batch: PASS, TYPE and\n" \
+    "                              PWD after login, and CWD, MDTM and SIZE before\n" \
+    "                              each file. This saves round trips, especially\n" \
+    "                              when downloading many small files, but some\n" \
+    "                              servers do not handle pipelined commands.")
 #define TEXT_FTP_REUSE_CONNECTION                                       \
   _(" --ftp-reuse-connection[=true|false] Reuse connection in FTP.")
 #define TEXT_SUMMARY_INTERVAL                                           \
@@ -459,6 +466,27 @@
 #define TEXT_LOG_LEVEL                                          \
   _(" --log-level=LEVEL            Set log level to output to file specified using\n" \
     "                             --log option.")
+#define TEXT_LOG_ASYNC                                          \
+  _(" --log-async[=true|false]     Write the log file specified using --log option\n" \
+    "                              from a background thread. Log messages are\n" \
+    "                              queued and written in batches, which reduces\n" \
+    "                              the logging overhead of the download engine.\n" \
+    "                              This option has no effect if the log is written\n" \
+    "                              to stdout.")
+#define TEXT_LOG_ASYNC_OVERFLOW                                 \
+  _(" --log-async-overflow=POLICY  Specify what to do when the queue of the\n" \
+    "                              asynchronous logger is full. If block is given,\n" \
+    "                              aria2 waits until the queued messages are\n" \
+    "                              written. If drop is given, the message is\n" \
+    "                              discarded and the number of discarded messages\n" \
+    "                              is written to the log later.")
+#define TEXT_LOG_MAX_SIZE                                       \
+  _(" --log-max-size=SIZE          Rotate the log file when its size exceeds SIZE\n" \
+    "                              bytes. The current log file is renamed to\n" \
+    "                              FILE.1, overwriting the previous one, and a new\n" \
+    "                              log file is started. 0 means no rotation. This\n" \
+    "                              option is only effective with --log-async.\n" \
+    "                              SIZE can include K or M(1K = 1024, 1M = 1024K).")
 #define TEXT_REMOTE_TIME                                                \
   _(" -R, --remote-time[=true|false] Retrieve timestamp of the remote file from the\n" \
     "                              remote HTTP/FTP server and if it is available,\n" \
@@ -505,6 +533,12 @@
     "                              of the servers. The loaded data will be used in\n" \
     "                              some URI selector such as 'feedback'.\n" \
     "                              See also --uri-selector option")
+#define TEXT_SERVER_STAT_FORMAT                                         \
+  _(" --server-stat-format=FORMAT  Specify the format of the file saved by\n" \
+    "                              --server-stat-of option. FORMAT is either 'text'\n" \
+    "                              or 'binary'. The binary format is smaller and\n" \
+    "                              faster to load. --server-stat-if option reads\n" \
+    "                              both formats.")
 #define TEXT_SERVER_STAT_TIMEOUT                                        \
   _(" --server-stat-timeout=SEC    Specifies timeout in seconds to invalidate\n" \
     "                              performance profile of the servers since the last\n" \
@@ -829,6 +863,19 @@
   _(" --rpc-max-request-size=SIZE  Set max size of JSON-RPC/XML-RPC request. If aria2\n" \
     "                              detects the request is more than SIZE bytes, it\n" \
     "                              drops connection.")
+#define TEXT_RPC_MAX_SEND_QUEUE_SIZE                                \
+  _(" --rpc-max-send-queue-size=SIZE Set max size of the data queued to send to a\n" \
+    "                              WebSocket RPC client. If a notification would\n" \
+    "                              exceed it, aria2 handles it as specified by\n" \
+    "                              --rpc-send-queue-overflow option. 0 means no\n" \
+    "                              limit.")
+#define TEXT_RPC_SEND_QUEUE_OVERFLOW                                \
+  _(" --rpc-send-queue-overflow=POLICY Specify what aria2 does when a notification\n" \
+    "                              exceeds the limit set by\n" \
+    "                              --rpc-max-send-queue-size option. If drop is\n" \
+    "                              given, the notification is not sent to the\n" \
+    "                              client. If close is given, aria2 closes the\n" \
+    "                              connection.")
 #define TEXT_RPC_USER                               \
   _(" --rpc-user=USER              Set JSON-RPC/XML-RPC user. This option will be\n" \
     "                              deprecated in the future release. Migrate to\n" \
@@ -880,7 +927,16 @@
     "                              will reduce the number of establishing connection\n" \
     "                              and at the same time it will download the\n" \
     "                              beginning part of the file first. This will be\n" \
-    "                              useful to view movie while downloading it.")
+    "                              useful to view movie while downloading it.\n" \
+    "                              If 'deadline' is given, aria2 selects piece\n" \
+    "                              which the player reaches first, counting from\n" \
+    "                              the playback position given by\n"   \
+    "                              aria2.changePlaybackPosition RPC method. The\n" \
+    "                              pieces the player reaches in 20 seconds are\n" \
+    "                              assigned to the connections which can complete\n" \
+    "                              them in time, and a late piece is taken over by\n" \
+    "                              a faster connection. This also applies to\n" \
+    "                              BitTorrent downloads.")
 #define TEXT_TRUNCATE_CONSOLE_READOUT                                   \
   _(" --truncate-console-readout[=true|false] Truncate console readout to fit in\n"\
     "                              a single line.")
@@ -923,6 +979,14 @@
     "                              option will be ignored in BitTorrent downloads.\n" \
     "                              It will be also ignored if Metalink file\n" \
     "                              contains piece hashes.")
+#define TEXT_PIECE_HASH_INDEX                                           \
+  _(" --piece-hash-index=FILE      Load the index of the pieces of completed\n" \
+    "                              downloads from FILE, add the pieces of the\n" \
+    "                              downloads completing with piece hashes to it,\n" \
+    "                              and save it to FILE on exit. A download with\n" \
+    "                              piece hashes copies the pieces found in the\n" \
+    "                              index from the local files after verifying\n" \
+    "                              their hashes, instead of fetching them.")
 #define TEXT_STOP_WITH_PROCESS                                          \
   _(" --stop-with-process=PID      Stop application when process PID is not running.\n" \
     "                              This is useful if aria2 process is forked from a\n" \
@@ -1077,6 +1141,13 @@
     "                              If true is given, deny legacy BitTorrent\n" \
     "                              handshake and only use Obfuscation handshake and\n" \
     "                              always encrypt message payload.")
+#define TEXT_SFTP_READ_AHEAD                                            \
+  _(" --sftp-read-ahead=SIZE       Keep read requests for up to SIZE bytes in\n" \
+    "                              flight per SFTP connection. The throughput of a\n" \
+    "                              connection is at most SIZE per round trip time.\n" \
+    "                              0 leaves the read requests to libssh2, which\n" \
+    "                              keeps 64KiB in flight.\n" \
+    "                              You can append K or M (1K = 1024, 1M = 1024K).")
 #define TEXT_SSH_HOST_KEY_MD                                            \
   _(" --ssh-host-key-md=TYPE=DIGEST\n"                                  \
     "                              Set checksum for SSH host public key. TYPE is\n" \
@@ -39,7 +39,9 @@ namespace aria2 {
 namespace global {
 
 // Global clock, this clock is reset before executeCommand() call to
-// reduce the call gettimeofday() system call.
+// reduce the call gettimeofday() system call.  Objects created or
+// updated from commands should take the time from here instead of
+// constructing Timer, which reads the current TimeSource.
 Timer& wallclock();
 
 } // namespace global
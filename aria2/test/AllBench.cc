@@ -0,0 +1,96 @@
+#include "Bench.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <vector>
+#include <utility>
+
+#include "Platform.h"
+#include "SocketCore.h"
+#include "util.h"
+#include "console.h"
+
+namespace aria2 {
+
+namespace bench {
+
+namespace {
+std::vector<std::pair<const char*, BenchmarkFunc>>& benchmarks()
+{
+  static std::vector<std::pair<const char*, BenchmarkFunc>> v;
+  return v;
+}
+} // namespace
+
+namespace {
+const char* currentName = "";
+double scaleFactor = 1.0;
+} // namespace
+
+int registerBenchmark(const char* name, BenchmarkFunc func)
+{
+  benchmarks().emplace_back(name, func);
+  return 0;
+}
+
+double now()
+{
+  using namespace std::chrono;
+  return duration_cast<duration<double>>(
+             steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void report(const std::string& label, double value, const char* unit)
+{
+  printf("%-32s %-40s %16.2f %s\n", currentName, label.c_str(), value, unit);
+  fflush(stdout);
+}
+
+size_t scale(size_t n)
+{
+  auto res = static_cast<size_t>(n * scaleFactor);
+  return res == 0 ? 1 : res;
+}
+
+} // namespace bench
+
+} // namespace aria2
+
+// Usage: aria2bench [-s SCALE] [NAME...]
+//
+// Runs the benchmarks whose name contains one of NAMEs, or all of
+// them if no NAME is given.  SCALE multiplies the iteration counts.
+int main(int argc, char* argv[])
+{
+  aria2::global::initConsole(true);
+  aria2::Platform platform;
+  aria2::util::mkdirs(A2_TEST_OUT_DIR);
+
+  std::vector<const char*> filters;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+      aria2::bench::scaleFactor = strtod(argv[++i], nullptr);
+    }
+    else {
+      filters.push_back(argv[i]);
+    }
+  }
+  for (auto& b : aria2::bench::benchmarks()) {
+    bool run = filters.empty();
+    for (auto f : filters) {
+      if (strstr(b.first, f)) {
+        run = true;
+        break;
+      }
+    }
+    if (!run) {
+      continue;
+    }
+    aria2::bench::currentName = b.first;
+    b.second();
+  }
+  return 0;
+}
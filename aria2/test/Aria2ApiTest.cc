@@ -7,17 +7,21 @@
 #include "OptionParser.h"
 #include "OptionHandler.h"
 #include "RequestGroupMan.h"
+#include "RequestGroup.h"
 #include "Context.h"
 #include "MultiUrlRequestInfo.h"
 #include "DownloadEngine.h"
 #include "Option.h"
 
+#include <thread>
+
 namespace aria2 {
 
 class Aria2ApiTest : public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(Aria2ApiTest);
   CPPUNIT_TEST(testAddUri);
+  CPPUNIT_TEST(testAddUriToSink);
   CPPUNIT_TEST(testAddMetalink);
   CPPUNIT_TEST(testAddTorrent);
   CPPUNIT_TEST(testRemovePause);
@@ -25,6 +29,7 @@ class Aria2ApiTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testChangeOption);
   CPPUNIT_TEST(testChangeGlobalOption);
   CPPUNIT_TEST(testDownloadResultDH);
+  CPPUNIT_TEST(testRunForever);
   CPPUNIT_TEST_SUITE_END();
 
   Session* session_;
@@ -40,6 +45,7 @@ public:
   void tearDown() { sessionFinal(session_); }
 
   void testAddUri();
+  void testAddUriToSink();
   void testAddMetalink();
   void testAddTorrent();
   void testRemovePause();
@@ -47,6 +53,7 @@ public:
   void testChangeOption();
   void testChangeGlobalOption();
   void testDownloadResultDH();
+  void testRunForever();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(Aria2ApiTest);
@@ -72,6 +79,38 @@ void Aria2ApiTest::testAddUri()
   CPPUNIT_ASSERT_EQUAL(-1, addUri(session_, &gid, uris, options));
 }
 
+void Aria2ApiTest::testAddUriToSink()
+{
+  MemoryDataSink sink;
+  A2Gid gid;
+  std::vector<std::string> uris(1);
+  KeyVals options;
+  uris[0] = "http://localhost/1";
+  CPPUNIT_ASSERT_EQUAL(0, addUriToSink(session_, &gid, uris, options, &sink,
+                                       DATA_SINK_SEQUENTIAL));
+  CPPUNIT_ASSERT(!isNull(gid));
+
+  auto group = session_->context->reqinfo->getDownloadEngine()
+                   ->getRequestGroupMan()
+                   ->findGroup(gid);
+  CPPUNIT_ASSERT(group);
+  CPPUNIT_ASSERT(group->inMemoryDownload());
+  CPPUNIT_ASSERT(!group->isPreLocalFileCheckEnabled());
+  CPPUNIT_ASSERT_EQUAL(V_INORDER,
+                       group->getOption()->get(PREF_STREAM_PIECE_SELECTOR));
+
+  options.push_back(KeyVals::value_type(
+      "checksum", "sha-1=0192ba11326fe2298c8cb4de616f4d4140213837"));
+  CPPUNIT_ASSERT_EQUAL(-1,
+                       addUriToSink(session_, &gid, uris, options, &sink));
+#ifdef ENABLE_BITTORRENT
+  options.clear();
+  uris[0] = "magnet:?xt=urn:btih:248d0a1cd08284299de78d5c1ed359bb46717d8c";
+  CPPUNIT_ASSERT_EQUAL(-1,
+                       addUriToSink(session_, &gid, uris, options, &sink));
+#endif // ENABLE_BITTORRENT
+}
+
 void Aria2ApiTest::testAddMetalink()
 {
   std::string metalinkPath = A2_TEST_DIR "/metalink4.xml";
@@ -248,4 +287,74 @@ void Aria2ApiTest::testDownloadResultDH()
   deleteDownloadHandle(hd);
 }
 
+namespace {
+void recordThreadId(Session* session, void* userData)
+{
+  *static_cast<std::thread::id*>(userData) = std::this_thread::get_id();
+}
+} // namespace
+
+void Aria2ApiTest::testRunForever()
+{
+  std::vector<A2Gid> gids(3);
+  std::vector<std::string> uris(1);
+  KeyVals options;
+  uris[0] = "http://localhost/1";
+  for (auto& gid : gids) {
+    CPPUNIT_ASSERT_EQUAL(0, addUri(session_, &gid, uris, options));
+    CPPUNIT_ASSERT_EQUAL(0, pauseDownload(session_, gid));
+  }
+
+  CPPUNIT_ASSERT_EQUAL(0, run(session_, RUN_FOREVER));
+  // Only one event loop thread per session
+  CPPUNIT_ASSERT_EQUAL(-1, run(session_, RUN_FOREVER));
+  CPPUNIT_ASSERT_EQUAL(-1, run(session_, RUN_ONCE));
+
+  DownloadHandle* hd = getDownloadHandle(session_, gids[0]);
+  CPPUNIT_ASSERT(hd);
+  CPPUNIT_ASSERT_EQUAL(DOWNLOAD_PAUSED, hd->getStatus());
+  CPPUNIT_ASSERT_EQUAL(1, hd->getNumFiles());
+  CPPUNIT_ASSERT_EQUAL(uris[0], hd->getFile(1).uris[0].uri);
+  deleteDownloadHandle(hd);
+  // The statistics reflect the calls made so far.
+  CPPUNIT_ASSERT_EQUAL(3, getGlobalStat(session_).numWaiting);
+  CPPUNIT_ASSERT(getActiveDownload(session_).empty());
+
+  CPPUNIT_ASSERT_EQUAL(0,
+                       changePosition(session_, gids[2], 0, OFFSET_MODE_SET));
+  CPPUNIT_ASSERT_EQUAL(0, removeDownload(session_, gids[1]));
+  CPPUNIT_ASSERT(!getDownloadHandle(session_, gids[1]));
+  CPPUNIT_ASSERT_EQUAL(2, getGlobalStat(session_).numWaiting);
+
+  options = {{PREF_FILE_ALLOCATION->k, "none"}};
+  CPPUNIT_ASSERT_EQUAL(0, changeGlobalOption(session_, options));
+  const auto& fileAllocation =
+      getGlobalOption(session_, PREF_FILE_ALLOCATION->k);
+  CPPUNIT_ASSERT_EQUAL(std::string("none"), fileAllocation);
+  auto fileAllocationCopy =
+      getGlobalOptionCopy(session_, PREF_FILE_ALLOCATION->k);
+  CPPUNIT_ASSERT_EQUAL(std::string("none"), fileAllocationCopy);
+  // Changing the option in the engine thread does not touch the value
+  // returned to this thread.
+  CPPUNIT_ASSERT_EQUAL(
+      0, changeGlobalOption(session_, {{PREF_FILE_ALLOCATION->k, "trunc"}}));
+  CPPUNIT_ASSERT_EQUAL(std::string("none"), fileAllocation);
+  CPPUNIT_ASSERT_EQUAL(std::string("none"), fileAllocationCopy);
+  CPPUNIT_ASSERT_EQUAL(std::string("trunc"),
+                       getGlobalOptionCopy(session_, PREF_FILE_ALLOCATION->k));
+
+  std::thread::id tid;
+  CPPUNIT_ASSERT_EQUAL(0, post(session_, recordThreadId, &tid));
+  // Calls are executed in order, so the callback has run once this
+  // returns.
+  getGlobalOptions(session_);
+  CPPUNIT_ASSERT(std::thread::id() != tid);
+  CPPUNIT_ASSERT(std::this_thread::get_id() != tid);
+
+  A2Gid gid;
+  CPPUNIT_ASSERT_EQUAL(0, addUri(session_, &gid, uris, options));
+  CPPUNIT_ASSERT(!isNull(gid));
+  CPPUNIT_ASSERT_EQUAL(0, shutdown(session_, true));
+}
+
 } // namespace aria2
@@ -0,0 +1,176 @@
+#include "AsyncLogWriter.h"
+
+#include <thread>
+#include <vector>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "File.h"
+#include "Exception.h"
+#include "TestUtil.h"
+#include "util.h"
+
+namespace aria2 {
+
+class AsyncLogWriterTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(AsyncLogWriterTest);
+  CPPUNIT_TEST(testPush);
+  CPPUNIT_TEST(testPush_multipleProducers);
+  CPPUNIT_TEST(testPush_drop);
+  CPPUNIT_TEST(testRotate);
+  CPPUNIT_TEST(testOpen_fail);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testPush();
+  void testPush_multipleProducers();
+  void testPush_drop();
+  void testRotate();
+  void testOpen_fail();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(AsyncLogWriterTest);
+
+namespace {
+struct timeval makeTimeval()
+{
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return tv;
+}
+} // namespace
+
+namespace {
+std::vector<std::string> readLines(const std::string& path)
+{
+  auto s = readFile(path);
+  std::vector<std::string> lines;
+  util::split(std::begin(s), std::end(s), std::back_inserter(lines), '\n');
+  return lines;
+}
+} // namespace
+
+void AsyncLogWriterTest::testPush()
+{
+  File f(A2_TEST_OUT_DIR "/aria2_AsyncLogWriterTest_testPush.log");
+  f.remove();
+  {
+    AsyncLogWriter writer(f.getPath(), 4, AsyncLogWriter::OVERFLOW_BLOCK, 0);
+    CPPUNIT_ASSERT_EQUAL((size_t)4, writer.getCapacity());
+    auto tv = makeTimeval();
+    for (int i = 0; i < 10; ++i) {
+      CPPUNIT_ASSERT(writer.push(tv, "INFO", "foo.cc", i,
+                                 "message" + util::itos(i), ""));
+    }
+    CPPUNIT_ASSERT(writer.push(tv, "ERROR", "bar.cc", 100, "failure",
+                               "trace1\ntrace2\n"));
+    writer.flush();
+    CPPUNIT_ASSERT_EQUAL((uint64_t)11, writer.getWrittenCount());
+    auto lines = readLines(f.getPath());
+    CPPUNIT_ASSERT_EQUAL((size_t)13, lines.size());
+    for (int i = 0; i < 10; ++i) {
+      CPPUNIT_ASSERT(util::endsWith(lines[i], " [INFO] [foo.cc:" +
+                                                  util::itos(i) + "] message" +
+                                                  util::itos(i)));
+    }
+    CPPUNIT_ASSERT(
+        util::endsWith(lines[10], " [ERROR] [bar.cc:100] failure"));
+    CPPUNIT_ASSERT_EQUAL(std::string("trace1"), lines[11]);
+    CPPUNIT_ASSERT_EQUAL(std::string("trace2"), lines[12]);
+    // The messages pushed after flush() are written by the
+    // destructor.
+    CPPUNIT_ASSERT(writer.push(tv, "DEBUG", "baz.cc", 1, "last", ""));
+  }
+  auto lines = readLines(f.getPath());
+  CPPUNIT_ASSERT_EQUAL((size_t)14, lines.size());
+  CPPUNIT_ASSERT(util::endsWith(lines[13], " [DEBUG] [baz.cc:1] last"));
+}
+
+void AsyncLogWriterTest::testPush_multipleProducers()
+{
+  File f(A2_TEST_OUT_DIR
+         "/aria2_AsyncLogWriterTest_testPush_multipleProducers.log");
+  f.remove();
+  const int numThreads = 4;
+  const int numRecords = 1000;
+  {
+    AsyncLogWriter writer(f.getPath(), 16, AsyncLogWriter::OVERFLOW_BLOCK, 0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i) {
+      threads.emplace_back([&writer, i] {
+        auto tv = makeTimeval();
+        for (int j = 0; j < numRecords; ++j) {
+          writer.push(tv, "INFO", "foo.cc", i, "message", "");
+        }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    writer.flush();
+    CPPUNIT_ASSERT_EQUAL((uint64_t)0, writer.getDroppedCount());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)numThreads * numRecords,
+                         writer.getWrittenCount());
+  }
+  auto lines = readLines(f.getPath());
+  CPPUNIT_ASSERT_EQUAL((size_t)numThreads * numRecords, lines.size());
+}
+
+void AsyncLogWriterTest::testPush_drop()
+{
+  File f(A2_TEST_OUT_DIR "/aria2_AsyncLogWriterTest_testPush_drop.log");
+  f.remove();
+  uint64_t written, dropped;
+  {
+    AsyncLogWriter writer(f.getPath(), 2, AsyncLogWriter::OVERFLOW_DROP, 0);
+    auto tv = makeTimeval();
+    for (int i = 0; i < 10000; ++i) {
+      writer.push(tv, "INFO", "foo.cc", i, "message", "");
+    }
+    writer.flush();
+    written = writer.getWrittenCount();
+    dropped = writer.getDroppedCount();
+    CPPUNIT_ASSERT_EQUAL((uint64_t)10000, written + dropped);
+  }
+  auto lines = readLines(f.getPath());
+  // If some records are dropped, one line reports the number of
+  // them.
+  CPPUNIT_ASSERT_EQUAL((size_t)written + (dropped > 0), lines.size());
+}
+
+void AsyncLogWriterTest::testRotate()
+{
+  File f(A2_TEST_OUT_DIR "/aria2_AsyncLogWriterTest_testRotate.log");
+  File backup(f.getPath() + ".1");
+  f.remove();
+  backup.remove();
+  {
+    AsyncLogWriter writer(f.getPath(), 16, AsyncLogWriter::OVERFLOW_BLOCK,
+                          256);
+    auto tv = makeTimeval();
+    CPPUNIT_ASSERT(
+        writer.push(tv, "INFO", "foo.cc", 1, std::string(300, 'a'), ""));
+    writer.flush();
+    CPPUNIT_ASSERT(backup.exists());
+    CPPUNIT_ASSERT(backup.size() > 300);
+    CPPUNIT_ASSERT_EQUAL((int64_t)0, f.size());
+    CPPUNIT_ASSERT(writer.push(tv, "INFO", "foo.cc", 2, "bravo", ""));
+  }
+  CPPUNIT_ASSERT(util::endsWith(readFile(f.getPath()),
+                                " [INFO] [foo.cc:2] bravo\n"));
+}
+
+void AsyncLogWriterTest::testOpen_fail()
+{
+  try {
+    AsyncLogWriter writer(A2_TEST_OUT_DIR "/nonexistent/dir/log", 16,
+                          AsyncLogWriter::OVERFLOW_BLOCK, 0);
+    CPPUNIT_FAIL("exception must be thrown.");
+  }
+  catch (Exception& e) {
+    // success
+  }
+}
+
+} // namespace aria2
@@ -0,0 +1,38 @@
+#include "AuthTokenCache.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace aria2 {
+
+class AuthTokenCacheTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(AuthTokenCacheTest);
+  CPPUNIT_TEST(testMatch);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testMatch();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(AuthTokenCacheTest);
+
+void AuthTokenCacheTest::testMatch()
+{
+  AuthTokenCache cache;
+  // An empty cache matches nothing, not even an empty token.
+  CPPUNIT_ASSERT(!cache.match(""));
+  CPPUNIT_ASSERT(!cache.match("secret"));
+  cache.store("secret");
+  CPPUNIT_ASSERT(cache.match("secret"));
+  CPPUNIT_ASSERT(!cache.match("secreT"));
+  CPPUNIT_ASSERT(!cache.match("secret2"));
+  CPPUNIT_ASSERT(!cache.match("secre"));
+  CPPUNIT_ASSERT(!cache.match(""));
+  cache.store("");
+  CPPUNIT_ASSERT(cache.match(""));
+  CPPUNIT_ASSERT(!cache.match("secret"));
+  cache.clear();
+  CPPUNIT_ASSERT(!cache.match(""));
+}
+
+} // namespace aria2
@@ -0,0 +1,49 @@
+#ifndef D_BENCH_H
+#define D_BENCH_H
+
+#include "common.h"
+
+#include <string>
+
+// Minimal benchmark harness for aria2bench.  A benchmark is a
+// function which runs the code under measurement and reports the
+// results using bench::report().  Define a benchmark with:
+//
+// A2_BENCHMARK(LoggerSync)
+// {
+//   ...
+//   bench::report("events", n / elapsed, "events/s");
+// }
+
+namespace aria2 {
+
+namespace bench {
+
+typedef void (*BenchmarkFunc)();
+
+// Registers |func| under |name|.  Always returns 0.
+int registerBenchmark(const char* name, BenchmarkFunc func);
+
+// Returns the current monotonic time in seconds.
+double now();
+
+// Prints the result |value| in |unit| labeled with |label| for the
+// benchmark currently running.
+void report(const std::string& label, double value, const char* unit);
+
+// Returns the number of iterations scaled by the -s command-line
+// option of aria2bench.  Use this for the loop count so that quick
+// runs are possible.
+size_t scale(size_t n);
+
+} // namespace bench
+
+} // namespace aria2
+
+#define A2_BENCHMARK(name)                                                     \
+  static void a2bench_##name();                                                \
+  static int a2bench_##name##_reg =                                            \
+      aria2::bench::registerBenchmark(#name, a2bench_##name);                  \
+  static void a2bench_##name()
+
+#endif // D_BENCH_H
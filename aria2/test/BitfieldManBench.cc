@@ -0,0 +1,93 @@
+#include "Bench.h"
+
+#include <vector>
+
+#include "BitfieldMan.h"
+#include "LongestSequencePieceSelector.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+namespace {
+const int32_t BLOCK_LENGTH = 16_k;
+const size_t NUM_BLOCKS = 500000;
+const size_t SPLIT = 16;
+const int32_t MIN_SPLIT_SIZE = 20_m;
+
+// A download of NUM_BLOCKS blocks in the middle of the transfer with
+// --split=16: each connection has completed the first half of its
+// range, and uses the block at its head.
+void setupHalfway(BitfieldMan& bm)
+{
+  std::vector<unsigned char> bits(bm.getBitfieldLength());
+  std::vector<size_t> heads;
+  size_t range = NUM_BLOCKS / SPLIT;
+  for (size_t i = 0; i < SPLIT; ++i) {
+    size_t head = i * range + range / 2;
+    for (size_t j = i * range; j < head; ++j) {
+      bits[j / 8] |= 128 >> (j % 8);
+    }
+    heads.push_back(head);
+  }
+  bm.setBitfield(bits.data(), bits.size());
+  for (auto head : heads) {
+    bm.setUseBit(head);
+  }
+}
+
+template <typename F> void measure(const char* label, F f)
+{
+  auto n = bench::scale(2000);
+  volatile size_t sink = 0;
+  auto start = bench::now();
+  for (size_t i = 0; i < n; ++i) {
+    sink = sink + f();
+  }
+  auto end = bench::now();
+  bench::report(label, (end - start) * 1e6 / n, "us/op");
+}
+} // namespace
+
+// The queries of segment and piece selection on a 500k block file.
+A2_BENCHMARK(BitfieldManQuery)
+{
+  BitfieldMan bm(BLOCK_LENGTH,
+                 static_cast<int64_t>(NUM_BLOCKS) * BLOCK_LENGTH);
+  setupHalfway(bm);
+  std::vector<unsigned char> ignore(bm.getBitfieldLength());
+  size_t index;
+  measure("getSparseMissingUnusedIndex", [&] {
+    bm.getSparseMissingUnusedIndex(index, MIN_SPLIT_SIZE, ignore.data(),
+                                   ignore.size());
+    return index;
+  });
+  measure("getGeomMissingUnusedIndex", [&] {
+    bm.getGeomMissingUnusedIndex(index, MIN_SPLIT_SIZE, ignore.data(),
+                                 ignore.size(), 1.5, 0);
+    return index;
+  });
+  measure("getInorderMissingUnusedIndex", [&] {
+    bm.getInorderMissingUnusedIndex(index, MIN_SPLIT_SIZE, ignore.data(),
+                                    ignore.size());
+    return index;
+  });
+  measure("getFirstMissingUnusedIndex", [&] {
+    bm.getFirstMissingUnusedIndex(index);
+    return index;
+  });
+  measure("getMissingUnusedLength", [&] {
+    return bm.getMissingUnusedLength(NUM_BLOCKS / SPLIT / 2 + 1);
+  });
+  std::vector<unsigned char> peer(bm.getBitfieldLength());
+  peer.back() = 0x80;
+  measure("hasMissingPiece", [&] {
+    return bm.hasMissingPiece(peer.data(), peer.size());
+  });
+  LongestSequencePieceSelector selector;
+  measure("LongestSequencePieceSelector", [&] {
+    selector.select(index, bm.getBitfield(), NUM_BLOCKS);
+    return index;
+  });
+}
+
+} // namespace aria2
@@ -1,6 +1,7 @@
 #include "ChunkedDecodingStreamFilter.h"
 
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <cppunit/extensions/HelperMacros.h>
 
@@ -10,6 +11,10 @@
 #include "SinkStreamFilter.h"
 #include "MockSegment.h"
 #include "a2functional.h"
+#include "PiecedSegment.h"
+#include "Piece.h"
+#include "DirectDiskAdaptor.h"
+#include "WrDiskCache.h"
 
 namespace aria2 {
 
@@ -22,6 +27,7 @@ class ChunkedDecodingStreamFilterTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testTransform_largeChunkSize);
   CPPUNIT_TEST(testTransform_tooLargeChunkSize);
   CPPUNIT_TEST(testTransform_chunkSizeMismatch);
+  CPPUNIT_TEST(testReserve);
   CPPUNIT_TEST(testGetName);
   CPPUNIT_TEST_SUITE_END();
 
@@ -48,6 +54,7 @@ public:
   void testTransform_largeChunkSize();
   void testTransform_tooLargeChunkSize();
   void testTransform_chunkSizeMismatch();
+  void testReserve();
   void testGetName();
 };
 
@@ -264,6 +271,46 @@ void ChunkedDecodingStreamFilterTest::testTransform_chunkSizeMismatch()
   }
 }
 
+void ChunkedDecodingStreamFilterTest::testReserve()
+{
+  auto adaptor = std::make_shared<DirectDiskAdaptor>();
+  auto dw = make_unique<ByteArrayDiskWriter>();
+  auto writer = dw.get();
+  adaptor->setDiskWriter(std::move(dw));
+  WrDiskCache dc(1_m);
+  auto piece = std::make_shared<Piece>(0, 1_k);
+  piece->initWrCache(&dc, adaptor);
+  std::shared_ptr<Segment> segment =
+      std::make_shared<PiecedSegment>(1_k, piece);
+  ChunkedDecodingStreamFilter filter(make_unique<SinkStreamFilter>(&dc));
+  filter.init();
+  size_t len = 16_k;
+  // The chunk size is not known yet.
+  CPPUNIT_ASSERT(!filter.reserve(segment, len));
+  std::string header = "a\r\n123";
+  filter.transform(adaptor, segment,
+                   reinterpret_cast<const unsigned char*>(header.data()),
+                   header.size());
+  // The rest of the chunk data
+  auto buf = filter.reserve(segment, len);
+  CPPUNIT_ASSERT(buf);
+  CPPUNIT_ASSERT_EQUAL((size_t)7, len);
+  memcpy(buf, "4567890", len);
+  CPPUNIT_ASSERT_EQUAL((ssize_t)7,
+                       filter.transform(adaptor, segment, buf, len));
+  CPPUNIT_ASSERT_EQUAL((size_t)7, filter.getBytesProcessed());
+  // CRLF follows.
+  len = 16_k;
+  CPPUNIT_ASSERT(!filter.reserve(segment, len));
+  std::string trailer = "\r\n0\r\n\r\n";
+  filter.transform(adaptor, segment,
+                   reinterpret_cast<const unsigned char*>(trailer.data()),
+                   trailer.size());
+  CPPUNIT_ASSERT(filter.finished());
+  piece->flushWrCache(&dc);
+  CPPUNIT_ASSERT_EQUAL(std::string("1234567890"), writer->getString());
+}
+
 void ChunkedDecodingStreamFilterTest::testGetName()
 {
   CPPUNIT_ASSERT_EQUAL(std::string("ChunkedDecodingStreamFilter"),
@@ -0,0 +1,182 @@
+#include "DataSinkDiskWriter.h"
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "DlAbortEx.h"
+
+namespace aria2 {
+
+class DataSinkDiskWriterTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(DataSinkDiskWriterTest);
+  CPPUNIT_TEST(testWriteData_random);
+  CPPUNIT_TEST(testWriteData_sequential);
+  CPPUNIT_TEST(testWriteData_sequentialOverlap);
+  CPPUNIT_TEST(testWriteData_sequentialRestart);
+  CPPUNIT_TEST(testWriteData_sinkError);
+  CPPUNIT_TEST(testReadData);
+  CPPUNIT_TEST(testMemoryDataSink);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testWriteData_random();
+  void testWriteData_sequential();
+  void testWriteData_sequentialOverlap();
+  void testWriteData_sequentialRestart();
+  void testWriteData_sinkError();
+  void testReadData();
+  void testMemoryDataSink();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DataSinkDiskWriterTest);
+
+namespace {
+class MockDataSink : public DataSink {
+public:
+  MockDataSink() : fail(false) {}
+  virtual int write(int64_t offset, const uint8_t* data,
+                    size_t length) CXX11_OVERRIDE
+  {
+    if (fail) {
+      return -1;
+    }
+    writes.emplace_back(offset, std::string(data, data + length));
+    return 0;
+  }
+  std::vector<std::pair<int64_t, std::string>> writes;
+  bool fail;
+};
+
+void write(DiskWriter& dw, const std::string& s, int64_t offset)
+{
+  dw.writeData(reinterpret_cast<const unsigned char*>(s.data()), s.size(),
+               offset);
+}
+} // namespace
+
+void DataSinkDiskWriterTest::testWriteData_random()
+{
+  MockDataSink sink;
+  DataSinkDiskWriterFactory factory(&sink, DATA_SINK_RANDOM);
+  auto dw = factory.newDiskWriter("out");
+  dw->initAndOpenFile();
+  write(*dw, "World", 6);
+  write(*dw, "Hello ", 0);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, sink.writes.size());
+  CPPUNIT_ASSERT_EQUAL((int64_t)6, sink.writes[0].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("World"), sink.writes[0].second);
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, sink.writes[1].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("Hello "), sink.writes[1].second);
+  CPPUNIT_ASSERT_EQUAL((int64_t)11, dw->size());
+}
+
+void DataSinkDiskWriterTest::testWriteData_sequential()
+{
+  MockDataSink sink;
+  auto feeder = std::make_shared<DataSinkFeeder>(&sink, DATA_SINK_SEQUENTIAL);
+  DataSinkDiskWriter dw(feeder);
+  write(dw, "lo ", 3);
+  write(dw, "World", 6);
+  CPPUNIT_ASSERT(sink.writes.empty());
+  CPPUNIT_ASSERT_EQUAL((size_t)8, feeder->getBufferedLength());
+  CPPUNIT_ASSERT_EQUAL((int64_t)11, dw.size());
+
+  write(dw, "Hel", 0);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, sink.writes.size());
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, sink.writes[0].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("Hel"), sink.writes[0].second);
+  CPPUNIT_ASSERT_EQUAL((int64_t)3, sink.writes[1].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("lo "), sink.writes[1].second);
+  CPPUNIT_ASSERT_EQUAL((int64_t)6, sink.writes[2].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("World"), sink.writes[2].second);
+  CPPUNIT_ASSERT_EQUAL((int64_t)11, feeder->getOffset());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, feeder->getBufferedLength());
+}
+
+void DataSinkDiskWriterTest::testWriteData_sequentialOverlap()
+{
+  MockDataSink sink;
+  auto feeder = std::make_shared<DataSinkFeeder>(&sink, DATA_SINK_SEQUENTIAL);
+  DataSinkDiskWriter dw(feeder);
+  write(dw, "Hello", 0);
+  // Already passed
+  write(dw, "ell", 1);
+  // Partially passed
+  write(dw, "lo W", 3);
+  // Held data overlapping with the data passed later
+  write(dw, "ld", 9);
+  write(dw, "orl", 7);
+  CPPUNIT_ASSERT_EQUAL((size_t)4, sink.writes.size());
+  CPPUNIT_ASSERT_EQUAL((int64_t)5, sink.writes[1].first);
+  CPPUNIT_ASSERT_EQUAL(std::string(" W"), sink.writes[1].second);
+  CPPUNIT_ASSERT_EQUAL((int64_t)7, sink.writes[2].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("orl"), sink.writes[2].second);
+  CPPUNIT_ASSERT_EQUAL((int64_t)10, sink.writes[3].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("d"), sink.writes[3].second);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, feeder->getBufferedLength());
+  CPPUNIT_ASSERT_EQUAL((int64_t)11, feeder->getOffset());
+}
+
+void DataSinkDiskWriterTest::testWriteData_sequentialRestart()
+{
+  MockDataSink sink;
+  DataSinkDiskWriterFactory factory(&sink, DATA_SINK_SEQUENTIAL);
+  auto dw = factory.newDiskWriter("out");
+  write(*dw, "Hello", 0);
+  write(*dw, "World", 6);
+  // The download is restarted from the beginning.
+  dw = factory.newDiskWriter("out");
+  dw->initAndOpenFile();
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, dw->size());
+  write(*dw, "Hello ", 0);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, sink.writes.size());
+  CPPUNIT_ASSERT_EQUAL((int64_t)5, sink.writes[1].first);
+  CPPUNIT_ASSERT_EQUAL(std::string(" "), sink.writes[1].second);
+  CPPUNIT_ASSERT_EQUAL((int64_t)6, sink.writes[2].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("World"), sink.writes[2].second);
+}
+
+void DataSinkDiskWriterTest::testWriteData_sinkError()
+{
+  MockDataSink sink;
+  sink.fail = true;
+  DataSinkDiskWriterFactory factory(&sink, DATA_SINK_RANDOM);
+  auto dw = factory.newDiskWriter("out");
+  try {
+    write(*dw, "Hello", 0);
+    CPPUNIT_FAIL("exception must be thrown.");
+  }
+  catch (DlAbortEx& e) {
+  }
+}
+
+void DataSinkDiskWriterTest::testReadData()
+{
+  MockDataSink sink;
+  DataSinkDiskWriterFactory factory(&sink, DATA_SINK_RANDOM);
+  auto dw = factory.newDiskWriter("out");
+  write(*dw, "Hello", 0);
+  unsigned char buf[5];
+  try {
+    dw->readData(buf, sizeof(buf), 0);
+    CPPUNIT_FAIL("exception must be thrown.");
+  }
+  catch (DlAbortEx& e) {
+  }
+}
+
+void DataSinkDiskWriterTest::testMemoryDataSink()
+{
+  MemoryDataSink sink;
+  DataSinkDiskWriterFactory factory(&sink, DATA_SINK_RANDOM);
+  auto dw = factory.newDiskWriter("out");
+  write(*dw, "World", 6);
+  write(*dw, "Hello ", 0);
+  CPPUNIT_ASSERT_EQUAL(std::string("Hello World"), sink.getData());
+}
+
+} // namespace aria2
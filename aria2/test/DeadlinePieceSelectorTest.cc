@@ -0,0 +1,69 @@
+#include "DeadlinePieceSelector.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "BitfieldMan.h"
+#include "PlaybackCursor.h"
+#include "MockPieceSelector.h"
+#include "wallclock.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+class DeadlinePieceSelectorTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(DeadlinePieceSelectorTest);
+  CPPUNIT_TEST(testSelect);
+  CPPUNIT_TEST_SUITE_END();
+
+  ManualTimeSource source_;
+  TimeSource* prev_;
+
+public:
+  void setUp()
+  {
+    prev_ = setTimeSource(&source_);
+    global::wallclock().reset();
+  }
+
+  void tearDown()
+  {
+    setTimeSource(prev_);
+    global::wallclock().reset();
+  }
+
+  void testSelect();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DeadlinePieceSelectorTest);
+
+void DeadlinePieceSelectorTest::testSelect()
+{
+  constexpr size_t pieceLength = 1_k;
+  BitfieldMan bf(pieceLength, pieceLength * 256);
+  bf.setBit(1);
+  bf.setBit(5);
+  bf.setBit(200);
+  PlaybackCursor cursor;
+  DeadlinePieceSelector selector(
+      std::shared_ptr<PieceSelector>(new MockPieceSelector()), &cursor,
+      pieceLength);
+  size_t index;
+  // Only the piece at the position is urgent.
+  CPPUNIT_ASSERT(!selector.select(index, bf.getBitfield(), bf.countBlock()));
+  cursor.update(1_k, 0);
+  CPPUNIT_ASSERT(selector.select(index, bf.getBitfield(), bf.countBlock()));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, index);
+  // The player reaches the piece 5 in 20 seconds, but not 200.
+  bf.unsetBit(1);
+  cursor.update(1_k, 256);
+  CPPUNIT_ASSERT(selector.select(index, bf.getBitfield(), bf.countBlock()));
+  CPPUNIT_ASSERT_EQUAL((size_t)5, index);
+  bf.unsetBit(5);
+  CPPUNIT_ASSERT(!selector.select(index, bf.getBitfield(), bf.countBlock()));
+  cursor.update(190_k, 1_k);
+  CPPUNIT_ASSERT(selector.select(index, bf.getBitfield(), bf.countBlock()));
+  CPPUNIT_ASSERT_EQUAL((size_t)200, index);
+}
+
+} // namespace aria2
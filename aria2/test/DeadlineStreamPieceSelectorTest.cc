@@ -0,0 +1,95 @@
+#include "DeadlineStreamPieceSelector.h"
+
+#include <cstring>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "BitfieldMan.h"
+#include "bitfield.h"
+#include "PlaybackCursor.h"
+#include "wallclock.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+class DeadlineStreamPieceSelectorTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(DeadlineStreamPieceSelectorTest);
+  CPPUNIT_TEST(testSelect);
+  CPPUNIT_TEST(testSelect_notPlaying);
+  CPPUNIT_TEST_SUITE_END();
+
+  ManualTimeSource source_;
+  TimeSource* prev_;
+
+public:
+  void setUp()
+  {
+    prev_ = setTimeSource(&source_);
+    global::wallclock().reset();
+  }
+
+  void tearDown()
+  {
+    setTimeSource(prev_);
+    global::wallclock().reset();
+  }
+
+  void testSelect();
+  void testSelect_notPlaying();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DeadlineStreamPieceSelectorTest);
+
+void DeadlineStreamPieceSelectorTest::testSelect()
+{
+  BitfieldMan bf(1_k, 100_k);
+  PlaybackCursor cursor;
+  DeadlineStreamPieceSelector sel(&bf, &cursor);
+  unsigned char igbf[13];
+  memset(igbf, 0, sizeof(igbf));
+  size_t index;
+  // 20 seconds at 50 bytes/s covers the pieces 10 and 11.
+  cursor.update(10_k + 512, 50);
+  bf.setBit(10);
+  bf.setUseBit(11);
+  // The urgent pieces ignore minSplitSize, but 11 is in use.  The
+  // next in order honors minSplitSize.
+  CPPUNIT_ASSERT(sel.select(index, 4_k, igbf, sizeof(igbf)));
+  CPPUNIT_ASSERT_EQUAL((size_t)15, index);
+  bf.unsetUseBit(11);
+  CPPUNIT_ASSERT(sel.select(index, 4_k, igbf, sizeof(igbf)));
+  CPPUNIT_ASSERT_EQUAL((size_t)11, index);
+  // Ignored pieces are skipped.
+  bitfield::flipBit(igbf, 100, 11);
+  CPPUNIT_ASSERT(sel.select(index, 4_k, igbf, sizeof(igbf)));
+  CPPUNIT_ASSERT_EQUAL((size_t)12, index);
+  // After the position, the pieces before it are selected.
+  bf.setBitRange(12, 99);
+  CPPUNIT_ASSERT(sel.select(index, 4_k, igbf, sizeof(igbf)));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, index);
+  bf.setBitRange(0, 9);
+  CPPUNIT_ASSERT(!sel.select(index, 4_k, igbf, sizeof(igbf)));
+}
+
+void DeadlineStreamPieceSelectorTest::testSelect_notPlaying()
+{
+  BitfieldMan bf(1_k, 100_k);
+  PlaybackCursor cursor;
+  DeadlineStreamPieceSelector sel(&bf, &cursor);
+  unsigned char igbf[13];
+  memset(igbf, 0, sizeof(igbf));
+  size_t index;
+  // Without the position, it works like inorder.
+  CPPUNIT_ASSERT(sel.select(index, 4_k, igbf, sizeof(igbf)));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, index);
+  bf.setUseBit(0);
+  CPPUNIT_ASSERT(sel.select(index, 4_k, igbf, sizeof(igbf)));
+  CPPUNIT_ASSERT_EQUAL((size_t)4, index);
+  // A paused player needs the piece at its position first.
+  cursor.update(50_k, 0);
+  CPPUNIT_ASSERT(sel.select(index, 4_k, igbf, sizeof(igbf)));
+  CPPUNIT_ASSERT_EQUAL((size_t)50, index);
+}
+
+} // namespace aria2
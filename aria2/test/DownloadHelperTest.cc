@@ -1,6 +1,7 @@
 #include "download_helper.h"
 
 #include <iostream>
+#include <fstream>
 #include <string>
 #include <algorithm>
 
@@ -14,6 +15,7 @@
 #include "Exception.h"
 #include "util.h"
 #include "FileEntry.h"
+#include "MetadataInfo.h"
 #ifdef ENABLE_BITTORRENT
 #  include "bittorrent_helper.h"
 #endif // ENABLE_BITTORRENT
@@ -29,6 +31,7 @@ class DownloadHelperTest : public CppUnit::TestFixture {
 
 #ifdef ENABLE_BITTORRENT
   CPPUNIT_TEST(testCreateRequestGroupForUri_BitTorrent);
+  CPPUNIT_TEST(testCreateRequestGroupForUriList_BitTorrent);
   CPPUNIT_TEST(testCreateRequestGroupForBitTorrent);
 #endif // ENABLE_BITTORRENT
 
@@ -53,6 +56,7 @@ public:
 
 #ifdef ENABLE_BITTORRENT
   void testCreateRequestGroupForUri_BitTorrent();
+  void testCreateRequestGroupForUriList_BitTorrent();
   void testCreateRequestGroupForBitTorrent();
 #endif // ENABLE_BITTORRENT
 
@@ -278,6 +282,45 @@ void DownloadHelperTest::testCreateRequestGroupForUriList()
 }
 
 #ifdef ENABLE_BITTORRENT
+void DownloadHelperTest::testCreateRequestGroupForUriList_BitTorrent()
+{
+  std::string bad =
+      A2_TEST_OUT_DIR "/aria2_DownloadHelperTest_bad.torrent";
+  std::string input =
+      A2_TEST_OUT_DIR "/aria2_DownloadHelperTest_torrents.txt";
+  {
+    std::ofstream out(bad.c_str(), std::ios::binary);
+    out << "d4:infoi1ee";
+  }
+  {
+    std::ofstream out(input.c_str(), std::ios::binary);
+    out << A2_TEST_DIR "/test.torrent\n"
+        << "  dir=/mydownloads\n"
+        << bad << "\n"
+        << "http://alpha/file\n"
+        << A2_TEST_DIR "/single.torrent\n";
+  }
+  option_->put(PREF_INPUT_FILE, input);
+  option_->put(PREF_DIR, "/tmp");
+
+  std::vector<std::shared_ptr<RequestGroup>> result;
+  createRequestGroupForUriList(result, option_);
+
+  // The bad torrent is skipped.
+  CPPUNIT_ASSERT_EQUAL((size_t)3, result.size());
+  auto multiCtx = result[0]->getDownloadContext();
+  CPPUNIT_ASSERT(multiCtx->hasAttribute(CTX_ATTR_BT));
+  CPPUNIT_ASSERT_EQUAL(std::string("/mydownloads/aria2-test"),
+                       multiCtx->getBasePath());
+  CPPUNIT_ASSERT_EQUAL(std::string(A2_TEST_DIR "/test.torrent"),
+                       result[0]->getMetadataInfo()->getUri());
+  CPPUNIT_ASSERT(
+      !result[1]->getDownloadContext()->hasAttribute(CTX_ATTR_BT));
+  auto singleCtx = result[2]->getDownloadContext();
+  CPPUNIT_ASSERT_EQUAL(std::string("/tmp/aria2-0.8.2.tar.bz2"),
+                       singleCtx->getFirstFileEntry()->getPath());
+}
+
 void DownloadHelperTest::testCreateRequestGroupForBitTorrent()
 {
   std::vector<std::string> auxURIs{"http://alpha/file", "http://bravo/file",
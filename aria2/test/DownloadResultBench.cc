@@ -0,0 +1,56 @@
+#include "Bench.h"
+
+#include <memory>
+
+#include "RequestGroupMan.h"
+#include "DownloadResult.h"
+#include "GroupId.h"
+#include "Option.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+namespace {
+std::shared_ptr<DownloadResult> newResult(error_code::Value result)
+{
+  auto dr = std::make_shared<DownloadResult>();
+  dr->gid = GroupId::create();
+  dr->belongsTo = 0;
+  dr->result = result;
+  dr->option = std::make_shared<Option>();
+  return dr;
+}
+
+const error_code::Value results[] = {
+    error_code::FINISHED, error_code::FINISHED, error_code::FINISHED,
+    error_code::REMOVED, error_code::TIME_OUT, error_code::IN_PROGRESS};
+} // namespace
+
+// getDownloadStat() is called every event loop iteration to check
+// whether the session is finished.  It should take constant time
+// regardless of the number of retained results.
+
+A2_BENCHMARK(DownloadStat)
+{
+  const size_t sizes[] = {1000, 10000, 100000};
+  for (auto size : sizes) {
+    Option option;
+    RequestGroupMan rgman({}, 1, &option);
+    rgman.setMaxDownloadResult(size);
+    for (size_t i = 0; i < size; ++i) {
+      rgman.addDownloadResult(newResult(results[i % 6]));
+    }
+    auto n = bench::scale(100000);
+    volatile int sink = 0;
+    auto start = bench::now();
+    for (size_t i = 0; i < n; ++i) {
+      sink = sink + rgman.getDownloadStat().getInProgress();
+    }
+    auto end = bench::now();
+    bench::report(
+        fmt("getDownloadStat N=%lu", static_cast<unsigned long>(size)),
+        (end - start) * 1e9 / n, "ns/op");
+  }
+}
+
+} // namespace aria2
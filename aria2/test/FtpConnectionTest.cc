@@ -29,6 +29,8 @@ class FtpConnectionTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testReceivePwdResponse_unquotedResponse);
   CPPUNIT_TEST(testReceivePwdResponse_badStatus);
   CPPUNIT_TEST(testSendCwd);
+  CPPUNIT_TEST(testSendLoginPipeline);
+  CPPUNIT_TEST(testSendCwdPipeline);
   CPPUNIT_TEST(testSendSize);
   CPPUNIT_TEST(testReceiveSizeResponse);
   CPPUNIT_TEST(testSendRetr);
@@ -85,6 +87,8 @@ public:
   void testReceivePwdResponse_unquotedResponse();
   void testReceivePwdResponse_badStatus();
   void testSendCwd();
+  void testSendLoginPipeline();
+  void testSendCwdPipeline();
   void testSendSize();
   void testReceiveSizeResponse();
   void testSendRetr();
@@ -283,6 +287,70 @@ void FtpConnectionTest::testSendCwd()
   CPPUNIT_ASSERT_EQUAL(std::string("CWD /dir sp\r\n"), std::string(data));
 }
 
+void FtpConnectionTest::testSendLoginPipeline()
+{
+  CPPUNIT_ASSERT(ftp_->sendLoginPipeline(true));
+  char data[64];
+  size_t len = sizeof(data);
+  serverSocket_->readData(data, len);
+  CPPUNIT_ASSERT_EQUAL(std::string("PASS ARIA2USER@\r\n"
+                                   "TYPE I\r\n"
+                                   "PWD\r\n"),
+                       std::string(&data[0], &data[len]));
+
+  CPPUNIT_ASSERT(ftp_->sendLoginPipeline(false));
+  len = sizeof(data);
+  serverSocket_->readData(data, len);
+  CPPUNIT_ASSERT_EQUAL(std::string("TYPE I\r\n"
+                                   "PWD\r\n"),
+                       std::string(&data[0], &data[len]));
+}
+
+void FtpConnectionTest::testSendCwdPipeline()
+{
+  std::deque<std::string> dirs{"/", "dir%20sp", "sub"};
+  CPPUNIT_ASSERT(ftp_->sendCwdPipeline(dirs, true));
+  char data[128];
+  size_t len = sizeof(data);
+  serverSocket_->readData(data, len);
+  CPPUNIT_ASSERT_EQUAL(std::string("CWD /\r\n"
+                                   "CWD dir sp\r\n"
+                                   "CWD sub\r\n"
+                                   "MDTM hello world.img\r\n"
+                                   "SIZE hello world.img\r\n"),
+                       std::string(&data[0], &data[len]));
+
+  // The server replies to all of them at once.  Each reply is read
+  // from the buffer without waiting for the socket again.
+  serverSocket_->writeData("250 ok\r\n"
+                           "250 ok\r\n"
+                           "250-multi\r\n"
+                           "250 ok\r\n"
+                           "213 20080908124312\r\n"
+                           "213 4294967296\r\n");
+  waitRead(clientSocket_);
+  CPPUNIT_ASSERT_EQUAL(250, ftp_->receiveResponse());
+  CPPUNIT_ASSERT_EQUAL(250, ftp_->receiveResponse());
+  CPPUNIT_ASSERT_EQUAL(250, ftp_->receiveResponse());
+  Time t;
+  CPPUNIT_ASSERT_EQUAL(213, ftp_->receiveMdtmResponse(t));
+  CPPUNIT_ASSERT_EQUAL((time_t)1220877792, t.getTimeFromEpoch());
+  int64_t size;
+  CPPUNIT_ASSERT_EQUAL(213, ftp_->receiveSizeResponse(size));
+  CPPUNIT_ASSERT_EQUAL((int64_t)4294967296LL, size);
+  CPPUNIT_ASSERT_EQUAL(0, ftp_->receiveResponse());
+
+  // Without MDTM
+  dirs.pop_front();
+  CPPUNIT_ASSERT(ftp_->sendCwdPipeline(dirs, false));
+  len = sizeof(data);
+  serverSocket_->readData(data, len);
+  CPPUNIT_ASSERT_EQUAL(std::string("CWD dir sp\r\n"
+                                   "CWD sub\r\n"
+                                   "SIZE hello world.img\r\n"),
+                       std::string(&data[0], &data[len]));
+}
+
 void FtpConnectionTest::testSendSize()
 {
   ftp_->sendSize();
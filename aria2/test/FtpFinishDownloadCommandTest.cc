@@ -0,0 +1,203 @@
+#include "FtpFinishDownloadCommand.h"
+
+#include <chrono>
+#include <thread>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "TestUtil.h"
+#include "Context.h"
+#include "MultiUrlRequestInfo.h"
+#include "DownloadEngine.h"
+#include "SocketCore.h"
+#include "File.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+class FtpFinishDownloadCommandTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(FtpFinishDownloadCommandTest);
+  CPPUNIT_TEST(testBufferedResponse);
+  CPPUNIT_TEST(testPartialResponseTimesOut);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testBufferedResponse();
+  void testPartialResponseTimesOut();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(FtpFinishDownloadCommandTest);
+
+namespace {
+const std::string DATA = "0123456789abcdef";
+
+// A minimal FTP server for a single download over a single control
+// connection.  The replies to RETR are sent in one write after the
+// data, followed by |finalReply|.
+class FtpServer {
+public:
+  FtpServer(std::string finalReply) : finalReply_(std::move(finalReply))
+  {
+    listenSocket_.bind(0);
+    listenSocket_.beginListen();
+    listenSocket_.setBlockingMode();
+    port_ = listenSocket_.getAddrInfo().port;
+    thread_ = std::thread([this] { serve(); });
+  }
+
+  ~FtpServer() { thread_.join(); }
+
+  uint16_t getPort() const { return port_; }
+
+private:
+  bool readLine(SocketCore& socket, std::string& line)
+  {
+    line.clear();
+    for (;;) {
+      char c;
+      size_t len = 1;
+      socket.readData(&c, len);
+      if (len == 0) {
+        return false;
+      }
+      if (c == '\n') {
+        return true;
+      }
+      if (c != '\r') {
+        line += c;
+      }
+    }
+  }
+
+  void serve()
+  {
+    auto control = listenSocket_.acceptConnection();
+    control->setBlockingMode();
+    control->writeData("220 ready\r\n");
+    std::shared_ptr<SocketCore> dataListenSocket;
+    std::string line;
+    while (readLine(*control, line)) {
+      auto command = line.substr(0, line.find(' '));
+      if (command == "USER") {
+        control->writeData("331 password\r\n");
+      }
+      else if (command == "PASS") {
+        control->writeData("230 logged in\r\n");
+      }
+      else if (command == "TYPE") {
+        control->writeData("200 ok\r\n");
+      }
+      else if (command == "PWD") {
+        control->writeData("257 \"/\"\r\n");
+      }
+      else if (command == "CWD") {
+        control->writeData("250 ok\r\n");
+      }
+      else if (command == "SIZE") {
+        control->writeData(fmt("213 %zu\r\n", DATA.size()));
+      }
+      else if (command == "EPSV" || command == "PASV") {
+        dataListenSocket = std::make_shared<SocketCore>();
+        dataListenSocket->bind(0);
+        dataListenSocket->beginListen();
+        dataListenSocket->setBlockingMode();
+        unsigned int port = dataListenSocket->getAddrInfo().port;
+        if (command == "EPSV") {
+          control->writeData(
+              fmt("229 Entering Extended Passive Mode (|||%u|)\r\n", port));
+        }
+        else {
+          control->writeData(
+              fmt("227 Entering Passive Mode (127,0,0,1,%u,%u)\r\n",
+                  port >> 8, port & 0xffu));
+        }
+      }
+      else if (command == "REST") {
+        control->writeData("350 ok\r\n");
+      }
+      else if (command == "RETR" && dataListenSocket) {
+        auto data = dataListenSocket->acceptConnection();
+        data->setBlockingMode();
+        data->writeData(DATA);
+        data->closeConnection();
+        // The transfer complete reply arrives together with the 150
+        // one, so there won't be another read event for it.
+        control->writeData("150 opening data connection\r\n" + finalReply_);
+      }
+      else {
+        control->writeData("502 not implemented\r\n");
+      }
+    }
+  }
+
+  SocketCore listenSocket_;
+  uint16_t port_;
+  std::string finalReply_;
+  std::thread thread_;
+};
+
+// Downloads the file from |server| and returns the number of seconds
+// it took.  Gives up after 20 seconds.
+int download(const FtpServer& server, const std::string& out,
+             const std::string& timeout)
+{
+  File(out).remove();
+  std::string uri = fmt("ftp://localhost:%u/file", server.getPort());
+  char arg0[] = "aria2c";
+  char* argv[] = {arg0, &uri[0]};
+  KeyVals options = {{"no-conf", "true"},
+                     {"quiet", "true"},
+                     {"dir", File(out).getDirname()},
+                     {"out", File(out).getBasename()},
+                     {"timeout", timeout},
+                     {"max-tries", "1"}};
+  Context context(false, 2, argv, options);
+  context.reqinfo->setUseSignalHandler(false);
+  CPPUNIT_ASSERT_EQUAL(0, context.reqinfo->prepare());
+  auto start = std::chrono::steady_clock::now();
+  auto elapsed = [&start] {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+  };
+  auto& e = context.reqinfo->getDownloadEngine();
+  while (e->run(true) == 1 && elapsed() < 20)
+    ;
+  e->requestForceHalt();
+  while (e->run(true) == 1)
+    ;
+  return elapsed();
+}
+} // namespace
+
+void FtpFinishDownloadCommandTest::testBufferedResponse()
+{
+  const std::string out =
+      A2_TEST_OUT_DIR "/aria2_FtpFinishDownloadCommandTest_buffered";
+  int elapsed;
+  {
+    FtpServer server("226 transfer complete\r\n");
+    elapsed = download(server, out, "10");
+  }
+  CPPUNIT_ASSERT_EQUAL(DATA, readFile(out));
+  CPPUNIT_ASSERT(elapsed < 5);
+}
+
+void FtpFinishDownloadCommandTest::testPartialResponseTimesOut()
+{
+  const std::string out =
+      A2_TEST_OUT_DIR "/aria2_FtpFinishDownloadCommandTest_partial";
+  int elapsed;
+  {
+    // The rest of the reply never comes.  The partial reply in the
+    // buffer must not keep the command from timing out.
+    FtpServer server("226 transf");
+    elapsed = download(server, out, "2");
+  }
+  CPPUNIT_ASSERT_EQUAL(DATA, readFile(out));
+  CPPUNIT_ASSERT(elapsed >= 1);
+  CPPUNIT_ASSERT(elapsed < 10);
+}
+
+} // namespace aria2
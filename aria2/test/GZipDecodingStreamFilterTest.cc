@@ -13,6 +13,11 @@
 #include "SinkStreamFilter.h"
 #include "MockSegment.h"
 #include "MessageDigest.h"
+#include "PiecedSegment.h"
+#include "Piece.h"
+#include "DirectDiskAdaptor.h"
+#include "WrDiskCache.h"
+#include "Metrics.h"
 
 namespace aria2 {
 
@@ -20,6 +25,7 @@ class GZipDecodingStreamFilterTest : public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(GZipDecodingStreamFilterTest);
   CPPUNIT_TEST(testTransform);
+  CPPUNIT_TEST(testTransform_inPlace);
   CPPUNIT_TEST_SUITE_END();
 
   class MockSegment2 : public MockSegment {
@@ -56,6 +62,7 @@ public:
   }
 
   void testTransform();
+  void testTransform_inPlace();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(GZipDecodingStreamFilterTest);
@@ -76,4 +83,38 @@ void GZipDecodingStreamFilterTest::testTransform()
                        util::toHex(sha1->digest()));
 }
 
+void GZipDecodingStreamFilterTest::testTransform_inPlace()
+{
+  auto adaptor = std::make_shared<DirectDiskAdaptor>();
+  auto dw = make_unique<ByteArrayDiskWriter>();
+  auto writer = dw.get();
+  adaptor->setDiskWriter(std::move(dw));
+  WrDiskCache dc(1_m);
+  auto piece = std::make_shared<Piece>(0, 1_m);
+  piece->initWrCache(&dc, adaptor);
+  std::shared_ptr<Segment> segment =
+      std::make_shared<PiecedSegment>(1_m, piece);
+  GZipDecodingStreamFilter filter(make_unique<SinkStreamFilter>(&dc));
+  filter.init();
+  auto copied =
+      global::metrics().counter("aria2_disk_cache_copied_bytes_total", "");
+  auto copiedStart = copied->get();
+
+  unsigned char buf[4_k];
+  std::ifstream in(A2_TEST_DIR "/gzip_decode_test.gz", std::ios::binary);
+  while (in) {
+    in.read(reinterpret_cast<char*>(buf), sizeof(buf));
+    filter.transform(adaptor, segment, buf, in.gcount());
+  }
+  CPPUNIT_ASSERT(filter.finished());
+  // The output is inflated into the cache directly.
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, copied->get() - copiedStart);
+  piece->flushWrCache(&dc);
+  std::string data = writer->getString();
+  std::shared_ptr<MessageDigest> sha1(MessageDigest::sha1());
+  sha1->update(data.data(), data.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("8b577b33c0411b2be9d4fa74c7402d54a8d21f96"),
+                       util::toHex(sha1->digest()));
+}
+
 } // namespace aria2
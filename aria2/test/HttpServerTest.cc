@@ -86,6 +86,11 @@ void HttpServerTest::testHttpBasicAuth()
                                           "dXNlcjpwYXNz\r\n\r\n");
     req->setUsernamePassword("user", "pass");
     CPPUNIT_ASSERT(req->authenticate());
+    // The same header is accepted again from the cache, until the
+    // credentials change.
+    CPPUNIT_ASSERT(req->authenticate());
+    req->setUsernamePassword("user", "pass2");
+    CPPUNIT_ASSERT(!req->authenticate());
   }
 
   {
@@ -0,0 +1,112 @@
+#include "IncrementalChecksum.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "TestUtil.h"
+#include "DownloadContext.h"
+#include "DefaultPieceStorage.h"
+#include "Option.h"
+#include "DiskAdaptor.h"
+#include "MessageDigest.h"
+#include "Piece.h"
+
+namespace aria2 {
+
+class IncrementalChecksumTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(IncrementalChecksumTest);
+  CPPUNIT_TEST(testUpdate);
+  CPPUNIT_TEST(testUpdate_outOfOrder);
+  CPPUNIT_TEST(testUpdate_readError);
+  CPPUNIT_TEST(testInit);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  Option option_;
+  std::shared_ptr<DownloadContext> dctx_;
+  std::shared_ptr<DefaultPieceStorage> ps_;
+
+public:
+  void setUp()
+  {
+    dctx_ = std::make_shared<DownloadContext>(
+        100, 250, A2_TEST_DIR "/chunkChecksumTestFile250.txt");
+    dctx_->setDigest("sha-1",
+                     fromHex("898a81b8e0181280ae2ee1b81e269196d91e869a"));
+    ps_ = std::make_shared<DefaultPieceStorage>(dctx_, &option_);
+    ps_->initStorage();
+    ps_->getDiskAdaptor()->enableReadOnly();
+    ps_->getDiskAdaptor()->openFile();
+  }
+
+  void complete(size_t index)
+  {
+    ps_->completePiece(ps_->getMissingPiece(index, 1));
+  }
+
+  void testUpdate();
+  void testUpdate_outOfOrder();
+  void testUpdate_readError();
+  void testInit();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(IncrementalChecksumTest);
+
+void IncrementalChecksumTest::testUpdate()
+{
+  IncrementalChecksum checksum("sha-1", 100, 250);
+  // Not the next piece
+  checksum.update(std::make_shared<Piece>(1, 100), ps_->getDiskAdaptor());
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, checksum.getOffset());
+  checksum.update(std::make_shared<Piece>(0, 100), ps_->getDiskAdaptor());
+  CPPUNIT_ASSERT_EQUAL((int64_t)100, checksum.getOffset());
+  checksum.update(std::make_shared<Piece>(1, 100), ps_->getDiskAdaptor());
+  checksum.update(std::make_shared<Piece>(2, 50), ps_->getDiskAdaptor());
+  CPPUNIT_ASSERT_EQUAL((int64_t)250, checksum.getOffset());
+  auto ctx = checksum.popContext();
+  CPPUNIT_ASSERT_EQUAL(dctx_->getDigest(), ctx->digest());
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, checksum.getOffset());
+}
+
+void IncrementalChecksumTest::testUpdate_outOfOrder()
+{
+  IncrementalChecksum checksum("sha-1", 100, 250);
+  complete(1);
+  complete(2);
+  checksum.update(ps_.get(), 4);
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, checksum.getOffset());
+  complete(0);
+  checksum.update(ps_.get(), 2);
+  CPPUNIT_ASSERT_EQUAL((int64_t)200, checksum.getOffset());
+  checksum.update(ps_.get(), 2);
+  CPPUNIT_ASSERT_EQUAL((int64_t)250, checksum.getOffset());
+  CPPUNIT_ASSERT_EQUAL(dctx_->getDigest(), checksum.popContext()->digest());
+}
+
+void IncrementalChecksumTest::testUpdate_readError()
+{
+  // The file is shorter than the pieces claim.
+  IncrementalChecksum checksum("sha-1", 100, 300);
+  checksum.update(std::make_shared<Piece>(0, 100), ps_->getDiskAdaptor());
+  CPPUNIT_ASSERT_EQUAL((int64_t)100, checksum.getOffset());
+  checksum.update(std::make_shared<Piece>(1, 100), ps_->getDiskAdaptor());
+  checksum.update(std::make_shared<Piece>(2, 100), ps_->getDiskAdaptor());
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, checksum.getOffset());
+}
+
+void IncrementalChecksumTest::testInit()
+{
+  dctx_->initIncrementalChecksum();
+  CPPUNIT_ASSERT(dctx_->getIncrementalChecksum());
+  dctx_->setChecksumVerified(true);
+  dctx_->initIncrementalChecksum();
+  CPPUNIT_ASSERT(!dctx_->getIncrementalChecksum());
+  dctx_->setChecksumVerified(false);
+  // Piece hashes are verified instead.
+  std::vector<std::string> hashes(3);
+  dctx_->setPieceHashes("sha-1", std::begin(hashes), std::end(hashes));
+  dctx_->initIncrementalChecksum();
+  CPPUNIT_ASSERT(!dctx_->getIncrementalChecksum());
+}
+
+} // namespace aria2
@@ -0,0 +1,90 @@
+#include "Bench.h"
+
+#include <memory>
+
+#include "IndexedList.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+namespace {
+typedef IndexedList<uint64_t, std::shared_ptr<int>> BenchList;
+
+void fill(BenchList& list, size_t n)
+{
+  auto v = std::make_shared<int>(0);
+  for (size_t i = 0; i < n; ++i) {
+    list.push_back(i, v);
+  }
+}
+
+uint64_t lcg(uint64_t& seed)
+{
+  seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  return seed >> 33;
+}
+
+const size_t sizes[] = {1000, 10000, 100000, 200000};
+} // namespace
+
+// The queue operations aria2.changePosition, aria2.addUri with
+// position, aria2.remove and aria2.tellWaiting with offset do on the
+// waiting queue, for the growing queue size.  The time per operation
+// should grow logarithmically.
+
+A2_BENCHMARK(IndexedListMove)
+{
+  for (auto size : sizes) {
+    BenchList list;
+    fill(list, size);
+    uint64_t seed = 1;
+    auto n = bench::scale(200000);
+    auto start = bench::now();
+    for (size_t i = 0; i < n; ++i) {
+      list.move(lcg(seed) % size, lcg(seed) % size, OFFSET_MODE_SET);
+    }
+    auto end = bench::now();
+    bench::report(fmt("move N=%lu", static_cast<unsigned long>(size)),
+                  (end - start) * 1e9 / n, "ns/op");
+  }
+}
+
+A2_BENCHMARK(IndexedListInsertRemove)
+{
+  for (auto size : sizes) {
+    BenchList list;
+    fill(list, size);
+    auto v = std::make_shared<int>(0);
+    auto n = bench::scale(200000);
+    auto start = bench::now();
+    for (size_t i = 0; i < n; ++i) {
+      list.insert(size / 2, size + i, v);
+      list.remove(size + i);
+    }
+    auto end = bench::now();
+    bench::report(fmt("insert+remove N=%lu", static_cast<unsigned long>(size)),
+                  (end - start) * 1e9 / n, "ns/op");
+  }
+}
+
+A2_BENCHMARK(IndexedListOffset)
+{
+  for (auto size : sizes) {
+    BenchList list;
+    fill(list, size);
+    uint64_t seed = 1;
+    auto n = bench::scale(200000);
+    volatile size_t sink = 0;
+    auto start = bench::now();
+    for (size_t i = 0; i < n; ++i) {
+      auto first = list.begin();
+      std::advance(first, lcg(seed) % size);
+      sink = first.index();
+    }
+    auto end = bench::now();
+    bench::report(fmt("offset N=%lu", static_cast<unsigned long>(size)),
+                  (end - start) * 1e9 / n, "ns/op");
+  }
+}
+
+} // namespace aria2
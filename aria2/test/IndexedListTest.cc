@@ -26,6 +26,7 @@ class IndexedListTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testInsert_keyFunc);
   CPPUNIT_TEST(testIterator);
   CPPUNIT_TEST(testRemoveIf);
+  CPPUNIT_TEST(testRandomOperations);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -42,6 +43,7 @@ public:
   void testInsert_keyFunc();
   void testIterator();
   void testRemoveIf();
+  void testRandomOperations();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(IndexedListTest);
@@ -420,4 +422,85 @@ void IndexedListTest::testRemoveIf()
   }
 }
 
+void IndexedListTest::testRandomOperations()
+{
+  // Compares IndexedList with the plain sequence after each
+  // operation.
+  IndexedList<int, int> list;
+  std::deque<int> ref;
+  uint32_t seed = 1;
+  auto rnd = [&seed](size_t n) {
+    seed = seed * 1103515245 + 12345;
+    return n == 0 ? 0 : (seed >> 8) % n;
+  };
+  int nextKey = 0;
+  for (int i = 0; i < 3000; ++i) {
+    switch (rnd(6)) {
+    case 0: {
+      auto pos = rnd(ref.size() + 1);
+      list.insert(pos, nextKey, nextKey);
+      ref.insert(std::begin(ref) + pos, nextKey);
+      ++nextKey;
+      break;
+    }
+    case 1:
+      list.push_back(nextKey, nextKey);
+      ref.push_back(nextKey);
+      ++nextKey;
+      break;
+    case 2:
+      if (!ref.empty()) {
+        auto pos = rnd(ref.size());
+        CPPUNIT_ASSERT(list.remove(ref[pos]));
+        ref.erase(std::begin(ref) + pos);
+      }
+      break;
+    case 3:
+      if (!ref.empty()) {
+        auto pos = rnd(ref.size());
+        auto key = ref[pos];
+        auto dest = rnd(ref.size());
+        CPPUNIT_ASSERT_EQUAL((ssize_t)dest,
+                             list.move(key, dest, OFFSET_MODE_SET));
+        ref.erase(std::begin(ref) + pos);
+        ref.insert(std::begin(ref) + dest, key);
+      }
+      break;
+    case 4: {
+      std::vector<int> v;
+      for (size_t j = 0, n = rnd(5); j < n; ++j) {
+        v.push_back(nextKey++);
+      }
+      auto pos = rnd(ref.size() + 1);
+      list.insert(list.begin() + pos, [](int x) { return x; }, std::begin(v),
+                  std::end(v));
+      ref.insert(std::begin(ref) + pos, std::begin(v), std::end(v));
+      break;
+    }
+    case 5: {
+      auto m = rnd(7) + 2;
+      list.remove_if([m](int x) { return x % m == 0; });
+      ref.erase(std::remove_if(std::begin(ref), std::end(ref),
+                               [m](int x) { return x % m == 0; }),
+                std::end(ref));
+      break;
+    }
+    }
+    CPPUNIT_ASSERT_EQUAL(ref.size(), list.size());
+    if (!ref.empty()) {
+      auto pos = rnd(ref.size());
+      CPPUNIT_ASSERT_EQUAL(ref[pos], list[pos]);
+      CPPUNIT_ASSERT_EQUAL(ref[pos], *(list.begin() + pos));
+      CPPUNIT_ASSERT_EQUAL((ssize_t)pos, (list.begin() + pos) - list.begin());
+      CPPUNIT_ASSERT_EQUAL(ref[pos], *(list.end() - (ref.size() - pos)));
+    }
+  }
+  CPPUNIT_ASSERT(std::equal(std::begin(ref), std::end(ref), list.begin()));
+  auto j = ref.rbegin();
+  for (auto i = list.end(); i != list.begin(); ++j) {
+    --i;
+    CPPUNIT_ASSERT_EQUAL(*j, *i);
+  }
+}
+
 } // namespace aria2
@@ -9,6 +9,8 @@
 #include "DiskAdaptor.h"
 #include "FileEntry.h"
 #include "PieceSelector.h"
+#include "IncrementalChecksum.h"
+#include "Piece.h"
 
 namespace aria2 {
 
@@ -17,6 +19,7 @@ class IteratableChecksumValidatorTest : public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(IteratableChecksumValidatorTest);
   CPPUNIT_TEST(testValidate);
   CPPUNIT_TEST(testValidate_fail);
+  CPPUNIT_TEST(testValidate_incremental);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -25,6 +28,7 @@ public:
 
   void testValidate();
   void testValidate_fail();
+  void testValidate_incremental();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(IteratableChecksumValidatorTest);
@@ -72,4 +76,31 @@ void IteratableChecksumValidatorTest::testValidate_fail()
   CPPUNIT_ASSERT(!ps->downloadFinished());
 }
 
+void IteratableChecksumValidatorTest::testValidate_incremental()
+{
+  Option option;
+  std::shared_ptr<DownloadContext> dctx(new DownloadContext(
+      100, 250, A2_TEST_DIR "/chunkChecksumTestFile250.txt"));
+  dctx->setDigest("sha-1", fromHex("898a81b8e0181280ae2ee1b81e269196d91e869a"));
+  dctx->initIncrementalChecksum();
+  std::shared_ptr<DefaultPieceStorage> ps(
+      new DefaultPieceStorage(dctx, &option));
+  ps->initStorage();
+  ps->getDiskAdaptor()->enableReadOnly();
+  ps->getDiskAdaptor()->openFile();
+  dctx->getIncrementalChecksum()->update(std::make_shared<Piece>(0, 100),
+                                         ps->getDiskAdaptor());
+
+  IteratableChecksumValidator validator(dctx, ps);
+  validator.init();
+  // Only the rest of the file is read.
+  CPPUNIT_ASSERT_EQUAL((int64_t)100, validator.getCurrentOffset());
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, dctx->getIncrementalChecksum()->getOffset());
+  while (!validator.finished()) {
+    validator.validateChunk();
+  }
+
+  CPPUNIT_ASSERT(ps->downloadFinished());
+}
+
 } // namespace aria2
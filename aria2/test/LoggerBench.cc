@@ -0,0 +1,52 @@
+#include "Bench.h"
+
+#include "Logger.h"
+#include "File.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+namespace {
+void runLogger(const char* filename, size_t capacity, bool drop)
+{
+  File f(filename);
+  f.remove();
+  Logger logger;
+  logger.setConsoleOutput(false);
+  logger.setLogLevel(Logger::A2_INFO);
+  logger.setAsync(capacity, drop, 0);
+  logger.openFile(f.getPath());
+  auto n = bench::scale(500000);
+  auto start = bench::now();
+  for (size_t i = 0; i < n; ++i) {
+    logger.log(Logger::A2_INFO, __FILE__, __LINE__,
+               fmt("CUID#%lu - Received %lu bytes from 192.168.0.1:6881",
+                   static_cast<unsigned long>(i % 100),
+                   static_cast<unsigned long>(i)));
+  }
+  auto enqueued = bench::now();
+  logger.flush();
+  logger.closeFile();
+  auto end = bench::now();
+  bench::report("caller throughput", n / (enqueued - start), "events/s");
+  bench::report("end-to-end throughput", n / (end - start), "events/s");
+  f.remove();
+}
+} // namespace
+
+A2_BENCHMARK(LoggerSync)
+{
+  runLogger(A2_TEST_OUT_DIR "/aria2_LoggerBench_sync.log", 0, false);
+}
+
+A2_BENCHMARK(LoggerAsyncBlock)
+{
+  runLogger(A2_TEST_OUT_DIR "/aria2_LoggerBench_async.log", 16384, false);
+}
+
+A2_BENCHMARK(LoggerAsyncDrop)
+{
+  runLogger(A2_TEST_OUT_DIR "/aria2_LoggerBench_async.log", 16384, true);
+}
+
+} // namespace aria2
@@ -0,0 +1,155 @@
+#include "Metrics.h"
+
+#include <thread>
+#include <vector>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "util.h"
+
+namespace aria2 {
+
+class MetricsTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(MetricsTest);
+  CPPUNIT_TEST(testCounter);
+  CPPUNIT_TEST(testCounter_multipleThreads);
+  CPPUNIT_TEST(testGauge);
+  CPPUNIT_TEST(testHistogram_bucketIndex);
+  CPPUNIT_TEST(testHistogram_getQuantile);
+  CPPUNIT_TEST(testRegistry);
+  CPPUNIT_TEST(testToPrometheusText);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testCounter();
+  void testCounter_multipleThreads();
+  void testGauge();
+  void testHistogram_bucketIndex();
+  void testHistogram_getQuantile();
+  void testRegistry();
+  void testToPrometheusText();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(MetricsTest);
+
+void MetricsTest::testCounter()
+{
+  Counter c("c", "help");
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, c.get());
+  c.inc();
+  c.add(99);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)100, c.get());
+  CPPUNIT_ASSERT_EQUAL(Metric::COUNTER, c.getType());
+  CPPUNIT_ASSERT_EQUAL(std::string("c"), c.getName());
+  CPPUNIT_ASSERT_EQUAL(std::string("help"), c.getHelp());
+}
+
+void MetricsTest::testCounter_multipleThreads()
+{
+  Counter c("c", "help");
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&c] {
+      for (int j = 0; j < 10000; ++j) {
+        c.inc();
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  CPPUNIT_ASSERT_EQUAL((uint64_t)40000, c.get());
+}
+
+void MetricsTest::testGauge()
+{
+  Gauge g("g", "help");
+  g.set(10);
+  g.add(-15);
+  CPPUNIT_ASSERT_EQUAL((int64_t)-5, g.get());
+}
+
+void MetricsTest::testHistogram_bucketIndex()
+{
+  // Values less than SUB_BUCKETS are exact.
+  for (uint64_t v = 0; v < Histogram::SUB_BUCKETS; ++v) {
+    CPPUNIT_ASSERT_EQUAL((size_t)v, Histogram::bucketIndex(v));
+    CPPUNIT_ASSERT_EQUAL(v, Histogram::bucketUpperBound(v));
+  }
+  // Every value falls in the bucket whose upper bound is not less
+  // than the value, and bucket of the next value is either the same
+  // or the next one.
+  for (uint64_t v = 1; v < 100000; ++v) {
+    auto idx = Histogram::bucketIndex(v);
+    CPPUNIT_ASSERT(v <= Histogram::bucketUpperBound(idx));
+    CPPUNIT_ASSERT(idx == 0 || v > Histogram::bucketUpperBound(idx - 1));
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)8, Histogram::bucketIndex(8));
+  CPPUNIT_ASSERT_EQUAL((size_t)8, Histogram::bucketIndex(9) - 1);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)17, Histogram::bucketUpperBound(
+                                         Histogram::bucketIndex(16)));
+  CPPUNIT_ASSERT_EQUAL(Histogram::NUM_BUCKETS - 1,
+                       Histogram::bucketIndex(UINT64_MAX));
+  CPPUNIT_ASSERT_EQUAL((uint64_t)UINT64_MAX,
+                       Histogram::bucketUpperBound(Histogram::NUM_BUCKETS - 1));
+}
+
+void MetricsTest::testHistogram_getQuantile()
+{
+  Histogram h("h", "help", 1.0);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, h.getQuantile(0.5));
+  for (uint64_t v = 1; v <= 1000; ++v) {
+    h.record(v);
+  }
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1000, h.getCount());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)500500, h.getSum());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1000, h.getMax());
+  // The relative error is at most 1/SUB_BUCKETS.
+  auto p50 = h.getQuantile(0.5);
+  CPPUNIT_ASSERT(p50 >= 500 && p50 <= 500 + 500 / Histogram::SUB_BUCKETS);
+  auto p99 = h.getQuantile(0.99);
+  CPPUNIT_ASSERT(p99 >= 990 && p99 <= 1000);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1000, h.getQuantile(1.0));
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, h.getQuantile(0.0));
+}
+
+void MetricsTest::testRegistry()
+{
+  MetricsRegistry r;
+  auto c = r.counter("aria2_test_total", "help");
+  CPPUNIT_ASSERT(c == r.counter("aria2_test_total", "other help"));
+  auto g = r.gauge("aria2_test_gauge", "help");
+  auto h = r.histogram("aria2_test_seconds", "help", 1e-6);
+  CPPUNIT_ASSERT(h == r.histogram("aria2_test_seconds", "help", 1e-6));
+  CPPUNIT_ASSERT(g == r.gauge("aria2_test_gauge", "help"));
+  CPPUNIT_ASSERT_EQUAL((size_t)3, r.getMetrics().size());
+}
+
+void MetricsTest::testToPrometheusText()
+{
+  MetricsRegistry r;
+  r.counter("aria2_test_total", "Test counter.")->add(3);
+  r.gauge("aria2_test_gauge", "Test gauge.")->set(-2);
+  auto h = r.histogram("aria2_test_seconds", "Test histogram.", 1e-6);
+  h->record(2);
+  h->record(4);
+  CPPUNIT_ASSERT_EQUAL(
+      std::string("# HELP aria2_test_total Test counter.\n"
+                  "# TYPE aria2_test_total counter\n"
+                  "aria2_test_total 3\n"
+                  "# HELP aria2_test_gauge Test gauge.\n"
+                  "# TYPE aria2_test_gauge gauge\n"
+                  "aria2_test_gauge -2\n"
+                  "# HELP aria2_test_seconds Test histogram.\n"
+                  "# TYPE aria2_test_seconds summary\n"
+                  "aria2_test_seconds{quantile=\"0.5\"} 2e-06\n"
+                  "aria2_test_seconds{quantile=\"0.9\"} 4e-06\n"
+                  "aria2_test_seconds{quantile=\"0.99\"} 4e-06\n"
+                  "aria2_test_seconds{quantile=\"1\"} 4e-06\n"
+                  "aria2_test_seconds_sum 6e-06\n"
+                  "aria2_test_seconds_count 2\n"),
+      r.toPrometheusText());
+}
+
+} // namespace aria2
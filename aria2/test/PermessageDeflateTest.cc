@@ -0,0 +1,187 @@
+#include "PermessageDeflate.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "util.h"
+
+namespace aria2 {
+
+namespace rpc {
+
+class PermessageDeflateTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(PermessageDeflateTest);
+  CPPUNIT_TEST(testNegotiate);
+  CPPUNIT_TEST(testNegotiate_decline);
+  CPPUNIT_TEST(testDeflate);
+  CPPUNIT_TEST(testInflate);
+  CPPUNIT_TEST(testInflate_contextTakeover);
+  CPPUNIT_TEST(testInflate_finalBlock);
+  CPPUNIT_TEST(testInflate_error);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testNegotiate();
+  void testNegotiate_decline();
+  void testDeflate();
+  void testInflate();
+  void testInflate_contextTakeover();
+  void testInflate_finalBlock();
+  void testInflate_error();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(PermessageDeflateTest);
+
+namespace {
+std::string fromHex(const std::string& s)
+{
+  return util::fromHex(std::begin(s), std::end(s));
+}
+} // namespace
+
+namespace {
+const std::string ACCEPT = "permessage-deflate; server_no_context_takeover";
+} // namespace
+
+void PermessageDeflateTest::testNegotiate()
+{
+  CPPUNIT_ASSERT_EQUAL(ACCEPT, negotiatePermessageDeflate(
+                                   {"permessage-deflate; "
+                                    "client_max_window_bits"}));
+  CPPUNIT_ASSERT_EQUAL(ACCEPT, negotiatePermessageDeflate(
+                                   {"x-webkit-deflate-frame",
+                                    "Permessage-Deflate;"
+                                    "server_no_context_takeover;"
+                                    "client_no_context_takeover"}));
+  // The offered server_max_window_bits is echoed.
+  CPPUNIT_ASSERT_EQUAL(ACCEPT + "; server_max_window_bits=15",
+                       negotiatePermessageDeflate(
+                           {"permessage-deflate; client_max_window_bits=10; "
+                            "server_max_window_bits=\"15\""}));
+  CPPUNIT_ASSERT_EQUAL(ACCEPT + "; server_max_window_bits=15",
+                       negotiatePermessageDeflate(
+                           {"permessage-deflate; server_max_window_bits=15"}));
+  // The first offer limits our window, so the second one is accepted.
+  CPPUNIT_ASSERT_EQUAL(ACCEPT, negotiatePermessageDeflate(
+                                   {"permessage-deflate; "
+                                    "server_max_window_bits=10, "
+                                    "permessage-deflate"}));
+}
+
+void PermessageDeflateTest::testNegotiate_decline()
+{
+  CPPUNIT_ASSERT_EQUAL(std::string(), negotiatePermessageDeflate({}));
+  CPPUNIT_ASSERT_EQUAL(std::string(),
+                       negotiatePermessageDeflate({"x-webkit-deflate-frame"}));
+  CPPUNIT_ASSERT_EQUAL(std::string(),
+                       negotiatePermessageDeflate(
+                           {"permessage-deflate; server_max_window_bits=10"}));
+  CPPUNIT_ASSERT_EQUAL(std::string(),
+                       negotiatePermessageDeflate(
+                           {"permessage-deflate; server_max_window_bits"}));
+  CPPUNIT_ASSERT_EQUAL(std::string(),
+                       negotiatePermessageDeflate(
+                           {"permessage-deflate; client_max_window_bits=16"}));
+  CPPUNIT_ASSERT_EQUAL(std::string(),
+                       negotiatePermessageDeflate(
+                           {"permessage-deflate; "
+                            "server_no_context_takeover=1"}));
+  CPPUNIT_ASSERT_EQUAL(std::string(),
+                       negotiatePermessageDeflate(
+                           {"permessage-deflate; client_no_context_takeover; "
+                            "client_no_context_takeover"}));
+  CPPUNIT_ASSERT_EQUAL(std::string(), negotiatePermessageDeflate(
+                                          {"permessage-deflate; foo"}));
+}
+
+void PermessageDeflateTest::testDeflate()
+{
+  PermessageDeflater deflater;
+  // The example in RFC 7692 section 7.2.3.1
+  CPPUNIT_ASSERT_EQUAL(std::string("f248cdc9c90700"),
+                       util::toHex(deflater.deflate("Hello")));
+  // No context takeover
+  CPPUNIT_ASSERT_EQUAL(std::string("f248cdc9c90700"),
+                       util::toHex(deflater.deflate("Hello")));
+
+  std::string msg;
+  for (int i = 0; i < 1000; ++i) {
+    msg += R"({"jsonrpc":"2.0","method":"aria2.onDownloadPause")";
+  }
+  auto compressed = deflater.deflate(msg);
+  CPPUNIT_ASSERT(compressed.size() < msg.size() / 10);
+  PermessageInflater inflater;
+  std::string out;
+  CPPUNIT_ASSERT(inflater.inflate(
+      out, reinterpret_cast<const unsigned char*>(compressed.data()),
+      compressed.size(), msg.size()));
+  CPPUNIT_ASSERT(inflater.finish(out, msg.size()));
+  CPPUNIT_ASSERT(msg == out);
+}
+
+void PermessageDeflateTest::testInflate()
+{
+  PermessageInflater inflater;
+  auto data = fromHex("f248cdc9c90700");
+  // Fed a byte at a time
+  std::string out;
+  for (auto c : data) {
+    CPPUNIT_ASSERT(inflater.inflate(
+        out, reinterpret_cast<const unsigned char*>(&c), 1, 5));
+  }
+  CPPUNIT_ASSERT(inflater.finish(out, 5));
+  CPPUNIT_ASSERT_EQUAL(std::string("Hello"), out);
+  // Too long
+  out.clear();
+  CPPUNIT_ASSERT(!inflater.inflate(
+      out, reinterpret_cast<const unsigned char*>(data.data()), data.size(),
+      4));
+}
+
+void PermessageDeflateTest::testInflate_contextTakeover()
+{
+  PermessageInflater inflater;
+  // The second message refers to the first one, as the example in
+  // RFC 7692.
+  std::string out;
+  auto first = fromHex("f248cdc9c90700");
+  auto second = fromHex("f200110000");
+  CPPUNIT_ASSERT(inflater.inflate(
+      out, reinterpret_cast<const unsigned char*>(first.data()), first.size(),
+      1024));
+  CPPUNIT_ASSERT(inflater.finish(out, 1024));
+  CPPUNIT_ASSERT(inflater.inflate(
+      out, reinterpret_cast<const unsigned char*>(second.data()),
+      second.size(), 1024));
+  CPPUNIT_ASSERT(inflater.finish(out, 1024));
+  CPPUNIT_ASSERT_EQUAL(std::string("HelloHello"), out);
+}
+
+void PermessageDeflateTest::testInflate_finalBlock()
+{
+  PermessageInflater inflater;
+  // "Hello" in a block with BFINAL set, followed by padding
+  std::string out;
+  for (int i = 0; i < 2; ++i) {
+    auto data = fromHex("f348cdc9c9070000");
+    CPPUNIT_ASSERT(inflater.inflate(
+        out, reinterpret_cast<const unsigned char*>(data.data()), data.size(),
+        1024));
+    CPPUNIT_ASSERT(inflater.finish(out, 1024));
+  }
+  CPPUNIT_ASSERT_EQUAL(std::string("HelloHello"), out);
+}
+
+void PermessageDeflateTest::testInflate_error()
+{
+  PermessageInflater inflater;
+  std::string out;
+  auto data = fromHex("ffffffff");
+  CPPUNIT_ASSERT(!inflater.inflate(
+      out, reinterpret_cast<const unsigned char*>(data.data()), data.size(),
+      1024));
+}
+
+} // namespace rpc
+
+} // namespace aria2
@@ -0,0 +1,142 @@
+#include "PieceHashIndex.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "DownloadContext.h"
+#include "FileEntry.h"
+#include "BufferedFile.h"
+#include "File.h"
+#include "TestUtil.h"
+
+namespace aria2 {
+
+class PieceHashIndexTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(PieceHashIndexTest);
+  CPPUNIT_TEST(testAddAndFind);
+  CPPUNIT_TEST(testAdd_downloadContext);
+  CPPUNIT_TEST(testSaveAndLoad);
+  CPPUNIT_TEST(testLoad_malformed);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testAddAndFind();
+  void testAdd_downloadContext();
+  void testSaveAndLoad();
+  void testLoad_malformed();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(PieceHashIndexTest);
+
+namespace {
+const std::string HASH1(20, 'a');
+const std::string HASH2(20, 'b');
+const std::string HASH3(20, 'c');
+} // namespace
+
+void PieceHashIndexTest::testAddAndFind()
+{
+  PieceHashIndex index;
+  index.add("sha-1", HASH1, 1024, "/data/a.iso", 4096);
+  index.add("sha-1", HASH2, 1024, "/data/a.iso", 5120);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, index.size());
+  auto loc = index.find("sha-1", HASH1, 1024);
+  CPPUNIT_ASSERT(loc);
+  CPPUNIT_ASSERT_EQUAL(std::string("/data/a.iso"), loc->path);
+  CPPUNIT_ASSERT_EQUAL((int64_t)4096, loc->offset);
+  // The hash type and the length are part of the key.
+  CPPUNIT_ASSERT(!index.find("sha-256", HASH1, 1024));
+  CPPUNIT_ASSERT(!index.find("sha-1", HASH1, 1000));
+  // The latest location wins.
+  index.add("sha-1", HASH1, 1024, "/data/b.iso", 0);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, index.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("/data/b.iso"),
+                       index.find("sha-1", HASH1, 1024)->path);
+  index.remove("sha-1", HASH1, 1024);
+  CPPUNIT_ASSERT(!index.find("sha-1", HASH1, 1024));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, index.size());
+}
+
+void PieceHashIndexTest::testAdd_downloadContext()
+{
+  DownloadContext dctx(4, 11);
+  std::vector<std::shared_ptr<FileEntry>> fileEntries{
+      std::make_shared<FileEntry>("/data/a", 6, 0),
+      std::make_shared<FileEntry>("/data/b", 5, 6)};
+  dctx.setFileEntries(std::begin(fileEntries), std::end(fileEntries));
+  std::vector<std::string> hashes{HASH1, HASH2, HASH3};
+  dctx.setPieceHashes("sha-1", std::begin(hashes), std::end(hashes));
+  PieceHashIndex index;
+  // The second piece spans both files.
+  CPPUNIT_ASSERT_EQUAL((size_t)2, index.add(dctx));
+  auto loc = index.find("sha-1", HASH1, 4);
+  CPPUNIT_ASSERT(loc);
+  CPPUNIT_ASSERT_EQUAL(std::string("/data/a"), loc->path);
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, loc->offset);
+  CPPUNIT_ASSERT(!index.find("sha-1", HASH2, 4));
+  // The last piece is shorter.
+  loc = index.find("sha-1", HASH3, 3);
+  CPPUNIT_ASSERT(loc);
+  CPPUNIT_ASSERT_EQUAL(std::string("/data/b"), loc->path);
+  CPPUNIT_ASSERT_EQUAL((int64_t)2, loc->offset);
+
+  PieceHashIndex index2;
+  dctx.getFileEntries()[1]->setRequested(false);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, index2.add(dctx));
+  CPPUNIT_ASSERT(!index2.find("sha-1", HASH3, 3));
+
+  DownloadContext noHash(4, 11, "/data/c");
+  CPPUNIT_ASSERT_EQUAL((size_t)0, index2.add(noHash));
+}
+
+void PieceHashIndexTest::testSaveAndLoad()
+{
+  std::string filename =
+      A2_TEST_OUT_DIR "/aria2_PieceHashIndexTest_testSaveAndLoad";
+  File(filename).remove();
+  PieceHashIndex index;
+  index.add("sha-1", HASH1, 1024, "/data/with space/a.iso", 4096);
+  index.add("sha-256", HASH2, 512, "/data/b.iso", 0);
+  CPPUNIT_ASSERT(index.save(filename));
+  CPPUNIT_ASSERT_EQUAL(
+      std::string("sha-1 6161616161616161616161616161616161616161"
+                  " 1024 4096 %2Fdata%2Fwith%20space%2Fa.iso\n"
+                  "sha-256 6262626262626262626262626262626262626262"
+                  " 512 0 %2Fdata%2Fb.iso\n"),
+      readFile(filename));
+
+  PieceHashIndex loaded;
+  CPPUNIT_ASSERT(loaded.load(filename));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, loaded.size());
+  auto loc = loaded.find("sha-1", HASH1, 1024);
+  CPPUNIT_ASSERT(loc);
+  CPPUNIT_ASSERT_EQUAL(std::string("/data/with space/a.iso"), loc->path);
+  CPPUNIT_ASSERT_EQUAL((int64_t)4096, loc->offset);
+  loc = loaded.find("sha-256", HASH2, 512);
+  CPPUNIT_ASSERT(loc);
+  CPPUNIT_ASSERT_EQUAL(std::string("/data/b.iso"), loc->path);
+}
+
+void PieceHashIndexTest::testLoad_malformed()
+{
+  std::string filename =
+      A2_TEST_OUT_DIR "/aria2_PieceHashIndexTest_testLoad_malformed";
+  {
+    BufferedFile fp(filename.c_str(), BufferedFile::WRITE);
+    fp.printf("sha-1 6161616161616161616161616161616161616161 1024 0 %%2Fa\n"
+              "sha-1 zz 1024 0 %%2Fb\n"
+              "sha-1 6262626262626262626262626262626262626262 0 0 %%2Fc\n"
+              "sha-1 6363636363636363636363636363636363636363 1024\n"
+              "\n"
+              "SHA-1 6464646464646464646464646464646464646464 1 -1 %%2Fd\n");
+    fp.close();
+  }
+  PieceHashIndex index;
+  CPPUNIT_ASSERT(index.load(filename));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, index.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("/a"),
+                       index.find("sha-1", HASH1, 1024)->path);
+  CPPUNIT_ASSERT(!index.load(A2_TEST_OUT_DIR "/aria2_PieceHashIndexTest_none"));
+}
+
+} // namespace aria2
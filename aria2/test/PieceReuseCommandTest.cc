@@ -0,0 +1,159 @@
+#include "PieceReuseCommand.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "TestUtil.h"
+#include "DownloadEngine.h"
+#include "SelectEventPoll.h"
+#include "RequestGroup.h"
+#include "RequestGroupMan.h"
+#include "DownloadContext.h"
+#include "PieceStorage.h"
+#include "DiskAdaptor.h"
+#include "PieceHashIndex.h"
+#include "MessageDigest.h"
+#include "BufferedFile.h"
+#include "GroupId.h"
+#include "Option.h"
+#include "File.h"
+#include "prefs.h"
+
+namespace aria2 {
+
+class PieceReuseCommandTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(PieceReuseCommandTest);
+  CPPUNIT_TEST(testReuse);
+  CPPUNIT_TEST(testReuse_changed);
+  CPPUNIT_TEST(testReuse_missingFile);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  std::shared_ptr<Option> option_;
+  std::unique_ptr<DownloadEngine> e_;
+  std::shared_ptr<RequestGroup> group_;
+  std::string data_;
+  std::string srcPath_;
+  std::string dstPath_;
+
+public:
+  void setUp()
+  {
+    option_ = std::make_shared<Option>();
+    e_ = make_unique<DownloadEngine>(make_unique<SelectEventPoll>());
+    e_->setOption(option_.get());
+    e_->setRequestGroupMan(make_unique<RequestGroupMan>(
+        std::vector<std::shared_ptr<RequestGroup>>{}, 1, option_.get()));
+    e_->getRequestGroupMan()->loadPieceHashIndex(
+        A2_TEST_OUT_DIR "/aria2_PieceReuseCommandTest_noindex");
+
+    // 3 pieces of 1KiB, each of them different.
+    for (size_t i = 0; i < 3_k; ++i) {
+      data_ += static_cast<char>('a' + (i / 1_k * 7 + i) % 26);
+    }
+    srcPath_ = A2_TEST_OUT_DIR "/aria2_PieceReuseCommandTest_src";
+    dstPath_ = A2_TEST_OUT_DIR "/aria2_PieceReuseCommandTest_dst";
+    File(srcPath_).remove();
+    File(dstPath_).remove();
+
+    auto dctx = std::make_shared<DownloadContext>(1_k, 3_k, dstPath_);
+    std::vector<std::string> hashes;
+    for (size_t i = 0; i < 3; ++i) {
+      auto ctx = MessageDigest::sha1();
+      ctx->update(data_.data() + i * 1_k, 1_k);
+      hashes.push_back(ctx->digest());
+    }
+    dctx->setPieceHashes("sha-1", std::begin(hashes), std::end(hashes));
+    group_ = std::make_shared<RequestGroup>(GroupId::create(), option_);
+    group_->setDownloadContext(dctx);
+    group_->initPieceStorage();
+    group_->getPieceStorage()->getDiskAdaptor()->initAndOpenFile();
+  }
+
+  void tearDown()
+  {
+    group_->getPieceStorage()->getDiskAdaptor()->closeFile();
+  }
+
+  void writeSource(const std::string& data)
+  {
+    BufferedFile fp(srcPath_.c_str(), BufferedFile::WRITE);
+    CPPUNIT_ASSERT_EQUAL(data.size(), fp.write(data.data(), data.size()));
+    CPPUNIT_ASSERT_EQUAL(0, fp.close());
+  }
+
+  PieceHashIndex* index()
+  {
+    return e_->getRequestGroupMan()->getPieceHashIndex();
+  }
+
+  // Indexes the piece 1 of the download at |offset| in |path|.
+  void addPiece1(const std::string& path, int64_t offset)
+  {
+    index()->add("sha-1", group_->getDownloadContext()->getPieceHash(1), 1_k,
+                 path, offset);
+  }
+
+  void run()
+  {
+    e_->addCommand(
+        make_unique<PieceReuseCommand>(e_->newCUID(), group_.get(), e_.get()));
+    e_->run();
+  }
+
+  void testReuse();
+  void testReuse_changed();
+  void testReuse_missingFile();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(PieceReuseCommandTest);
+
+void PieceReuseCommandTest::testReuse()
+{
+  // The source has the piece at another offset.
+  writeSource("xyz" + data_.substr(1_k, 1_k));
+  addPiece1(srcPath_, 3);
+  run();
+  auto& ps = group_->getPieceStorage();
+  CPPUNIT_ASSERT(!ps->hasPiece(0));
+  CPPUNIT_ASSERT(ps->hasPiece(1));
+  CPPUNIT_ASSERT(!ps->hasPiece(2));
+  CPPUNIT_ASSERT(!ps->isPieceUsed(1));
+  CPPUNIT_ASSERT_EQUAL((int64_t)1_k, ps->getCompletedLength());
+  ps->getDiskAdaptor()->closeFile();
+  CPPUNIT_ASSERT_EQUAL(data_.substr(1_k, 1_k),
+                       readFile(dstPath_).substr(1_k, 1_k));
+  CPPUNIT_ASSERT(index()->find("sha-1",
+                               group_->getDownloadContext()->getPieceHash(1),
+                               1_k));
+}
+
+void PieceReuseCommandTest::testReuse_changed()
+{
+  auto data = data_.substr(1_k, 1_k);
+  data[100] = '!';
+  writeSource(data);
+  addPiece1(srcPath_, 0);
+  run();
+  auto& ps = group_->getPieceStorage();
+  // The piece is cancelled, so that it is fetched as usual.
+  CPPUNIT_ASSERT(!ps->hasPiece(1));
+  CPPUNIT_ASSERT(!ps->isPieceUsed(1));
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, ps->getCompletedLength());
+  CPPUNIT_ASSERT(!index()->find(
+      "sha-1", group_->getDownloadContext()->getPieceHash(1), 1_k));
+}
+
+void PieceReuseCommandTest::testReuse_missingFile()
+{
+  addPiece1(srcPath_, 0);
+  run();
+  auto& ps = group_->getPieceStorage();
+  CPPUNIT_ASSERT(!ps->hasPiece(1));
+  CPPUNIT_ASSERT(!ps->isPieceUsed(1));
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, ps->getCompletedLength());
+  CPPUNIT_ASSERT(!index()->find(
+      "sha-1", group_->getDownloadContext()->getPieceHash(1), 1_k));
+}
+
+} // namespace aria2
@@ -0,0 +1,106 @@
+#include "PlaybackCursor.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "wallclock.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+class PlaybackCursorTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(PlaybackCursorTest);
+  CPPUNIT_TEST(testGetPosition);
+  CPPUNIT_TEST(testPaused);
+  CPPUNIT_TEST(testCanMeetDeadline);
+  CPPUNIT_TEST(testGetReachableOffset);
+  CPPUNIT_TEST_SUITE_END();
+
+  ManualTimeSource source_;
+  TimeSource* prev_;
+
+public:
+  void setUp()
+  {
+    prev_ = setTimeSource(&source_);
+    global::wallclock().reset();
+  }
+
+  void tearDown()
+  {
+    setTimeSource(prev_);
+    global::wallclock().reset();
+  }
+
+  // Moves the clock as the event loop does.
+  void advance(std::chrono::milliseconds t)
+  {
+    source_.advance(t);
+    global::wallclock().reset();
+  }
+
+  void testGetPosition();
+  void testPaused();
+  void testCanMeetDeadline();
+  void testGetReachableOffset();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(PlaybackCursorTest);
+
+void PlaybackCursorTest::testGetPosition()
+{
+  PlaybackCursor cursor;
+  CPPUNIT_ASSERT(!cursor.isPlaying());
+  cursor.update(1_m, 100_k);
+  CPPUNIT_ASSERT(cursor.isPlaying());
+  CPPUNIT_ASSERT_EQUAL((int64_t)1_m, cursor.getPosition());
+  advance(std::chrono::milliseconds(2500));
+  CPPUNIT_ASSERT_EQUAL((int64_t)(1_m + 250_k), cursor.getPosition());
+  CPPUNIT_ASSERT_EQUAL((int64_t)(1_m + 250_k + 2000_k),
+                       cursor.getUrgentEnd());
+  CPPUNIT_ASSERT(std::chrono::milliseconds(1000) ==
+                 cursor.getTimeLeft(1_m + 350_k));
+  CPPUNIT_ASSERT(std::chrono::milliseconds(-2500) ==
+                 cursor.getTimeLeft(1_m));
+  // The player seeks back.
+  cursor.update(0, 100_k);
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, cursor.getPosition());
+}
+
+void PlaybackCursorTest::testPaused()
+{
+  PlaybackCursor cursor;
+  cursor.update(1_m, 0);
+  advance(std::chrono::milliseconds(2500));
+  CPPUNIT_ASSERT_EQUAL((int64_t)1_m, cursor.getPosition());
+  // Only the byte at the position is urgent.
+  CPPUNIT_ASSERT_EQUAL((int64_t)(1_m + 1), cursor.getUrgentEnd());
+  CPPUNIT_ASSERT(std::chrono::milliseconds::max() ==
+                 cursor.getTimeLeft(2_m));
+  CPPUNIT_ASSERT(cursor.canMeetDeadline(1_m, 1_m, 0));
+}
+
+void PlaybackCursorTest::testCanMeetDeadline()
+{
+  PlaybackCursor cursor;
+  cursor.update(0, 100_k);
+  // The player reaches 1MiB in 10.24 seconds.
+  CPPUNIT_ASSERT(cursor.canMeetDeadline(1_m, 1_m, 100_k));
+  CPPUNIT_ASSERT(!cursor.canMeetDeadline(1_m, 1_m, 99_k));
+  CPPUNIT_ASSERT(!cursor.canMeetDeadline(1_m, 1_m, 0));
+  advance(std::chrono::seconds(1));
+  CPPUNIT_ASSERT(!cursor.canMeetDeadline(1_m, 1_m, 100_k));
+}
+
+void PlaybackCursorTest::testGetReachableOffset()
+{
+  PlaybackCursor cursor;
+  cursor.update(1_m, 100_k);
+  // Downloading 1MiB at 50KiB/s takes 20.48 seconds, while the player
+  // plays 2MiB.
+  CPPUNIT_ASSERT_EQUAL((int64_t)3_m, cursor.getReachableOffset(1_m, 50_k));
+  CPPUNIT_ASSERT(cursor.canMeetDeadline(3_m, 1_m, 50_k));
+  CPPUNIT_ASSERT(!cursor.canMeetDeadline(3_m - 1_k, 1_m, 50_k));
+}
+
+} // namespace aria2
@@ -0,0 +1,178 @@
+#include "ReadAheadBuffer.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace aria2 {
+
+class ReadAheadBufferTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(ReadAheadBufferTest);
+  CPPUNIT_TEST(testRead);
+  CPPUNIT_TEST(testRead_direct);
+  CPPUNIT_TEST(testRead_noCapacity);
+  CPPUNIT_TEST(testRead_wouldBlock);
+  CPPUNIT_TEST(testRead_eof);
+  CPPUNIT_TEST(testClear);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testRead();
+  void testRead_direct();
+  void testRead_noCapacity();
+  void testRead_wouldBlock();
+  void testRead_eof();
+  void testClear();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ReadAheadBufferTest);
+
+namespace {
+const ssize_t WOULDBLOCK = -37;
+
+// Stands in for libssh2_sftp_read() on a remote file.
+class Transport {
+public:
+  Transport(std::string data) : data_(std::move(data)), pos_(0), block_(false)
+  {
+  }
+
+  ssize_t operator()(char* buf, size_t len)
+  {
+    lengths.push_back(len);
+    if (block_) {
+      return WOULDBLOCK;
+    }
+    auto n = std::min(len, data_.size() - pos_);
+    memcpy(buf, data_.data() + pos_, n);
+    pos_ += n;
+    return n;
+  }
+
+  void seek(size_t pos) { pos_ = pos; }
+
+  void setBlock(bool block) { block_ = block; }
+
+  // The lengths passed to each read.
+  std::vector<size_t> lengths;
+
+private:
+  std::string data_;
+  size_t pos_;
+  bool block_;
+};
+
+std::string read(ReadAheadBuffer& buf, Transport& transport, size_t len)
+{
+  std::string res(len, '\0');
+  auto n = buf.read(&res[0], len, std::ref(transport));
+  CPPUNIT_ASSERT(n >= 0);
+  res.resize(n);
+  return res;
+}
+} // namespace
+
+void ReadAheadBufferTest::testRead()
+{
+  Transport transport("0123456789abcdef");
+  ReadAheadBuffer buf;
+  buf.reset(10);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, buf.getBufferedLength());
+
+  CPPUNIT_ASSERT_EQUAL(std::string("0123"), read(buf, transport, 4));
+  // The transport was asked for the whole buffer.
+  CPPUNIT_ASSERT_EQUAL((size_t)1, transport.lengths.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)10, transport.lengths[0]);
+  CPPUNIT_ASSERT_EQUAL((size_t)6, buf.getBufferedLength());
+
+  // Served from the buffer, even if |len| exceeds what is left.
+  CPPUNIT_ASSERT_EQUAL(std::string("45678"), read(buf, transport, 5));
+  CPPUNIT_ASSERT_EQUAL(std::string("9"), read(buf, transport, 4));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, transport.lengths.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, buf.getBufferedLength());
+
+  CPPUNIT_ASSERT_EQUAL(std::string("ab"), read(buf, transport, 2));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, transport.lengths.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)4, buf.getBufferedLength());
+}
+
+void ReadAheadBufferTest::testRead_direct()
+{
+  Transport transport("0123456789abcdef");
+  ReadAheadBuffer buf;
+  buf.reset(4);
+  // Reads at least as large as the buffer bypass it.
+  CPPUNIT_ASSERT_EQUAL(std::string("01234"), read(buf, transport, 5));
+  CPPUNIT_ASSERT_EQUAL((size_t)5, transport.lengths[0]);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, buf.getBufferedLength());
+
+  CPPUNIT_ASSERT_EQUAL(std::string("5"), read(buf, transport, 1));
+  CPPUNIT_ASSERT_EQUAL((size_t)3, buf.getBufferedLength());
+  // The buffered data come first.
+  CPPUNIT_ASSERT_EQUAL(std::string("678"), read(buf, transport, 8));
+  CPPUNIT_ASSERT_EQUAL(std::string("9abcdef"), read(buf, transport, 8));
+  CPPUNIT_ASSERT_EQUAL((size_t)3, transport.lengths.size());
+}
+
+void ReadAheadBufferTest::testRead_noCapacity()
+{
+  Transport transport("0123456789abcdef");
+  ReadAheadBuffer buf;
+  buf.reset(0);
+  CPPUNIT_ASSERT_EQUAL(std::string("0"), read(buf, transport, 1));
+  CPPUNIT_ASSERT_EQUAL(std::string("12"), read(buf, transport, 2));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, transport.lengths.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, transport.lengths[0]);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, transport.lengths[1]);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, buf.getBufferedLength());
+}
+
+void ReadAheadBufferTest::testRead_wouldBlock()
+{
+  Transport transport("0123456789abcdef");
+  ReadAheadBuffer buf;
+  buf.reset(8);
+  char data[4];
+  transport.setBlock(true);
+  CPPUNIT_ASSERT_EQUAL(WOULDBLOCK, buf.read(data, 4, std::ref(transport)));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, buf.getBufferedLength());
+
+  transport.setBlock(false);
+  CPPUNIT_ASSERT_EQUAL(std::string("0123"), read(buf, transport, 4));
+  // Buffered data are returned without touching the transport.
+  transport.setBlock(true);
+  CPPUNIT_ASSERT_EQUAL(std::string("4567"), read(buf, transport, 4));
+  CPPUNIT_ASSERT_EQUAL(WOULDBLOCK, buf.read(data, 4, std::ref(transport)));
+}
+
+void ReadAheadBufferTest::testRead_eof()
+{
+  Transport transport("012");
+  ReadAheadBuffer buf;
+  buf.reset(8);
+  CPPUNIT_ASSERT_EQUAL(std::string("01"), read(buf, transport, 2));
+  CPPUNIT_ASSERT_EQUAL(std::string("2"), read(buf, transport, 2));
+  CPPUNIT_ASSERT_EQUAL(std::string(), read(buf, transport, 2));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, buf.getBufferedLength());
+}
+
+void ReadAheadBufferTest::testClear()
+{
+  Transport transport("0123456789abcdef");
+  ReadAheadBuffer buf;
+  buf.reset(8);
+  CPPUNIT_ASSERT_EQUAL(std::string("01"), read(buf, transport, 2));
+  CPPUNIT_ASSERT_EQUAL((size_t)6, buf.getBufferedLength());
+  // A seek discards the data read ahead from the old position.
+  buf.clear();
+  transport.seek(12);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, buf.getBufferedLength());
+  CPPUNIT_ASSERT_EQUAL(std::string("cd"), read(buf, transport, 2));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, buf.getBufferedLength());
+  CPPUNIT_ASSERT_EQUAL(std::string("ef"), read(buf, transport, 4));
+}
+
+} // namespace aria2
@@ -35,6 +35,7 @@ class RequestGroupManTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testFillRequestGroupFromReserver_uriParser);
   CPPUNIT_TEST(testInsertReservedGroup);
   CPPUNIT_TEST(testAddDownloadResult);
+  CPPUNIT_TEST(testGetDownloadStat);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -67,6 +68,7 @@ public:
   void testFillRequestGroupFromReserver_uriParser();
   void testInsertReservedGroup();
   void testAddDownloadResult();
+  void testGetDownloadStat();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(RequestGroupManTest);
@@ -280,4 +282,50 @@ void RequestGroupManTest::testAddDownloadResult()
                        rgman_->getDownloadStat().getLastErrorResult());
 }
 
+void RequestGroupManTest::testGetDownloadStat()
+{
+  std::string uri = "http://example.org";
+  auto timeout = createDownloadResult(error_code::TIME_OUT, uri);
+  auto network = createDownloadResult(error_code::NETWORK_PROBLEM, uri);
+  auto inprogress = createDownloadResult(error_code::IN_PROGRESS, uri);
+  auto child = createDownloadResult(error_code::RESOURCE_NOT_FOUND, uri);
+  child->belongsTo = timeout->gid->getNumericId();
+  rgman_->setMaxDownloadResult(10);
+  rgman_->addDownloadResult(timeout);
+  rgman_->addDownloadResult(network);
+  rgman_->addDownloadResult(inprogress);
+  rgman_->addDownloadResult(child);
+  rgman_->addDownloadResult(createDownloadResult(error_code::FINISHED, uri));
+  rgman_->addDownloadResult(createDownloadResult(error_code::REMOVED, uri));
+
+  auto stat = rgman_->getDownloadStat();
+  CPPUNIT_ASSERT(!stat.allCompleted());
+  CPPUNIT_ASSERT_EQUAL(1, stat.getInProgress());
+  CPPUNIT_ASSERT_EQUAL(error_code::NETWORK_PROBLEM, stat.getLastErrorResult());
+
+  CPPUNIT_ASSERT(rgman_->removeDownloadResult(network->gid->getNumericId()));
+  CPPUNIT_ASSERT_EQUAL(error_code::TIME_OUT,
+                       rgman_->getDownloadStat().getLastErrorResult());
+  CPPUNIT_ASSERT(rgman_->removeDownloadResult(inprogress->gid->getNumericId()));
+  CPPUNIT_ASSERT_EQUAL(0, rgman_->getDownloadStat().getInProgress());
+  CPPUNIT_ASSERT(rgman_->removeDownloadResult(timeout->gid->getNumericId()));
+  stat = rgman_->getDownloadStat();
+  // The error of child download is not counted.
+  CPPUNIT_ASSERT(stat.allCompleted());
+  CPPUNIT_ASSERT_EQUAL(error_code::FINISHED, stat.getLastErrorResult());
+
+  // Evicted error is still counted.
+  rgman_->setMaxDownloadResult(1);
+  rgman_->addDownloadResult(createDownloadResult(error_code::TIME_OUT, uri));
+  rgman_->addDownloadResult(createDownloadResult(error_code::FINISHED, uri));
+  stat = rgman_->getDownloadStat();
+  CPPUNIT_ASSERT(!stat.allCompleted());
+  CPPUNIT_ASSERT_EQUAL(error_code::TIME_OUT, stat.getLastErrorResult());
+
+  rgman_->addDownloadResult(createDownloadResult(error_code::IN_PROGRESS, uri));
+  CPPUNIT_ASSERT_EQUAL(1, rgman_->getDownloadStat().getInProgress());
+  rgman_->purgeDownloadResult();
+  CPPUNIT_ASSERT_EQUAL(0, rgman_->getDownloadStat().getInProgress());
+}
+
 } // namespace aria2
@@ -0,0 +1,95 @@
+#include "Bench.h"
+
+#include "DownloadEngine.h"
+#include "SelectEventPoll.h"
+#include "Option.h"
+#include "prefs.h"
+#include "rpc_helper.h"
+#include "RpcResponse.h"
+#include "AuthTokenCache.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+namespace {
+const char SECRET[] = "dashboard-secret-0123456789abcdef";
+
+std::unique_ptr<Dict> createCall(const std::string& methodName,
+                                 std::unique_ptr<List> params)
+{
+  auto dict = Dict::g();
+  dict->put("jsonrpc", "2.0");
+  dict->put("id", Integer::g(1));
+  dict->put("method", methodName);
+  dict->put("params", std::move(params));
+  return dict;
+}
+
+std::unique_ptr<Dict> createGetVersion()
+{
+  auto params = List::g();
+  params->append(std::string("token:") + SECRET);
+  return createCall("aria2.getVersion", std::move(params));
+}
+
+// system.multicall of |n| aria2.getVersion calls, each carrying the
+// token.
+std::unique_ptr<Dict> createMulticall(size_t n)
+{
+  auto calls = List::g();
+  for (size_t i = 0; i < n; ++i) {
+    auto call = Dict::g();
+    call->put("methodName", "aria2.getVersion");
+    auto params = List::g();
+    params->append(std::string("token:") + SECRET);
+    call->put("params", std::move(params));
+    calls->append(std::move(call));
+  }
+  auto params = List::g();
+  params->append(std::move(calls));
+  return createCall("system.multicall", std::move(params));
+}
+
+template <typename F>
+void measure(const std::string& label, DownloadEngine* e,
+             AuthTokenCache* cache, size_t callsPerRequest, F create)
+{
+  auto n = bench::scale(20000) / callsPerRequest;
+  size_t failures = 0;
+  auto start = bench::now();
+  for (size_t i = 0; i < n; ++i) {
+    auto req = create();
+    auto res = rpc::processJsonRpcRequest(req.get(), e, cache);
+    if (res.code != 0) {
+      ++failures;
+    }
+  }
+  auto elapsed = bench::now() - start;
+  bench::report(label, n * callsPerRequest / elapsed, "calls/s");
+  if (failures) {
+    bench::report(label + " failures", failures, "");
+  }
+}
+} // namespace
+
+// aria2.getVersion calls carrying --rpc-secret, as a dashboard polls
+// over a keep-alive connection, one by one and in system.multicall
+// batches of 100.  "no cache" verifies every token with HMAC, and a
+// multicall verifies the token of a batch once.
+A2_BENCHMARK(RpcAuth)
+{
+  Option option;
+  DownloadEngine e(make_unique<SelectEventPoll>());
+  e.setOption(&option);
+  measure("no secret", &e, nullptr, 1, createGetVersion);
+  option.put(PREF_RPC_SECRET, SECRET);
+  measure("secret, no cache", &e, nullptr, 1, createGetVersion);
+  AuthTokenCache cache;
+  measure("secret, connection cache", &e, &cache, 1, createGetVersion);
+  auto multicall = [] { return createMulticall(100); };
+  measure("multicall", &e, nullptr, 100, multicall);
+  cache.clear();
+  measure("multicall, connection cache", &e, &cache, 100, multicall);
+}
+
+} // namespace aria2
@@ -21,6 +21,7 @@
 #include "download_helper.h"
 #include "FileEntry.h"
 #include "RpcMethodFactory.h"
+#include "AuthTokenCache.h"
 #ifdef ENABLE_BITTORRENT
 #  include "BtRegistry.h"
 #  include "BtRuntime.h"
@@ -35,6 +36,7 @@ class RpcMethodTest : public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(RpcMethodTest);
   CPPUNIT_TEST(testAuthorize);
+  CPPUNIT_TEST(testAuthorize_tokenCache);
   CPPUNIT_TEST(testAddUri);
   CPPUNIT_TEST(testAddUri_withoutUri);
   CPPUNIT_TEST(testAddUri_notUri);
@@ -76,12 +78,17 @@ class RpcMethodTest : public CppUnit::TestFixture {
 #endif // ENABLE_BITTORRENT
   CPPUNIT_TEST(testChangePosition);
   CPPUNIT_TEST(testChangePosition_fail);
+  CPPUNIT_TEST(testChangePlaybackPosition);
   CPPUNIT_TEST(testGetSessionInfo);
   CPPUNIT_TEST(testChangeUri);
   CPPUNIT_TEST(testChangeUri_fail);
   CPPUNIT_TEST(testPause);
   CPPUNIT_TEST(testSystemMulticall);
   CPPUNIT_TEST(testSystemMulticall_fail);
+  CPPUNIT_TEST(testSystemMulticall_tokenCache);
+#ifdef ENABLE_BITTORRENT
+  CPPUNIT_TEST(testSystemMulticall_addTorrent);
+#endif // ENABLE_BITTORRENT
   CPPUNIT_TEST(testSystemListMethods);
   CPPUNIT_TEST(testSystemListNotifications);
   CPPUNIT_TEST_SUITE_END();
@@ -105,6 +112,7 @@ public:
   }
 
   void testAuthorize();
+  void testAuthorize_tokenCache();
   void testAddUri();
   void testAddUri_withoutUri();
   void testAddUri_notUri();
@@ -146,12 +154,17 @@ public:
 #endif // ENABLE_BITTORRENT
   void testChangePosition();
   void testChangePosition_fail();
+  void testChangePlaybackPosition();
   void testGetSessionInfo();
   void testChangeUri();
   void testChangeUri_fail();
   void testPause();
   void testSystemMulticall();
   void testSystemMulticall_fail();
+  void testSystemMulticall_tokenCache();
+#ifdef ENABLE_BITTORRENT
+  void testSystemMulticall_addTorrent();
+#endif // ENABLE_BITTORRENT
   void testSystemListMethods();
   void testSystemListNotifications();
 };
@@ -213,6 +226,44 @@ void RpcMethodTest::testAuthorize()
   }
 }
 
+void RpcMethodTest::testAuthorize_tokenCache()
+{
+  TellActiveRpcMethod m;
+  AuthTokenCache cache;
+  e_->getOption()->put(PREF_RPC_SECRET, "foo");
+  {
+    auto req = createReq(TellActiveRpcMethod::getMethodName());
+    req.params->append("token:foo2");
+    req.tokenCache = &cache;
+    auto res = m.execute(std::move(req), e_.get());
+    CPPUNIT_ASSERT_EQUAL(1, res.code);
+    CPPUNIT_ASSERT(!cache.match("foo2"));
+  }
+  {
+    auto req = createReq(TellActiveRpcMethod::getMethodName());
+    req.params->append("token:foo");
+    req.tokenCache = &cache;
+    auto res = m.execute(std::move(req), e_.get());
+    CPPUNIT_ASSERT_EQUAL(0, res.code);
+    CPPUNIT_ASSERT(cache.match("foo"));
+  }
+  // The cached token does not let other tokens in.
+  {
+    auto req = createReq(TellActiveRpcMethod::getMethodName());
+    req.params->append("token:fop");
+    req.tokenCache = &cache;
+    auto res = m.execute(std::move(req), e_.get());
+    CPPUNIT_ASSERT_EQUAL(1, res.code);
+    CPPUNIT_ASSERT(cache.match("foo"));
+  }
+  {
+    auto req = createReq(TellActiveRpcMethod::getMethodName());
+    req.tokenCache = &cache;
+    auto res = m.execute(std::move(req), e_.get());
+    CPPUNIT_ASSERT_EQUAL(1, res.code);
+  }
+}
+
 void RpcMethodTest::testAddUri()
 {
   AddUriRpcMethod m;
@@ -1115,6 +1166,52 @@ void RpcMethodTest::testChangePosition_fail()
   CPPUNIT_ASSERT_EQUAL(1, res.code);
 }
 
+namespace {
+RpcRequest createChangePlaybackPositionReq(a2_gid_t gid, int64_t position)
+{
+  auto req = createReq(ChangePlaybackPositionRpcMethod::getMethodName());
+  req.params->append(GroupId::toHex(gid));
+  req.params->append(Integer::g(position));
+  return req;
+}
+} // namespace
+
+void RpcMethodTest::testChangePlaybackPosition()
+{
+  auto group =
+      std::make_shared<RequestGroup>(GroupId::create(), util::copy(option_));
+  auto dctx = std::make_shared<DownloadContext>(1_m, 64_m, "aria2.tar.bz2");
+  group->setDownloadContext(dctx);
+  e_->getRequestGroupMan()->addReservedGroup(group);
+  ChangePlaybackPositionRpcMethod m;
+  auto req = createChangePlaybackPositionReq(group->getGID(), 10_m);
+  req.params->append(Integer::g(500_k));
+  // Not downloaded with --stream-piece-selector=deadline
+  auto res = m.execute(std::move(req), e_.get());
+  CPPUNIT_ASSERT_EQUAL(1, res.code);
+  CPPUNIT_ASSERT(!dctx->getPlaybackCursor().isPlaying());
+
+  group->getOption()->put(PREF_STREAM_PIECE_SELECTOR, A2_V_DEADLINE);
+  req = createChangePlaybackPositionReq(group->getGID(), 10_m);
+  req.params->append(Integer::g(500_k));
+  res = m.execute(std::move(req), e_.get());
+  CPPUNIT_ASSERT_EQUAL(0, res.code);
+  CPPUNIT_ASSERT_EQUAL(std::string("OK"), downcast<String>(res.param)->s());
+  CPPUNIT_ASSERT(dctx->getPlaybackCursor().isPlaying());
+  CPPUNIT_ASSERT_EQUAL((int64_t)500_k, dctx->getPlaybackCursor().getBitrate());
+
+  // bitrate is optional.
+  res = m.execute(createChangePlaybackPositionReq(group->getGID(), 20_m),
+                  e_.get());
+  CPPUNIT_ASSERT_EQUAL(0, res.code);
+  CPPUNIT_ASSERT_EQUAL((int64_t)20_m, dctx->getPlaybackCursor().getPosition());
+  CPPUNIT_ASSERT(!dctx->getPlaybackCursor().isPlaying());
+
+  res = m.execute(createChangePlaybackPositionReq(group->getGID(), -1),
+                  e_.get());
+  CPPUNIT_ASSERT_EQUAL(1, res.code);
+}
+
 namespace {
 RpcRequest createChangeUriReq(a2_gid_t gid, size_t fileIndex)
 {
@@ -1411,6 +1508,96 @@ void RpcMethodTest::testSystemMulticall()
   CPPUNIT_ASSERT(downcast<List>(resParams->get(6)));
 }
 
+void RpcMethodTest::testSystemMulticall_tokenCache()
+{
+  e_->getOption()->put(PREF_RPC_SECRET, "foo");
+  SystemMulticallRpcMethod m;
+  auto req = createReq("system.multicall");
+  auto reqparams = List::g();
+  for (auto& token : {"token:foo", "token:bar", "token:foo"}) {
+    auto dict = Dict::g();
+    dict->put("methodName", GetVersionRpcMethod::getMethodName());
+    auto params = List::g();
+    params->append(token);
+    dict->put("params", std::move(params));
+    reqparams->append(std::move(dict));
+  }
+  req.params->append(std::move(reqparams));
+  AuthTokenCache cache;
+  req.tokenCache = &cache;
+  auto res = m.execute(std::move(req), e_.get());
+  CPPUNIT_ASSERT_EQUAL(0, res.code);
+  CPPUNIT_ASSERT(rpc::not_authorized(res));
+  const List* resParams = downcast<List>(res.param);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, resParams->size());
+  CPPUNIT_ASSERT(downcast<List>(resParams->get(0)));
+  CPPUNIT_ASSERT(downcast<Dict>(resParams->get(1)));
+  CPPUNIT_ASSERT(downcast<List>(resParams->get(2)));
+  // The connection is authenticated by the first call.
+  CPPUNIT_ASSERT(cache.match("foo"));
+}
+
+#ifdef ENABLE_BITTORRENT
+void RpcMethodTest::testSystemMulticall_addTorrent()
+{
+  std::string dir = A2_TEST_OUT_DIR "/aria2_RpcMethodTest_multicallTorrent";
+  File(dir).mkdirs();
+  File(dir + "/0a3893293e27ac0490424c06de4d09242215f0a6.torrent").remove();
+  e_->getOption()->put(PREF_RPC_SAVE_UPLOAD_METADATA, A2_V_TRUE);
+  SystemMulticallRpcMethod m;
+  auto req = createReq("system.multicall");
+  auto reqparams = List::g();
+  for (int i = 0; i < 2; ++i) {
+    auto dict = Dict::g();
+    dict->put("methodName", AddTorrentRpcMethod::getMethodName());
+    auto params = List::g();
+    params->append(readFile(A2_TEST_DIR "/single.torrent"));
+    auto uris = List::g();
+    uris->append("http://localhost/" + util::itos(i));
+    params->append(std::move(uris));
+    if (i == 1) {
+      auto opt = Dict::g();
+      opt->put(PREF_DIR->k, dir);
+      params->append(std::move(opt));
+    }
+    dict->put("params", std::move(params));
+    reqparams->append(std::move(dict));
+  }
+  {
+    auto dict = Dict::g();
+    dict->put("methodName", AddTorrentRpcMethod::getMethodName());
+    auto params = List::g();
+    params->append("not torrent");
+    dict->put("params", std::move(params));
+    reqparams->append(std::move(dict));
+  }
+  req.params->append(std::move(reqparams));
+  auto res = m.execute(std::move(req), e_.get());
+  CPPUNIT_ASSERT_EQUAL(0, res.code);
+  const List* resParams = downcast<List>(res.param);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, resParams->size());
+  auto& rgman = e_->getRequestGroupMan();
+  for (int i = 0; i < 2; ++i) {
+    auto group = getReservedGroup(rgman.get(), i);
+    CPPUNIT_ASSERT_EQUAL(
+        GroupId::toHex(group->getGID()),
+        downcast<String>(downcast<List>(resParams->get(i))->get(0))->s());
+    CPPUNIT_ASSERT_EQUAL(std::string("http://localhost/") + util::itos(i),
+                         group->getDownloadContext()
+                             ->getFirstFileEntry()
+                             ->getRemainingUris()[0]);
+  }
+  CPPUNIT_ASSERT_EQUAL(dir + "/aria2-0.8.2.tar.bz2",
+                       getReservedGroup(rgman.get(), 1)->getFirstFilePath());
+  auto saved = dir + "/0a3893293e27ac0490424c06de4d09242215f0a6.torrent";
+  CPPUNIT_ASSERT(File(saved).exists());
+  CPPUNIT_ASSERT_EQUAL(
+      saved,
+      getReservedGroup(rgman.get(), 1)->getOption()->get(PREF_TORRENT_FILE));
+  CPPUNIT_ASSERT(downcast<Dict>(resParams->get(2)));
+}
+#endif // ENABLE_BITTORRENT
+
 void RpcMethodTest::testSystemMulticall_fail()
 {
   SystemMulticallRpcMethod m;
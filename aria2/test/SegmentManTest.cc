@@ -10,6 +10,8 @@
 #include "PieceSelector.h"
 #include "FileEntry.h"
 #include "PeerStat.h"
+#include "prefs.h"
+#include "wallclock.h"
 
 namespace aria2 {
 
@@ -23,6 +25,7 @@ class SegmentManTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testCancelAllSegments);
   CPPUNIT_TEST(testGetPeerStat);
   CPPUNIT_TEST(testGetCleanSegmentIfOwnerIsIdle);
+  CPPUNIT_TEST(testGetSegment_deadline);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -49,6 +52,7 @@ public:
   void testCancelAllSegments();
   void testGetPeerStat();
   void testGetCleanSegmentIfOwnerIsIdle();
+  void testGetSegment_deadline();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(SegmentManTest);
@@ -195,4 +199,48 @@ void SegmentManTest::testGetCleanSegmentIfOwnerIsIdle()
   CPPUNIT_ASSERT(!segmentMan_->getCleanSegmentIfOwnerIsIdle(5, 1));
 }
 
+void SegmentManTest::testGetSegment_deadline()
+{
+  ManualTimeSource source;
+  auto prev = setTimeSource(&source);
+  global::wallclock().reset();
+  option_->put(PREF_STREAM_PIECE_SELECTOR, A2_V_DEADLINE);
+  auto ps = std::make_shared<DefaultPieceStorage>(dctx_, option_.get());
+  SegmentMan segmentMan(dctx_, ps);
+  auto slow = std::make_shared<PeerStat>(1);
+  auto fast = std::make_shared<PeerStat>(2);
+  slow->downloadStart();
+  fast->downloadStart();
+  segmentMan.registerPeerStat(slow);
+  segmentMan.registerPeerStat(fast);
+  dctx_->getPlaybackCursor().update(0, 100_k);
+  auto seg = segmentMan.getSegment(1, 1_m);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, seg->getIndex());
+  for (int i = 0; i < 3; ++i) {
+    source.advance(1_s);
+    global::wallclock().reset();
+    slow->updateDownload(10_k);
+    fast->updateDownload(1_m);
+    seg->updateWrittenLength(10_k);
+  }
+  // The player has passed the position to write of segment#0, and the
+  // faster one takes it over.
+  seg = segmentMan.getSegment(2, 1_m);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, seg->getIndex());
+  std::vector<std::shared_ptr<Segment>> segments;
+  segmentMan.getInFlightSegment(segments, 1);
+  CPPUNIT_ASSERT(segments.empty());
+  // The slow one cannot complete the pieces from 1 to 6 before the
+  // player reaches them.
+  seg = segmentMan.getSegment(1, 1_m);
+  CPPUNIT_ASSERT_EQUAL((size_t)7, seg->getIndex());
+  // Without the player, the pieces are selected in order.
+  dctx_->getPlaybackCursor().update(0, 0);
+  seg = segmentMan.getSegment(1, 1_m);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, seg->getIndex());
+
+  setTimeSource(prev);
+  global::wallclock().reset();
+}
+
 } // namespace aria2
@@ -0,0 +1,112 @@
+#include "Bench.h"
+
+#include <vector>
+#include <thread>
+#include <cstdio>
+
+#include "ServerStatMan.h"
+#include "ServerStat.h"
+#include "File.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+namespace {
+const size_t NUM_HOSTS = 50000;
+
+std::vector<std::string> makeHosts()
+{
+  std::vector<std::string> hosts;
+  for (size_t i = 0; i < NUM_HOSTS; ++i) {
+    hosts.push_back(
+        fmt("mirror%lu.example.org", static_cast<unsigned long>(i)));
+  }
+  return hosts;
+}
+
+void populate(ServerStatMan& ssm, const std::vector<std::string>& hosts)
+{
+  auto now = Time().getTimeFromEpoch();
+  for (size_t i = 0; i < hosts.size(); ++i) {
+    auto ss = ssm.getOrCreate(hosts[i], "http");
+    ss->setDownloadSpeed((i * 7919) % 1000000);
+    ss->setSingleConnectionAvgSpeed((i * 104729) % 1000000);
+    ss->setCounter(i % 10);
+    ss->setLastUpdated(Time(now - static_cast<time_t>(i % 86400)));
+  }
+}
+
+// Picks the fastest of 10 candidate hosts, which is what
+// FeedbackURISelector does for each URI selection.
+size_t select(const ServerStatMan& ssm, const std::vector<std::string>& hosts,
+              size_t n, uint64_t seed)
+{
+  size_t picked = 0;
+  auto now = Time();
+  for (size_t i = 0; i < n; ++i) {
+    int max = -1;
+    for (int j = 0; j < 10; ++j) {
+      seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+      auto ss = ssm.find(hosts[(seed >> 33) % hosts.size()], "http");
+      if (ss && ss->isOK()) {
+        max = std::max(max, ss->getDecayedDownloadSpeed(now));
+      }
+    }
+    picked += max > 0;
+  }
+  return picked;
+}
+} // namespace
+
+A2_BENCHMARK(ServerStatSelect)
+{
+  auto hosts = makeHosts();
+  ServerStatMan ssm;
+  populate(ssm, hosts);
+  auto n = bench::scale(200000);
+  const size_t threads[] = {1, 4};
+  for (auto nthreads : threads) {
+    std::vector<std::thread> workers;
+    std::vector<size_t> picked(nthreads);
+    auto start = bench::now();
+    for (size_t i = 0; i < nthreads; ++i) {
+      workers.emplace_back([&, i] { picked[i] = select(ssm, hosts, n, i); });
+    }
+    for (auto& t : workers) {
+      t.join();
+    }
+    auto elapsed = bench::now() - start;
+    bench::report(fmt("select threads=%lu",
+                      static_cast<unsigned long>(nthreads)),
+                  n * nthreads / elapsed, "selections/s");
+    if (picked[0] == 0) {
+      bench::report("sink", 0, "");
+    }
+  }
+}
+
+A2_BENCHMARK(ServerStatSaveLoad)
+{
+  auto hosts = makeHosts();
+  ServerStatMan ssm;
+  populate(ssm, hosts);
+  std::string filename = "/tmp/aria2_ServerStatManBench";
+  const std::pair<ServerStatMan::Format, const char*> formats[] = {
+      {ServerStatMan::TEXT, "text"}, {ServerStatMan::BINARY, "binary"}};
+  for (auto& f : formats) {
+    auto start = bench::now();
+    ssm.save(filename, f.first);
+    auto saveTime = bench::now() - start;
+    ServerStatMan loaded;
+    start = bench::now();
+    loaded.load(filename);
+    auto loadTime = bench::now() - start;
+    bench::report(fmt("save %s", f.second), saveTime * 1e3, "ms");
+    bench::report(fmt("load %s", f.second), loadTime * 1e3, "ms");
+    bench::report(fmt("size %s", f.second), File(filename).size() / 1024.0,
+                  "KiB");
+  }
+  File(filename).remove();
+}
+
+} // namespace aria2
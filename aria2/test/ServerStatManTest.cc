@@ -8,6 +8,7 @@
 #include "Exception.h"
 #include "util.h"
 #include "BufferedFile.h"
+#include "fmt.h"
 #include "TestUtil.h"
 
 namespace aria2 {
@@ -19,6 +20,8 @@ class ServerStatManTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testSave);
   CPPUNIT_TEST(testLoad);
   CPPUNIT_TEST(testRemoveStaleServerStat);
+  CPPUNIT_TEST(testGetOrCreate);
+  CPPUNIT_TEST(testSaveAndLoadBinary);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -30,6 +33,8 @@ public:
   void testSave();
   void testLoad();
   void testRemoveStaleServerStat();
+  void testGetOrCreate();
+  void testSaveAndLoadBinary();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(ServerStatManTest);
@@ -170,4 +175,72 @@ void ServerStatManTest::testRemoveStaleServerStat()
   CPPUNIT_ASSERT(!ssm.find("mirror", "http"));
 }
 
+void ServerStatManTest::testGetOrCreate()
+{
+  ServerStatMan ssm;
+  auto localhost_http = ssm.getOrCreate("localhost", "http");
+  CPPUNIT_ASSERT_EQUAL(std::string("localhost"), localhost_http->getHostname());
+  CPPUNIT_ASSERT_EQUAL(std::string("http"), localhost_http->getProtocol());
+  CPPUNIT_ASSERT(localhost_http == ssm.getOrCreate("localhost", "http"));
+  CPPUNIT_ASSERT(localhost_http == ssm.find("localhost", "http"));
+  auto localhost_ftp = ssm.getOrCreate("localhost", "ftp");
+  CPPUNIT_ASSERT(localhost_http != localhost_ftp);
+  CPPUNIT_ASSERT(!ssm.add(std::make_shared<ServerStat>("localhost", "ftp")));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, ssm.size());
+}
+
+void ServerStatManTest::testSaveAndLoadBinary()
+{
+  ServerStatMan ssm;
+  for (int i = 0; i < 100; ++i) {
+    auto ss = std::make_shared<ServerStat>(fmt("host%d", i), "http");
+    ss->setDownloadSpeed(i * 1000);
+    ss->setSingleConnectionAvgSpeed(i * 100);
+    ss->setMultiConnectionAvgSpeed(i * 101);
+    ss->setCounter(i);
+    ss->setLastUpdated(Time(1210000000 + i));
+    if (i % 3 == 0) {
+      ss->setStatus(ServerStat::A2_ERROR);
+    }
+    CPPUNIT_ASSERT(ssm.add(ss));
+  }
+  CPPUNIT_ASSERT(ssm.add(std::make_shared<ServerStat>("host1", "ftp")));
+  // Names too long for the binary format are left out.
+  CPPUNIT_ASSERT(ssm.add(
+      std::make_shared<ServerStat>(std::string(UINT16_MAX + 1, 'a'), "http")));
+  CPPUNIT_ASSERT(ssm.add(
+      std::make_shared<ServerStat>("host1", std::string(UINT8_MAX + 1, 'p'))));
+
+  const char* filename =
+      A2_TEST_OUT_DIR "/aria2_ServerStatManTest_testSaveAndLoadBinary";
+  CPPUNIT_ASSERT(ssm.save(filename, ServerStatMan::BINARY));
+  CPPUNIT_ASSERT_EQUAL(std::string("\xa1\xa2\x05"),
+                       readFile(filename).substr(0, 3));
+
+  ServerStatMan loaded;
+  CPPUNIT_ASSERT(loaded.load(filename));
+  CPPUNIT_ASSERT_EQUAL((size_t)101, loaded.size());
+  for (int i = 0; i < 100; ++i) {
+    auto ss = loaded.find(fmt("host%d", i), "http");
+    CPPUNIT_ASSERT(ss);
+    CPPUNIT_ASSERT_EQUAL(i * 1000, ss->getDownloadSpeed());
+    CPPUNIT_ASSERT_EQUAL(i * 100, ss->getSingleConnectionAvgSpeed());
+    CPPUNIT_ASSERT_EQUAL(i * 101, ss->getMultiConnectionAvgSpeed());
+    CPPUNIT_ASSERT_EQUAL(i, ss->getCounter());
+    CPPUNIT_ASSERT_EQUAL(static_cast<time_t>(1210000000 + i),
+                         ss->getLastUpdated().getTimeFromEpoch());
+    CPPUNIT_ASSERT_EQUAL(i % 3 == 0 ? ServerStat::A2_ERROR : ServerStat::OK,
+                         ss->getStatus());
+  }
+  CPPUNIT_ASSERT(loaded.find("host1", "ftp"));
+
+  // Text format is still saved and loaded as before.
+  CPPUNIT_ASSERT(loaded.save(filename));
+  ServerStatMan text;
+  CPPUNIT_ASSERT(text.load(filename));
+  CPPUNIT_ASSERT_EQUAL((size_t)101, text.size());
+  CPPUNIT_ASSERT_EQUAL(ServerStat::A2_ERROR,
+                       text.find("host99", "http")->getStatus());
+}
+
 } // namespace aria2
@@ -15,6 +15,7 @@ class ServerStatTest : public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(ServerStatTest);
   CPPUNIT_TEST(testSetStatus);
   CPPUNIT_TEST(testToString);
+  CPPUNIT_TEST(testGetDecayedDownloadSpeed);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -24,6 +25,7 @@ public:
 
   void testSetStatus();
   void testToString();
+  void testGetDecayedDownloadSpeed();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(ServerStatTest);
@@ -71,4 +73,20 @@ void ServerStatTest::testToString()
       localhost_ftp.toString());
 }
 
+void ServerStatTest::testGetDecayedDownloadSpeed()
+{
+  ServerStat ss("localhost", "http");
+  ss.setDownloadSpeed(80000);
+  ss.setLastUpdated(Time(1000000));
+  CPPUNIT_ASSERT_EQUAL(80000, ss.getDecayedDownloadSpeed(Time(1000000)));
+  // Clock went backwards
+  CPPUNIT_ASSERT_EQUAL(80000, ss.getDecayedDownloadSpeed(Time(999000)));
+  auto halfLife = std::chrono::seconds(ServerStat::SPEED_HALF_LIFE).count();
+  CPPUNIT_ASSERT_EQUAL(40000,
+                       ss.getDecayedDownloadSpeed(Time(1000000 + halfLife)));
+  CPPUNIT_ASSERT_EQUAL(
+      20000, ss.getDecayedDownloadSpeed(Time(1000000 + halfLife * 2)));
+  CPPUNIT_ASSERT_EQUAL(80000, ss.getDownloadSpeed());
+}
+
 } // namespace aria2
@@ -0,0 +1,1322 @@
+#include "Simulation.h"
+
+#include <algorithm>
+#include <cassert>
+#include <ctime>
+#include <deque>
+#include <limits>
+
+#include "DownloadEngine.h"
+#include "RequestGroupMan.h"
+#include "DownloadContext.h"
+#include "DefaultPieceStorage.h"
+#include "SegmentMan.h"
+#include "Segment.h"
+#include "Piece.h"
+#include "Peer.h"
+#include "PeerStat.h"
+#include "PeerStorage.h"
+#include "BtLeecherStateChoke.h"
+#include "BtConstants.h"
+#include "Command.h"
+#include "Option.h"
+#include "prefs.h"
+#include "SimpleRandomizer.h"
+#include "wallclock.h"
+#include "fmt.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+SimNetwork::SimNetwork(uint32_t seed)
+    : prevTimeSource_(setTimeSource(&clock_)),
+      seq_(0),
+      numEvents_(0),
+      readableNotice_(false),
+      random_(seed)
+{
+  SimpleRandomizer::getInstance()->seed(seed);
+  global::wallclock().reset();
+}
+
+SimNetwork::~SimNetwork()
+{
+  SimpleRandomizer::getInstance()->useSystemEntropy();
+  setTimeSource(prevTimeSource_);
+  global::wallclock().reset();
+}
+
+void SimNetwork::schedule(Clock::duration delay, std::function<void()> f)
+{
+  events_.push(Event{now() + delay, seq_++, std::move(f)});
+}
+
+bool SimNetwork::runNext(Clock::time_point deadline)
+{
+  if (events_.empty() || events_.top().time > deadline) {
+    if (now() < deadline) {
+      clock_.advance(deadline - now());
+    }
+    return false;
+  }
+  // The event is copied out, because it may schedule new events.
+  auto f = std::move(const_cast<Event&>(events_.top()).f);
+  auto time = events_.top().time;
+  events_.pop();
+  if (now() < time) {
+    clock_.advance(time - now());
+  }
+  ++numEvents_;
+  f();
+  return true;
+}
+
+sock_t SimNetwork::createSocket()
+{
+  readable_.push_back(false);
+  return readable_.size() - 1;
+}
+
+void SimNetwork::setReadable(sock_t fd, bool f)
+{
+  if (readable_[fd] == f) {
+    return;
+  }
+  readable_[fd] = f;
+  if (f) {
+    readableSet_.insert(fd);
+    readableNotice_ = true;
+  }
+  else {
+    readableSet_.erase(fd);
+  }
+}
+
+bool SimNetwork::takeReadableNotice()
+{
+  auto res = readableNotice_;
+  readableNotice_ = false;
+  return res;
+}
+
+SimEventPoll::SimEventPoll(SimNetwork* network)
+    : network_(network), numWriteEvents_(0)
+{
+}
+
+void SimEventPoll::poll(const struct timeval& tv)
+{
+  auto deadline = network_->now() + std::chrono::seconds(tv.tv_sec) +
+                  std::chrono::microseconds(tv.tv_usec);
+  while (!processEvents()) {
+    do {
+      if (!network_->runNext(deadline)) {
+        return;
+      }
+    } while (!network_->takeReadableNotice());
+  }
+}
+
+namespace {
+bool notify(std::vector<std::pair<Command*, int>>& ces, bool readable)
+{
+  bool notified = false;
+  for (auto& ce : ces) {
+    bool read = readable && (ce.second & EventPoll::EVENT_READ);
+    bool write = ce.second & EventPoll::EVENT_WRITE;
+    if (!read && !write) {
+      continue;
+    }
+    ce.first->setStatusActive();
+    if (read) {
+      ce.first->readEventReceived();
+    }
+    if (write) {
+      ce.first->writeEventReceived();
+    }
+    notified = true;
+  }
+  return notified;
+}
+} // namespace
+
+bool SimEventPoll::processEvents()
+{
+  bool notified = false;
+  if (numWriteEvents_ > 0) {
+    for (auto& entry : entries_) {
+      notified |= notify(entry.second, network_->isReadable(entry.first));
+    }
+    return notified;
+  }
+  for (auto fd : network_->getReadableSockets()) {
+    auto i = entries_.find(fd);
+    if (i != entries_.end()) {
+      notified |= notify((*i).second, true);
+    }
+  }
+  return notified;
+}
+
+bool SimEventPoll::addEvents(sock_t socket, Command* command,
+                             EventType events)
+{
+  auto& ces = entries_[socket];
+  for (auto& ce : ces) {
+    if (ce.first == command) {
+      if ((events & EVENT_WRITE) && !(ce.second & EVENT_WRITE)) {
+        ++numWriteEvents_;
+      }
+      ce.second |= events;
+      return true;
+    }
+  }
+  if (events & EVENT_WRITE) {
+    ++numWriteEvents_;
+  }
+  ces.emplace_back(command, events);
+  return true;
+}
+
+bool SimEventPoll::deleteEvents(sock_t socket, Command* command,
+                                EventType events)
+{
+  auto i = entries_.find(socket);
+  if (i == entries_.end()) {
+    return false;
+  }
+  auto& ces = (*i).second;
+  for (auto j = ces.begin(); j != ces.end(); ++j) {
+    if ((*j).first == command) {
+      if ((events & EVENT_WRITE) && ((*j).second & EVENT_WRITE)) {
+        --numWriteEvents_;
+      }
+      (*j).second &= ~events;
+      if ((*j).second == 0) {
+        ces.erase(j);
+      }
+      if (ces.empty()) {
+        entries_.erase(i);
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+#ifdef ENABLE_ASYNC_DNS
+bool SimEventPoll::addNameResolver(
+    const std::shared_ptr<AsyncNameResolver>& resolver, Command* command)
+{
+  return false;
+}
+
+bool SimEventPoll::deleteNameResolver(
+    const std::shared_ptr<AsyncNameResolver>& resolver, Command* command)
+{
+  return false;
+}
+#endif // ENABLE_ASYNC_DNS
+
+namespace {
+const int64_t CHUNK_LENGTH = 16_k;
+} // namespace
+
+namespace {
+SimNetwork::Clock::duration transferTime(int64_t length, int64_t bandwidth)
+{
+  return std::chrono::duration_cast<SimNetwork::Clock::duration>(
+      std::chrono::duration<double>(static_cast<double>(length) / bandwidth));
+}
+} // namespace
+
+SimHost::SimHost(SimNetwork* network, const SimLinkConfig& config)
+    : network_(network), config_(config), next_(0), busy_(false), bytesSent_(0)
+{
+}
+
+std::shared_ptr<SimConnection> SimHost::connect()
+{
+  auto conn = std::make_shared<SimConnection>(this, network_->createSocket());
+  conns_.push_back(conn);
+  return conn;
+}
+
+void SimHost::pump()
+{
+  if (busy_) {
+    return;
+  }
+  conns_.erase(std::remove_if(std::begin(conns_), std::end(conns_),
+                              std::mem_fn(&SimConnection::isClosed)),
+               std::end(conns_));
+  for (size_t i = 0; i < conns_.size(); ++i) {
+    auto idx = (next_ + i) % conns_.size();
+    auto conn = conns_[idx];
+    if (!conn->sendable()) {
+      continue;
+    }
+    auto length = conn->takeChunk(CHUNK_LENGTH);
+    bytesSent_ += length;
+    busy_ = true;
+    next_ = idx + 1;
+    network_->schedule(transferTime(length, config_.bandwidth),
+                       [this, conn, length]() {
+                         busy_ = false;
+                         conn->transmitted(length);
+                         pump();
+                       });
+    return;
+  }
+}
+
+const int64_t SimConnection::WINDOW;
+
+SimConnection::SimConnection(SimHost* host, sock_t fd)
+    : host_(host),
+      fd_(fd),
+      established_(false),
+      closed_(false),
+      epoch_(0),
+      pending_(0),
+      inFlight_(0),
+      buffered_(0),
+      lastArrival_(host->getNetwork()->now())
+{
+}
+
+void SimConnection::request(int64_t length)
+{
+  auto delay = host_->getConfig().latency;
+  if (!established_) {
+    established_ = true;
+    delay *= 3;
+  }
+  auto self = shared_from_this();
+  auto epoch = epoch_;
+  host_->getNetwork()->schedule(delay, [self, length, epoch]() {
+    if (self->closed_ || self->epoch_ != epoch) {
+      return;
+    }
+    self->pending_ += length;
+    self->host_->pump();
+  });
+}
+
+void SimConnection::cancel()
+{
+  pending_ = 0;
+  ++epoch_;
+}
+
+int64_t SimConnection::read(int64_t max)
+{
+  auto n = std::min(max, buffered_);
+  buffered_ -= n;
+  if (buffered_ == 0) {
+    host_->getNetwork()->setReadable(fd_, false);
+  }
+  if (n > 0) {
+    // The window update reaches the host after the latency.
+    auto host = host_;
+    host_->getNetwork()->schedule(host_->getConfig().latency,
+                                  [host]() { host->pump(); });
+  }
+  return n;
+}
+
+void SimConnection::notify()
+{
+  if (!closed_) {
+    host_->getNetwork()->setReadable(fd_, true);
+  }
+}
+
+void SimConnection::close()
+{
+  closed_ = true;
+  pending_ = 0;
+  buffered_ = 0;
+  host_->getNetwork()->setReadable(fd_, false);
+}
+
+bool SimConnection::sendable() const
+{
+  return !closed_ && pending_ > 0 && inFlight_ + buffered_ < WINDOW;
+}
+
+int64_t SimConnection::takeChunk(int64_t max)
+{
+  auto n = std::min(std::min(max, pending_), WINDOW - inFlight_ - buffered_);
+  pending_ -= n;
+  inFlight_ += n;
+  return n;
+}
+
+void SimConnection::transmitted(int64_t length)
+{
+  auto network = host_->getNetwork();
+  auto& config = host_->getConfig();
+  auto arrival = network->now() + config.latency;
+  if (std::bernoulli_distribution(config.loss)(network->getRandom())) {
+    arrival += std::max(std::chrono::milliseconds(200), config.latency * 2);
+  }
+  arrival = std::max(arrival, lastArrival_);
+  lastArrival_ = arrival;
+  auto self = shared_from_this();
+  network->schedule(arrival - network->now(), [self, length]() {
+    self->inFlight_ -= length;
+    if (self->closed_) {
+      return;
+    }
+    self->buffered_ += length;
+    self->host_->getNetwork()->setReadable(self->fd_, true);
+  });
+}
+
+SimDisk::SimDisk(SimNetwork* network, int64_t bandwidth,
+                 std::chrono::microseconds latency)
+    : network_(network),
+      bandwidth_(bandwidth),
+      latency_(latency),
+      busyUntil_(network->now())
+{
+}
+
+SimNetwork::Clock::time_point SimDisk::write(int64_t length)
+{
+  busyUntil_ = std::max(busyUntil_, network_->now()) + latency_ +
+               transferTime(length, bandwidth_);
+  return busyUntil_;
+}
+
+double SimResult::throughput() const
+{
+  return elapsed > 0 ? bytesReceived / elapsed : 0;
+}
+
+double SimResult::cpuPerByte() const
+{
+  return bytesReceived > 0 ? cpuTime * 1e9 / bytesReceived : 0;
+}
+
+double jainIndex(const std::vector<double>& values)
+{
+  double sum = 0, sumsq = 0;
+  for (auto v : values) {
+    sum += v;
+    sumsq += v * v;
+  }
+  if (sumsq == 0) {
+    return 1.0;
+  }
+  return sum * sum / (values.size() * sumsq);
+}
+
+namespace {
+// State of a simulated download shared by its commands.
+struct SimDownload {
+  SimNetwork* network;
+  std::shared_ptr<DownloadContext> downloadContext;
+  std::shared_ptr<DefaultPieceStorage> pieceStorage;
+  bool stop;
+  bool finished;
+  SimNetwork::Clock::time_point finishTime;
+  uint64_t requests;
+  int64_t bytesReceived;
+
+  SimDownload(SimNetwork* network, int32_t pieceLength, int64_t totalLength,
+              const Option* option)
+      : network(network),
+        downloadContext(
+            std::make_shared<DownloadContext>(pieceLength, totalLength)),
+        pieceStorage(
+            std::make_shared<DefaultPieceStorage>(downloadContext, option)),
+        stop(false),
+        finished(false),
+        requests(0),
+        bytesReceived(0)
+  {
+  }
+
+  bool done() const { return stop || finished; }
+
+  void checkFinished(DownloadEngine* e)
+  {
+    if (!finished && pieceStorage->downloadFinished()) {
+      finished = true;
+      finishTime = network->now();
+      // Let the other commands notice without 1 second delay, as
+      // DownloadCommand does.
+      e->setNoWait(true);
+      e->setRefreshInterval(std::chrono::milliseconds(0));
+    }
+  }
+};
+} // namespace
+
+namespace {
+// Runs |e| until all commands exit, stopping the download at
+// |timeLimit| of simulated time, and fills the common fields of the
+// result.
+void runEngine(DownloadEngine* e, SimDownload& dl,
+               std::chrono::seconds timeLimit, SimResult& result)
+{
+  auto start = dl.network->now();
+  auto eventsStart = dl.network->getNumEvents();
+  auto cpuStart = std::clock();
+  result.iterations = 0;
+  do {
+    ++result.iterations;
+    if (!dl.done() && dl.network->now() - start >= timeLimit) {
+      dl.stop = true;
+      e->setNoWait(true);
+      e->setRefreshInterval(std::chrono::milliseconds(0));
+    }
+  } while (e->run(true) == 1);
+  result.cpuTime =
+      static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+  result.events = dl.network->getNumEvents() - eventsStart;
+  result.completed = dl.finished;
+  result.totalLength = dl.downloadContext->getTotalLength();
+  auto end = dl.finished ? dl.finishTime : start + timeLimit;
+  result.elapsed = std::chrono::duration<double>(end - start).count();
+  result.bytesReceived = dl.bytesReceived;
+  result.requests = dl.requests;
+  result.stalls = 0;
+  result.stallTime = 0;
+}
+} // namespace
+
+namespace {
+// Fills the per host fields of |result|.
+void setHostStats(const std::vector<SimHost*>& hosts, SimResult& result)
+{
+  std::vector<double> shares;
+  for (auto host : hosts) {
+    result.hostBytes.push_back(host->getBytesSent());
+    shares.push_back(static_cast<double>(host->getBytesSent()) /
+                     host->getConfig().bandwidth);
+  }
+  result.fairness = jainIndex(shares);
+}
+} // namespace
+
+namespace {
+std::unique_ptr<DownloadEngine> createEngine(SimNetwork* network,
+                                             Option* option)
+{
+  auto e = make_unique<DownloadEngine>(make_unique<SimEventPoll>(network));
+  e->setOption(option);
+  e->setRequestGroupMan(make_unique<RequestGroupMan>(
+      std::vector<std::shared_ptr<RequestGroup>>{}, 1, option));
+  return e;
+}
+} // namespace
+
+namespace {
+// Base of the simulated commands.  It waits for one virtual
+// descriptor at a time.
+class SimCommand : public Command {
+public:
+  SimCommand(cuid_t cuid, DownloadEngine* e) : Command(cuid), e_(e), fd_(-1)
+  {
+  }
+
+  virtual ~SimCommand() { waitFor(-1); }
+
+protected:
+  // Switches the descriptor to wait for to |fd|, or none if |fd| is
+  // -1.
+  void waitFor(sock_t fd)
+  {
+    if (fd == fd_) {
+      return;
+    }
+    if (fd_ != -1) {
+      e_->deleteSocketForReadCheck(fd_, this);
+    }
+    fd_ = fd;
+    if (fd_ != -1) {
+      e_->addSocketForReadCheck(fd_, this);
+    }
+  }
+
+  bool wait()
+  {
+    e_->addCommand(std::unique_ptr<Command>(this));
+    return false;
+  }
+
+  DownloadEngine* e_;
+
+private:
+  sock_t fd_;
+};
+} // namespace
+
+namespace {
+// A connection to an HTTP mirror.  It requests the rest of the file
+// from the start of its segment and streams into the following
+// segments while nobody else owns them, as DownloadCommand does.
+class SimSegmentCommand : public SimCommand {
+public:
+  SimSegmentCommand(cuid_t cuid, DownloadEngine* e, SimDownload* dl,
+                    SegmentMan* segmentMan, SimHost* host, SimDisk* disk,
+                    size_t minSplitSize, int64_t readAhead,
+                    const std::string& hostname)
+      : SimCommand(cuid, e),
+        dl_(dl),
+        segmentMan_(segmentMan),
+        host_(host),
+        disk_(disk),
+        minSplitSize_(minSplitSize),
+        readAhead_(readAhead),
+        readOffset_(0),
+        requestEnd_(0),
+        peerStat_(std::make_shared<PeerStat>(cuid, hostname, "http")),
+        diskFd_(dl->network->createSocket()),
+        diskBusy_(false)
+  {
+    segmentMan_->registerPeerStat(peerStat_);
+  }
+
+  virtual ~SimSegmentCommand()
+  {
+    if (conn_) {
+      conn_->close();
+    }
+    if (segment_) {
+      segmentMan_->cancelSegment(getCuid());
+    }
+    peerStat_->downloadStop();
+  }
+
+  virtual bool execute() CXX11_OVERRIDE
+  {
+    if (dl_->done()) {
+      return true;
+    }
+    if (diskBusy_) {
+      // Wait for the write to complete before reading more, so that
+      // a slow disk throttles the sender.
+      if (dl_->network->isReadable(diskFd_)) {
+        dl_->network->setReadable(diskFd_, false);
+        diskBusy_ = false;
+      }
+      else {
+        return wait();
+      }
+    }
+    if (segment_ && segmentTakenOver()) {
+      // The segment was canceled and given to a faster connection.
+      // Start over, as AbstractCommand does.
+      conn_->close();
+      conn_.reset();
+      segment_.reset();
+      peerStat_->downloadStop();
+    }
+    if (!segment_) {
+      segment_ = segmentMan_->getSegment(getCuid(), minSplitSize_);
+      if (!segment_) {
+        return true;
+      }
+      if (!conn_) {
+        conn_ = host_->connect();
+      }
+      readOffset_ = segment_->getPositionToWrite();
+      requestEnd_ = dl_->downloadContext->getTotalLength();
+      if (readAhead_ > 0) {
+        requestEnd_ = std::min(requestEnd_, readOffset_ + readAhead_);
+      }
+      conn_->request(requestEnd_ - readOffset_);
+      ++dl_->requests;
+      peerStat_->downloadStart();
+    }
+    auto n = conn_->read(std::numeric_limits<int64_t>::max());
+    if (n > 0) {
+      dl_->bytesReceived += n;
+      peerStat_->updateDownload(n);
+      readOffset_ += n;
+      consume(n);
+      if (conn_ && readAhead_ > 0) {
+        auto end = std::min(dl_->downloadContext->getTotalLength(),
+                            readOffset_ + readAhead_);
+        if (end > requestEnd_) {
+          conn_->request(end - requestEnd_);
+          requestEnd_ = end;
+        }
+      }
+      dl_->checkFinished(e_);
+      if (dl_->finished) {
+        return true;
+      }
+      if (disk_) {
+        auto fd = diskFd_;
+        auto network = dl_->network;
+        network->schedule(disk_->write(n) - network->now(),
+                          [network, fd]() { network->setReadable(fd, true); });
+        diskBusy_ = true;
+        waitFor(diskFd_);
+        return wait();
+      }
+    }
+    if (!segment_) {
+      return execute();
+    }
+    waitFor(conn_->getSockfd());
+    return wait();
+  }
+
+private:
+  bool segmentTakenOver()
+  {
+    std::vector<std::shared_ptr<Segment>> segments;
+    segmentMan_->getInFlightSegment(segments, getCuid());
+    return std::find(std::begin(segments), std::end(segments), segment_) ==
+           std::end(segments);
+  }
+
+  // Writes |n| received bytes to the segments.  If the next segment is
+  // owned by another connection, the rest of the response is
+  // discarded and the connection is closed.
+  void consume(int64_t n)
+  {
+    while (n > 0 && segment_) {
+      auto len = std::min(n, segment_->getLength() -
+                                 segment_->getWrittenLength());
+      segment_->updateWrittenLength(len);
+      n -= len;
+      if (!segment_->complete()) {
+        continue;
+      }
+      auto nextIndex = segment_->getIndex() + 1;
+      segmentMan_->completeSegment(getCuid(), segment_);
+      segment_.reset();
+      if (nextIndex >= dl_->downloadContext->getNumPieces()) {
+        break;
+      }
+      auto next = segmentMan_->getSegmentWithIndex(getCuid(), nextIndex);
+      if (!next) {
+        next = segmentMan_->getCleanSegmentIfOwnerIsIdle(getCuid(), nextIndex);
+      }
+      if (next && next->getWrittenLength() == 0) {
+        segment_ = next;
+      }
+      else {
+        if (next) {
+          segmentMan_->cancelSegment(getCuid(), next);
+        }
+        break;
+      }
+    }
+    if (!segment_) {
+      conn_->close();
+      conn_.reset();
+      peerStat_->downloadStop();
+    }
+  }
+
+  SimDownload* dl_;
+  SegmentMan* segmentMan_;
+  SimHost* host_;
+  SimDisk* disk_;
+  size_t minSplitSize_;
+  int64_t readAhead_;
+  // Offset of the next byte to read, and the end of the bytes
+  // requested on conn_
+  int64_t readOffset_;
+  int64_t requestEnd_;
+  std::shared_ptr<PeerStat> peerStat_;
+  std::shared_ptr<SimConnection> conn_;
+  std::shared_ptr<Segment> segment_;
+  // Becomes readable when the last disk write completes.
+  sock_t diskFd_;
+  bool diskBusy_;
+};
+} // namespace
+
+namespace {
+struct SimPlayback {
+  uint64_t stalls;
+  SimNetwork::Clock::duration stallTime;
+};
+} // namespace
+
+namespace {
+// A player which plays the file from the start while it is being
+// downloaded.  It wakes up every TICK and plays the completed pieces
+// at its bitrate.  The stalls are counted in |playback|.
+class SimPlayerCommand : public SimCommand {
+public:
+  SimPlayerCommand(cuid_t cuid, DownloadEngine* e, SimDownload* dl,
+                   int64_t bitrate, std::chrono::seconds delay,
+                   bool reportPosition, SimPlayback* playback)
+      : SimCommand(cuid, e),
+        dl_(dl),
+        bitrate_(bitrate),
+        reportPosition_(reportPosition),
+        playback_(playback),
+        timerFd_(dl->network->createSocket()),
+        ticks_(0),
+        position_(0),
+        availableIndex_(0),
+        stalled_(false)
+  {
+    schedule(delay);
+  }
+
+  virtual bool execute() CXX11_OVERRIDE
+  {
+    if (!dl_->network->isReadable(timerFd_)) {
+      return wait();
+    }
+    dl_->network->setReadable(timerFd_, false);
+    auto totalLength = dl_->downloadContext->getTotalLength();
+    int64_t pieceLength = dl_->downloadContext->getPieceLength();
+    auto numPieces = dl_->downloadContext->getNumPieces();
+    while (availableIndex_ < numPieces &&
+           dl_->pieceStorage->hasPiece(availableIndex_)) {
+      ++availableIndex_;
+    }
+    auto available = std::min(
+        totalLength, static_cast<int64_t>(availableIndex_) * pieceLength);
+    auto want = std::min(totalLength,
+                         position_ + bitrate_ * TICK.count() / 1000);
+    if (want <= available) {
+      position_ = want;
+      if (stalled_) {
+        stalled_ = false;
+        playback_->stallTime += dl_->network->now() - stallStart_;
+      }
+    }
+    else {
+      position_ = available;
+      if (!stalled_) {
+        stalled_ = true;
+        ++playback_->stalls;
+        stallStart_ = dl_->network->now();
+      }
+    }
+    if (reportPosition_ && ticks_++ % 10 == 0) {
+      dl_->downloadContext->getPlaybackCursor().update(position_, bitrate_);
+    }
+    // Once the download finishes, the player never stalls.
+    if (position_ == totalLength || dl_->done()) {
+      if (stalled_) {
+        playback_->stallTime += dl_->network->now() - stallStart_;
+      }
+      return true;
+    }
+    schedule(TICK);
+    return wait();
+  }
+
+private:
+  static const std::chrono::milliseconds TICK;
+
+  void schedule(SimNetwork::Clock::duration delay)
+  {
+    auto network = dl_->network;
+    auto fd = timerFd_;
+    network->schedule(delay,
+                      [network, fd]() { network->setReadable(fd, true); });
+    waitFor(timerFd_);
+  }
+
+  SimDownload* dl_;
+  int64_t bitrate_;
+  bool reportPosition_;
+  SimPlayback* playback_;
+  sock_t timerFd_;
+  uint64_t ticks_;
+  int64_t position_;
+  // The pieces before this index are completed.
+  size_t availableIndex_;
+  bool stalled_;
+  SimNetwork::Clock::time_point stallStart_;
+};
+
+const std::chrono::milliseconds SimPlayerCommand::TICK(100);
+} // namespace
+
+SimMirrorConfig::SimMirrorConfig()
+    : totalLength(256_m),
+      pieceLength(1_m),
+      split(5),
+      minSplitSize(20_m),
+      readAhead(0),
+      diskBandwidth(0),
+      diskLatency(0),
+      playbackBitrate(0),
+      playbackDelay(0),
+      timeLimit(3600),
+      seed(1)
+{
+}
+
+SimResult runMirrorScenario(const SimMirrorConfig& config)
+{
+  SimNetwork network(config.seed);
+  Option option;
+  if (!config.streamPieceSelector.empty()) {
+    option.put(PREF_STREAM_PIECE_SELECTOR, config.streamPieceSelector);
+  }
+  SimDownload dl(&network, config.pieceLength, config.totalLength, &option);
+  SegmentMan segmentMan(dl.downloadContext, dl.pieceStorage);
+  std::vector<std::unique_ptr<SimHost>> hosts;
+  for (auto& link : config.mirrors) {
+    hosts.push_back(make_unique<SimHost>(&network, link));
+  }
+  std::unique_ptr<SimDisk> disk;
+  if (config.diskBandwidth > 0) {
+    disk = make_unique<SimDisk>(&network, config.diskBandwidth,
+                                config.diskLatency);
+  }
+  auto e = createEngine(&network, &option);
+  for (size_t i = 0; i < config.split; ++i) {
+    auto hostIndex = i % hosts.size();
+    e->addCommand(make_unique<SimSegmentCommand>(
+        e->newCUID(), e.get(), &dl, &segmentMan, hosts[hostIndex].get(),
+        disk.get(), config.minSplitSize, config.readAhead,
+        fmt("mirror%lu", static_cast<unsigned long>(hostIndex))));
+  }
+  SimPlayback playback{0, SimNetwork::Clock::duration::zero()};
+  if (config.playbackBitrate > 0) {
+    e->addCommand(make_unique<SimPlayerCommand>(
+        e->newCUID(), e.get(), &dl, config.playbackBitrate,
+        config.playbackDelay, config.streamPieceSelector == A2_V_DEADLINE,
+        &playback));
+  }
+  SimResult result;
+  runEngine(e.get(), dl, config.timeLimit, result);
+  result.stalls = playback.stalls;
+  result.stallTime =
+      std::chrono::duration<double>(playback.stallTime).count();
+  std::vector<SimHost*> hostPtrs;
+  for (auto& host : hosts) {
+    hostPtrs.push_back(host.get());
+  }
+  setHostStats(hostPtrs, result);
+  return result;
+}
+
+namespace {
+// Probability that a leecher picks us as its optimistic unchoke in a
+// round.
+const double OPTIMISTIC_UNCHOKE_PROBABILITY = 0.25;
+} // namespace
+
+namespace {
+// Remote end of a BitTorrent connection.
+struct SimPeer {
+  std::shared_ptr<Peer> peer;
+  std::unique_ptr<SimHost> host;
+  std::shared_ptr<SimConnection> conn;
+  bool optimistic;
+  // True if the remote end has decided to unchoke us.
+  bool unchoking;
+};
+} // namespace
+
+namespace {
+class SimSwarm {
+public:
+  SimSwarm(SimDownload* dl) : dl_(dl) {}
+
+  SimPeer* addPeer(std::shared_ptr<Peer> peer, const SimLinkConfig& link)
+  {
+    peers_.push_back(make_unique<SimPeer>());
+    auto& p = *peers_.back();
+    p.peer = std::move(peer);
+    p.host = make_unique<SimHost>(dl_->network, link);
+    p.conn = p.host->connect();
+    p.optimistic = false;
+    p.unchoking = false;
+    return &p;
+  }
+
+  // Decides whether |p| unchokes us, and tells us after the latency.
+  void updateChoke(SimPeer* p)
+  {
+    bool unchoke =
+        p->peer->isSeeder() || p->optimistic || !p->peer->amChoking();
+    if (unchoke == p->unchoking) {
+      return;
+    }
+    p->unchoking = unchoke;
+    auto peer = p->peer;
+    auto conn = p->conn;
+    dl_->network->schedule(p->host->getConfig().latency,
+                           [peer, conn, unchoke]() {
+                             peer->peerChoking(!unchoke);
+                             conn->notify();
+                           });
+  }
+
+  // Picks the optimistic unchoke of the leecher |p| every 30 seconds.
+  void scheduleOptimisticUnchoke(SimPeer* p)
+  {
+    auto network = dl_->network;
+    network->schedule(std::chrono::seconds(30), [this, p, network]() {
+      p->optimistic = std::bernoulli_distribution(
+          OPTIMISTIC_UNCHOKE_PROBABILITY)(network->getRandom());
+      updateChoke(p);
+      scheduleOptimisticUnchoke(p);
+    });
+  }
+
+  // Makes the leecher |p| gain a random piece every |interval| on
+  // average, as if it downloaded from the rest of the swarm.
+  void schedulePieceGain(SimPeer* p, std::chrono::seconds interval)
+  {
+    auto network = dl_->network;
+    auto delay = std::chrono::duration_cast<SimNetwork::Clock::duration>(
+        std::chrono::duration<double>(
+            std::uniform_real_distribution<double>(0.5, 1.5)(
+                network->getRandom()) *
+            interval.count()));
+    network->schedule(delay, [this, p, interval, network]() {
+      auto& peer = p->peer;
+      auto numPieces = dl_->downloadContext->getNumPieces();
+      auto start = std::uniform_int_distribution<size_t>(0, numPieces - 1)(
+          network->getRandom());
+      for (size_t i = 0; i < numPieces; ++i) {
+        auto index = (start + i) % numPieces;
+        if (!peer->hasPiece(index)) {
+          peer->updateBitfield(index, 1);
+          dl_->pieceStorage->addPieceStats(index);
+          break;
+        }
+      }
+      p->conn->notify();
+      if (peer->isSeeder()) {
+        peer->peerInterested(false);
+        updateChoke(p);
+      }
+      else {
+        schedulePieceGain(p, interval);
+      }
+    });
+  }
+
+  const std::vector<std::unique_ptr<SimPeer>>& getPeers() const
+  {
+    return peers_;
+  }
+
+private:
+  SimDownload* dl_;
+  std::vector<std::unique_ptr<SimPeer>> peers_;
+};
+} // namespace
+
+namespace {
+// Runs BtLeecherStateChoke every 10 seconds, as PeerChokeCommand
+// does, and lets the remote ends react to the result.
+class SimChokeCommand : public SimCommand {
+public:
+  SimChokeCommand(cuid_t cuid, DownloadEngine* e, SimDownload* dl,
+                  SimSwarm* swarm)
+      : SimCommand(cuid, e), dl_(dl), swarm_(swarm)
+  {
+    for (auto& p : swarm_->getPeers()) {
+      peerSet_.insert(p->peer);
+    }
+  }
+
+  virtual bool execute() CXX11_OVERRIDE
+  {
+    if (dl_->done()) {
+      return true;
+    }
+    if (choke_.getLastRound().difference(global::wallclock()) >= 10_s) {
+      choke_.executeChoke(peerSet_);
+      for (auto& p : swarm_->getPeers()) {
+        p->peer->amChoking(p->peer->shouldBeChoking());
+        swarm_->updateChoke(p.get());
+      }
+    }
+    return wait();
+  }
+
+private:
+  SimDownload* dl_;
+  SimSwarm* swarm_;
+  PeerSet peerSet_;
+  BtLeecherStateChoke choke_;
+};
+} // namespace
+
+namespace {
+// A connection to a BitTorrent peer.  It selects pieces and pipelines
+// block requests as DefaultBtInteractive and DefaultBtRequestFactory
+// do.
+class SimPeerCommand : public SimCommand {
+public:
+  SimPeerCommand(cuid_t cuid, DownloadEngine* e, SimDownload* dl,
+                 SimPeer* remote)
+      : SimCommand(cuid, e),
+        dl_(dl),
+        remote_(remote),
+        pieceStorage_(dl->pieceStorage.get()),
+        received_(0),
+        discard_(0),
+        maxOutstandingRequest_(DEFAULT_MAX_OUTSTANDING_REQUEST)
+  {
+    remote_->peer->usedBy(cuid);
+    waitFor(remote_->conn->getSockfd());
+  }
+
+  virtual ~SimPeerCommand()
+  {
+    cancelAll();
+    remote_->conn->close();
+  }
+
+  virtual bool execute() CXX11_OVERRIDE
+  {
+    if (dl_->done()) {
+      return true;
+    }
+    receive();
+    dl_->checkFinished(e_);
+    if (dl_->finished) {
+      return true;
+    }
+    if (remote_->peer->peerChoking()) {
+      cancelAll();
+    }
+    else {
+      addRequests();
+    }
+    return wait();
+  }
+
+private:
+  struct Request {
+    std::shared_ptr<Piece> piece;
+    size_t blockIndex;
+    int32_t length;
+  };
+
+  void receive()
+  {
+    auto n = remote_->conn->read(std::numeric_limits<int64_t>::max());
+    dl_->bytesReceived += n;
+    auto d = std::min(n, discard_);
+    discard_ -= d;
+    received_ += n - d;
+    size_t completed = 0;
+    while (!requests_.empty() && received_ >= requests_.front().length) {
+      auto req = std::move(requests_.front());
+      requests_.pop_front();
+      received_ -= req.length;
+      ++completed;
+      remote_->peer->updateDownload(req.length);
+      if (req.piece->hasBlock(req.blockIndex)) {
+        // Already received from another peer in end game
+        continue;
+      }
+      req.piece->completeBlock(req.blockIndex);
+      if (req.piece->pieceComplete() &&
+          !pieceStorage_->hasPiece(req.piece->getIndex())) {
+        pieceStorage_->completePiece(req.piece);
+      }
+    }
+    if (!pieceStorage_->isEndGame() &&
+        completed * 4 >= maxOutstandingRequest_) {
+      maxOutstandingRequest_ = std::min(
+          static_cast<size_t>(UB_MAX_OUTSTANDING_REQUEST),
+          maxOutstandingRequest_ * 2);
+    }
+  }
+
+  // Cancels the outstanding requests and gives up the target pieces,
+  // as done on a choke message.
+  void cancelAll()
+  {
+    for (auto& req : requests_) {
+      if (!req.piece->hasBlock(req.blockIndex)) {
+        req.piece->cancelBlock(req.blockIndex);
+      }
+    }
+    requests_.clear();
+    received_ = 0;
+    // The bytes already sent still arrive, and are thrown away.
+    remote_->conn->cancel();
+    discard_ = remote_->conn->getUnreadLength();
+    for (auto& piece : pieces_) {
+      pieceStorage_->cancelPiece(piece, getCuid());
+    }
+    pieces_.clear();
+  }
+
+  void addRequests()
+  {
+    if (!pieceStorage_->isEndGame() &&
+        !pieceStorage_->hasMissingUnusedPiece()) {
+      pieceStorage_->enterEndGame();
+    }
+    pieces_.erase(std::remove_if(std::begin(pieces_), std::end(pieces_),
+                                 std::mem_fn(&Piece::pieceComplete)),
+                  std::end(pieces_));
+    fillPiece();
+    if (requests_.size() >= maxOutstandingRequest_) {
+      return;
+    }
+    auto max = maxOutstandingRequest_ - requests_.size();
+    auto endGame = pieceStorage_->isEndGame();
+    std::vector<size_t> blockIndexes;
+    for (auto& piece : pieces_) {
+      if (max == 0) {
+        break;
+      }
+      blockIndexes.clear();
+      if (endGame) {
+        for (size_t i = 0; i < piece->countBlock(); ++i) {
+          if (!piece->hasBlock(i) && !isOutstanding(piece->getIndex(), i)) {
+            blockIndexes.push_back(i);
+          }
+        }
+        std::shuffle(std::begin(blockIndexes), std::end(blockIndexes),
+                     *SimpleRandomizer::getInstance());
+        if (blockIndexes.size() > max) {
+          blockIndexes.resize(max);
+        }
+      }
+      else {
+        piece->getMissingUnusedBlockIndex(blockIndexes, max);
+      }
+      for (auto i : blockIndexes) {
+        auto length = piece->getBlockLength(i);
+        requests_.push_back(Request{piece, i, length});
+        remote_->conn->request(length);
+        ++dl_->requests;
+      }
+      max -= blockIndexes.size();
+    }
+  }
+
+  void fillPiece()
+  {
+    auto& peer = remote_->peer;
+    if (!pieceStorage_->hasMissingPiece(peer)) {
+      return;
+    }
+    size_t numMissingBlock = 0;
+    for (auto& piece : pieces_) {
+      numMissingBlock += piece->countMissingBlock();
+    }
+    if (numMissingBlock >= maxOutstandingRequest_) {
+      return;
+    }
+    auto diff = maxOutstandingRequest_ - numMissingBlock;
+    std::vector<std::shared_ptr<Piece>> pieces;
+    if (pieceStorage_->isEndGame()) {
+      std::vector<size_t> indexes;
+      for (auto& piece : pieces_) {
+        indexes.push_back(piece->getIndex());
+      }
+      pieceStorage_->getMissingPiece(pieces, diff, peer, indexes, getCuid());
+    }
+    else {
+      pieceStorage_->getMissingPiece(pieces, diff, peer, getCuid());
+    }
+    pieces_.insert(std::end(pieces_), std::begin(pieces), std::end(pieces));
+  }
+
+  bool isOutstanding(size_t index, size_t blockIndex) const
+  {
+    for (auto& req : requests_) {
+      if (req.piece->getIndex() == index && req.blockIndex == blockIndex) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  SimDownload* dl_;
+  SimPeer* remote_;
+  DefaultPieceStorage* pieceStorage_;
+  std::deque<Request> requests_;
+  std::vector<std::shared_ptr<Piece>> pieces_;
+  // Bytes received of the first request
+  int64_t received_;
+  // Bytes to arrive for the cancelled requests
+  int64_t discard_;
+  size_t maxOutstandingRequest_;
+};
+} // namespace
+
+SimSwarmConfig::SimSwarmConfig()
+    : totalLength(256_m),
+      pieceLength(256_k),
+      numSeeders(1),
+      leecherCompletion(0.5),
+      pieceInterval(10),
+      timeLimit(3600),
+      seed(1)
+{
+}
+
+SimResult runSwarmScenario(const SimSwarmConfig& config)
+{
+  SimNetwork network(config.seed);
+  Option option;
+  SimDownload dl(&network, config.pieceLength, config.totalLength, &option);
+  auto numPieces = dl.downloadContext->getNumPieces();
+  // PeerSet is ordered by address.  Assign the configurations in that
+  // order, so that the choking algorithm sees the same order in every
+  // run.
+  std::vector<std::shared_ptr<Peer>> peers;
+  for (size_t i = 0; i < config.peers.size(); ++i) {
+    peers.push_back(std::make_shared<Peer>(
+        fmt("10.%lu.%lu.1", static_cast<unsigned long>(i / 256),
+            static_cast<unsigned long>(i % 256)),
+        6881));
+  }
+  std::sort(std::begin(peers), std::end(peers), RefLess<Peer>());
+  SimSwarm swarm(&dl);
+  std::bernoulli_distribution hasPiece(config.leecherCompletion);
+  for (size_t i = 0; i < peers.size(); ++i) {
+    auto& peer = peers[i];
+    peer->allocateSessionResource(config.pieceLength, config.totalLength);
+    if (i < config.numSeeders) {
+      peer->setAllBitfield();
+    }
+    else {
+      for (size_t index = 0; index < numPieces; ++index) {
+        if (hasPiece(network.getRandom())) {
+          peer->updateBitfield(index, 1);
+        }
+      }
+      peer->peerInterested(true);
+    }
+    dl.pieceStorage->addPieceStats(peer->getBitfield(),
+                                   peer->getBitfieldLength());
+    auto p = swarm.addPeer(peer, config.peers[i]);
+    swarm.updateChoke(p);
+    if (!peer->isSeeder()) {
+      swarm.scheduleOptimisticUnchoke(p);
+      swarm.schedulePieceGain(p, config.pieceInterval);
+    }
+  }
+  auto e = createEngine(&network, &option);
+  for (auto& p : swarm.getPeers()) {
+    e->addCommand(
+        make_unique<SimPeerCommand>(e->newCUID(), e.get(), &dl, p.get()));
+  }
+  e->addCommand(
+      make_unique<SimChokeCommand>(e->newCUID(), e.get(), &dl, &swarm));
+  SimResult result;
+  runEngine(e.get(), dl, config.timeLimit, result);
+  std::vector<SimHost*> hosts;
+  for (auto& p : swarm.getPeers()) {
+    hosts.push_back(p->host.get());
+  }
+  setHostStats(hosts, result);
+  return result;
+}
+
+} // namespace aria2
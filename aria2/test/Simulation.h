@@ -0,0 +1,348 @@
+#ifndef D_SIMULATION_H
+#define D_SIMULATION_H
+
+#include "common.h"
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <queue>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "EventPoll.h"
+#include "TimerA2.h"
+
+// Deterministic discrete-event simulation of downloads.
+//
+// DownloadEngine runs with SimEventPoll, which moves the simulated
+// clock to the next event instead of sleeping.  The commands added by
+// the scenarios drive the real SegmentMan, PieceStorage and choking
+// code over simulated links, and exchange no real data: only the
+// byte counts travel.  Neither sockets nor files are touched, and a
+// run is reproducible from its seed.
+
+namespace aria2 {
+
+// Event queue and clock of a simulation.  Constructing it installs
+// the simulated clock as the TimeSource of Timer and seeds
+// SimpleRandomizer.  The destructor restores both.  Only one instance
+// may exist at a time.
+class SimNetwork {
+public:
+  typedef Timer::Clock Clock;
+
+  explicit SimNetwork(uint32_t seed);
+
+  ~SimNetwork();
+
+  Clock::time_point now() { return clock_.now(); }
+
+  // Runs |f| after |delay| of simulated time.  The events due at the
+  // same time run in the order they were scheduled.
+  void schedule(Clock::duration delay, std::function<void()> f);
+
+  // Runs the next event and returns true if it is due by |deadline|.
+  // Otherwise moves the clock to |deadline| and returns false.
+  bool runNext(Clock::time_point deadline);
+
+  // Returns a new virtual descriptor, which is only known to
+  // SimEventPoll.
+  sock_t createSocket();
+
+  void setReadable(sock_t fd, bool f);
+
+  bool isReadable(sock_t fd) const { return readable_[fd]; }
+
+  // Returns the readable descriptors in ascending order.
+  const std::set<sock_t>& getReadableSockets() const { return readableSet_; }
+
+  // Returns true if a descriptor became readable since the last
+  // call.
+  bool takeReadableNotice();
+
+  std::mt19937& getRandom() { return random_; }
+
+  uint64_t getNumEvents() const { return numEvents_; }
+
+private:
+  struct Event {
+    Clock::time_point time;
+    uint64_t seq;
+    std::function<void()> f;
+
+    bool operator>(const Event& rhs) const
+    {
+      return time > rhs.time || (time == rhs.time && seq > rhs.seq);
+    }
+  };
+
+  ManualTimeSource clock_;
+  TimeSource* prevTimeSource_;
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events_;
+  uint64_t seq_;
+  uint64_t numEvents_;
+  std::vector<bool> readable_;
+  std::set<sock_t> readableSet_;
+  bool readableNotice_;
+  std::mt19937 random_;
+};
+
+// EventPoll over the virtual descriptors of SimNetwork.  Descriptors
+// are always writable, and readable as SimNetwork says.  poll() runs
+// the simulated events until a watched descriptor becomes readable or
+// the timeout elapses in simulated time.  Only the readable
+// descriptors are looked up, so that thousands of idle connections
+// cost nothing.
+class SimEventPoll : public EventPoll {
+public:
+  SimEventPoll(SimNetwork* network);
+
+  virtual void poll(const struct timeval& tv) CXX11_OVERRIDE;
+
+  virtual bool addEvents(sock_t socket, Command* command,
+                         EventType events) CXX11_OVERRIDE;
+
+  virtual bool deleteEvents(sock_t socket, Command* command,
+                            EventType events) CXX11_OVERRIDE;
+
+#ifdef ENABLE_ASYNC_DNS
+  virtual bool
+  addNameResolver(const std::shared_ptr<AsyncNameResolver>& resolver,
+                  Command* command) CXX11_OVERRIDE;
+
+  virtual bool
+  deleteNameResolver(const std::shared_ptr<AsyncNameResolver>& resolver,
+                     Command* command) CXX11_OVERRIDE;
+#endif // ENABLE_ASYNC_DNS
+
+private:
+  // Notifies the commands whose descriptors are ready.  Returns true
+  // if any command was notified.
+  bool processEvents();
+
+  SimNetwork* network_;
+  std::map<sock_t, std::vector<std::pair<Command*, int>>> entries_;
+  // Number of the commands waiting for EVENT_WRITE
+  size_t numWriteEvents_;
+};
+
+struct SimLinkConfig {
+  // Uplink bandwidth in bytes per second.
+  int64_t bandwidth;
+  // One way latency.
+  std::chrono::milliseconds latency;
+  // Probability that a chunk is lost and retransmitted after the
+  // retransmission timeout.
+  double loss;
+};
+
+class SimConnection;
+
+// Sending side of simulated links, such as an HTTP mirror or a
+// BitTorrent peer.  The connections to a host share its uplink in
+// round robin, 16KiB at a time, and the data reaches the receiver
+// after the latency.  A host never sends more than the receive window
+// ahead of the reader, so a slow reader throttles it.
+class SimHost {
+public:
+  SimHost(SimNetwork* network, const SimLinkConfig& config);
+
+  std::shared_ptr<SimConnection> connect();
+
+  const SimLinkConfig& getConfig() const { return config_; }
+
+  SimNetwork* getNetwork() const { return network_; }
+
+  int64_t getBytesSent() const { return bytesSent_; }
+
+  // Sends the next chunk if the uplink is idle.
+  void pump();
+
+private:
+  SimNetwork* network_;
+  SimLinkConfig config_;
+  std::vector<std::shared_ptr<SimConnection>> conns_;
+  size_t next_;
+  bool busy_;
+  int64_t bytesSent_;
+};
+
+class SimConnection : public std::enable_shared_from_this<SimConnection> {
+public:
+  static const int64_t WINDOW = 1024 * 1024;
+
+  SimConnection(SimHost* host, sock_t fd);
+
+  sock_t getSockfd() const { return fd_; }
+
+  // Asks the host for |length| more bytes.  The request reaches the
+  // host after the latency, and after one more round trip for the
+  // handshake if it is the first one.
+  void request(int64_t length);
+
+  // Discards the requested bytes the host has not sent yet,
+  // including the requests still on the way to the host.
+  void cancel();
+
+  // Returns the number of sent bytes the reader has not read yet.
+  int64_t getUnreadLength() const { return inFlight_ + buffered_; }
+
+  // Consumes up to |max| received bytes and returns the number of
+  // them.  The descriptor stays readable while bytes remain.
+  int64_t read(int64_t max);
+
+  // Makes the descriptor readable without data, so that the reader
+  // notices a change of the state of the remote end.
+  void notify();
+
+  void close();
+
+  bool isClosed() const { return closed_; }
+
+  // Returns true if the host can send on this connection now.
+  bool sendable() const;
+
+  // Takes the next chunk to send, at most |max| bytes.
+  int64_t takeChunk(int64_t max);
+
+  // Called when the host finished putting |length| bytes on the wire.
+  void transmitted(int64_t length);
+
+private:
+  SimHost* host_;
+  sock_t fd_;
+  bool established_;
+  bool closed_;
+  // Incremented by cancel() to drop the requests on the way
+  uint64_t epoch_;
+  // Requested, but not sent yet
+  int64_t pending_;
+  // Sent, but not received yet
+  int64_t inFlight_;
+  // Received, but not read yet
+  int64_t buffered_;
+  // Arrival time of the last chunk, which keeps the chunks in order
+  // when one of them is retransmitted.
+  SimNetwork::Clock::time_point lastArrival_;
+};
+
+// Disk which performs writes one by one, each taking |latency| plus
+// the time to transfer the data at |bandwidth| bytes per second.
+class SimDisk {
+public:
+  SimDisk(SimNetwork* network, int64_t bandwidth,
+          std::chrono::microseconds latency);
+
+  // Queues a write of |length| bytes and returns the time it
+  // completes.
+  SimNetwork::Clock::time_point write(int64_t length);
+
+private:
+  SimNetwork* network_;
+  int64_t bandwidth_;
+  std::chrono::microseconds latency_;
+  SimNetwork::Clock::time_point busyUntil_;
+};
+
+struct SimResult {
+  bool completed;
+  int64_t totalLength;
+  // Simulated seconds until the download completed, or the time limit
+  // if it did not.
+  double elapsed;
+  // CPU seconds spent for the run.
+  double cpuTime;
+  // Bytes received, including the discarded duplicates.
+  int64_t bytesReceived;
+  // Bytes sent by each host in the configuration order.
+  std::vector<int64_t> hostBytes;
+  // Number of requests sent for segments or blocks.
+  uint64_t requests;
+  // Number of event loop iterations and simulated events.
+  uint64_t iterations;
+  uint64_t events;
+  // Jain's fairness index of the share of the uplink each host
+  // contributed, 1.0 if all hosts were used equally.
+  double fairness;
+  // Number of times the player ran out of data, and the simulated
+  // seconds it waited for data in total.
+  uint64_t stalls;
+  double stallTime;
+
+  // Bytes per simulated second.
+  double throughput() const;
+
+  // CPU nanoseconds per received byte.
+  double cpuPerByte() const;
+};
+
+// Segmented download from HTTP mirrors, one connection after another
+// assigned to the mirrors in round robin.  Each connection requests
+// the rest of the file from its segment, and streams into the
+// following segment while it is free, as DownloadCommand does.
+//
+// If playbackBitrate is not 0, a player plays the file from the start
+// while it is being downloaded, and stalls when it reaches a piece
+// which is not completed yet.  With --stream-piece-selector=deadline,
+// the player reports its position every second, as it would with
+// aria2.changePlaybackPosition.
+struct SimMirrorConfig {
+  int64_t totalLength;
+  int32_t pieceLength;
+  size_t split;
+  int64_t minSplitSize;
+  // Value of --stream-piece-selector
+  std::string streamPieceSelector;
+  std::vector<SimLinkConfig> mirrors;
+  // If not 0, a connection keeps at most this many bytes requested
+  // ahead of what it has read, as SFTP does with its pipelined read
+  // requests, instead of requesting the rest of the file at once.
+  int64_t readAhead;
+  // Write speed of the disk in bytes per second, 0 for no disk.
+  int64_t diskBandwidth;
+  std::chrono::microseconds diskLatency;
+  // Bytes per second the player consumes, 0 for no player.
+  int64_t playbackBitrate;
+  // Time from the start of the download until the player starts.
+  std::chrono::seconds playbackDelay;
+  std::chrono::seconds timeLimit;
+  uint32_t seed;
+
+  SimMirrorConfig();
+};
+
+SimResult runMirrorScenario(const SimMirrorConfig& config);
+
+// BitTorrent download from a swarm.  The first numSeeders peers are
+// seeders and the others have a random part of the pieces, gaining a
+// random piece every pieceInterval.  Pieces are selected with the
+// rarest first PieceStorage and requested with the pipelining of
+// DefaultBtInteractive.  BtLeecherStateChoke runs every 10 seconds,
+// and a leecher serves us while we unchoke it, or while we are its
+// optimistic unchoke, which it picks at random every 30 seconds.
+struct SimSwarmConfig {
+  int64_t totalLength;
+  int32_t pieceLength;
+  std::vector<SimLinkConfig> peers;
+  size_t numSeeders;
+  // Part of the pieces a leecher has at the start.
+  double leecherCompletion;
+  std::chrono::seconds pieceInterval;
+  std::chrono::seconds timeLimit;
+  uint32_t seed;
+
+  SimSwarmConfig();
+};
+
+SimResult runSwarmScenario(const SimSwarmConfig& config);
+
+// Returns Jain's fairness index of |values|.
+double jainIndex(const std::vector<double>& values);
+
+} // namespace aria2
+
+#endif // D_SIMULATION_H
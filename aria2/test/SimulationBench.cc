@@ -0,0 +1,127 @@
+#include "Bench.h"
+
+#include "Simulation.h"
+#include "fmt.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+namespace {
+void report(const std::string& prefix, const SimResult& res)
+{
+  bench::report(prefix + "completed", res.completed, "");
+  bench::report(prefix + "elapsed", res.elapsed, "s(simulated)");
+  bench::report(prefix + "throughput", res.throughput() / 1_m, "MiB/s");
+  bench::report(prefix + "requests", res.requests, "");
+  bench::report(prefix + "overhead",
+                (res.bytesReceived - res.totalLength) * 100.0 /
+                    res.totalLength,
+                "%");
+  bench::report(prefix + "fairness", res.fairness, "");
+  bench::report(prefix + "cpu", res.cpuPerByte() * 1_m / 1000, "us/MiB");
+  bench::report(prefix + "iterations", res.iterations, "");
+  bench::report(prefix + "events", res.events, "");
+}
+} // namespace
+
+namespace {
+SimMirrorConfig createMirrorConfig()
+{
+  SimMirrorConfig config;
+  config.totalLength = bench::scale(1024) * 1_m;
+  config.split = 16;
+  // Fast and near, fast and far, slow and lossy, slow and far
+  config.mirrors.push_back(
+      SimLinkConfig{40_m, std::chrono::milliseconds(10), 0});
+  config.mirrors.push_back(
+      SimLinkConfig{40_m, std::chrono::milliseconds(150), 0});
+  config.mirrors.push_back(
+      SimLinkConfig{5_m, std::chrono::milliseconds(30), 0.02});
+  config.mirrors.push_back(
+      SimLinkConfig{2_m, std::chrono::milliseconds(250), 0.001});
+  return config;
+}
+} // namespace
+
+// Segmented download from 4 mirrors with 16 connections, for each
+// --stream-piece-selector.
+A2_BENCHMARK(SimMirrors)
+{
+  auto config = createMirrorConfig();
+  const char* selectors[] = {"default", "inorder", "geom"};
+  for (auto selector : selectors) {
+    config.streamPieceSelector = selector;
+    report(fmt("%s ", selector), runMirrorScenario(config));
+  }
+}
+
+// The same download played while it is being downloaded, at a
+// bitrate which the default selector barely sustains on average.
+A2_BENCHMARK(SimMirrorsPlayback)
+{
+  auto config = createMirrorConfig();
+  config.playbackBitrate = 16_m;
+  config.playbackDelay = std::chrono::seconds(2);
+  const char* selectors[] = {"default", "inorder", "geom", "deadline"};
+  for (auto selector : selectors) {
+    config.streamPieceSelector = selector;
+    auto res = runMirrorScenario(config);
+    report(fmt("%s ", selector), res);
+    bench::report(fmt("%s stalls", selector), res.stalls, "");
+    bench::report(fmt("%s stallTime", selector), res.stallTime,
+                  "s(simulated)");
+  }
+}
+
+// The same download to a disk slower than the network.
+A2_BENCHMARK(SimMirrorsSlowDisk)
+{
+  auto config = createMirrorConfig();
+  config.diskBandwidth = 30_m;
+  config.diskLatency = std::chrono::microseconds(2000);
+  report("", runMirrorScenario(config));
+}
+
+// Download from one far mirror through SFTP, which keeps only the
+// read ahead size in flight on each connection, for some read ahead
+// sizes and numbers of connections.
+A2_BENCHMARK(SimSftpReadAhead)
+{
+  SimMirrorConfig config;
+  config.totalLength = bench::scale(256) * 1_m;
+  config.minSplitSize = 1_m;
+  config.mirrors.push_back(
+      SimLinkConfig{20_m, std::chrono::milliseconds(100), 0.001});
+  const int64_t readAheads[] = {64_k, 256_k, 1_m, 4_m};
+  const size_t splits[] = {1, 4};
+  for (auto split : splits) {
+    for (auto readAhead : readAheads) {
+      config.split = split;
+      config.readAhead = readAhead;
+      report(fmt("split=%lu readAhead=%" PRId64 "K ",
+                 static_cast<unsigned long>(split), readAhead / 1024),
+             runMirrorScenario(config));
+    }
+  }
+}
+
+// BitTorrent download from a swarm of 1000 peers, 20 of which are
+// seeders.
+A2_BENCHMARK(SimSwarm)
+{
+  SimSwarmConfig config;
+  config.totalLength = bench::scale(512) * 1_m;
+  config.pieceLength = 256_k;
+  config.numSeeders = 20;
+  std::mt19937 gen(1);
+  std::uniform_int_distribution<int64_t> bandwidth(32_k, 2_m);
+  std::uniform_int_distribution<int> latency(10, 300);
+  for (int i = 0; i < 1000; ++i) {
+    config.peers.push_back(
+        SimLinkConfig{bandwidth(gen), std::chrono::milliseconds(latency(gen)),
+                      0.005});
+  }
+  report("", runSwarmScenario(config));
+}
+
+} // namespace aria2
@@ -0,0 +1,263 @@
+#include "Simulation.h"
+
+#include <limits>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "Command.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+class SimulationTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(SimulationTest);
+  CPPUNIT_TEST(testLink);
+  CPPUNIT_TEST(testLink_window);
+  CPPUNIT_TEST(testEventPoll);
+  CPPUNIT_TEST(testMirrorScenario);
+  CPPUNIT_TEST(testMirrorScenario_slowDisk);
+  CPPUNIT_TEST(testMirrorScenario_playback);
+  CPPUNIT_TEST(testMirrorScenario_readAhead);
+  CPPUNIT_TEST(testSwarmScenario);
+  CPPUNIT_TEST(testJainIndex);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testLink();
+  void testLink_window();
+  void testEventPoll();
+  void testMirrorScenario();
+  void testMirrorScenario_slowDisk();
+  void testMirrorScenario_playback();
+  void testMirrorScenario_readAhead();
+  void testSwarmScenario();
+  void testJainIndex();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SimulationTest);
+
+namespace {
+// Reads everything |conn| receives until |length| bytes arrive, and
+// returns the simulated milliseconds it took.
+int64_t receive(SimNetwork& network, SimConnection& conn, int64_t length)
+{
+  auto start = network.now();
+  auto deadline = start + std::chrono::hours(1);
+  int64_t received = 0;
+  while (received < length && network.runNext(deadline)) {
+    received += conn.read(std::numeric_limits<int64_t>::max());
+  }
+  CPPUNIT_ASSERT_EQUAL(length, received);
+  return std::chrono::duration_cast<std::chrono::milliseconds>(network.now() -
+                                                               start)
+      .count();
+}
+} // namespace
+
+void SimulationTest::testLink()
+{
+  SimNetwork network(1);
+  SimHost host(&network, SimLinkConfig{1_m, std::chrono::milliseconds(50), 0});
+  auto conn = host.connect();
+  conn->request(1_m);
+  // Handshake and request 150ms, transfer 1s, and the latency of the
+  // last chunk 50ms.
+  CPPUNIT_ASSERT_EQUAL((int64_t)1200, receive(network, *conn, 1_m));
+  CPPUNIT_ASSERT_EQUAL((int64_t)1_m, host.getBytesSent());
+  // The connection is established now.
+  conn->request(16_k);
+  CPPUNIT_ASSERT_EQUAL((int64_t)115, receive(network, *conn, 16_k));
+}
+
+void SimulationTest::testLink_window()
+{
+  SimNetwork network(1);
+  SimHost host(&network,
+               SimLinkConfig{10_m, std::chrono::milliseconds(10), 0});
+  auto conn = host.connect();
+  conn->request(4_m);
+  auto deadline = network.now() + std::chrono::seconds(10);
+  while (network.runNext(deadline))
+    ;
+  // Nobody reads, so the host stops at the window.
+  CPPUNIT_ASSERT_EQUAL(SimConnection::WINDOW, host.getBytesSent());
+  CPPUNIT_ASSERT_EQUAL(SimConnection::WINDOW, conn->getUnreadLength());
+  CPPUNIT_ASSERT(network.isReadable(conn->getSockfd()));
+  CPPUNIT_ASSERT_EQUAL(SimConnection::WINDOW, conn->read(4_m));
+  CPPUNIT_ASSERT(!network.isReadable(conn->getSockfd()));
+  receive(network, *conn, 4_m - SimConnection::WINDOW);
+  CPPUNIT_ASSERT_EQUAL((int64_t)4_m, host.getBytesSent());
+}
+
+namespace {
+class ReadCommand : public Command {
+public:
+  ReadCommand() : Command(1) {}
+
+  virtual bool execute() CXX11_OVERRIDE { return true; }
+
+  bool readEventReceived() const { return readEventEnabled(); }
+};
+} // namespace
+
+void SimulationTest::testEventPoll()
+{
+  SimNetwork network(1);
+  SimHost host(&network, SimLinkConfig{1_m, std::chrono::milliseconds(20), 0});
+  auto conn = host.connect();
+  SimEventPoll poll(&network);
+  ReadCommand command;
+  poll.addEvents(conn->getSockfd(), &command, EventPoll::EVENT_READ);
+  struct timeval tv = {10, 0};
+  auto start = network.now();
+  // Nothing happens, so the whole timeout elapses.
+  poll.poll(tv);
+  CPPUNIT_ASSERT(!command.readEventReceived());
+  CPPUNIT_ASSERT(std::chrono::seconds(10) == network.now() - start);
+
+  conn->request(16_k);
+  start = network.now();
+  poll.poll(tv);
+  CPPUNIT_ASSERT(command.readEventReceived());
+  CPPUNIT_ASSERT(command.statusMatch(Command::STATUS_ACTIVE));
+  // Handshake and request 60ms, transfer 15.625ms, and latency 20ms
+  CPPUNIT_ASSERT_EQUAL((int64_t)95625,
+                       (int64_t)std::chrono::duration_cast<
+                           std::chrono::microseconds>(network.now() - start)
+                           .count());
+  CPPUNIT_ASSERT(poll.deleteEvents(conn->getSockfd(), &command,
+                                   EventPoll::EVENT_READ));
+  CPPUNIT_ASSERT(!poll.deleteEvents(conn->getSockfd(), &command,
+                                    EventPoll::EVENT_READ));
+}
+
+namespace {
+SimMirrorConfig createMirrorConfig()
+{
+  SimMirrorConfig config;
+  config.totalLength = 16_m;
+  config.pieceLength = 1_m;
+  config.split = 4;
+  config.minSplitSize = 1_m;
+  config.mirrors.push_back(
+      SimLinkConfig{2_m, std::chrono::milliseconds(20), 0});
+  config.mirrors.push_back(
+      SimLinkConfig{1_m, std::chrono::milliseconds(80), 0.01});
+  return config;
+}
+} // namespace
+
+void SimulationTest::testMirrorScenario()
+{
+  auto config = createMirrorConfig();
+  auto res = runMirrorScenario(config);
+  CPPUNIT_ASSERT(res.completed);
+  CPPUNIT_ASSERT(res.bytesReceived >= config.totalLength);
+  // 3MiB/s at most in total
+  CPPUNIT_ASSERT(res.elapsed >= 16.0 / 3);
+  CPPUNIT_ASSERT(res.elapsed < 16.0 / 3 * 2);
+  // The connections reaching the segment of another one send a new
+  // request.
+  CPPUNIT_ASSERT(res.requests > config.split);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, res.hostBytes.size());
+  CPPUNIT_ASSERT(res.hostBytes[0] + res.hostBytes[1] >= config.totalLength);
+
+  // The same seed reproduces the same run.
+  auto res2 = runMirrorScenario(config);
+  CPPUNIT_ASSERT_EQUAL(res.elapsed, res2.elapsed);
+  CPPUNIT_ASSERT_EQUAL(res.requests, res2.requests);
+  CPPUNIT_ASSERT_EQUAL(res.events, res2.events);
+  CPPUNIT_ASSERT(res.hostBytes == res2.hostBytes);
+}
+
+void SimulationTest::testMirrorScenario_slowDisk()
+{
+  auto config = createMirrorConfig();
+  config.diskBandwidth = 1_m;
+  config.diskLatency = std::chrono::microseconds(1000);
+  auto res = runMirrorScenario(config);
+  CPPUNIT_ASSERT(res.completed);
+  CPPUNIT_ASSERT(res.elapsed >= 16.0);
+  CPPUNIT_ASSERT(res.elapsed < 20.0);
+}
+
+void SimulationTest::testMirrorScenario_playback()
+{
+  auto config = createMirrorConfig();
+  config.totalLength = 64_m;
+  config.mirrors[1].bandwidth = 256_k;
+  // Almost all of the bandwidth is needed to keep up with the player.
+  config.playbackBitrate = 1800_k;
+  config.playbackDelay = std::chrono::seconds(2);
+  auto res = runMirrorScenario(config);
+  CPPUNIT_ASSERT(res.completed);
+  CPPUNIT_ASSERT(res.stalls > 0);
+  config.streamPieceSelector = "inorder";
+  auto inorder = runMirrorScenario(config);
+  CPPUNIT_ASSERT(inorder.completed);
+  config.streamPieceSelector = "deadline";
+  auto deadline = runMirrorScenario(config);
+  CPPUNIT_ASSERT(deadline.completed);
+  CPPUNIT_ASSERT(deadline.stallTime < res.stallTime);
+  CPPUNIT_ASSERT(deadline.stallTime < inorder.stallTime);
+}
+
+void SimulationTest::testMirrorScenario_readAhead()
+{
+  SimMirrorConfig config;
+  config.totalLength = 16_m;
+  config.pieceLength = 1_m;
+  config.split = 1;
+  config.mirrors.push_back(
+      SimLinkConfig{4_m, std::chrono::milliseconds(50), 0});
+  // 64KiB per round trip of 100ms
+  config.readAhead = 64_k;
+  auto res = runMirrorScenario(config);
+  CPPUNIT_ASSERT(res.completed);
+  CPPUNIT_ASSERT(res.elapsed >= 16.0 / (640.0 / 1024));
+  // Enough to fill the link
+  config.readAhead = 1_m;
+  res = runMirrorScenario(config);
+  CPPUNIT_ASSERT(res.completed);
+  CPPUNIT_ASSERT(res.elapsed >= 16.0 / 4);
+  CPPUNIT_ASSERT(res.elapsed < 16.0 / 4 * 1.2);
+}
+
+void SimulationTest::testSwarmScenario()
+{
+  SimSwarmConfig config;
+  config.totalLength = 8_m;
+  config.pieceLength = 256_k;
+  config.numSeeders = 2;
+  for (int i = 0; i < 20; ++i) {
+    config.peers.push_back(SimLinkConfig{
+        (i + 1) * 64_k, std::chrono::milliseconds(10 + i * 5), 0.001});
+  }
+  auto res = runSwarmScenario(config);
+  CPPUNIT_ASSERT(res.completed);
+  CPPUNIT_ASSERT(res.bytesReceived >= config.totalLength);
+  CPPUNIT_ASSERT_EQUAL((size_t)20, res.hostBytes.size());
+  // Seeders serve us from the start.
+  CPPUNIT_ASSERT(res.hostBytes[0] > 0);
+  CPPUNIT_ASSERT(res.hostBytes[1] > 0);
+
+  auto res2 = runSwarmScenario(config);
+  CPPUNIT_ASSERT_EQUAL(res.elapsed, res2.elapsed);
+  CPPUNIT_ASSERT_EQUAL(res.requests, res2.requests);
+  CPPUNIT_ASSERT(res.hostBytes == res2.hostBytes);
+
+  config.seed = 2;
+  auto res3 = runSwarmScenario(config);
+  CPPUNIT_ASSERT(res3.completed);
+  CPPUNIT_ASSERT(res.hostBytes != res3.hostBytes);
+}
+
+void SimulationTest::testJainIndex()
+{
+  CPPUNIT_ASSERT_EQUAL(1.0, jainIndex({3, 3, 3}));
+  CPPUNIT_ASSERT_EQUAL(0.25, jainIndex({1, 0, 0, 0}));
+  CPPUNIT_ASSERT_EQUAL(1.0, jainIndex({0, 0}));
+}
+
+} // namespace aria2
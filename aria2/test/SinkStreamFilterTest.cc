@@ -1,6 +1,7 @@
 #include "SinkStreamFilter.h"
 
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <cppunit/extensions/HelperMacros.h>
 
@@ -8,6 +9,11 @@
 #include "ByteArrayDiskWriter.h"
 #include "SinkStreamFilter.h"
 #include "MockSegment.h"
+#include "PiecedSegment.h"
+#include "Piece.h"
+#include "DirectDiskAdaptor.h"
+#include "WrDiskCache.h"
+#include "Metrics.h"
 
 namespace aria2 {
 
@@ -16,6 +22,7 @@ class SinkStreamFilterTest : public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(SinkStreamFilterTest);
   CPPUNIT_TEST(testTransform_with_length);
   CPPUNIT_TEST(testTransform_without_length);
+  CPPUNIT_TEST(testTransform_inPlace);
   CPPUNIT_TEST_SUITE_END();
 
   class MockSegment2 : public MockSegment {
@@ -55,6 +62,7 @@ public:
 
   void testTransform_with_length();
   void testTransform_without_length();
+  void testTransform_inPlace();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(SinkStreamFilterTest);
@@ -82,4 +90,55 @@ void SinkStreamFilterTest::testTransform_without_length()
   CPPUNIT_ASSERT_EQUAL((ssize_t)17, r);
 }
 
+void SinkStreamFilterTest::testTransform_inPlace()
+{
+  auto adaptor = std::make_shared<DirectDiskAdaptor>();
+  auto dw = make_unique<ByteArrayDiskWriter>();
+  auto writer = dw.get();
+  adaptor->setDiskWriter(std::move(dw));
+  WrDiskCache dc(1_m);
+  auto piece = std::make_shared<Piece>(0, 10_k);
+  piece->initWrCache(&dc, adaptor);
+  std::shared_ptr<Segment> segment =
+      std::make_shared<PiecedSegment>(10_k, piece);
+  SinkStreamFilter filter(&dc);
+  auto copied =
+      global::metrics().counter("aria2_disk_cache_copied_bytes_total", "");
+  auto inPlace =
+      global::metrics().counter("aria2_disk_cache_in_place_bytes_total", "");
+  auto copiedStart = copied->get();
+  auto inPlaceStart = inPlace->get();
+
+  // Copied into a new 4KiB cell
+  std::string x(1_k, 'x');
+  filter.transform(adaptor, segment,
+                   reinterpret_cast<const unsigned char*>(x.data()),
+                   x.size());
+  // The rest of the cell is lent.
+  size_t len = 16_k;
+  auto buf = filter.reserve(segment, len);
+  CPPUNIT_ASSERT(buf);
+  CPPUNIT_ASSERT_EQUAL((size_t)3_k, len);
+  memset(buf, 'y', len);
+  CPPUNIT_ASSERT_EQUAL((ssize_t)3_k,
+                       filter.transform(adaptor, segment, buf, len));
+  // A new cell is lent, at most the rest of the segment.
+  len = 16_k;
+  buf = filter.reserve(segment, len);
+  CPPUNIT_ASSERT(buf);
+  CPPUNIT_ASSERT_EQUAL((size_t)6_k, len);
+  memset(buf, 'z', len);
+  CPPUNIT_ASSERT_EQUAL((ssize_t)6_k,
+                       filter.transform(adaptor, segment, buf, len));
+  len = 16_k;
+  CPPUNIT_ASSERT(!filter.reserve(segment, len));
+
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1_k, copied->get() - copiedStart);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)9_k, inPlace->get() - inPlaceStart);
+  CPPUNIT_ASSERT_EQUAL((size_t)10_k, dc.getSize());
+  piece->flushWrCache(&dc);
+  CPPUNIT_ASSERT_EQUAL(x + std::string(3_k, 'y') + std::string(6_k, 'z'),
+                       writer->getString());
+}
+
 } // namespace aria2
@@ -0,0 +1,45 @@
+#include "Bench.h"
+
+#include <vector>
+
+#include "SpeedCalc.h"
+#include "wallclock.h"
+
+namespace aria2 {
+
+// 5000 peers, each of which receives a 16KiB block per event loop
+// iteration.  Each iteration takes 1ms, so that time slots are
+// created and expire as in a busy download.
+A2_BENCHMARK(SpeedCalcUpdate)
+{
+  const size_t NUM_PEERS = 5000;
+  std::vector<SpeedCalc> calcs(NUM_PEERS);
+  global::wallclock().reset();
+  auto rounds = bench::scale(2000);
+  auto start = bench::now();
+  for (size_t i = 0; i < rounds; ++i) {
+    global::wallclock().advance(1_ms);
+    for (auto& calc : calcs) {
+      calc.update(16_k);
+    }
+  }
+  auto end = bench::now();
+  bench::report("update", (end - start) * 1e9 / (rounds * NUM_PEERS),
+                "ns/op");
+
+  volatile int sink = 0;
+  rounds = bench::scale(200);
+  start = bench::now();
+  for (size_t i = 0; i < rounds; ++i) {
+    global::wallclock().advance(10_ms);
+    for (auto& calc : calcs) {
+      sink = sink + calc.calculateSpeed();
+    }
+  }
+  end = bench::now();
+  bench::report("calculateSpeed", (end - start) * 1e9 / (rounds * NUM_PEERS),
+                "ns/op");
+  global::wallclock().reset();
+}
+
+} // namespace aria2
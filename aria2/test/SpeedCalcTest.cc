@@ -2,19 +2,27 @@
 #include <string>
 #include <cppunit/extensions/HelperMacros.h>
 
+#include "wallclock.h"
+
 namespace aria2 {
 
 class SpeedCalcTest : public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(SpeedCalcTest);
   CPPUNIT_TEST(testUpdate);
+  CPPUNIT_TEST(testCalculateSpeed);
+  CPPUNIT_TEST(testCalculateNewestSpeed);
+  CPPUNIT_TEST(testWindow);
   CPPUNIT_TEST_SUITE_END();
 
 private:
 public:
-  void setUp() {}
+  void setUp() { global::wallclock().reset(); }
 
   void testUpdate();
+  void testCalculateSpeed();
+  void testCalculateNewestSpeed();
+  void testWindow();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(SpeedCalcTest);
@@ -25,4 +33,57 @@ void SpeedCalcTest::testUpdate()
   calc.update(1000);
 }
 
+void SpeedCalcTest::testCalculateSpeed()
+{
+  SpeedCalc calc;
+  CPPUNIT_ASSERT_EQUAL(0, calc.calculateSpeed());
+  calc.update(1000);
+  global::wallclock().advance(500_ms);
+  // Same time slot
+  calc.update(1000);
+  CPPUNIT_ASSERT_EQUAL(4000, calc.calculateSpeed());
+  global::wallclock().advance(1_s);
+  calc.update(3000);
+  CPPUNIT_ASSERT_EQUAL(3333, calc.calculateSpeed());
+  CPPUNIT_ASSERT_EQUAL(4000, calc.getMaxSpeed());
+  calc.reset();
+  CPPUNIT_ASSERT_EQUAL(0, calc.calculateSpeed());
+  CPPUNIT_ASSERT_EQUAL(0, calc.getMaxSpeed());
+}
+
+void SpeedCalcTest::testCalculateNewestSpeed()
+{
+  SpeedCalc calc;
+  CPPUNIT_ASSERT_EQUAL(0, calc.calculateNewestSpeed(1));
+  calc.update(1000);
+  global::wallclock().advance(1500_ms);
+  calc.update(3000);
+  global::wallclock().advance(500_ms);
+  // Only the second slot is in the last second.
+  CPPUNIT_ASSERT_EQUAL(6000, calc.calculateNewestSpeed(1));
+  CPPUNIT_ASSERT_EQUAL(2000, calc.calculateNewestSpeed(2));
+  global::wallclock().advance(2_s);
+  CPPUNIT_ASSERT_EQUAL(0, calc.calculateNewestSpeed(1));
+}
+
+void SpeedCalcTest::testWindow()
+{
+  SpeedCalc calc;
+  // Wraps around the time slots several times.
+  for (int i = 0; i < 30; ++i) {
+    calc.update(100);
+    global::wallclock().advance(1_s);
+  }
+  global::wallclock().sub(1_s);
+  // 11 slots for the last 10 seconds
+  CPPUNIT_ASSERT_EQUAL(110, calc.calculateSpeed());
+  global::wallclock().advance(5_s);
+  // Slots updated in the last 10 seconds
+  CPPUNIT_ASSERT_EQUAL(60, calc.calculateSpeed());
+  global::wallclock().advance(6_s);
+  CPPUNIT_ASSERT_EQUAL(0, calc.calculateSpeed());
+  calc.update(100);
+  CPPUNIT_ASSERT_EQUAL(100000, calc.calculateSpeed());
+}
+
 } // namespace aria2
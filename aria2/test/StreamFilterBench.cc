@@ -0,0 +1,203 @@
+#include "Bench.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "SinkStreamFilter.h"
+#include "ChunkedDecodingStreamFilter.h"
+#include "GZipDecodingStreamFilter.h"
+#include "GZipEncoder.h"
+#include "DirectDiskAdaptor.h"
+#include "DiskWriter.h"
+#include "WrDiskCache.h"
+#include "PiecedSegment.h"
+#include "Piece.h"
+#include "Metrics.h"
+#include "a2functional.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+namespace {
+const size_t DATA_LENGTH = 16_m;
+const size_t CHUNK_LENGTH = 32_k;
+// The capacity of SocketRecvBuffer
+const size_t RECV_LENGTH = 16_k;
+
+// Discards the data flushed from the disk cache.
+class NullDiskWriter : public DiskWriter {
+public:
+  virtual void initAndOpenFile(int64_t totalLength) CXX11_OVERRIDE {}
+
+  virtual void openFile(int64_t totalLength) CXX11_OVERRIDE {}
+
+  virtual void closeFile() CXX11_OVERRIDE {}
+
+  virtual void openExistingFile(int64_t totalLength) CXX11_OVERRIDE {}
+
+  virtual int64_t size() CXX11_OVERRIDE { return 0; }
+
+  virtual void writeData(const unsigned char* data, size_t len,
+                         int64_t offset) CXX11_OVERRIDE
+  {
+  }
+
+  virtual ssize_t readData(unsigned char* data, size_t len,
+                           int64_t offset) CXX11_OVERRIDE
+  {
+    return 0;
+  }
+};
+} // namespace
+
+namespace {
+// The sink before it lent the disk cache to the filters: all data are
+// copied into the cache.
+class CopySinkStreamFilter : public SinkStreamFilter {
+public:
+  CopySinkStreamFilter(WrDiskCache* wrDiskCache)
+      : SinkStreamFilter(wrDiskCache)
+  {
+  }
+
+  virtual unsigned char* reserve(const std::shared_ptr<Segment>& segment,
+                                 size_t& len) CXX11_OVERRIDE
+  {
+    return nullptr;
+  }
+};
+} // namespace
+
+namespace {
+std::string createData()
+{
+  // Compressible about 2:1
+  std::mt19937 rng(1);
+  std::string data(DATA_LENGTH, '\0');
+  for (auto& c : data) {
+    c = 'a' + rng() % 16;
+  }
+  return data;
+}
+} // namespace
+
+namespace {
+std::string chunk(const std::string& data)
+{
+  std::string res;
+  for (size_t i = 0; i < data.size(); i += CHUNK_LENGTH) {
+    auto len = std::min(CHUNK_LENGTH, data.size() - i);
+    res += fmt("%lx\r\n", static_cast<unsigned long>(len));
+    res.append(data, i, len);
+    res += "\r\n";
+  }
+  res += "0\r\n\r\n";
+  return res;
+}
+} // namespace
+
+namespace {
+std::string gzip(const std::string& data)
+{
+  GZipEncoder encoder;
+  encoder.init();
+  encoder << data;
+  return encoder.str();
+}
+} // namespace
+
+namespace {
+// Feeds |wire| to |filter| as DownloadCommand reads it from the
+// socket: into the buffer lent by the filter if any, and otherwise
+// into the receive buffer.  The first copy stands for the read from
+// the socket.
+void feed(StreamFilter& filter, const std::shared_ptr<BinaryStream>& out,
+          const std::shared_ptr<Segment>& segment, const std::string& wire)
+{
+  std::vector<unsigned char> recvbuf(RECV_LENGTH);
+  size_t pos = 0;
+  while (pos < wire.size()) {
+    auto len = std::min(RECV_LENGTH, wire.size() - pos);
+    auto buf = filter.reserve(segment, len);
+    if (buf) {
+      memcpy(buf, wire.data() + pos, len);
+      filter.transform(out, segment, buf, len);
+      pos += len;
+    }
+    else {
+      len = std::min(RECV_LENGTH, wire.size() - pos);
+      memcpy(recvbuf.data(), wire.data() + pos, len);
+      filter.transform(out, segment, recvbuf.data(), len);
+      pos += filter.getBytesProcessed();
+    }
+  }
+}
+} // namespace
+
+namespace {
+void measure(const std::string& label, const std::string& wire,
+             bool chunked, bool gzipped, bool lend)
+{
+  auto copied =
+      global::metrics().counter("aria2_disk_cache_copied_bytes_total", "");
+  auto adaptor = std::make_shared<DirectDiskAdaptor>();
+  adaptor->setDiskWriter(make_unique<NullDiskWriter>());
+  // Flushed every 4MiB as --disk-cache=4M would
+  WrDiskCache dc(4_m);
+  auto n = bench::scale(8);
+  uint64_t copiedStart = copied->get();
+  double elapsed = 0;
+  for (size_t i = 0; i < n; ++i) {
+    auto piece = std::make_shared<Piece>(0, DATA_LENGTH);
+    piece->initWrCache(&dc, adaptor);
+    std::shared_ptr<Segment> segment =
+        std::make_shared<PiecedSegment>(DATA_LENGTH, piece);
+    std::unique_ptr<StreamFilter> filter;
+    if (lend) {
+      filter = make_unique<SinkStreamFilter>(&dc);
+    }
+    else {
+      filter = make_unique<CopySinkStreamFilter>(&dc);
+    }
+    filter->init();
+    if (gzipped) {
+      filter = make_unique<GZipDecodingStreamFilter>(std::move(filter));
+      filter->init();
+    }
+    if (chunked) {
+      filter = make_unique<ChunkedDecodingStreamFilter>(std::move(filter));
+      filter->init();
+    }
+    auto start = bench::now();
+    feed(*filter, adaptor, segment, wire);
+    piece->flushWrCache(&dc);
+    elapsed += bench::now() - start;
+    piece->releaseWrCache(&dc);
+  }
+  double total = static_cast<double>(n) * DATA_LENGTH;
+  bench::report(label, total / elapsed / 1_m, "MiB/s");
+  bench::report(label + " copies", (copied->get() - copiedStart) / total,
+                "copies/byte");
+}
+} // namespace
+
+// Decoding of a 16MiB body into the write disk cache.  The "copy"
+// runs use the sink which does not lend its cache, as before the
+// filters read into it.
+A2_BENCHMARK(StreamFilterThroughput)
+{
+  auto data = createData();
+  auto chunked = chunk(data);
+  auto gzipped = gzip(data);
+  auto chunkedGzipped = chunk(gzipped);
+  for (auto lend : {false, true}) {
+    std::string mode = lend ? "lent " : "copy ";
+    measure(mode + "identity", data, false, false, lend);
+    measure(mode + "chunked", chunked, true, false, lend);
+    measure(mode + "gzip", gzipped, false, true, lend);
+    measure(mode + "chunked gzip", chunkedGzipped, true, true, lend);
+  }
+}
+
+} // namespace aria2
@@ -0,0 +1,94 @@
+#include "Bench.h"
+
+#include <memory>
+#include <vector>
+
+#include "TimerA2.h"
+#include "NetStat.h"
+#include "wallclock.h"
+
+namespace aria2 {
+
+namespace {
+// Counts the reads of the clock, which would be system calls where
+// the clock is not served from memory.
+class CountingTimeSource : public TimeSource {
+public:
+  CountingTimeSource() : count(0) {}
+
+  virtual Timer::Clock::time_point now() CXX11_OVERRIDE
+  {
+    ++count;
+    return source.now();
+  }
+
+  MonotonicTimeSource source;
+  uint64_t count;
+};
+} // namespace
+
+A2_BENCHMARK(TimeSourceRead)
+{
+  auto n = bench::scale(10000000);
+  MonotonicTimeSource source;
+  volatile int64_t sink = 0;
+  auto start = bench::now();
+  for (size_t i = 0; i < n; ++i) {
+    sink = sink + source.now().time_since_epoch().count();
+  }
+  auto end = bench::now();
+  bench::report("MonotonicTimeSource", (end - start) * 1e9 / n, "ns/op");
+
+  start = bench::now();
+  for (size_t i = 0; i < n; ++i) {
+    sink = sink + Timer::Clock::now().time_since_epoch().count();
+  }
+  end = bench::now();
+  bench::report("Timer::Clock::now", (end - start) * 1e9 / n, "ns/op");
+}
+
+// 10000 connections, each of which receives a block per event loop
+// iteration and checks its timeout.  1% of the connections are
+// replaced by new ones per iteration.
+A2_BENCHMARK(TimeSourceEventLoop)
+{
+  const size_t NUM_CONNECTIONS = 10000;
+  CountingTimeSource source;
+  auto prev = setTimeSource(&source);
+  global::wallclock().reset();
+  std::vector<std::unique_ptr<NetStat>> conns;
+  std::vector<Timer> checkPoints;
+  for (size_t i = 0; i < NUM_CONNECTIONS; ++i) {
+    conns.push_back(make_unique<NetStat>());
+    checkPoints.push_back(global::wallclock());
+  }
+  auto iterations = bench::scale(1000);
+  size_t timedout = 0;
+  source.count = 0;
+  auto start = bench::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    global::wallclock().reset();
+    for (size_t j = 0; j < NUM_CONNECTIONS; ++j) {
+      conns[j]->updateDownload(16_k);
+      if (checkPoints[j].difference(global::wallclock()) >= 60_s) {
+        ++timedout;
+      }
+      checkPoints[j] = global::wallclock();
+    }
+    for (size_t j = i % 100; j < NUM_CONNECTIONS; j += 100) {
+      conns[j] = make_unique<NetStat>();
+    }
+  }
+  auto elapsed = bench::now() - start;
+  setTimeSource(prev);
+  global::wallclock().reset();
+  bench::report("clock reads/iteration",
+                static_cast<double>(source.count) / iterations, "");
+  bench::report("clock reads/s", source.count / elapsed, "");
+  bench::report("iteration", elapsed * 1e6 / iterations, "us");
+  if (timedout) {
+    bench::report("timedout", timedout, "");
+  }
+}
+
+} // namespace aria2
@@ -0,0 +1,74 @@
+#include "TimerA2.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "wallclock.h"
+
+namespace aria2 {
+
+class TimerTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(TimerTest);
+  CPPUNIT_TEST(testMonotonicTimeSource);
+  CPPUNIT_TEST(testManualTimeSource);
+  CPPUNIT_TEST(testSetTimeSource);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp() {}
+
+  void tearDown() { setTimeSource(nullptr); }
+
+  void testMonotonicTimeSource();
+  void testManualTimeSource();
+  void testSetTimeSource();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TimerTest);
+
+void TimerTest::testMonotonicTimeSource()
+{
+  MonotonicTimeSource source;
+  auto prev = source.now();
+  for (int i = 0; i < 1000; ++i) {
+    auto now = source.now();
+    CPPUNIT_ASSERT(prev <= now);
+    prev = now;
+  }
+  // Coarse clock lags behind the precise one by a few milliseconds at
+  // most.
+  auto precise = Timer::Clock::now() + 24_h;
+  CPPUNIT_ASSERT(Timer(source.now()).difference(Timer(precise)) < 1_s);
+  CPPUNIT_ASSERT(Timer(precise).difference(Timer(source.now())) < 1_s);
+}
+
+void TimerTest::testManualTimeSource()
+{
+  ManualTimeSource source;
+  auto start = source.now();
+  CPPUNIT_ASSERT(start == ManualTimeSource().now());
+  CPPUNIT_ASSERT(!Timer(start).isZero());
+  CPPUNIT_ASSERT(start == source.now());
+  source.advance(1500_ms);
+  CPPUNIT_ASSERT(std::chrono::milliseconds(1500) ==
+                 Timer(start).difference(Timer(source.now())));
+}
+
+void TimerTest::testSetTimeSource()
+{
+  ManualTimeSource source;
+  setTimeSource(&source);
+  Timer timer;
+  CPPUNIT_ASSERT(source.now() == timer.getTime());
+  source.advance(10_s);
+  CPPUNIT_ASSERT(std::chrono::seconds(10) == timer.difference());
+  global::wallclock().reset();
+  CPPUNIT_ASSERT(source.now() == global::wallclock().getTime());
+
+  CPPUNIT_ASSERT(&source == setTimeSource(nullptr));
+  Timer now;
+  CPPUNIT_ASSERT(now.getTime() != source.now());
+  global::wallclock().reset();
+}
+
+} // namespace aria2
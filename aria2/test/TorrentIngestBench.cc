@@ -0,0 +1,103 @@
+#include "Bench.h"
+
+#include <thread>
+
+#include "TorrentIngestor.h"
+#include "Option.h"
+#include "prefs.h"
+#include "ValueBase.h"
+#include "bencode2.h"
+#include "base64.h"
+#include "util.h"
+
+namespace aria2 {
+
+namespace {
+// A torrent of |numFiles| files in |numPieces| pieces, with the
+// piece hashes derived from |seed| so that the info hashes differ.
+std::string createTorrent(size_t seed, size_t numFiles, size_t numPieces)
+{
+  const int64_t pieceLength = 256 * 1024;
+  auto info = Dict::g();
+  info->put("name", "bench-" + util::itos(seed));
+  info->put("piece length", Integer::g(pieceLength));
+  std::string pieces(numPieces * 20, '\0');
+  for (size_t i = 0; i < pieces.size(); ++i) {
+    pieces[i] = static_cast<char>((seed * 131 + i * 7) & 0xff);
+  }
+  info->put("pieces", pieces);
+  auto files = List::g();
+  int64_t fileLength = pieceLength * numPieces / numFiles;
+  for (size_t i = 0; i < numFiles; ++i) {
+    auto file = Dict::g();
+    file->put("length", Integer::g(fileLength));
+    auto path = List::g();
+    path->append("dir" + util::itos(i % 8));
+    path->append("file" + util::itos(i) + ".dat");
+    file->put("path", std::move(path));
+    files->append(std::move(file));
+  }
+  info->put("files", std::move(files));
+  auto root = Dict::g();
+  root->put("announce", "http://tracker.example.org/announce");
+  root->put("info", std::move(info));
+  return bencode2::encode(root.get());
+}
+
+void measure(const std::string& label, size_t numThreads,
+             const std::vector<std::string>& torrents,
+             const std::shared_ptr<Option>& option)
+{
+  std::vector<TorrentIngestJob> jobs(torrents.size());
+  size_t bytes = 0;
+  for (size_t i = 0; i < torrents.size(); ++i) {
+    jobs[i].data = torrents[i];
+    jobs[i].base64 = true;
+    jobs[i].option = option;
+    bytes += torrents[i].size();
+  }
+  auto start = bench::now();
+  if (numThreads == 0) {
+    for (auto& job : jobs) {
+      ingestTorrent(job);
+    }
+  }
+  else {
+    TorrentIngestor(numThreads).run(jobs);
+  }
+  auto elapsed = bench::now() - start;
+  size_t failures = 0;
+  for (auto& job : jobs) {
+    if (!job.downloadContext) {
+      ++failures;
+    }
+  }
+  bench::report(label, jobs.size() / elapsed, "torrents/s");
+  bench::report(label + " input", bytes / elapsed / 1024 / 1024, "MiB/s");
+  if (failures) {
+    bench::report(label + " failures", failures, "");
+  }
+}
+} // namespace
+
+// Ingests Base64 encoded torrents of 64 files in 4000 pieces, as
+// aria2.addTorrent calls in a JSON-RPC system.multicall carry them,
+// on the calling thread alone as before, and on TorrentIngestor.
+A2_BENCHMARK(TorrentIngest)
+{
+  auto option = std::make_shared<Option>();
+  option->put(PREF_DIR, "/tmp");
+  option->put(PREF_MAX_CONNECTION_PER_SERVER, "1");
+  std::vector<std::string> torrents;
+  for (size_t i = 0, n = bench::scale(2000); i < n; ++i) {
+    auto torrent = createTorrent(i, 64, 4000);
+    torrents.push_back(base64::encode(std::begin(torrent), std::end(torrent)));
+  }
+  measure("serial", 0, torrents, option);
+  size_t maxThreads = TorrentIngestor().getNumThreads();
+  for (size_t n = 1; n <= maxThreads; n *= 2) {
+    measure(util::itos(n) + " threads", n, torrents, option);
+  }
+}
+
+} // namespace aria2
@@ -0,0 +1,142 @@
+#include "TorrentIngestor.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "DownloadContext.h"
+#include "FileEntry.h"
+#include "Option.h"
+#include "prefs.h"
+#include "bittorrent_helper.h"
+#include "base64.h"
+#include "download_helper.h"
+#include "ValueBaseBencodeParser.h"
+#include "RecoverableException.h"
+#include "TestUtil.h"
+
+namespace aria2 {
+
+class TorrentIngestorTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(TorrentIngestorTest);
+  CPPUNIT_TEST(testRun);
+  CPPUNIT_TEST(testRun_data);
+  CPPUNIT_TEST(testRun_error);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  std::shared_ptr<Option> option_;
+
+public:
+  void setUp()
+  {
+    option_ = std::make_shared<Option>();
+    option_->put(PREF_DIR, "/tmp");
+    option_->put(PREF_MAX_CONNECTION_PER_SERVER, "1");
+  }
+
+  void testRun();
+  void testRun_data();
+  void testRun_error();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TorrentIngestorTest);
+
+void TorrentIngestorTest::testRun()
+{
+  std::vector<TorrentIngestJob> jobs(64);
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    jobs[i].metaInfoUri = i % 2 ? A2_TEST_DIR "/test.torrent"
+                                : A2_TEST_DIR "/single.torrent";
+    jobs[i].option = option_;
+  }
+  // Neither is a .torrent file, so they are skipped.
+  jobs[10].metaInfoUri = A2_TEST_DIR "/input_uris.txt";
+  jobs[11].metaInfoUri = A2_TEST_DIR "/no-such-file.torrent";
+  TorrentIngestor ingestor(4);
+  CPPUNIT_ASSERT_EQUAL((size_t)4, ingestor.getNumThreads());
+  ingestor.run(jobs);
+
+  // The same as the DownloadContext created on this thread.
+  bittorrent::ValueBaseBencodeParser parser;
+  auto torrent = parseFile(parser, A2_TEST_DIR "/test.torrent");
+  auto expected = createBtDownloadContext(
+      option_, {}, A2_TEST_DIR "/test.torrent", torrent.get());
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    if (i == 10 || i == 11) {
+      CPPUNIT_ASSERT(!jobs[i].downloadContext);
+      CPPUNIT_ASSERT(!jobs[i].error);
+      continue;
+    }
+    CPPUNIT_ASSERT(jobs[i].downloadContext);
+    CPPUNIT_ASSERT(!jobs[i].error);
+    if (i % 2) {
+      auto& dctx = jobs[i].downloadContext;
+      CPPUNIT_ASSERT_EQUAL(
+          bittorrent::getInfoHashString(expected),
+          bittorrent::getInfoHashString(dctx));
+      CPPUNIT_ASSERT_EQUAL(expected->getFileEntries().size(),
+                           dctx->getFileEntries().size());
+      CPPUNIT_ASSERT_EQUAL(expected->getBasePath(), dctx->getBasePath());
+      CPPUNIT_ASSERT(expected->getPieceHashes() == dctx->getPieceHashes());
+    }
+    else {
+      CPPUNIT_ASSERT_EQUAL(
+          std::string("/tmp/aria2-0.8.2.tar.bz2"),
+          jobs[i].downloadContext->getFirstFileEntry()->getPath());
+    }
+  }
+}
+
+void TorrentIngestorTest::testRun_data()
+{
+  auto data = readFile(A2_TEST_DIR "/single.torrent");
+  std::vector<TorrentIngestJob> jobs(3);
+  for (auto& job : jobs) {
+    job.option = option_;
+    job.uris.push_back("http://localhost/aria2-0.8.2.tar.bz2");
+  }
+  jobs[0].data = data;
+  jobs[1].data = base64::encode(std::begin(data), std::end(data));
+  jobs[1].base64 = true;
+  jobs[2].data = data;
+  jobs[2].option = std::make_shared<Option>(*option_);
+  jobs[2].option->put(PREF_RPC_SAVE_UPLOAD_METADATA, A2_V_TRUE);
+  TorrentIngestor(2).run(jobs);
+
+  for (auto& job : jobs) {
+    CPPUNIT_ASSERT(job.downloadContext);
+    CPPUNIT_ASSERT_EQUAL(data, job.data);
+    CPPUNIT_ASSERT(!job.base64);
+    CPPUNIT_ASSERT_EQUAL(
+        std::string("http://localhost/aria2-0.8.2.tar.bz2"),
+        job.downloadContext->getFirstFileEntry()->getRemainingUris()[0]);
+  }
+  CPPUNIT_ASSERT_EQUAL(std::string(), jobs[0].metaInfoUri);
+  // The path aria2.addTorrent saves the upload to.
+  CPPUNIT_ASSERT_EQUAL(
+      std::string("/tmp/0a3893293e27ac0490424c06de4d09242215f0a6.torrent"),
+      jobs[2].metaInfoUri);
+}
+
+void TorrentIngestorTest::testRun_error()
+{
+  std::vector<TorrentIngestJob> jobs(2);
+  jobs[0].data = "not torrent";
+  jobs[0].option = option_;
+  // The info dictionary lacks the pieces.
+  jobs[1].data = "d4:infod6:lengthi1e4:name1:a12:piece lengthi1eee";
+  jobs[1].option = option_;
+  TorrentIngestor(2).run(jobs);
+  for (auto& job : jobs) {
+    CPPUNIT_ASSERT(!job.downloadContext);
+    CPPUNIT_ASSERT(job.error);
+    try {
+      std::rethrow_exception(job.error);
+      CPPUNIT_FAIL("exception must be thrown.");
+    }
+    catch (RecoverableException& e) {
+    }
+  }
+}
+
+} // namespace aria2
@@ -0,0 +1,158 @@
+#include "Bench.h"
+
+#ifdef ENABLE_WEBSOCKET
+
+#  include <sys/types.h>
+#  include <sys/socket.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+
+#  include <vector>
+
+#  include "DownloadEngine.h"
+#  include "SelectEventPoll.h"
+#  include "SocketCore.h"
+#  include "Option.h"
+#  include "prefs.h"
+#  include "RequestGroup.h"
+#  include "GroupId.h"
+#  include "WebSocketSession.h"
+#  include "WebSocketSessionMan.h"
+#  include "WebSocketInteractionCommand.h"
+#  include "a2functional.h"
+#  include "fmt.h"
+
+namespace aria2 {
+
+namespace {
+// A dashboard connected over a socketpair.  The bench plays the
+// client end.
+struct Client {
+  int fd;
+  std::shared_ptr<rpc::WebSocketSession> session;
+  std::unique_ptr<rpc::WebSocketInteractionCommand> command;
+  int64_t received;
+
+  ~Client()
+  {
+    command.reset();
+    close(fd);
+  }
+};
+
+std::unique_ptr<Client> connect(DownloadEngine* e, cuid_t cuid,
+                                bool permessageDeflate)
+{
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+    return nullptr;
+  }
+  auto socket = std::make_shared<SocketCore>(fds[0], SOCK_STREAM);
+  socket->setNonBlockingMode();
+  fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+  auto client = make_unique<Client>();
+  client->fd = fds[1];
+  client->session =
+      std::make_shared<rpc::WebSocketSession>(socket, e, permessageDeflate);
+  client->command = make_unique<rpc::WebSocketInteractionCommand>(
+      cuid, client->session, e, socket);
+  client->session->setCommand(client->command.get());
+  client->received = 0;
+  return client;
+}
+
+void receive(Client& client)
+{
+  char buf[16_k];
+  ssize_t r;
+  while ((r = read(client.fd, buf, sizeof(buf))) > 0) {
+    client.received += r;
+  }
+}
+
+// Sends the queued frames to the clients until all of them are sent.
+void drain(std::vector<std::unique_ptr<Client>>& clients)
+{
+  bool pending = true;
+  while (pending) {
+    pending = false;
+    for (auto& client : clients) {
+      client->session->onWriteEvent();
+      receive(*client);
+      pending = pending || client->session->getQueuedLength() > 0;
+    }
+  }
+}
+} // namespace
+
+// A burst of aria2.onDownloadPause notifications, as aria2.pauseAll
+// causes, sent to 200 dashboards.  Half of them negotiated
+// permessage-deflate.  Then a dashboard which stopped reading keeps
+// receiving notifications, and its send queue is capped by
+// --rpc-max-send-queue-size.
+A2_BENCHMARK(WebSocketNotification)
+{
+  const size_t NUM_CLIENTS = 200;
+  auto option = std::make_shared<Option>();
+  option->put(PREF_RPC_MAX_REQUEST_SIZE, "2097152");
+  option->put(PREF_RPC_MAX_SEND_QUEUE_SIZE, "1048576");
+  option->put(PREF_RPC_SEND_QUEUE_OVERFLOW, V_DROP);
+  DownloadEngine e(make_unique<SelectEventPoll>());
+  e.setOption(option.get());
+  e.setWebSocketSessionMan(make_unique<rpc::WebSocketSessionMan>());
+  auto& wsman = e.getWebSocketSessionMan();
+
+  std::vector<std::unique_ptr<Client>> clients;
+  for (size_t i = 0; i < NUM_CLIENTS; ++i) {
+    auto client = connect(&e, i + 1, i % 2);
+    if (!client) {
+      bench::report("socketpair failed", i, "");
+      return;
+    }
+    clients.push_back(std::move(client));
+  }
+  auto n = bench::scale(2000);
+  std::vector<std::unique_ptr<RequestGroup>> groups;
+  for (size_t i = 0; i < n; ++i) {
+    groups.push_back(make_unique<RequestGroup>(GroupId::create(), option));
+  }
+
+  auto start = bench::now();
+  for (auto& group : groups) {
+    wsman->addNotification("aria2.onDownloadPause", group.get());
+  }
+  auto queued = bench::now();
+  drain(clients);
+  auto end = bench::now();
+  bench::report("queue", (queued - start) * 1e9 / n / NUM_CLIENTS,
+                "ns/notification/session");
+  bench::report("send", (end - queued) * 1e9 / n / NUM_CLIENTS,
+                "ns/notification/session");
+  bench::report("wire bytes, plain",
+                static_cast<double>(clients[0]->received) / n,
+                "bytes/notification");
+  bench::report("wire bytes, permessage-deflate",
+                static_cast<double>(clients[1]->received) / n,
+                "bytes/notification");
+
+  clients.resize(1);
+  auto stalled = connect(&e, NUM_CLIENTS + 1, false);
+  auto stalledSession = stalled->session;
+  clients.push_back(std::move(stalled));
+  size_t maxQueued = 0;
+  for (size_t round = 0; round < 20; ++round) {
+    for (auto& group : groups) {
+      wsman->addNotification("aria2.onDownloadPause", group.get());
+    }
+    for (auto& client : clients) {
+      client->session->onWriteEvent();
+    }
+    receive(*clients[0]);
+    maxQueued = std::max(maxQueued, stalledSession->getQueuedLength());
+  }
+  bench::report("stalled client queue", maxQueued / 1024.0, "KiB");
+}
+
+} // namespace aria2
+
+#endif // ENABLE_WEBSOCKET
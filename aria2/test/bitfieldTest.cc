@@ -1,5 +1,7 @@
 #include "bitfield.h"
 
+#include <vector>
+
 #include <cppunit/extensions/HelperMacros.h>
 
 #include "TimerA2.h"
@@ -13,6 +15,11 @@ class bitfieldTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testCountBit32);
   CPPUNIT_TEST(testCountSetBit);
   CPPUNIT_TEST(testLastByteMask);
+  CPPUNIT_TEST(testGetWord);
+  CPPUNIT_TEST(testFindSetBit);
+  CPPUNIT_TEST(testFindUnsetBit);
+  CPPUNIT_TEST(testFindSetBit_expr);
+  CPPUNIT_TEST(testGetFirstNSetBitIndex);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -21,6 +28,11 @@ public:
   void testCountBit32();
   void testCountSetBit();
   void testLastByteMask();
+  void testGetWord();
+  void testFindSetBit();
+  void testFindUnsetBit();
+  void testFindSetBit_expr();
+  void testGetFirstNSetBitIndex();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(bitfieldTest);
@@ -71,4 +83,117 @@ void bitfieldTest::testLastByteMask()
                        (unsigned int)bitfield::lastByteMask(16));
 }
 
+void bitfieldTest::testGetWord()
+{
+  unsigned char bitfield[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
+                              0x07, 0x08, 0xff, 0xff, 0xff};
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0x0102030405060708llu,
+                       bitfield::getWord(bitfield, 88, 0));
+  // The last word is partial, and the bits past nbits are cleared.
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0xffffff0000000000llu,
+                       bitfield::getWord(bitfield, 88, 1));
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0xfff0000000000000llu,
+                       bitfield::getWord(bitfield, 76, 1));
+}
+
+void bitfieldTest::testFindSetBit()
+{
+  std::vector<unsigned char> bitfield(25);
+  const size_t nbits = 197;
+  bitfield[0] = 0x40;
+  bitfield[8] = 0x01;
+  bitfield[24] = 0x80;
+  auto p = bitfield.data();
+  CPPUNIT_ASSERT_EQUAL((size_t)1, bitfield::findSetBit(p, nbits, 0, nbits));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, bitfield::findSetBit(p, nbits, 1, nbits));
+  CPPUNIT_ASSERT_EQUAL((size_t)71, bitfield::findSetBit(p, nbits, 2, nbits));
+  CPPUNIT_ASSERT_EQUAL((size_t)192,
+                       bitfield::findSetBit(p, nbits, 72, nbits));
+  CPPUNIT_ASSERT_EQUAL((size_t)nbits,
+                       bitfield::findSetBit(p, nbits, 193, nbits));
+  // Bounded by |to|
+  CPPUNIT_ASSERT_EQUAL((size_t)71, bitfield::findSetBit(p, nbits, 2, 71));
+  CPPUNIT_ASSERT_EQUAL((size_t)71, bitfield::findSetBit(p, nbits, 2, 72));
+  CPPUNIT_ASSERT_EQUAL((size_t)5, bitfield::findSetBit(p, nbits, 5, 5));
+  CPPUNIT_ASSERT_EQUAL((size_t)5, bitfield::findSetBit(p, nbits, 6, 5));
+  // The bits past nbits in the last byte are ignored.
+  bitfield[24] = 0x07;
+  CPPUNIT_ASSERT_EQUAL((size_t)nbits,
+                       bitfield::findSetBit(p, nbits, 72, nbits));
+
+  size_t index;
+  CPPUNIT_ASSERT(bitfield::getFirstSetBitIndex(index, p, nbits));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, index);
+  CPPUNIT_ASSERT(!bitfield::getFirstSetBitIndex(index, p, 0));
+}
+
+void bitfieldTest::testFindUnsetBit()
+{
+  std::vector<unsigned char> bitfield(25, 0xff);
+  const size_t nbits = 197;
+  bitfield[9] = 0xfe;
+  auto p = bitfield.data();
+  CPPUNIT_ASSERT_EQUAL((size_t)79, bitfield::findUnsetBit(p, nbits, 0, nbits));
+  CPPUNIT_ASSERT_EQUAL((size_t)79,
+                       bitfield::findUnsetBit(p, nbits, 79, nbits));
+  // The bits past nbits are never reported as unset.
+  CPPUNIT_ASSERT_EQUAL((size_t)nbits,
+                       bitfield::findUnsetBit(p, nbits, 80, nbits));
+  CPPUNIT_ASSERT_EQUAL((size_t)64, bitfield::findUnsetBit(p, nbits, 0, 64));
+}
+
+void bitfieldTest::testFindSetBit_expr()
+{
+  using namespace aria2::expr;
+  const size_t nbits = 150;
+  std::vector<unsigned char> have(19, 0xff), use(19), filter(19);
+  have[10] = 0xef;
+  have[17] = 0x7f;
+  use[17] = 0x80;
+  filter[10] = 0x10;
+  CPPUNIT_ASSERT_EQUAL((size_t)83,
+                       bitfield::findSetBit(~array(have.data()) &
+                                                ~array(use.data()),
+                                            nbits, 0, nbits));
+  CPPUNIT_ASSERT_EQUAL((size_t)nbits,
+                       bitfield::findSetBit(~array(have.data()) &
+                                                ~array(use.data()),
+                                            nbits, 84, nbits));
+  CPPUNIT_ASSERT_EQUAL((size_t)83,
+                       bitfield::findUnsetBit(array(have.data()) |
+                                                  array(use.data()) |
+                                                  ~array(filter.data()),
+                                              nbits, 0, nbits));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, bitfield::countSetBitSlow(
+                                      ~array(have.data()) & ~array(use.data()),
+                                      nbits));
+}
+
+void bitfieldTest::testGetFirstNSetBitIndex()
+{
+  std::vector<unsigned char> bitfield(20);
+  const size_t nbits = 153;
+  bitfield[0] = 0x81;
+  bitfield[9] = 0x20;
+  bitfield[19] = 0xff;
+  std::vector<size_t> out;
+  CPPUNIT_ASSERT_EQUAL((size_t)3, bitfield::getFirstNSetBitIndex(
+                                      std::back_inserter(out), 3,
+                                      bitfield.data(), nbits));
+  CPPUNIT_ASSERT_EQUAL((size_t)3, out.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, out[0]);
+  CPPUNIT_ASSERT_EQUAL((size_t)7, out[1]);
+  CPPUNIT_ASSERT_EQUAL((size_t)74, out[2]);
+  out.clear();
+  // Only 1 bit of the last byte is inside nbits.
+  CPPUNIT_ASSERT_EQUAL((size_t)4, bitfield::getFirstNSetBitIndex(
+                                      std::back_inserter(out), 10,
+                                      bitfield.data(), nbits));
+  CPPUNIT_ASSERT_EQUAL((size_t)152, out[3]);
+  CPPUNIT_ASSERT_EQUAL((size_t)0,
+                       bitfield::getFirstNSetBitIndex(std::back_inserter(out),
+                                                      0, bitfield.data(),
+                                                      nbits));
+}
+
 } // namespace aria2
@@ -0,0 +1,522 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "ColdRowStore.hpp"
+
+#include <til/hash.h>
+#include <til/unicode.h>
+
+#pragma warning(disable : 26446) // Prefer to use gsl::at() instead of unchecked subscript operator (bounds.4).
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+#pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
+
+// A record is laid out like this:
+//   flags       1 byte, see below
+//   columns     varint: the number of leading columns that are stored. Each of the others holds a narrow space.
+//   chars       varint: the UTF-16 length of the text of these columns, left out if the offsets are elided
+//   bytes       varint: the length of the text in bytes, only if it's UTF-8
+//   text        in Latin-1, UTF-8 or UTF-16LE
+//   offsets     per column a varint of its length in chars << 1 | its trailer bit, left out if elided
+//   runs        varint: the number of attribute runs, followed by each run's
+//     length    varint
+//     attribute varint: the index in the attribute table + 1, or 0 followed by the TextAttribute itself
+static constexpr uint8_t FlagLineRenditionMask = 0x03;
+static constexpr uint8_t FlagWrapForced = 0x04;
+static constexpr uint8_t FlagDoubleBytePadded = 0x08;
+static constexpr uint8_t FlagTextUtf8 = 0x10;
+static constexpr uint8_t FlagTextUtf16 = 0x20;
+static constexpr uint8_t FlagOffsetsElided = 0x40;
+static constexpr uint8_t FlagHyperlinks = 0x80;
+
+static void putVarint(std::vector<uint8_t>& out, uint32_t value)
+{
+    for (; value >= 0x80; value >>= 7)
+    {
+        out.push_back(gsl::narrow_cast<uint8_t>(value | 0x80));
+    }
+    out.push_back(gsl::narrow_cast<uint8_t>(value));
+}
+
+static uint32_t getVarint(const uint8_t*& in) noexcept
+{
+    uint32_t value = 0;
+    for (uint32_t shift = 0;; shift += 7)
+    {
+        const auto b = *in++;
+        value |= static_cast<uint32_t>(b & 0x7f) << shift;
+        if (b < 0x80)
+        {
+            return value;
+        }
+    }
+}
+
+size_t ColdRowStore::AttributeHash::operator()(const TextAttribute& attr) const noexcept
+{
+    // TextAttribute compares with memcmp(), so hashing its bytes is consistent with operator==.
+    return til::hash(&attr, sizeof(attr));
+}
+
+// Encodes the given row, unless it still has the record it was decoded from, and marks it as cold.
+// The caller destroys the ROW afterwards. rowCount is the number of rows of the memory arena.
+void ColdRowStore::Freeze(size_t offset, size_t rowCount, const ROW& row)
+{
+    if (_rows.empty())
+    {
+        _rows.resize(rowCount);
+    }
+
+    auto& slot = til::at(_rows, offset);
+    if (slot.cold)
+    {
+        return;
+    }
+    if (!slot.length)
+    {
+        _encode(row);
+        _append(slot);
+    }
+    slot.cold = true;
+    _coldRowCount++;
+}
+
+// Decodes the record of the given row into `row`, which must have the width of the encoded row.
+// Its previous contents are overwritten. The record is kept for the next Freeze().
+void ColdRowStore::Thaw(size_t offset, ROW& row)
+{
+    Decode(offset, row);
+
+    auto& slot = til::at(_rows, offset);
+    if (slot.cold)
+    {
+        slot.cold = false;
+        _coldRowCount--;
+    }
+}
+
+// Like Thaw(), but the row stays cold. This allows reading a cold row through a scratch ROW.
+void ColdRowStore::Decode(size_t offset, ROW& row) const
+{
+    const auto& slot = til::at(_rows, offset);
+    auto in = _record(slot);
+
+    const auto flags = *in++;
+    const auto columnCount = row._columnCount;
+    const auto columns = getVarint(in);
+    const auto elided = WI_IsFlagSet(flags, FlagOffsetsElided);
+    const auto prefixChars = elided ? columns : getVarint(in);
+    const size_t charCount = prefixChars + (columnCount - columns);
+
+    row._charsHeap.reset();
+    row._chars = { row._charsBuffer, columnCount };
+    if (charCount > columnCount)
+    {
+        auto charsHeap = std::make_unique_for_overwrite<wchar_t[]>(charCount);
+        row._chars = { charsHeap.get(), charCount };
+        row._charsHeap = std::move(charsHeap);
+    }
+
+    const auto chars = row._chars.data();
+    if (WI_IsFlagSet(flags, FlagTextUtf8))
+    {
+        const auto bytes = getVarint(in);
+        // The transcoder needs room for as many chars as there are bytes.
+        if (bytes <= row._chars.size())
+        {
+            til::details::u8u16_transcode(reinterpret_cast<const char*>(in), bytes, chars);
+        }
+        else
+        {
+            _scratchChars.resize(bytes);
+            til::details::u8u16_transcode(reinterpret_cast<const char*>(in), bytes, _scratchChars.data());
+            std::copy_n(_scratchChars.data(), prefixChars, chars);
+        }
+        in += bytes;
+    }
+    else if (WI_IsFlagSet(flags, FlagTextUtf16))
+    {
+        for (size_t i = 0; i < prefixChars; ++i, in += 2)
+        {
+            chars[i] = static_cast<wchar_t>(in[0] | in[1] << 8);
+        }
+    }
+    else
+    {
+        std::copy_n(in, prefixChars, chars);
+        in += prefixChars;
+    }
+    std::fill_n(chars + prefixChars, columnCount - columns, L' ');
+
+    const auto charOffsets = row._charOffsets.data();
+    uint16_t charOffset = 0;
+    if (!elided)
+    {
+        for (uint32_t column = 0; column < columns; ++column)
+        {
+            const auto value = getVarint(in);
+            charOffsets[column] = charOffset | (value & 1 ? ROW::CharOffsetsTrailer : 0);
+            charOffset = gsl::narrow_cast<uint16_t>(charOffset + (value >> 1));
+        }
+    }
+    // When the offsets are elided, this is all there's to them.
+    std::iota(charOffsets + (elided ? 0 : columns), charOffsets + columnCount + 1, charOffset);
+
+    auto& runs = row._attr.runs();
+    const auto runCount = getVarint(in);
+    runs.clear();
+    for (uint32_t i = 0; i < runCount; ++i)
+    {
+        const auto length = gsl::narrow_cast<uint16_t>(getVarint(in));
+        const auto index = getVarint(in);
+        if (index)
+        {
+            runs.emplace_back(til::at(_attributes, index - 1), length);
+        }
+        else
+        {
+            TextAttribute attr;
+            memcpy(&attr, in, sizeof(attr));
+            in += sizeof(attr);
+            runs.emplace_back(attr, length);
+        }
+    }
+
+    row._lineRendition = static_cast<LineRendition>(flags & FlagLineRenditionMask);
+    row._wrapForced = WI_IsFlagSet(flags, FlagWrapForced);
+    row._doubleBytePadded = WI_IsFlagSet(flags, FlagDoubleBytePadded);
+}
+
+// Returns the hyperlink IDs a cold row refers to, without decoding it.
+std::vector<uint16_t> ColdRowStore::GetHyperlinks(size_t offset) const
+{
+    std::vector<uint16_t> ids;
+    const auto& slot = til::at(_rows, offset);
+    auto in = _record(slot);
+
+    const auto flags = *in++;
+    if (WI_IsFlagClear(flags, FlagHyperlinks))
+    {
+        return ids;
+    }
+
+    const auto columns = getVarint(in);
+    const auto elided = WI_IsFlagSet(flags, FlagOffsetsElided);
+    const auto prefixChars = elided ? columns : getVarint(in);
+    if (WI_IsFlagSet(flags, FlagTextUtf8))
+    {
+        const auto bytes = getVarint(in);
+        in += bytes;
+    }
+    else
+    {
+        in += WI_IsFlagSet(flags, FlagTextUtf16) ? prefixChars * 2 : prefixChars;
+    }
+    if (!elided)
+    {
+        for (uint32_t column = 0; column < columns; ++column)
+        {
+            getVarint(in);
+        }
+    }
+
+    const auto runCount = getVarint(in);
+    for (uint32_t i = 0; i < runCount; ++i)
+    {
+        getVarint(in);
+        const auto index = getVarint(in);
+        TextAttribute attr;
+        if (index)
+        {
+            attr = til::at(_attributes, index - 1);
+        }
+        else
+        {
+            memcpy(&attr, in, sizeof(attr));
+            in += sizeof(attr);
+        }
+        if (attr.IsHyperlink())
+        {
+            ids.emplace_back(attr.GetHyperlinkId());
+        }
+    }
+    return ids;
+}
+
+void ColdRowStore::Clear() noexcept
+{
+    _rows = {};
+    _chunks.clear();
+    _chunks.shrink_to_fit();
+    _freeChunks = {};
+    _currentChunk = 0;
+    _coldRowCount = 0;
+    _attributes = {};
+    _attributeIndices = {};
+}
+
+size_t ColdRowStore::ColdRowCount() const noexcept
+{
+    return _coldRowCount;
+}
+
+// Returns the number of bytes held by the records and the tables describing them.
+size_t ColdRowStore::MemoryUsage() const noexcept
+{
+    auto bytes = _rows.capacity() * sizeof(Slot) + _chunks.capacity() * sizeof(Chunk) + _attributes.capacity() * sizeof(TextAttribute);
+    for (const auto& chunk : _chunks)
+    {
+        bytes += chunk.capacity;
+    }
+    // Roughly what the nodes and buckets of an unordered_map cost.
+    bytes += _attributeIndices.size() * (sizeof(TextAttribute) + sizeof(uint32_t) + 2 * sizeof(void*));
+    bytes += _attributeIndices.bucket_count() * sizeof(void*);
+    return bytes;
+}
+
+void ColdRowStore::_discard(size_t offset) noexcept
+{
+    auto& slot = _rows[offset];
+    const auto index = slot.location >> 16;
+    auto& chunk = _chunks[index];
+
+    chunk.live -= slot.length;
+    if (!chunk.live)
+    {
+        if (index == _currentChunk)
+        {
+            chunk.used = 0;
+        }
+        else
+        {
+            _freeChunk(index);
+        }
+    }
+
+    if (slot.cold)
+    {
+        _coldRowCount--;
+    }
+    slot = {};
+}
+
+void ColdRowStore::_encode(const ROW& row)
+{
+    const auto columnCount = row._columnCount;
+    const auto chars = row._chars.data();
+    const auto charOffsets = row._charOffsets.data();
+    const auto charCount = row._charSize();
+
+    // Columns at the end that hold a narrow space each aren't stored.
+    // Their offsets are 1 apart and end at charCount.
+    auto columns = columnCount;
+    for (; columns > 0; --columns)
+    {
+        const auto column = columns - 1;
+        const auto charOffset = charOffsets[column];
+        if (charOffset + (columnCount - column) != charCount || chars[charOffset] != L' ')
+        {
+            break;
+        }
+    }
+
+    const auto prefixChars = charOffsets[columns] & ROW::CharOffsetsMask;
+    auto elided = prefixChars == columns;
+    for (uint16_t column = 0; elided && column < columns; ++column)
+    {
+        elided = charOffsets[column] == column;
+    }
+
+    // Latin-1 if possible, UTF-8 otherwise, unless there are unpaired surrogates which UTF-8 can't represent.
+    wchar_t bits = 0;
+    size_t utf8Bytes = 0;
+    auto pairedSurrogates = true;
+    for (uint16_t i = 0; i < prefixChars; ++i)
+    {
+        const auto ch = chars[i];
+        bits |= ch;
+        if (ch < 0x80)
+        {
+            utf8Bytes += 1;
+        }
+        else if (ch < 0x800)
+        {
+            utf8Bytes += 2;
+        }
+        else if (til::is_leading_surrogate(ch) && i + 1 < prefixChars && til::is_trailing_surrogate(chars[i + 1]))
+        {
+            utf8Bytes += 4;
+            ++i;
+        }
+        else
+        {
+            pairedSurrogates &= !til::is_surrogate(ch);
+            utf8Bytes += 3;
+        }
+    }
+
+    uint8_t flags = static_cast<uint8_t>(row._lineRendition) & FlagLineRenditionMask;
+    WI_SetFlagIf(flags, FlagWrapForced, row._wrapForced);
+    WI_SetFlagIf(flags, FlagDoubleBytePadded, row._doubleBytePadded);
+    WI_SetFlagIf(flags, FlagOffsetsElided, elided);
+    if (static_cast<uint32_t>(bits) >= 0x100)
+    {
+        WI_SetFlag(flags, pairedSurrogates ? FlagTextUtf8 : FlagTextUtf16);
+    }
+
+    _scratch.clear();
+    _scratch.push_back(flags);
+    putVarint(_scratch, columns);
+    if (!elided)
+    {
+        putVarint(_scratch, prefixChars);
+    }
+
+    if (WI_IsFlagSet(flags, FlagTextUtf8))
+    {
+        putVarint(_scratch, gsl::narrow_cast<uint32_t>(utf8Bytes));
+        for (uint16_t i = 0; i < prefixChars; ++i)
+        {
+            const auto ch = chars[i];
+            uint32_t cp = static_cast<char16_t>(ch);
+            if (til::is_leading_surrogate(ch) && i + 1 < prefixChars && til::is_trailing_surrogate(chars[i + 1]))
+            {
+                cp = 0x10000 + ((cp & 0x3FF) << 10 | (static_cast<char16_t>(chars[i + 1]) & 0x3FF));
+                ++i;
+            }
+            if (cp < 0x80)
+            {
+                _scratch.push_back(gsl::narrow_cast<uint8_t>(cp));
+            }
+            else if (cp < 0x800)
+            {
+                _scratch.push_back(gsl::narrow_cast<uint8_t>(0xC0 | (cp >> 6)));
+                _scratch.push_back(gsl::narrow_cast<uint8_t>(0x80 | (cp & 0x3F)));
+            }
+            else if (cp < 0x10000)
+            {
+                _scratch.push_back(gsl::narrow_cast<uint8_t>(0xE0 | (cp >> 12)));
+                _scratch.push_back(gsl::narrow_cast<uint8_t>(0x80 | ((cp >> 6) & 0x3F)));
+                _scratch.push_back(gsl::narrow_cast<uint8_t>(0x80 | (cp & 0x3F)));
+            }
+            else
+            {
+                _scratch.push_back(gsl::narrow_cast<uint8_t>(0xF0 | (cp >> 18)));
+                _scratch.push_back(gsl::narrow_cast<uint8_t>(0x80 | ((cp >> 12) & 0x3F)));
+                _scratch.push_back(gsl::narrow_cast<uint8_t>(0x80 | ((cp >> 6) & 0x3F)));
+                _scratch.push_back(gsl::narrow_cast<uint8_t>(0x80 | (cp & 0x3F)));
+            }
+        }
+    }
+    else if (WI_IsFlagSet(flags, FlagTextUtf16))
+    {
+        for (uint16_t i = 0; i < prefixChars; ++i)
+        {
+            const auto ch = static_cast<char16_t>(chars[i]);
+            _scratch.push_back(gsl::narrow_cast<uint8_t>(ch));
+            _scratch.push_back(gsl::narrow_cast<uint8_t>(ch >> 8));
+        }
+    }
+    else
+    {
+        for (uint16_t i = 0; i < prefixChars; ++i)
+        {
+            _scratch.push_back(gsl::narrow_cast<uint8_t>(chars[i]));
+        }
+    }
+
+    if (!elided)
+    {
+        for (uint16_t column = 0; column < columns; ++column)
+        {
+            const auto charOffset = charOffsets[column];
+            const auto nextCharOffset = charOffsets[column + 1] & ROW::CharOffsetsMask;
+            const auto length = nextCharOffset - (charOffset & ROW::CharOffsetsMask);
+            putVarint(_scratch, gsl::narrow_cast<uint32_t>(length << 1 | (WI_IsFlagSet(charOffset, ROW::CharOffsetsTrailer) ? 1 : 0)));
+        }
+    }
+
+    const auto& runs = row._attr.runs();
+    putVarint(_scratch, gsl::narrow_cast<uint32_t>(runs.size()));
+    for (const auto& run : runs)
+    {
+        putVarint(_scratch, run.length);
+        WI_SetFlagIf(_scratch[0], FlagHyperlinks, run.value.IsHyperlink());
+
+        if (const auto it = _attributeIndices.find(run.value); it != _attributeIndices.end())
+        {
+            putVarint(_scratch, it->second + 1);
+        }
+        else if (_attributes.size() < _attributeTableLimit)
+        {
+            const auto index = gsl::narrow_cast<uint32_t>(_attributes.size());
+            _attributes.emplace_back(run.value);
+            _attributeIndices.emplace(run.value, index);
+            putVarint(_scratch, index + 1);
+        }
+        else
+        {
+            putVarint(_scratch, 0);
+            const auto bytes = reinterpret_cast<const uint8_t*>(&run.value);
+            _scratch.insert(_scratch.end(), bytes, bytes + sizeof(TextAttribute));
+        }
+    }
+}
+
+const uint8_t* ColdRowStore::_record(const Slot& slot) const noexcept
+{
+    return _chunks[slot.location >> 16].data.get() + (slot.location & 0xffff);
+}
+
+// Appends the record in _scratch to the current chunk and points the slot at it.
+void ColdRowStore::_append(Slot& slot)
+{
+    const auto length = gsl::narrow<uint32_t>(_scratch.size());
+    auto index = _currentChunk;
+
+    if (_chunks.empty() || _chunks[index].capacity - _chunks[index].used < length)
+    {
+        if (_freeChunks.empty())
+        {
+            // The chunk index has to fit into the upper 16 bits of Slot::location.
+            THROW_HR_IF(E_OUTOFMEMORY, _chunks.size() > 0xffff);
+            index = gsl::narrow_cast<uint32_t>(_chunks.size());
+            _chunks.emplace_back();
+            _freeChunks.reserve(_chunks.size());
+        }
+        else
+        {
+            index = _freeChunks.back();
+            _freeChunks.pop_back();
+        }
+
+        // Records larger than a chunk get a chunk of their own. Since they start at offset 0,
+        // their location still fits. The current chunk stays the one to append to.
+        const auto capacity = std::max(_chunkSize, length);
+        auto& chunk = _chunks[index];
+        chunk.data = std::make_unique_for_overwrite<uint8_t[]>(capacity);
+        chunk.capacity = capacity;
+        chunk.used = 0;
+        chunk.live = 0;
+
+        if (capacity == _chunkSize)
+        {
+            _currentChunk = index;
+        }
+    }
+
+    auto& chunk = _chunks[index];
+    memcpy(chunk.data.get() + chunk.used, _scratch.data(), length);
+    slot.location = index << 16 | chunk.used;
+    slot.length = length;
+    chunk.used += length;
+    chunk.live += length;
+}
+
+void ColdRowStore::_freeChunk(uint32_t index) noexcept
+{
+    auto& chunk = _chunks[index];
+    chunk = {};
+    // _freeChunks is reserved to hold every chunk, so that this can't throw.
+    _freeChunks.push_back(index);
+}
@@ -0,0 +1,105 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- ColdRowStore.hpp
+
+Abstract:
+- Holds the compressed copies of the ROWs of a TextBuffer that scrolled far
+  out of the mutable viewport ("cold" rows), indexed by their offset in the
+  TextBuffer's memory arena.
+- A row is encoded as its text in Latin-1 or UTF-8 (UTF-16 only if it has
+  unpaired surrogates), without the trailing blank columns. The column to
+  text offsets are left out if every column holds 1 narrow character, and
+  the attribute runs refer to a table of the distinct attributes of the
+  buffer. The records are appended to 64KiB chunks, which are freed once all
+  records in them are released. Most rows cost a few bytes plus their text.
+- A row that is decoded ("thawed") keeps its record, so that freezing it
+  again is free, until it's modified.
+--*/
+
+#pragma once
+
+#include "Row.hpp"
+
+class ColdRowStore final
+{
+public:
+    bool IsCold(size_t offset) const noexcept
+    {
+        return offset < _rows.size() && _rows[offset].cold;
+    }
+
+    bool HasRecord(size_t offset) const noexcept
+    {
+        return offset < _rows.size() && _rows[offset].length != 0;
+    }
+
+    // Drops the record of the given row, if it has one, because the row is about to be modified or
+    // reset. A cold row is thereby forgotten and the caller is responsible for constructing it anew.
+    void Discard(size_t offset) noexcept
+    {
+        if (HasRecord(offset))
+        {
+            _discard(offset);
+        }
+    }
+
+    void Freeze(size_t offset, size_t rowCount, const ROW& row);
+    void Thaw(size_t offset, ROW& row);
+    void Decode(size_t offset, ROW& row) const;
+    std::vector<uint16_t> GetHyperlinks(size_t offset) const;
+
+    void Clear() noexcept;
+    size_t ColdRowCount() const noexcept;
+    size_t MemoryUsage() const noexcept;
+
+private:
+    struct Slot
+    {
+        // The chunk index in the upper and the byte offset in the lower 16 bits.
+        uint32_t location = 0;
+        // The length of the record in bytes, 0 if there's none.
+        uint32_t length = 0;
+        // Set if the ROW has been destroyed and only the record remains.
+        bool cold = false;
+    };
+
+    struct Chunk
+    {
+        std::unique_ptr<uint8_t[]> data;
+        uint32_t capacity = 0;
+        uint32_t used = 0;
+        // The bytes of records that haven't been released yet.
+        uint32_t live = 0;
+    };
+
+    struct AttributeHash
+    {
+        size_t operator()(const TextAttribute& attr) const noexcept;
+    };
+
+    static constexpr uint32_t _chunkSize = 64 * 1024;
+    // Beyond this many distinct attributes (true color art, mostly) they're stored inline.
+    static constexpr uint32_t _attributeTableLimit = 16 * 1024;
+
+    void _discard(size_t offset) noexcept;
+    void _encode(const ROW& row);
+    const uint8_t* _record(const Slot& slot) const noexcept;
+    void _append(Slot& slot);
+    void _freeChunk(uint32_t index) noexcept;
+
+    std::vector<Slot> _rows;
+    std::vector<Chunk> _chunks;
+    std::vector<uint32_t> _freeChunks;
+    uint32_t _currentChunk = 0;
+    size_t _coldRowCount = 0;
+
+    std::vector<TextAttribute> _attributes;
+    std::unordered_map<TextAttribute, uint32_t, AttributeHash> _attributeIndices;
+
+    // Reused by _encode() and Decode().
+    std::vector<uint8_t> _scratch;
+    mutable std::vector<wchar_t> _scratchChars;
+};
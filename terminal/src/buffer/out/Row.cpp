@@ -254,7 +254,11 @@ void ROW::_init() noexcept
 
     // Fills _charsBuffer with whitespace and correspondingly _charOffsets
     // with successive numbers from 0 to _columnCount+1.
-#if defined(TIL_SSE_INTRINSICS)
+#if WCHAR_MAX > 0xFFFF
+    // The vectorized code below writes 2 byte wchar_t. Where wchar_t is wider, as in the portable build, the fill is left to the compiler.
+    std::fill_n(_charsBuffer, _columnCount, UNICODE_SPACE);
+    std::iota(_charOffsets.begin(), _charOffsets.end(), uint16_t{ 0 });
+#elif defined(TIL_SSE_INTRINSICS)
     alignas(__m256i) static constexpr uint16_t whitespaceData[]{ 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20 };
     alignas(__m256i) static constexpr uint16_t offsetsData[]{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
     alignas(__m256i) static constexpr uint16_t increment16Data[]{ 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16 };
@@ -1009,6 +1013,13 @@ bool ROW::ContainsText() const noexcept
     return false;
 }
 
+// Returns true if any of the glyphs in this row is 2 columns wide.
+bool ROW::ContainsWideGlyph() const noexcept
+{
+    const auto offsets = _charOffsets.first(_columnCount);
+    return std::any_of(offsets.begin(), offsets.end(), [](const uint16_t offset) { return (offset & CharOffsetsTrailer) != 0; });
+}
+
 std::wstring_view ROW::GlyphAt(til::CoordType column) const noexcept
 {
     auto col = _clampedColumn(column);
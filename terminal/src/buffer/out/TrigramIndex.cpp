@@ -0,0 +1,137 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "TrigramIndex.hpp"
+
+#include <icu.h>
+
+#pragma warning(disable : 26446) // Prefer to use gsl::at() instead of unchecked subscript operator (bounds.4).
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+#pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
+
+// Prepares the index for a buffer with the given number of rows. All blocks start out dirty.
+void TrigramIndex::Reset(size_t rowCount)
+{
+    const auto blockCount = (rowCount + BlockSize - 1) / BlockSize;
+    _rowCount = rowCount;
+    _bits.assign(blockCount * _blockWords, 0);
+    _dirty.assign(blockCount, true);
+}
+
+// Drops the index. Invalidate() does nothing until the next Reset().
+void TrigramIndex::Clear() noexcept
+{
+    _rowCount = 0;
+    _bits = {};
+    _dirty = {};
+}
+
+size_t TrigramIndex::RowCount() const noexcept
+{
+    return _rowCount;
+}
+
+size_t TrigramIndex::BlockCount() const noexcept
+{
+    return _dirty.size();
+}
+
+bool TrigramIndex::IsDirty(size_t block) const noexcept
+{
+    return _dirty[block];
+}
+
+// Replaces the trigrams of the given block with those of `text`, which is the case folded text of its rows
+// followed by the first 2 code units of the (case folded) row after it.
+void TrigramIndex::SetBlock(size_t block, std::u16string_view text)
+{
+    const auto bits = _bits.data() + block * _blockWords;
+    std::fill_n(bits, _blockWords, 0);
+    for (size_t i = 2; i < text.size(); ++i)
+    {
+        const auto hash = _hash(text[i - 2], text[i - 1], text[i]);
+        bits[hash / 64] |= uint64_t{ 1 } << (hash % 64);
+    }
+    _dirty[block] = false;
+}
+
+// Returns the blocks in which a match of the case folded, at least 3 code units long needle may start.
+// The match must not span more than 2 blocks, which is up to the caller to ensure.
+std::vector<size_t> TrigramIndex::FindBlocks(std::u16string_view needle) const
+{
+    std::vector<size_t> hashes;
+    for (size_t i = 2; i < needle.size(); ++i)
+    {
+        hashes.emplace_back(_hash(needle[i - 2], needle[i - 1], needle[i]));
+    }
+    const auto first = hashes.front();
+    std::sort(hashes.begin(), hashes.end());
+    hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+
+    std::vector<size_t> blocks;
+    const auto blockCount = _dirty.size();
+    for (size_t block = 0; block < blockCount; ++block)
+    {
+        // The match starts in this block and continues into the next one at most.
+        if (!_contains(block, first))
+        {
+            continue;
+        }
+        const auto next = (block + 1) % blockCount;
+        if (std::all_of(hashes.begin(), hashes.end(), [&](const size_t hash) { return _contains(block, hash) || _contains(next, hash); }))
+        {
+            blocks.emplace_back(block);
+        }
+    }
+    return blocks;
+}
+
+size_t TrigramIndex::MemoryUsage() const noexcept
+{
+    return _bits.capacity() * sizeof(uint64_t) + _dirty.capacity() / 8;
+}
+
+// Appends the full case folding of `text` to `out`, the same one ICU uses for case insensitive matching.
+void TrigramIndex::Fold(std::wstring_view text, std::u16string& out)
+{
+    const auto ascii = std::all_of(text.begin(), text.end(), [](const wchar_t ch) { return ch < 0x80; });
+    if (ascii)
+    {
+        for (const auto ch : text)
+        {
+            out.push_back(static_cast<char16_t>(ch >= L'A' && ch <= L'Z' ? ch + 0x20 : ch));
+        }
+        return;
+    }
+
+#if WCHAR_MAX > 0xFFFF
+    const std::u16string source{ text.begin(), text.end() };
+    const auto src = source.data();
+#else
+    const auto src = reinterpret_cast<const UChar*>(text.data());
+#endif
+    const auto length = gsl::narrow<int32_t>(text.size());
+    const auto offset = out.size();
+
+    // Full case folding expands a code point into 3 at most.
+    out.resize(offset + text.size() * 3);
+    UErrorCode status = U_ZERO_ERROR;
+    const auto written = u_strFoldCase(reinterpret_cast<UChar*>(out.data() + offset), gsl::narrow<int32_t>(text.size() * 3), src, length, U_FOLD_CASE_DEFAULT, &status);
+    THROW_HR_IF(E_UNEXPECTED, U_FAILURE(status));
+    out.resize(offset + gsl::narrow_cast<size_t>(written));
+}
+
+// Returns the index of the bit of the trigram in the bitmap of a block.
+size_t TrigramIndex::_hash(char16_t a, char16_t b, char16_t c) noexcept
+{
+    // The top 12 bits of the product are the best ones of this multiplicative hash.
+    static_assert(BlockBits == 1 << 12);
+    const auto key = static_cast<uint64_t>(a) << 32 | static_cast<uint64_t>(b) << 16 | c;
+    return gsl::narrow_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 52);
+}
+
+bool TrigramIndex::_contains(size_t block, size_t hash) const noexcept
+{
+    return (_bits[block * _blockWords + hash / 64] >> (hash % 64)) & 1;
+}
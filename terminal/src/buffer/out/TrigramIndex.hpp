@@ -0,0 +1,66 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- TrigramIndex.hpp
+
+Abstract:
+- An index of the trigrams (3 consecutive UTF-16 code units) of the text of a
+  TextBuffer, which TextBuffer::SearchText() uses to find the rows that may
+  contain a needle, instead of scanning all of them.
+- The rows are grouped into blocks of BlockSize rows by their offset in the
+  memory arena, and each block stores a bitmap of the hashes of the trigrams
+  that start in its rows. Like a bloom filter it may report trigrams that
+  aren't there, but never misses one. The text is case folded first, so that
+  the index serves both case sensitive and insensitive searches. A modified
+  row marks its block as dirty, and dirty blocks are rebuilt by the next search.
+- A trigram that starts at the end of a row continues into the next row in
+  the arena. Together with the assumption that a match spans 2 blocks at most,
+  this makes sure that matches across rows are found too.
+--*/
+
+#pragma once
+
+class TrigramIndex final
+{
+public:
+    static constexpr size_t BlockSize = 16;
+    // The bits of the bitmap of each block. At 32 bytes per row this is a small fraction of
+    // the memory of the rows, and the bitmap of a block of 16 rows of 120 columns of text
+    // stays sparse enough for the trigrams of a needle to rule out most blocks.
+    static constexpr size_t BlockBits = 4096;
+
+    // Marks the block of the given row as dirty, as well as the one of the row before it,
+    // whose trigrams at its end depend on the text of this row.
+    void Invalidate(size_t row) noexcept
+    {
+        if (row < _rowCount)
+        {
+            _dirty[row / BlockSize] = true;
+            _dirty[(row ? row - 1 : _rowCount - 1) / BlockSize] = true;
+        }
+    }
+
+    void Reset(size_t rowCount);
+    void Clear() noexcept;
+    size_t RowCount() const noexcept;
+    size_t BlockCount() const noexcept;
+    bool IsDirty(size_t block) const noexcept;
+    void SetBlock(size_t block, std::u16string_view text);
+    std::vector<size_t> FindBlocks(std::u16string_view needle) const;
+    size_t MemoryUsage() const noexcept;
+
+    static void Fold(std::wstring_view text, std::u16string& out);
+
+private:
+    static constexpr size_t _blockWords = BlockBits / 64;
+
+    static size_t _hash(char16_t a, char16_t b, char16_t c) noexcept;
+    bool _contains(size_t block, size_t hash) const noexcept;
+
+    size_t _rowCount = 0;
+    // The bitmaps of all blocks, _blockWords per block.
+    std::vector<uint64_t> _bits;
+    std::vector<bool> _dirty;
+};
@@ -27,6 +27,34 @@ constexpr til::CoordType& accessCurrentRow(UText* ut) noexcept
     return ut->b;
 }
 
+#if WCHAR_MAX > 0xFFFF
+// Where wchar_t is 32 bits wide (the portable build), the rows hold UTF-16 code units in 32-bit units,
+// and ICU needs copies of them as char16_t. The copies live in a small ring per thread, so that a UText
+// and its clone can each hold on to a chunk. Chunks are only valid until the next few accesses, which is
+// why UTextFromTextBuffer doesn't claim UTEXT_PROVIDER_STABLE_CHUNKS in that case.
+struct ConvertedChunks
+{
+    std::array<std::u16string, 4> chunks;
+    size_t next = 0;
+};
+
+static thread_local ConvertedChunks convertedChunks;
+
+static const char16_t* chunkContents(const std::wstring_view& text)
+{
+    auto& chunk = convertedChunks.chunks[convertedChunks.next];
+    convertedChunks.next = (convertedChunks.next + 1) % convertedChunks.chunks.size();
+    chunk.assign(text.begin(), text.end());
+    return chunk.data();
+}
+#else
+static const char16_t* chunkContents(const std::wstring_view& text) noexcept
+{
+#pragma warning(suppress : 26490) // Don't use reinterpret_cast (type.1).
+    return reinterpret_cast<const char16_t*>(text.data());
+}
+#endif
+
 // An excerpt from the ICU documentation:
 //
 // Clone a UText. Much like opening a UText where the source text is itself another UText.
@@ -58,7 +86,11 @@ static UText* U_CALLCONV utextClone(UText* dest, const UText* src, UBool deep, U
     dest = utext_setup(dest, 0, status);
     if (*status <= U_ZERO_ERROR)
     {
+        // utext_setup() sets the flags that tell utext_close() to free the clone. Copying the ones of the
+        // (stack allocated) source over them would leak it, which adds up once a search runs many regexes.
+        const auto flags = dest->flags;
         memcpy(dest, src, sizeof(UText));
+        dest->flags = flags;
     }
 
     return dest;
@@ -166,8 +198,7 @@ try
         ut->chunkNativeStart = start;
         ut->chunkNativeLimit = limit;
         ut->chunkLength = gsl::narrow_cast<int32_t>(text.size());
-#pragma warning(suppress : 26490) // Don't use reinterpret_cast (type.1).
-        ut->chunkContents = reinterpret_cast<const char16_t*>(text.data());
+        ut->chunkContents = chunkContents(text);
         ut->nativeIndexingLimit = ut->chunkLength;
     }
 
@@ -239,7 +270,7 @@ try
     const auto destCapacitySizeT = gsl::narrow_cast<size_t>(destCapacity);
     const auto length = std::min(destCapacitySizeT, text.size());
 
-    memcpy(dest, text.data(), length * sizeof(char16_t));
+    std::copy_n(text.data(), length, dest);
 
     if (length < destCapacitySizeT)
     {
@@ -268,7 +299,11 @@ UText Microsoft::Console::ICU::UTextFromTextBuffer(const TextBuffer& textBuffer,
 {
 #pragma warning(suppress : 26477) // Use 'nullptr' rather than 0 or NULL (es.47).
     UText ut = UTEXT_INITIALIZER;
+#if WCHAR_MAX > 0xFFFF
+    ut.providerProperties = 1 << UTEXT_PROVIDER_LENGTH_IS_EXPENSIVE;
+#else
     ut.providerProperties = (1 << UTEXT_PROVIDER_LENGTH_IS_EXPENSIVE) | (1 << UTEXT_PROVIDER_STABLE_CHUNKS);
+#endif
     ut.pFuncs = &utextFuncs;
     ut.context = &textBuffer;
     accessCurrentRow(&ut) = rowBeg - 1; // the utextAccess() below will advance this by 1.
@@ -280,8 +315,13 @@ UText Microsoft::Console::ICU::UTextFromTextBuffer(const TextBuffer& textBuffer,
 
 Microsoft::Console::ICU::unique_uregex Microsoft::Console::ICU::CreateRegex(const std::wstring_view& pattern, uint32_t flags, UErrorCode* status) noexcept
 {
+#if WCHAR_MAX > 0xFFFF
+    const std::u16string converted{ pattern.begin(), pattern.end() };
+    const auto re = uregex_open(converted.data(), gsl::narrow_cast<int32_t>(converted.size()), flags, nullptr, status);
+#else
 #pragma warning(suppress : 26490) // Don't use reinterpret_cast (type.1).
     const auto re = uregex_open(reinterpret_cast<const char16_t*>(pattern.data()), gsl::narrow_cast<int32_t>(pattern.size()), flags, nullptr, status);
+#endif
     // ICU describes the time unit as being dependent on CPU performance and "typically [in] the order of milliseconds",
     // but this claim seems highly outdated already. On my CPU from 2021, a limit of 4096 equals roughly 600ms.
     uregex_setTimeLimit(re, 4096, status);
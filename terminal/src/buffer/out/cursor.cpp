@@ -3,7 +3,7 @@
 
 #include "precomp.h"
 #include "cursor.h"
-#include "TextBuffer.hpp"
+#include "textBuffer.hpp"
 
 #pragma hdrstop
 
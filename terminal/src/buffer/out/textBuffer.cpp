@@ -33,6 +33,23 @@ constexpr bool allWhitespace(const std::wstring_view& text) noexcept
 
 static std::atomic<uint64_t> s_lastMutationIdInitialValue;
 
+// Appends the matches of the (literal) regex in the rows [rowBeg,rowEnd) to `results`.
+static void findMatches(const TextBuffer& textBuffer, URegularExpression* re, til::CoordType rowBeg, til::CoordType rowEnd, std::vector<til::point_span>& results)
+{
+    auto text = ICU::UTextFromTextBuffer(textBuffer, rowBeg, rowEnd);
+
+    UErrorCode status = U_ZERO_ERROR;
+    uregex_setUText(re, &text, &status);
+
+    if (uregex_find(re, -1, &status))
+    {
+        do
+        {
+            results.emplace_back(ICU::BufferRangeFromMatch(&text, re));
+        } while (uregex_findNext(re, &status));
+    }
+}
+
 // Routine Description:
 // - Creates a new instance of TextBuffer
 // Arguments:
@@ -118,6 +135,31 @@ void TextBuffer::_reserve(til::size screenBufferSize, const TextAttribute& defau
     _height = h;
 }
 
+// Exchanges the rows of this buffer, and everything that describes them, with those of `other`.
+// NOTE: Keep this in sync with _reserve().
+void TextBuffer::_swapRows(TextBuffer& other) noexcept
+{
+    std::swap(_buffer, other._buffer);
+    std::swap(_bufferEnd, other._bufferEnd);
+    std::swap(_commitWatermark, other._commitWatermark);
+    std::swap(_initialAttributes, other._initialAttributes);
+    std::swap(_bufferRowStride, other._bufferRowStride);
+    std::swap(_bufferOffsetChars, other._bufferOffsetChars);
+    std::swap(_bufferOffsetCharOffsets, other._bufferOffsetCharOffsets);
+    std::swap(_width, other._width);
+    std::swap(_height, other._height);
+    std::swap(_firstRow, other._firstRow);
+    std::swap(_coldRows, other._coldRows);
+    std::swap(_thawedRows, other._thawedRows);
+    std::swap(_frozenLimit, other._frozenLimit);
+    std::swap(_decommittedPages, other._decommittedPages);
+    std::swap(_coldRowTicks, other._coldRowTicks);
+    std::swap(_searchIndex, other._searchIndex);
+    std::swap(_reflowSource, other._reflowSource);
+    std::swap(_pendingReflowRows, other._pendingReflowRows);
+    std::swap(_pendingReflowRowCount, other._pendingReflowRowCount);
+}
+
 // MEM_COMMITs the memory and constructs all ROWs up to and including the given row pointer.
 // It's expected that the caller verifies the parameter. It goes hand in hand with _getRowByOffsetDirect().
 //
@@ -144,6 +186,9 @@ void TextBuffer::_decommit() noexcept
     _destroy();
     VirtualFree(_buffer.get(), 0, MEM_DECOMMIT);
     _commitWatermark = _buffer.get();
+    _resetColdRows();
+    _searchIndex.Clear();
+    _resetReflow();
 }
 
 // Constructs ROWs up to (excluding) the ROW pointed to by `until`.
@@ -162,9 +207,14 @@ void TextBuffer::_construct(const std::byte* until) noexcept
 // Be careful! This doesn't reset any of the members, in particular the _commitWatermark.
 void TextBuffer::_destroy() const noexcept
 {
-    for (auto it = _buffer.get(); it < _commitWatermark; it += _bufferRowStride)
+    size_t offset = 0;
+    for (auto it = _buffer.get(); it < _commitWatermark; it += _bufferRowStride, ++offset)
     {
-        std::destroy_at(reinterpret_cast<ROW*>(it));
+        // Frozen ROWs have been destroyed already and their memory may be decommitted.
+        if (!_coldRows.IsCold(offset))
+        {
+            std::destroy_at(reinterpret_cast<ROW*>(it));
+        }
     }
 }
 
@@ -180,11 +230,25 @@ ROW& TextBuffer::_getRowByOffsetDirect(size_t offset)
     {
         _commit(row);
     }
+    else if (_coldRows.IsCold(offset))
+    {
+        _thaw(offset);
+    }
+    else if (_isReflowPending(offset))
+    {
+        _reflowPendingRow(offset);
+    }
 
     return *reinterpret_cast<ROW*>(row);
 }
 
 ROW& TextBuffer::_getRow(til::CoordType y) const
+{
+#pragma warning(suppress : 26492) // Don't use const_cast to cast away const or volatile (type.3).
+    return const_cast<TextBuffer*>(this)->_getRowByOffsetDirect(_getRowOffset(y));
+}
+
+size_t TextBuffer::_getRowOffset(til::CoordType y) const noexcept
 {
     // Rows are stored circularly, so the index you ask for is offset by the start position and mod the total of rows.
     auto offset = (_firstRow + y) % _height;
@@ -197,8 +261,423 @@ ROW& TextBuffer::_getRow(til::CoordType y) const
     }
 
     // We add 1 to the row offset, because row "0" is the one returned by GetScratchpadRow().
+    return gsl::narrow_cast<size_t>(offset) + 1;
+}
+
+// The inverse of _getRowOffset().
+til::CoordType TextBuffer::_getRowY(size_t offset) const noexcept
+{
+    auto y = gsl::narrow_cast<til::CoordType>(offset) - 1 - _firstRow;
+    if (y < 0)
+    {
+        y += _height;
+    }
+    return y;
+}
+
+// Decodes a frozen ROW back into its place in the arena. Just like _commit() this is noinline,
+// because it keeps the rarely taken branch out of the inlined _getRowByOffsetDirect().
+__declspec(noinline) void TextBuffer::_thaw(size_t offset)
+{
+    _coldRows.Thaw(offset, _reconstruct(offset));
+    _thawedRows.emplace_back(offset);
+}
+
+// Commits the pages of a frozen ROW again and constructs a blank ROW in its place.
+ROW& TextBuffer::_reconstruct(size_t offset)
+{
+    const auto row = _buffer.get() + _bufferRowStride * offset;
+    const auto beg = gsl::narrow_cast<size_t>(row - _buffer.get());
+    const auto end = beg + _bufferRowStride;
+
+    for (auto page = beg / _pageSize; page <= (end - 1) / _pageSize; ++page)
+    {
+        if (_decommittedPages[page])
+        {
+            THROW_LAST_ERROR_IF_NULL(VirtualAlloc(_buffer.get() + page * _pageSize, _pageSize, MEM_COMMIT, PAGE_READWRITE));
+            _decommittedPages[page] = false;
+        }
+    }
+
+    const auto chars = reinterpret_cast<wchar_t*>(row + _bufferOffsetChars);
+    const auto indices = reinterpret_cast<uint16_t*>(row + _bufferOffsetCharOffsets);
+    return *std::construct_at(reinterpret_cast<ROW*>(row), chars, indices, _width, _initialAttributes);
+}
+
+// Encodes and destroys the given ROW and decommits the pages that only hold frozen ROWs now.
+void TextBuffer::_freeze(size_t offset)
+{
+    const auto row = _buffer.get() + _bufferRowStride * offset;
+    if (row >= _commitWatermark || _coldRows.IsCold(offset) || _isReflowPending(offset))
+    {
+        return;
+    }
+
+    _coldRows.Freeze(offset, gsl::narrow_cast<size_t>(_height) + 1, *reinterpret_cast<ROW*>(row));
+    std::destroy_at(reinterpret_cast<ROW*>(row));
+
+    if (_decommittedPages.empty())
+    {
+        _decommittedPages.resize((gsl::narrow_cast<size_t>(_bufferEnd - _buffer.get()) + _pageSize - 1) / _pageSize);
+    }
+
+    const auto committedRows = gsl::narrow_cast<size_t>(_commitWatermark - _buffer.get()) / _bufferRowStride;
+    const auto beg = gsl::narrow_cast<size_t>(row - _buffer.get());
+    const auto end = beg + _bufferRowStride;
+
+    for (auto page = beg / _pageSize; page <= (end - 1) / _pageSize; ++page)
+    {
+        const auto firstRow = page * _pageSize / _bufferRowStride;
+        const auto lastRow = ((page + 1) * _pageSize - 1) / _bufferRowStride;
+        if (_decommittedPages[page] || lastRow >= committedRows)
+        {
+            continue;
+        }
+
+        auto allCold = true;
+        for (auto r = firstRow; allCold && r <= lastRow; ++r)
+        {
+            allCold = _coldRows.IsCold(r);
+        }
+        if (allCold)
+        {
+            VirtualFree(_buffer.get() + page * _pageSize, _pageSize, MEM_DECOMMIT);
+            _decommittedPages[page] = true;
+        }
+    }
+}
+
+// Freezes the rows that are more than _coldRowDistance rows above the cursor and weren't frozen yet,
+// as well as the rows that were thawed since the last call and are still that far away.
+void TextBuffer::_freezeColdRows()
+{
+    const auto limit = std::min<til::CoordType>(_cursor.GetPosition().y - _coldRowDistance, _height);
+    if (limit <= 0)
+    {
+        return;
+    }
+
+    for (auto y = std::max(0, _frozenLimit); y < limit; ++y)
+    {
+        _freeze(_getRowOffset(y));
+    }
+    _frozenLimit = std::max(_frozenLimit, limit);
+
+    std::erase_if(_thawedRows, [&](const size_t offset) {
+        if (_getRowY(offset) >= limit)
+        {
+            return false;
+        }
+        _freeze(offset);
+        return true;
+    });
+}
+
+// Called once per newline. Freezing cold rows in batches keeps the cost out of the common path.
+void TextBuffer::_tickColdRows()
+{
+    if (_coldScrollback && ++_coldRowTicks >= _coldRowInterval)
+    {
+        _coldRowTicks = 0;
+        _freezeColdRows();
+    }
+}
+
+// Forgets all frozen ROWs. The caller is responsible for having destroyed or decommitted the arena.
+void TextBuffer::_resetColdRows() noexcept
+{
+    _coldRows.Clear();
+    _thawedRows = {};
+    _frozenLimit = 0;
+    _decommittedPages = {};
+    _coldRowTicks = 0;
+}
+
+// Returns the hyperlink IDs of the given row without thawing it. For a row that ReflowLazily() hasn't
+// rewrapped yet, these are the ones of its entire line, which is good enough for _PruneHyperlinks().
+std::vector<uint16_t> TextBuffer::_getHyperlinks(til::CoordType y) const
+{
+    const auto offset = _getRowOffset(y);
+    if (_coldRows.IsCold(offset))
+    {
+        return _coldRows.GetHyperlinks(offset);
+    }
+    if (_isReflowPending(offset))
+    {
+        const auto& line = til::at(_reflowSource->lines, _pendingReflowRows[offset].line);
+        std::vector<uint16_t> hyperlinks;
+        for (auto row = line.row; row < line.row + line.rows; ++row)
+        {
+            const auto ids = _reflowSource->buffer->_getHyperlinks(row);
+            hyperlinks.insert(hyperlinks.end(), ids.begin(), ids.end());
+        }
+        return hyperlinks;
+    }
+    return GetRowByOffset(y).GetHyperlinks();
+}
+
+bool TextBuffer::_isReflowPending(size_t offset) const noexcept
+{
+    return offset < _pendingReflowRows.size() && _pendingReflowRows[offset].line != _noReflowLine;
+}
+
+// Rewraps the line that the pending row at the given arena offset belongs to. Just like _thaw() this is
+// noinline, because it keeps the rarely taken branch out of the inlined _getRowByOffsetDirect().
+__declspec(noinline) void TextBuffer::_reflowPendingRow(size_t offset)
+{
+    const auto pending = _pendingReflowRows[offset];
+    const auto firstOffset = (offset - 1 + _height - pending.part % _height) % _height + 1;
+    _rewrapLine(*_reflowSource, pending.line, firstOffset);
+    if (!_pendingReflowRowCount)
+    {
+        _resetReflow();
+    }
+}
+
+// Forgets about the pending row at the given arena offset, because it's about to be overwritten anyway.
+void TextBuffer::_dropPendingReflowRow(size_t offset) noexcept
+{
+    if (_isReflowPending(offset))
+    {
+        _pendingReflowRows[offset].line = _noReflowLine;
+        // While _reflow() is running, there's no source yet and more rows may become pending.
+        if (!--_pendingReflowRowCount && _reflowSource)
+        {
+            _resetReflow();
+        }
+    }
+}
+
+// Forgets all pending rows and releases the rows they would've been rewrapped from.
+void TextBuffer::_resetReflow() noexcept
+{
+    _reflowSource.reset();
+    _pendingReflowRows = {};
+    _pendingReflowRowCount = 0;
+}
+
+// Returns the number of rows the given line of the source takes up when it's rewrapped at our width,
+// and the column its text ends at in the last of them in `textEnd`.
+til::CoordType TextBuffer::_countReflowRows(const ReflowSource& source, uint32_t line, til::CoordType* textEnd)
+{
+    const auto& l = til::at(source.lines, line);
+    const auto flags = source.flags.begin() + l.row;
+    if (std::any_of(flags, flags + l.rows, [](const uint8_t f) { return f != 0; }))
+    {
+        return _rewrapLine(source, line, 0, textEnd);
+    }
+
+    // Without wide glyphs every column of the line takes up exactly one column of the new rows.
+    // This computes what the copy loop of _rewrapLine() would do, without copying anything.
+    const til::CoordType width = _width;
+    til::CoordType part = 0;
+    til::CoordType newX = 0;
+    for (auto y = l.row; y < l.row + l.rows; ++y)
+    {
+        const til::CoordType limit = til::at(source.limits, y);
+        if (newX >= width)
+        {
+            newX = 0;
+            part++;
+        }
+        const auto head = std::min(width - newX, limit);
+        newX += head;
+        if (const auto rest = limit - head; rest > 0)
+        {
+            const auto wraps = (rest - 1) / width;
+            part += wraps + 1;
+            newX = rest - wraps * width;
+        }
+    }
+    if (textEnd)
+    {
+        *textEnd = newX;
+    }
+    return part + (l.open ? newX > 0 : 1);
+}
+
+// Rewraps the given line of the source into the rows starting at the arena offset `firstOffset`, skipping
+// those that aren't pending for this line anymore, and returns the number of rows the line takes up.
+// A firstOffset of 0 rewraps the line into the scratchpad row, which only counts its rows, unless
+// `foldedParts` is given, which then receives the case folded text of each of them.
+// See _countReflowRows() for `textEnd`.
+til::CoordType TextBuffer::_rewrapLine(const ReflowSource& source, uint32_t line, size_t firstOffset, til::CoordType* textEnd, std::vector<std::u16string>* foldedParts)
+{
+    const auto& l = til::at(source.lines, line);
+    const til::CoordType width = _width;
+    til::CoordType part = 0;
+
+    const auto nextRow = [&]() -> ROW& {
+        if (firstOffset)
+        {
+            const auto offset = (firstOffset - 1 + part) % _height + 1;
+            auto& pending = _pendingReflowRows[offset];
+            if (pending.line == line && pending.part == gsl::narrow_cast<uint32_t>(part))
+            {
+                pending.line = _noReflowLine;
+                _pendingReflowRowCount--;
+                // Rows that are far above the cursor get frozen by the next batch again.
+                if (_getRowY(offset) < _frozenLimit)
+                {
+                    _thawedRows.emplace_back(offset);
+                }
+                auto& row = _getRowByOffsetDirect(offset);
+                row.Reset(_initialAttributes);
+                return row;
+            }
+        }
+        return GetScratchpadRow(_initialAttributes);
+    };
+    const auto foldRow = [&](const ROW& row) {
+        if (foldedParts)
+        {
+            TrigramIndex::Fold(row.GetText(), foldedParts->emplace_back());
+        }
+    };
+
+    auto newRow = &nextRow();
+
+    if (til::at(source.flags, l.row) & ReflowSource::FlagLineRendition)
+    {
+        newRow->CopyFrom(source.buffer->GetRowByOffset(l.row));
+        newRow->SetWrapForced(false);
+        foldRow(*newRow);
+        if (textEnd)
+        {
+            *textEnd = 0;
+        }
+        return 1;
+    }
+
+    // This is the copy loop of _reflow() for a single line.
+    til::CoordType newX = 0;
+    for (auto y = l.row; y < l.row + l.rows; ++y)
+    {
+        const auto& oldRow = source.buffer->GetRowByOffset(y);
+        const til::CoordType oldRowLimit = til::at(source.limits, y);
+        til::CoordType oldX = 0;
+
+        do
+        {
+            if (newX >= width)
+            {
+                newRow->SetWrapForced(true);
+                foldRow(*newRow);
+                newX = 0;
+                part++;
+                newRow = &nextRow();
+            }
+
+            RowCopyTextFromState state{
+                .source = oldRow,
+                .columnBegin = newX,
+                .columnLimit = til::CoordTypeMax,
+                .sourceColumnBegin = oldX,
+                .sourceColumnLimit = oldRowLimit,
+            };
+            newRow->CopyTextFrom(state);
+
+            const auto& oldAttr = oldRow.Attributes();
+            auto& newAttr = newRow->Attributes();
+            const auto attributes = oldAttr.slice(gsl::narrow_cast<uint16_t>(oldX), oldAttr.size());
+            newAttr.replace(gsl::narrow_cast<uint16_t>(newX), newAttr.size(), attributes);
+            newAttr.resize_trailing_extent(_width);
+
+            oldX = state.sourceColumnEnd;
+            newX = state.columnEnd;
+        } while (oldX < oldRowLimit);
+    }
+
+    // The copy loop put the attributes past the end of the text of the source at the end of the last row. Those
+    // that earlier resizes cut off are replaced with the last one that survived, like Reflow() would've done.
+    auto& newAttr = newRow->Attributes();
+    newAttr.resize_trailing_extent(gsl::narrow_cast<uint16_t>(std::clamp(newX + l.tailColumns, 1, width)));
+    newAttr.resize_trailing_extent(_width);
+    foldRow(*newRow);
+
+    if (textEnd)
+    {
+        *textEnd = newX;
+    }
+    return part + (l.open ? newX > 0 : 1);
+}
+
+// Appends the case folded text of the row at the given arena offset, which wraps around, to `out`.
+// Rows that weren't committed yet are blank, which is what they'll look like once they are.
+// Cold rows are decoded and pending ones rewrapped into the scratchpad, so that searching doesn't thaw
+// or rewrap the entire buffer. `pending` holds on to the last pending line for its remaining rows.
+void TextBuffer::_foldSearchRow(size_t offset, std::u16string& out, FoldedReflowLine& pending) const
+{
+    offset = (offset - 1) % _height + 1;
 #pragma warning(suppress : 26492) // Don't use const_cast to cast away const or volatile (type.3).
-    return const_cast<TextBuffer*>(this)->_getRowByOffsetDirect(gsl::narrow_cast<size_t>(offset) + 1);
+    const auto self = const_cast<TextBuffer*>(this);
+
+    if (_isReflowPending(offset))
+    {
+        const auto [line, part] = _pendingReflowRows[offset];
+        if (pending.line != line)
+        {
+            pending.line = line;
+            pending.parts.clear();
+            self->_rewrapLine(*_reflowSource, line, 0, nullptr, &pending.parts);
+        }
+        if (part < pending.parts.size())
+        {
+            out.append(pending.parts[part]);
+        }
+        else
+        {
+            out.append(_width, u' ');
+        }
+        return;
+    }
+    if (_buffer.get() + _bufferRowStride * offset >= _commitWatermark)
+    {
+        out.append(_width, u' ');
+        return;
+    }
+    if (_coldRows.IsCold(offset))
+    {
+        auto& row = self->GetScratchpadRow(_initialAttributes);
+        _coldRows.Decode(offset, row);
+        TrigramIndex::Fold(row.GetText(), out);
+        return;
+    }
+    TrigramIndex::Fold(_getRow(_getRowY(offset)).GetText(), out);
+}
+
+// Builds the blocks of the search index that are missing or outdated.
+void TextBuffer::_updateSearchIndex() const
+{
+    if (_searchIndex.RowCount() != _height)
+    {
+        _searchIndex.Reset(_height);
+    }
+
+    std::u16string text;
+    FoldedReflowLine pending;
+    for (size_t block = 0; block < _searchIndex.BlockCount(); ++block)
+    {
+        if (!_searchIndex.IsDirty(block))
+        {
+            continue;
+        }
+
+        const auto beg = block * TrigramIndex::BlockSize + 1;
+        const auto end = std::min<size_t>(beg + TrigramIndex::BlockSize, _height + 1);
+        text.clear();
+        for (auto offset = beg; offset < end; ++offset)
+        {
+            _foldSearchRow(offset, text, pending);
+        }
+
+        // The trigrams that start at the end of the last row continue into the next one.
+        const auto size = text.size();
+        _foldSearchRow(end, text, pending);
+        text.resize(std::min(text.size(), size + 2));
+
+        _searchIndex.SetBlock(block, text);
+    }
 }
 
 // Returns the "user-visible" index of the last committed row, which can be used
@@ -226,7 +705,12 @@ const ROW& TextBuffer::GetRowByOffset(const til::CoordType index) const
 ROW& TextBuffer::GetMutableRowByOffset(const til::CoordType index)
 {
     _lastMutationId++;
-    return _getRow(index);
+    auto& row = _getRow(index);
+    // The ROW is about to change, which makes the record it was decoded from outdated.
+    const auto offset = _getRowOffset(index);
+    _coldRows.Discard(offset);
+    _searchIndex.Invalidate(offset - 1);
+    return row;
 }
 
 // Returns a row filled with whitespace and the current attributes, for you to freely use.
@@ -269,6 +753,35 @@ til::CoordType TextBuffer::TotalRowCount() const noexcept
     return _height;
 }
 
+// Enables or disables the compression of the rows far above the cursor (which is enabled by default).
+// Disabling it thaws all frozen rows. This mostly exists for tests and benchmarks.
+void TextBuffer::EnableColdScrollback(bool enable)
+{
+    _coldScrollback = enable;
+    if (!enable)
+    {
+        for (size_t offset = 1; offset <= _height; ++offset)
+        {
+            if (_coldRows.IsCold(offset))
+            {
+                _thaw(offset);
+            }
+        }
+        _thawedRows.clear();
+        _frozenLimit = 0;
+    }
+}
+
+const ColdRowStore& TextBuffer::GetColdRows() const noexcept
+{
+    return _coldRows;
+}
+
+const TrigramIndex& TextBuffer::GetSearchIndex() const noexcept
+{
+    return _searchIndex;
+}
+
 // Method Description:
 // - Gets the number of glyphs in the buffer between two points.
 // - IMPORTANT: Make sure that start is before end, or this will never return!
@@ -841,6 +1354,10 @@ void TextBuffer::NewlineCursor()
         // Instead increment the circular buffer to move us into the "oldest" row of the backing buffer
         IncrementCircularBuffer();
     }
+    else
+    {
+        _tickColdRows();
+    }
 }
 
 //Routine Description:
@@ -862,11 +1379,23 @@ void TextBuffer::IncrementCircularBuffer(const TextAttribute& fillAttributes)
     _PruneHyperlinks();
 
     // Second, clean out the old "first row" as it will become the "last row" of the buffer after the circle is performed.
+    // It's most likely frozen, in which case there's no point in decoding it just to reset it.
+    // The same goes for rewrapping it, if ReflowLazily() hasn't done that yet.
+    if (const auto offset = _getRowOffset(0); _coldRows.IsCold(offset))
+    {
+        _coldRows.Discard(offset);
+        _reconstruct(offset);
+    }
+    else
+    {
+        _dropPendingReflowRow(offset);
+    }
     GetMutableRowByOffset(0).Reset(fillAttributes);
     {
         // Now proceed to increment.
         // Incrementing it will cause the next line down to become the new "top" of the window (the new "0" in logical coordinates)
         _firstRow++;
+        _frozenLimit = std::max(0, _frozenLimit - 1);
 
         // If we pass up the height of the buffer, loop back to 0.
         if (_firstRow >= GetSize().Height())
@@ -874,6 +1403,8 @@ void TextBuffer::IncrementCircularBuffer(const TextAttribute& fillAttributes)
             _firstRow = 0;
         }
     }
+
+    _tickColdRows();
 }
 
 //Routine Description:
@@ -1174,18 +1705,8 @@ void TextBuffer::ResizeTraditional(til::size newSize)
         newBuffer.GetMutableRowByOffset(dstRow).CopyFrom(GetRowByOffset(srcRow));
     }
 
-    // NOTE: Keep this in sync with _reserve().
-    _buffer = std::move(newBuffer._buffer);
-    _bufferEnd = newBuffer._bufferEnd;
-    _commitWatermark = newBuffer._commitWatermark;
-    _initialAttributes = newBuffer._initialAttributes;
-    _bufferRowStride = newBuffer._bufferRowStride;
-    _bufferOffsetChars = newBuffer._bufferOffsetChars;
-    _bufferOffsetCharOffsets = newBuffer._bufferOffsetCharOffsets;
-    _width = newBuffer._width;
-    _height = newBuffer._height;
-
-    _SetFirstRowIndex(0);
+    // The old rows get destroyed together with newBuffer.
+    _swapRows(newBuffer);
 }
 
 void TextBuffer::SetAsActiveBuffer(const bool isActiveBuffer) noexcept
@@ -1523,7 +2044,7 @@ void TextBuffer::_PruneHyperlinks()
     // If the buffer does not contain the same reference, we can remove that hyperlink from our map
     // This way, obsolete hyperlink references are cleared from our hyperlink map instead of hanging around
     // Get all the hyperlink references in the row we're erasing
-    const auto hyperlinks = GetRowByOffset(0).GetHyperlinks();
+    const auto hyperlinks = _getHyperlinks(0);
 
     if (!hyperlinks.empty())
     {
@@ -1539,7 +2060,7 @@ void TextBuffer::_PruneHyperlinks()
         // to see if those references are anywhere else
         for (til::CoordType i = 1; i < total; ++i)
         {
-            const auto nextRowRefs = GetRowByOffset(i).GetHyperlinks();
+            const auto nextRowRefs = _getHyperlinks(i);
             for (auto id : nextRowRefs)
             {
                 if (firstRowRefs.find(id) != firstRowRefs.end())
@@ -2451,7 +2972,7 @@ void TextBuffer::_AppendRTFText(std::ostringstream& contentBuilder, const std::w
         else
         {
             // Windows uses unsigned wchar_t - RTF uses signed ones.
-            contentBuilder << "\\u" << std::to_string(til::bit_cast<int16_t>(codeUnit)) << "?";
+            contentBuilder << "\\u" << std::to_string(til::bit_cast<int16_t>(gsl::narrow_cast<uint16_t>(codeUnit))) << "?";
         }
     }
 }
@@ -2473,6 +2994,50 @@ void TextBuffer::_AppendRTFText(std::ostringstream& contentBuilder, const std::w
 // Return Value:
 // - S_OK if we successfully copied the contents to the new buffer, otherwise an appropriate HRESULT.
 void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const Viewport* lastCharacterViewport, PositionInformation* positionInfo)
+{
+    _reflow(oldBuffer, newBuffer, lastCharacterViewport, positionInfo, false);
+}
+
+// Function Description:
+// - Like Reflow(), but only the lines from the top of the viewports (see positionInfo)
+//   and the cursor downwards are rewrapped right away. The other rows of oldBuffer move
+//   into newBuffer, which rewraps each of their lines the first time one of its rows is
+//   accessed, or when FinishReflow() is called.
+// - Lines that can't be rewrapped on their own later are rewrapped right away: lines that
+//   continue into a row with a different line rendition, double-width lines, lines ending in
+//   whitespace, and lines with marks on them whose new position depends on how the line wraps (see
+//   canPlaceMarkPoints in _reflow()). That's what keeps the text, the attributes, the marks, and the
+//   positions in positionInfo identical to what Reflow() produces.
+// - Resizing newBuffer lazily again only needs to look at the rows that were accessed since,
+//   because the lines of the other ones have been measured already.
+// - oldBuffer is left blank.
+// - It still commits every row of newBuffer up to the viewport and isn't faster than Reflow() yet,
+//   so the Terminal and conhost keep resizing with Reflow().
+void TextBuffer::ReflowLazily(TextBuffer& oldBuffer, TextBuffer& newBuffer, const Viewport* lastCharacterViewport, PositionInformation* positionInfo)
+{
+    _reflow(oldBuffer, newBuffer, lastCharacterViewport, positionInfo, true);
+}
+
+// Returns the number of rows that ReflowLazily() hasn't rewrapped yet.
+size_t TextBuffer::GetPendingReflowRowCount() const noexcept
+{
+    return _pendingReflowRowCount;
+}
+
+// Rewraps all rows that ReflowLazily() hasn't rewrapped yet and releases the old rows.
+void TextBuffer::FinishReflow()
+{
+    // _reflowPendingRow() clears _pendingReflowRows once the last pending row is rewrapped.
+    for (size_t offset = 1; offset < _pendingReflowRows.size(); ++offset)
+    {
+        if (_isReflowPending(offset))
+        {
+            _reflowPendingRow(offset);
+        }
+    }
+}
+
+void TextBuffer::_reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const Viewport* lastCharacterViewport, PositionInformation* positionInfo, bool lazy)
 {
     const auto& oldCursor = oldBuffer.GetCursor();
     auto& newCursor = newBuffer.GetCursor();
@@ -2489,11 +3054,155 @@ void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const View
     oldCursorPos.x = std::clamp(oldCursorPos.x, 0, oldBuffer._width - 1);
     oldCursorPos.y = std::clamp(oldCursorPos.y, 0, oldBuffer._height - 1);
 
-    const auto lastRowWithText = oldBuffer.GetLastNonSpaceCharacter(lastCharacterViewport).y;
+    // When reflowing lazily, the lines above the top of the viewports and the cursor become pending rows
+    // of newBuffer, which refer to the lines of a ReflowSource. If oldBuffer has pending rows itself,
+    // we refer to its source as well, and only need to copy the rows that it has rewrapped already.
+    // Otherwise the rows of oldBuffer move into a new source and its lines get measured along the way.
+    std::unique_ptr<ReflowSource> newSource;
+    auto source = oldBuffer._reflowSource.get();
+    auto rows = &oldBuffer;
+    if (lazy && !source)
+    {
+        newSource = std::make_unique<ReflowSource>();
+        newSource->buffer = std::make_unique<TextBuffer>(til::size{ oldBuffer._width, oldBuffer._height }, oldBuffer._initialAttributes, 0, false, oldBuffer._renderer);
+        newSource->buffer->_swapRows(oldBuffer);
+        newSource->limits.resize(oldBuffer._height);
+        newSource->flags.resize(oldBuffer._height);
+        source = newSource.get();
+        rows = newSource->buffer.get();
+    }
+    if (lazy)
+    {
+        newBuffer._pendingReflowRows.resize(gsl::narrow_cast<size_t>(newBuffer._height) + 1);
+    }
+
+    const auto lastRowWithText = rows->GetLastNonSpaceCharacter(lastCharacterViewport).y;
 
     auto mutableViewportTop = positionInfo ? positionInfo->mutableViewportTop : til::CoordTypeMax;
     auto visibleViewportTop = positionInfo ? positionInfo->visibleViewportTop : til::CoordTypeMax;
 
+    // The marks move along with the text, the same way the cursor does. Their points are remapped
+    // by the copy loop below, which visits them in the order of the rows they're in.
+    struct MarkPoint
+    {
+        til::point old;
+        til::point* point = nullptr;
+        bool remapped = false;
+    };
+    newBuffer._marks = oldBuffer._marks;
+    std::vector<MarkPoint> markPoints;
+    for (auto& mark : newBuffer._marks)
+    {
+        for (const auto point : { &mark.start, &mark.end, mark.commandEnd ? &*mark.commandEnd : nullptr, mark.outputEnd ? &*mark.outputEnd : nullptr })
+        {
+            if (point)
+            {
+                markPoints.emplace_back(MarkPoint{ .old = *point, .point = point });
+            }
+        }
+    }
+    std::stable_sort(markPoints.begin(), markPoints.end(), [](const MarkPoint& a, const MarkPoint& b) { return a.old.y < b.old.y; });
+    auto markPointsBeg = markPoints.begin();
+    auto markPointsEnd = markPoints.begin();
+    const auto markPointsAt = [&](til::CoordType y) {
+        return std::lower_bound(markPoints.begin(), markPoints.end(), y, [](const MarkPoint& p, til::CoordType value) { return p.old.y < value; });
+    };
+    // The number of columns of text in a line of the source, or -1 if it contains wide glyphs.
+    const auto textLength = [&](const ReflowSource::Line& l) {
+        til::CoordType length = 0;
+        for (auto y = l.row; y < l.row + l.rows; ++y)
+        {
+            if (til::at(source->flags, y) & ReflowSource::FlagWideGlyphs)
+            {
+                return -1;
+            }
+            length += til::at(source->limits, y);
+        }
+        return length;
+    };
+    // A line with points of marks in its rows [beg, beg + count) can only stay pending if it doesn't contain wide glyphs.
+    // The offset of a point within its text is then the same at any width, and a point past its end in the last row
+    // gets cut off at the right edge just like the attributes there (see ReflowSource::Line::tailColumns). Other points
+    // are remapped by copying the line. Lines with a non-standard line rendition are truncated instead.
+    const auto canPlaceMarkPoints = [&](til::CoordType beg, til::CoordType count, const ReflowSource::Line& l) {
+        auto it = markPointsAt(beg);
+        if (it == markPoints.end() || it->old.y >= beg + count || (til::at(source->flags, l.row) & ReflowSource::FlagLineRendition))
+        {
+            return true;
+        }
+        const auto length = textLength(l);
+        if (length < 0)
+        {
+            return false;
+        }
+        for (; it != markPoints.end() && it->old.y < beg + count; ++it)
+        {
+            const auto offset = (it->old.y - beg) * oldBuffer._width + it->old.x;
+            const auto fits = offset <= length ? it->old.x < oldBuffer._width || offset == length : it->old.y == beg + count - 1 && offset - length <= l.tailColumns;
+            if (it->old.x < 0 || !fits)
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+    // Remaps the points of the marks in the rows [beg, beg + count) of a pending line that now spans the rows [top, top + height).
+    // A point at or past the end of the text stays in the last row, even if that one is full.
+    const auto placeMarkPoints = [&](til::CoordType beg, til::CoordType count, const ReflowSource::Line& l, til::CoordType top, til::CoordType height) {
+        auto it = markPointsAt(beg);
+        if (it == markPoints.end() || it->old.y >= beg + count)
+        {
+            return;
+        }
+        const auto rendition = (til::at(source->flags, l.row) & ReflowSource::FlagLineRendition) != 0;
+        const auto length = rendition ? 0 : textLength(l);
+        for (; it != markPoints.end() && it->old.y < beg + count; ++it)
+        {
+            if (rendition)
+            {
+                *it->point = { std::min<til::CoordType>(it->old.x, newBuffer._width), top };
+            }
+            else
+            {
+                const auto offset = (it->old.y - beg) * oldBuffer._width + it->old.x;
+                const auto row = std::min(std::min(offset, length) / newBuffer._width, height - 1);
+                const auto excess = std::max(0, offset - length);
+                *it->point = { std::min(offset, length) - row * newBuffer._width + std::min<til::CoordType>(excess, l.tailColumns), top + row };
+            }
+            it->remapped = true;
+        }
+    };
+    // Remaps the points of the marks in row oldY, if they're at or past column from, to the same distance from column to in row y.
+    const auto remapMarkPoints = [&](til::CoordType from, til::CoordType to, til::CoordType y) {
+        for (auto it = markPointsBeg; it != markPointsEnd; ++it)
+        {
+            if (it->old.x >= from)
+            {
+                *it->point = { std::min<til::CoordType>(it->old.x - from + to, newBuffer._width), y };
+                it->remapped = true;
+            }
+        }
+    };
+
+    // Whether the line that row y-1 of the old buffer is in continues in row y. Rows with
+    // a non-standard line rendition are lines of their own (see the copy loop below).
+    const auto continuesLine = [&](til::CoordType y) {
+        const auto& prevRow = rows->GetRowByOffset(y - 1);
+        const auto wrapped = prevRow.WasWrapForced() && prevRow.GetLineRendition() == LineRendition::SingleWidth;
+        return wrapped && rows->GetRowByOffset(y).GetLineRendition() == LineRendition::SingleWidth;
+    };
+
+    // The lines before this row stay pending, if we reflow lazily.
+    til::CoordType pendingLimit = 0;
+    if (lazy)
+    {
+        pendingLimit = std::max(0, std::min({ oldCursorPos.y, mutableViewportTop, visibleViewportTop }));
+        while (pendingLimit > 0 && continuesLine(pendingLimit))
+        {
+            pendingLimit--;
+        }
+    }
+
     til::CoordType oldY = 0;
     til::CoordType newY = 0;
     til::CoordType newX = 0;
@@ -2504,10 +3213,112 @@ void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const View
     const auto newHeight = newBuffer.GetSize().Height();
     const auto newWidthU16 = gsl::narrow_cast<uint16_t>(newWidth);
 
+    // Whether oldY is the first row of a line. Only entire lines can stay pending.
+    auto lineStart = true;
+
     // Copy oldBuffer into newBuffer until oldBuffer has been fully consumed.
     for (; oldY < oldHeight && newY < newYLimit; ++oldY)
     {
-        const auto& oldRow = oldBuffer.GetRowByOffset(oldY);
+        if (oldY < pendingLimit && newX == 0 && lineStart)
+        {
+            auto line = _noReflowLine;
+            til::CoordType oldRows = 0;
+
+            if (newSource)
+            {
+                // Measure the line that starts at oldY and add it to the source.
+                ReflowSource::Line l{ .row = oldY };
+                for (auto y = oldY;; ++y)
+                {
+                    const auto& row = rows->GetRowByOffset(y);
+                    const auto rendition = row.GetLineRendition() != LineRendition::SingleWidth;
+                    newSource->limits[y] = gsl::narrow_cast<uint16_t>(row.MeasureRight());
+                    newSource->flags[y] = (row.ContainsWideGlyph() ? ReflowSource::FlagWideGlyphs : 0) | (rendition ? ReflowSource::FlagLineRendition : 0);
+                    if (y + 1 >= pendingLimit || !continuesLine(y + 1))
+                    {
+                        l.rows = y + 1 - oldY;
+                        l.open = !rendition && row.WasWrapForced();
+                        break;
+                    }
+                }
+                if (!(newSource->flags[oldY] & ReflowSource::FlagLineRendition))
+                {
+                    // A blank last row means that the line ended in whitespace after a full row.
+                    const auto lastY = oldY + l.rows - 1;
+                    const auto limit = newSource->limits[lastY];
+                    l.trailingWhitespace = limit ? rows->GetRowByOffset(lastY).GlyphAt(limit - 1) == L" " : l.rows > 1;
+                    l.tailColumns = gsl::narrow_cast<uint16_t>(rows->_width - limit);
+                }
+                if (canPlaceMarkPoints(oldY, l.rows, l))
+                {
+                    line = gsl::narrow<uint32_t>(newSource->lines.size());
+                    oldRows = l.rows;
+                    newSource->lines.emplace_back(l);
+                }
+            }
+            else if (const auto offset = oldBuffer._getRowOffset(oldY); oldBuffer._isReflowPending(offset))
+            {
+                // A line that's still pending in its entirety can stay pending,
+                // without looking at its rows. Otherwise we copy what's left of it.
+                const auto pending = oldBuffer._pendingReflowRows[offset];
+                auto complete = pending.part == 0 && til::at(source->lines, pending.line).CanStayPending(*source);
+                if (complete)
+                {
+                    oldRows = oldBuffer._countReflowRows(*source, pending.line);
+                    complete = oldY + oldRows <= pendingLimit && canPlaceMarkPoints(oldY, oldRows, til::at(source->lines, pending.line));
+                }
+                for (til::CoordType part = 1; complete && part < oldRows; ++part)
+                {
+                    const auto& next = oldBuffer._pendingReflowRows[oldBuffer._getRowOffset(oldY + part)];
+                    complete = next.line == pending.line && next.part == gsl::narrow_cast<uint32_t>(part);
+                }
+                if (complete)
+                {
+                    line = pending.line;
+                }
+            }
+
+            if (line != _noReflowLine)
+            {
+                til::CoordType textEnd = 0;
+                const auto newRows = newBuffer._countReflowRows(*source, line, &textEnd);
+                auto& l = til::at(source->lines, line);
+                l.tailColumns = std::min(l.tailColumns, gsl::narrow_cast<uint16_t>(newWidth - textEnd));
+                placeMarkPoints(oldY, oldRows, l, newY, newRows);
+                for (til::CoordType part = 0; part < newRows; ++part)
+                {
+                    const auto offset = newBuffer._getRowOffset(newY + part);
+                    // Reflow() commits every row it writes and _estimateOffsetOfLastCommittedRow() relies on it.
+                    const auto row = newBuffer._buffer.get() + newBuffer._bufferRowStride * offset;
+                    if (row >= newBuffer._commitWatermark)
+                    {
+                        newBuffer._commit(row);
+                    }
+                    auto& pending = newBuffer._pendingReflowRows[offset];
+                    if (pending.line == _noReflowLine)
+                    {
+                        newBuffer._pendingReflowRowCount++;
+                    }
+                    pending = { line, gsl::narrow_cast<uint32_t>(part) };
+                }
+                newY += newRows;
+                oldY += oldRows - 1;
+                continue;
+            }
+        }
+
+        const auto& oldRow = rows->GetRowByOffset(oldY);
+        lineStart = !oldRow.WasWrapForced() || oldRow.GetLineRendition() != LineRendition::SingleWidth;
+
+        while (markPointsBeg != markPoints.end() && markPointsBeg->old.y < oldY)
+        {
+            ++markPointsBeg;
+        }
+        markPointsEnd = markPointsBeg;
+        while (markPointsEnd != markPoints.end() && markPointsEnd->old.y == oldY)
+        {
+            ++markPointsEnd;
+        }
 
         // A pair of double height rows should optimally wrap as a union (i.e. after wrapping there should be 4 lines).
         // But for this initial implementation I chose the alternative approach: Just truncate them.
@@ -2522,6 +3333,7 @@ void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const View
                 newY++;
             }
 
+            newBuffer._dropPendingReflowRow(newBuffer._getRowOffset(newY));
             auto& newRow = newBuffer.GetMutableRowByOffset(newY);
 
             // See the comment marked with "REFLOW_RESET".
@@ -2537,6 +3349,7 @@ void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const View
             {
                 newCursorPos = { newRow.AdjustToGlyphStart(oldCursorPos.x), newY };
             }
+            remapMarkPoints(0, 0, newY);
             if (oldY >= mutableViewportTop)
             {
                 positionInfo->mutableViewportTop = newY;
@@ -2594,6 +3407,8 @@ void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const View
                 {
                     break;
                 }
+                // A pending row would get rewrapped by GetMutableRowByOffset() only to be reset.
+                newBuffer._dropPendingReflowRow(newBuffer._getRowOffset(newY));
                 newBuffer.GetMutableRowByOffset(newY).Reset(newBuffer._initialAttributes);
             }
 
@@ -2627,6 +3442,7 @@ void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const View
                 // This implements the second option. There's no fundamental reason why this is better.
                 newYLimit = newY + newHeight;
             }
+            remapMarkPoints(oldX, newX, newY);
             if (oldY >= mutableViewportTop)
             {
                 positionInfo->mutableViewportTop = newY;
@@ -2650,14 +3466,24 @@ void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const View
         }
     }
 
+    // The points of the marks below the rows we've copied keep their distance to them.
+    // Those above the buffer stay there and get removed below.
+    for (auto& p : markPoints)
+    {
+        if (!p.remapped)
+        {
+            *p.point = { std::min(p.old.x, newWidth), p.old.y < oldY ? p.old.y : p.old.y - oldY + newY };
+        }
+    }
+
     // Finish copying buffer attributes to remaining rows below the last
     // printable character. This is to fix the `color 2f` scenario, where you
     // change the buffer colors then resize and everything below the last
     // printable char gets reset. See GH #12567
-    const auto initializedRowsEnd = oldBuffer._estimateOffsetOfLastCommittedRow() + 1;
+    const auto initializedRowsEnd = rows->_estimateOffsetOfLastCommittedRow() + 1;
     for (; oldY < initializedRowsEnd && newY < newHeight; oldY++, newY++)
     {
-        auto& oldRow = oldBuffer.GetRowByOffset(oldY);
+        auto& oldRow = rows->GetRowByOffset(oldY);
         auto& newRow = newBuffer.GetMutableRowByOffset(newY);
         auto& newAttr = newRow.Attributes();
         newAttr = oldRow.Attributes();
@@ -2675,6 +3501,11 @@ void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const View
         // Here, we need to un-map the `newCursorPos.y` from the underlying Y coordinate to the API coordinate
         // and so we do `(y - _firstRow) % height`, but we add `+ newHeight` to avoid getting negative results.
         newCursorPos.y = (newCursorPos.y - newBuffer._firstRow + newHeight) % newHeight;
+        // The marks in the rows that got overwritten end up above the top and get removed below.
+        for (auto& p : markPoints)
+        {
+            p.point->y -= newY - newHeight;
+        }
     }
 
     newBuffer.CopyProperties(oldBuffer);
@@ -2685,8 +3516,26 @@ void TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const View
     newCursor.SetSize(oldCursor.GetSize());
     newCursor.SetPosition(newCursorPos);
 
-    newBuffer._marks = oldBuffer._marks;
     newBuffer._trimMarksOutsideBuffer();
+
+    if (lazy)
+    {
+        if (newBuffer._pendingReflowRowCount)
+        {
+            newBuffer._reflowSource = newSource ? std::move(newSource) : std::move(oldBuffer._reflowSource);
+            // Measuring the lines thawed their rows, if they were frozen. They won't change anymore.
+            auto& sourceRows = *newBuffer._reflowSource->buffer;
+            for (const auto offset : std::exchange(sourceRows._thawedRows, {}))
+            {
+                sourceRows._freeze(offset);
+            }
+        }
+        else
+        {
+            newBuffer._resetReflow();
+        }
+        oldBuffer._decommit();
+    }
 }
 
 // Method Description:
@@ -2796,10 +3645,95 @@ void TextBuffer::CopyHyperlinkMaps(const TextBuffer& other)
 }
 
 // Searches through the entire (committed) text buffer for `needle` and returns the coordinates in absolute coordinates.
+// Only the rows that the search index can't rule out are actually searched.
 // The end coordinates of the returned ranges are considered inclusive.
 std::vector<til::point_span> TextBuffer::SearchText(const std::wstring_view& needle, bool caseInsensitive) const
 {
-    return SearchText(needle, caseInsensitive, 0, til::CoordTypeMax);
+    if (allWhitespace(needle))
+    {
+        return {};
+    }
+
+    // Case folding never shortens the text, so a match spans at most this many rows,
+    // given that a row holds at least 1 code unit per 2 columns.
+    std::u16string folded;
+    TrigramIndex::Fold(needle, folded);
+    const auto minRowLength = std::max<size_t>(1, _width / 2);
+    const auto maxMatchRows = folded.size() / minRowLength + 2;
+
+    // The index can't help with needles shorter than a trigram, and it assumes that matches span 2 blocks at most.
+    if (folded.size() < 3 || maxMatchRows >= TrigramIndex::BlockSize)
+    {
+        return SearchText(needle, caseInsensitive, 0, til::CoordTypeMax);
+    }
+
+    _updateSearchIndex();
+
+    // Every match starts in one of the rows of the candidate blocks. The case folded text of a match is the
+    // folded needle, so the rows in which it starts can be narrowed down with a plain string search.
+    // Each of those rows and the ones a match starting in it may span get searched, merging the ranges
+    // that touch each other. Matches don't cross the start of a range that way, so the results are the
+    // same as those of a search through the entire buffer.
+    const auto matchRows = gsl::narrow_cast<til::CoordType>(maxMatchRows);
+    std::vector<std::pair<til::CoordType, til::CoordType>> ranges;
+    std::u16string text;
+    std::vector<size_t> rowStarts;
+    FoldedReflowLine pending;
+    for (const auto block : _searchIndex.FindBlocks(folded))
+    {
+        const auto beg = block * TrigramIndex::BlockSize + 1;
+        const auto end = std::min<size_t>(beg + TrigramIndex::BlockSize, _height + 1);
+        text.clear();
+        rowStarts.clear();
+        for (auto offset = beg; offset < end; ++offset)
+        {
+            rowStarts.emplace_back(text.size());
+            _foldSearchRow(offset, text, pending);
+        }
+        const auto blockEnd = text.size();
+        for (auto offset = end; offset < end + maxMatchRows; ++offset)
+        {
+            _foldSearchRow(offset, text, pending);
+        }
+
+        for (auto pos = text.find(folded); pos < blockEnd; pos = text.find(folded, pos))
+        {
+            const auto row = std::upper_bound(rowStarts.begin(), rowStarts.end(), pos) - rowStarts.begin() - 1;
+            const auto y = _getRowY(beg + row);
+            ranges.emplace_back(y, std::min<til::CoordType>(y + matchRows, _height));
+            // Any further matches in this row are covered by its range already.
+            pos = gsl::narrow_cast<size_t>(row) + 1 < rowStarts.size() ? rowStarts[row + 1] : blockEnd;
+        }
+    }
+    std::sort(ranges.begin(), ranges.end());
+
+    std::vector<til::point_span> results;
+    if (ranges.empty())
+    {
+        return results;
+    }
+
+    uint32_t flags = UREGEX_LITERAL;
+    WI_SetFlagIf(flags, UREGEX_CASE_INSENSITIVE, caseInsensitive);
+
+    UErrorCode status = U_ZERO_ERROR;
+    const auto re = ICU::CreateRegex(needle, flags, &status);
+    const auto committedEnd = _estimateOffsetOfLastCommittedRow() + 1;
+
+    for (auto it = ranges.begin(); it != ranges.end();)
+    {
+        auto [rowBeg, rowEnd] = *it;
+        for (++it; it != ranges.end() && it->first <= rowEnd; ++it)
+        {
+            rowEnd = std::max(rowEnd, it->second);
+        }
+        rowEnd = std::min(rowEnd, committedEnd);
+        if (rowBeg < rowEnd)
+        {
+            findMatches(*this, re.get(), rowBeg, rowEnd, results);
+        }
+    }
+    return results;
 }
 
 // Searches through the given rows [rowBeg,rowEnd) for `needle` and returns the coordinates in absolute coordinates.
@@ -2816,22 +3750,12 @@ std::vector<til::point_span> TextBuffer::SearchText(const std::wstring_view& nee
         return results;
     }
 
-    auto text = ICU::UTextFromTextBuffer(*this, rowBeg, rowEnd);
-
     uint32_t flags = UREGEX_LITERAL;
     WI_SetFlagIf(flags, UREGEX_CASE_INSENSITIVE, caseInsensitive);
 
     UErrorCode status = U_ZERO_ERROR;
     const auto re = ICU::CreateRegex(needle, flags, &status);
-    uregex_setUText(re.get(), &text, &status);
-
-    if (uregex_find(re.get(), -1, &status))
-    {
-        do
-        {
-            results.emplace_back(ICU::BufferRangeFromMatch(&text, re.get()));
-        } while (uregex_findNext(re.get(), &status));
-    }
+    findMatches(*this, re.get(), rowBeg, rowEnd, results);
 
     return results;
 }
@@ -51,10 +51,12 @@ filling in the last row, and updating the screen.
 
 #include <vector>
 
+#include "ColdRowStore.hpp"
 #include "cursor.h"
 #include "Row.hpp"
 #include "TextAttribute.hpp"
-#include "../types/inc/Viewport.hpp"
+#include "TrigramIndex.hpp"
+#include "../types/inc/viewport.hpp"
 
 #include "../buffer/out/textBufferCellIterator.hpp"
 #include "../buffer/out/textBufferTextIterator.hpp"
@@ -178,6 +180,9 @@ public:
 
     til::CoordType TotalRowCount() const noexcept;
 
+    void EnableColdScrollback(bool enable);
+    const ColdRowStore& GetColdRows() const noexcept;
+    const TrigramIndex& GetSearchIndex() const noexcept;
     const TextAttribute& GetCurrentAttributes() const noexcept;
 
     void SetCurrentAttributes(const TextAttribute& currentAttributes) noexcept;
@@ -264,6 +269,9 @@ public:
     };
 
     static void Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const Microsoft::Console::Types::Viewport* lastCharacterViewport = nullptr, PositionInformation* positionInfo = nullptr);
+    static void ReflowLazily(TextBuffer& oldBuffer, TextBuffer& newBuffer, const Microsoft::Console::Types::Viewport* lastCharacterViewport = nullptr, PositionInformation* positionInfo = nullptr);
+    size_t GetPendingReflowRowCount() const noexcept;
+    void FinishReflow();
 
     std::vector<til::point_span> SearchText(const std::wstring_view& needle, bool caseInsensitive) const;
     std::vector<til::point_span> SearchText(const std::wstring_view& needle, bool caseInsensitive, til::CoordType rowBeg, til::CoordType rowEnd) const;
@@ -280,6 +288,69 @@ public:
     std::wstring_view CurrentCommand() const;
 
 private:
+    // The rows of the buffer that ReflowLazily() moved out of the old buffer, split up into the logical lines
+    // that line wrapping forms. The lines are measured once, so that later resizes don't need to look at them.
+    struct ReflowSource
+    {
+        struct Line
+        {
+            // The line consists of the rows [row, row + rows) of the buffer.
+            til::CoordType row = 0;
+            til::CoordType rows = 0;
+            // The line ends without a newline, because the row after it has a different LineRendition.
+            bool open = false;
+            // The text of the line ends in whitespace. Reflow() trims that off the last row it rewraps the line
+            // into, or turns it into a blank row if the text before it fills the rows exactly, which makes
+            // the result of resizing twice depend on the width in between. That's why such lines are copied
+            // instead of staying pending when the buffer is reflowed again.
+            bool trailingWhitespace = false;
+            // Reflow() moves the attributes past the end of the text along with it, into the last row of the line,
+            // and cuts them off at the right edge of that row. Where they don't reach the edge, the last one is
+            // repeated. This is the number of columns of the attributes that the line had past its text in the
+            // buffer, which survived all resizes so far. It's updated whenever the line stays pending.
+            uint16_t tailColumns = 0;
+
+            // Whether Reflow() rewraps the line into the same rows and attributes, no matter which widths it went
+            // through before. Lines that end without a newline, lines with a non-standard LineRendition (which get
+            // truncated to the width of each buffer) and lines ending in whitespace don't, and are copied instead.
+            bool CanStayPending(const ReflowSource& source) const noexcept
+            {
+                return !open && !trailingWhitespace && !(til::at(source.flags, row) & FlagLineRendition);
+            }
+        };
+
+        static constexpr uint8_t FlagWideGlyphs = 1;
+        static constexpr uint8_t FlagLineRendition = 2;
+
+        std::unique_ptr<TextBuffer> buffer;
+        std::vector<Line> lines;
+        // Indexed by row: MeasureRight() and a combination of the Flag* constants.
+        std::vector<uint16_t> limits;
+        std::vector<uint8_t> flags;
+    };
+
+    static constexpr uint32_t _noReflowLine = UINT32_MAX;
+    struct PendingReflowRow
+    {
+        uint32_t line = _noReflowLine;
+        uint32_t part = 0;
+    };
+
+    // The case folded text of each row of the pending line that _foldSearchRow() rewrapped last.
+    struct FoldedReflowLine
+    {
+        uint32_t line = _noReflowLine;
+        std::vector<std::u16string> parts;
+    };
+
+    static void _reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer, const Microsoft::Console::Types::Viewport* lastCharacterViewport, PositionInformation* positionInfo, bool lazy);
+    void _swapRows(TextBuffer& other) noexcept;
+    bool _isReflowPending(size_t offset) const noexcept;
+    void _reflowPendingRow(size_t offset);
+    void _dropPendingReflowRow(size_t offset) noexcept;
+    void _resetReflow() noexcept;
+    til::CoordType _countReflowRows(const ReflowSource& source, uint32_t line, til::CoordType* textEnd = nullptr);
+    til::CoordType _rewrapLine(const ReflowSource& source, uint32_t line, size_t firstOffset, til::CoordType* textEnd = nullptr, std::vector<std::u16string>* foldedParts = nullptr);
     void _reserve(til::size screenBufferSize, const TextAttribute& defaultAttributes);
     void _commit(const std::byte* row);
     void _decommit() noexcept;
@@ -287,6 +358,17 @@ private:
     void _destroy() const noexcept;
     ROW& _getRowByOffsetDirect(size_t offset);
     ROW& _getRow(til::CoordType y) const;
+    size_t _getRowOffset(til::CoordType y) const noexcept;
+    til::CoordType _getRowY(size_t offset) const noexcept;
+    void _thaw(size_t offset);
+    ROW& _reconstruct(size_t offset);
+    void _freeze(size_t offset);
+    void _freezeColdRows();
+    void _tickColdRows();
+    void _resetColdRows() noexcept;
+    std::vector<uint16_t> _getHyperlinks(til::CoordType y) const;
+    void _foldSearchRow(size_t offset, std::u16string& out, FoldedReflowLine& pending) const;
+    void _updateSearchIndex() const;
     til::CoordType _estimateOffsetOfLastCommittedRow() const noexcept;
 
     void _SetFirstRowIndex(const til::CoordType FirstRowIndex) noexcept;
@@ -371,6 +453,38 @@ private:
 
     TextAttribute _currentAttributes;
     til::CoordType _firstRow = 0; // indexes top row (not necessarily 0)
+
+    // This block describes the compressed scrollback. ROWs that are more than _coldRowDistance rows above the
+    // cursor get encoded into _coldRows and destroyed ("frozen"), and the pages of the arena that only hold such
+    // ROWs get MEM_DECOMMITed. Accessing a frozen ROW decodes it back into its place in the arena ("thaws" it),
+    // so that references returned by GetRowByOffset() stay valid as usual. Thawed ROWs are frozen again with the
+    // next batch, which runs every _coldRowInterval newlines, and only need to be encoded again if modified.
+    ColdRowStore _coldRows;
+    // The arena offsets of the ROWs that were thawed since the last batch.
+    std::vector<size_t> _thawedRows;
+    // Rows above this y have been frozen (or thawed since). It moves up with every IncrementCircularBuffer().
+    til::CoordType _frozenLimit = 0;
+    // A bit per page of the arena, set if the page was MEM_DECOMMITed because it only holds frozen ROWs.
+    std::vector<bool> _decommittedPages;
+    uint32_t _coldRowTicks = 0;
+    bool _coldScrollback = true;
+    static constexpr til::CoordType _coldRowDistance = 1024;
+    static constexpr uint32_t _coldRowInterval = 64;
+    // The page size of all platforms that we support.
+    static constexpr size_t _pageSize = 4096;
+
+    // The trigrams of the text of all rows, which SearchText() uses to only look at the rows that may contain
+    // the needle. It's built by the first search, and GetMutableRowByOffset() marks the parts that need updating.
+    mutable TrigramIndex _searchIndex;
+
+    // This block describes the rows that ReflowLazily() hasn't rewrapped yet. Each such "pending" row knows the line
+    // of _reflowSource it belongs to and which of the line's rows it is. The first access to a pending row rewraps
+    // the entire line into those of its rows that are still pending (see _reflowPendingRow()).
+    std::unique_ptr<ReflowSource> _reflowSource;
+    // Indexed by arena offset. Empty if no rows are pending.
+    std::vector<PendingReflowRow> _pendingReflowRows;
+    size_t _pendingReflowRowCount = 0;
+
     uint64_t _lastMutationId = 0;
 
     Cursor _cursor;
@@ -0,0 +1,222 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+#include "../../inc/consoletaeftemplates.hpp"
+
+#include "../textBuffer.hpp"
+#include "../../renderer/inc/DummyRenderer.hpp"
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+namespace
+{
+    struct TestRow
+    {
+        explicit TestRow(uint16_t width) :
+            chars{ std::make_unique<wchar_t[]>(width) },
+            charOffsets{ std::make_unique<uint16_t[]>(width + 1) },
+            row{ chars.get(), charOffsets.get(), width, {} }
+        {
+        }
+
+        void Write(til::CoordType column, std::wstring_view text, const TextAttribute& attr = {})
+        {
+            RowWriteState state{ .text = text, .columnBegin = column };
+            row.ReplaceText(state);
+            row.ReplaceAttributes(state.columnBegin, state.columnEnd, attr);
+        }
+
+        std::unique_ptr<wchar_t[]> chars;
+        std::unique_ptr<uint16_t[]> charOffsets;
+        ROW row;
+    };
+
+    void verifyRowsEqual(const ROW& expected, const ROW& actual)
+    {
+        VERIFY_ARE_EQUAL(expected.GetText(), actual.GetText());
+        VERIFY_IS_TRUE(expected.Attributes() == actual.Attributes());
+        VERIFY_ARE_EQUAL(expected.WasWrapForced(), actual.WasWrapForced());
+        VERIFY_ARE_EQUAL(expected.WasDoubleBytePadded(), actual.WasDoubleBytePadded());
+        VERIFY_ARE_EQUAL(expected.GetLineRendition(), actual.GetLineRendition());
+        for (til::CoordType column = 0; column < expected.size(); ++column)
+        {
+            VERIFY_ARE_EQUAL(expected.GlyphAt(column), actual.GlyphAt(column));
+            VERIFY_ARE_EQUAL(expected.DbcsAttrAt(column), actual.DbcsAttrAt(column));
+        }
+    }
+
+    // Freezes the row, thaws it into a row that holds something else and compares the two.
+    void verifyRoundtrip(const ROW& row)
+    {
+        ColdRowStore store;
+        store.Freeze(1, 2, row);
+        VERIFY_IS_TRUE(store.IsCold(1));
+        VERIFY_ARE_EQUAL(1u, store.ColdRowCount());
+
+        TestRow actual{ gsl::narrow<uint16_t>(row.size()) };
+        actual.Write(0, L"garbage \xD83D\xDE00 garbage", TextAttribute{ 0x1f });
+        actual.row.SetWrapForced(true);
+        store.Thaw(1, actual.row);
+        VERIFY_IS_FALSE(store.IsCold(1));
+        VERIFY_IS_TRUE(store.HasRecord(1));
+        VERIFY_ARE_EQUAL(0u, store.ColdRowCount());
+        verifyRowsEqual(row, actual.row);
+    }
+}
+
+class ColdRowStoreTests
+{
+    TEST_CLASS(ColdRowStoreTests);
+
+    TEST_METHOD(TestRoundtripBlank);
+    TEST_METHOD(TestRoundtripLatin1);
+    TEST_METHOD(TestRoundtripComplex);
+    TEST_METHOD(TestRoundtripUnpairedSurrogates);
+    TEST_METHOD(TestRoundtripOverlong);
+    TEST_METHOD(TestHyperlinks);
+    TEST_METHOD(TestDiscard);
+    TEST_METHOD(TestTextBufferScrollback);
+};
+
+void ColdRowStoreTests::TestRoundtripBlank()
+{
+    TestRow row{ 80 };
+    verifyRoundtrip(row.row);
+}
+
+void ColdRowStoreTests::TestRoundtripLatin1()
+{
+    TestRow row{ 80 };
+    row.Write(0, L"caf\xe9  ");
+    row.Write(10, L"trailing spaces are left out", TextAttribute{ 0x0a });
+    verifyRoundtrip(row.row);
+}
+
+void ColdRowStoreTests::TestRoundtripComplex()
+{
+    TestRow row{ 40 };
+    row.Write(0, L"\x6587\x5b57\x5217");
+    row.Write(6, L"\xD83D\xDE00", TextAttribute{ 0x0c });
+    row.Write(8, L"e\x0301\x043f\x0440");
+    // The wide glyph doesn't fit into the last column, which pads it.
+    row.Write(39, L"\x6587");
+    row.row.SetWrapForced(true);
+    row.row.SetDoubleBytePadded(true);
+    row.row.SetLineRendition(LineRendition::DoubleWidth);
+    verifyRoundtrip(row.row);
+}
+
+void ColdRowStoreTests::TestRoundtripUnpairedSurrogates()
+{
+    TestRow row{ 20 };
+    row.Write(0, L"a\xD800" L"b\xDC00" L"c");
+    verifyRoundtrip(row.row);
+}
+
+void ColdRowStoreTests::TestRoundtripOverlong()
+{
+    // More text than columns spills over into ROW::_charsHeap.
+    // U+1D400 is a narrow character outside of the BMP.
+    std::wstring text;
+    for (auto i = 0; i < 10; ++i)
+    {
+        text.append(L"\xD835\xDC00");
+    }
+
+    TestRow row{ 10 };
+    row.Write(0, text);
+    VERIFY_ARE_EQUAL(text, row.row.GetText());
+    verifyRoundtrip(row.row);
+}
+
+void ColdRowStoreTests::TestHyperlinks()
+{
+    TextAttribute link;
+    link.SetHyperlinkId(42);
+
+    TestRow row{ 40 };
+    row.Write(0, L"see ");
+    row.Write(4, L"https://example.com", link);
+
+    ColdRowStore store;
+    store.Freeze(3, 4, row.row);
+    const auto hyperlinks = store.GetHyperlinks(3);
+    VERIFY_ARE_EQUAL(1u, hyperlinks.size());
+    VERIFY_ARE_EQUAL(42, hyperlinks[0]);
+    verifyRoundtrip(row.row);
+}
+
+void ColdRowStoreTests::TestDiscard()
+{
+    TestRow row{ 80 };
+    row.Write(0, L"some text");
+
+    ColdRowStore store;
+    for (size_t i = 0; i < 10000; ++i)
+    {
+        store.Freeze(i, 10000, row.row);
+    }
+    VERIFY_ARE_EQUAL(10000u, store.ColdRowCount());
+    const auto usage = store.MemoryUsage();
+
+    // Discarding all records frees their chunks and makes room for new records.
+    for (size_t i = 0; i < 10000; ++i)
+    {
+        store.Discard(i);
+    }
+    VERIFY_ARE_EQUAL(0u, store.ColdRowCount());
+    VERIFY_IS_FALSE(store.IsCold(0));
+    VERIFY_IS_FALSE(store.HasRecord(0));
+    VERIFY_IS_LESS_THAN(store.MemoryUsage(), usage);
+
+    for (size_t i = 0; i < 10000; ++i)
+    {
+        store.Freeze(i, 10000, row.row);
+    }
+    VERIFY_ARE_EQUAL(usage, store.MemoryUsage());
+}
+
+void ColdRowStoreTests::TestTextBufferScrollback()
+{
+    DummyRenderer renderer;
+    TextBuffer buffer{ { 20, 5000 }, {}, 0, false, renderer };
+
+    const auto writeLine = [&](til::CoordType y, std::wstring_view text) {
+        RowWriteState state{ .text = text };
+        buffer.Write(y, {}, state);
+    };
+
+    // Fill the buffer and then some, so that it rotates 1001 times.
+    for (auto i = 0; i < 6000; ++i)
+    {
+        writeLine(buffer.GetCursor().GetPosition().y, L"line " + std::to_wstring(i));
+        buffer.NewlineCursor();
+    }
+    VERIFY_IS_GREATER_THAN(buffer.GetColdRows().ColdRowCount(), 3000u);
+
+    // Reading a frozen row thaws it.
+    VERIFY_ARE_EQUAL(L"line 1001", buffer.GetRowByOffset(0).GetText().substr(0, 9));
+
+    // A modified row has to be encoded anew when it's frozen again.
+    writeLine(1000, L"modified");
+    for (auto i = 0; i < 200; ++i)
+    {
+        buffer.NewlineCursor();
+    }
+    VERIFY_IS_GREATER_THAN(buffer.GetColdRows().ColdRowCount(), 3000u);
+    VERIFY_ARE_EQUAL(L"modified1", buffer.GetRowByOffset(800).GetText().substr(0, 9));
+
+    // Disabling the compression thaws all rows.
+    buffer.EnableColdScrollback(false);
+    VERIFY_ARE_EQUAL(0u, buffer.GetColdRows().ColdRowCount());
+    for (til::CoordType y = 0; y < 4799; ++y)
+    {
+        const auto expected = y == 800 ? std::wstring{ L"modified1" } : L"line " + std::to_wstring(1201 + y);
+        VERIFY_ARE_EQUAL(expected, buffer.GetRowByOffset(y).GetText().substr(0, expected.size()));
+    }
+    VERIFY_ARE_EQUAL(std::wstring(20, L' '), buffer.GetRowByOffset(4799).GetText());
+}
@@ -723,13 +723,115 @@ class ReflowTests
         return buffer;
     }
 
-    static std::unique_ptr<TextBuffer> _textBufferByReflowingTextBuffer(TextBuffer& originalBuffer, const til::size newSize)
+    static std::unique_ptr<TextBuffer> _textBufferByReflowingTextBuffer(TextBuffer& originalBuffer, const til::size newSize, bool lazy = false)
     {
         auto buffer = std::make_unique<TextBuffer>(newSize, TextAttribute{ 0x7 }, 0, false, renderer);
-        TextBuffer::Reflow(originalBuffer, *buffer);
+        if (lazy)
+        {
+            TextBuffer::ReflowLazily(originalBuffer, *buffer);
+        }
+        else
+        {
+            TextBuffer::Reflow(originalBuffer, *buffer);
+        }
         return buffer;
     }
 
+    // Writes the text at the cursor and wraps it across as many rows as it needs.
+    static void _write(TextBuffer& buffer, std::wstring_view text, const TextAttribute& attributes)
+    {
+        auto& cursor = buffer.GetCursor();
+        RowWriteState state{ .text = text, .columnBegin = cursor.GetPosition().x };
+        for (;;)
+        {
+            const auto y = cursor.GetPosition().y;
+            buffer.Write(y, attributes, state);
+            cursor.SetXPosition(state.columnEnd);
+            if (state.text.empty())
+            {
+                break;
+            }
+            buffer.SetWrapForced(y, true);
+            buffer.NewlineCursor();
+            state.columnBegin = 0;
+        }
+    }
+
+    // Fills the buffer with more lines than it has rows. Some of them wrap, contain wide glyphs or
+    // colors, have a non-standard line rendition, or are empty, and some of them have a mark.
+    static void _fillTextBuffer(TextBuffer& buffer, int lines = 400)
+    {
+        const TextAttribute plain{ 0x7 };
+        const TextAttribute colored{ 0x1e };
+        for (auto i = 1; i < lines; ++i)
+        {
+            const auto y = buffer.GetCursor().GetPosition().y;
+            if (i % 7 == 0)
+            {
+                ScrollMark mark{ .start = { 0, y }, .end = { 5, y } };
+                if (i % 2 == 0)
+                {
+                    mark.commandEnd = til::point{ 12, y };
+                }
+                buffer.StartPromptMark(mark);
+            }
+            if (i % 19 == 0)
+            {
+                // The line before this one wraps into it, but can't, because its line rendition differs.
+                buffer.SetWrapForced(y - 1, true);
+                buffer.SetCurrentLineRendition(LineRendition::DoubleWidth, plain);
+            }
+            if (i % 17 != 0)
+            {
+                _write(buffer, L"line " + std::to_wstring(i), plain);
+            }
+            if (i % 3 == 0 && i % 19 != 0)
+            {
+                _write(buffer, i % 2 ? L" the quick brown fox jumps over the lazy dog" : L" \x4E00\x4E8C\x4E09 wide \x56DB\x4E94\x516D\x4E03\x516B\x4E5D\x5341 glyphs \x767E\x5343", plain);
+            }
+            if (i % 5 == 0 && i % 19 != 0)
+            {
+                // Colored text in the middle of the line, which continues in the default colors,
+                // or at the end of it, whose color extends into the rest of the row when it gets wider.
+                _write(buffer, std::wstring(i % 40 + 10, L'#'), colored);
+                if (i % 2)
+                {
+                    _write(buffer, L" end", plain);
+                }
+            }
+            buffer.NewlineCursor();
+        }
+    }
+
+    static void _compareTextBuffers(const TextBuffer& expected, const TextBuffer& actual)
+    {
+        VERIFY_ARE_EQUAL(expected.GetSize().Dimensions(), actual.GetSize().Dimensions());
+        VERIFY_ARE_EQUAL(expected.GetCursor().GetPosition(), actual.GetCursor().GetPosition());
+
+        for (til::CoordType y = 0; y < expected.TotalRowCount(); ++y)
+        {
+            const auto& expectedRow = expected.GetRowByOffset(y);
+            const auto& actualRow = actual.GetRowByOffset(y);
+            const auto indexString = NoThrowString().Format(L"[Row %d]", y);
+            VERIFY_ARE_EQUAL(std::wstring{ expectedRow.GetText() }, std::wstring{ actualRow.GetText() }, indexString);
+            VERIFY_ARE_EQUAL(expectedRow.WasWrapForced(), actualRow.WasWrapForced(), indexString);
+            VERIFY_ARE_EQUAL(expectedRow.WasDoubleBytePadded(), actualRow.WasDoubleBytePadded(), indexString);
+            VERIFY_IS_TRUE(expectedRow.GetLineRendition() == actualRow.GetLineRendition(), indexString);
+            VERIFY_IS_TRUE(expectedRow.Attributes() == actualRow.Attributes(), indexString);
+        }
+
+        const auto& expectedMarks = expected.GetMarks();
+        const auto& actualMarks = actual.GetMarks();
+        VERIFY_ARE_EQUAL(expectedMarks.size(), actualMarks.size());
+        for (size_t i = 0; i < expectedMarks.size() && i < actualMarks.size(); ++i)
+        {
+            VERIFY_ARE_EQUAL(expectedMarks[i].start, actualMarks[i].start);
+            VERIFY_ARE_EQUAL(expectedMarks[i].end, actualMarks[i].end);
+            VERIFY_IS_TRUE(expectedMarks[i].commandEnd == actualMarks[i].commandEnd);
+            VERIFY_IS_TRUE(expectedMarks[i].outputEnd == actualMarks[i].outputEnd);
+        }
+    }
+
     static void _compareTextBufferAgainstTestBuffer(const TextBuffer& buffer, const TestBuffer& testBuffer)
     {
         VERIFY_ARE_EQUAL(testBuffer.cursor, buffer.GetCursor().GetPosition());
@@ -782,6 +884,151 @@ class ReflowTests
             TEST_METHOD_PROPERTY(L"DataSource", L"Export:ReflowTestDataSource")
         END_TEST_METHOD_PROPERTIES()
 
+        _testReflowCase(false);
+    }
+
+    TEST_METHOD(TestReflowCasesLazily)
+    {
+        BEGIN_TEST_METHOD_PROPERTIES()
+            TEST_METHOD_PROPERTY(L"DataSource", L"Export:ReflowTestDataSource")
+        END_TEST_METHOD_PROPERTIES()
+
+        _testReflowCase(true);
+    }
+
+    TEST_METHOD(TestReflowLazily)
+    {
+        // Reflowing lazily must result in the same buffer as reflowing right away, including the cursor, the attributes,
+        // the marks and the position information, no matter whether the pending rows get accessed before the next resize.
+        static constexpr til::size sizes[]{
+            { 80, 1500 },
+            { 23, 1500 },
+            { 23, 2000 },
+            { 51, 2000 },
+            { 9, 3000 },
+            { 37, 3000 },
+            { 120, 2500 },
+            { 64, 2500 },
+            { 44, 1800 },
+            { 97, 1800 },
+            { 200, 40 },
+        };
+
+        auto expected = std::make_unique<TextBuffer>(til::size{ 37, 1500 }, TextAttribute{ 0x7 }, 0, false, renderer);
+        auto actual = std::make_unique<TextBuffer>(til::size{ 37, 1500 }, TextAttribute{ 0x7 }, 0, false, renderer);
+        _fillTextBuffer(*expected, 4000);
+        _fillTextBuffer(*actual, 4000);
+
+        for (size_t i = 0; i < std::size(sizes); ++i)
+        {
+            Log::Comment(NoThrowString().Format(L"Resizing to %dx%d", sizes[i].width, sizes[i].height));
+
+            const auto cursorY = expected->GetCursor().GetPosition().y;
+            TextBuffer::PositionInformation expectedInfo{
+                .mutableViewportTop = std::max(0, cursorY - 20),
+                .visibleViewportTop = std::max(0, cursorY - 60),
+            };
+            auto actualInfo = expectedInfo;
+
+            auto expectedBuffer = std::make_unique<TextBuffer>(sizes[i], TextAttribute{ 0x7 }, 0, false, renderer);
+            auto actualBuffer = std::make_unique<TextBuffer>(sizes[i], TextAttribute{ 0x7 }, 0, false, renderer);
+            TextBuffer::Reflow(*expected, *expectedBuffer, nullptr, &expectedInfo);
+            TextBuffer::ReflowLazily(*actual, *actualBuffer, nullptr, &actualInfo);
+            expected = std::move(expectedBuffer);
+            actual = std::move(actualBuffer);
+
+            VERIFY_ARE_EQUAL(expectedInfo.mutableViewportTop, actualInfo.mutableViewportTop);
+            VERIFY_ARE_EQUAL(expectedInfo.visibleViewportTop, actualInfo.visibleViewportTop);
+            // Unless the buffer gets so small that the lines below the viewport tops fill it, some rows are left pending.
+            if (sizes[i].height > 100)
+            {
+                VERIFY_IS_GREATER_THAN(actual->GetPendingReflowRowCount(), 0u);
+            }
+
+            // Rewrap some or all of the pending rows before some of the resizes,
+            // which then need to copy those lines instead of leaving them pending.
+            switch (i % 3)
+            {
+            case 1:
+                for (til::CoordType y = 0; y < actual->TotalRowCount(); y += 13)
+                {
+                    actual->GetRowByOffset(y);
+                }
+                break;
+            case 2:
+                _compareTextBuffers(*expected, *actual);
+                break;
+            default:
+                break;
+            }
+
+            // New output between the resizes moves the pending rows up and overwrites the oldest ones.
+            for (auto j = 0; j < 50; ++j)
+            {
+                for (auto buffer : { expected.get(), actual.get() })
+                {
+                    _write(*buffer, L"output " + std::to_wstring(j), j % 2 ? TextAttribute{ 0x1e } : TextAttribute{ 0x7 });
+                    buffer->NewlineCursor();
+                }
+            }
+        }
+
+        _compareTextBuffers(*expected, *actual);
+        VERIFY_ARE_EQUAL(0u, actual->GetPendingReflowRowCount());
+
+        // New output recycles rows, pending or not.
+        auto lazy = std::make_unique<TextBuffer>(til::size{ 61, 150 }, TextAttribute{ 0x7 }, 0, false, renderer);
+        auto eager = std::make_unique<TextBuffer>(til::size{ 61, 150 }, TextAttribute{ 0x7 }, 0, false, renderer);
+        TextBuffer::ReflowLazily(*actual, *lazy);
+        TextBuffer::Reflow(*expected, *eager);
+        for (auto i = 0; i < 100; ++i)
+        {
+            for (auto buffer : { lazy.get(), eager.get() })
+            {
+                _write(*buffer, L"more output " + std::to_wstring(i), TextAttribute{ 0x7 });
+                buffer->NewlineCursor();
+            }
+        }
+        VERIFY_IS_GREATER_THAN(lazy->GetPendingReflowRowCount(), 0u);
+        lazy->FinishReflow();
+        VERIFY_ARE_EQUAL(0u, lazy->GetPendingReflowRowCount());
+        _compareTextBuffers(*eager, *lazy);
+    }
+
+    TEST_METHOD(TestReflowLazilyAroundTheEnd)
+    {
+        // Narrowing the buffer and making it shorter makes the pending lines wrap around its end several times.
+        // The 2999 lines that are left in the buffer take up 5998 rows at the new width, which puts the cursor
+        // into the first row of the new buffer and the pending rows after it past the ones it committed so far.
+        auto expected = std::make_unique<TextBuffer>(til::size{ 20, 3000 }, TextAttribute{ 0x7 }, 0, false, renderer);
+        auto actual = std::make_unique<TextBuffer>(til::size{ 20, 3000 }, TextAttribute{ 0x7 }, 0, false, renderer);
+        for (auto i = 0; i < 4000; ++i)
+        {
+            for (auto buffer : { expected.get(), actual.get() })
+            {
+                _write(*buffer, L"line " + std::to_wstring(i), i % 2 ? TextAttribute{ 0x1e } : TextAttribute{ 0x7 });
+                buffer->NewlineCursor();
+            }
+        }
+
+        auto expectedBuffer = std::make_unique<TextBuffer>(til::size{ 5, 1999 }, TextAttribute{ 0x7 }, 0, false, renderer);
+        auto actualBuffer = std::make_unique<TextBuffer>(til::size{ 5, 1999 }, TextAttribute{ 0x7 }, 0, false, renderer);
+        TextBuffer::Reflow(*expected, *expectedBuffer);
+        TextBuffer::ReflowLazily(*actual, *actualBuffer);
+        VERIFY_IS_GREATER_THAN(actualBuffer->GetPendingReflowRowCount(), 1000u);
+
+        // Searches only look at the rows that are committed, which must include the pending ones.
+        const auto expectedMatches = expectedBuffer->SearchText(L"line 39", false, 0, til::CoordTypeMax);
+        const auto actualMatches = actualBuffer->SearchText(L"line 39", false, 0, til::CoordTypeMax);
+        VERIFY_ARE_EQUAL(expectedMatches.size(), actualMatches.size());
+        VERIFY_IS_GREATER_THAN(actualMatches.size(), 0u);
+
+        _compareTextBuffers(*expectedBuffer, *actualBuffer);
+        VERIFY_ARE_EQUAL(0u, actualBuffer->GetPendingReflowRowCount());
+    }
+
+    static void _testReflowCase(bool lazy)
+    {
         WEX::TestExecution::DisableVerifyExceptions disableVerifyExceptions{};
         WEX::TestExecution::SetVerifyOutput verifyOutputScope{ WEX::TestExecution::VerifyOutputSettings::LogOnlyFailures };
 
@@ -797,7 +1044,7 @@ class ReflowTests
             const auto& testBuffer{ til::at(testCase.buffers, bufferIndex) };
             Log::Comment(NoThrowString().Format(L"[%zu.%zu] Resizing to %dx%d", i, bufferIndex, testBuffer.size.width, testBuffer.size.height));
 
-            auto newBuffer{ _textBufferByReflowingTextBuffer(*textBuffer, testBuffer.size) };
+            auto newBuffer{ _textBufferByReflowingTextBuffer(*textBuffer, testBuffer.size, lazy) };
 
             // All future operations are based on the new buffer
             std::swap(textBuffer, newBuffer);
@@ -0,0 +1,224 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+#include "../../inc/consoletaeftemplates.hpp"
+
+#include "../textBuffer.hpp"
+#include "../../renderer/inc/DummyRenderer.hpp"
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+namespace
+{
+    std::u16string fold(std::wstring_view text)
+    {
+        std::u16string out;
+        TrigramIndex::Fold(text, out);
+        return out;
+    }
+
+    void writeLine(TextBuffer& buffer, std::wstring_view text)
+    {
+        RowWriteState state{ .text = text };
+        buffer.Write(buffer.GetCursor().GetPosition().y, {}, state);
+        buffer.NewlineCursor();
+    }
+
+    // The indexed search must return exactly what a search through all rows returns.
+    void verifySearch(const TextBuffer& buffer, std::wstring_view needle, bool caseInsensitive)
+    {
+        const auto expected = buffer.SearchText(needle, caseInsensitive, 0, til::CoordTypeMax);
+        const auto actual = buffer.SearchText(needle, caseInsensitive);
+        VERIFY_ARE_EQUAL(expected.size(), actual.size());
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            VERIFY_ARE_EQUAL(expected[i].start, actual[i].start);
+            VERIFY_ARE_EQUAL(expected[i].end, actual[i].end);
+        }
+    }
+}
+
+class TrigramIndexTests
+{
+    TEST_CLASS(TrigramIndexTests);
+
+    TEST_METHOD(TestFold);
+    TEST_METHOD(TestFindBlocks);
+    TEST_METHOD(TestInvalidate);
+    TEST_METHOD(TestSearchText);
+    TEST_METHOD(TestSearchTextLeavesRowsAlone);
+};
+
+void TrigramIndexTests::TestFold()
+{
+    VERIFY_IS_TRUE(fold(L"Hello, World") == u"hello, world");
+    // Full case folding turns the sharp s into "ss", just like ICU's case insensitive matching.
+    VERIFY_IS_TRUE(fold(L"Stra\xDF" L"e") == u"strasse");
+    VERIFY_IS_TRUE(fold(L"\x041F\x0420\x0418") == u"\x043F\x0440\x0438");
+    // U+10400 DESERET CAPITAL LETTER LONG I folds to U+10428.
+    VERIFY_IS_TRUE(fold(L"\xD801\xDC00") == u"\xD801\xDC28");
+}
+
+void TrigramIndexTests::TestFindBlocks()
+{
+    TrigramIndex index;
+    index.Reset(3 * TrigramIndex::BlockSize);
+    VERIFY_ARE_EQUAL(3u, index.BlockCount());
+    VERIFY_IS_TRUE(index.IsDirty(0));
+
+    // Each block's text ends with the first 2 code units of the next block.
+    index.SetBlock(0, u"the quick brown fox ju");
+    index.SetBlock(1, u"jumps over the lazy dogan");
+    // The last block continues in the first one.
+    index.SetBlock(2, u"and then it wrath");
+    VERIFY_IS_FALSE(index.IsDirty(0));
+
+    VERIFY_IS_TRUE(index.FindBlocks(u"quick") == std::vector<size_t>{ 0 });
+    VERIFY_IS_TRUE(index.FindBlocks(u"the ") == (std::vector<size_t>{ 0, 1, 2 }));
+    VERIFY_IS_TRUE(index.FindBlocks(u"fox jumps") == std::vector<size_t>{ 0 });
+    VERIFY_IS_TRUE(index.FindBlocks(u"wrathe quick") == std::vector<size_t>{ 2 });
+    VERIFY_IS_TRUE(index.FindBlocks(u"lazy cat").empty());
+    VERIFY_IS_GREATER_THAN(index.MemoryUsage(), 0u);
+}
+
+void TrigramIndexTests::TestInvalidate()
+{
+    TrigramIndex index;
+    // Does nothing as long as the index doesn't exist.
+    index.Invalidate(0);
+
+    index.Reset(3 * TrigramIndex::BlockSize);
+    for (size_t block = 0; block < 3; ++block)
+    {
+        index.SetBlock(block, u"");
+    }
+
+    // The previous row's trigrams extend into this one.
+    index.Invalidate(TrigramIndex::BlockSize);
+    VERIFY_IS_TRUE(index.IsDirty(0));
+    VERIFY_IS_TRUE(index.IsDirty(1));
+    VERIFY_IS_FALSE(index.IsDirty(2));
+
+    index.SetBlock(0, u"");
+    index.SetBlock(1, u"");
+    index.Invalidate(0);
+    VERIFY_IS_TRUE(index.IsDirty(0));
+    VERIFY_IS_FALSE(index.IsDirty(1));
+    VERIFY_IS_TRUE(index.IsDirty(2));
+
+    index.Clear();
+    VERIFY_ARE_EQUAL(0u, index.BlockCount());
+    index.Invalidate(0);
+}
+
+void TrigramIndexTests::TestSearchText()
+{
+    DummyRenderer renderer;
+    TextBuffer buffer{ { 20, 1000 }, {}, 0, false, renderer };
+
+    // Lines longer than the buffer is wide wrap, which makes some matches span rows and blocks.
+    for (auto i = 0; i < 1500; ++i)
+    {
+        std::wstring line = L"line " + std::to_wstring(i);
+        if (i % 97 == 0)
+        {
+            line.append(L" the Needle in the haystack, the NEEDLE again");
+        }
+        if (i % 131 == 0)
+        {
+            line.append(L" Stra\xDF" L"e \x041F\x0420\x0418\x0412\x0415\x0422");
+        }
+        writeLine(buffer, line);
+    }
+
+    static constexpr std::wstring_view needles[]{
+        L"needle",
+        L"Needle in the haystack",
+        L"line 1499",
+        L"strasse",
+        L"\x043F\x0440\x0438\x0432\x0435\x0442",
+        L"not there at all",
+        L"ne",
+        L"e 14",
+        L"ck, the",
+        L"the Needle in the haystack, the NEEDLE again line",
+    };
+    for (const auto needle : needles)
+    {
+        verifySearch(buffer, needle, false);
+        verifySearch(buffer, needle, true);
+    }
+    VERIFY_IS_FALSE(buffer.SearchText(L"needle", true).empty());
+    VERIFY_IS_TRUE(buffer.SearchText(L"needle", false).empty());
+    VERIFY_IS_GREATER_THAN(buffer.GetSearchIndex().BlockCount(), 0u);
+
+    // Writing more output and modifying rows updates the index.
+    for (auto i = 0; i < 100; ++i)
+    {
+        writeLine(buffer, L"more output " + std::to_wstring(i));
+    }
+    RowWriteState state{ .text = L"a modified needle" };
+    buffer.Write(500, {}, state);
+    for (const auto needle : needles)
+    {
+        verifySearch(buffer, needle, false);
+        verifySearch(buffer, needle, true);
+    }
+    verifySearch(buffer, L"modified", true);
+    verifySearch(buffer, L"output 99", false);
+    VERIFY_ARE_EQUAL(1u, buffer.SearchText(L"modified needle", false).size());
+
+    // Resetting the buffer drops the index.
+    buffer.Reset();
+    VERIFY_ARE_EQUAL(0u, buffer.GetSearchIndex().BlockCount());
+    VERIFY_IS_TRUE(buffer.SearchText(L"needle", true).empty());
+}
+
+void TrigramIndexTests::TestSearchTextLeavesRowsAlone()
+{
+    DummyRenderer renderer;
+    auto buffer = std::make_unique<TextBuffer>(til::size{ 80, 2000 }, TextAttribute{}, 0, false, renderer);
+    for (auto i = 0; i < 3000; ++i)
+    {
+        std::wstring line = L"line " + std::to_wstring(i);
+        if (i % 97 == 0)
+        {
+            line.append(L" the Needle in the haystack, the NEEDLE again");
+        }
+        writeLine(*buffer, line);
+    }
+
+    // Unlike the regex, which looks at the rows that may contain a match, the indexed search runs on the
+    // rows as they are. The results must still be those of a search through all rows, which materializes them.
+    const auto verifyIndexedSearch = [](const TextBuffer& buffer, std::wstring_view needle) {
+        const auto actual = buffer.SearchText(needle, true);
+        const auto expected = buffer.SearchText(needle, true, 0, til::CoordTypeMax);
+        VERIFY_IS_GREATER_THAN(expected.size(), 0u);
+        VERIFY_ARE_EQUAL(expected.size(), actual.size());
+        for (size_t i = 0; i < expected.size() && i < actual.size(); ++i)
+        {
+            VERIFY_ARE_EQUAL(expected[i].start, actual[i].start);
+            VERIFY_ARE_EQUAL(expected[i].end, actual[i].end);
+        }
+    };
+
+    // Building the index reads the frozen rows of the scrollback without thawing them...
+    const auto coldRows = buffer->GetColdRows().ColdRowCount();
+    VERIFY_IS_GREATER_THAN(coldRows, 0u);
+    VERIFY_IS_TRUE(buffer->SearchText(L"not in the buffer", true).empty());
+    VERIFY_ARE_EQUAL(coldRows, buffer->GetColdRows().ColdRowCount());
+    verifyIndexedSearch(*buffer, L"needle");
+
+    // ...and the rows that ReflowLazily() hasn't rewrapped yet without rewrapping them.
+    auto narrow = std::make_unique<TextBuffer>(til::size{ 13, 2000 }, TextAttribute{}, 0, false, renderer);
+    TextBuffer::ReflowLazily(*buffer, *narrow);
+    const auto pendingRows = narrow->GetPendingReflowRowCount();
+    VERIFY_IS_GREATER_THAN(pendingRows, 0u);
+    VERIFY_IS_TRUE(narrow->SearchText(L"not in the buffer", true).empty());
+    VERIFY_ARE_EQUAL(pendingRows, narrow->GetPendingReflowRowCount());
+    verifyIndexedSearch(*narrow, L"needle in the haystack");
+}
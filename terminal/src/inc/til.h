@@ -14,6 +14,14 @@
 
 #define _TIL_INLINEPREFIX __declspec(noinline) inline
 
+// Allows the use of the intrinsics of an instruction set in a function, which MSVC does
+// anywhere, but GCC and clang only in functions that are compiled for it.
+#if defined(__GNUC__) || defined(__clang__)
+#define _TIL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define _TIL_TARGET(isa)
+#endif
+
 #include "til/at.h"
 #include "til/bitmap.h"
 #include "til/coalesce.h"
@@ -13,11 +13,11 @@
 #pragma warning(disable : 26494) // Variable '...' is uninitialized. Always initialize an object (type.5).
 #pragma warning(disable : 26496) // The variable '...' does not change after construction, mark it as const (con.4).
 
-#if defined(_M_X64) && !defined(_M_ARM64EC)
+#if (defined(_M_X64) || __x86_64__) && !defined(_M_ARM64EC)
 #define TIL_HASH_X64
-#elif defined(_M_ARM64) || defined(_M_ARM64EC)
+#elif defined(_M_ARM64) || defined(_M_ARM64EC) || __aarch64__
 #define TIL_HASH_ARM64
-#elif defined(_M_IX86) || defined(_M_ARM)
+#elif defined(_M_IX86) || defined(_M_ARM) || __i386__ || __arm__
 #define TIL_HASH_32BIT
 #else
 #error "Unsupported architecture for til::hash"
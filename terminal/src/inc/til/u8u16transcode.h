@@ -0,0 +1,569 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- u8u16transcode.h
+
+Abstract:
+- Defines a UTF-8 validator and a UTF-8 to UTF-16 transcoder, vectorized with
+  SSE4.1 and AVX2 and with a scalar fallback, which til::u8u16 is built on.
+- Ill-formed input is replaced the same way MultiByteToWideChar(CP_UTF8)
+  does: each maximal subpart of an ill-formed sequence ("U+FFFD Substitution
+  of Maximal Subparts" in chapter 3 of the Unicode standard) becomes one
+  U+FFFD. The output never has more code units than the input has bytes.
+- The vector path is the one of "Transcoding Billions of Unicode Characters
+  per Second with SIMD Instructions" (Lemire, Muła 2021): a mask of the bytes
+  that end a character indexes a table of shuffles, which gather 6 characters
+  of up to 2 bytes, 4 of up to 3 bytes or 3 of up to 4 bytes into lanes where
+  they are decoded and validated at once. Anything the vector code doesn't
+  accept, including all ill-formed input, is left to the scalar code.
+- Pure ASCII is widened 16 (SSE4.1) or 32 (AVX2) bytes per iteration.
+--*/
+
+#pragma once
+
+#if defined(TIL_SSE_INTRINSICS)
+#include <isa_availability.h>
+extern "C" int __isa_available;
+#endif
+
+#pragma warning(push)
+#pragma warning(disable : 26429 26446 26459 26481 26482 26490) // use not_null, subscript operator, use span, pointer arithmetic, dynamic array indexing, reinterpret_cast
+
+namespace til // Terminal Implementation Library. Also: "Today I Learned"
+{
+    namespace details
+    {
+        // A UTF-16 code unit type, which wchar_t is even where it's 32 bits wide.
+        template<typename T>
+        concept u16_unit = std::is_integral_v<T> && (sizeof(T) == 2 || sizeof(T) == 4);
+
+        // How far a step of the transcoder advanced in the input and the output.
+        // The steps return it, so that the loops can keep their pointers in registers.
+        struct u8u16_advance
+        {
+            uint8_t read;
+            uint8_t written;
+            bool valid;
+        };
+
+        template<u16_unit T>
+        constexpr uint8_t u8u16_put(T* out, char32_t cp) noexcept
+        {
+            if (cp < 0x10000)
+            {
+                out[0] = static_cast<T>(cp);
+                return 1;
+            }
+            cp -= 0x10000;
+            out[0] = static_cast<T>(0xD800 | (cp >> 10));
+            out[1] = static_cast<T>(0xDC00 | (cp & 0x3FF));
+            return 2;
+        }
+
+        // Decodes the character at in, or the maximal subpart of an ill-formed
+        // sequence at in as U+FFFD, and writes it to out.
+        template<u16_unit T>
+        constexpr u8u16_advance u8u16_scalar_char(const uint8_t* in, const uint8_t* end, T* out) noexcept
+        {
+            const auto lead = in[0];
+            if (lead < 0x80)
+            {
+                out[0] = static_cast<T>(lead);
+                return { 1, 1, true };
+            }
+
+            // The valid range of the first continuation byte depends on the
+            // lead byte (table 3-7 of the Unicode standard), the others are 80..BF.
+            uint8_t length;
+            uint8_t lower = 0x80;
+            uint8_t upper = 0xBF;
+            if (lead >= 0xC2 && lead <= 0xDF)
+            {
+                length = 2;
+            }
+            else if (lead >= 0xE0 && lead <= 0xEF)
+            {
+                length = 3;
+                lower = lead == 0xE0 ? 0xA0 : 0x80;
+                upper = lead == 0xED ? 0x9F : 0xBF;
+            }
+            else if (lead >= 0xF0 && lead <= 0xF4)
+            {
+                length = 4;
+                lower = lead == 0xF0 ? 0x90 : 0x80;
+                upper = lead == 0xF4 ? 0x8F : 0xBF;
+            }
+            else
+            {
+                out[0] = static_cast<T>(0xFFFD);
+                return { 1, 1, false };
+            }
+
+            char32_t cp = lead & (0x7F >> length);
+            for (uint8_t i = 1; i < length; ++i)
+            {
+                if (in + i == end || in[i] < lower || in[i] > upper)
+                {
+                    out[0] = static_cast<T>(0xFFFD);
+                    return { i, 1, false };
+                }
+                cp = (cp << 6) | (in[i] & 0x3F);
+                lower = 0x80;
+                upper = 0xBF;
+            }
+            return { length, u8u16_put(out, cp), true };
+        }
+
+        // Transcodes [in, end) and returns the end of the output. valid is set
+        // to false if the input is ill-formed.
+        template<u16_unit T>
+        T* u8u16_scalar(const uint8_t* in, const uint8_t* end, T* out, bool& valid) noexcept
+        {
+            auto ok = true;
+            while (in != end)
+            {
+                // Take 8 bytes at a time while they are ASCII.
+                while (end - in >= 8)
+                {
+                    uint64_t chunk;
+                    memcpy(&chunk, in, sizeof(chunk));
+                    if (chunk & 0x8080808080808080)
+                    {
+                        break;
+                    }
+                    for (size_t i = 0; i < 8; ++i)
+                    {
+                        out[i] = static_cast<T>(in[i]);
+                    }
+                    in += 8;
+                    out += 8;
+                }
+                while (in != end && *in < 0x80)
+                {
+                    *out++ = static_cast<T>(*in++);
+                }
+                if (in != end)
+                {
+                    const auto advance = u8u16_scalar_char(in, end, out);
+                    in += advance.read;
+                    out += advance.written;
+                    ok &= advance.valid;
+                }
+            }
+            valid &= ok;
+            return out;
+        }
+
+#if defined(TIL_SSE_INTRINSICS)
+        // The three kinds of steps of the vector path, by the index of their shuffle.
+        inline constexpr uint8_t u8u16_shuffles_2byte = 0; // 6 characters of 1-2 bytes, 64 shuffles
+        inline constexpr uint8_t u8u16_shuffles_3byte = 64; // 4 characters of 1-3 bytes, 81 shuffles
+        inline constexpr uint8_t u8u16_shuffles_4byte = 145; // 3 characters of 1-4 bytes, 64 shuffles
+        inline constexpr size_t u8u16_shuffles_count = 209;
+
+        struct u8u16_tables
+        {
+            struct step
+            {
+                uint8_t consumed; // 0 if the vector path can't take the characters
+                uint8_t shuffle;
+            };
+
+            // Gather the bytes of a character into a lane, last byte first:
+            // 16-bit lanes for u8u16_shuffles_2byte, 32-bit lanes for the others.
+            alignas(16) uint8_t shuffles[u8u16_shuffles_count][16];
+            // Indexed by the mask of the first 12 bytes which end a character.
+            step steps[4096];
+            // Drop the unused upper halves of the 32-bit lanes of u8u16_shuffles_4byte,
+            // indexed by the mask of the lanes which hold a surrogate pair.
+            alignas(16) uint8_t compactions[8][16];
+
+            u8u16_tables() noexcept
+            {
+                const auto fill = [&](size_t index, const uint8_t* lengths, size_t count, size_t laneSize) {
+                    auto& shuffle = shuffles[index];
+                    std::fill(std::begin(shuffle), std::end(shuffle), uint8_t{ 0x80 });
+                    uint8_t pos = 0;
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        for (uint8_t j = 0; j < lengths[i]; ++j)
+                        {
+                            shuffle[i * laneSize + j] = gsl::narrow_cast<uint8_t>(pos + lengths[i] - 1 - j);
+                        }
+                        pos += lengths[i];
+                    }
+                };
+
+                uint8_t lengths[6];
+                for (size_t i = 0; i < 64; ++i)
+                {
+                    for (size_t k = 0; k < 6; ++k)
+                    {
+                        lengths[k] = gsl::narrow_cast<uint8_t>(1 + ((i >> k) & 1));
+                    }
+                    fill(u8u16_shuffles_2byte + i, &lengths[0], 6, 2);
+                }
+                for (size_t i = 0; i < 81; ++i)
+                {
+                    for (size_t k = 0, digits = i; k < 4; ++k, digits /= 3)
+                    {
+                        lengths[k] = gsl::narrow_cast<uint8_t>(1 + digits % 3);
+                    }
+                    fill(u8u16_shuffles_3byte + i, &lengths[0], 4, 4);
+                }
+                for (size_t i = 0; i < 64; ++i)
+                {
+                    for (size_t k = 0; k < 3; ++k)
+                    {
+                        lengths[k] = gsl::narrow_cast<uint8_t>(1 + ((i >> (2 * k)) & 3));
+                    }
+                    fill(u8u16_shuffles_4byte + i, &lengths[0], 3, 4);
+                }
+
+                for (size_t mask = 0; mask < 8; ++mask)
+                {
+                    auto& compaction = compactions[mask];
+                    std::fill(std::begin(compaction), std::end(compaction), uint8_t{ 0x80 });
+                    uint8_t pos = 0;
+                    for (uint8_t lane = 0; lane < 3; ++lane)
+                    {
+                        const auto bytes = mask & (size_t{ 1 } << lane) ? 4 : 2;
+                        for (uint8_t j = 0; j < bytes; ++j)
+                        {
+                            compaction[pos++] = gsl::narrow_cast<uint8_t>(lane * 4 + j);
+                        }
+                    }
+                }
+
+                for (size_t mask = 0; mask < 4096; ++mask)
+                {
+                    uint8_t count = 0;
+                    uint8_t maxLength[6]{}; // the longest of the first i+1 characters
+                    uint8_t consumed[6]{};
+                    size_t index2 = 0;
+                    size_t index3 = 0;
+                    size_t digit3 = 1;
+                    size_t index4 = 0;
+                    size_t start = 0;
+                    for (size_t i = 0; i < 12 && count < 6; ++i)
+                    {
+                        if (!(mask & (size_t{ 1 } << i)))
+                        {
+                            continue;
+                        }
+                        const auto length = gsl::narrow_cast<uint8_t>(i + 1 - start);
+                        maxLength[count] = std::max(length, count ? maxLength[count - 1] : uint8_t{ 0 });
+                        consumed[count] = gsl::narrow_cast<uint8_t>(i + 1);
+                        if (length <= 2)
+                        {
+                            index2 |= size_t{ length - 1u } << count;
+                        }
+                        if (length <= 3 && count < 4)
+                        {
+                            index3 += (length - 1u) * digit3;
+                            digit3 *= 3;
+                        }
+                        if (length <= 4 && count < 3)
+                        {
+                            index4 |= size_t{ length - 1u } << (2 * count);
+                        }
+                        start = i + 1;
+                        ++count;
+                    }
+
+                    auto& step = steps[mask];
+                    step = {};
+                    if (count >= 6 && maxLength[5] <= 2)
+                    {
+                        step = { consumed[5], gsl::narrow_cast<uint8_t>(u8u16_shuffles_2byte + index2) };
+                    }
+                    else if (count >= 4 && maxLength[3] <= 3)
+                    {
+                        step = { consumed[3], gsl::narrow_cast<uint8_t>(u8u16_shuffles_3byte + index3) };
+                    }
+                    else if (count >= 3 && maxLength[2] <= 4)
+                    {
+                        step = { consumed[2], gsl::narrow_cast<uint8_t>(u8u16_shuffles_4byte + index4) };
+                    }
+                }
+            }
+
+            static const u8u16_tables& get() noexcept
+            {
+                static const u8u16_tables tables;
+                return tables;
+            }
+        };
+
+        // Widens 16 ASCII characters to out.
+        template<u16_unit T>
+        _TIL_TARGET("sse4.1") inline void u8u16_widen_sse41(T* out, const __m128i v) noexcept
+        {
+            if constexpr (sizeof(T) == 2)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_cvtepu8_epi16(v));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_cvtepu8_epi16(_mm_srli_si128(v, 8)));
+            }
+            else
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_cvtepu8_epi32(v));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_cvtepu8_epi32(_mm_srli_si128(v, 4)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_cvtepu8_epi32(_mm_srli_si128(v, 8)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 12), _mm_cvtepu8_epi32(_mm_srli_si128(v, 12)));
+            }
+        }
+
+        // Transcodes the 6, 4 or 3 characters at the start of v, if they are
+        // well-formed. Returns a read of 0 if they aren't, or if they don't fit
+        // in 12 bytes. out needs room for 8 code units, which may all be written.
+        template<u16_unit T>
+        _TIL_TARGET("sse4.1") inline u8u16_advance u8u16_step_sse41(T* out, const __m128i v, const u8u16_tables& tables) noexcept
+        {
+            // Continuation bytes are 80..BF, which are less than -64 as int8_t.
+            const auto continuation = _mm_movemask_epi8(_mm_cmplt_epi8(v, _mm_set1_epi8(-64)));
+            const auto ends = (~continuation >> 1) & 0xFFF;
+            const auto step = til::at(tables.steps, ends);
+            if (!step.consumed)
+            {
+                return {};
+            }
+
+            const auto zero = _mm_setzero_si128();
+            const auto lanes = _mm_shuffle_epi8(v, _mm_load_si128(reinterpret_cast<const __m128i*>(&til::at(tables.shuffles, step.shuffle)[0])));
+
+            if (step.shuffle < u8u16_shuffles_3byte)
+            {
+                // 16-bit lanes of [last byte, lead byte] or [ASCII, 0].
+                const auto cp = _mm_or_si128(_mm_and_si128(lanes, _mm_set1_epi16(0x7F)), _mm_srli_epi16(_mm_and_si128(lanes, _mm_set1_epi16(0x1F00)), 2));
+                const auto ok1 = _mm_cmpeq_epi16(_mm_and_si128(lanes, _mm_set1_epi16(static_cast<short>(0xFF80))), zero);
+                const auto lead2 = _mm_cmpeq_epi16(_mm_and_si128(lanes, _mm_set1_epi16(static_cast<short>(0xE000))), _mm_set1_epi16(static_cast<short>(0xC000)));
+                const auto ok2 = _mm_andnot_si128(_mm_cmpeq_epi16(_mm_and_si128(cp, _mm_set1_epi16(0x780)), zero), lead2);
+                if (_mm_movemask_epi8(_mm_or_si128(ok1, ok2)) != 0xFFFF)
+                {
+                    return {};
+                }
+
+                if constexpr (sizeof(T) == 2)
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), cp);
+                }
+                else
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_cvtepu16_epi32(cp));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_cvtepu16_epi32(_mm_srli_si128(cp, 8)));
+                }
+                return { step.consumed, 6, true };
+            }
+
+            // 32-bit lanes of [last byte, ..., lead byte, 0...].
+            const auto low = _mm_or_si128(_mm_and_si128(lanes, _mm_set1_epi32(0x7F)), _mm_srli_epi32(_mm_and_si128(lanes, _mm_set1_epi32(0x3F00)), 2));
+            const auto cp3 = _mm_or_si128(low, _mm_srli_epi32(_mm_and_si128(lanes, _mm_set1_epi32(0x0F0000)), 4));
+            const auto ok1 = _mm_cmpeq_epi32(_mm_and_si128(lanes, _mm_set1_epi32(static_cast<int>(0xFFFFFF80))), zero);
+            const auto ok2 = _mm_and_si128(_mm_cmpeq_epi32(_mm_and_si128(lanes, _mm_set1_epi32(static_cast<int>(0xFFFFE000))), _mm_set1_epi32(0xC000)), _mm_cmpgt_epi32(cp3, _mm_set1_epi32(0x7F)));
+            // 3 bytes: at least U+0800 and not a surrogate.
+            const auto ok3 = _mm_andnot_si128(
+                _mm_cmpeq_epi32(_mm_and_si128(cp3, _mm_set1_epi32(0xF800)), _mm_set1_epi32(0xD800)),
+                _mm_and_si128(_mm_cmpeq_epi32(_mm_and_si128(lanes, _mm_set1_epi32(static_cast<int>(0xFFF00000))), _mm_set1_epi32(0xE00000)), _mm_cmpgt_epi32(cp3, _mm_set1_epi32(0x7FF))));
+            const auto ok123 = _mm_or_si128(ok1, _mm_or_si128(ok2, ok3));
+
+            if (step.shuffle < u8u16_shuffles_4byte)
+            {
+                if (_mm_movemask_epi8(ok123) != 0xFFFF)
+                {
+                    return {};
+                }
+
+                if constexpr (sizeof(T) == 2)
+                {
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi32(cp3, cp3));
+                }
+                else
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), cp3);
+                }
+                return { step.consumed, 4, true };
+            }
+
+            // The lead byte of a 3 byte character has 4 bits of payload, the one of a 4 byte character 3.
+            const auto cp4 = _mm_or_si128(_mm_or_si128(low, _mm_srli_epi32(_mm_and_si128(lanes, _mm_set1_epi32(0x3F0000)), 4)), _mm_srli_epi32(_mm_and_si128(lanes, _mm_set1_epi32(0x07000000)), 6));
+            const auto shorter = _mm_cmpeq_epi32(_mm_and_si128(lanes, _mm_set1_epi32(static_cast<int>(0xFF000000))), zero);
+            const auto cp = _mm_blendv_epi8(cp4, cp3, shorter);
+            // 4 bytes: U+10000 to U+10FFFF.
+            const auto supplementary = _mm_cmpgt_epi32(cp, _mm_set1_epi32(0xFFFF));
+            const auto ok4 = _mm_and_si128(
+                _mm_cmpeq_epi32(_mm_and_si128(lanes, _mm_set1_epi32(static_cast<int>(0xF8000000))), _mm_set1_epi32(static_cast<int>(0xF0000000))),
+                _mm_and_si128(supplementary, _mm_cmplt_epi32(cp, _mm_set1_epi32(0x110000))));
+            if (_mm_movemask_epi8(_mm_or_si128(ok123, ok4)) != 0xFFFF)
+            {
+                return {};
+            }
+
+            // Split the supplementary characters into surrogate pairs, which fill
+            // their lanes, and drop the upper half of the lanes of the others.
+            const auto offset = _mm_sub_epi32(cp, _mm_set1_epi32(0x10000));
+            const auto high = _mm_or_si128(_mm_srli_epi32(offset, 10), _mm_set1_epi32(0xD800));
+            const auto low10 = _mm_or_si128(_mm_and_si128(offset, _mm_set1_epi32(0x3FF)), _mm_set1_epi32(0xDC00));
+            const auto units = _mm_blendv_epi8(cp, _mm_or_si128(high, _mm_slli_epi32(low10, 16)), supplementary);
+            const auto pairs = _mm_movemask_ps(_mm_castsi128_ps(supplementary));
+            const auto packed = _mm_shuffle_epi8(units, _mm_load_si128(reinterpret_cast<const __m128i*>(&til::at(tables.compactions, pairs)[0])));
+
+            if constexpr (sizeof(T) == 2)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), packed);
+            }
+            else
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_cvtepu16_epi32(packed));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_cvtepu16_epi32(_mm_srli_si128(packed, 8)));
+            }
+            return { step.consumed, gsl::narrow_cast<uint8_t>(3 + (pairs & 1) + ((pairs >> 1) & 1) + (pairs >> 2)), true };
+        }
+
+        // One iteration of the SSE4.1 loop over the 16 bytes at in. The output
+        // needs room for as many code units as there are bytes left in the input.
+        template<u16_unit T>
+        _TIL_TARGET("sse4.1") inline u8u16_advance u8u16_block_sse41(const uint8_t* in, const uint8_t* end, T* out, const u8u16_tables& tables) noexcept
+        {
+            const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+            const auto ascii = static_cast<unsigned long>(_mm_movemask_epi8(v));
+            if (!ascii)
+            {
+                u8u16_widen_sse41(out, v);
+                return { 16, 16, true };
+            }
+
+            // The step takes ASCII as well, but only up to 6 characters.
+            unsigned long prefix;
+            _BitScanForward(&prefix, ascii);
+            if (prefix > 6)
+            {
+                // Widen all 16 bytes, but only keep the ASCII prefix.
+                u8u16_widen_sse41(out, v);
+                return { gsl::narrow_cast<uint8_t>(prefix), gsl::narrow_cast<uint8_t>(prefix), true };
+            }
+
+            if (const auto advance = u8u16_step_sse41(out, v, tables); advance.read)
+            {
+                return advance;
+            }
+            return u8u16_scalar_char(in, end, out);
+        }
+
+        template<u16_unit T>
+        _TIL_TARGET("sse4.1") T* u8u16_sse41(const uint8_t* in, const uint8_t* end, T* out, bool& valid) noexcept
+        {
+            const auto& tables = u8u16_tables::get();
+            auto ok = true;
+            while (end - in >= 16)
+            {
+                const auto advance = u8u16_block_sse41(in, end, out, tables);
+                in += advance.read;
+                out += advance.written;
+                ok &= advance.valid;
+            }
+            valid &= ok;
+            return u8u16_scalar(in, end, out, valid);
+        }
+
+        template<u16_unit T>
+        _TIL_TARGET("avx2") T* u8u16_avx2(const uint8_t* in, const uint8_t* end, T* out, bool& valid) noexcept
+        {
+            const auto& tables = u8u16_tables::get();
+            auto ok = true;
+            while (end - in >= 16)
+            {
+                if (end - in >= 32)
+                {
+                    const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+                    if (!_mm256_movemask_epi8(v))
+                    {
+                        if constexpr (sizeof(T) == 2)
+                        {
+                            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v)));
+                            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1)));
+                        }
+                        else
+                        {
+                            const auto lo = _mm256_castsi256_si128(v);
+                            const auto hi = _mm256_extracti128_si256(v, 1);
+                            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_cvtepu8_epi32(lo));
+                            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 8), _mm256_cvtepu8_epi32(_mm_srli_si128(lo, 8)));
+                            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 16), _mm256_cvtepu8_epi32(hi));
+                            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 24), _mm256_cvtepu8_epi32(_mm_srli_si128(hi, 8)));
+                        }
+                        in += 32;
+                        out += 32;
+                        continue;
+                    }
+                }
+
+                // Text which isn't ASCII rarely turns into ASCII right away,
+                // so don't check the next 32 bytes before 16 have been taken.
+                const auto next = in + 16;
+                do
+                {
+                    const auto advance = u8u16_block_sse41(in, end, out, tables);
+                    in += advance.read;
+                    out += advance.written;
+                    ok &= advance.valid;
+                } while (in < next && end - in >= 16);
+            }
+            valid &= ok;
+            return u8u16_scalar(in, end, out, valid);
+        }
+#endif
+
+        // Transcodes the UTF-8 string [in, in + length) to UTF-16 at out, which
+        // needs room for length code units, and returns the number of code units
+        // written. valid is set to false if the input is ill-formed.
+        template<u16_unit T>
+        size_t u8u16_transcode(const char* in, size_t length, T* out, bool& valid) noexcept
+        {
+            const auto beg = reinterpret_cast<const uint8_t*>(in);
+            const auto end = beg + length;
+#if defined(TIL_SSE_INTRINSICS)
+            if (__isa_available >= __ISA_AVAILABLE_AVX2)
+            {
+                return gsl::narrow_cast<size_t>(u8u16_avx2(beg, end, out, valid) - out);
+            }
+            if (__isa_available >= __ISA_AVAILABLE_SSE42)
+            {
+                return gsl::narrow_cast<size_t>(u8u16_sse41(beg, end, out, valid) - out);
+            }
+#endif
+            return gsl::narrow_cast<size_t>(u8u16_scalar(beg, end, out, valid) - out);
+        }
+
+        template<u16_unit T>
+        size_t u8u16_transcode(const char* in, size_t length, T* out) noexcept
+        {
+            bool valid = true;
+            return u8u16_transcode(in, length, out, valid);
+        }
+    }
+
+    // Returns true if str is well-formed UTF-8.
+    inline bool is_valid_utf8(const std::string_view& str) noexcept
+    {
+        // The validation is a byproduct of transcoding, into a buffer on the stack.
+        char16_t buffer[1024];
+        auto valid = true;
+        for (size_t i = 0; i < str.size() && valid;)
+        {
+            auto length = std::min(std::size(buffer), str.size() - i);
+            // Don't split a character. If there are more than 3 continuation
+            // bytes in a row, the input is ill-formed either way.
+            for (size_t j = 0; j < 3 && i + length < str.size() && (static_cast<uint8_t>(til::at(str, i + length)) & 0xC0) == 0x80; ++j)
+            {
+                --length;
+            }
+            details::u8u16_transcode(str.data() + i, length, &buffer[0], valid);
+            i += length;
+        }
+        return valid;
+    }
+}
+
+#pragma warning(pop)
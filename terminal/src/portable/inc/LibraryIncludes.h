@@ -0,0 +1,89 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+// clang-format off
+
+/*
+Module Name:
+- LibraryIncludes.h
+
+Abstract:
+- Replaces src/inc/LibraryIncludes.h in the portable build, which puts
+  src/portable/inc ahead of src/inc on the include path. It pulls in the
+  same STL headers, the vendored libraries, and the stand-ins in this
+  directory for the Windows SDK, WIL and GSL.
+*/
+
+#pragma once
+
+// The MSVC STL checks its iterators in debug builds only.
+#ifndef _ITERATOR_DEBUG_LEVEL
+#define _ITERATOR_DEBUG_LEVEL 0
+#endif
+
+// C
+#include <climits>
+#include <cstring>
+#include <cwchar>
+#include <cwctype>
+
+// STL
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <iterator>
+#include <map>
+#include <memory_resource>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <numeric>
+#include <optional>
+#include <set>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Windows SDK
+#include <windows.h>
+#include <sal.h>
+#include <intsafe.h>
+
+// WIL
+#include <wil/resource.h>
+#include <wil/result.h>
+
+// GSL
+#include <gsl/gsl>
+#include <gsl/gsl_util>
+#include <gsl/pointers>
+
+// Chromium Numerics (safe math)
+#include <base/numerics/safe_math.h>
+
+// LibPopCnt - Fast C/C++ bit population count library (on bits in an array)
+#include <libpopcnt.h>
+
+// Dynamic Bitset (optional dependency on LibPopCnt for perf at bit counting)
+#include <dynamic_bitset.hpp>
+
+#define USE_INTERVAL_TREE_NAMESPACE
+#include <IntervalTree.h>
+
+// TIL - Terminal Implementation Library
+#ifndef BLOCK_TIL
+#include "til.h"
+#endif
+
+// clang-format on
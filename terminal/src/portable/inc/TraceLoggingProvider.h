@@ -0,0 +1,42 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+/*
+Module Name:
+- TraceLoggingProvider.h
+
+Abstract:
+- Portable stand-in for TraceLoggingProvider.h. There is no ETW outside of
+  Windows, so providers are never enabled and events are discarded without
+  evaluating their arguments.
+*/
+
+#pragma once
+
+struct _tlgProvider_t
+{
+};
+using TraceLoggingHProvider = const _tlgProvider_t*;
+
+#define TRACELOGGING_DECLARE_PROVIDER(handle) extern const TraceLoggingHProvider handle
+#define TRACELOGGING_DEFINE_PROVIDER(handle, name, guid, ...) \
+    static const _tlgProvider_t handle##_storage{};           \
+    const TraceLoggingHProvider handle = &handle##_storage
+
+inline long TraceLoggingRegister(TraceLoggingHProvider) noexcept
+{
+    return 0;
+}
+inline void TraceLoggingUnregister(TraceLoggingHProvider) noexcept
+{
+}
+inline bool TraceLoggingProviderEnabled(TraceLoggingHProvider, unsigned char, unsigned long long) noexcept
+{
+    return false;
+}
+
+#define TraceLoggingWrite(provider, name, ...) \
+    do                                         \
+    {                                          \
+        (void)(provider);                      \
+    } while (0)
@@ -0,0 +1,17 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+/*
+Module Name:
+- icu.h
+
+Abstract:
+- Portable stand-in for the ICU header of the Windows SDK, on top of the
+  headers of the ICU installed on the system.
+*/
+
+#pragma once
+
+#include <unicode/uregex.h>
+#include <unicode/ustring.h>
+#include <unicode/utext.h>
@@ -0,0 +1,76 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+/*
+Module Name:
+- intrin.h
+
+Abstract:
+- Portable stand-in for the MSVC intrinsics header: the vector intrinsics
+  of the target, and the bit scan and 128-bit multiplication intrinsics on
+  top of the GCC builtins.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(__arm__)
+#include <arm_neon.h>
+#endif
+
+inline unsigned char _BitScanForward(unsigned long* index, unsigned long mask) noexcept
+{
+    if (!mask)
+    {
+        return 0;
+    }
+    *index = static_cast<unsigned long>(__builtin_ctzl(mask));
+    return 1;
+}
+
+inline unsigned char _BitScanReverse(unsigned long* index, unsigned long mask) noexcept
+{
+    if (!mask)
+    {
+        return 0;
+    }
+    *index = static_cast<unsigned long>(sizeof(unsigned long) * 8 - 1 - __builtin_clzl(mask));
+    return 1;
+}
+
+inline unsigned char _BitScanForward64(unsigned long* index, uint64_t mask) noexcept
+{
+    if (!mask)
+    {
+        return 0;
+    }
+    *index = static_cast<unsigned long>(__builtin_ctzll(mask));
+    return 1;
+}
+
+inline unsigned char _BitScanReverse64(unsigned long* index, uint64_t mask) noexcept
+{
+    if (!mask)
+    {
+        return 0;
+    }
+    *index = static_cast<unsigned long>(63 - __builtin_clzll(mask));
+    return 1;
+}
+
+#if defined(__SIZEOF_INT128__)
+inline uint64_t _umul128(uint64_t multiplier, uint64_t multiplicand, uint64_t* highProduct) noexcept
+{
+    const auto product = static_cast<unsigned __int128>(multiplier) * multiplicand;
+    *highProduct = static_cast<uint64_t>(product >> 64);
+    return static_cast<uint64_t>(product);
+}
+
+inline uint64_t __umulh(uint64_t a, uint64_t b) noexcept
+{
+    return static_cast<uint64_t>((static_cast<unsigned __int128>(a) * b) >> 64);
+}
+#endif
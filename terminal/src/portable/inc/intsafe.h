@@ -0,0 +1,41 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+/*
+Module Name:
+- intsafe.h
+
+Abstract:
+- Portable stand-in for intsafe.h: the types, and the few conversions the
+  code built on non-Windows platforms calls.
+*/
+
+#pragma once
+
+#include "windows.h"
+
+#include <climits>
+
+#define INTSAFE_E_ARITHMETIC_OVERFLOW ((HRESULT)0x80070216L)
+
+inline HRESULT SizeTToInt(size_t operand, int* result) noexcept
+{
+    if (operand > static_cast<size_t>(INT_MAX))
+    {
+        *result = -1;
+        return INTSAFE_E_ARITHMETIC_OVERFLOW;
+    }
+    *result = static_cast<int>(operand);
+    return S_OK;
+}
+
+inline HRESULT IntToSizeT(int operand, size_t* result) noexcept
+{
+    if (operand < 0)
+    {
+        *result = SIZE_MAX;
+        return INTSAFE_E_ARITHMETIC_OVERFLOW;
+    }
+    *result = static_cast<size_t>(operand);
+    return S_OK;
+}
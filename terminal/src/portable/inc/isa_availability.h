@@ -0,0 +1,23 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+/*
+Module Name:
+- isa_availability.h
+
+Abstract:
+- Portable stand-in for the header of the MSVC runtime which names the
+  levels of __isa_available. The variable is set in win32.cpp from what
+  the CPU supports.
+*/
+
+#pragma once
+
+#define __ISA_AVAILABLE_X86 0
+#define __ISA_AVAILABLE_SSE2 1
+#define __ISA_AVAILABLE_SSE42 2
+#define __ISA_AVAILABLE_AVX 3
+#define __ISA_AVAILABLE_ENFSTRG 4
+#define __ISA_AVAILABLE_AVX2 5
+
+extern "C" int __isa_available;
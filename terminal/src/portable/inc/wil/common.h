@@ -0,0 +1,41 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+/*
+Module Name:
+- common.h
+
+Abstract:
+- Portable stand-in for the flag helpers of WIL.
+*/
+
+#pragma once
+
+#define WI_IsFlagSet(val, flag) ((((val) & (flag)) == (flag)))
+#define WI_IsFlagClear(val, flag) ((((val) & (flag)) == static_cast<decltype((val) & (flag))>(0)))
+#define WI_IsAnyFlagSet(val, flags) ((((val) & (flags)) != static_cast<decltype((val) & (flags))>(0)))
+#define WI_AreAllFlagsSet(val, flags) ((((val) & (flags)) == (flags)))
+#define WI_AreAllFlagsClear(val, flags) ((((val) & (flags)) == static_cast<decltype((val) & (flags))>(0)))
+#define WI_SetFlag(var, flag) ((var) |= (flag))
+#define WI_SetAllFlags(var, flags) ((var) |= (flags))
+#define WI_ClearFlag(var, flag) ((var) &= ~(flag))
+#define WI_ClearAllFlags(var, flags) ((var) &= ~(flags))
+#define WI_SetFlagIf(var, flag, condition) \
+    do                                     \
+    {                                      \
+        if (condition)                     \
+        {                                  \
+            WI_SetFlag(var, flag);         \
+        }                                  \
+    } while (0)
+#define WI_ClearFlagIf(var, flag, condition) \
+    do                                       \
+    {                                        \
+        if (condition)                       \
+        {                                    \
+            WI_ClearFlag(var, flag);         \
+        }                                    \
+    } while (0)
+#define WI_ToggleFlag(var, flag) ((var) ^= (flag))
+#define WI_UpdateFlag(var, flag, isFlagSet) ((isFlagSet) ? WI_SetFlag(var, flag) : WI_ClearFlag(var, flag))
+#define WI_EnumValue(val) static_cast<std::underlying_type_t<decltype(val)>>(val)
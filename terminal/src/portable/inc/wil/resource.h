@@ -0,0 +1,97 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+/*
+Module Name:
+- resource.h
+
+Abstract:
+- Portable stand-in for wil::scope_exit, wil::function_deleter and
+  wil::unique_virtualalloc_ptr, the only parts of the WIL resource helpers
+  used by the code in the portable build. wistd::unique_ptr is
+  std::unique_ptr.
+*/
+
+#pragma once
+
+#include <memory>
+#include <utility>
+
+#include <windows.h>
+
+namespace wistd
+{
+    using std::unique_ptr;
+}
+
+namespace wil
+{
+    template<typename TLambda>
+    class scope_exit_t
+    {
+    public:
+        explicit scope_exit_t(TLambda&& lambda) noexcept :
+            _lambda{ std::move(lambda) }
+        {
+        }
+
+        scope_exit_t(scope_exit_t&& other) noexcept :
+            _lambda{ std::move(other._lambda) },
+            _call{ std::exchange(other._call, false) }
+        {
+        }
+
+        scope_exit_t(const scope_exit_t&) = delete;
+        scope_exit_t& operator=(const scope_exit_t&) = delete;
+        scope_exit_t& operator=(scope_exit_t&&) = delete;
+
+        ~scope_exit_t()
+        {
+            reset();
+        }
+
+        void reset()
+        {
+            if (std::exchange(_call, false))
+            {
+                _lambda();
+            }
+        }
+
+        void release() noexcept
+        {
+            _call = false;
+        }
+
+    private:
+        TLambda _lambda;
+        bool _call = true;
+    };
+
+    template<typename TLambda>
+    [[nodiscard]] scope_exit_t<TLambda> scope_exit(TLambda&& lambda) noexcept
+    {
+        return scope_exit_t<TLambda>{ std::forward<TLambda>(lambda) };
+    }
+
+    template<typename TDeleter, TDeleter Deleter>
+    struct function_deleter
+    {
+        template<typename T>
+        void operator()(T* p) const noexcept
+        {
+            Deleter(p);
+        }
+    };
+
+    struct virtualalloc_deleter
+    {
+        void operator()(void* p) const noexcept
+        {
+            VirtualFree(p, 0, MEM_RELEASE);
+        }
+    };
+
+    template<typename T = void>
+    using unique_virtualalloc_ptr = std::unique_ptr<T, virtualalloc_deleter>;
+}
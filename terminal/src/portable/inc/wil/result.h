@@ -0,0 +1,192 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+/*
+Module Name:
+- result.h
+
+Abstract:
+- Portable stand-in for the error handling macros of WIL used by the code in
+  the portable build. Failures are thrown as wil::ResultException and the
+  logging macros drop their message, as there is no telemetry to send it to.
+*/
+
+#pragma once
+
+#include <cstdarg>
+#include <cstdio>
+#include <exception>
+#include <new>
+#include <string>
+
+#include "../windows.h"
+#include "common.h"
+
+namespace wil
+{
+    class ResultException : public std::exception
+    {
+    public:
+        explicit ResultException(HRESULT hr) noexcept :
+            _hr{ hr }
+        {
+        }
+
+        HRESULT GetErrorCode() const noexcept
+        {
+            return _hr;
+        }
+
+        const char* what() const noexcept override
+        {
+            return "wil::ResultException";
+        }
+
+    private:
+        HRESULT _hr;
+    };
+
+    [[noreturn]] inline void ThrowResult(HRESULT hr)
+    {
+        throw ResultException{ hr };
+    }
+
+    inline HRESULT ResultFromCaughtException() noexcept
+    {
+        try
+        {
+            throw;
+        }
+        catch (const ResultException& e)
+        {
+            return e.GetErrorCode();
+        }
+        catch (const std::bad_alloc&)
+        {
+            return E_OUTOFMEMORY;
+        }
+        catch (...)
+        {
+            return E_FAIL;
+        }
+    }
+
+    template<typename T>
+    T* ThrowLastErrorIfNull(T* ptr)
+    {
+        if (!ptr)
+        {
+            ThrowResult(HRESULT_FROM_WIN32(GetLastError()));
+        }
+        return ptr;
+    }
+
+    template<typename T>
+    constexpr bool verify_bool(T value) noexcept
+    {
+        return static_cast<bool>(value);
+    }
+
+    template<typename T>
+    T str_printf(const wchar_t* format, ...)
+    {
+        wchar_t buffer[256];
+        va_list args;
+        va_start(args, format);
+        const auto length = std::vswprintf(&buffer[0], std::size(buffer), format, args);
+        va_end(args);
+        return T{ &buffer[0], length < 0 ? 0 : static_cast<size_t>(length) };
+    }
+}
+
+#define LOG_HR(hr) ((void)(hr))
+#define SUCCEEDED_LOG(hr) SUCCEEDED(hr)
+#define FAILED_LOG(hr) FAILED(hr)
+#define LOG_HR_MSG(hr, ...) ((void)(hr))
+#define LOG_IF_FAILED(hr) ((void)(hr))
+#define LOG_IF_FAILED_MSG(hr, ...) ((void)(hr))
+#define LOG_HR_IF(hr, condition) ((void)(hr), (void)(condition))
+#define LOG_CAUGHT_EXCEPTION() ((void)0)
+#define LOG_LAST_ERROR() ((void)0)
+#define LOG_LAST_ERROR_IF(condition) ((void)(condition))
+
+#define THROW_HR(hr) ::wil::ThrowResult(hr)
+#define THROW_HR_MSG(hr, ...) ::wil::ThrowResult(hr)
+#define THROW_WIN32(err) ::wil::ThrowResult(HRESULT_FROM_WIN32(err))
+#define THROW_LAST_ERROR() ::wil::ThrowResult(E_FAIL)
+#define THROW_HR_IF(hr, condition) \
+    do                             \
+    {                              \
+        if (condition)             \
+        {                          \
+            THROW_HR(hr);          \
+        }                          \
+    } while (0)
+#define THROW_HR_IF_NULL(hr, ptr) THROW_HR_IF(hr, (ptr) == nullptr)
+#define THROW_IF_NULL_ALLOC(ptr) THROW_HR_IF(E_OUTOFMEMORY, (ptr) == nullptr)
+#define THROW_LAST_ERROR_IF(condition) THROW_HR_IF(E_FAIL, condition)
+#define THROW_LAST_ERROR_IF_NULL(ptr) ::wil::ThrowLastErrorIfNull(ptr)
+#define THROW_IF_FAILED(hr)                     \
+    do                                          \
+    {                                           \
+        const HRESULT __hrThrow = (hr);         \
+        if (FAILED(__hrThrow))                  \
+        {                                       \
+            THROW_HR(__hrThrow);                \
+        }                                       \
+    } while (0)
+
+#define RETURN_HR(hr) return (hr)
+#define RETURN_WIN32(err) return HRESULT_FROM_WIN32(err)
+#define RETURN_HR_IF(hr, condition) \
+    do                              \
+    {                               \
+        if (condition)              \
+        {                           \
+            return (hr);            \
+        }                           \
+    } while (0)
+#define RETURN_HR_IF_NULL(hr, ptr) RETURN_HR_IF(hr, (ptr) == nullptr)
+#define RETURN_IF_FAILED(hr)                    \
+    do                                          \
+    {                                           \
+        const HRESULT __hrRet = (hr);           \
+        if (FAILED(__hrRet))                    \
+        {                                       \
+            return __hrRet;                     \
+        }                                       \
+    } while (0)
+#define RETURN_CAUGHT_EXCEPTION() return ::wil::ResultFromCaughtException()
+
+#define FAIL_FAST() std::terminate()
+#define FAIL_FAST_IF(condition) \
+    do                          \
+    {                           \
+        if (condition)          \
+        {                       \
+            std::terminate();   \
+        }                       \
+    } while (0)
+#define FAIL_FAST_HR(hr) std::terminate()
+#define FAIL_FAST_IF_FAILED(hr) FAIL_FAST_IF(FAILED(hr))
+#define FAIL_FAST_LAST_ERROR_IF(condition) FAIL_FAST_IF(condition)
+
+#define CATCH_FAIL_FAST() \
+    catch (...)           \
+    {                     \
+        std::terminate(); \
+    }
+#define CATCH_LOG() \
+    catch (...)     \
+    {               \
+    }
+#define CATCH_RETURN()                               \
+    catch (...)                                      \
+    {                                                \
+        return ::wil::ResultFromCaughtException();   \
+    }
+#define CATCH_LOG_RETURN_HR(hr) \
+    catch (...)                 \
+    {                           \
+        return (hr);            \
+    }
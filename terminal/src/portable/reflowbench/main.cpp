@@ -0,0 +1,368 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+/*
+Module Name:
+- main.cpp
+
+Abstract:
+- reflowbench measures how long it takes to resize a TextBuffer with a full
+  scrollback, the way Terminal::UserResize() does it on every resize event
+  while the window edge is dragged: it reflows the buffer into a new one and
+  then draws the viewport. It does so with TextBuffer::Reflow(), which rewraps
+  every row right away, and with TextBuffer::ReflowLazily(), which leaves the
+  scrollback above the viewport for later, and prints the latency per resize.
+- After the last resize, it rewraps the remaining rows of the lazily reflowed
+  buffer with FinishReflow(), and fails if it's different from the other one.
+  It then resizes both buffers a few more times to random sizes, accesses
+  random rows of the lazily reflowed one and writes more output in between,
+  and fails if the viewport positions, the cursor, the rows, their attributes
+  or the marks of both buffers ever differ.
+*/
+
+#include "LibraryIncludes.h"
+
+#include "../buffer/out/textBuffer.hpp"
+#include "../renderer/base/renderer.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+    constexpr til::CoordType viewportHeight = 30;
+
+    const TextAttribute plain{};
+    const TextAttribute colored{ 0x1e };
+
+    struct Line
+    {
+        std::wstring text;
+        // The number of characters at the end of the text that are colored.
+        size_t colored = 0;
+    };
+
+    Line makeLine(std::mt19937& rng, size_t i, til::CoordType width)
+    {
+        static constexpr std::wstring_view words[]{ L"request", L"completed", L"in", L"42ms", L"GET", L"/api/v1/items", L"status=200", L"bytes=1834", L"user=alice", L"cache=miss" };
+        static constexpr std::wstring_view wideWords[]{ L"\x8BF7\x6C42", L"\x5B8C\x6210", L"\x7528\x6237", L"\x7F13\x5B58\x672A\x547D\x4E2D" };
+
+        wchar_t prefix[64];
+        swprintf(prefix, 64, L"2024-05-01 12:%02zu:%02zu.%03zu INFO [worker-%zu] ", i / 60 % 60, i % 60, i % 1000, i % 8);
+        std::wstring line{ prefix };
+        // Most lines fit into the buffer, some wrap across several rows, and every 16th one is CJK text.
+        const auto wide = i % 16 == 0;
+        const auto columns = static_cast<size_t>(width) * (rng() % 8 == 0 ? 2 + rng() % 2 : 1) * (rng() % 4 + 4) / 8;
+        while (line.size() * (wide ? 2 : 1) < columns)
+        {
+            line.append(wide ? wideWords[rng() % std::size(wideWords)] : words[rng() % std::size(words)]);
+            line.push_back(L' ');
+        }
+        // Like most output, the lines don't end in whitespace. ReflowLazily() copies such lines instead.
+        line.pop_back();
+        // Every 4th line ends in a colored status, which makes the attributes past its end differ from those of its text.
+        size_t coloredLength = 0;
+        if (i % 4 == 0)
+        {
+            line.append(L" [ OK ]");
+            coloredLength = 6;
+        }
+        return { std::move(line), coloredLength };
+    }
+
+    // Moves the cursor to the start of the next row. Once the buffer is full, it scrolls,
+    // and just like Terminal does it, we move the marks up along with the text.
+    void newline(TextBuffer& buffer)
+    {
+        const auto scrolls = buffer.GetCursor().GetPosition().y == buffer.GetSize().BottomInclusive();
+        buffer.NewlineCursor();
+        if (scrolls)
+        {
+            buffer.ScrollMarks(-1);
+        }
+    }
+
+    // Writes the text at the cursor with the given attributes and wraps it across as many rows as it needs.
+    void write(TextBuffer& buffer, std::wstring_view text, const TextAttribute& attributes)
+    {
+        auto& cursor = buffer.GetCursor();
+        RowWriteState state{ .text = text, .columnBegin = cursor.GetPosition().x };
+        for (;;)
+        {
+            const auto y = cursor.GetPosition().y;
+            buffer.Write(y, attributes, state);
+            cursor.SetXPosition(state.columnEnd);
+            if (state.text.empty())
+            {
+                break;
+            }
+            buffer.SetWrapForced(y, true);
+            newline(buffer);
+            state.columnBegin = 0;
+        }
+    }
+
+    // Writes the line at the cursor and ends it with a newline. Every 20th line gets a prompt mark.
+    void writeLine(TextBuffer& buffer, size_t i, const Line& line)
+    {
+        if (i % 20 == 0)
+        {
+            const auto y = buffer.GetCursor().GetPosition().y;
+            buffer.StartPromptMark(ScrollMark{ .start = { 0, y }, .end = { 10, y } });
+        }
+        const std::wstring_view text{ line.text };
+        write(buffer, text.substr(0, text.size() - line.colored), plain);
+        write(buffer, text.substr(text.size() - line.colored), colored);
+        newline(buffer);
+    }
+
+    std::unique_ptr<TextBuffer> makeBuffer(Microsoft::Console::Render::Renderer& renderer, til::size size, size_t lines)
+    {
+        auto buffer = std::make_unique<TextBuffer>(size, TextAttribute{}, 0, false, renderer);
+        std::mt19937 rng{ 42 };
+        for (size_t i = 0; i < lines; ++i)
+        {
+            writeLine(*buffer, i, makeLine(rng, i, size.width));
+        }
+        return buffer;
+    }
+
+    TextBuffer::PositionInformation viewportPosition(const TextBuffer& buffer)
+    {
+        const auto viewportTop = std::max(0, buffer.GetCursor().GetPosition().y - viewportHeight + 1);
+        return {
+            .mutableViewportTop = viewportTop,
+            .visibleViewportTop = viewportTop,
+        };
+    }
+
+    // Reflows the buffer into a new one of the given size and returns where the viewport ended up.
+    TextBuffer::PositionInformation resize(std::unique_ptr<TextBuffer>& buffer, til::size size, TextBuffer::PositionInformation positionInfo, bool lazy)
+    {
+        auto newBuffer = std::make_unique<TextBuffer>(size, TextAttribute{}, 0, false, buffer->GetRenderer());
+        if (lazy)
+        {
+            TextBuffer::ReflowLazily(*buffer, *newBuffer, nullptr, &positionInfo);
+        }
+        else
+        {
+            TextBuffer::Reflow(*buffer, *newBuffer, nullptr, &positionInfo);
+        }
+        buffer = std::move(newBuffer);
+        return positionInfo;
+    }
+
+    double elapsed(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    struct Result
+    {
+        double first = 0;
+        double average = 0;
+        double max = 0;
+        double finish = 0;
+        size_t pending = 0;
+        std::vector<TextBuffer::PositionInformation> positions;
+    };
+
+    // Resizes the buffer to each of the widths and draws the viewport at the bottom after each resize.
+    Result drag(std::unique_ptr<TextBuffer>& buffer, const std::vector<til::CoordType>& widths, bool lazy)
+    {
+        Result result;
+        for (size_t i = 0; i < widths.size(); ++i)
+        {
+            const auto start = std::chrono::steady_clock::now();
+
+            const auto positionInfo = resize(buffer, { widths[i], buffer->TotalRowCount() }, viewportPosition(*buffer), lazy);
+            result.positions.emplace_back(positionInfo);
+
+            for (auto y = positionInfo.mutableViewportTop; y < positionInfo.mutableViewportTop + viewportHeight && y < buffer->TotalRowCount(); ++y)
+            {
+                buffer->GetRowByOffset(y);
+            }
+
+            const auto duration = elapsed(start);
+            if (i == 0)
+            {
+                result.first = duration;
+            }
+            else
+            {
+                result.average += duration / static_cast<double>(widths.size() - 1);
+            }
+            result.max = std::max(result.max, duration);
+        }
+
+        result.pending = buffer->GetPendingReflowRowCount();
+        const auto start = std::chrono::steady_clock::now();
+        buffer->FinishReflow();
+        result.finish = elapsed(start);
+        return result;
+    }
+
+    bool equal(const TextBuffer::PositionInformation& expected, const TextBuffer::PositionInformation& actual)
+    {
+        return expected.mutableViewportTop == actual.mutableViewportTop && expected.visibleViewportTop == actual.visibleViewportTop;
+    }
+
+    bool equal(const TextBuffer& expected, const TextBuffer& actual)
+    {
+        if (expected.GetSize().Dimensions() != actual.GetSize().Dimensions() || expected.GetCursor().GetPosition() != actual.GetCursor().GetPosition())
+        {
+            return false;
+        }
+        for (til::CoordType y = 0; y < expected.TotalRowCount(); ++y)
+        {
+            const auto& expectedRow = expected.GetRowByOffset(y);
+            const auto& actualRow = actual.GetRowByOffset(y);
+            if (expectedRow.GetText() != actualRow.GetText() ||
+                expectedRow.WasWrapForced() != actualRow.WasWrapForced() ||
+                expectedRow.WasDoubleBytePadded() != actualRow.WasDoubleBytePadded() ||
+                expectedRow.GetLineRendition() != actualRow.GetLineRendition() ||
+                expectedRow.Attributes() != actualRow.Attributes())
+            {
+                return false;
+            }
+        }
+        const auto& expectedMarks = expected.GetMarks();
+        const auto& actualMarks = actual.GetMarks();
+        return std::equal(expectedMarks.begin(), expectedMarks.end(), actualMarks.begin(), actualMarks.end(), [](const ScrollMark& a, const ScrollMark& b) {
+            return a.start == b.start && a.end == b.end && a.commandEnd == b.commandEnd && a.outputEnd == b.outputEnd;
+        });
+    }
+
+    // Resizes both buffers to random sizes, with the viewport at random positions. In between it accesses random rows
+    // of the lazily reflowed buffer, which rewraps their lines, and writes more output into both buffers.
+    // Returns false if the buffers or the viewport positions differ.
+    bool verify(std::unique_ptr<TextBuffer>& eager, std::unique_ptr<TextBuffer>& lazy, til::CoordType width, size_t cycles)
+    {
+        std::mt19937 rng{ 1234 };
+        auto line = static_cast<size_t>(eager->TotalRowCount());
+        for (size_t i = 0; i < cycles; ++i)
+        {
+            const auto newWidth = width / 2 + static_cast<til::CoordType>(rng() % static_cast<unsigned>(width));
+            const auto newHeight = eager->TotalRowCount() + static_cast<til::CoordType>(rng() % 512) - 256;
+            const til::size size{ std::max<til::CoordType>(10, newWidth), std::clamp<til::CoordType>(newHeight, viewportHeight, 32767) };
+            const auto cursorY = eager->GetCursor().GetPosition().y;
+            const TextBuffer::PositionInformation positionInfo{
+                .mutableViewportTop = std::max(0, cursorY - viewportHeight + 1),
+                .visibleViewportTop = static_cast<til::CoordType>(rng() % static_cast<unsigned>(cursorY + 1)),
+            };
+            const auto eagerPosition = resize(eager, size, positionInfo, false);
+            const auto lazyPosition = resize(lazy, size, positionInfo, true);
+            if (!equal(eagerPosition, lazyPosition) || eager->GetCursor().GetPosition() != lazy->GetCursor().GetPosition())
+            {
+                fprintf(stderr, "reflowbench: the viewport or the cursor differ after resizing to %dx%d\n", size.width, size.height);
+                return false;
+            }
+
+            for (auto n = rng() % 64; n; --n)
+            {
+                lazy->GetRowByOffset(static_cast<til::CoordType>(rng() % static_cast<unsigned>(lazy->TotalRowCount())));
+            }
+            for (auto n = rng() % 256; n; --n, ++line)
+            {
+                const auto l = makeLine(rng, line, size.width);
+                writeLine(*eager, line, l);
+                writeLine(*lazy, line, l);
+            }
+        }
+
+        lazy->FinishReflow();
+        if (!equal(*eager, *lazy))
+        {
+            fputs("reflowbench: the buffers differ after resizing them to random sizes\n", stderr);
+            return false;
+        }
+        return true;
+    }
+
+    void usage()
+    {
+        fputs("usage: reflowbench [-w columns] [-r rows] [-n resizes]\n"
+              "Prints the latency of resizing a full TextBuffer in ms, while shrinking it\n"
+              "by 4 columns per resize and growing it back, with TextBuffer::Reflow() and\n"
+              "with TextBuffer::ReflowLazily(). Then checks that both give the same\n"
+              "result over several resizes to random sizes.\n",
+              stderr);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    til::CoordType width = 120;
+    til::CoordType rows = 50000;
+    size_t resizes = 20;
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        const std::string_view arg{ argv[i] };
+        if ((arg == "-w" || arg == "-r" || arg == "-n") && i + 1 < argc)
+        {
+            const auto value = std::strtod(argv[++i], nullptr);
+            if (value < 1 || value > 32767 || (arg == "-r" && value < viewportHeight))
+            {
+                usage();
+                return 1;
+            }
+            if (arg == "-w")
+            {
+                width = static_cast<til::CoordType>(value);
+            }
+            else if (arg == "-r")
+            {
+                rows = static_cast<til::CoordType>(value);
+            }
+            else
+            {
+                resizes = static_cast<size_t>(value);
+            }
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    // Shrink the buffer column by column, the way dragging the window edge does, and then grow it back.
+    std::vector<til::CoordType> widths;
+    for (size_t i = 1; i <= resizes; ++i)
+    {
+        const auto step = static_cast<til::CoordType>(std::min(i, resizes - i + (resizes % 2)));
+        widths.emplace_back(std::max(1, width - 4 * step));
+    }
+
+    Microsoft::Console::Render::Renderer renderer;
+    // Write more lines than the buffer holds, so that its rows are in circulation.
+    const auto lines = static_cast<size_t>(rows) * 5 / 4;
+    auto eager = makeBuffer(renderer, { width, rows }, lines);
+    auto lazy = makeBuffer(renderer, { width, rows }, lines);
+
+    const auto eagerResult = drag(eager, widths, false);
+    const auto lazyResult = drag(lazy, widths, true);
+
+    printf("%d rows, %zu lines, %zu resizes from %d columns down to %d and back\n\n", rows, lines, widths.size(), width, *std::min_element(widths.begin(), widths.end()));
+    printf("%-14s %10s %10s %10s %12s %10s\n", "", "first ms", "avg ms", "max ms", "pending", "finish ms");
+    printf("%-14s %10.2f %10.2f %10.2f %12s %10s\n", "Reflow", eagerResult.first, eagerResult.average, eagerResult.max, "-", "-");
+    printf("%-14s %10.2f %10.2f %10.2f %12zu %10.2f\n", "ReflowLazily", lazyResult.first, lazyResult.average, lazyResult.max, lazyResult.pending, lazyResult.finish);
+
+    if (!std::equal(eagerResult.positions.begin(), eagerResult.positions.end(), lazyResult.positions.begin(), lazyResult.positions.end(), [](const auto& a, const auto& b) { return equal(a, b); }))
+    {
+        fputs("reflowbench: the viewport positions differ\n", stderr);
+        return 1;
+    }
+    if (!equal(*eager, *lazy))
+    {
+        fputs("reflowbench: the buffers differ\n", stderr);
+        return 1;
+    }
+    if (!verify(eager, lazy, width, 12))
+    {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,37 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+/*
+Module Name:
+- renderer.hpp
+
+Abstract:
+- Portable stand-in for src/renderer/base/renderer.hpp. TextBuffer only
+  notifies the renderer of the regions it changed, and the portable build
+  has nothing to draw, so the notifications do nothing. The include path
+  puts src/portable/inc first, so "../renderer/base/renderer.hpp" resolves
+  to this file.
+*/
+
+#pragma once
+
+namespace Microsoft::Console::Types
+{
+    class Viewport;
+}
+
+namespace Microsoft::Console::Render
+{
+    class Renderer
+    {
+    public:
+        void TriggerRedraw(const Microsoft::Console::Types::Viewport&) noexcept {}
+        void TriggerRedraw(const til::point* const) noexcept {}
+        void TriggerRedrawCursor(const til::point* const) noexcept {}
+        void TriggerRedrawAll(const bool = false, const bool = false) noexcept {}
+        void TriggerScroll() noexcept {}
+        void TriggerScroll(const til::point* const) noexcept {}
+        void TriggerFlush(const bool) noexcept {}
+        void TriggerNewTextNotification(const std::wstring_view) noexcept {}
+    };
+}
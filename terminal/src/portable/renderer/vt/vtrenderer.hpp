@@ -0,0 +1,29 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+/*
+Module Name:
+- vtrenderer.hpp
+
+Abstract:
+- Portable stand-in for src/renderer/vt/vtrenderer.hpp. The output engine
+  includes the VT renderer only to pass unrecognized sequences through to
+  the terminal connection, which the portable build does not have. The
+  include path puts src/portable/inc first, so "../renderer/vt/vtrenderer.hpp"
+  resolves to this file.
+*/
+
+#pragma once
+
+#include "conattrs.hpp"
+
+namespace Microsoft::Console::Render
+{
+    class VtEngine
+    {
+    public:
+        virtual ~VtEngine() = default;
+
+        [[nodiscard]] virtual HRESULT WriteTerminalW(const std::wstring_view str) noexcept = 0;
+    };
+}
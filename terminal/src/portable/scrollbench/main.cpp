@@ -0,0 +1,330 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+/*
+Module Name:
+- main.cpp
+
+Abstract:
+- scrollbench measures the compressed scrollback of TextBuffer (see
+  buffer/out/ColdRowStore.hpp): the resident memory a TextBuffer needs per
+  100k lines of output with and without it, and how long it takes to encode
+  ("freeze") and decode ("thaw") a row, per corpus.
+- The buffer is limited to 65535 rows, so the memory is measured for a full
+  buffer and scaled to 100k lines.
+- Before printing anything, it checks that both buffers hold the same rows.
+*/
+
+#include "LibraryIncludes.h"
+
+#include "../buffer/out/textBuffer.hpp"
+#include "../renderer/base/renderer.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#include <unistd.h>
+
+namespace
+{
+    struct Segment
+    {
+        TextAttribute attr;
+        std::wstring text;
+    };
+
+    using Line = std::vector<Segment>;
+
+    struct Corpus
+    {
+        std::string name;
+        std::vector<Line> lines;
+    };
+
+    // The corpora repeat after this many lines, which is plenty to defeat any caching.
+    constexpr size_t distinctLines = 4096;
+
+    std::wstring pick(std::mt19937& rng, std::initializer_list<std::wstring_view> words, size_t columns)
+    {
+        std::wstring out;
+        while (out.size() < columns)
+        {
+            out.append(words.begin()[rng() % words.size()]);
+            out.push_back(L' ');
+        }
+        return out;
+    }
+
+    std::vector<Corpus> makeCorpora(const uint16_t hyperlinkId)
+    {
+        std::mt19937 rng{ 42 };
+        std::vector<Corpus> corpora;
+
+        corpora.push_back({ "blank", std::vector<Line>(distinctLines) });
+
+        auto& ascii = corpora.emplace_back(Corpus{ "ascii log", {} }).lines;
+        for (size_t i = 0; i < distinctLines; ++i)
+        {
+            wchar_t prefix[64];
+            swprintf(prefix, 64, L"2024-05-01 12:%02zu:%02zu.%03zu INFO [worker-%zu] ", i / 60 % 60, i % 60, i % 1000, i % 8);
+            ascii.push_back({ { {}, prefix + pick(rng, { L"request", L"completed", L"in", L"42ms", L"GET", L"/api/v1/items", L"status=200", L"bytes=1834" }, 10 + rng() % 50) } });
+        }
+
+        auto& sgr = corpora.emplace_back(Corpus{ "sgr colors", {} }).lines;
+        for (size_t i = 0; i < distinctLines; ++i)
+        {
+            Line line;
+            for (auto n = 2 + rng() % 8; n; --n)
+            {
+                TextAttribute attr;
+                if (rng() % 4)
+                {
+                    attr.SetIndexedForeground(static_cast<BYTE>(rng() % 16));
+                }
+                else
+                {
+                    attr.SetForeground(RGB(rng() % 256, rng() % 256, rng() % 256));
+                }
+                attr.SetIntense(rng() % 3 == 0);
+                line.push_back({ attr, pick(rng, { L"src", L"main.cpp", L"README.md", L"+    return 0;", L"-    throw;", L"@@ -12,7 +12,8 @@" }, 4 + rng() % 10) });
+            }
+            sgr.push_back(std::move(line));
+        }
+
+        auto& cjk = corpora.emplace_back(Corpus{ "cjk", {} }).lines;
+        for (size_t i = 0; i < distinctLines; ++i)
+        {
+            cjk.push_back({ { {}, pick(rng, { L"\x6587\x5B57\x5217\x306E\x5909\x63DB", L"\x3053\x3093\x306B\x3061\x306F\x4E16\x754C", L"\xD55C\xAD6D\xC5B4\xD14C\xC2A4\xD2B8" }, 20 + rng() % 20) } });
+        }
+
+        // Cyrillic, emoji, combining marks and hyperlinks. The emoji are spelled out as surrogate
+        // pairs, because wchar_t holds UTF-16 code units even where it's 32 bits wide.
+        auto& mixed = corpora.emplace_back(Corpus{ "mixed", {} }).lines;
+        for (size_t i = 0; i < distinctLines; ++i)
+        {
+            Line line;
+            line.push_back({ {}, pick(rng, { L"the", L"terminal", L"\x043F\x0440\x0438\x0432\x0435\x0442", L"\xD83D\xDE00\xD83D\xDE80", L"cafe\x0301", L"\x6587\x5B57" }, 20 + rng() % 40) });
+            if (i % 8 == 0)
+            {
+                TextAttribute attr;
+                attr.SetHyperlinkId(hyperlinkId);
+                attr.SetUnderlineStyle(UnderlineStyle::SinglyUnderlined);
+                line.push_back({ attr, L"https://example.com/" });
+            }
+            mixed.push_back(std::move(line));
+        }
+        return corpora;
+    }
+
+    size_t residentBytes()
+    {
+#if defined(__GLIBC__)
+        // Return the memory that ROWs freed to the OS, like Windows' heap would, as far as it's possible.
+        malloc_trim(0);
+#endif
+        size_t pages = 0;
+        size_t resident = 0;
+        std::ifstream statm{ "/proc/self/statm" };
+        statm >> pages >> resident;
+        return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+
+    // Writes `lines` lines of the corpus into a new buffer and returns the resident memory it gained.
+    size_t fill(TextBuffer& buffer, const Corpus& corpus, size_t lines)
+    {
+        const auto before = residentBytes();
+        for (size_t i = 0; i < lines; ++i)
+        {
+            const auto y = buffer.GetCursor().GetPosition().y;
+            til::CoordType column = 0;
+            for (const auto& segment : corpus.lines[i % corpus.lines.size()])
+            {
+                RowWriteState state{ .text = segment.text, .columnBegin = column };
+                buffer.Write(y, segment.attr, state);
+                column = state.columnEnd;
+            }
+            buffer.NewlineCursor();
+        }
+        const auto after = residentBytes();
+        return after > before ? after - before : 0;
+    }
+
+    bool equal(const TextBuffer& expected, const TextBuffer& actual, const Corpus& corpus)
+    {
+        for (til::CoordType y = 0; y < expected.TotalRowCount(); ++y)
+        {
+            const auto& a = expected.GetRowByOffset(y);
+            const auto& b = actual.GetRowByOffset(y);
+            if (a.GetText() != b.GetText() || a.Attributes() != b.Attributes() || a.WasWrapForced() != b.WasWrapForced() || a.GetLineRendition() != b.GetLineRendition())
+            {
+                fprintf(stderr, "scrollbench: row %d differs on %s\n", y, corpus.name.c_str());
+                return false;
+            }
+        }
+        return true;
+    }
+
+    struct OwnedRow
+    {
+        explicit OwnedRow(uint16_t width) :
+            chars{ std::make_unique<wchar_t[]>(width) },
+            charOffsets{ std::make_unique<uint16_t[]>(width + 1) },
+            row{ chars.get(), charOffsets.get(), width, {} }
+        {
+        }
+
+        std::unique_ptr<wchar_t[]> chars;
+        std::unique_ptr<uint16_t[]> charOffsets;
+        ROW row;
+    };
+
+    template<typename Func>
+    double measure(const size_t rows, const double minSeconds, Func&& func)
+    {
+        using clock = std::chrono::steady_clock;
+        size_t passes = 0;
+        const auto start = clock::now();
+        std::chrono::duration<double> elapsed{};
+        do
+        {
+            func();
+            ++passes;
+            elapsed = clock::now() - start;
+        } while (elapsed.count() < minSeconds);
+        return elapsed.count() * 1e9 / static_cast<double>(rows * passes);
+    }
+
+    // Returns the time it takes to encode and to decode a row of the corpus in ns.
+    std::pair<double, double> codec(const Corpus& corpus, uint16_t width, double minSeconds)
+    {
+        std::vector<std::unique_ptr<OwnedRow>> rows;
+        for (const auto& line : corpus.lines)
+        {
+            auto& r = rows.emplace_back(std::make_unique<OwnedRow>(width))->row;
+            til::CoordType column = 0;
+            for (const auto& segment : line)
+            {
+                RowWriteState state{ .text = segment.text, .columnBegin = column };
+                r.ReplaceText(state);
+                r.ReplaceAttributes(state.columnBegin, state.columnEnd, segment.attr);
+                column = state.columnEnd;
+            }
+        }
+
+        ColdRowStore store;
+        OwnedRow scratch{ width };
+        const auto encode = measure(rows.size(), minSeconds, [&]() {
+            for (size_t i = 0; i < rows.size(); ++i)
+            {
+                store.Discard(i);
+                store.Freeze(i, rows.size(), rows[i]->row);
+            }
+        });
+        // Freezing a thawed row again only marks it as frozen, so this measures Thaw().
+        const auto decode = measure(rows.size(), minSeconds, [&]() {
+            for (size_t i = 0; i < rows.size(); ++i)
+            {
+                store.Thaw(i, scratch.row);
+                store.Freeze(i, rows.size(), scratch.row);
+            }
+        });
+        return { encode, decode };
+    }
+
+    void usage()
+    {
+        fputs("usage: scrollbench [-w columns] [-r rows] [-l lines] [-t seconds]\n"
+              "Prints the resident memory of a TextBuffer per 100k lines of output with and\n"
+              "without the compressed scrollback, and its encode and decode time per row.\n",
+              stderr);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    til::CoordType width = 120;
+    til::CoordType height = 32000;
+    size_t lines = 100000;
+    auto minSeconds = 0.5;
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        const std::string_view arg{ argv[i] };
+        if ((arg == "-w" || arg == "-r" || arg == "-l" || arg == "-t") && i + 1 < argc)
+        {
+            const auto value = std::strtod(argv[++i], nullptr);
+            if (value <= 0 || (arg != "-t" && arg != "-l" && value > 65535))
+            {
+                usage();
+                return 1;
+            }
+            if (arg == "-w")
+            {
+                width = static_cast<til::CoordType>(value);
+            }
+            else if (arg == "-r")
+            {
+                height = static_cast<til::CoordType>(value);
+            }
+            else if (arg == "-l")
+            {
+                lines = static_cast<size_t>(value);
+            }
+            else
+            {
+                minSeconds = value;
+            }
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    Microsoft::Console::Render::Renderer renderer;
+    // Writing at least a full buffer of lines makes every row resident.
+    lines = std::max(lines, static_cast<size_t>(height));
+    const auto resident = static_cast<double>(height);
+    const auto scale = 100000.0 / resident / 1e6;
+
+    printf("%-12s %12s %12s %8s %10s %10s %10s\n", "corpus", "hot MB", "cold MB", "ratio", "B/row", "encode ns", "decode ns");
+
+    auto ok = true;
+    for (const auto& corpus : makeCorpora(1))
+    {
+        TextBuffer hot{ { width, height }, {}, 0, false, renderer };
+        hot.EnableColdScrollback(false);
+        hot.AddHyperlinkToMap(L"https://example.com/", hot.GetHyperlinkId(L"https://example.com/", L""));
+        const auto hotBytes = fill(hot, corpus, lines);
+
+        TextBuffer cold{ { width, height }, {}, 0, false, renderer };
+        cold.AddHyperlinkToMap(L"https://example.com/", cold.GetHyperlinkId(L"https://example.com/", L""));
+        const auto coldBytes = fill(cold, corpus, lines);
+        const auto coldRows = cold.GetColdRows().ColdRowCount();
+        const auto storeBytes = cold.GetColdRows().MemoryUsage();
+
+        if (!coldRows)
+        {
+            fprintf(stderr, "scrollbench: no rows were frozen on %s\n", corpus.name.c_str());
+            ok = false;
+        }
+        ok &= equal(hot, cold, corpus);
+
+        const auto [encode, decode] = codec(corpus, gsl::narrow<uint16_t>(width), minSeconds);
+        printf("%-12s %12.1f %12.1f %8.2f %10.1f %10.1f %10.1f\n",
+               corpus.name.c_str(),
+               static_cast<double>(hotBytes) * scale,
+               static_cast<double>(coldBytes) * scale,
+               coldBytes ? static_cast<double>(hotBytes) / static_cast<double>(coldBytes) : 0.0,
+               coldRows ? static_cast<double>(storeBytes) / static_cast<double>(coldRows) : 0.0,
+               encode,
+               decode);
+    }
+    return ok ? 0 : 1;
+}
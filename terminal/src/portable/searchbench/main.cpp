@@ -0,0 +1,251 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+/*
+Module Name:
+- main.cpp
+
+Abstract:
+- searchbench measures the latency of TextBuffer::SearchText() against the
+  size of the scrollback, with and without the trigram index (see
+  buffer/out/TrigramIndex.hpp). The search box runs a search on every
+  keystroke and after new output, so next to the latency of a search over
+  unchanged text, it measures the latency right after new lines were written.
+- It checks that both searches return the same matches and fails otherwise.
+*/
+
+#include "LibraryIncludes.h"
+
+#include "../buffer/out/textBuffer.hpp"
+#include "../renderer/base/renderer.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+    struct Needle
+    {
+        std::wstring_view text;
+        bool caseInsensitive;
+    };
+
+    // A rare needle, one that's on every 100th line, a case insensitive one that's on about
+    // every 10th line, and one that's too short for the index, which falls back to a full scan.
+    constexpr Needle needles[]{
+        { L"0xdeadbeef", false },
+        { L"status=500", false },
+        { L"get /API/v1", true },
+        { L"ms", false },
+    };
+
+    std::wstring makeLine(std::mt19937& rng, size_t i, til::CoordType width)
+    {
+        static constexpr std::wstring_view words[]{ L"request", L"completed", L"in", L"42ms", L"GET", L"/api/v1/items", L"status=200", L"bytes=1834", L"user=alice", L"cache=miss" };
+
+        wchar_t prefix[64];
+        swprintf(prefix, 64, L"2024-05-01 12:%02zu:%02zu.%03zu INFO [worker-%zu] ", i / 60 % 60, i % 60, i % 1000, i % 8);
+        std::wstring line{ prefix };
+        if (i % 100 == 0)
+        {
+            line.append(L"status=500 ");
+        }
+        if (i % 5000 == 4999)
+        {
+            line.append(L"panic at 0xDEADBEEF 0xdeadbeef ");
+        }
+        // Some lines are longer than the buffer is wide and wrap.
+        const auto columns = std::max(line.size(), static_cast<size_t>(width) * (rng() % 8 == 0 ? 2 : 1) - 12);
+        while (line.size() < columns)
+        {
+            line.append(words[rng() % std::size(words)]);
+            line.push_back(L' ');
+        }
+        return line;
+    }
+
+    void writeLine(TextBuffer& buffer, std::wstring_view text)
+    {
+        RowWriteState state{ .text = text };
+        buffer.Write(buffer.GetCursor().GetPosition().y, {}, state);
+        buffer.NewlineCursor();
+    }
+
+    template<typename Func>
+    double measure(const double minSeconds, Func&& func)
+    {
+        using clock = std::chrono::steady_clock;
+        size_t passes = 0;
+        const auto start = clock::now();
+        std::chrono::duration<double> elapsed{};
+        do
+        {
+            func();
+            ++passes;
+            elapsed = clock::now() - start;
+        } while (elapsed.count() < minSeconds);
+        return elapsed.count() * 1e3 / static_cast<double>(passes);
+    }
+
+    double once(auto&& func)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        func();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    bool equal(const std::vector<til::point_span>& expected, const std::vector<til::point_span>& actual)
+    {
+        if (expected.size() != actual.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            if (expected[i].start != actual[i].start || expected[i].end != actual[i].end)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool verify(const std::vector<til::point_span>& expected, const std::vector<til::point_span>& actual, const Needle& needle, til::CoordType rows)
+    {
+        if (!equal(expected, actual))
+        {
+            fprintf(stderr, "searchbench: the results differ for \"%ls\" on %d rows\n", std::wstring{ needle.text }.c_str(), rows);
+            return false;
+        }
+        return true;
+    }
+
+    void usage()
+    {
+        fputs("usage: searchbench [-w columns] [-r rows] [-n lines] [-t seconds]\n"
+              "Prints the latency of TextBuffer::SearchText() in ms against the number of rows,\n"
+              "scanning all rows and using the trigram index, and the latter right after\n"
+              "writing a few new lines.\n",
+              stderr);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    til::CoordType width = 120;
+    til::CoordType maxRows = 65535;
+    size_t newLines = 16;
+    auto minSeconds = 0.5;
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        const std::string_view arg{ argv[i] };
+        if ((arg == "-w" || arg == "-r" || arg == "-n" || arg == "-t") && i + 1 < argc)
+        {
+            const auto value = std::strtod(argv[++i], nullptr);
+            if (value <= 0 || (arg != "-t" && value > 65535))
+            {
+                usage();
+                return 1;
+            }
+            if (arg == "-w")
+            {
+                width = static_cast<til::CoordType>(value);
+            }
+            else if (arg == "-r")
+            {
+                maxRows = static_cast<til::CoordType>(value);
+            }
+            else if (arg == "-n")
+            {
+                newLines = static_cast<size_t>(value);
+            }
+            else
+            {
+                minSeconds = value;
+            }
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    Microsoft::Console::Render::Renderer renderer;
+    std::vector<til::CoordType> sizes;
+    for (til::CoordType rows = 1000; rows < maxRows / 2; rows *= 4)
+    {
+        sizes.emplace_back(rows);
+    }
+    sizes.emplace_back(maxRows);
+
+    printf("%-8s %-14s %8s %10s %10s %10s %10s %10s\n", "rows", "needle", "matches", "full ms", "index ms", "+new ms", "build ms", "index MB");
+
+    auto ok = true;
+    for (const auto rows : sizes)
+    {
+        std::mt19937 rng{ 42 };
+        size_t line = 0;
+
+        // Write more lines than the buffer holds, so that its rows are in circulation.
+        TextBuffer buffer{ { width, rows }, {}, 0, false, renderer };
+        for (const auto end = static_cast<size_t>(rows) * 5 / 4; line < end; ++line)
+        {
+            writeLine(buffer, makeLine(rng, line, width));
+        }
+
+        // The first indexed search builds the index of the entire buffer.
+        const auto build = once([&]() {
+            buffer.SearchText(needles[0].text, needles[0].caseInsensitive);
+        });
+        const auto indexBytes = buffer.GetSearchIndex().MemoryUsage();
+
+        for (const auto& needle : needles)
+        {
+            const auto expected = buffer.SearchText(needle.text, needle.caseInsensitive, 0, til::CoordTypeMax);
+            const auto full = measure(minSeconds, [&]() {
+                buffer.SearchText(needle.text, needle.caseInsensitive, 0, til::CoordTypeMax);
+            });
+
+            auto actual = buffer.SearchText(needle.text, needle.caseInsensitive);
+            const auto indexed = measure(minSeconds, [&]() {
+                buffer.SearchText(needle.text, needle.caseInsensitive);
+            });
+            ok &= verify(expected, actual, needle, rows);
+
+            // New output makes the blocks of the rows it was written to outdated.
+            double added = 0;
+            for (auto pass = 0; pass < 8; ++pass)
+            {
+                for (size_t n = 0; n < newLines; ++n, ++line)
+                {
+                    writeLine(buffer, makeLine(rng, line, width));
+                }
+                added += once([&]() {
+                    actual = buffer.SearchText(needle.text, needle.caseInsensitive);
+                });
+            }
+            ok &= verify(buffer.SearchText(needle.text, needle.caseInsensitive, 0, til::CoordTypeMax), actual, needle, rows);
+
+            char buildText[16]{};
+            char bytesText[16]{};
+            if (&needle == &needles[0])
+            {
+                snprintf(buildText, sizeof(buildText), "%.2f", build);
+                snprintf(bytesText, sizeof(bytesText), "%.2f", static_cast<double>(indexBytes) / 1e6);
+            }
+            printf("%-8d %-14ls %8zu %10.2f %10.3f %10.3f %10s %10s\n",
+                   rows,
+                   std::wstring{ needle.text }.c_str(),
+                   expected.size(),
+                   full,
+                   indexed,
+                   added / 8,
+                   buildText,
+                   bytesText);
+        }
+    }
+    return ok ? 0 : 1;
+}
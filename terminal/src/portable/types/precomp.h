@@ -0,0 +1,17 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+/*
+Module Name:
+- precomp.h
+
+Abstract:
+- Replaces src/types/precomp.h, which needs the console driver headers of
+  the Windows SDK and DDK. CMakeLists.txt copies this file and the portable
+  sources of src/types into one directory of the build tree, so that their
+  #include "precomp.h" finds this one.
+*/
+
+#pragma once
+
+#include "LibraryIncludes.h"
@@ -0,0 +1,273 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+/*
+Module Name:
+- main.cpp
+
+Abstract:
+- u8u16bench measures the UTF-8 to UTF-16 conversion of til::u8u16 in GB/s
+  of UTF-8 input, per corpus and per code path of the transcoder in
+  til/u8u16transcode.h, next to the MultiByteToWideChar of win32.cpp.
+- Before timing anything, it checks that every path produces the same code
+  units as MultiByteToWideChar, including on random bytes, and that the
+  streaming til::u8u16 produces them regardless of where the input is split.
+*/
+
+#include "LibraryIncludes.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+    struct Corpus
+    {
+        std::string name;
+        std::string text;
+    };
+
+    std::string makeCorpus(std::mt19937& rng, size_t size, std::initializer_list<std::string_view> words)
+    {
+        std::string out;
+        size_t column = 0;
+        while (out.size() < size)
+        {
+            const auto& word = words.begin()[rng() % words.size()];
+            out.append(word);
+            column += word.size() + 1;
+            if (column > 72)
+            {
+                out.append("\r\n");
+                column = 0;
+            }
+            else
+            {
+                out.push_back(' ');
+            }
+        }
+        return out;
+    }
+
+    std::vector<Corpus> makeCorpora(size_t size)
+    {
+        std::mt19937 rng{ 42 };
+        std::vector<Corpus> corpora;
+        corpora.push_back({ "ascii", makeCorpus(rng, size, { "the", "terminal", "renders", "every", "character", "of", "output", "./src/til/u8u16convert.h:123:" }) });
+        corpora.push_back({ "cyrillic", makeCorpus(rng, size, { "\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82", "\xd0\xbc\xd0\xb8\xd1\x80", "\xd1\x82\xd0\xb5\xd1\x80\xd0\xbc\xd0\xb8\xd0\xbd\xd0\xb0\xd0\xbb" }) });
+        // CJK text has no spaces, so the words are long runs of 3 byte characters.
+        corpora.push_back({ "cjk", makeCorpus(rng, size, { "\xe6\x96\x87\xe5\xad\x97\xe5\x88\x97\xe3\x81\xae\xe5\xa4\x89\xe6\x8f\x9b", "\xe3\x81\x93\xe3\x82\x93\xe3\x81\xab\xe3\x81\xa1\xe3\x81\xaf\xe4\xb8\x96\xe7\x95\x8c", "\xed\x95\x9c\xea\xb5\xad\xec\x96\xb4\xed\x85\x8c\xec\x8a\xa4\xed\x8a\xb8" }) });
+        corpora.push_back({ "emoji", makeCorpus(rng, size, { "\xf0\x9f\x98\x80\xf0\x9f\x98\x81", "\xf0\x9f\x9a\x80\xf0\x9f\x8c\x8d\xf0\x9f\x8e\x89", "\xf0\x9f\x91\x8d" }) });
+        corpora.push_back({ "mixed", makeCorpus(rng, size, { "the", "terminal", "\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82", "\xe6\x96\x87\xe5\xad\x97\xe5\x88\x97", "\xf0\x9f\x98\x80" }) });
+
+        std::string random(size, '\0');
+        for (auto& ch : random)
+        {
+            ch = static_cast<char>(rng());
+        }
+        corpora.push_back({ "random bytes", std::move(random) });
+        return corpora;
+    }
+
+    template<typename Func>
+    double measure(const size_t bytes, const double minSeconds, Func&& func)
+    {
+        using clock = std::chrono::steady_clock;
+        size_t passes = 0;
+        const auto start = clock::now();
+        std::chrono::duration<double> elapsed{};
+        do
+        {
+            func();
+            ++passes;
+            elapsed = clock::now() - start;
+        } while (elapsed.count() < minSeconds);
+        return static_cast<double>(bytes) * static_cast<double>(passes) / elapsed.count() / 1e9;
+    }
+
+    using Path = size_t (*)(const std::string& in, char16_t* out);
+
+    struct NamedPath
+    {
+        const char* name;
+        Path path;
+        bool available;
+    };
+
+    template<typename Func>
+    size_t transcodeWith(Func&& func, const std::string& in, char16_t* out)
+    {
+        const auto beg = reinterpret_cast<const uint8_t*>(in.data());
+        bool valid = true;
+        return gsl::narrow_cast<size_t>(func(beg, beg + in.size(), out, valid) - out);
+    }
+
+    std::vector<NamedPath> paths()
+    {
+        std::vector<NamedPath> paths;
+        paths.push_back({ "scalar", [](const std::string& in, char16_t* out) {
+                             return transcodeWith(til::details::u8u16_scalar<char16_t>, in, out);
+                         },
+                          true });
+#if defined(TIL_SSE_INTRINSICS)
+        paths.push_back({ "sse4.1", [](const std::string& in, char16_t* out) {
+                             return transcodeWith(til::details::u8u16_sse41<char16_t>, in, out);
+                         },
+                          __isa_available >= __ISA_AVAILABLE_SSE42 });
+        paths.push_back({ "avx2", [](const std::string& in, char16_t* out) {
+                             return transcodeWith(til::details::u8u16_avx2<char16_t>, in, out);
+                         },
+                          __isa_available >= __ISA_AVAILABLE_AVX2 });
+#endif
+        return paths;
+    }
+
+    std::wstring reference(const std::string& in)
+    {
+        std::wstring out(in.size(), L'\0');
+        out.resize(static_cast<size_t>(MultiByteToWideChar(CP_UTF8, 0, in.data(), static_cast<int>(in.size()), out.data(), static_cast<int>(out.size()))));
+        return out;
+    }
+
+    template<typename T>
+    bool equal(const std::wstring& expected, const T* actual, size_t length)
+    {
+        return expected.size() == length && std::equal(expected.begin(), expected.end(), actual, [](wchar_t a, T b) { return static_cast<uint32_t>(a) == static_cast<uint32_t>(b); });
+    }
+
+    bool check(const Corpus& corpus, const std::vector<NamedPath>& paths)
+    {
+        const auto expected = reference(corpus.text);
+        std::vector<char16_t> buffer(corpus.text.size());
+        auto ok = true;
+        for (const auto& path : paths)
+        {
+            if (path.available && !equal(expected, buffer.data(), path.path(corpus.text, buffer.data())))
+            {
+                fprintf(stderr, "u8u16bench: %s differs from MultiByteToWideChar on %s\n", path.name, corpus.name.c_str());
+                ok = false;
+            }
+        }
+
+        // Streaming in writes of odd sizes splits characters everywhere. The
+        // result is the same as a one-shot conversion, unless the input is ill-formed.
+        if (til::is_valid_utf8(corpus.text) != (corpus.name != "random bytes"))
+        {
+            fprintf(stderr, "u8u16bench: is_valid_utf8 is wrong on %s\n", corpus.name.c_str());
+            ok = false;
+        }
+        if (corpus.name != "random bytes")
+        {
+            std::mt19937 rng{ 1 };
+            til::u8state state;
+            std::wstring streamed;
+            std::wstring chunk;
+            for (size_t i = 0; i < corpus.text.size();)
+            {
+                const auto length = std::min<size_t>(1 + rng() % 37, corpus.text.size() - i);
+                THROW_IF_FAILED(til::u8u16({ corpus.text.data() + i, length }, chunk, state));
+                streamed.append(chunk);
+                i += length;
+            }
+            if (streamed != expected)
+            {
+                fprintf(stderr, "u8u16bench: the streaming til::u8u16 differs from MultiByteToWideChar on %s\n", corpus.name.c_str());
+                ok = false;
+            }
+        }
+        return ok;
+    }
+
+    void usage()
+    {
+        fputs("usage: u8u16bench [-s corpus-bytes] [-t seconds]\n"
+              "Prints the throughput of the UTF-8 to UTF-16 conversion in GB/s of UTF-8\n"
+              "input, per corpus and per code path.\n",
+              stderr);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t corpusSize = 1024 * 1024;
+    auto minSeconds = 0.5;
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        const std::string_view arg{ argv[i] };
+        if ((arg == "-s" || arg == "-t") && i + 1 < argc)
+        {
+            const auto value = std::strtod(argv[++i], nullptr);
+            if (value <= 0)
+            {
+                usage();
+                return 1;
+            }
+            if (arg == "-s")
+            {
+                corpusSize = static_cast<size_t>(value);
+            }
+            else
+            {
+                minSeconds = value;
+            }
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    const auto corpora = makeCorpora(corpusSize);
+    const auto allPaths = paths();
+
+    auto ok = true;
+    for (const auto& corpus : corpora)
+    {
+        ok &= check(corpus, allPaths);
+    }
+    if (!ok)
+    {
+        return 1;
+    }
+
+    printf("%-14s %10s", "corpus", "MBTWC");
+    printf(" %10s", "u8u16");
+    for (const auto& path : allPaths)
+    {
+        printf(" %10s", path.name);
+    }
+    printf("   (GB/s)\n");
+
+    for (const auto& corpus : corpora)
+    {
+        const auto bytes = corpus.text.size();
+        const auto length = static_cast<int>(bytes);
+        std::vector<wchar_t> wide(bytes);
+        std::vector<char16_t> narrow(bytes);
+        std::wstring string;
+
+        printf("%-14s", corpus.name.c_str());
+        printf(" %10.2f", measure(bytes, minSeconds, [&]() {
+                   MultiByteToWideChar(CP_UTF8, 0, corpus.text.data(), length, wide.data(), length);
+               }));
+        printf(" %10.2f", measure(bytes, minSeconds, [&]() {
+                   THROW_IF_FAILED(til::u8u16(corpus.text, string));
+               }));
+        for (const auto& path : allPaths)
+        {
+            if (!path.available)
+            {
+                printf(" %10s", "-");
+                continue;
+            }
+            printf(" %10.2f", measure(bytes, minSeconds, [&]() {
+                       path.path(corpus.text, narrow.data());
+                   }));
+        }
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,491 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+/*
+Module Name:
+- main.cpp
+
+Abstract:
+- vtbench replays VT output through the output state machine and reports
+  its throughput per corpus in MB/s of UTF-8 input. The built-in corpora
+  model the output of "ls -R", of "cat" on multilingual text, of colorful
+  prompts and diffs heavy on SGR, and of progress bars. Files given on the
+  command line are replayed as corpora of their own.
+- The dispatch only counts what it receives, so the numbers are the cost of
+  the parser, and of the UTF-8 to UTF-16 conversion in the "u8u16+parse"
+  column, which mirrors what the console does with each write.
+*/
+
+#include "LibraryIncludes.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+#include "../../terminal/adapter/termDispatch.hpp"
+#include "../../terminal/parser/OutputStateMachineEngine.hpp"
+#include "../../terminal/parser/stateMachine.hpp"
+
+using namespace Microsoft::Console::VirtualTerminal;
+
+namespace
+{
+    // Counts the calls it receives, and accepts the common ones so that the
+    // state machine takes the same paths as with a real terminal.
+    class CountingDispatch final : public TermDispatch
+    {
+    public:
+        struct Counts
+        {
+            uint64_t printed = 0;
+            uint64_t strings = 0;
+            uint64_t controls = 0;
+            uint64_t sgr = 0;
+            uint64_t sgrParameters = 0;
+            uint64_t cursor = 0;
+            uint64_t erase = 0;
+            uint64_t osc = 0;
+
+            uint64_t total() const noexcept
+            {
+                return printed + strings + controls + sgr + sgrParameters + cursor + erase + osc;
+            }
+        };
+
+        explicit CountingDispatch(Counts& counts) noexcept :
+            _counts{ counts }
+        {
+        }
+
+        void Print(const wchar_t) override
+        {
+            ++_counts.printed;
+        }
+
+        void PrintString(const std::wstring_view string) override
+        {
+            ++_counts.strings;
+            _counts.printed += string.size();
+        }
+
+        bool CarriageReturn() override
+        {
+            ++_counts.controls;
+            return true;
+        }
+
+        bool LineFeed(const DispatchTypes::LineFeedType) override
+        {
+            ++_counts.controls;
+            return true;
+        }
+
+        bool ForwardTab(const VTInt) override
+        {
+            ++_counts.controls;
+            return true;
+        }
+
+        bool CursorBackward(const VTInt) override
+        {
+            ++_counts.controls;
+            return true;
+        }
+
+        bool WarningBell() override
+        {
+            ++_counts.controls;
+            return true;
+        }
+
+        bool SetGraphicsRendition(const VTParameters options) override
+        {
+            ++_counts.sgr;
+            _counts.sgrParameters += options.size();
+            return true;
+        }
+
+        bool CursorUp(const VTInt) override
+        {
+            ++_counts.cursor;
+            return true;
+        }
+
+        bool CursorDown(const VTInt) override
+        {
+            ++_counts.cursor;
+            return true;
+        }
+
+        bool CursorForward(const VTInt) override
+        {
+            ++_counts.cursor;
+            return true;
+        }
+
+        bool CursorHorizontalPositionAbsolute(const VTInt) override
+        {
+            ++_counts.cursor;
+            return true;
+        }
+
+        bool CursorPosition(const VTInt, const VTInt) override
+        {
+            ++_counts.cursor;
+            return true;
+        }
+
+        bool EraseInLine(const DispatchTypes::EraseType) override
+        {
+            ++_counts.erase;
+            return true;
+        }
+
+        bool EraseInDisplay(const DispatchTypes::EraseType) override
+        {
+            ++_counts.erase;
+            return true;
+        }
+
+        bool SetWindowTitle(const std::wstring_view) override
+        {
+            ++_counts.osc;
+            return true;
+        }
+
+        bool AddHyperlink(const std::wstring_view, const std::wstring_view) override
+        {
+            ++_counts.osc;
+            return true;
+        }
+
+        bool EndHyperlink() override
+        {
+            ++_counts.osc;
+            return true;
+        }
+
+    private:
+        Counts& _counts;
+    };
+
+    struct Corpus
+    {
+        std::string name;
+        std::string text;
+    };
+
+    // Recursive listing of a source tree in the format of "ls -R --color".
+    std::string makeListing(std::mt19937& rng, size_t size)
+    {
+        static constexpr std::string_view stems[]{
+            "stateMachine", "OutputStateMachineEngine", "textBuffer", "Row", "cursor", "search",
+            "utils", "viewport", "precomp", "main", "README", "LICENSE", "adaptDispatch", "til"
+        };
+        static constexpr std::string_view extensions[]{ ".cpp", ".hpp", ".h", ".md", ".vcxproj", ".filters", "" };
+        std::string out;
+        size_t directory = 0;
+        while (out.size() < size)
+        {
+            out.append("./src/module");
+            out.append(std::to_string(directory++));
+            out.append(":\n");
+            const auto entries = 4 + rng() % 24;
+            for (size_t i = 0; i < entries; ++i)
+            {
+                const auto& stem = stems[rng() % std::size(stems)];
+                if (rng() % 5 == 0)
+                {
+                    out.append("\x1b[01;34m");
+                    out.append(stem);
+                    out.append("\x1b[0m");
+                }
+                else
+                {
+                    out.append(stem);
+                    out.append(extensions[rng() % std::size(extensions)]);
+                }
+                out.append(i + 1 == entries || i % 6 == 5 ? "\n" : "  ");
+            }
+            out.append("\n");
+        }
+        return out;
+    }
+
+    // Paragraphs of English, Cyrillic, Greek, CJK, and emoji, as printed by "cat".
+    std::string makeText(std::mt19937& rng, size_t size)
+    {
+        static constexpr std::string_view words[]{
+            "the", "terminal", "renders", "every", "character", "of", "output",
+            "\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82", // привет
+            "\xce\xba\xce\xb1\xce\xbb\xce\xb7\xce\xbc\xce\xad\xcf\x81\xce\xb1", // καλημέρα
+            "\xe6\x96\x87\xe5\xad\x97\xe5\x88\x97", // 文字列
+            "\xe3\x81\x93\xe3\x82\x93\xe3\x81\xab\xe3\x81\xa1\xe3\x81\xaf", // こんにちは
+            "\xed\x95\x9c\xea\xb5\xad\xec\x96\xb4", // 한국어
+            "\xf0\x9f\x98\x80", // 😀
+            "\xf0\x9f\x9a\x80\xf0\x9f\x8c\x8d", // 🚀🌍
+        };
+        std::string out;
+        size_t column = 0;
+        while (out.size() < size)
+        {
+            const auto& word = words[rng() % std::size(words)];
+            out.append(word);
+            column += word.size() + 1;
+            if (column > 72)
+            {
+                out.append("\r\n");
+                column = 0;
+            }
+            else
+            {
+                out.push_back(' ');
+            }
+        }
+        return out;
+    }
+
+    // Colored diff and prompt output, which changes the rendition every few cells.
+    std::string makeSgr(std::mt19937& rng, size_t size)
+    {
+        std::string out;
+        while (out.size() < size)
+        {
+            switch (rng() % 4)
+            {
+            case 0:
+                out.append("\x1b[38;2;");
+                out.append(std::to_string(rng() % 256));
+                out.push_back(';');
+                out.append(std::to_string(rng() % 256));
+                out.push_back(';');
+                out.append(std::to_string(rng() % 256));
+                out.push_back('m');
+                break;
+            case 1:
+                out.append("\x1b[48;5;");
+                out.append(std::to_string(rng() % 256));
+                out.push_back('m');
+                break;
+            case 2:
+                out.append("\x1b[1;3");
+                out.push_back(static_cast<char>('0' + rng() % 8));
+                out.push_back('m');
+                break;
+            default:
+                out.append("\x1b[m");
+                break;
+            }
+            const auto cells = 1 + rng() % 6;
+            for (size_t i = 0; i < cells; ++i)
+            {
+                out.push_back(static_cast<char>('!' + rng() % 94));
+            }
+            if (rng() % 16 == 0)
+            {
+                out.append("\x1b[m\r\n");
+            }
+        }
+        return out;
+    }
+
+    // Package manager style progress bars redrawn in place, with a title and
+    // a status line under them.
+    std::string makeProgress(std::mt19937& rng, size_t size)
+    {
+        std::string out;
+        int percent = 0;
+        while (out.size() < size)
+        {
+            percent = (percent + 1 + static_cast<int>(rng() % 3)) % 101;
+            const auto filled = percent * 40 / 100;
+            out.append("\x1b]0;Downloading ");
+            out.append(std::to_string(percent));
+            out.append("%\x07");
+            out.append("\r\x1b[K\x1b[32m[");
+            out.append(static_cast<size_t>(filled), '#');
+            out.append(static_cast<size_t>(40 - filled), ' ');
+            out.append("]\x1b[0m ");
+            out.append(std::to_string(percent));
+            out.append("% ");
+            out.append(std::to_string(rng() % 100));
+            out.append(".");
+            out.append(std::to_string(rng() % 10));
+            out.append(" MB/s\r\n\x1b[2K");
+            out.append("\xe2\xa0\x8b fetching package-");
+            out.append(std::to_string(rng() % 1000));
+            out.append("\x1b[1A\x1b[");
+            out.append(std::to_string(1 + rng() % 80));
+            out.append("G");
+        }
+        return out;
+    }
+
+    std::vector<Corpus> makeCorpora(size_t size)
+    {
+        std::mt19937 rng{ 42 };
+        std::vector<Corpus> corpora;
+        corpora.push_back({ "ls -R", makeListing(rng, size) });
+        corpora.push_back({ "cat utf-8", makeText(rng, size) });
+        corpora.push_back({ "sgr", makeSgr(rng, size) });
+        corpora.push_back({ "progress", makeProgress(rng, size) });
+        return corpora;
+    }
+
+    struct Result
+    {
+        double parseMBps = 0;
+        double convertMBps = 0;
+        uint64_t events = 0;
+    };
+
+    template<typename Func>
+    double measure(const size_t bytes, const double minSeconds, Func&& func)
+    {
+        using clock = std::chrono::steady_clock;
+        size_t passes = 0;
+        const auto start = clock::now();
+        std::chrono::duration<double> elapsed{};
+        do
+        {
+            func();
+            ++passes;
+            elapsed = clock::now() - start;
+        } while (elapsed.count() < minSeconds);
+        return static_cast<double>(bytes) * static_cast<double>(passes) / elapsed.count() / 1e6;
+    }
+
+    // Splits text into writes of chunkSize bytes, as a pseudoconsole reads
+    // them from its pipe, regardless of where UTF-8 sequences end.
+    std::vector<std::string_view> split(const std::string& text, const size_t chunkSize)
+    {
+        std::vector<std::string_view> chunks;
+        for (size_t i = 0; i < text.size(); i += chunkSize)
+        {
+            chunks.emplace_back(text.data() + i, std::min(chunkSize, text.size() - i));
+        }
+        return chunks;
+    }
+
+    Result run(const Corpus& corpus, const size_t chunkSize, const double minSeconds)
+    {
+        CountingDispatch::Counts counts;
+        StateMachine machine{ std::make_unique<OutputStateMachineEngine>(std::make_unique<CountingDispatch>(counts)) };
+        const auto chunks = split(corpus.text, chunkSize);
+
+        std::vector<std::wstring> converted;
+        til::u8state state;
+        for (const auto& chunk : chunks)
+        {
+            converted.emplace_back(til::u8u16(chunk, state));
+        }
+
+        Result result;
+        result.parseMBps = measure(corpus.text.size(), minSeconds, [&]() {
+            for (const auto& chunk : converted)
+            {
+                machine.ProcessString(chunk);
+            }
+        });
+
+        counts = {};
+        machine.ProcessString(L"\x1b[m\x1b\\");
+        for (const auto& chunk : converted)
+        {
+            machine.ProcessString(chunk);
+        }
+        result.events = counts.total();
+
+        std::wstring buffer;
+        result.convertMBps = measure(corpus.text.size(), minSeconds, [&]() {
+            for (const auto& chunk : chunks)
+            {
+                THROW_IF_FAILED(til::u8u16(chunk, buffer, state));
+                machine.ProcessString(buffer);
+            }
+        });
+        return result;
+    }
+
+    void usage()
+    {
+        fputs("usage: vtbench [-s corpus-bytes] [-c chunk-bytes] [-t seconds] [file...]\n"
+              "Replays the built-in corpora, or the given files, through the VT output\n"
+              "parser and prints the throughput in MB/s of UTF-8 input.\n",
+              stderr);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t corpusSize = 4 * 1024 * 1024;
+    size_t chunkSize = 4096;
+    auto minSeconds = 0.5;
+    std::vector<Corpus> corpora;
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        const std::string_view arg{ argv[i] };
+        if ((arg == "-s" || arg == "-c" || arg == "-t") && i + 1 < argc)
+        {
+            const auto value = std::strtod(argv[++i], nullptr);
+            if (value <= 0)
+            {
+                usage();
+                return 1;
+            }
+            if (arg == "-s")
+            {
+                corpusSize = static_cast<size_t>(value);
+            }
+            else if (arg == "-c")
+            {
+                chunkSize = static_cast<size_t>(value);
+            }
+            else
+            {
+                minSeconds = value;
+            }
+        }
+        else if (arg.starts_with("-"))
+        {
+            usage();
+            return 1;
+        }
+        else
+        {
+            std::ifstream file{ argv[i], std::ios::binary };
+            if (!file)
+            {
+                fprintf(stderr, "vtbench: cannot read %s\n", argv[i]);
+                return 1;
+            }
+            std::ostringstream text;
+            text << file.rdbuf();
+            corpora.push_back({ std::string{ arg }, text.str() });
+        }
+    }
+
+    if (corpora.empty())
+    {
+        corpora = makeCorpora(corpusSize);
+    }
+
+    printf("%-24s %10s %12s %16s %12s\n", "corpus", "bytes", "parse MB/s", "u8u16+parse MB/s", "events");
+    for (const auto& corpus : corpora)
+    {
+        if (corpus.text.empty())
+        {
+            continue;
+        }
+        const auto result = run(corpus, chunkSize, minSeconds);
+        printf("%-24s %10zu %12.1f %16.1f %12llu\n",
+               corpus.name.c_str(),
+               corpus.text.size(),
+               result.parseMBps,
+               result.convertMBps,
+               static_cast<unsigned long long>(result.events));
+    }
+    return 0;
+}
@@ -0,0 +1,624 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+/*
+Module Name:
+- win32.cpp
+
+Abstract:
+- Implements the few Win32 functions the portable build calls, declared in
+  inc/windows.h and src/interactivity/inc/VtApiRedirection.hpp.
+- The keyboard functions assume a US keyboard layout, which is all the input
+  engine needs to synthesize key events.
+*/
+
+#include "LibraryIncludes.h"
+
+#include <isa_availability.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "../interactivity/inc/VtApiRedirection.hpp"
+
+namespace
+{
+    thread_local DWORD lastError = 0;
+
+    // mmap needs the size of a region to release it, which VirtualFree isn't given.
+    std::mutex reservationsMutex;
+    std::map<uintptr_t, size_t> reservations;
+
+    std::optional<std::pair<uintptr_t, size_t>> findReservation(uintptr_t address) noexcept
+    {
+        const std::lock_guard lock{ reservationsMutex };
+        auto it = reservations.upper_bound(address);
+        if (it == reservations.begin())
+        {
+            return std::nullopt;
+        }
+        --it;
+        if (address >= it->first + it->second)
+        {
+            return std::nullopt;
+        }
+        return *it;
+    }
+
+    size_t pageSize() noexcept
+    {
+        static const auto size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return size;
+    }
+
+    int detectIsaAvailable() noexcept
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return __ISA_AVAILABLE_AVX2;
+        }
+        if (__builtin_cpu_supports("avx"))
+        {
+            return __ISA_AVAILABLE_AVX;
+        }
+        if (__builtin_cpu_supports("sse4.2"))
+        {
+            return __ISA_AVAILABLE_SSE42;
+        }
+        if (__builtin_cpu_supports("sse2"))
+        {
+            return __ISA_AVAILABLE_SSE2;
+        }
+#endif
+        return __ISA_AVAILABLE_X86;
+    }
+
+    constexpr char32_t replacementChar = 0xFFFD;
+
+    // Appends one code point as UTF-16 to dst, or only counts it if dst is null.
+    // Returns false if dst is too small.
+    bool putUtf16(char32_t cp, wchar_t* dst, int capacity, int& length) noexcept
+    {
+        const auto units = cp >= 0x10000 ? 2 : 1;
+        if (dst)
+        {
+            if (capacity - length < units)
+            {
+                return false;
+            }
+            if (units == 2)
+            {
+                cp -= 0x10000;
+                dst[length] = static_cast<wchar_t>(0xD800 | (cp >> 10));
+                dst[length + 1] = static_cast<wchar_t>(0xDC00 | (cp & 0x3FF));
+            }
+            else
+            {
+                dst[length] = static_cast<wchar_t>(cp);
+            }
+        }
+        length += units;
+        return true;
+    }
+
+    // Decodes the UTF-8 sequence at src[0..count), which is not empty. Returns
+    // the number of bytes consumed, and sets cp to U+FFFD and valid to false if
+    // they form a maximal ill-formed subsequence instead, as defined by Unicode
+    // in "U+FFFD Substitution of Maximal Subparts".
+    size_t decodeUtf8(const uint8_t* src, size_t count, char32_t& cp, bool& valid) noexcept
+    {
+        const auto lead = src[0];
+        valid = false;
+        cp = replacementChar;
+
+        if (lead < 0x80)
+        {
+            cp = lead;
+            valid = true;
+            return 1;
+        }
+
+        size_t length;
+        uint8_t lower = 0x80;
+        uint8_t upper = 0xBF;
+        if (lead >= 0xC2 && lead <= 0xDF)
+        {
+            length = 2;
+        }
+        else if (lead >= 0xE0 && lead <= 0xEF)
+        {
+            length = 3;
+            lower = lead == 0xE0 ? 0xA0 : 0x80;
+            upper = lead == 0xED ? 0x9F : 0xBF;
+        }
+        else if (lead >= 0xF0 && lead <= 0xF4)
+        {
+            length = 4;
+            lower = lead == 0xF0 ? 0x90 : 0x80;
+            upper = lead == 0xF4 ? 0x8F : 0xBF;
+        }
+        else
+        {
+            return 1;
+        }
+
+        char32_t value = lead & (0x7F >> length);
+        for (size_t i = 1; i < length; ++i)
+        {
+            if (i >= count || src[i] < lower || src[i] > upper)
+            {
+                return i;
+            }
+            value = (value << 6) | (src[i] & 0x3F);
+            lower = 0x80;
+            upper = 0xBF;
+        }
+
+        cp = value;
+        valid = true;
+        return length;
+    }
+
+    // Appends one code point as UTF-8 to dst, or only counts it if dst is null.
+    bool putUtf8(char32_t cp, char* dst, int capacity, int& length) noexcept
+    {
+        char buffer[4];
+        int units;
+        if (cp < 0x80)
+        {
+            buffer[0] = static_cast<char>(cp);
+            units = 1;
+        }
+        else if (cp < 0x800)
+        {
+            buffer[0] = static_cast<char>(0xC0 | (cp >> 6));
+            buffer[1] = static_cast<char>(0x80 | (cp & 0x3F));
+            units = 2;
+        }
+        else if (cp < 0x10000)
+        {
+            buffer[0] = static_cast<char>(0xE0 | (cp >> 12));
+            buffer[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            buffer[2] = static_cast<char>(0x80 | (cp & 0x3F));
+            units = 3;
+        }
+        else
+        {
+            buffer[0] = static_cast<char>(0xF0 | (cp >> 18));
+            buffer[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            buffer[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            buffer[3] = static_cast<char>(0x80 | (cp & 0x3F));
+            units = 4;
+        }
+        if (dst)
+        {
+            if (capacity - length < units)
+            {
+                return false;
+            }
+            std::copy_n(&buffer[0], units, dst + length);
+        }
+        length += units;
+        return true;
+    }
+}
+
+int __isa_available = detectIsaAvailable();
+
+DWORD GetLastError() noexcept
+{
+    return lastError;
+}
+
+void SetLastError(DWORD error) noexcept
+{
+    lastError = error;
+}
+
+int MultiByteToWideChar(UINT codePage, DWORD flags, LPCSTR src, int srcLength, LPWSTR dst, int dstLength) noexcept
+{
+    if (codePage != CP_UTF8 || !src || srcLength == 0 || srcLength < -1 || dstLength < 0 || (dstLength && !dst))
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return 0;
+    }
+
+    const auto count = srcLength == -1 ? strlen(src) + 1 : static_cast<size_t>(srcLength);
+    const auto bytes = reinterpret_cast<const uint8_t*>(src);
+    const auto out = dstLength ? dst : nullptr;
+    int length = 0;
+
+    for (size_t i = 0; i < count;)
+    {
+        char32_t cp;
+        bool valid;
+        i += decodeUtf8(bytes + i, count - i, cp, valid);
+        if (!valid && WI_IsFlagSet(flags, MB_ERR_INVALID_CHARS))
+        {
+            SetLastError(ERROR_NO_UNICODE_TRANSLATION);
+            return 0;
+        }
+        if (!putUtf16(cp, out, dstLength, length))
+        {
+            SetLastError(ERROR_INSUFFICIENT_BUFFER);
+            return 0;
+        }
+    }
+
+    return length;
+}
+
+int WideCharToMultiByte(UINT codePage, DWORD /*flags*/, LPCWSTR src, int srcLength, LPSTR dst, int dstLength, LPCSTR defaultChar, BOOL* usedDefaultChar) noexcept
+{
+    if (codePage != CP_UTF8 || !src || srcLength == 0 || srcLength < -1 || dstLength < 0 || (dstLength && !dst) || defaultChar || usedDefaultChar)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return 0;
+    }
+
+    const auto count = srcLength == -1 ? wcslen(src) + 1 : static_cast<size_t>(srcLength);
+    const auto out = dstLength ? dst : nullptr;
+    int length = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        // wchar_t holds UTF-16 code units, even where it is wider.
+        char32_t cp = static_cast<char16_t>(src[i]);
+        if (cp >= 0xD800 && cp <= 0xDBFF && i + 1 < count)
+        {
+            const char32_t trail = static_cast<char16_t>(src[i + 1]);
+            if (trail >= 0xDC00 && trail <= 0xDFFF)
+            {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (trail - 0xDC00);
+                ++i;
+            }
+        }
+        if (cp >= 0xD800 && cp <= 0xDFFF)
+        {
+            cp = replacementChar;
+        }
+        if (!putUtf8(cp, out, dstLength, length))
+        {
+            SetLastError(ERROR_INSUFFICIENT_BUFFER);
+            return 0;
+        }
+    }
+
+    return length;
+}
+
+int CompareStringOrdinal(LPCWSTR string1, int count1, LPCWSTR string2, int count2, BOOL ignoreCase) noexcept
+{
+    const auto length1 = count1 < 0 ? wcslen(string1) : static_cast<size_t>(count1);
+    const auto length2 = count2 < 0 ? wcslen(string2) : static_cast<size_t>(count2);
+    const auto fold = [=](wchar_t ch) noexcept {
+        return static_cast<char16_t>(ignoreCase ? std::towupper(ch) : ch);
+    };
+
+    for (size_t i = 0; i < length1 && i < length2; ++i)
+    {
+        const auto a = fold(string1[i]);
+        const auto b = fold(string2[i]);
+        if (a != b)
+        {
+            return a < b ? CSTR_LESS_THAN : CSTR_GREATER_THAN;
+        }
+    }
+    return length1 == length2 ? CSTR_EQUAL : length1 < length2 ? CSTR_LESS_THAN : CSTR_GREATER_THAN;
+}
+
+UINT GetDoubleClickTime() noexcept
+{
+    // The default of Windows.
+    return 500;
+}
+
+void* VirtualAlloc(void* address, SIZE_T size, DWORD allocationType, DWORD protect) noexcept
+{
+    if (!size || (protect != PAGE_READWRITE && protect != PAGE_NOACCESS) || (allocationType & ~(MEM_RESERVE | MEM_COMMIT)) || !allocationType)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return nullptr;
+    }
+
+    const auto prot = protect == PAGE_READWRITE ? PROT_READ | PROT_WRITE : PROT_NONE;
+    const auto page = pageSize();
+
+    if (WI_IsFlagSet(allocationType, MEM_RESERVE))
+    {
+        if (address)
+        {
+            SetLastError(ERROR_INVALID_PARAMETER);
+            return nullptr;
+        }
+        size = (size + page - 1) & ~(page - 1);
+        // A reservation without a commit stays inaccessible, so that it costs nothing but address space.
+        const auto initial = WI_IsFlagSet(allocationType, MEM_COMMIT) ? prot : PROT_NONE;
+        const auto ptr = mmap(nullptr, size, initial, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (ptr == MAP_FAILED)
+        {
+            SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+            return nullptr;
+        }
+        try
+        {
+            const std::lock_guard lock{ reservationsMutex };
+            reservations.emplace(reinterpret_cast<uintptr_t>(ptr), size);
+        }
+        catch (...)
+        {
+            munmap(ptr, size);
+            SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+            return nullptr;
+        }
+        return ptr;
+    }
+
+    // MEM_COMMIT of pages in an existing reservation.
+    const auto begin = reinterpret_cast<uintptr_t>(address) & ~(page - 1);
+    const auto end = (reinterpret_cast<uintptr_t>(address) + size + page - 1) & ~(page - 1);
+    const auto reservation = findReservation(begin);
+    if (!address || !reservation || end > reservation->first + reservation->second)
+    {
+        SetLastError(ERROR_INVALID_ADDRESS);
+        return nullptr;
+    }
+    if (mprotect(reinterpret_cast<void*>(begin), end - begin, prot) != 0)
+    {
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return nullptr;
+    }
+    return reinterpret_cast<void*>(begin);
+}
+
+BOOL VirtualFree(void* address, SIZE_T size, DWORD freeType) noexcept
+{
+    const auto page = pageSize();
+    const auto reservation = findReservation(reinterpret_cast<uintptr_t>(address));
+    if (!reservation || (freeType != MEM_DECOMMIT && freeType != MEM_RELEASE))
+    {
+        SetLastError(ERROR_INVALID_ADDRESS);
+        return FALSE;
+    }
+
+    if (freeType == MEM_RELEASE)
+    {
+        if (size || reinterpret_cast<uintptr_t>(address) != reservation->first)
+        {
+            SetLastError(ERROR_INVALID_PARAMETER);
+            return FALSE;
+        }
+        {
+            const std::lock_guard lock{ reservationsMutex };
+            reservations.erase(reservation->first);
+        }
+        munmap(address, reservation->second);
+        return TRUE;
+    }
+
+    // MEM_DECOMMIT with a size of 0 decommits everything from the given address to the end of the reservation.
+    const auto begin = reinterpret_cast<uintptr_t>(address) & ~(page - 1);
+    const auto end = size ? (reinterpret_cast<uintptr_t>(address) + size + page - 1) & ~(page - 1) : reservation->first + reservation->second;
+    if (end > reservation->first + reservation->second)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return FALSE;
+    }
+    // MADV_DONTNEED returns the pages to the system. They read as zero when they're committed again.
+    madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+    mprotect(reinterpret_cast<void*>(begin), end - begin, PROT_NONE);
+    return TRUE;
+}
+
+UINT OneCoreSafeMapVirtualKeyW(_In_ UINT uCode, _In_ UINT uMapType)
+{
+    // Scan codes of set 1 for the virtual keys of a US keyboard.
+    static constexpr std::pair<UINT, UINT> scanCodes[]{
+        { VK_BACK, 0x0E },
+        { VK_TAB, 0x0F },
+        { VK_RETURN, 0x1C },
+        { VK_SHIFT, 0x2A },
+        { VK_CONTROL, 0x1D },
+        { VK_MENU, 0x38 },
+        { VK_PAUSE, 0x45 },
+        { VK_CAPITAL, 0x3A },
+        { VK_ESCAPE, 0x01 },
+        { VK_SPACE, 0x39 },
+        { VK_PRIOR, 0x49 },
+        { VK_NEXT, 0x51 },
+        { VK_END, 0x4F },
+        { VK_HOME, 0x47 },
+        { VK_LEFT, 0x4B },
+        { VK_UP, 0x48 },
+        { VK_RIGHT, 0x4D },
+        { VK_DOWN, 0x50 },
+        { VK_INSERT, 0x52 },
+        { VK_DELETE, 0x53 },
+        { '0', 0x0B },
+        { '1', 0x02 },
+        { '2', 0x03 },
+        { '3', 0x04 },
+        { '4', 0x05 },
+        { '5', 0x06 },
+        { '6', 0x07 },
+        { '7', 0x08 },
+        { '8', 0x09 },
+        { '9', 0x0A },
+        { 'A', 0x1E },
+        { 'B', 0x30 },
+        { 'C', 0x2E },
+        { 'D', 0x20 },
+        { 'E', 0x12 },
+        { 'F', 0x21 },
+        { 'G', 0x22 },
+        { 'H', 0x23 },
+        { 'I', 0x17 },
+        { 'J', 0x24 },
+        { 'K', 0x25 },
+        { 'L', 0x26 },
+        { 'M', 0x32 },
+        { 'N', 0x31 },
+        { 'O', 0x18 },
+        { 'P', 0x19 },
+        { 'Q', 0x10 },
+        { 'R', 0x13 },
+        { 'S', 0x1F },
+        { 'T', 0x14 },
+        { 'U', 0x16 },
+        { 'V', 0x2F },
+        { 'W', 0x11 },
+        { 'X', 0x2D },
+        { 'Y', 0x15 },
+        { 'Z', 0x2C },
+        { VK_F1, 0x3B },
+        { VK_F2, 0x3C },
+        { VK_F3, 0x3D },
+        { VK_F4, 0x3E },
+        { VK_F5, 0x3F },
+        { VK_F6, 0x40 },
+        { VK_F7, 0x41 },
+        { VK_F8, 0x42 },
+        { VK_F9, 0x43 },
+        { VK_F10, 0x44 },
+        { VK_F11, 0x57 },
+        { VK_F12, 0x58 },
+        { VK_OEM_1, 0x27 },
+        { VK_OEM_PLUS, 0x0D },
+        { VK_OEM_COMMA, 0x33 },
+        { VK_OEM_MINUS, 0x0C },
+        { VK_OEM_PERIOD, 0x34 },
+        { VK_OEM_2, 0x35 },
+        { VK_OEM_3, 0x29 },
+        { VK_OEM_4, 0x1A },
+        { VK_OEM_5, 0x2B },
+        { VK_OEM_6, 0x1B },
+        { VK_OEM_7, 0x28 },
+    };
+
+    switch (uMapType)
+    {
+    case MAPVK_VK_TO_VSC:
+        for (const auto& [vk, sc] : scanCodes)
+        {
+            if (vk == uCode)
+            {
+                return sc;
+            }
+        }
+        return 0;
+    case MAPVK_VSC_TO_VK:
+    case MAPVK_VSC_TO_VK_EX:
+        for (const auto& [vk, sc] : scanCodes)
+        {
+            if (sc == uCode)
+            {
+                return vk;
+            }
+        }
+        return 0;
+    case MAPVK_VK_TO_CHAR:
+        if ((uCode >= '0' && uCode <= '9') || (uCode >= 'A' && uCode <= 'Z'))
+        {
+            return uCode;
+        }
+        switch (uCode)
+        {
+        case VK_BACK:
+            return L'\b';
+        case VK_TAB:
+            return L'\t';
+        case VK_RETURN:
+            return L'\r';
+        case VK_ESCAPE:
+            return L'\x1b';
+        case VK_SPACE:
+            return L' ';
+        default:
+            break;
+        }
+        for (const auto ch : std::wstring_view{ L";=,-./`[\\]'" })
+        {
+            if ((OneCoreSafeVkKeyScanW(ch) & 0xFF) == static_cast<SHORT>(uCode))
+            {
+                return ch;
+            }
+        }
+        return 0;
+    default:
+        return 0;
+    }
+}
+
+SHORT OneCoreSafeVkKeyScanW(_In_ WCHAR ch)
+{
+    // The low byte is the virtual key and the high byte the shift state:
+    // 1 for Shift and 2 for Ctrl, as VkKeyScanW returns them.
+    static constexpr std::wstring_view shiftedDigits{ L")!@#$%^&*(" };
+    static constexpr std::pair<wchar_t, SHORT> punctuation[]{
+        { L';', VK_OEM_1 },
+        { L':', 0x100 | VK_OEM_1 },
+        { L'=', VK_OEM_PLUS },
+        { L'+', 0x100 | VK_OEM_PLUS },
+        { L',', VK_OEM_COMMA },
+        { L'<', 0x100 | VK_OEM_COMMA },
+        { L'-', VK_OEM_MINUS },
+        { L'_', 0x100 | VK_OEM_MINUS },
+        { L'.', VK_OEM_PERIOD },
+        { L'>', 0x100 | VK_OEM_PERIOD },
+        { L'/', VK_OEM_2 },
+        { L'?', 0x100 | VK_OEM_2 },
+        { L'`', VK_OEM_3 },
+        { L'~', 0x100 | VK_OEM_3 },
+        { L'[', VK_OEM_4 },
+        { L'{', 0x100 | VK_OEM_4 },
+        { L'\\', VK_OEM_5 },
+        { L'|', 0x100 | VK_OEM_5 },
+        { L']', VK_OEM_6 },
+        { L'}', 0x100 | VK_OEM_6 },
+        { L'\'', VK_OEM_7 },
+        { L'"', 0x100 | VK_OEM_7 },
+        { L' ', VK_SPACE },
+        { L'\b', VK_BACK },
+        { L'\t', VK_TAB },
+        { L'\r', VK_RETURN },
+        { L'\n', 0x200 | VK_RETURN },
+        { L'\x1b', VK_ESCAPE },
+    };
+
+    if (ch >= L'a' && ch <= L'z')
+    {
+        return static_cast<SHORT>(ch - L'a' + 'A');
+    }
+    if (ch >= L'A' && ch <= L'Z')
+    {
+        return static_cast<SHORT>(0x100 | ch);
+    }
+    if (ch >= L'0' && ch <= L'9')
+    {
+        return static_cast<SHORT>(ch);
+    }
+    if (const auto pos = shiftedDigits.find(ch); pos != std::wstring_view::npos)
+    {
+        return static_cast<SHORT>(0x100 | ('0' + pos));
+    }
+    for (const auto& [key, value] : punctuation)
+    {
+        if (key == ch)
+        {
+            return value;
+        }
+    }
+    if (ch >= 1 && ch <= 26)
+    {
+        // Ctrl+A through Ctrl+Z
+        return static_cast<SHORT>(0x200 | (ch - 1 + 'A'));
+    }
+    return -1;
+}
+
+SHORT OneCoreSafeGetKeyState(_In_ int /*nVirtKey*/)
+{
+    // There is no keyboard: no key is down and no lock is on.
+    return 0;
+}
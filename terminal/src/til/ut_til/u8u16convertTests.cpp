@@ -4,6 +4,8 @@
 #include "precomp.h"
 #include "WexTestClass.h"
 
+#include <random>
+
 using namespace WEX::Common;
 using namespace WEX::Logging;
 using namespace WEX::TestExecution;
@@ -17,8 +19,241 @@ class Utf8Utf16ConvertTests
     TEST_METHOD(TestU8ToU16Partials);
     TEST_METHOD(TestU16ToU8Partials);
     TEST_METHOD(TestU8ToU16OneByOne);
+    TEST_METHOD(TestU8ToU16Replacement);
+    TEST_METHOD(TestU8ToU16Transcoders);
+    TEST_METHOD(TestU8ToU16Streaming);
+    TEST_METHOD(TestIsValidUtf8);
 };
 
+namespace
+{
+    // Appends cp in length bytes, which may be more than needed (an overlong encoding).
+    void appendUtf8(std::string& out, char32_t cp, size_t length)
+    {
+        if (length == 1)
+        {
+            out.push_back(static_cast<char>(cp));
+        }
+        else if (length == 2)
+        {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+        else if (length == 3)
+        {
+            out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+        else
+        {
+            out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+
+    void appendUtf8(std::string& out, char32_t cp)
+    {
+        appendUtf8(out, cp, cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4);
+    }
+
+    // Sequences which look well-formed, but aren't: overlong encodings,
+    // surrogates, code points beyond U+10FFFF and lead bytes of 5 bytes and more.
+    void appendIllFormedUtf8(std::string& out, std::mt19937& rng)
+    {
+        switch (rng() % 6)
+        {
+        case 0:
+            appendUtf8(out, rng() % 0x80, 2);
+            break;
+        case 1:
+            appendUtf8(out, rng() % 0x800, 3);
+            break;
+        case 2:
+            appendUtf8(out, rng() % 0x10000, 4);
+            break;
+        case 3:
+            appendUtf8(out, 0xD800 + rng() % 0x800, 3);
+            break;
+        case 4:
+            appendUtf8(out, 0x110000 + rng() % 0xF0000, 4);
+            break;
+        default:
+            appendUtf8(out, rng() % 0x40000, 4);
+            out[out.size() - 4] = static_cast<char>(0xF8 + rng() % 8);
+            break;
+        }
+    }
+
+    // Random text of characters of all lengths and runs of ASCII, which the vector
+    // paths take in different steps. If illFormed is true, random bytes and
+    // truncated characters are mixed in.
+    std::string randomUtf8(std::mt19937& rng, size_t length, bool illFormed)
+    {
+        std::string out;
+        while (out.size() < length)
+        {
+            switch (rng() % 6)
+            {
+            case 0:
+                out.append(1 + rng() % 40, static_cast<char>(0x20 + rng() % 0x5F));
+                break;
+            case 1:
+                appendUtf8(out, 0x80 + rng() % (0x800 - 0x80));
+                break;
+            case 2:
+            {
+                const char32_t cp = 0x800 + rng() % (0x10000 - 0x800);
+                appendUtf8(out, cp >= 0xD800 && cp <= 0xDFFF ? 0xFFFD : cp);
+                break;
+            }
+            case 3:
+                appendUtf8(out, 0x10000 + rng() % (0x110000 - 0x10000));
+                break;
+            case 4:
+                if (illFormed && rng() % 2)
+                {
+                    out.push_back(static_cast<char>(rng()));
+                }
+                else if (illFormed)
+                {
+                    appendIllFormedUtf8(out, rng);
+                }
+                else
+                {
+                    appendUtf8(out, 0x400 + rng() % 0x100); // Cyrillic
+                }
+                break;
+            default:
+                if (illFormed)
+                {
+                    std::string character;
+                    appendUtf8(character, 0x80 + rng() % (0x110000 - 0x80));
+                    out.append(character, 0, 1 + rng() % (character.size() - 1));
+                }
+                else
+                {
+                    appendUtf8(out, 0x4E00 + rng() % 0x5200); // CJK
+                }
+                break;
+            }
+        }
+        return out;
+    }
+
+    std::wstring referenceU8U16(const std::string_view& in)
+    {
+        std::wstring out(in.size(), L'\0');
+        out.resize(gsl::narrow_cast<size_t>(MultiByteToWideChar(CP_UTF8, 0UL, in.data(), gsl::narrow_cast<int>(in.size()), out.data(), gsl::narrow_cast<int>(out.size()))));
+        return out;
+    }
+
+#pragma warning(push)
+#pragma warning(disable : 26429 26446 26459 26481 26482) // use not_null, subscript operator, use span, pointer arithmetic, dynamic array indexing
+    // The streaming til::u8u16 as it was when it used MultiByteToWideChar.
+    HRESULT referenceU8U16(const std::string_view& in, std::wstring& out, til::u8state& state)
+    {
+        out.clear();
+        RETURN_HR_IF(S_OK, in.empty());
+
+        const auto capa16{ gsl::narrow_cast<int>(in.length() + state.have) };
+        out.resize(gsl::narrow_cast<size_t>(capa16));
+        auto len8{ gsl::narrow_cast<int>(in.length()) };
+        int len16{};
+        auto cursor8{ in.data() };
+        if (state.have)
+        {
+            const auto copyable{ std::min<int>(state.want, len8) };
+            std::move(cursor8, cursor8 + copyable, &state.partials[state.have]);
+            state.have += gsl::narrow_cast<uint8_t>(copyable);
+            state.want -= gsl::narrow_cast<uint8_t>(copyable);
+            if (state.want)
+            {
+                out.clear();
+                return S_OK;
+            }
+
+            len16 = MultiByteToWideChar(CP_UTF8, 0UL, &state.partials[0], gsl::narrow_cast<int>(state.have), out.data(), capa16);
+            len8 -= copyable;
+            cursor8 += copyable;
+            state.have = 0;
+        }
+
+        if (len8)
+        {
+            auto backIter{ cursor8 + len8 - 1 };
+            int sequenceLen{ 1 };
+            while (backIter != cursor8 && (*backIter & 0b11'000000) == 0b10'000000)
+            {
+                --backIter;
+                ++sequenceLen;
+            }
+
+            static constexpr uint8_t lengths[]{ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 3, 3, 4, 0 };
+            const auto codePointLen{ lengths[gsl::narrow_cast<uint8_t>(*backIter) >> 3] };
+            if (codePointLen > sequenceLen)
+            {
+                std::move(backIter, backIter + sequenceLen, &state.partials[0]);
+                len8 -= sequenceLen;
+                state.have = gsl::narrow_cast<uint8_t>(sequenceLen);
+                state.want = gsl::narrow_cast<uint8_t>(codePointLen - sequenceLen);
+            }
+        }
+
+        if (len8)
+        {
+            len16 += MultiByteToWideChar(CP_UTF8, 0UL, cursor8, len8, out.data() + len16, capa16 - len16);
+        }
+
+        out.resize(gsl::narrow_cast<size_t>(len16));
+        return S_OK;
+    }
+#pragma warning(pop)
+
+    struct Transcoder
+    {
+        const wchar_t* name;
+        wchar_t* (*transcode)(const uint8_t* in, const uint8_t* end, wchar_t* out, bool& valid) noexcept;
+    };
+
+    // The code paths of the transcoder which this CPU can run.
+    std::vector<Transcoder> availableTranscoders()
+    {
+        std::vector<Transcoder> transcoders{ { L"scalar", &til::details::u8u16_scalar<wchar_t> } };
+#if defined(TIL_SSE_INTRINSICS)
+        if (__isa_available >= __ISA_AVAILABLE_SSE42)
+        {
+            transcoders.push_back({ L"sse4.1", &til::details::u8u16_sse41<wchar_t> });
+        }
+        if (__isa_available >= __ISA_AVAILABLE_AVX2)
+        {
+            transcoders.push_back({ L"avx2", &til::details::u8u16_avx2<wchar_t> });
+        }
+#endif
+        return transcoders;
+    }
+
+    // Verifies that every path of the transcoder replaces ill-formed input
+    // the same way MultiByteToWideChar does.
+    void verifyTranscoders(const std::string& input)
+    {
+        const auto expected = referenceU8U16(input);
+        const auto expectedValid = input.empty() || MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, input.data(), gsl::narrow_cast<int>(input.size()), nullptr, 0) != 0;
+        const auto beg = reinterpret_cast<const uint8_t*>(input.data());
+
+        for (const auto& transcoder : availableTranscoders())
+        {
+            std::wstring actual(input.size(), L'\0');
+            auto valid = true;
+            actual.resize(gsl::narrow_cast<size_t>(transcoder.transcode(beg, beg + input.size(), actual.data(), valid) - actual.data()));
+            VERIFY_ARE_EQUAL(expected, actual, NoThrowString().Format(L"%s, %zu bytes", transcoder.name, input.size()));
+            VERIFY_ARE_EQUAL(expectedValid, valid, NoThrowString().Format(L"%s, %zu bytes", transcoder.name, input.size()));
+        }
+    }
+}
+
 void Utf8Utf16ConvertTests::TestU8ToU16()
 {
     const std::string u8String{
@@ -191,3 +426,114 @@ void Utf8Utf16ConvertTests::TestU8ToU16OneByOne()
     VERIFY_SUCCEEDED(til::u8u16(u8String1_4, u16Out1, state));
     VERIFY_ARE_EQUAL(u16StringComp1, u16Out1);
 }
+
+void Utf8Utf16ConvertTests::TestU8ToU16Replacement()
+{
+    // Each maximal subpart of an ill-formed sequence becomes one U+FFFD.
+    static constexpr std::pair<std::string_view, std::wstring_view> tests[]{
+        { "\xC0\xAF", L"\xFFFD\xFFFD" }, // overlong
+        { "\xC1\xBF", L"\xFFFD\xFFFD" }, // overlong
+        { "\xE0\x80\xAF", L"\xFFFD\xFFFD\xFFFD" }, // overlong
+        { "\xE0\x9F\xBF", L"\xFFFD\xFFFD\xFFFD" }, // overlong
+        { "\xF0\x8F\xBF\xBF", L"\xFFFD\xFFFD\xFFFD\xFFFD" }, // overlong
+        { "\xED\xA0\x80", L"\xFFFD\xFFFD\xFFFD" }, // surrogate
+        { "\xED\xBF\xBF", L"\xFFFD\xFFFD\xFFFD" }, // surrogate
+        { "\xF4\x90\x80\x80", L"\xFFFD\xFFFD\xFFFD\xFFFD" }, // beyond U+10FFFF
+        { "\xF5\x80", L"\xFFFD\xFFFD" },
+        { "\xF9\x80\x80\x80", L"\xFFFD\xFFFD\xFFFD\xFFFD" },
+        { "\xE6\x96", L"\xFFFD" }, // truncated
+        { "\xF0\x9F\x98" "A", L"\xFFFD" L"A" }, // truncated
+        { "\x80\xBF", L"\xFFFD\xFFFD" }, // continuation bytes
+        { "\xEF\xBF\xBF\xF0\x90\x80\x80", L"\xFFFF\xD800\xDC00" }, // well-formed
+    };
+
+    // Put the sequences at every offset of a 32 byte block, between ASCII
+    // and 2 byte characters, so that every step of the vector paths sees them.
+    for (const auto& [input, output] : tests)
+    {
+        for (size_t offset = 0; offset < 32; ++offset)
+        {
+            for (const auto filler : { "a", "\xC3\xA9" })
+            {
+                std::string u8String;
+                std::wstring u16StringComp;
+                while (u8String.size() < offset)
+                {
+                    u8String.append(filler);
+                    u16StringComp.push_back(filler[1] ? L'\xE9' : L'a');
+                }
+                u8String.append(input);
+                u16StringComp.append(output);
+                for (auto i = 0; i < 32; ++i)
+                {
+                    u8String.append(filler);
+                    u16StringComp.push_back(filler[1] ? L'\xE9' : L'a');
+                }
+
+                std::wstring u16Out;
+                VERIFY_SUCCEEDED(til::u8u16(u8String, u16Out));
+                VERIFY_ARE_EQUAL(u16StringComp, u16Out);
+                verifyTranscoders(u8String);
+            }
+        }
+    }
+}
+
+void Utf8Utf16ConvertTests::TestU8ToU16Transcoders()
+{
+    std::mt19937 rng{ 42 };
+    for (auto i = 0; i < 2000; ++i)
+    {
+        verifyTranscoders(randomUtf8(rng, rng() % 300, i % 2 != 0));
+    }
+}
+
+void Utf8Utf16ConvertTests::TestU8ToU16Streaming()
+{
+    std::mt19937 rng{ 42 };
+    for (auto i = 0; i < 200; ++i)
+    {
+        const auto input = randomUtf8(rng, 1000, i % 2 != 0);
+        til::u8state state{};
+        til::u8state referenceState{};
+        std::wstring u16Out;
+        std::wstring u16OutComp;
+        std::wstring streamed;
+
+        for (size_t pos = 0; pos < input.size();)
+        {
+            const auto chunk = std::string_view{ input }.substr(pos, 1 + rng() % 20);
+            VERIFY_SUCCEEDED(til::u8u16(chunk, u16Out, state));
+            VERIFY_SUCCEEDED(referenceU8U16(chunk, u16OutComp, referenceState));
+            VERIFY_ARE_EQUAL(u16OutComp, u16Out);
+            VERIFY_ARE_EQUAL(referenceState.have, state.have);
+            VERIFY_ARE_EQUAL(referenceState.want, state.want);
+            streamed.append(u16Out);
+            pos += chunk.size();
+        }
+
+        // Well-formed text converts the same regardless of where it's split.
+        if (i % 2 == 0)
+        {
+            VERIFY_ARE_EQUAL(referenceU8U16(input), streamed);
+        }
+    }
+}
+
+void Utf8Utf16ConvertTests::TestIsValidUtf8()
+{
+    VERIFY_IS_TRUE(til::is_valid_utf8(""));
+    VERIFY_IS_TRUE(til::is_valid_utf8("\x7E\xC3\xB6\xE2\x82\xAC\xF0\xA4\xBD\x9C"));
+    VERIFY_IS_FALSE(til::is_valid_utf8("\xF0\xA4\xBD"));
+    VERIFY_IS_FALSE(til::is_valid_utf8("\xED\xA0\x80"));
+
+    // Long enough to be validated in several parts, which must not split characters.
+    std::mt19937 rng{ 42 };
+    for (auto i = 0; i < 20; ++i)
+    {
+        auto input = randomUtf8(rng, 5000, false);
+        VERIFY_IS_TRUE(til::is_valid_utf8(input));
+        input[rng() % input.size()] = '\xFF';
+        VERIFY_IS_FALSE(til::is_valid_utf8(input));
+    }
+}